@@ -35,6 +35,8 @@
 #include "LMSerializationManager2.h"
 
 #include "brush.h"
+#include "cbuffer.h"
+#include "VegetationSoA.h"
 
 ISystem * Cry3DEngineBase::m_pSys=0;
 IRenderer * Cry3DEngineBase::m_pRenderer=0;
@@ -321,6 +323,29 @@ void C3DEngine::Update()
 	m_configSpec = GetISystem()->GetConfigSpec();
   m_LightConfigSpec = (ESystemConfigSpec)GetCurrentLightSpec();
 
+  if(GetCVars()->e_cbuffer_bench)
+  {
+    CCoverageBuffer::RunBenchmark(GetCVars()->e_cbuffer_bench);
+    GetCVars()->e_cbuffer_bench = 0;
+  }
+
+  if(m_pTerrain)
+    m_pTerrain->UpdateOcclusionBenchmark(GetCVars()->e_terrain_occlusion_culling_bench);
+
+  if(GetCVars()->e_vis_area_bench)
+  {
+    if(m_pVisAreaManager)
+      m_pVisAreaManager->RunBenchmark(GetCVars()->e_vis_area_bench);
+    CVisAreaManager::RunSyntheticBenchmark(1024, GetCVars()->e_vis_area_bench);
+    GetCVars()->e_vis_area_bench = 0;
+  }
+
+  if(GetCVars()->e_vegetation_soa_bench)
+  {
+    CVegetationSoA::RunBenchmark(GetCVars()->e_vegetation_soa_bench);
+    GetCVars()->e_vegetation_soa_bench = 0;
+  }
+
 ///	if(m_pVisAreaManager)
 	//	m_pVisAreaManager->Preceche(m_pObjManager);
 }
@@ -1795,6 +1820,9 @@ bool C3DEngine::SetStatInstGroup(int nGroupId, const IStatInstGroup & siGroup)
 
 	m_pObjManager->m_lstStaticTypes[nGroupId].SetRndFlags();
 
+	// the vegetation streams keep values computed from the group
+	CVegetationSoA::OnStatInstGroupChanged();
+
 	return true;
 }
 
@@ -2130,6 +2158,14 @@ IVisArea * C3DEngine::GetVisAreaFromPos(const Vec3d &vPos)
 	return 0;
 }
 
+void C3DEngine::GetVisAreasFromPos(const Vec3d * pPos, int nCount, IVisArea ** ppAreas)
+{
+	if(m_pObjManager && m_pVisAreaManager)
+		m_pVisAreaManager->GetVisAreasFromPos(pPos, nCount, ppAreas);
+	else
+		memset(ppAreas, 0, sizeof(IVisArea*)*nCount);
+}
+
 bool C3DEngine::IsVisAreasConnected(IVisArea * pArea1, IVisArea * pArea2, int nMaxRecursion, bool bSkipDisabledPortals)
 {
 	if (pArea1==pArea2)
@@ -314,6 +314,7 @@ public:
   virtual float GetLightAmountForEntity(IEntityRender * pEntity, bool bOnlyVisibleLights);
   virtual float GetAmbientLightAmountForEntity(IEntityRender * pEntity);
   virtual IVisArea * GetVisAreaFromPos(const Vec3d &vPos);	
+  virtual void GetVisAreasFromPos(const Vec3d * pPos, int nCount, IVisArea ** ppAreas);
   virtual bool IsVisAreasConnected(IVisArea * pArea1, IVisArea * pArea2, int nMaxReqursion, bool bSkipDisabledPortals);
   virtual ILMSerializationManager * CreateLMSerializationManager();
   void EnableOceanRendering(bool bOcean, bool bShore); // todo: remove
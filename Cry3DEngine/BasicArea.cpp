@@ -25,6 +25,7 @@
 #include "watervolumes.h"
 #include "brush.h"
 #include "LMCompStructures.h"
+#include "VegetationSoA.h"
 
 void CBasicArea::SerializeArea(bool bSave)
 {
@@ -158,6 +159,12 @@ void CBasicArea::DrawEntities( int nFogVolumeID, int nDLightMask,
 		static list2<IEntityRenderInfo*> TmpEntList; TmpEntList.Clear();
 		list2<struct IEntityRender*> & SrcEntList = m_lstEntities[STATIC_ENTITIES];
 
+		if(GetCVars()->e_vegetation && m_pVegetSoA)
+		{ // cull and render simple vegetations from the streams, the list below is empty then
+			pObjManager->RenderVegetationSoA( m_pVegetSoA, 
+				nDLightMaskNoSun, EntViewCamera, bNotAllInFrustum, fSectorMinDist);
+		}
+
 		if(GetCVars()->e_vegetation)
 		{	// fill simple vegetations
 //		FRAME_PROFILER( "*fill simple vegetations", GetSystem(), PROFILE_3DENGINE );
@@ -467,6 +474,19 @@ void CBasicArea::SortStaticInstancesBySize(VolumeInfo * pFogVolume)
 
 	m_lstStatEntInfoVegetNoCastersNoVolFog.Clear();
 	m_lstStatEntInfoOthers.Clear();
+
+	if(GetCVars()->e_vegetation_soa)
+	{
+		if(!m_pVegetSoA)
+			m_pVegetSoA = new CVegetationSoA();
+		m_pVegetSoA->Clear();
+	}
+	else
+	{
+		delete m_pVegetSoA;
+		m_pVegetSoA = 0;
+	}
+
 	for( int i=0; i<m_lstEntities[STATIC_ENTITIES].Count(); i++)
 	{
 		IEntityRender * pEntityRender =	m_lstEntities[STATIC_ENTITIES][i];
@@ -485,7 +505,12 @@ void CBasicArea::SortStaticInstancesBySize(VolumeInfo * pFogVolume)
 		if(	!(pEntityRender->GetRndFlags() & (ERF_CASTSHADOWMAPS|ERF_CASTSHADOWVOLUME|ERF_RECVSHADOWMAPS|ERF_SELFSHADOW)) && 
 				pEntityRender->GetEntityRenderType() ==	eERType_Vegetation && 
 				!bInFogVolume)
-			m_lstStatEntInfoVegetNoCastersNoVolFog.Add(inf);
+		{
+			if(m_pVegetSoA)
+				m_pVegetSoA->Add((CStatObjInst*)pEntityRender);
+			else
+				m_lstStatEntInfoVegetNoCastersNoVolFog.Add(inf);
+		}
 		else
 			m_lstStatEntInfoOthers.Add(inf);
 	}
@@ -869,6 +894,8 @@ CBasicArea::~CBasicArea()
 	for( int i=0; i<m_lstAreaBrush.Count(); i++ )
 		FreeAreaBrush(m_lstAreaBrush[i]);
 	m_lstAreaBrush.Clear();
+
+	delete m_pVegetSoA;
 }
 
 
@@ -32,11 +32,12 @@ struct IEntityRenderInfo
 
 struct CBasicArea : public Cry3DEngineBase
 {
-  CBasicArea() { m_nLastUsedFrameId=0; m_eSStatus=eSStatus_Unloaded; m_vBoxMin=m_vBoxMax=m_vAreaBrushFocusPos=Vec3d(0,0,0); m_StaticEntitiesSorted=false; }
+  CBasicArea() { m_nLastUsedFrameId=0; m_eSStatus=eSStatus_Unloaded; m_vBoxMin=m_vBoxMax=m_vAreaBrushFocusPos=Vec3d(0,0,0); m_StaticEntitiesSorted=false; m_pVegetSoA=0; }
 	~CBasicArea();
 
   list2<struct IEntityRender*> m_lstEntities[2];
 	list2<IEntityRenderInfo> m_lstStatEntInfoVegetNoCastersNoVolFog, m_lstStatEntInfoOthers;
+	class CVegetationSoA * m_pVegetSoA; // replaces m_lstStatEntInfoVegetNoCastersNoVolFog if e_vegetation_soa
 	list2<struct IEntityRender*> m_lstStaticShadowMapCasters;
   Vec3d m_vBoxMin, m_vBoxMax;
   int m_nLastUsedFrameId;
@@ -25,6 +25,7 @@
 #include "watervolumes.h"
 #include "brush.h"
 #include "LMCompStructures.h"
+#include "VegetationSoA.h"
 
 double CObjManager::m_dMakeObjectTime = 0;
 double CObjManager::m_dCIndexedMesh__LoadMaterial = 0;
@@ -163,6 +164,8 @@ bool CObjManager::UnRegisterEntity( IEntityRender* pEntityRS )
 			pSector->m_lstStatEntInfoOthers.Delete(i);
 			i--;
 		}
+		if(pSector->m_pVegetSoA)
+			pSector->m_pVegetSoA->Remove(pEntityRS);
 	}
 
   pSector=0;
@@ -657,6 +660,20 @@ bool CObjManager::GetStaticObjectBBox(int nType, Vec3d & vBoxMin, Vec3d & vBoxMa
   return true;
 }
 
+static uint GetParticleRenderState(const ParticleBlendType eBlendType)
+{
+	switch(eBlendType)
+	{
+		case ParticleBlendType_AlphaBased:
+			return GS_BLSRC_SRCALPHA | GS_BLDST_ONEMINUSSRCALPHA | GS_ALPHATEST_GREATER0;
+		case ParticleBlendType_ColorBased:
+			return GS_BLSRC_ONE | GS_BLDST_ONEMINUSSRCCOL;
+		case ParticleBlendType_Additive:
+			return GS_BLSRC_ONE | GS_BLDST_ONE;
+	}
+	return 0;
+}
+
 void CObjManager::AddPolygonToRenderer( const int nTexBindId, 
                                         IShader * pShader, 
                                         const int nDynLMask,
@@ -716,19 +733,7 @@ void CObjManager::AddPolygonToRenderer( const int nTexBindId,
   }
 
 	// calculate render state
-	uint nRenderState=0;
-	switch(eBlendType)
-	{
-		case ParticleBlendType_AlphaBased:
-			nRenderState = GS_BLSRC_SRCALPHA | GS_BLDST_ONEMINUSSRCALPHA | GS_ALPHATEST_GREATER0;
-			break;
-		case ParticleBlendType_ColorBased:
-			nRenderState = GS_BLSRC_ONE | GS_BLDST_ONEMINUSSRCCOL;
-			break;
-		case ParticleBlendType_Additive:
-			nRenderState = GS_BLSRC_ONE | GS_BLDST_ONE;
-			break;
-	}
+	uint nRenderState = GetParticleRenderState(eBlendType);
 
 	// repeated objects are free imedeately in renderer
 	CCObject * pOb = GetIdentityCCObject();		
@@ -768,6 +773,65 @@ void CObjManager::AddPolygonToRenderer( const int nTexBindId,
 		(SColorVert*)pTailVerts, pOb, (byte*)pTailIndices, nTailIndicesNum);
 }
 
+// client polys of the renderer take up to 42 indices
+#define MAX_SPRITES_PER_CLIENT_POLY 7
+
+void CObjManager::AddSpritesToRenderer( const int nTexBindId, 
+                                        IShader * pShader, 
+                                        const int nDynLMask,
+                                        const ParticleBlendType eBlendType,
+                                        const Vec3d & vAmbientColor,
+                                        SColorVert * pVerts,
+                                        const int nQuads,
+                                        const float fSortId,
+                                        const int dwCCObjFlags,
+                                        list2<struct ShadowMapLightSourceInstance> * pShadowMapCasters)
+{
+  if(nTexBindId <= 0 || nTexBindId >= 16384)
+  {
+    Warning( 0,0,"CObjManager::AddSpritesToRenderer: texture id is out of range: %d", nTexBindId);
+    return;
+  }
+
+	// one object for all quads, the renderer finds it in its sprite list for the following polys
+	CCObject * pOb = GetIdentityCCObject();		
+
+	if(pShadowMapCasters && pShadowMapCasters->Count())
+	{
+		pOb->m_pShadowCasters = pShadowMapCasters;
+		pOb->m_ObjFlags |= FOB_INSHADOW;
+	}
+
+	pOb->m_DynLMMask = nDynLMask;
+	pOb->m_NumCM = nTexBindId;	    
+	pOb->m_AmbColor = vAmbientColor;
+	pOb->m_RenderState = GetParticleRenderState(eBlendType);
+	if(GetRenderer()->EF_GetHeatVision())
+		pOb->m_ObjFlags |= FOB_HEATVISION;
+
+  pOb->m_ObjFlags |= dwCCObjFlags;
+	pOb->m_SortId = fSortId;
+
+	// same triangles as the fan used for single quads
+	byte arrIndices[MAX_SPRITES_PER_CLIENT_POLY*6];
+	for(int i=0; i<MAX_SPRITES_PER_CLIENT_POLY; i++)
+	{
+		arrIndices[i*6+0] = i*4+0;
+		arrIndices[i*6+1] = i*4+1;
+		arrIndices[i*6+2] = i*4+2;
+		arrIndices[i*6+3] = i*4+0;
+		arrIndices[i*6+4] = i*4+2;
+		arrIndices[i*6+5] = i*4+3;
+	}
+
+	int nShaderId = pShader->GetID();
+	for(int nQuad=0; nQuad<nQuads; nQuad+=MAX_SPRITES_PER_CLIENT_POLY)
+	{
+		int nChunk = min(MAX_SPRITES_PER_CLIENT_POLY, nQuads-nQuad);
+		pOb = GetRenderer()->EF_AddSpriteToScene(nShaderId, nChunk*4, &pVerts[nQuad*4], pOb, arrIndices, nChunk*6);
+	}
+}
+
 int CObjManager::GetMemoryUsage(class ICrySizer * pSizer)
 {
 	int nSize = 0;
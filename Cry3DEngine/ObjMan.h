@@ -209,6 +209,18 @@ public:
                             IMatInfo * pCustomMaterial = NULL,
 														CStatObjInst * pStatObjInst = NULL,
 														list2<struct ShadowMapLightSourceInstance> * pShadowMapCasters = NULL);
+
+  // adds nQuads ready made quads (4 verts each) sharing one texture and render object
+  void AddSpritesToRenderer(const int nTexBindId, 
+                            IShader * pShader, 
+                            const int nDynLMask,
+                            const ParticleBlendType eBlendType,
+                            const Vec3d & vAmbientColor,
+                            SColorVert * pVerts,
+                            const int nQuads,
+                            const float fSortId,
+                            const int dwCCObjFlags,
+                            list2<struct ShadowMapLightSourceInstance> * pShadowMapCasters = NULL);
   
   // tmp containers (replacement for local static vars)
   list2<IEntityRender*> lstEntList_MLSMCIA;
@@ -264,6 +276,8 @@ public:
 	void RenderObjectVegetationNonCastersNoFogVolume( IEntityRender * pEntityRS,uint nDLightMask,
 		const CCamera & EntViewCamera, 
 		bool bNotAllInFrustum, float fMaxViewDist, IEntityRenderInfo * pEntInfo);
+	void RenderVegetationSoA( class CVegetationSoA * pVegetSoA, uint nDLightMask,
+		const CCamera & EntViewCamera, bool bNotAllInFrustum, float fSectorMinDist );
 };
 
 #endif // CObjManager_H
@@ -41,8 +41,8 @@ bool CObjManager::IsBoxOccluded( const Vec3d & vBoxMin, const Vec3d & vBoxMax, f
   }
 
   { // test occlusion by objects
-    if(!pOcclTestVars->ucOcclusionByObjectsFrames && fDistance>COVERAGEBUFFER_OCCLUSION_TESTERS_MIN_DISTANCE && GetCVars()->e_cbuffer)
-    { // less distance do not work because objects are sorted wrong
+    if(!pOcclTestVars->ucOcclusionByObjectsFrames && GetCVars()->e_cbuffer)
+    { // buffer keeps depth, so drawing order of occluders does not matter
       if(!m_pCoverageBuffer->IsBBoxVisible(vBoxMin,vBoxMax))
       {
         pOcclTestVars->ucOcclusionByObjectsFrames = 0; // force to test next frame
@@ -24,6 +24,7 @@
 #include "3dengine.h"
 #include "cryparticlespawninfo.h"
 #include "lightman.h"
+#include "VegetationSoA.h"
 #include <utility>
 
 #define MAX_SHADOW_VOLUME_LEN 8.f
@@ -299,6 +300,142 @@ void CObjManager::RenderObjectVegetationNonCastersNoFogVolume( IEntityRender * p
 	pEntityRS->DrawEntity(DrawParams);
 }
 
+void CObjManager::RenderVegetationSoA( CVegetationSoA * pVegetSoA, uint nDLightMask, 
+	const CCamera & EntViewCamera, bool bNotAllInFrustum, float fSectorMinDist )
+{
+	// distance, frustum, sprite distance and lod of all instances in SIMD batches, 
+	// visible ones come grouped by object type
+	static list2<SVegetationVisible> lstVisible; lstVisible.Clear();
+	pVegetSoA->Cull(EntViewCamera, bNotAllInFrustum, fSectorMinDist, !nDLightMask, lstVisible);
+	if(!lstVisible.Count())
+		return;
+
+	FUNCTION_PROFILER_FAST( GetSystem(),PROFILE_3DENGINE,m_bProfilerEnabled );
+
+	IRenderer * pRend = GetRenderer();
+	CVars * pCVars = GetCVars();
+	const Vec3d vCamPos = EntViewCamera.GetPos();
+
+	// same for all instances of the sector
+	list2<CDLight> * pSources = m_p3DEngine->GetDynamicLightSources();
+	int nSunMask = 0;
+	for(int i=0; i<pSources->Count(); i++)
+	{
+		CDLight * pDynLight = pSources->Get(i);
+		if(pDynLight->m_Flags & DLF_SUN)
+		{
+			if(pDynLight->m_Id>=0)
+				nSunMask = 1<<pDynLight->m_Id;
+			break;
+		}
+	}
+
+	Vec3d vAmbientColor = m_vOutdoorAmbientColor;
+	Vec3d vWorldColor = Get3DEngine()->GetWorldColor();
+	vAmbientColor.x *= vWorldColor.x;
+	vAmbientColor.y *= vWorldColor.y;
+	vAmbientColor.z *= vWorldColor.z;
+
+	const bool bHeatVision = pRend->EF_GetHeatVision()!=0;
+	const bool bTestOcclusion = pCVars->e_portals!=3;
+	CSectorInfo * pSector00 = m_pTerrain->m_arrSecInfoTable[0][0];
+
+	int nType = -1;
+	CStatObj * pBody = NULL;
+
+	for( int i=0; i<lstVisible.Count(); i++ )
+	{
+		const SVegetationVisible & vis = lstVisible[i];
+		CStatObjInst * pInst = vis.pInst;
+
+		if (i+1 < lstVisible.Count())
+		{ // prefech next element
+			cryPrefetchT0SSE(lstVisible[i+1].pInst);
+		}
+
+		// new group
+		if(pInst->m_nObjectTypeID != nType)
+		{
+			nType = pInst->m_nObjectTypeID;
+			pBody = m_lstStaticTypes[nType].GetStatObj();
+		}
+
+		const float fEntDistance = vis.fDistance;
+		const Vec3d & vBoxMin = pInst->m_vWSBoxMin, & vBoxMax = pInst->m_vWSBoxMax;
+		const float fEntRadius = pInst->m_fWSRadius;
+		Vec3d vCenter = (vBoxMin+vBoxMax)*0.5f;
+
+		// for big objects (registered in sector 00) - get light mask from 00 sector
+		uint nInstLightMask = nDLightMask;
+		if(pInst->m_pSector == pSector00)
+		{
+			CSectorInfo * pSectorInfo = m_pTerrain->GetSecInfo(vCenter);
+			if(pSectorInfo)
+				nInstLightMask = pSectorInfo->m_nDynLightMask;
+		}
+
+		Vec3d vLightIntensity(0,0,0);
+		CDLight * pStrongestLightForTranspGeom = NULL;
+		if(nInstLightMask==1 && pSources->Count() && pSources->GetAt(0).m_Flags & DLF_SUN)
+			pStrongestLightForTranspGeom = pSources->Get(0);
+		else if(nInstLightMask)
+			m_p3DEngine->CheckDistancesToLightSources(nInstLightMask, vCenter, fEntRadius, pInst, 8, &pStrongestLightForTranspGeom, 1, &vLightIntensity);
+
+		// check all possible occlusions for outdoor objects
+		if(fEntRadius && bTestOcclusion)
+		{
+			// test occlusion of outdoor objects by mountains
+			if(m_fZoomFactor && fEntDistance/m_fZoomFactor > 48 && !pInst->m_pVisArea)
+				if(IsBoxOccluded(vBoxMin, vBoxMax, fEntDistance/m_fZoomFactor, &pInst->OcclState))
+					continue;
+
+			// test occl by antiportals
+			if(GetVisAreaManager()->IsOccludedByOcclVolumes(vBoxMin,vBoxMax, pInst->m_pVisArea!=NULL))
+				continue;
+		}
+
+		// store for later use (like tree sprites rendering)
+		pInst->m_arrfDistance[m_nRenderStackLevel] = fEntDistance;
+
+		// mark as rendered in this frame
+		pInst->SetDrawFrame( GetFrameID(), m_nRenderStackLevel );
+
+		// process object particles (rain drops)
+		if(pCVars->e_rain_amount)
+			ProcessEntityParticles(pInst,fEntDistance);
+
+		if(!pBody)
+			continue;
+
+		// set render params
+		SRendParams DrawParams;  
+		DrawParams.nDLightMask  = nInstLightMask;
+		DrawParams.nFogVolumeID = 0;
+		DrawParams.fDistance = fEntDistance;
+		DrawParams.vAmbientColor = vAmbientColor;
+		if(pCVars->e_objects_fade_on_distance)
+			DrawParams.fAlpha = min(1.f,(1.f - fEntDistance / pInst->m_fWSMaxViewDist)*6);
+		DrawParams.fCustomSortOffset = GetSortOffset(vCenter,vCamPos);
+		DrawParams.dwFObjFlags = FOB_IGNOREMATERIALAMBIENT;
+		if(bHeatVision)
+			DrawParams.nShaderTemplate = EFT_HEATVISION;
+
+		// draw bbox
+		if (pCVars->e_bboxes)			
+			pRend->Draw3dBBox(vBoxMin, vBoxMax);
+
+		// set light mask for transparent geometry
+		if(pStrongestLightForTranspGeom)
+		{
+			DrawParams.nStrongestDLightMask = 1<<pStrongestLightForTranspGeom->m_Id;
+			if(DrawParams.fAlpha<1.f) // set it for entire object if entire object is transparent
+				DrawParams.nDLightMask = DrawParams.nStrongestDLightMask & DrawParams.nDLightMask;
+		}
+
+		pInst->DrawInstance(DrawParams, pBody, vis.fSpriteDist, DrawParams.nDLightMask & ~nSunMask, vis.nLod);
+	}
+}
+
 void CObjManager::RenderObject( IEntityRender * pEntityRS,
 															 int nFogVolumeID, uint nDLightMask, bool bLMapGeneration,
 															 const CCamera & EntViewCamera, Vec3d * pvAmbColor, Vec3d * pvDynAmbColor,
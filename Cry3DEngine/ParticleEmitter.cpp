@@ -16,6 +16,7 @@
 #include "StdAfx.h"
 #include "ParticleEmitter.h"
 #include "partman.h"
+#include "ParticleSoA.h"
 
 //////////////////////////////////////////////////////////////////////////
 CParticleEmitter::~CParticleEmitter()
@@ -23,6 +24,7 @@ CParticleEmitter::~CParticleEmitter()
 	if (m_bActive)
 		OnActivate(false);
 	ReleaseParams();
+	delete m_pSoA;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -19,6 +19,8 @@
 
 #include <ISound.h>
 
+class CParticleSoA;
+
 /*! Temporary emitter position for ParticleEffects.
 */
 class CParticleEmitter : public IParticleEmitter
@@ -75,6 +77,9 @@ public:
 	// Particle emitter looped sound.
 	_smart_ptr<ISound> m_pSound;
 
+	//! Particles simulated in float streams, created by the sprite manager on first spawn.
+	CParticleSoA *m_pSoA;
+
 	//////////////////////////////////////////////////////////////////////////
 	// Methods.
 	//////////////////////////////////////////////////////////////////////////
@@ -95,6 +100,7 @@ public:
 		m_bLoopSound = false;
 		m_bUseEndTime=false;
 		m_bChildEmitter = false;
+		m_pSoA = 0;
 	}
 	~CParticleEmitter();
 	void ReleaseParams();
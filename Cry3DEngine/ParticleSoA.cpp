@@ -0,0 +1,1127 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  Crytek Engine Source File.
+//  Copyright (C), Crytek Studios, 2002.
+// -------------------------------------------------------------------------
+//  File name:   ParticleSoA.cpp
+//  Version:     v1.00
+//  Compilers:   Visual Studio.NET
+//  Description: move and render particles kept as float streams
+// -------------------------------------------------------------------------
+//  History:
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+
+#include "partman.h"
+#include "objman.h"
+#include "visareas.h"
+#include "3dEngine.h"
+#include "ParticleSoA.h"
+
+#ifdef PARTICLES_SSE
+#include <xmmintrin.h>
+#endif
+
+list2<SColorVert> CParticleSoA::m_lstVerts;
+list2<SColorVert> CParticleSoA::m_lstSortedVerts;
+list2<int> CParticleSoA::m_lstFrames;
+list2<int> CParticleSoA::m_lstFrameStart;
+list2<float> CParticleSoA::m_lstSin;
+list2<float> CParticleSoA::m_lstCos;
+
+#ifdef PARTICLES_SSE
+// SSE1 has no floor, round with the 1.5*2^23 trick and step down where it rounded up
+static inline __m128 FloorPS(__m128 v)
+{
+	const __m128 vMagic = _mm_set1_ps(12582912.f);
+	__m128 r = _mm_sub_ps(_mm_add_ps(v, vMagic), vMagic);
+	return _mm_sub_ps(r, _mm_and_ps(_mm_cmpgt_ps(r, v), _mm_set1_ps(1.f)));
+}
+
+static inline __m128 Clamp01PS(__m128 v)
+{
+	return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+}
+
+// mask ? a : b
+static inline __m128 SelectPS(__m128 vMask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(vMask, a), _mm_andnot_ps(vMask, b));
+}
+
+// x is wrapped into [c-m,c+m) by a multiple of 2m, returns the number of 2m steps
+static inline __m128 WrapPS(__m128 &x, __m128 c, float m)
+{
+	__m128 k = FloorPS(_mm_mul_ps(_mm_add_ps(_mm_sub_ps(x, c), _mm_set1_ps(m)), _mm_set1_ps(0.5f/m)));
+	x = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(m*2)));
+	return k;
+}
+#endif
+
+// same as the while loops of CParticle::Update
+static inline float WrapCoord(float x, float c, float m, float &k)
+{
+	k = cry_floorf((x-c+m)*(0.5f/m));
+	return x - k*(m*2);
+}
+
+static inline float Clamp01(float f)
+{
+	if(f<0) return 0;
+	if(f>1) return 1;
+	return f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+CParticleSoA::CParticleSoA()
+{
+	m_pData = 0;
+	m_pStreams = 0;
+	m_pDead = 0;
+	m_nCount = 0;
+	m_nAlloc = 0;
+	m_bRotated = false;
+	m_cAmbientColor = 0;
+	m_vBoxMin(0,0,0);
+	m_vBoxMax(0,0,0);
+
+#if defined(PARTICLES_SSE) && defined(_CPU_X86)
+	m_bUseSSE = (Cry3DEngineBase::m_CpuFlags & CPUF_SSE) != 0;
+#elif defined(PARTICLES_SSE)
+	m_bUseSSE = true;
+#else
+	m_bUseSSE = false;
+#endif
+}
+
+CParticleSoA::~CParticleSoA()
+{
+	delete [] m_pData;
+	delete [] m_pDead;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CParticleSoA::IsSupported( const ParticleParams &Params )
+{
+	if(Params.bRealPhysics || Params.pStatObj || Params.nTexId <= 0)
+		return false;
+
+	if(Params.pChild && Params.pChild->nCount > 0)
+		return false;
+
+	if(Params.fTailLenght || Params.fStretch || Params.fTurbulenceSize)
+		return false;
+
+	if(Params.nParticleFlags & (PART_FLAG_LINEPARTICLE | PART_FLAG_RIGIDBODY | PART_FLAG_BIND_POSITION_TO_EMITTER))
+		return false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::Reserve( int nCount )
+{
+	if(nCount <= m_nAlloc)
+		return;
+
+	int nAlloc = max(16, m_nAlloc*2);
+	while(nAlloc < nCount)
+		nAlloc *= 2;
+
+	float * pData = new float[nAlloc*S_COUNT+4];
+	float * pStreams = (float*)(((UINT_PTR)pData + 15) & ~(UINT_PTR)15);
+	unsigned char * pDead = new unsigned char[nAlloc];
+	memset(pStreams, 0, sizeof(float)*nAlloc*S_COUNT);
+	memset(pDead, 0, nAlloc);
+
+	if(m_nCount)
+	{
+		for(int s=0; s<S_COUNT; s++)
+			memcpy(pStreams + s*nAlloc, Stream(s), sizeof(float)*m_nCount);
+		memcpy(pDead, m_pDead, m_nCount);
+	}
+
+	delete [] m_pData;
+	delete [] m_pDead;
+	m_pData = pData;
+	m_pStreams = pStreams;
+	m_pDead = pDead;
+	m_nAlloc = nAlloc;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::Add( const CParticle &part )
+{
+	Reserve(m_nCount+1);
+
+	int i = m_nCount++;
+	Stream(S_POS_X)[i] = part.m_vPos.x;
+	Stream(S_POS_Y)[i] = part.m_vPos.y;
+	Stream(S_POS_Z)[i] = part.m_vPos.z;
+	Stream(S_DIR_X)[i] = part.m_vDelta.x;
+	Stream(S_DIR_Y)[i] = part.m_vDelta.y;
+	Stream(S_DIR_Z)[i] = part.m_vDelta.z;
+	Stream(S_SIZE)[i] = part.m_fSize;
+	Stream(S_SIZE_ORIG)[i] = part.m_fSizeOriginal;
+	Stream(S_SPAWN_TIME)[i] = part.m_fSpawnTime;
+	Stream(S_LIFE_TIME)[i] = part.m_fLifeTime;
+	Stream(S_ANGLE)[i] = part.m_vAngles.z;
+	Stream(S_ROT_SPEED)[i] = part.m_vRotation.z;
+	Stream(S_SCALE)[i] = part.m_fScale;
+	m_pDead[i] = 0;
+
+	if(part.m_vAngles.z || part.m_vRotation.z)
+		m_bRotated = true;
+
+	m_cAmbientColor = part.m_cAmbientColor;
+
+	Vec3 vSize(part.m_fSize,part.m_fSize,part.m_fSize);
+	if(m_nCount == 1)
+	{
+		m_vBoxMin = part.m_vPos - vSize;
+		m_vBoxMax = part.m_vPos + vSize;
+	}
+	else
+	{
+		m_vBoxMin.CheckMin(part.m_vPos - vSize);
+		m_vBoxMax.CheckMax(part.m_vPos + vSize);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::Update( CParticleEmitter &emitter,const PartProcessParams &PPP )
+{
+	if(!m_nCount)
+		return;
+
+	const ParticleParams * pParams = emitter.m_pParams;
+	if(!pParams || !IsSupported(*pParams))
+	{ // emitter got params that need the sprite path, drop what was spawned with the old ones
+		Clear();
+		return;
+	}
+
+	const ParticleParams &Params = *pParams;
+
+	if(Params.nParticleFlags & PART_FLAG_BIND_EMITTER_TO_CAMERA)
+	{
+		float fLen = Params.vSpaceLoopBoxSize.GetLength();
+		Vec3d vDir = PPP.pCamera->GetVCMatrixD3D9().GetOrtZ();
+		emitter.m_pos = PPP.pCamera->GetPos()-vDir*fLen*0.75f;
+	}
+
+	Move( Params,emitter,PPP );
+
+	if(PPP.pTerrain && !(Params.nParticleFlags & PART_FLAG_SPACELOOP))
+		CollideWithTerrain( Params,PPP );
+
+	KillAndBound( Params,emitter,PPP );
+
+	if(Params.nParticleFlags & PART_FLAG_NO_INDOOR)
+		KillIndoor();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Space loop, space limit test of the next position, movement, rotation and size.
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::Move( const ParticleParams &Params,const CParticleEmitter &emitter,const PartProcessParams &PPP )
+{
+	float * pPosX = Stream(S_POS_X), * pPosY = Stream(S_POS_Y), * pPosZ = Stream(S_POS_Z);
+	float * pDirX = Stream(S_DIR_X), * pDirY = Stream(S_DIR_Y), * pDirZ = Stream(S_DIR_Z);
+	float * pSize = Stream(S_SIZE);
+	const float * pSizeOrig = Stream(S_SIZE_ORIG);
+	const float * pSpawnTime = Stream(S_SPAWN_TIME);
+	const float * pLifeTime = Stream(S_LIFE_TIME);
+	float * pAngle = Stream(S_ANGLE);
+	const float * pRotSpeed = Stream(S_ROT_SPEED);
+	const float * pScale = Stream(S_SCALE);
+
+	const int nFlags = Params.nParticleFlags;
+	const float fDt = PPP.fFrameTime;
+	const float fCurTime = PPP.fCurTime;
+
+	const bool bSpaceLoop = (nFlags & PART_FLAG_SPACELOOP) != 0;
+	const Vec3 vLoopCenter = emitter.m_pos;
+	const Vec3 vLoopBox = Params.vSpaceLoopBoxSize;
+
+	const bool bSpaceLimit = (nFlags & PART_FLAG_SPACELIMIT) != 0;
+	Vec3 vLimitMin = Params.vPosition - Params.vSpaceLoopBoxSize;
+	Vec3 vLimitMax = Params.vPosition + Params.vSpaceLoopBoxSize;
+	vLimitMin.CheckMin(Params.vPosition + Params.vSpaceLoopBoxSize);
+	vLimitMax.CheckMax(Params.vPosition - Params.vSpaceLoopBoxSize);
+
+	const float fSpeedFadeOut = Params.fSpeedFadeOut;
+	const float fInvSpeedFadeOut = fSpeedFadeOut ? 1.f/fSpeedFadeOut : 0;
+	const Vec3 vGravityDt = Params.vGravity*fDt;
+	const float fAccelDt = Params.fSpeedAccel*fDt;
+	const float fAirDt = Params.fAirResistance*fDt;
+	const float fRotDt = fDt*(180.0f/gf_PI);
+	const float fSizeSpeedDt = Params.fSizeSpeed*fDt;
+	const bool bSizeLinear = (nFlags & PART_FLAG_SIZE_LINEAR) != 0;
+	const float fSizeFadeIn = Params.fSizeFadeIn;
+	const float fInvSizeFadeIn = fSizeFadeIn ? 1.f/fSizeFadeIn : 0;
+	const float fSizeFadeOut = Params.fSizeFadeOut;
+	const float fInvSizeFadeOut = fSizeFadeOut ? 1.f/fSizeFadeOut : 0;
+
+	int i = 0;
+
+#ifdef PARTICLES_SSE
+	if(m_bUseSSE)
+	{
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vOne = _mm_set1_ps(1.f);
+		const __m128 vDt = _mm_set1_ps(fDt);
+		const __m128 vCurTime = _mm_set1_ps(fCurTime);
+
+		for(; i+4<=m_nCount; i+=4)
+		{
+			__m128 vX = _mm_load_ps(pPosX+i), vY = _mm_load_ps(pPosY+i), vZ = _mm_load_ps(pPosZ+i);
+			__m128 vDX = _mm_load_ps(pDirX+i), vDY = _mm_load_ps(pDirY+i), vDZ = _mm_load_ps(pDirZ+i);
+
+			int nWrappedUp = 0;
+			if(bSpaceLoop)
+			{
+				if(vLoopBox.x>0)
+					WrapPS(vX, _mm_set1_ps(vLoopCenter.x), vLoopBox.x);
+				if(vLoopBox.y>0)
+					WrapPS(vY, _mm_set1_ps(vLoopCenter.y), vLoopBox.y);
+				if(vLoopBox.z>0)
+					nWrappedUp = _mm_movemask_ps(_mm_cmplt_ps(WrapPS(vZ, _mm_set1_ps(vLoopCenter.z), vLoopBox.z), vZero));
+			}
+
+			int nDead = 0;
+			if(bSpaceLimit)
+			{
+				__m128 vNX = _mm_add_ps(vX, _mm_mul_ps(vDX, vDt));
+				__m128 vNY = _mm_add_ps(vY, _mm_mul_ps(vDY, vDt));
+				__m128 vNZ = _mm_add_ps(vZ, _mm_mul_ps(vDZ, vDt));
+				__m128 vOut = _mm_or_ps(_mm_cmplt_ps(vNX, _mm_set1_ps(vLimitMin.x)), _mm_cmpgt_ps(vNX, _mm_set1_ps(vLimitMax.x)));
+				vOut = _mm_or_ps(vOut, _mm_or_ps(_mm_cmplt_ps(vNY, _mm_set1_ps(vLimitMin.y)), _mm_cmpgt_ps(vNY, _mm_set1_ps(vLimitMax.y))));
+				vOut = _mm_or_ps(vOut, _mm_or_ps(_mm_cmplt_ps(vNZ, _mm_set1_ps(vLimitMin.z)), _mm_cmpgt_ps(vNZ, _mm_set1_ps(vLimitMax.z))));
+				nDead = _mm_movemask_ps(vOut);
+			}
+
+			__m128 vAge = _mm_sub_ps(vCurTime, _mm_load_ps(pSpawnTime+i));
+			__m128 vLife = _mm_load_ps(pLifeTime+i);
+			__m128 vScale = _mm_load_ps(pScale+i);
+
+			// fade out speed
+			__m128 vMoveDt = vDt;
+			if(fSpeedFadeOut)
+				vMoveDt = _mm_mul_ps(vDt, Clamp01PS(_mm_mul_ps(_mm_sub_ps(vLife, vAge), _mm_set1_ps(fInvSpeedFadeOut))));
+
+			vX = _mm_add_ps(vX, _mm_mul_ps(vDX, vMoveDt));
+			vY = _mm_add_ps(vY, _mm_mul_ps(vDY, vMoveDt));
+			vZ = _mm_add_ps(vZ, _mm_mul_ps(vDZ, vMoveDt));
+
+			vDX = _mm_add_ps(vDX, _mm_mul_ps(_mm_set1_ps(vGravityDt.x), vScale));
+			vDY = _mm_add_ps(vDY, _mm_mul_ps(_mm_set1_ps(vGravityDt.y), vScale));
+			vDZ = _mm_add_ps(vDZ, _mm_mul_ps(_mm_set1_ps(vGravityDt.z), vScale));
+
+			if(fAccelDt)
+			{ // accelerate along the heading
+				__m128 vSpeed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vDX,vDX), _mm_mul_ps(vDY,vDY)), _mm_mul_ps(vDZ,vDZ)));
+				__m128 vF = _mm_add_ps(vOne, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(fAccelDt), vScale), vSpeed));
+				vF = SelectPS(_mm_cmpgt_ps(vSpeed, vZero), vF, vOne);
+				vDX = _mm_mul_ps(vDX, vF);
+				vDY = _mm_mul_ps(vDY, vF);
+				vDZ = _mm_mul_ps(vDZ, vF);
+			}
+
+			if(fAirDt)
+			{ // resistance speed*speed*fAirResistance*dt, at most the speed
+				__m128 vSpeed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vDX,vDX), _mm_mul_ps(vDY,vDY)), _mm_mul_ps(vDZ,vDZ)));
+				__m128 vF = _mm_sub_ps(vOne, _mm_min_ps(_mm_mul_ps(vSpeed, _mm_set1_ps(fAirDt)), vOne));
+				vDX = _mm_mul_ps(vDX, vF);
+				vDY = _mm_mul_ps(vDY, vF);
+				vDZ = _mm_mul_ps(vDZ, vF);
+			}
+
+			_mm_store_ps(pAngle+i, _mm_add_ps(_mm_load_ps(pAngle+i), _mm_mul_ps(_mm_load_ps(pRotSpeed+i), _mm_set1_ps(fRotDt))));
+
+			__m128 vSize = _mm_load_ps(pSize+i);
+			if(fSizeSpeedDt)
+			{
+				__m128 vInc = _mm_mul_ps(_mm_set1_ps(fSizeSpeedDt), vScale);
+				if(!bSizeLinear)
+					vInc = SelectPS(_mm_cmpgt_ps(vSize, vOne), _mm_div_ps(vInc, vSize), vInc);
+				vSize = _mm_add_ps(vSize, vInc);
+			}
+
+			__m128 vSizeOrig = _mm_load_ps(pSizeOrig+i);
+			__m128 vScaleFade = vOne;
+			if(fSizeFadeIn)
+			{
+				__m128 vIn = _mm_cmple_ps(vAge, _mm_set1_ps(fSizeFadeIn));
+				vScaleFade = SelectPS(vIn, Clamp01PS(_mm_mul_ps(vAge, _mm_set1_ps(fInvSizeFadeIn))), vOne);
+				vSize = SelectPS(vIn, _mm_mul_ps(vSizeOrig, vScaleFade), vSize);
+			}
+			if(fSizeFadeOut)
+			{
+				__m128 vT = _mm_sub_ps(vLife, vAge);
+				__m128 vOut = _mm_cmplt_ps(vT, _mm_set1_ps(fSizeFadeOut));
+				vT = _mm_max_ps(vT, vZero);
+				vScaleFade = Clamp01PS(_mm_mul_ps(vScaleFade, _mm_mul_ps(vT, _mm_set1_ps(fInvSizeFadeOut))));
+				vSize = SelectPS(vOut, _mm_mul_ps(vSizeOrig, vScaleFade), vSize);
+			}
+			vSize = SelectPS(_mm_cmplt_ps(vSize, _mm_set1_ps(0.001f)), _mm_set1_ps(0.0001f), vSize);
+
+			_mm_store_ps(pPosX+i, vX); _mm_store_ps(pPosY+i, vY); _mm_store_ps(pPosZ+i, vZ);
+			_mm_store_ps(pDirX+i, vDX); _mm_store_ps(pDirY+i, vDY); _mm_store_ps(pDirZ+i, vDZ);
+			_mm_store_ps(pSize+i, vSize);
+
+			if(nDead | nWrappedUp)
+			for(int l=0; l<4; l++)
+			{
+				if(nDead & (1<<l))
+					m_pDead[i+l] = 1;
+				if(nWrappedUp & (1<<l))
+					pPosZ[i+l] -= rnd(); // random height when wrapped to the top, like the scalar loop
+			}
+		}
+	}
+#endif
+
+	for(; i<m_nCount; i++)
+	{
+		float x = pPosX[i], y = pPosY[i], z = pPosZ[i];
+
+		if(bSpaceLoop)
+		{
+			float k;
+			if(vLoopBox.x>0)
+				x = WrapCoord(x, vLoopCenter.x, vLoopBox.x, k);
+			if(vLoopBox.y>0)
+				y = WrapCoord(y, vLoopCenter.y, vLoopBox.y, k);
+			if(vLoopBox.z>0)
+			{
+				z = WrapCoord(z, vLoopCenter.z, vLoopBox.z, k);
+				if(k<0)
+					z -= rnd();
+			}
+		}
+
+		if(bSpaceLimit)
+		{
+			float nx = x + pDirX[i]*fDt, ny = y + pDirY[i]*fDt, nz = z + pDirZ[i]*fDt;
+			if(	nx < vLimitMin.x || ny < vLimitMin.y || nz < vLimitMin.z ||
+					nx > vLimitMax.x || ny > vLimitMax.y || nz > vLimitMax.z )
+				m_pDead[i] = 1;
+		}
+
+		float fAge = fCurTime - pSpawnTime[i];
+		float fLifeTime = pLifeTime[i];
+		float fScale = pScale[i];
+
+		float fMoveDt = fDt;
+		if(fSpeedFadeOut)
+			fMoveDt *= Clamp01((fLifeTime - fAge)*fInvSpeedFadeOut);
+
+		x += pDirX[i]*fMoveDt;
+		y += pDirY[i]*fMoveDt;
+		z += pDirZ[i]*fMoveDt;
+
+		float dx = pDirX[i] + vGravityDt.x*fScale;
+		float dy = pDirY[i] + vGravityDt.y*fScale;
+		float dz = pDirZ[i] + vGravityDt.z*fScale;
+
+		if(fAccelDt)
+		{
+			float fSpeed = cry_sqrtf(dx*dx+dy*dy+dz*dz);
+			if(fSpeed > 0)
+			{
+				float f = 1.f + fAccelDt*fScale/fSpeed;
+				dx *= f; dy *= f; dz *= f;
+			}
+		}
+
+		if(fAirDt)
+		{
+			float fSpeed = cry_sqrtf(dx*dx+dy*dy+dz*dz);
+			float f = 1.f - min(fSpeed*fAirDt, 1.f);
+			dx *= f; dy *= f; dz *= f;
+		}
+
+		pAngle[i] += pRotSpeed[i]*fRotDt;
+
+		float fSize = pSize[i];
+		if(fSizeSpeedDt)
+		{
+			float fInc = fSizeSpeedDt*fScale;
+			if(!bSizeLinear && fSize > 1)
+				fInc /= fSize;
+			fSize += fInc;
+		}
+
+		float fScaleFade = 1.f;
+		if(fSizeFadeIn && fAge <= fSizeFadeIn)
+		{
+			fScaleFade = Clamp01(fAge*fInvSizeFadeIn);
+			fSize = pSizeOrig[i]*fScaleFade;
+		}
+		if(fSizeFadeOut && fLifeTime - fAge < fSizeFadeOut)
+		{
+			float t = max(fLifeTime - fAge, 0.f);
+			fScaleFade = Clamp01(fScaleFade*t*fInvSizeFadeOut);
+			fSize = pSizeOrig[i]*fScaleFade;
+		}
+		if(fSize < 0.001f)
+			fSize = 0.0001f;
+
+		pPosX[i] = x; pPosY[i] = y; pPosZ[i] = z;
+		pDirX[i] = dx; pDirY[i] = dy; pDirZ[i] = dz;
+		pSize[i] = fSize;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Bounce from the terrain, only falling particles can hit it.
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::CollideWithTerrain( const ParticleParams &Params,const PartProcessParams &PPP )
+{
+	const float * pPosX = Stream(S_POS_X), * pPosY = Stream(S_POS_Y), * pPosZ = Stream(S_POS_Z);
+	float * pDirX = Stream(S_DIR_X), * pDirY = Stream(S_DIR_Y), * pDirZ = Stream(S_DIR_Z);
+	float * pRotSpeed = Stream(S_ROT_SPEED);
+	const float * pScale = Stream(S_SCALE);
+
+	const float fFriction = 0.15f;
+	const int nUnit = CTerrain::GetHeightMapUnitSize();
+	CTerrain * pTerrain = PPP.pTerrain;
+
+	for(int i=0; i<m_nCount; i++)
+	{
+		if(pDirZ[i] >= 0 || m_pDead[i])
+			continue;
+
+		float x = pPosX[i], y = pPosY[i], z = pPosZ[i];
+		if(!_finite(x) || !_finite(y))
+			continue;
+
+		float fTerrainZ = pTerrain->GetZApr(x,y);
+		if(z >= fTerrainZ || z <= fTerrainZ-0.1f)
+			continue;
+
+		int nX = (int)x;
+		int nY = (int)y;
+		if(	pTerrain->GetHoleSafe(nX,nY) ||
+				pTerrain->GetHoleSafe(nX+nUnit,nY+nUnit) ||
+				pTerrain->GetHoleSafe(nX-nUnit,nY+nUnit) ||
+				pTerrain->GetHoleSafe(nX+nUnit,nY-nUnit) ||
+				pTerrain->GetHoleSafe(nX-nUnit,nY-nUnit) )
+			continue;
+
+		Vec3 vDelta(pDirX[i],pDirY[i],pDirZ[i]);
+		float fLen = (vDelta - Params.vGravity*pScale[i]*PPP.fFrameTime).Length()-fFriction;
+
+		if(fLen>fFriction)
+		{
+			vDelta.z = -vDelta.z;
+			vDelta.SetLen( fLen*Params.fBouncenes );
+		}
+		else
+		{
+			vDelta(0,0,0);
+			pRotSpeed[i] = 0;
+		}
+
+		if(!IsEquivalent(vDelta,Vec3(0,0,0), 0.001f))
+		{ // spin around the side axis of the movement
+			Vec3d vVec(vDelta.x,vDelta.y,0);
+			if(vVec.Normalize())
+			{
+				vVec = vVec.Cross(Vec3d(0,0,1));
+				quaternionf q(0, vVec.x,vVec.y,vVec.z);
+				Vec3 vRotation = Ang3::GetAnglesXYZ( matrix3x3f(q) );
+				pRotSpeed[i] = vRotation.z*Params.fBouncenes*2;
+				if(pRotSpeed[i])
+					m_bRotated = true;
+			}
+		}
+
+		pDirX[i] = vDelta.x;
+		pDirY[i] = vDelta.y;
+		pDirZ[i] = vDelta.z;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Life time, water and space limit kills; bounds of all particles.
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::KillAndBound( const ParticleParams &Params,const CParticleEmitter &emitter,const PartProcessParams &PPP )
+{
+	const float * pPosX = Stream(S_POS_X), * pPosY = Stream(S_POS_Y), * pPosZ = Stream(S_POS_Z);
+	const float * pDirX = Stream(S_DIR_X), * pDirY = Stream(S_DIR_Y), * pDirZ = Stream(S_DIR_Z);
+	const float * pSize = Stream(S_SIZE);
+	const float * pSpawnTime = Stream(S_SPAWN_TIME);
+	const float * pLifeTime = Stream(S_LIFE_TIME);
+
+	const int nFlags = Params.nParticleFlags;
+	const float fCurTime = PPP.fCurTime;
+
+	const bool bUnderWater = (nFlags & PART_FLAG_UNDERWATER) && emitter.m_fWaterLevel>WATER_LEVEL_UNKNOWN;
+	const float fWaterLevel = emitter.m_fWaterLevel;
+
+	const bool bSpaceLimit = (nFlags & PART_FLAG_SPACELIMIT) != 0;
+	Vec3 vLimitMin = Params.vPosition - Params.vSpaceLoopBoxSize;
+	Vec3 vLimitMax = Params.vPosition + Params.vSpaceLoopBoxSize;
+	vLimitMin.CheckMin(Params.vPosition + Params.vSpaceLoopBoxSize);
+	vLimitMax.CheckMax(Params.vPosition - Params.vSpaceLoopBoxSize);
+
+	Vec3 vBoxMin(pPosX[0]-pSize[0],pPosY[0]-pSize[0],pPosZ[0]-pSize[0]);
+	Vec3 vBoxMax(pPosX[0]+pSize[0],pPosY[0]+pSize[0],pPosZ[0]+pSize[0]);
+
+	int i = 0;
+
+#ifdef PARTICLES_SSE
+	if(m_bUseSSE && m_nCount>=4)
+	{
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vCurTime = _mm_set1_ps(fCurTime);
+		__m128 vMinX = _mm_set1_ps(vBoxMin.x), vMinY = _mm_set1_ps(vBoxMin.y), vMinZ = _mm_set1_ps(vBoxMin.z);
+		__m128 vMaxX = _mm_set1_ps(vBoxMax.x), vMaxY = _mm_set1_ps(vBoxMax.y), vMaxZ = _mm_set1_ps(vBoxMax.z);
+
+		for(; i+4<=m_nCount; i+=4)
+		{
+			__m128 vX = _mm_load_ps(pPosX+i), vY = _mm_load_ps(pPosY+i), vZ = _mm_load_ps(pPosZ+i);
+			__m128 vSize = _mm_load_ps(pSize+i);
+
+			__m128 vDead = _mm_cmpge_ps(vCurTime, _mm_add_ps(_mm_load_ps(pSpawnTime+i), _mm_load_ps(pLifeTime+i)));
+
+			if(bUnderWater)
+				vDead = _mm_or_ps(vDead, _mm_cmpgt_ps(vZ, _mm_sub_ps(_mm_set1_ps(fWaterLevel), _mm_mul_ps(vSize, _mm_set1_ps(0.5f)))));
+
+			if(bSpaceLimit)
+			{ // front point of the particle in movement direction
+				__m128 vDX = _mm_load_ps(pDirX+i), vDY = _mm_load_ps(pDirY+i), vDZ = _mm_load_ps(pDirZ+i);
+				__m128 vSpeed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vDX,vDX), _mm_mul_ps(vDY,vDY)), _mm_mul_ps(vDZ,vDZ)));
+				__m128 vF = _mm_and_ps(_mm_cmpgt_ps(vSpeed, vZero), _mm_div_ps(vSize, vSpeed));
+				__m128 vHX = _mm_add_ps(vX, _mm_mul_ps(vDX, vF));
+				__m128 vHY = _mm_add_ps(vY, _mm_mul_ps(vDY, vF));
+				__m128 vHZ = _mm_add_ps(vZ, _mm_mul_ps(vDZ, vF));
+				vDead = _mm_or_ps(vDead, _mm_or_ps(_mm_cmplt_ps(vHX, _mm_set1_ps(vLimitMin.x)), _mm_cmpgt_ps(vHX, _mm_set1_ps(vLimitMax.x))));
+				vDead = _mm_or_ps(vDead, _mm_or_ps(_mm_cmplt_ps(vHY, _mm_set1_ps(vLimitMin.y)), _mm_cmpgt_ps(vHY, _mm_set1_ps(vLimitMax.y))));
+				vDead = _mm_or_ps(vDead, _mm_or_ps(_mm_cmplt_ps(vHZ, _mm_set1_ps(vLimitMin.z)), _mm_cmpgt_ps(vHZ, _mm_set1_ps(vLimitMax.z))));
+			}
+
+			if(int nDead = _mm_movemask_ps(vDead))
+			for(int l=0; l<4; l++)
+				if(nDead & (1<<l))
+					m_pDead[i+l] = 1;
+
+			vMinX = _mm_min_ps(vMinX, _mm_sub_ps(vX, vSize)); vMaxX = _mm_max_ps(vMaxX, _mm_add_ps(vX, vSize));
+			vMinY = _mm_min_ps(vMinY, _mm_sub_ps(vY, vSize)); vMaxY = _mm_max_ps(vMaxY, _mm_add_ps(vY, vSize));
+			vMinZ = _mm_min_ps(vMinZ, _mm_sub_ps(vZ, vSize)); vMaxZ = _mm_max_ps(vMaxZ, _mm_add_ps(vZ, vSize));
+		}
+
+		float arrMin[3][4], arrMax[3][4];
+		_mm_storeu_ps(arrMin[0], vMinX); _mm_storeu_ps(arrMin[1], vMinY); _mm_storeu_ps(arrMin[2], vMinZ);
+		_mm_storeu_ps(arrMax[0], vMaxX); _mm_storeu_ps(arrMax[1], vMaxY); _mm_storeu_ps(arrMax[2], vMaxZ);
+		for(int l=0; l<4; l++)
+		{
+			vBoxMin.CheckMin(Vec3(arrMin[0][l],arrMin[1][l],arrMin[2][l]));
+			vBoxMax.CheckMax(Vec3(arrMax[0][l],arrMax[1][l],arrMax[2][l]));
+		}
+	}
+#endif
+
+	for(; i<m_nCount; i++)
+	{
+		Vec3 vPos(pPosX[i],pPosY[i],pPosZ[i]);
+		float fSize = pSize[i];
+
+		if(fCurTime >= pSpawnTime[i] + pLifeTime[i])
+			m_pDead[i] = 1;
+		else if(bUnderWater && vPos.z > fWaterLevel-fSize*0.5f)
+			m_pDead[i] = 1;
+
+		if(bSpaceLimit)
+		{
+			Vec3 vDelta(pDirX[i],pDirY[i],pDirZ[i]);
+			float fSpeed = vDelta.GetLength();
+			Vec3 vHitPos = vPos;
+			if(fSpeed > 0)
+				vHitPos += vDelta*(fSize/fSpeed);
+
+			if(	vHitPos.x < vLimitMin.x || vHitPos.y < vLimitMin.y || vHitPos.z < vLimitMin.z ||
+					vHitPos.x > vLimitMax.x || vHitPos.y > vLimitMax.y || vHitPos.z > vLimitMax.z )
+				m_pDead[i] = 1;
+		}
+
+		Vec3 vSize(fSize,fSize,fSize);
+		vBoxMin.CheckMin(vPos - vSize);
+		vBoxMax.CheckMax(vPos + vSize);
+	}
+
+	m_vBoxMin = vBoxMin;
+	m_vBoxMax = vBoxMax;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::KillIndoor()
+{
+	// rain and snow are mostly nowhere near an area, then no particle has to be tested
+	CVisAreaManager * pVisAreaManager = GetVisAreaManager();
+	if(!pVisAreaManager || !pVisAreaManager->IsBoxOverlapVisAreas(m_vBoxMin,m_vBoxMax))
+		return;
+
+	// batched queries, the particles of one emitter are close to each other
+	enum { nBatch = 64 };
+	Vec3d arrPos[nBatch];
+	IVisArea * arrAreas[nBatch];
+	const float * pPosX = Stream(S_POS_X), * pPosY = Stream(S_POS_Y), * pPosZ = Stream(S_POS_Z);
+	for(int nFirst=0; nFirst<m_nCount; nFirst+=nBatch)
+	{
+		int n = min((int)nBatch, m_nCount-nFirst);
+		for(int i=0; i<n; i++)
+			arrPos[i].Set(pPosX[nFirst+i],pPosY[nFirst+i],pPosZ[nFirst+i]);
+
+		pVisAreaManager->GetVisAreasFromPos(arrPos, n, arrAreas);
+
+		for(int i=0; i<n; i++)
+			if(arrAreas[i])
+				m_pDead[nFirst+i] = 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::RemoveDead()
+{
+	// keep the order, the slots are overwritten from the front
+	int nNew = 0;
+	for(int i=0; i<m_nCount; i++)
+	{
+		if(m_pDead[i])
+			continue;
+
+		if(nNew != i)
+			for(int s=0; s<S_COUNT; s++)
+				Stream(s)[nNew] = Stream(s)[i];
+		m_pDead[nNew] = 0;
+		nNew++;
+	}
+	m_nCount = nNew;
+
+	if(!m_nCount)
+		m_bRotated = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int CParticleSoA::GetMemoryUsage() const
+{
+	int nSize = sizeof(*this);
+	if(m_pData)
+		nSize += (m_nAlloc*S_COUNT+4)*sizeof(float) + m_nAlloc;
+	return nSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Same look as CSprite::Render, but the lighting, sorting and the object
+// are done once per emitter and the quads go to the renderer in batches.
+//////////////////////////////////////////////////////////////////////////
+void CParticleSoA::Render( CParticleEmitter &emitter,const PartProcessParams &PPP,IShader *pShader,int nRecursionLevel )
+{
+	const ParticleParams * pParams = emitter.m_pParams;
+	if(!m_nCount || !pParams || !IsSupported(*pParams))
+		return;
+
+	const ParticleParams &Params = *pParams;
+	const int nFlags = Params.nParticleFlags;
+
+	// horizontal sprites are not drawn into reflections
+	if(nRecursionLevel && (nFlags & PART_FLAG_HORIZONTAL))
+		return;
+
+	bool bAllIn = false;
+	if(PPP.pCamera->IsAABBVisible_hierarchical( AABB(m_vBoxMin,m_vBoxMax),&bAllIn ) == CULL_EXCLUSION)
+		return;
+
+	IMatInfo * pMaterial = Params.pMaterial ? Params.pMaterial : (IMatInfo*)emitter.m_pMaterial;
+	if(emitter.m_pShader)
+		pShader = emitter.m_pShader;
+	else if(Params.pShader)
+		pShader = Params.pShader;
+	else if(pMaterial)
+	{
+		IShader * pShaderContainer = pMaterial->GetShaderItem().m_pShader;
+		if(pShaderContainer)
+			pShader = pShaderContainer->GetTemplate(-1);
+	}
+
+	int dwCCObjFlags = 0;
+	if(nFlags & PART_FLAG_DRAW_NEAR)
+		dwCCObjFlags = FOB_NEAREST;
+
+	Vec3 vCenter = (m_vBoxMin+m_vBoxMax)*0.5f;
+	float fRadius = (m_vBoxMax-m_vBoxMin).GetLength()*0.5f;
+
+	uint nDynLightMask = 0;
+	if(Params.eBlendType != ParticleBlendType_Additive)
+	{
+		nDynLightMask = PPP.p3DEngine->GetLightMaskFromPosition(vCenter, fRadius);
+		PPP.p3DEngine->CheckDistancesToLightSources(nDynLightMask,vCenter,fRadius,emitter.m_pSpawnerEntity,1);
+	}
+
+	int nSortId = max(-4,min(4,Params.nDrawLast));
+	nSortId = FtoI(PPP.pObjManager->GetSortOffset(vCenter,PPP.vCamPos,emitter.m_fWaterLevel)) - nSortId;
+
+	const bool bAdditive = Params.eBlendType == ParticleBlendType_Additive;
+	const bool bColorBased = bAdditive || Params.eBlendType == ParticleBlendType_ColorBased;
+
+	// color scale: unlit is black, color based blending fades the color, the rest fades alpha
+	float fColorScale = 0.5f*255.f;
+	bool bColorAlpha = false;
+	if(nDynLightMask==0 && !bAdditive)
+		fColorScale = 0;
+	else if(bColorBased)
+	{
+		fColorScale = 255.f;
+		bColorAlpha = true;
+	}
+
+	Vec3 vAmbientColor(0,0,0);
+	bool bFog = false;
+	float fFogStart = 0, fInvFogRange = 0;
+	if(!bColorBased)
+	{
+		if(PPP.p3DEngine->GetFogEnd()>PPP.p3DEngine->GetFogStart())
+		{
+			bFog = true;
+			fFogStart = PPP.p3DEngine->GetFogStart();
+			fInvFogRange = 1.f/(PPP.p3DEngine->GetFogEnd()-PPP.p3DEngine->GetFogStart());
+		}
+		vAmbientColor.Set(
+			((unsigned char)(m_cAmbientColor))*0.00392156f,
+			((unsigned char)(m_cAmbientColor>>8))*0.00392156f,
+			((unsigned char)(m_cAmbientColor>>16))*0.00392156f );
+	}
+
+	const bool bSpaceLoop = (nFlags & PART_FLAG_SPACELOOP) != 0;
+	const bool bSkipDead = (nFlags & PART_FLAG_SPACELIMIT) != 0;
+	const bool bNoDrawUnderWater = (nFlags & PART_FLAG_NO_DRAW_UNDERWATER) && emitter.m_fWaterLevel>WATER_LEVEL_UNKNOWN;
+	const bool bAnimated = Params.nTexAnimFramesCount > 1 && Params.pAnimTex && Params.pAnimTex->nFramesCount > 0;
+
+	// billboard axes, rotated by angle around vFront: v*cos + (vFront x v)*sin
+	Vec3 vFront, vRight, vUp;
+	if(nFlags & PART_FLAG_HORIZONTAL)
+	{
+		vRight(1,0,0);
+		vUp(0,1,0);
+		vFront(0,0,1);
+	}
+	else
+	{
+		vFront = PPP.vFront;
+		vRight = -PPP.vRight;
+		vUp    = -PPP.vUp;
+	}
+	Vec3 vRightRot = vFront.Cross(vRight);
+	Vec3 vUpRot = vFront.Cross(vUp);
+
+	const float * pPosX = Stream(S_POS_X), * pPosY = Stream(S_POS_Y), * pPosZ = Stream(S_POS_Z);
+	const float * pSize = Stream(S_SIZE);
+	const float * pSpawnTime = Stream(S_SPAWN_TIME);
+	const float * pLifeTime = Stream(S_LIFE_TIME);
+	const float * pAngle = Stream(S_ANGLE);
+
+	if(m_bRotated)
+	{
+		m_lstSin.PreAllocate(m_nCount, m_nCount);
+		m_lstCos.PreAllocate(m_nCount, m_nCount);
+		for(int i=0; i<m_nCount; i++)
+		{
+			float fAngle = DEG2RAD(pAngle[i]);
+			m_lstSin[i] = cry_sinf(fAngle);
+			m_lstCos[i] = cry_cosf(fAngle);
+		}
+	}
+
+	const float fCurTime = PPP.fCurTime;
+	const float fFadeIn = Params.fFadeInTime;
+	const float fInvFadeIn = fFadeIn ? 1.f/fFadeIn : 0;
+	const Vec3 vColorStart = Params.vColorStart;
+	const Vec3 vColorDelta = Params.vColorEnd - Params.vColorStart;
+	const Vec3 vLoopCenter = emitter.m_pos;
+	const Vec3 vLoopBox = Params.vSpaceLoopBoxSize;
+	const float fFrames = (float)(Params.nTexAnimFramesCount-1);
+
+	m_lstVerts.PreAllocate(m_nCount*4, m_nCount*4);
+	m_lstFrames.PreAllocate(m_nCount, m_nCount);
+	SColorVert * pVerts = m_lstVerts.GetElements();
+	int nQuads = 0;
+
+	int i = 0;
+
+#ifdef PARTICLES_SSE
+	if(m_bUseSSE)
+	{
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vOne = _mm_set1_ps(1.f);
+		const __m128 vCurTime = _mm_set1_ps(fCurTime);
+
+		__m128 arrPlaneN[FRUSTUM_PLANES][3], arrPlaneD[FRUSTUM_PLANES];
+		if(!bAllIn)
+		for(int p=0; p<FRUSTUM_PLANES; p++)
+		{
+			const Plane * pPlane = PPP.pCamera->GetFrustumPlane(p);
+			arrPlaneN[p][0] = _mm_set1_ps(pPlane->n.x);
+			arrPlaneN[p][1] = _mm_set1_ps(pPlane->n.y);
+			arrPlaneN[p][2] = _mm_set1_ps(pPlane->n.z);
+			arrPlaneD[p] = _mm_set1_ps(pPlane->d);
+		}
+
+		// corners 0..3 x/y/z, then r,g,b,a and t
+		__m128 arrRes[12+5];
+		const float * pRes = (const float*)arrRes;
+
+		for(; i+4<=m_nCount; i+=4)
+		{
+			__m128 vX = _mm_load_ps(pPosX+i), vY = _mm_load_ps(pPosY+i), vZ = _mm_load_ps(pPosZ+i);
+			__m128 vSize = _mm_load_ps(pSize+i);
+
+			// visibility
+			__m128 vHidden = vZero;
+			if(!bAllIn)
+			for(int p=0; p<FRUSTUM_PLANES; p++)
+			{
+				__m128 vDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(arrPlaneN[p][0], vX), _mm_mul_ps(arrPlaneN[p][1], vY)), _mm_mul_ps(arrPlaneN[p][2], vZ));
+				vHidden = _mm_or_ps(vHidden, _mm_cmpgt_ps(_mm_sub_ps(vDist, arrPlaneD[p]), vSize));
+			}
+			if(bNoDrawUnderWater)
+				vHidden = _mm_or_ps(vHidden, _mm_cmplt_ps(vZ, _mm_set1_ps(emitter.m_fWaterLevel)));
+
+			int nHidden = _mm_movemask_ps(vHidden);
+			if(bSkipDead)
+				nHidden |= (m_pDead[i]?1:0) | (m_pDead[i+1]?2:0) | (m_pDead[i+2]?4:0) | (m_pDead[i+3]?8:0);
+			if(nHidden == 15)
+				continue;
+
+			// billboard vectors
+			__m128 vRX, vRY, vRZ, vUX, vUY, vUZ;
+			if(m_bRotated)
+			{
+				__m128 vC = _mm_mul_ps(_mm_loadu_ps(&m_lstCos[i]), vSize);
+				__m128 vS = _mm_mul_ps(_mm_loadu_ps(&m_lstSin[i]), vSize);
+				vRX = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vRight.x)), _mm_mul_ps(vS, _mm_set1_ps(vRightRot.x)));
+				vRY = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vRight.y)), _mm_mul_ps(vS, _mm_set1_ps(vRightRot.y)));
+				vRZ = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vRight.z)), _mm_mul_ps(vS, _mm_set1_ps(vRightRot.z)));
+				vUX = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vUp.x)), _mm_mul_ps(vS, _mm_set1_ps(vUpRot.x)));
+				vUY = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vUp.y)), _mm_mul_ps(vS, _mm_set1_ps(vUpRot.y)));
+				vUZ = _mm_add_ps(_mm_mul_ps(vC, _mm_set1_ps(vUp.z)), _mm_mul_ps(vS, _mm_set1_ps(vUpRot.z)));
+			}
+			else
+			{
+				vRX = _mm_mul_ps(vSize, _mm_set1_ps(vRight.x));
+				vRY = _mm_mul_ps(vSize, _mm_set1_ps(vRight.y));
+				vRZ = _mm_mul_ps(vSize, _mm_set1_ps(vRight.z));
+				vUX = _mm_mul_ps(vSize, _mm_set1_ps(vUp.x));
+				vUY = _mm_mul_ps(vSize, _mm_set1_ps(vUp.y));
+				vUZ = _mm_mul_ps(vSize, _mm_set1_ps(vUp.z));
+			}
+
+			// corners in the order of AddPolygonToRenderer: -r-u, r-u, r+u, -r+u
+			arrRes[0] = _mm_sub_ps(_mm_sub_ps(vX, vRX), vUX);
+			arrRes[1] = _mm_sub_ps(_mm_sub_ps(vY, vRY), vUY);
+			arrRes[2] = _mm_sub_ps(_mm_sub_ps(vZ, vRZ), vUZ);
+			arrRes[3] = _mm_sub_ps(_mm_add_ps(vX, vRX), vUX);
+			arrRes[4] = _mm_sub_ps(_mm_add_ps(vY, vRY), vUY);
+			arrRes[5] = _mm_sub_ps(_mm_add_ps(vZ, vRZ), vUZ);
+			arrRes[6] = _mm_add_ps(_mm_add_ps(vX, vRX), vUX);
+			arrRes[7] = _mm_add_ps(_mm_add_ps(vY, vRY), vUY);
+			arrRes[8] = _mm_add_ps(_mm_add_ps(vZ, vRZ), vUZ);
+			arrRes[9] = _mm_add_ps(_mm_sub_ps(vX, vRX), vUX);
+			arrRes[10] = _mm_add_ps(_mm_sub_ps(vY, vRY), vUY);
+			arrRes[11] = _mm_add_ps(_mm_sub_ps(vZ, vRZ), vUZ);
+
+			// life time fraction and alpha
+			__m128 vAge = _mm_sub_ps(vCurTime, _mm_load_ps(pSpawnTime+i));
+			__m128 vLife = _mm_load_ps(pLifeTime+i);
+			__m128 vNoLife = _mm_cmpeq_ps(vLife, vZero);
+			__m128 vT = _mm_andnot_ps(vNoLife, Clamp01PS(_mm_div_ps(vAge, vLife)));
+			__m128 vAlpha = _mm_sub_ps(vOne, _mm_div_ps(_mm_sub_ps(vAge, _mm_set1_ps(fFadeIn)), _mm_sub_ps(vLife, _mm_set1_ps(fFadeIn))));
+			vAlpha = SelectPS(vNoLife, vOne, vAlpha);
+			if(fFadeIn && fCurTime)
+				vAlpha = SelectPS(_mm_cmplt_ps(vAge, _mm_set1_ps(fFadeIn)), _mm_mul_ps(vAlpha, _mm_mul_ps(vAge, _mm_set1_ps(fInvFadeIn))), vAlpha);
+			vAlpha = Clamp01PS(_mm_mul_ps(vAlpha, _mm_set1_ps(1.5f)));
+
+			__m128 vColorScale = _mm_set1_ps(fColorScale);
+			if(bColorAlpha)
+				vColorScale = _mm_mul_ps(vColorScale, vAlpha);
+			arrRes[12] = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(vColorStart.x), _mm_mul_ps(vT, _mm_set1_ps(vColorDelta.x))), vColorScale);
+			arrRes[13] = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(vColorStart.y), _mm_mul_ps(vT, _mm_set1_ps(vColorDelta.y))), vColorScale);
+			arrRes[14] = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(vColorStart.z), _mm_mul_ps(vT, _mm_set1_ps(vColorDelta.z))), vColorScale);
+
+			if(bFog)
+			{ // 2d L1 distance to the camera
+				__m128 vDX = _mm_sub_ps(vX, _mm_set1_ps(PPP.vCamPos.x));
+				__m128 vDY = _mm_sub_ps(vY, _mm_set1_ps(PPP.vCamPos.y));
+				__m128 vDist = _mm_max_ps(_mm_max_ps(vDX, _mm_sub_ps(vZero, vDX)), _mm_max_ps(vDY, _mm_sub_ps(vZero, vDY)));
+				__m128 vFog = Clamp01PS(_mm_mul_ps(_mm_sub_ps(vDist, _mm_set1_ps(fFogStart)), _mm_set1_ps(fInvFogRange)));
+				vAlpha = _mm_mul_ps(vAlpha, _mm_sub_ps(vOne, vFog));
+			}
+
+			if(bSpaceLoop)
+			{ // fade near the borders of the loop box
+				__m128 vDX = _mm_sub_ps(_mm_set1_ps(vLoopCenter.x), vX);
+				__m128 vDY = _mm_sub_ps(_mm_set1_ps(vLoopCenter.y), vY);
+				__m128 vDZ = _mm_sub_ps(_mm_set1_ps(vLoopCenter.z), vZ);
+				__m128 vBX = _mm_sub_ps(_mm_set1_ps(vLoopBox.x), _mm_max_ps(vDX, _mm_sub_ps(vZero, vDX)));
+				__m128 vBY = _mm_sub_ps(_mm_set1_ps(vLoopBox.y), _mm_max_ps(vDY, _mm_sub_ps(vZero, vDY)));
+				__m128 vBZ = _mm_sub_ps(_mm_set1_ps(vLoopBox.z), _mm_max_ps(vDZ, _mm_sub_ps(vZero, vDZ)));
+				__m128 vBorder = _mm_min_ps(_mm_min_ps(vBX, vBY), vBZ);
+				vAlpha = _mm_mul_ps(vAlpha, Clamp01PS(_mm_mul_ps(vBorder, _mm_set1_ps(0.5f))));
+			}
+
+			arrRes[15] = _mm_mul_ps(vAlpha, _mm_set1_ps(255.f));
+			arrRes[16] = vT;
+
+			for(int l=0; l<4; l++)
+			{
+				if(nHidden & (1<<l))
+					continue;
+
+				UCol ucResCol;
+				ucResCol.bcolor[0] = fastftol_positive(pRes[12*4+l]);
+				ucResCol.bcolor[1] = fastftol_positive(pRes[13*4+l]);
+				ucResCol.bcolor[2] = fastftol_positive(pRes[14*4+l]);
+				ucResCol.bcolor[3] = fastftol_positive(pRes[15*4+l]);
+
+				SColorVert * pQuad = &pVerts[nQuads*4];
+				for(int c=0; c<4; c++)
+				{
+					pQuad[c].vert.x = pRes[(c*3+0)*4+l];
+					pQuad[c].vert.y = pRes[(c*3+1)*4+l];
+					pQuad[c].vert.z = pRes[(c*3+2)*4+l];
+					pQuad[c].color = ucResCol;
+				}
+
+				if(bAnimated)
+					m_lstFrames[nQuads] = ((int)(pRes[16*4+l]*fFrames)) % Params.pAnimTex->nFramesCount;
+				nQuads++;
+			}
+		}
+	}
+#endif
+
+	for(; i<m_nCount; i++)
+	{
+		Vec3 vPos(pPosX[i],pPosY[i],pPosZ[i]);
+		float fSize = pSize[i];
+
+		if(bSkipDead && m_pDead[i])
+			continue;
+		if(bNoDrawUnderWater && vPos.z < emitter.m_fWaterLevel)
+			continue;
+		if(!bAllIn && !PPP.pCamera->IsSphereVisibleFast( Sphere(vPos,fSize) ))
+			continue;
+
+		Vec3 vR, vU;
+		if(m_bRotated)
+		{
+			vR = (vRight*m_lstCos[i] + vRightRot*m_lstSin[i])*fSize;
+			vU = (vUp*m_lstCos[i] + vUpRot*m_lstSin[i])*fSize;
+		}
+		else
+		{
+			vR = vRight*fSize;
+			vU = vUp*fSize;
+		}
+
+		float fAge = fCurTime - pSpawnTime[i];
+		float fLifeTime = pLifeTime[i];
+		float t = 0;
+		float fAlpha = 1.f;
+		if(fLifeTime)
+		{
+			t = Clamp01(fAge/fLifeTime);
+			fAlpha = 1.f - (fAge - fFadeIn)/(fLifeTime - fFadeIn);
+		}
+		if(fAge < fFadeIn && fCurTime)
+			fAlpha *= fAge*fInvFadeIn;
+		fAlpha = Clamp01(fAlpha*1.5f);
+
+		Vec3 vResColor = (vColorStart + vColorDelta*t)*(bColorAlpha ? fColorScale*fAlpha : fColorScale);
+
+		if(bFog)
+			fAlpha *= 1.f - Clamp01((L1Distance2D(vPos, PPP.vCamPos)-fFogStart)*fInvFogRange);
+
+		if(bSpaceLoop)
+		{
+			float fDistFromCenterX = vLoopBox.x - fabs(vLoopCenter.x-vPos.x);
+			float fDistFromCenterY = vLoopBox.y - fabs(vLoopCenter.y-vPos.y);
+			float fDistFromCenterZ = vLoopBox.z - fabs(vLoopCenter.z-vPos.z);
+			fAlpha *= Clamp01(min(min(fDistFromCenterX,fDistFromCenterY),fDistFromCenterZ)*0.5f);
+		}
+
+		UCol ucResCol;
+		ucResCol.bcolor[0] = fastftol_positive(vResColor.x);
+		ucResCol.bcolor[1] = fastftol_positive(vResColor.y);
+		ucResCol.bcolor[2] = fastftol_positive(vResColor.z);
+		ucResCol.bcolor[3] = fastftol_positive(255.f*fAlpha);
+
+		SColorVert * pQuad = &pVerts[nQuads*4];
+		pQuad[0].vert = (-vR-vU) + vPos;
+		pQuad[1].vert = ( vR-vU) + vPos;
+		pQuad[2].vert = ( vR+vU) + vPos;
+		pQuad[3].vert = (-vR+vU) + vPos;
+		for(int c=0; c<4; c++)
+			pQuad[c].color = ucResCol;
+
+		if(bAnimated)
+			m_lstFrames[nQuads] = ((int)(t*fFrames)) % Params.pAnimTex->nFramesCount;
+		nQuads++;
+	}
+
+	if(!nQuads)
+		return;
+
+	// texture coordinates, same for all quads
+	for(int q=0; q<nQuads; q++)
+	{
+		SColorVert * pQuad = &pVerts[q*4];
+		pQuad[0].dTC[0] = 1; pQuad[0].dTC[1] = 0;
+		pQuad[1].dTC[0] = 1; pQuad[1].dTC[1] = 1;
+		pQuad[2].dTC[0] = 0; pQuad[2].dTC[1] = 1;
+		pQuad[3].dTC[0] = 0; pQuad[3].dTC[1] = 0;
+	}
+
+	list2<struct ShadowMapLightSourceInstance> * pShadowsList = NULL;
+	IEntityRender * pSpawnerEntity = emitter.m_pSpawnerEntity;
+	if(PPP.pObjManager->GetCVars()->e_particles_receive_shadows &&
+		pSpawnerEntity && pSpawnerEntity->GetEntityRS() && pSpawnerEntity->GetEntityRS()->pShadowMapInfo)
+		pShadowsList = pSpawnerEntity->GetEntityRS()->pShadowMapInfo->pShadowMapCasters;
+
+	if(!bAnimated)
+	{
+		PPP.pObjManager->AddSpritesToRenderer( (int)Params.nTexId, pShader, nDynLightMask, Params.eBlendType, vAmbientColor,
+			pVerts, nQuads, (float)nSortId, dwCCObjFlags, pShadowsList );
+		return;
+	}
+
+	// group the quads by texture frame (counting sort)
+	AnimTexInfo * pAnimTexInfo = Params.pAnimTex;
+	int nFramesCount = pAnimTexInfo->nFramesCount;
+	m_lstFrameStart.PreAllocate(nFramesCount+1, nFramesCount+1);
+	memset(m_lstFrameStart.GetElements(), 0, sizeof(int)*(nFramesCount+1));
+	for(int q=0; q<nQuads; q++)
+		m_lstFrameStart[m_lstFrames[q]+1]++;
+	for(int f=0; f<nFramesCount; f++)
+		m_lstFrameStart[f+1] += m_lstFrameStart[f];
+
+	m_lstSortedVerts.PreAllocate(nQuads*4, nQuads*4);
+	SColorVert * pSorted = m_lstSortedVerts.GetElements();
+	for(int q=0; q<nQuads; q++)
+		memcpy(&pSorted[(m_lstFrameStart[m_lstFrames[q]]++)*4], &pVerts[q*4], sizeof(SColorVert)*4);
+
+	// m_lstFrameStart[f] is the end of frame f now
+	int nFirst = 0;
+	for(int f=0; f<nFramesCount; f++)
+	{
+		int nEnd = m_lstFrameStart[f];
+		if(nEnd > nFirst)
+			PPP.pObjManager->AddSpritesToRenderer( pAnimTexInfo->pBindIds[f], pShader, nDynLightMask, Params.eBlendType, vAmbientColor,
+				&pSorted[nFirst*4], nEnd-nFirst, (float)nSortId, dwCCObjFlags, pShadowsList );
+		nFirst = nEnd;
+	}
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  Crytek Engine Source File.
+//  Copyright (C), Crytek Studios, 2002.
+// -------------------------------------------------------------------------
+//  File name:   ParticleSoA.h
+//  Version:     v1.00
+//  Compilers:   Visual Studio.NET
+//  Description: structure of arrays particle container of one emitter
+// -------------------------------------------------------------------------
+//  History:
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef __particlesoa_h__
+#define __particlesoa_h__
+
+// SSE kernels, on x86 it's also checked at runtime (CPUF_SSE)
+#if defined(_CPU_AMD64) || (defined(_CPU_X86) && !defined(__GNUC__)) || defined(__SSE__)
+#define PARTICLES_SSE
+#endif
+
+class CParticle;
+class CParticleEmitter;
+struct PartProcessParams;
+
+// Particles of one emitter kept as separate float streams.
+// Only used for plain billboards (no physics, objects, tails, line particles or children),
+// which covers weather (space loop) and most explosion sprites. Such particles only depend on
+// the emitter params, so the flags are tested once per emitter and the streams are processed
+// 4 particles at a time. Everything else stays on the CSprite path.
+class CParticleSoA : public Cry3DEngineBase
+{
+public:
+	CParticleSoA();
+	~CParticleSoA();
+
+	//! True if particles of these params can be simulated here.
+	static bool IsSupported( const ParticleParams &Params );
+
+	int  Count() const { return m_nCount; }
+	void Clear() { m_nCount = 0; m_bRotated = false; }
+
+	//! Copies the state of a freshly spawned particle.
+	void Add( const CParticle &part );
+
+	//! Moves the particles and marks the dead ones, they are removed by RemoveDead.
+	void Update( CParticleEmitter &emitter,const PartProcessParams &PPP );
+	//! Builds billboards of the visible particles and passes them to the renderer.
+	void Render( CParticleEmitter &emitter,const PartProcessParams &PPP,IShader *pShader,int nRecursionLevel );
+	void RemoveDead();
+
+	int GetMemoryUsage() const;
+
+private:
+	enum EStream
+	{
+		S_POS_X, S_POS_Y, S_POS_Z,
+		S_DIR_X, S_DIR_Y, S_DIR_Z,
+		S_SIZE, S_SIZE_ORIG,
+		S_SPAWN_TIME, S_LIFE_TIME,
+		S_ANGLE, S_ROT_SPEED, S_SCALE,
+		S_COUNT
+	};
+
+	float * Stream( int nStream ) const { return m_pStreams + nStream*m_nAlloc; }
+	void Reserve( int nCount );
+
+	// update steps, the SSE versions do blocks of 4 and leave the rest to the scalar code
+	void Move( const ParticleParams &Params,const CParticleEmitter &emitter,const PartProcessParams &PPP );
+	void CollideWithTerrain( const ParticleParams &Params,const PartProcessParams &PPP );
+	void KillAndBound( const ParticleParams &Params,const CParticleEmitter &emitter,const PartProcessParams &PPP );
+	void KillIndoor();
+
+	// m_nAlloc floats per stream, multiple of 4; streams are 16 byte aligned inside of m_pData
+	float * m_pData;
+	float * m_pStreams;
+	unsigned char * m_pDead;
+	int m_nCount;
+	int m_nAlloc;
+	bool m_bUseSSE;
+	bool m_bRotated;								//!< Some particle has an angle, billboards need sin/cos.
+
+	unsigned int m_cAmbientColor;		//!< Ambient at the emitter position of the last spawn.
+	Vec3 m_vBoxMin, m_vBoxMax;			//!< Bounds of all particles (+size) after the last update.
+
+	// render scratch, reused by all emitters
+	static list2<SColorVert> m_lstVerts;				//!< 4 per visible particle
+	static list2<SColorVert> m_lstSortedVerts;	//!< m_lstVerts ordered by texture frame
+	static list2<int> m_lstFrames;							//!< texture frame per visible particle
+	static list2<int> m_lstFrameStart;
+	static list2<float> m_lstSin, m_lstCos;
+};
+
+#endif // __particlesoa_h__
@@ -20,6 +20,7 @@
 #include "visareas.h"
 //#include "ParticleEffect.h"
 #include "3dEngine.h"
+#include "ParticleSoA.h"
 
 CSpriteManager::CSpriteManager( CPartManager *pPartManager )
 {
@@ -27,6 +28,7 @@ CSpriteManager::CSpriteManager( CPartManager *pPartManager )
 	m_arrSprites = new CSprite[m_nMaxSpritesCount];
 
 	m_nCurSpritesCount=0;
+	m_nSoASpritesCount=0;
 	memset(m_arrSprites,0,sizeof(CSprite)*m_nMaxSpritesCount);
 
 	m_pSystem = GetSystem();
@@ -38,6 +40,7 @@ CSpriteManager::CSpriteManager( CPartManager *pPartManager )
 
 CSpriteManager::~CSpriteManager()
 {
+	ClearSoA();
 	delete [] m_arrSprites;
 }
 
@@ -102,10 +105,16 @@ void CSpriteManager::Spawn( CParticleEmitter &emitter,bool bChildProcess )
 	float fCurrTime = m_pPartManager->GetParticlesTime();
 	int nCount = max(1,int(Params.nCount*GetCVars()->e_particles_lod));
 
+	if(!bChildProcess && GetCVars()->e_particles_soa && CParticleSoA::IsSupported(Params))
+	{
+		SpawnSoA( emitter,fCurrTime,nCount );
+		return;
+	}
+
 	// pass Params structure to CPartSpray::Spawn() nCount times
 	for(int i=0; i < nCount; i++)
 	{
-		if(m_nCurSpritesCount>=m_nMaxSpritesCount)
+		if(m_nCurSpritesCount+m_nSoASpritesCount>=m_nMaxSpritesCount)
 			break;
 
 		CSprite * pSprite = &m_arrSprites[m_nCurSpritesCount];
@@ -309,6 +318,80 @@ void CSpriteManager::SpawnParticle( CParticleEmitter &emitter,bool bChildProcess
 	pPart->m_pSpawnerEntity = emitter.m_pSpawnerEntity;
 }
 
+//////////////////////////////////////////////////////////////////////////
+void CSpriteManager::SpawnSoA( CParticleEmitter &emitter,float fCurrTime,int nCount )
+{
+	if(!emitter.m_pSoA)
+		emitter.m_pSoA = new CParticleSoA;
+
+	if(!emitter.m_pSoA->Count())
+		m_lstSoAEmitters.push_back(&emitter);
+
+	// spawn with the common code, only the state is kept
+	CParticle part;
+	for(int i=0; i < nCount; i++)
+	{
+		if(m_nCurSpritesCount+m_nSoASpritesCount>=m_nMaxSpritesCount)
+			break;
+
+		SpawnParticle( emitter,false,fCurrTime,&part );
+		emitter.m_pSoA->Add( part );
+		part.DeActivateParticle(GetPhysicalWorld());
+		m_nSoASpritesCount++;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CSpriteManager::RenderSoA( const PartProcessParams &PPP,int nRecursionLevel,IShader * pPartLightShader )
+{
+	FUNCTION_PROFILER_FAST( GetSystem(),PROFILE_3DENGINE,m_bProfilerEnabled );
+
+	m_nSoASpritesCount = 0;
+
+	for(int i=0; i<(int)m_lstSoAEmitters.size(); i++)
+	{
+		CParticleEmitter * pEmitter = m_lstSoAEmitters[i];
+		CParticleSoA * pSoA = pEmitter->m_pSoA;
+
+		if(!nRecursionLevel)
+			pSoA->Update( *pEmitter,PPP );
+
+		pSoA->Render( *pEmitter,PPP,pPartLightShader,nRecursionLevel );
+
+		if(!nRecursionLevel)
+			pSoA->RemoveDead();
+
+		if(!pSoA->Count())
+		{ // remove
+			if(i < (int)m_lstSoAEmitters.size()-1)
+				m_lstSoAEmitters[i] = m_lstSoAEmitters.back();
+			m_lstSoAEmitters.pop_back();
+			i--;
+			continue;
+		}
+
+		m_nSoASpritesCount += pSoA->Count();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CSpriteManager::ClearSoA()
+{
+	for(int i=0; i<(int)m_lstSoAEmitters.size(); i++)
+		m_lstSoAEmitters[i]->m_pSoA->Clear();
+	m_lstSoAEmitters.clear();
+	m_nSoASpritesCount = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CSpriteManager::GetSoAMemoryUsage(ICrySizer* pSizer) const
+{
+	int nSize = m_lstSoAEmitters.capacity()*sizeof(m_lstSoAEmitters[0]);
+	for(int i=0; i<(int)m_lstSoAEmitters.size(); i++)
+		nSize += m_lstSoAEmitters[i]->m_pSoA->GetMemoryUsage();
+	pSizer->AddObject(&m_lstSoAEmitters, nSize);
+}
+
 //////////////////////////////////////////////////////////////////////////
 void CSpriteManager::Render(CObjManager * pObjManager, CTerrain * pTerrain, int nRecursionLevel, CPartManager * pPartManager, IShader * pPartLightShader)
 {
@@ -407,4 +490,6 @@ void CSpriteManager::Render(CObjManager * pObjManager, CTerrain * pTerrain, int
 			i--;
 		}
 	}
+
+	RenderSoA( ProcParams,nRecursionLevel,pPartLightShader );
 }
\ No newline at end of file
@@ -142,6 +142,7 @@ void CStatObj::StreamCCGF(bool bFinishNow)
 	params.nLoadTime = 10000;
 	params.nMaxLoadTime = 10000;
 	params.nFlags |= SRP_FLAGS_ASYNC_PROGRESS;
+	params.nPriorityClass = SRPC_HIGH;
 
 	m_eCCGFStreamingStatus = ecss_LoadingInProgress;
 	m_pReadStream = m_pSys->GetStreamEngine()->StartRead("3DEngine", szCompiledFileName, this, &params);
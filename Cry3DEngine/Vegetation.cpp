@@ -72,8 +72,6 @@ bool CStatObjInst::DrawEntity(const struct SRendParams & _EntDrawParams)
 
   const Vec3d & vCamPos = GetViewCamera().GetPos();
 
-  float fDistance = m_arrfDistance[m_pObjManager->m_nRenderStackLevel];
-
 /*
   // calculate distance
   float fPrevDist0 = m_fDistance0;
@@ -140,6 +138,14 @@ bool CStatObjInst::DrawEntity(const struct SRendParams & _EntDrawParams)
   if(near_far_dist < GetCVars()->e_vegetation_sprites_min_distance)
     near_far_dist = GetCVars()->e_vegetation_sprites_min_distance;
 
+  return DrawInstance(_EntDrawParams, pBody, near_far_dist, nDynMask, -1);
+}
+
+bool CStatObjInst::DrawInstance(const SRendParams & _EntDrawParams, CStatObj * pBody, float near_far_dist, int nDynMask, int nLod)
+{
+  const Vec3d & vCamPos = GetViewCamera().GetPos();
+  float fDistance = m_arrfDistance[m_pObjManager->m_nRenderStackLevel];
+
 //  m_nStatObjNumPerFrame++;
 
   // fade out bending amount
@@ -344,7 +350,8 @@ bool CStatObjInst::DrawEntity(const struct SRendParams & _EntDrawParams)
 		rParms.dwFObjFlags |= (_EntDrawParams.dwFObjFlags & ~FOB_TRANS_MASK);
 
     // calculate lod and render the object
-		int nLod = max(0,(int)(fDistance*GetLodRatioNormilized()/(GetCVars()->e_obj_lod_ratio*GetRenderRadius())));
+		if(nLod<0)
+			nLod = max(0,(int)(fDistance*GetLodRatioNormilized()/(GetCVars()->e_obj_lod_ratio*GetRenderRadius())));
     pBody->Render( rParms, Vec3(zero), nLod );//int(fDistance/near_far_dist*pBody->m_nLoadedLodsNum*pBody->m_nLoadedLodsNum) );
 
     /*{ // speed test, render tree directly without shader pipeline - no speed difference
@@ -55,6 +55,9 @@ public:
   void GetRenderBBox(Vec3d &,Vec3d &);
   float GetRenderRadius(void) const;
   bool DrawEntity(const SRendParams & rendParams);
+  //! Second half of DrawEntity, the caller has computed the switch to sprite distance, the
+  //! light mask without the sun and the lod (-1: from the distance), m_arrfDistance is set.
+  bool DrawInstance(const SRendParams & rendParams, CStatObj * pBody, float fSpriteDist, int nDynMask, int nLod);
   bool IsStatic(void) const { return true; }
   bool IsEntityHasSomethingToRender(void) { return true; }
   bool IsEntityAreasVisible(void) { return true; }
@@ -0,0 +1,512 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  Crytek Engine Source File.
+//  Copyright (C), Crytek Studios, 2002.
+// -------------------------------------------------------------------------
+//  File name:   VegetationSoA.cpp
+//  Version:     v1.00
+//  Compilers:   Visual Studio.NET
+//  Description: distance, frustum and lod classification of vegetation streams
+// -------------------------------------------------------------------------
+//  History:
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+
+#include "StatObj.h"
+#include "objman.h"
+#include "VegetationSoA.h"
+
+#ifdef VEGETATION_SSE
+#include <xmmintrin.h>
+#endif
+
+list2<SVegetationVisible> CVegetationSoA::m_lstCulled;
+list2<int> CVegetationSoA::m_lstKeys;
+int CVegetationSoA::m_arrKeyStart[256*2+1];
+int CVegetationSoA::m_nGroupsChanged = 0;
+
+//////////////////////////////////////////////////////////////////////////
+CVegetationSoA::CVegetationSoA()
+{
+	m_pData = 0;
+	m_pStreams = 0;
+	m_ppInst = 0;
+	m_pType = 0;
+	m_pFlags = 0;
+	m_nCount = 0;
+	m_nAlloc = 0;
+	m_nGroupsVersion = m_nGroupsChanged;
+
+#if defined(VEGETATION_SSE) && defined(_CPU_X86)
+	m_bUseSSE = (Cry3DEngineBase::m_CpuFlags & CPUF_SSE) != 0;
+#elif defined(VEGETATION_SSE)
+	m_bUseSSE = true;
+#else
+	m_bUseSSE = false;
+#endif
+}
+
+CVegetationSoA::~CVegetationSoA()
+{
+	delete [] m_pData;
+	delete [] m_ppInst;
+	delete [] m_pType;
+	delete [] m_pFlags;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::Reserve( int nCount )
+{
+	if(nCount <= m_nAlloc)
+		return;
+
+	int nAlloc = max(16, m_nAlloc*2);
+	while(nAlloc < nCount)
+		nAlloc *= 2;
+
+	float * pData = new float[nAlloc*S_COUNT+4];
+	float * pStreams = (float*)(((UINT_PTR)pData + 15) & ~(UINT_PTR)15);
+	CStatObjInst ** ppInst = new CStatObjInst*[nAlloc];
+	unsigned char * pType = new unsigned char[nAlloc];
+	unsigned char * pFlags = new unsigned char[nAlloc];
+	memset(pStreams, 0, sizeof(float)*nAlloc*S_COUNT);
+
+	if(m_nCount)
+	{
+		for(int s=0; s<S_COUNT; s++)
+			memcpy(pStreams + s*nAlloc, Stream(s), sizeof(float)*m_nCount);
+		memcpy(ppInst, m_ppInst, sizeof(CStatObjInst*)*m_nCount);
+		memcpy(pType, m_pType, m_nCount);
+		memcpy(pFlags, m_pFlags, m_nCount);
+	}
+
+	delete [] m_pData;
+	delete [] m_ppInst;
+	delete [] m_pType;
+	delete [] m_pFlags;
+	m_pData = pData;
+	m_pStreams = pStreams;
+	m_ppInst = ppInst;
+	m_pType = pType;
+	m_pFlags = pFlags;
+	m_nAlloc = nAlloc;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::AddInstance( CStatObjInst * pInst, int nType, int nFlags, const Vec3 &vBoxMin, const Vec3 &vBoxMax,
+																 float fMaxViewDist, float fSpriteDist, float fSpriteZ, float fLodScale )
+{
+	Reserve(m_nCount+1);
+
+	int i = m_nCount++;
+	Stream(S_CENTER_X)[i] = (vBoxMin.x+vBoxMax.x)*0.5f;
+	Stream(S_CENTER_Y)[i] = (vBoxMin.y+vBoxMax.y)*0.5f;
+	Stream(S_MIN_X)[i] = vBoxMin.x;
+	Stream(S_MIN_Y)[i] = vBoxMin.y;
+	Stream(S_MIN_Z)[i] = vBoxMin.z;
+	Stream(S_MAX_X)[i] = vBoxMax.x;
+	Stream(S_MAX_Y)[i] = vBoxMax.y;
+	Stream(S_MAX_Z)[i] = vBoxMax.z;
+	Stream(S_MAX_DIST)[i] = fMaxViewDist;
+	Stream(S_MAX_DIST_SQ)[i] = fMaxViewDist*fMaxViewDist;
+	Stream(S_SPRITE_DIST)[i] = fSpriteDist;
+	Stream(S_SPRITE_Z)[i] = fSpriteZ;
+	Stream(S_LOD_SCALE)[i] = fLodScale;
+	m_ppInst[i] = pInst;
+	m_pType[i] = (unsigned char)nType;
+	m_pFlags[i] = (unsigned char)nFlags;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CVegetationSoA::GetGroupValues( CStatObjInst * pInst, int & nFlags, float & fSpriteDist, float & fSpriteZ, float & fLodScale )
+{
+	StatInstGroup & Group = CStatObjInst::m_pObjManager->m_lstStaticTypes[pInst->m_nObjectTypeID];
+	CStatObj * pBody = Group.GetStatObj();
+	if(!pBody)
+		return false; // not drawn by DrawEntity either
+
+	// parts of near_far_dist and of the lod of CStatObjInst::DrawEntity which do not depend on the camera
+	const float fScale = pInst->m_fScale;
+	fSpriteDist = (18.f * pBody->GetRadiusVert() * fScale) * max(0.5f, Group.fSpriteDistRatio);
+	fSpriteZ = pInst->m_vPos.z + pBody->GetCenter().z*fScale;
+	float fRadius = pBody->GetRadius()*fScale;
+	fLodScale = fRadius>0 ? pInst->GetLodRatioNormilized()/fRadius : 0;
+	nFlags = Group.bUseSprites ? VF_SPRITES : 0;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::Add( CStatObjInst * pInst )
+{
+	int nFlags;
+	float fSpriteDist, fSpriteZ, fLodScale;
+	if(!GetGroupValues(pInst, nFlags, fSpriteDist, fSpriteZ, fLodScale))
+		return;
+
+	AddInstance(pInst, pInst->m_nObjectTypeID, nFlags,
+		pInst->m_vWSBoxMin, pInst->m_vWSBoxMax, pInst->m_fWSMaxViewDist, fSpriteDist, fSpriteZ, fLodScale);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::UpdateGroupValues()
+{
+	// the editor changes the groups of a loaded level; the max view distance and so the order
+	// are taken from the instances like before, they are refreshed by SortStaticInstancesBySize
+	for(int i=0; i<m_nCount; i++)
+	{
+		int nFlags;
+		float fSpriteDist, fSpriteZ, fLodScale;
+		if(!m_ppInst[i] || !GetGroupValues(m_ppInst[i], nFlags, fSpriteDist, fSpriteZ, fLodScale))
+			continue; // no object, the instance is skipped by RenderVegetationSoA
+
+		Stream(S_SPRITE_DIST)[i] = fSpriteDist;
+		Stream(S_SPRITE_Z)[i] = fSpriteZ;
+		Stream(S_LOD_SCALE)[i] = fLodScale;
+		m_pFlags[i] = (unsigned char)nFlags;
+	}
+
+	m_nGroupsVersion = m_nGroupsChanged;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CVegetationSoA::Remove( IEntityRender * pEntityRender )
+{
+	for(int i=0; i<m_nCount; i++)
+	if(m_ppInst[i] == pEntityRender)
+	{
+		int nMove = m_nCount-i-1;
+		for(int s=0; s<S_COUNT; s++)
+			memmove(Stream(s)+i, Stream(s)+i+1, sizeof(float)*nMove);
+		memmove(m_ppInst+i, m_ppInst+i+1, sizeof(CStatObjInst*)*nMove);
+		memmove(m_pType+i, m_pType+i+1, nMove);
+		memmove(m_pFlags+i, m_pFlags+i+1, nMove);
+		m_nCount--;
+		return true;
+	}
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::AddCulled( int i, float fDistance, float fSpriteDist, bool bSprite, float fInvLodRatio )
+{
+	bSprite = bSprite && (m_pFlags[i] & VF_SPRITES);
+
+	SVegetationVisible vis;
+	vis.pInst = m_ppInst[i];
+	vis.fDistance = fDistance;
+	vis.fSpriteDist = fSpriteDist;
+	// bSprite only groups the instances, DrawInstance makes its own choice (the light mask of
+	// the instance can force the 3d object), so the lod is needed for the sprites too
+	vis.nLod = max(0,(int)(fDistance*Stream(S_LOD_SCALE)[i]*fInvLodRatio));
+
+	m_lstCulled.Add(vis);
+	m_lstKeys.Add(m_pType[i]*2 + (bSprite ? 1 : 0));
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::CullRange( const CCamera & cam, bool bTestFrustum, bool bSprites, int nEnd )
+{
+	const Vec3 vCamPos = cam.GetPos();
+	const float fSpriteRatio = GetCVars()->e_vegetation_sprites_distance_ratio;
+	const float fSpriteMinDist = GetCVars()->e_vegetation_sprites_min_distance;
+	const float fInvLodRatio = 1.f/GetCVars()->e_obj_lod_ratio;
+
+	const float * pCenterX = Stream(S_CENTER_X);
+	const float * pCenterY = Stream(S_CENTER_Y);
+	const float * pMaxDistSQ = Stream(S_MAX_DIST_SQ);
+	const float * pSpriteDist = Stream(S_SPRITE_DIST);
+	const float * pSpriteZ = Stream(S_SPRITE_Z);
+
+	// box corner which is most inside of each plane, same choice as CCamera::IsAABBVisibleFast
+	const float * arrCorner[FRUSTUM_PLANES][3];
+	if(bTestFrustum)
+	for(int p=0; p<FRUSTUM_PLANES; p++)
+	{
+		const Plane * pPlane = cam.GetFrustumPlane(p);
+		arrCorner[p][0] = Stream(pPlane->n.x>=0 ? S_MIN_X : S_MAX_X);
+		arrCorner[p][1] = Stream(pPlane->n.y>=0 ? S_MIN_Y : S_MAX_Y);
+		arrCorner[p][2] = Stream(pPlane->n.z>=0 ? S_MIN_Z : S_MAX_Z);
+	}
+
+	int i = 0;
+
+#ifdef VEGETATION_SSE
+	if(m_bUseSSE)
+	{
+		const __m128 vCamX = _mm_set1_ps(vCamPos.x), vCamY = _mm_set1_ps(vCamPos.y), vCamZ = _mm_set1_ps(vCamPos.z);
+		const __m128 vSignMask = _mm_set1_ps(-0.f);
+		const __m128 vHeightRatio = _mm_set1_ps(0.2f);
+		const __m128 vSpriteRatio = _mm_set1_ps(fSpriteRatio);
+		const __m128 vSpriteMinDist = _mm_set1_ps(fSpriteMinDist);
+
+		__m128 arrPlaneN[FRUSTUM_PLANES][3], arrPlaneD[FRUSTUM_PLANES];
+		if(bTestFrustum)
+		for(int p=0; p<FRUSTUM_PLANES; p++)
+		{
+			const Plane * pPlane = cam.GetFrustumPlane(p);
+			arrPlaneN[p][0] = _mm_set1_ps(pPlane->n.x);
+			arrPlaneN[p][1] = _mm_set1_ps(pPlane->n.y);
+			arrPlaneN[p][2] = _mm_set1_ps(pPlane->n.z);
+			arrPlaneD[p] = _mm_set1_ps(-pPlane->d);
+		}
+
+		// distances, then switch to sprite distances
+		__m128 arrRes[2];
+		const float * pRes = (const float*)arrRes;
+
+		for(; i+4<=nEnd; i+=4)
+		{
+			// max view distance, 2d because of the sprites
+			__m128 vDX = _mm_sub_ps(vCamX, _mm_load_ps(pCenterX+i));
+			__m128 vDY = _mm_sub_ps(vCamY, _mm_load_ps(pCenterY+i));
+			__m128 vDistSQ = _mm_add_ps(_mm_mul_ps(vDX,vDX), _mm_mul_ps(vDY,vDY));
+			__m128 vVisible = _mm_cmple_ps(vDistSQ, _mm_load_ps(pMaxDistSQ+i));
+			if(!_mm_movemask_ps(vVisible))
+				continue;
+
+			if(bTestFrustum)
+			for(int p=0; p<FRUSTUM_PLANES; p++)
+			{
+				__m128 vD = _mm_add_ps(arrPlaneD[p], _mm_mul_ps(arrPlaneN[p][0], _mm_load_ps(arrCorner[p][0]+i)));
+				vD = _mm_add_ps(vD, _mm_mul_ps(arrPlaneN[p][1], _mm_load_ps(arrCorner[p][1]+i)));
+				vD = _mm_add_ps(vD, _mm_mul_ps(arrPlaneN[p][2], _mm_load_ps(arrCorner[p][2]+i)));
+				vVisible = _mm_andnot_ps(_mm_cmpgt_ps(vD, _mm_setzero_ps()), vVisible);
+			}
+
+			int nVisible = _mm_movemask_ps(vVisible);
+			if(!nVisible)
+				continue;
+
+			__m128 vDist = _mm_sqrt_ps(vDistSQ);
+			__m128 vDZ = _mm_andnot_ps(vSignMask, _mm_sub_ps(_mm_load_ps(pSpriteZ+i), vCamZ));
+			__m128 vSprite = _mm_mul_ps(_mm_add_ps(_mm_load_ps(pSpriteDist+i), _mm_mul_ps(vHeightRatio, vDZ)), vSpriteRatio);
+			vSprite = _mm_max_ps(vSprite, vSpriteMinDist);
+			int nFar = bSprites ? _mm_movemask_ps(_mm_cmpgt_ps(vDist, vSprite)) : 0;
+
+			arrRes[0] = vDist;
+			arrRes[1] = vSprite;
+			for(int l=0; l<4; l++)
+				if(nVisible & (1<<l))
+					AddCulled(i+l, pRes[l], pRes[4+l], (nFar & (1<<l)) != 0, fInvLodRatio);
+		}
+	}
+#endif
+
+	for(; i<nEnd; i++)
+	{
+		const float dx = vCamPos.x-pCenterX[i];
+		const float dy = vCamPos.y-pCenterY[i];
+		const float fDistSQ = dx*dx+dy*dy;
+		if(fDistSQ > pMaxDistSQ[i])
+			continue;
+
+		if(bTestFrustum)
+		{
+			int p=0;
+			for(; p<FRUSTUM_PLANES; p++)
+			{
+				const Plane * pPlane = cam.GetFrustumPlane(p);
+				float d = -pPlane->d + pPlane->n.x*arrCorner[p][0][i];
+				d += pPlane->n.y*arrCorner[p][1][i];
+				d += pPlane->n.z*arrCorner[p][2][i];
+				if(d>0)
+					break;
+			}
+			if(p<FRUSTUM_PLANES)
+				continue;
+		}
+
+		float fDist = cry_sqrtf(fDistSQ);
+		float fSprite = (pSpriteDist[i] + 0.2f*fabsf(pSpriteZ[i] - vCamPos.z))*fSpriteRatio;
+		if(fSprite < fSpriteMinDist)
+			fSprite = fSpriteMinDist;
+
+		AddCulled(i, fDist, fSprite, bSprites && fDist > fSprite, fInvLodRatio);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CVegetationSoA::Cull( const CCamera & cam, bool bTestFrustum, float fSectorMinDist, bool bSprites, list2<SVegetationVisible> & lstVisible )
+{
+	FUNCTION_PROFILER_FAST( GetSystem(),PROFILE_3DENGINE,m_bProfilerEnabled );
+
+	// sorted by max view distance, find the first instance the sector is too far for
+	const float * pMaxDist = Stream(S_MAX_DIST);
+	int nFirst = 0, nEnd = m_nCount;
+	while(nFirst < nEnd)
+	{
+		int nMid = (nFirst+nEnd)>>1;
+		if(fSectorMinDist >= pMaxDist[nMid])
+			nEnd = nMid;
+		else
+			nFirst = nMid+1;
+	}
+
+	if(!nEnd)
+		return;
+
+	if(m_nGroupsVersion != m_nGroupsChanged)
+		UpdateGroupValues();
+
+	m_lstCulled.Clear();
+	m_lstKeys.Clear();
+	CullRange(cam, bTestFrustum, bSprites, nEnd);
+
+	int nCulled = m_lstCulled.Count();
+	if(!nCulled)
+		return;
+
+	// group by object type and lod class, counting sort keeps the size order inside of a group
+	memset(m_arrKeyStart, 0, sizeof(m_arrKeyStart));
+	for(int i=0; i<nCulled; i++)
+		m_arrKeyStart[m_lstKeys[i]+1]++;
+	for(int k=0; k<256*2; k++)
+		m_arrKeyStart[k+1] += m_arrKeyStart[k];
+
+	int nOffset = lstVisible.Count();
+	lstVisible.PreAllocate(nOffset+nCulled, nOffset+nCulled);
+	for(int i=0; i<nCulled; i++)
+		lstVisible[nOffset + m_arrKeyStart[m_lstKeys[i]]++] = m_lstCulled[i];
+}
+
+//////////////////////////////////////////////////////////////////////////
+int CVegetationSoA::GetMemoryUsage() const
+{
+	int nSize = sizeof(*this);
+	if(m_nAlloc)
+		nSize += (m_nAlloc*S_COUNT+4)*sizeof(float) + m_nAlloc*(sizeof(CStatObjInst*)+2);
+	return nSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int __cdecl CVegetationSoA__Cmp_FloatDesc(const void* v1, const void* v2)
+{
+	float f1 = *(const float*)v1;
+	float f2 = *(const float*)v2;
+
+	if(f1 > f2)
+		return -1;
+	else if(f1 < f2)
+		return 1;
+
+	return 0;
+}
+
+struct SVegetationBenchInst
+{
+	Vec3 vBoxMin, vBoxMax, vCenter;
+	float fMaxDistSQ;
+};
+
+void CVegetationSoA::RunBenchmark( int nInstances )
+{
+	if(nInstances<=0)
+		return;
+
+	// trees of 16 types on a 2 km map, biggest max view distance first like after SortStaticInstancesBySize
+	const float fMapSize = 2048.f;
+	srand(0);
+	list2<float> lstMaxDist;
+	lstMaxDist.PreAllocate(nInstances, nInstances);
+	for(int i=0; i<nInstances; i++)
+		lstMaxDist[i] = 40.f + rnd()*360.f;
+	qsort(lstMaxDist.GetElements(), nInstances, sizeof(float), CVegetationSoA__Cmp_FloatDesc);
+
+	// per instance reference, what the sector loop did with IEntityRenderInfo
+	list2<SVegetationBenchInst> lstInst;
+	lstInst.PreAllocate(nInstances, nInstances);
+
+	CVegetationSoA * pSoA = new CVegetationSoA();
+	for(int i=0; i<nInstances; i++)
+	{
+		float fRadius = 4.f*(0.7f + rnd()*0.6f);
+		Vec3 vPos(rnd()*fMapSize, rnd()*fMapSize, 20.f + rnd()*30.f);
+		Vec3 vBoxMin = vPos - Vec3(fRadius*0.5f, fRadius*0.5f, 0);
+		Vec3 vBoxMax = vPos + Vec3(fRadius*0.5f, fRadius*0.5f, fRadius*2.f);
+		pSoA->AddInstance(0, rand()%16, VF_SPRITES, vBoxMin, vBoxMax, lstMaxDist[i], 18.f*fRadius, vPos.z+fRadius, 1.f/fRadius);
+
+		lstInst[i].vBoxMin = vBoxMin;
+		lstInst[i].vBoxMax = vBoxMax;
+		lstInst[i].vCenter = (vBoxMin+vBoxMax)*0.5f;
+		lstInst[i].fMaxDistSQ = lstMaxDist[i]*lstMaxDist[i];
+	}
+
+	// camera in the middle of the map looking a bit down
+	CCamera cam;
+	cam.Init(800, 600);
+	cam.SetPos(Vec3(fMapSize*0.5f, fMapSize*0.5f, 60.f));
+	cam.SetAngle(Vec3(-10.f, 0, 45.f));
+	cam.Update();
+
+	const int nRuns = 8;
+	ITimer * pTimer = GetTimer();
+	list2<SVegetationVisible> lstVisible;
+	lstVisible.PreAllocate(nInstances);
+
+	int nRef = 0;
+	float fRefSum = 0;
+	float fStart = pTimer->GetAsyncCurTime();
+	for(int r=0; r<nRuns; r++)
+	{
+		nRef = 0;
+		for(int i=0; i<nInstances; i++)
+		{
+			const SVegetationBenchInst & inst = lstInst[i];
+			const float dx = cam.GetPos().x-inst.vCenter.x;
+			const float dy = cam.GetPos().y-inst.vCenter.y;
+			const float fDistSQ = dx*dx+dy*dy;
+			if(fDistSQ > inst.fMaxDistSQ)
+				continue;
+			if(!cam.IsAABBVisibleFast(AABB(inst.vBoxMin, inst.vBoxMax)))
+				continue;
+			fRefSum += cry_sqrtf(fDistSQ);
+			nRef++;
+		}
+	}
+	float fRef = pTimer->GetAsyncCurTime();
+
+	bool bSSE = pSoA->m_bUseSSE;
+	pSoA->m_bUseSSE = false;
+	for(int r=0; r<nRuns; r++)
+	{
+		lstVisible.Clear();
+		pSoA->Cull(cam, true, 0, true, lstVisible);
+	}
+	int nScalar = lstVisible.Count();
+	float fScalar = pTimer->GetAsyncCurTime();
+
+	int nSSE = 0;
+	if(bSSE)
+	{
+		pSoA->m_bUseSSE = true;
+		for(int r=0; r<nRuns; r++)
+		{
+			lstVisible.Clear();
+			pSoA->Cull(cam, true, 0, true, lstVisible);
+		}
+		nSSE = lstVisible.Count();
+	}
+	float fSSE = pTimer->GetAsyncCurTime();
+
+	int nSprites = 0;
+	for(int i=0; i<lstVisible.Count(); i++)
+		nSprites += lstVisible[i].fDistance > lstVisible[i].fSpriteDist;
+
+	float fRefMs = max((fRef-fStart)*1000.f/nRuns, 0.001f);
+	float fScalarMs = max((fScalar-fRef)*1000.f/nRuns, 0.001f);
+	float fSSEMs = max((fSSE-fScalar)*1000.f/nRuns, 0.001f);
+
+	GetLog()->Log("Vegetation cull benchmark: %d instances, %d visible (%d sprites, %.0f m on average), per instance code %d visible",
+		nInstances, nScalar, nSprites, nRef ? fRefSum/(nRuns*nRef) : 0.f, nRef);
+	GetLog()->Log("  per instance: %.3f ms, %.0f inst/ms; streams: %.3f ms, %.0f inst/ms",
+		fRefMs, nInstances/fRefMs, fScalarMs, nInstances/fScalarMs);
+	if(bSSE)
+		GetLog()->Log("  SSE: %.3f ms, %.0f inst/ms, %d visible", fSSEMs, nInstances/fSSEMs, nSSE);
+	else
+		GetLog()->Log("  SSE: not available");
+
+	delete pSoA;
+}
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////
+//
+//  Crytek Engine Source File.
+//  Copyright (C), Crytek Studios, 2002.
+// -------------------------------------------------------------------------
+//  File name:   VegetationSoA.h
+//  Version:     v1.00
+//  Compilers:   Visual Studio.NET
+//  Description: structure of arrays vegetation instances of one sector
+// -------------------------------------------------------------------------
+//  History:
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef __vegetationsoa_h__
+#define __vegetationsoa_h__
+
+// SSE kernels, on x86 it's also checked at runtime (CPUF_SSE)
+#if defined(_CPU_AMD64) || (defined(_CPU_X86) && !defined(__GNUC__)) || defined(__SSE__)
+#define VEGETATION_SSE
+#endif
+
+class CStatObjInst;
+
+//! Visible instance returned by CVegetationSoA::Cull.
+struct SVegetationVisible
+{
+	CStatObjInst * pInst;
+	float fDistance;			//!< 2d distance to the camera
+	float fSpriteDist;		//!< switch to sprite distance (near_far_dist of CStatObjInst::DrawEntity)
+	int nLod;							//!< lod of the 3d object
+};
+
+// Simple vegetation of one sector (no shadow casters, not in a fog volume) kept as separate streams.
+// The instances stay CStatObjInst objects for physics, decals and the editor, the streams only
+// replace the per instance view distance, frustum, sprite distance and lod math of the compiled
+// sector rendering. Filled by CBasicArea::SortStaticInstancesBySize in the same order as the
+// entity list (biggest max view distance first), so the sector distance test is one search.
+class CVegetationSoA : public Cry3DEngineBase
+{
+public:
+	CVegetationSoA();
+	~CVegetationSoA();
+
+	int  Count() const { return m_nCount; }
+	void Clear() { m_nCount = 0; m_nGroupsVersion = m_nGroupsChanged; }
+
+	//! Appends an instance, its world bbox and m_fWSMaxViewDist must be up to date.
+	void Add( CStatObjInst * pInst );
+	//! Removes an instance keeping the order, false if it's not in the store.
+	bool Remove( IEntityRender * pEntityRender );
+
+	//! Appends the visible instances to lstVisible grouped by object type, in a group the 3d
+	//! instances come before the sprites. Instances with max view distance up to fSectorMinDist
+	//! are skipped. bSprites 0 classifies everything as 3d (dynamic lights force 3d objects).
+	void Cull( const CCamera & cam, bool bTestFrustum, float fSectorMinDist, bool bSprites, list2<SVegetationVisible> & lstVisible );
+
+	int GetMemoryUsage() const;
+
+	//! Called by C3DEngine::SetStatInstGroup, the sprite and lod streams take the new group
+	//! parameters and object at the next Cull.
+	static void OnStatInstGroupChanged() { m_nGroupsChanged++; }
+
+	//! Culls nInstances random trees with the per instance code, the scalar and the SSE loop
+	//! and logs instances per millisecond. Needs no level and no renderer.
+	static void RunBenchmark( int nInstances );
+
+private:
+	enum EStream
+	{
+		S_CENTER_X, S_CENTER_Y,
+		S_MIN_X, S_MIN_Y, S_MIN_Z,
+		S_MAX_X, S_MAX_Y, S_MAX_Z,
+		S_MAX_DIST, S_MAX_DIST_SQ,
+		S_SPRITE_DIST, S_SPRITE_Z,
+		S_LOD_SCALE,
+		S_COUNT
+	};
+
+	enum
+	{
+		VF_SPRITES = 1			//!< type uses sprites
+	};
+
+	float * Stream( int nStream ) const { return m_pStreams + nStream*m_nAlloc; }
+	void Reserve( int nCount );
+	void AddInstance( CStatObjInst * pInst, int nType, int nFlags, const Vec3 &vBoxMin, const Vec3 &vBoxMax,
+		float fMaxViewDist, float fSpriteDist, float fSpriteZ, float fLodScale );
+	//! Values of the instance which depend on its group, false if the group has no object.
+	static bool GetGroupValues( CStatObjInst * pInst, int & nFlags, float & fSpriteDist, float & fSpriteZ, float & fLodScale );
+	void UpdateGroupValues();
+
+	// classification of [0,nEnd), the SSE version does blocks of 4 and leaves the rest to the scalar code
+	void CullRange( const CCamera & cam, bool bTestFrustum, bool bSprites, int nEnd );
+	void AddCulled( int i, float fDistance, float fSpriteDist, bool bSprite, float fInvLodRatio );
+
+	// m_nAlloc floats per stream, multiple of 4; streams are 16 byte aligned inside of m_pData
+	float * m_pData;
+	float * m_pStreams;
+	CStatObjInst ** m_ppInst;
+	unsigned char * m_pType;
+	unsigned char * m_pFlags;
+	int m_nCount;
+	int m_nAlloc;
+	int m_nGroupsVersion;				//!< m_nGroupsChanged the group values were taken at
+	bool m_bUseSSE;
+
+	static int m_nGroupsChanged;
+
+	// cull scratch, reused by all sectors
+	static list2<SVegetationVisible> m_lstCulled;
+	static list2<int> m_lstKeys;								//!< type*2+sprite per culled instance
+	static int m_arrKeyStart[256*2+1];
+};
+
+#endif // __vegetationsoa_h__
@@ -28,6 +28,9 @@ CVisAreaManager::CVisAreaManager()
 {
 	m_pCurPortal = m_pCurArea = 0;
   m_nLoadedSectors = 0;
+	m_vGridMin = m_vGridMax = Vec3d(0,0,0);
+	m_fGridInvCellSizeX = m_fGridInvCellSizeY = 0;
+	InvalidateAreaGrid();
 }
 
 CVisAreaManager::~CVisAreaManager()
@@ -142,6 +145,9 @@ bool CVisAreaManager::IsOutdoorAreasVisible()
 
 void CVisAreaManager::LoadVisAreaBoxFromXML(XDOM::IXMLDOMDocumentPtr pDoc)
 {
+	// areas get deleted, the grid is rebuilt by UpdateConnections at the end
+	InvalidateAreaGrid();
+
 	{
 		{ // reset only non shape volumes
 			for(int i=0; i<m_lstVisAreas.Count(); i++)
@@ -662,6 +668,9 @@ bool CVisAreaManager::DeleteVisArea(CVisArea * pVisArea)
 
 void CVisAreaManager::LoadVisAreaShapeFromXML(XDOM::IXMLDOMDocumentPtr pDoc)
 {
+	// areas get deleted, the grid is rebuilt by UpdateConnections of LoadVisAreaBoxFromXML
+	InvalidateAreaGrid();
+
 	{ // reset only shape volumes
 		for(int i=0; i<m_lstVisAreas.Count(); i++)
 		{
@@ -869,6 +878,108 @@ void CVisAreaManager::UpdateConnections()
 			}
 		}
 	}
+
+	RebuildAreaGrid();
+}
+
+// cells are not smaller than this, in meters
+#define VIS_AREA_GRID_MIN_CELL 2.f
+// max cells per axis
+#define VIS_AREA_GRID_MAX_SIZE 256
+
+void CVisAreaManager::RebuildAreaGrid()
+{
+	InvalidateAreaGrid();
+	m_lstGridCellStart.Clear();
+	m_lstGridAreas.Clear();
+
+	// bounds of everything GetVisAreaFromPos can return
+	m_vGridMin = SetMaxBB();
+	m_vGridMax = SetMinBB();
+	int nAreas = 0;
+	for(int nList=0; nList<2; nList++)
+	{
+		list2<CVisArea*> & lstAreas = nList ? m_lstPortals : m_lstVisAreas;
+		for(int v=0; v<lstAreas.Count(); v++)
+		{
+			CVisArea * pArea = lstAreas[v];
+			if(pArea->m_vBoxMin.x > pArea->m_vBoxMax.x || pArea->m_vBoxMin.y > pArea->m_vBoxMax.y || pArea->m_vBoxMin.z > pArea->m_vBoxMax.z)
+				continue; // no shape points, the point test never passes
+			m_vGridMin.CheckMin(pArea->m_vBoxMin);
+			m_vGridMax.CheckMax(pArea->m_vBoxMax);
+			nAreas++;
+		}
+	}
+
+	if(!nAreas)
+		return;
+
+	// about 2 cells per area
+	float fSizeX = m_vGridMax.x - m_vGridMin.x;
+	float fSizeY = m_vGridMax.y - m_vGridMin.y;
+	float fCellSize = cry_sqrtf(max(fSizeX,1.f)*max(fSizeY,1.f)/(nAreas*2));
+	if(fCellSize < VIS_AREA_GRID_MIN_CELL)
+		fCellSize = VIS_AREA_GRID_MIN_CELL;
+
+	int nSizeX = min(int(fSizeX/fCellSize)+1, VIS_AREA_GRID_MAX_SIZE);
+	int nSizeY = min(int(fSizeY/fCellSize)+1, VIS_AREA_GRID_MAX_SIZE);
+	m_fGridInvCellSizeX = fSizeX>0 ? nSizeX/fSizeX : 0;
+	m_fGridInvCellSizeY = fSizeY>0 ? nSizeY/fSizeY : 0;
+	m_nGridSizeX = nSizeX;
+	m_nGridSizeY = nSizeY;
+
+	// count the areas of each cell, then place them; vis areas go first like in the list walk
+	int nCells = nSizeX*nSizeY;
+	m_lstGridCellStart.PreAllocate(nCells+1, nCells+1);
+	memset(m_lstGridCellStart.GetElements(), 0, sizeof(int)*(nCells+1));
+
+	for(int nPass=0; nPass<2; nPass++)
+	{
+		for(int nList=0; nList<2; nList++)
+		{
+			list2<CVisArea*> & lstAreas = nList ? m_lstPortals : m_lstVisAreas;
+			for(int v=0; v<lstAreas.Count(); v++)
+			{
+				CVisArea * pArea = lstAreas[v];
+				int nMinCell, nMaxCell;
+				if(!GetAreaGridCell(pArea->m_vBoxMin, nMinCell) || !GetAreaGridCell(pArea->m_vBoxMax, nMaxCell))
+					continue;
+
+				for(int y=nMinCell/nSizeX; y<=nMaxCell/nSizeX; y++)
+				for(int x=nMinCell%nSizeX; x<=nMaxCell%nSizeX; x++)
+				{
+					if(nPass==0)
+						m_lstGridCellStart[x+y*nSizeX+1]++;
+					else
+						m_lstGridAreas[m_lstGridCellStart[x+y*nSizeX]++] = pArea;
+				}
+			}
+		}
+
+		if(nPass==0)
+		{ // counts to the start of the cell
+			for(int c=0; c<nCells; c++)
+				m_lstGridCellStart[c+1] += m_lstGridCellStart[c];
+			m_lstGridAreas.PreAllocate(m_lstGridCellStart[nCells], m_lstGridCellStart[nCells]);
+		}
+		else
+		{ // the second pass moved every start to the end of its cell, which is the start of the next one
+			for(int c=nCells; c>0; c--)
+				m_lstGridCellStart[c] = m_lstGridCellStart[c-1];
+			m_lstGridCellStart[0] = 0;
+		}
+	}
+}
+
+bool CVisAreaManager::GetAreaGridCell(const Vec3d & vPos, int & nCell)
+{
+	if(!Overlap::Point_AABB(vPos, m_vGridMin, m_vGridMax))
+		return false;
+
+	int x = min(int((vPos.x-m_vGridMin.x)*m_fGridInvCellSizeX), m_nGridSizeX-1);
+	int y = min(int((vPos.y-m_vGridMin.y)*m_fGridInvCellSizeY), m_nGridSizeY-1);
+	nCell = x + y*m_nGridSizeX;
+	return true;
 }
 
 void CVisAreaManager::MoveAllEntitiesIntoList(list2<IEntityRender*> * plstVisAreasEntities, 
@@ -900,6 +1011,57 @@ void CVisAreaManager::MoveAllEntitiesIntoList(list2<IEntityRender*> * plstVisAre
 }
 
 IVisArea * CVisAreaManager::GetVisAreaFromPos(const Vec3d &vPos)
+{
+	if(!m_nGridSizeX)
+		return GetVisAreaFromPosNoGrid(vPos);
+
+	int nCell;
+	if(!GetAreaGridCell(vPos, nCell))
+		return 0;
+
+	for(int i=m_lstGridCellStart[nCell]; i<m_lstGridCellStart[nCell+1]; i++)
+		if(m_lstGridAreas[i]->IsPointInsideVisArea(vPos))
+			return m_lstGridAreas[i];
+
+	return 0;
+}
+
+void CVisAreaManager::GetVisAreasFromPos(const Vec3d * pPos, int nCount, IVisArea ** ppAreas)
+{
+	if(!m_nGridSizeX)
+	{
+		for(int i=0; i<nCount; i++)
+			ppAreas[i] = GetVisAreaFromPosNoGrid(pPos[i]);
+		return;
+	}
+
+	// neighbouring points mostly fall into the same cell, and most of the cells are empty
+	int nPrevCell = -1, nStart = 0, nEnd = 0;
+	for(int i=0; i<nCount; i++)
+	{
+		ppAreas[i] = 0;
+
+		int nCell;
+		if(!GetAreaGridCell(pPos[i], nCell))
+			continue;
+
+		if(nCell != nPrevCell)
+		{
+			nPrevCell = nCell;
+			nStart = m_lstGridCellStart[nCell];
+			nEnd = m_lstGridCellStart[nCell+1];
+		}
+
+		for(int a=nStart; a<nEnd; a++)
+			if(m_lstGridAreas[a]->IsPointInsideVisArea(pPos[i]))
+			{
+				ppAreas[i] = m_lstGridAreas[a];
+				break;
+			}
+	}
+}
+
+IVisArea * CVisAreaManager::GetVisAreaFromPosNoGrid(const Vec3d &vPos)
 {
 	// check areas
 	for(int v=0; v<m_lstVisAreas.Count(); v++)
@@ -914,6 +1076,25 @@ IVisArea * CVisAreaManager::GetVisAreaFromPos(const Vec3d &vPos)
 	return 0;
 }
 
+// true if the box touches the bounds of some area or portal, GetVisAreaFromPos can only find something inside of them
+bool CVisAreaManager::IsBoxOverlapVisAreas(const Vec3d & vBoxMin, const Vec3d & vBoxMax)
+{
+	AABB box(vBoxMin, vBoxMax);
+
+	if(m_nGridSizeX && !Overlap::AABB_AABB(box, AABB(m_vGridMin, m_vGridMax)))
+		return false;
+
+	for(int v=0; v<m_lstVisAreas.Count(); v++)
+		if(Overlap::AABB_AABB(box, AABB(m_lstVisAreas[v]->m_vBoxMin, m_lstVisAreas[v]->m_vBoxMax)))
+			return true;
+
+	for(int v=0; v<m_lstPortals.Count(); v++)
+		if(Overlap::AABB_AABB(box, AABB(m_lstPortals[v]->m_vBoxMin, m_lstPortals[v]->m_vBoxMax)))
+			return true;
+
+	return false;
+}
+
 CVisArea * CVisAreaManager::CreateVisArea()
 {
 	CVisArea * p = new CVisArea(false);
@@ -1313,6 +1494,8 @@ void CVisAreaManager::GetMemoryUsage(ICrySizer*pSizer)
   for(int v=0; v<m_lstPortals.Count(); v++)
     m_lstPortals[v]->GetMemoryUsage(pSizer);
 
+  pSizer->AddObject(&m_lstGridAreas, m_lstGridAreas.GetMemoryUsage() + m_lstGridCellStart.GetMemoryUsage());
+
   pSizer->AddObject(this,sizeof(*this));
 }
 
@@ -1466,3 +1649,85 @@ void CVisAreaManager::GetObjectsAround(Vec3d vExploPos, float fExploRadius, list
 				pEntList->Add(pEntityRender);
 	}
 }
+
+void CVisAreaManager::RunBenchmark(int nQueries)
+{
+	if(!m_nGridSizeX)
+		RebuildAreaGrid();
+	if(!m_nGridSizeX || nQueries<=0)
+	{
+		GetLog()->Log("Vis area benchmark: no areas in the level");
+		return;
+	}
+
+	// random points in the area bounds and a bit around them, same set every run
+	Vec3d vSize = m_vGridMax - m_vGridMin;
+	Vec3d vMin = m_vGridMin - vSize*0.1f;
+	srand(0);
+	list2<Vec3d> lstPoints;
+	lstPoints.PreAllocate(nQueries, nQueries);
+	for(int i=0; i<nQueries; i++)
+		lstPoints[i] = vMin + Vec3d(rnd()*vSize.x, rnd()*vSize.y, rnd()*vSize.z)*1.2f;
+
+	list2<IVisArea*> lstList, lstGrid, lstBatch;
+	lstList.PreAllocate(nQueries, nQueries);
+	lstGrid.PreAllocate(nQueries, nQueries);
+	lstBatch.PreAllocate(nQueries, nQueries);
+
+	ITimer * pTimer = GetTimer();
+	float fStart = pTimer->GetAsyncCurTime();
+	for(int i=0; i<nQueries; i++)
+		lstList[i] = GetVisAreaFromPosNoGrid(lstPoints[i]);
+	float fList = pTimer->GetAsyncCurTime();
+	for(int i=0; i<nQueries; i++)
+		lstGrid[i] = GetVisAreaFromPos(lstPoints[i]);
+	float fGrid = pTimer->GetAsyncCurTime();
+	GetVisAreasFromPos(lstPoints.GetElements(), nQueries, lstBatch.GetElements());
+	float fBatch = pTimer->GetAsyncCurTime();
+
+	int nInside = 0, nDifferent = 0;
+	for(int i=0; i<nQueries; i++)
+	{
+		nInside += lstList[i]!=0;
+		nDifferent += lstGrid[i]!=lstList[i] || lstBatch[i]!=lstList[i];
+	}
+
+	GetLog()->Log("Vis area benchmark: %d areas, %d portals, grid %dx%d with %d entries, %d points (%d inside)",
+		m_lstVisAreas.Count(), m_lstPortals.Count(), m_nGridSizeX, m_nGridSizeY, m_lstGridAreas.Count(), nQueries, nInside);
+	GetLog()->Log("  list: %.3f ms, grid: %.3f ms, batched: %.3f ms, %d different results",
+		(fList-fStart)*1000.f, (fGrid-fList)*1000.f, (fBatch-fGrid)*1000.f, nDifferent);
+}
+
+void CVisAreaManager::RunSyntheticBenchmark(int nAreas, int nQueries)
+{
+	CVisAreaManager * pManager = new CVisAreaManager();
+
+	// rooms of 8x8 meters on a 10 meter raster, each one has a portal to its neighbour in x
+	int nRow = max(int(cry_sqrtf((float)nAreas)), 1);
+	for(int i=0; i<nAreas; i++)
+	{
+		float x = float(i%nRow)*10.f, y = float(i/nRow)*10.f;
+		char szName[32];
+
+		Vec3d arrRoom[4] = { Vec3d(x,y,0), Vec3d(x+8,y,0), Vec3d(x+8,y+8,0), Vec3d(x,y+8,0) };
+		CVisArea * pRoom = new CVisArea(false);
+		sprintf(szName, "visarea_%d", i);
+		pRoom->Update(arrRoom, 4, szName, 4.f, Vec3d(0,0,0), false, false, Vec3d(0,0,0), 100.f, true, false, false);
+		pManager->m_lstVisAreas.Add(pRoom);
+
+		if(i%nRow == nRow-1)
+			continue;
+
+		Vec3d arrDoor[4] = { Vec3d(x+7,y+3,0), Vec3d(x+11,y+3,0), Vec3d(x+11,y+5,0), Vec3d(x+7,y+5,0) };
+		CVisArea * pDoor = new CVisArea(false);
+		sprintf(szName, "portal_%d", i);
+		pDoor->Update(arrDoor, 4, szName, 3.f, Vec3d(0,0,0), false, false, Vec3d(0,0,0), 100.f, true, false, false);
+		pManager->m_lstPortals.Add(pDoor);
+	}
+
+	// only the point queries are measured, the connections are not needed
+	pManager->RebuildAreaGrid();
+	pManager->RunBenchmark(nQueries);
+
+	delete pManager;
+}
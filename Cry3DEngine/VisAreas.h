@@ -107,6 +107,9 @@ struct CVisAreaManager : public Cry3DEngineBase
 	void UpdateConnections();
 	void MoveAllEntitiesIntoList(list2<IEntityRender*> * plstVisAreasEntities, const Vec3d & vBoxMin, const Vec3d & vBoxMax);
 	IVisArea * GetVisAreaFromPos(const Vec3d &vPos);
+	// GetVisAreaFromPos for each of the points, ppAreas receives nCount results
+	void GetVisAreasFromPos(const Vec3d * pPos, int nCount, IVisArea ** ppAreas);
+	bool IsBoxOverlapVisAreas(const Vec3d & vBoxMin, const Vec3d & vBoxMax);
 //	void DefineTrees();
 	bool IsEntityVisAreaVisible(IEntityRender * pEnt, bool nCheckNeighbors);
 	void SetAreaFogVolume(CTerrain * pTerrain, CVisArea * pVisArea);
@@ -124,6 +127,23 @@ struct CVisAreaManager : public Cry3DEngineBase
 	bool IsOccludedByOcclVolumes(Vec3d vBoxMin, Vec3d vBoxMax, bool bCheckOnlyIndoorVolumes = false);
 	void Preceche(CObjManager * pObjManager);
 	void GetObjectsAround(Vec3d vExploPos, float fExploRadius, list2<IEntityRender*> * pEntList);
+
+	// 2d grid over the bounds of the areas and portals, used by GetVisAreaFromPos.
+	// Rebuilt by UpdateConnections, so every change of the area lists ends with it.
+	void RebuildAreaGrid();
+	void InvalidateAreaGrid() { m_nGridSizeX = m_nGridSizeY = 0; }
+	bool GetAreaGridCell(const Vec3d & vPos, int & nCell);
+	IVisArea * GetVisAreaFromPosNoGrid(const Vec3d &vPos);
+	// compares the grid with the plain list walk on random points (e_vis_area_bench)
+	void RunBenchmark(int nQueries);
+	// same on a generated level of nAreas rooms connected by portals
+	static void RunSyntheticBenchmark(int nAreas, int nQueries);
+
+	Vec3d m_vGridMin, m_vGridMax;					// bounds of all areas and portals
+	float m_fGridInvCellSizeX, m_fGridInvCellSizeY;
+	int m_nGridSizeX, m_nGridSizeY;				// 0 if not built, the lists are walked then
+	list2<int> m_lstGridCellStart;				// first entry of each cell in m_lstGridAreas, one more at the end
+	list2<CVisArea*> m_lstGridAreas;			// per cell: the vis areas, then the portals, in list order
 };
 
 #endif // VisArea_H
\ No newline at end of file
@@ -16,6 +16,34 @@
 #include "stdafx.h"
 #include "cbuffer.h"
 
+#ifdef COVERAGEBUFFER_SSE
+#include <xmmintrin.h>
+#endif
+
+CCoverageBuffer::CCoverageBuffer(IRenderer * pRenderer)
+{ 
+  m_pRenderer = pRenderer; 
+  m_pDepth = (float*)(((UINT_PTR)m_DepthData + 15) & ~(UINT_PTR)15);
+  ClearBuffer();
+  m_nTrisInBuffer=0;
+
+#if defined(COVERAGEBUFFER_SSE) && defined(_CPU_X86)
+  m_bUseSSE = (Cry3DEngineBase::m_CpuFlags & CPUF_SSE) != 0;
+#elif defined(COVERAGEBUFFER_SSE)
+  m_bUseSSE = true;
+#else
+  m_bUseSSE = false;
+#endif
+}
+
+void CCoverageBuffer::ClearBuffer()
+{
+  memset(m_pDepth,0,sizeof(float)*COVERAGEBUFFER_SIZE*COVERAGEBUFFER_SIZE); 
+  memset(m_TileMin,0,sizeof(m_TileMin));
+  memset(m_TileMax,0,sizeof(m_TileMax));
+  memset(m_TileDirty,0,sizeof(m_TileDirty));
+}
+
 void CCoverageBuffer::TransformPoint(float out[4], const float m[16], const float in[4])
 {
 #define M(row,col)  m[col*4+row]
@@ -47,7 +75,7 @@ void CCoverageBuffer::MatMul4( float *product, const float *a, const float *b )
 
 CCoverageBuffer::Point2d CCoverageBuffer::ProjectToScreen(const float & x, const float & y, const float & z)
 {
-  Point2d res; float res_z;
+  Point2d res;
 
   float _in[4], out[4];
   _in[0] = x;
@@ -57,21 +85,19 @@ CCoverageBuffer::Point2d CCoverageBuffer::ProjectToScreen(const float & x, const
 
   TransformPoint(out, m_matCombined, _in);
 
-  if (out[3] == 0.0)
+  if (out[3] < 0.001f)
+  { // behind or at the camera
     res.x = res.y = -1000; // mark vertex as bad - skip this triangle
+    res.z = 0;
+  }
   else
   {
-    res.x = out[0] / out[3];
-    res.y = out[1] / out[3];
-    res_z = out[2] / out[3];
+    res.z = 1.f / out[3];
+    res.x = out[0] * res.z;
+    res.y = out[1] * res.z;
 
     res.x = m_matViewPort[0] + (1.f + res.x) * m_matViewPort[2] * 0.5f;
     res.y = m_matViewPort[1] + (1.f + res.y) * m_matViewPort[3] * 0.5f;
-
-    res_z = (1.f + res_z) * 0.5f;
-
-    if( res_z < 0 || res_z > 1 )
-      res_z=res_z;//res.x = res.y = -1000; // mark vertex as bad - skip this triangle
   }
 
   return res;
@@ -271,13 +297,19 @@ bool CCoverageBuffer::IsBBoxVisible(const Vec3d & mins, const Vec3d & maxs)
   if(min2d.x<-900 || min2d.y<-900 || max2d.x<-900 || max2d.y<-900)
     return true; // object intersect near plane
 
+  // depth of the closest corner
+  float fZ = verts[0].z;
+  for(int i=1; i<8; i++)
+    if(verts[i].z > fZ)
+      fZ = verts[i].z;
+
   // make it little bigger to be sure that it's bigger than 1 pixel
   min2d.x -= 0.25f;
   min2d.y -= 0.25f;
   max2d.x += 0.25f;
   max2d.y += 0.25f;
 
-  return IsQuadVisible(min2d, max2d);
+  return IsQuadVisible(min2d, max2d, fZ);
 }
 
 bool CCoverageBuffer::__IsSphereVisible(const Vec3d & vCenter, float fRadius, float fDistance)
@@ -286,51 +318,121 @@ bool CCoverageBuffer::__IsSphereVisible(const Vec3d & vCenter, float fRadius, fl
     return true;
 
   Point2d Center2d = ProjectToScreen(vCenter.x,vCenter.y,vCenter.z);
+  if(Center2d.z<=0)
+    return true;
+
+  // closest point of the sphere
+  float fNearest = 1.f/Center2d.z - fRadius;
+  if(fNearest < 0.25f)
+    return true;
+
   float fRadius2d = fRadius * COVERAGEBUFFER_SIZE / fDistance / 2;
 
   // find 2d quad
   Point2d min2d(Center2d.x-fRadius2d, Center2d.y-fRadius2d*0.5f);
   Point2d max2d(Center2d.x+fRadius2d, Center2d.y+fRadius2d*0.5f);
 
-  return IsQuadVisible(min2d, max2d);
+  return IsQuadVisible(min2d, max2d, 1.f/fNearest);
 }
 
-bool CCoverageBuffer::IsQuadVisible(const Point2d & min2d, const Point2d & max2d)
+bool CCoverageBuffer::IsQuadVisible(const Point2d & min2d, const Point2d & max2d, float fZ)
 {
-  // make ints
-  int x1 = fastfround(min2d.x);
-  int y1 = fastfround(min2d.y);
-  int x2 = fastfround(max2d.x);
-  int y2 = fastfround(max2d.y);
-
-  // clip quads by screen bounds and reject quads totaly outside of the screen
-  if(x1<0)
-    x1=0;
-  else if(x1>=COVERAGEBUFFER_SIZE)
+  // make ints, use every pixel touched by the quad
+  if(max2d.x<0 || max2d.y<0)
     return false;
 
-  if(y1<0)
-    y1=0;
-  else if(y1>=COVERAGEBUFFER_SIZE)
-    return false;
+  int x1 = min2d.x>0 ? (int)min2d.x : 0;
+  int y1 = min2d.y>0 ? (int)min2d.y : 0;
+  int x2 = (int)max2d.x;
+  int y2 = (int)max2d.y;
 
-  if(x2<0)
+  // clip quads by screen bounds and reject quads totaly outside of the screen
+  if(x1>=COVERAGEBUFFER_SIZE || y1>=COVERAGEBUFFER_SIZE)
     return false;
-  else if(x2>=COVERAGEBUFFER_SIZE)
+
+  if(x2>=COVERAGEBUFFER_SIZE)
     x2=COVERAGEBUFFER_SIZE-1;
 
-  if(y2<0)
-    return false;
-  else if(y2>=COVERAGEBUFFER_SIZE)
+  if(y2>=COVERAGEBUFFER_SIZE)
     y2=COVERAGEBUFFER_SIZE-1;
 
-  // check each pixel inside this quad, if some pixel is zero - quad is visible
-  for(int x=x1; x<=x2; x++)
-  for(int y=y1; y<=y2; y++)
-    if(!m_Buffer[x][y])
-      return true;
+  // pixel hides the quad only if it's closer than that
+  float fZTest = fZ*COVERAGEBUFFER_DEPTH_BIAS;
 
-  return 0;
+  for(int ty=y1/COVERAGEBUFFER_TILE_SIZE; ty<=y2/COVERAGEBUFFER_TILE_SIZE; ty++)
+  for(int tx=x1/COVERAGEBUFFER_TILE_SIZE; tx<=x2/COVERAGEBUFFER_TILE_SIZE; tx++)
+  {
+    int nTile = ty*COVERAGEBUFFER_TILES+tx;
+    if(m_TileDirty[nTile])
+      UpdateTile(nTile);
+
+    if(m_TileMin[nTile] > fZTest)
+      continue; // all pixels of the tile are in front of the quad
+
+    if(m_TileMax[nTile] <= fZTest)
+      return true; // no pixel of the tile is in front of the quad
+
+    // check each pixel of this tile inside of the quad
+    int nX1 = max(x1, tx*COVERAGEBUFFER_TILE_SIZE);
+    int nX2 = min(x2, tx*COVERAGEBUFFER_TILE_SIZE+COVERAGEBUFFER_TILE_SIZE-1);
+    int nY1 = max(y1, ty*COVERAGEBUFFER_TILE_SIZE);
+    int nY2 = min(y2, ty*COVERAGEBUFFER_TILE_SIZE+COVERAGEBUFFER_TILE_SIZE-1);
+
+    for(int y=nY1; y<=nY2; y++)
+    {
+      const float * pRow = &m_pDepth[y*COVERAGEBUFFER_SIZE];
+      for(int x=nX1; x<=nX2; x++)
+        if(pRow[x] <= fZTest)
+          return true;
+    }
+  }
+
+  return false;
+}
+
+void CCoverageBuffer::UpdateTile(int nTile)
+{
+  const float * pSrc = &m_pDepth[
+    (nTile/COVERAGEBUFFER_TILES)*COVERAGEBUFFER_TILE_SIZE*COVERAGEBUFFER_SIZE + 
+    (nTile%COVERAGEBUFFER_TILES)*COVERAGEBUFFER_TILE_SIZE];
+
+#ifdef COVERAGEBUFFER_SSE
+  if(m_bUseSSE)
+  {
+    __m128 vMin = _mm_load_ps(pSrc);
+    __m128 vMax = vMin;
+    for(int y=0; y<COVERAGEBUFFER_TILE_SIZE; y++, pSrc+=COVERAGEBUFFER_SIZE)
+    for(int x=0; x<COVERAGEBUFFER_TILE_SIZE; x+=4)
+    {
+      __m128 v = _mm_load_ps(pSrc+x);
+      vMin = _mm_min_ps(vMin, v);
+      vMax = _mm_max_ps(vMax, v);
+    }
+
+    vMin = _mm_min_ps(vMin, _mm_movehl_ps(vMin, vMin));
+    vMin = _mm_min_ss(vMin, _mm_shuffle_ps(vMin, vMin, 1));
+    vMax = _mm_max_ps(vMax, _mm_movehl_ps(vMax, vMax));
+    vMax = _mm_max_ss(vMax, _mm_shuffle_ps(vMax, vMax, 1));
+    _mm_store_ss(&m_TileMin[nTile], vMin);
+    _mm_store_ss(&m_TileMax[nTile], vMax);
+  }
+  else
+#endif
+  {
+    float fMin = pSrc[0], fMax = pSrc[0];
+    for(int y=0; y<COVERAGEBUFFER_TILE_SIZE; y++, pSrc+=COVERAGEBUFFER_SIZE)
+    for(int x=0; x<COVERAGEBUFFER_TILE_SIZE; x++)
+    {
+      if(pSrc[x] < fMin)
+        fMin = pSrc[x];
+      if(pSrc[x] > fMax)
+        fMax = pSrc[x];
+    }
+    m_TileMin[nTile] = fMin;
+    m_TileMax[nTile] = fMax;
+  }
+
+  m_TileDirty[nTile] = false;
 }
 
 bool CCoverageBuffer::IsPixelVisible(int nScreenX, int nScreenY)
@@ -347,7 +449,7 @@ bool CCoverageBuffer::IsPixelVisible(int nScreenX, int nScreenY)
   if(nScreenY<0 || nScreenY>=COVERAGEBUFFER_SIZE)
     return false;
 
-  return (!m_Buffer[nScreenX][nScreenY]);
+  return (!m_pDepth[nScreenY*COVERAGEBUFFER_SIZE+nScreenX]);
 }
 
 void CCoverageBuffer::DrawDebug(int nStep)
@@ -359,39 +461,12 @@ void CCoverageBuffer::DrawDebug(int nStep)
 
   for(int x=0; x<COVERAGEBUFFER_SIZE; x+=nStep)
   for(int y=0; y<COVERAGEBUFFER_SIZE; y+=nStep)
-    if(m_Buffer[x][y])
+    if(m_pDepth[y*COVERAGEBUFFER_SIZE+x])
       m_pRenderer->DrawPoint((float)x,COVERAGEBUFFER_SIZE-(float)y,0,1);
 
   m_pRenderer->Set2DMode(false,COVERAGEBUFFER_SIZE,COVERAGEBUFFER_SIZE);
 }
 
-void CCoverageBuffer::ScanLine(int x1, int x2, int y, float & dxdyl, float & dxdyr)
-{
-  if(y<0 || y>=COVERAGEBUFFER_SIZE)
-    return;
-
-  // if we reach left border - stop changing line start x
-  if(x1<0)
-  {
-//    dxdyl = 0;
-    x1 = 0;
-  }
-
-  // if we reach right border - stop changing line stop x
-  if(x2>=COVERAGEBUFFER_SIZE)
-  {
-//    dxdyr = 0;
-    x2 = COVERAGEBUFFER_SIZE-1;
-  }
-
-  // draw line
-  for(int x = x1; x <= x2; x++)
-  {
-    assert(x>=0 && x<COVERAGEBUFFER_SIZE);
-    m_Buffer[x][y]=1;
-  }
-}
-
 // return number of vertices to add
 int CCoverageBuffer::ClipEdge(const Vec3d & v1, const Vec3d & v2, const Plane & ClipPlane, Vec3d & vRes1, Vec3d & vRes2)
 {
@@ -557,106 +632,113 @@ void CCoverageBuffer::ScanTriangleWithCliping(Point2d p1,Point2d p2,Point2d p3,
 void CCoverageBuffer::ScanTriangle(Point2d p1,Point2d p2,Point2d p3)
 {
   // back face culling // todo: move one level up
-  float fDot = (p1.x-p2.x)*(p3.y-p2.y)-(p1.y-p2.y)*(p3.x-p2.x);        
-  if(fDot>0)
+  float fArea = (p2.x-p1.x)*(p3.y-p1.y)-(p2.y-p1.y)*(p3.x-p1.x);
+  if(fArea<=0)
     return;
 
-  // make ints
-  p1.x = (float)fastfround(p1.x);
-  p1.y = (float)fastfround(p1.y);
-  p2.x = (float)fastfround(p2.x);
-  p2.y = (float)fastfround(p2.y);
-  p3.x = (float)fastfround(p3.x);
-  p3.y = (float)fastfround(p3.y);
+  // bounds in pixels
+  float fMinX = min(p1.x,min(p2.x,p3.x));
+  float fMaxX = max(p1.x,max(p2.x,p3.x));
+  float fMinY = min(p1.y,min(p2.y,p3.y));
+  float fMaxY = max(p1.y,max(p2.y,p3.y));
 
-  // sort vertices by y
-  if(p2.y<p3.y)
-  {
-    Point2d tmp = p2;
-    p2 = p3;
-    p3 = tmp;
-  }
-
-  if(p1.y<p2.y)
-  {
-    Point2d tmp = p1;
-    p1 = p2;
-    p2 = tmp;
-  }
-
-  if(p2.y<p3.y)
-  {
-    Point2d tmp = p2;
-    p2 = p3;
-    p3 = tmp;
-  }
-
-  { // draw top part
-    Point2d vLeft  = (p1-p3);
-    Point2d vRight = (p1-p2);
-
-    float dxdyl = vLeft.x /vLeft.y;
-    float dxdyr = vRight.x/vRight.y;
+  if(fMaxX<0 || fMaxY<0)
+    return;
 
-    float x1 = p1.x;
-    float x2 = p1.x;
+  int nX1 = fMinX>0 ? (int)fMinX : 0;
+  int nY1 = fMinY>0 ? (int)fMinY : 0;
+  int nX2 = min((int)fMaxX, COVERAGEBUFFER_SIZE-1);
+  int nY2 = min((int)fMaxY, COVERAGEBUFFER_SIZE-1);
 
-    if(dxdyl<dxdyr)
-    { // swap
-      float x = x1;
-      x1 = x2;
-      x2 = x;
+  if(nX1>nX2 || nY1>nY2)
+    return;
 
-      float d = dxdyl;
-      dxdyl = dxdyr;
-      dxdyr = d;
-    }
-  
-    int y2 = max(fastfround(p2.y), 0); // limit by screen bottom
-    if(p1.y>p2.y && y2<COVERAGEBUFFER_SIZE) // if top side of triangle is visible
+  // edge functions, pixel center is inside if all are >= 0
+  float arrA[3] = { p1.y-p2.y, p2.y-p3.y, p3.y-p1.y };
+  float arrB[3] = { p2.x-p1.x, p3.x-p2.x, p1.x-p3.x };
+  float arrC[3] = { 
+    -(arrA[0]*p1.x + arrB[0]*p1.y), 
+    -(arrA[1]*p2.x + arrB[1]*p2.y), 
+    -(arrA[2]*p3.x + arrB[2]*p3.y) };
+
+  // 1/w is linear in screen space
+  float fDZDX = ((p2.z-p1.z)*(p3.y-p1.y) - (p3.z-p1.z)*(p2.y-p1.y)) / fArea;
+  float fDZDY = ((p3.z-p1.z)*(p2.x-p1.x) - (p2.z-p1.z)*(p3.x-p1.x)) / fArea;
+  float fZC = p1.z - fDZDX*p1.x - fDZDY*p1.y;
+
+#ifdef COVERAGEBUFFER_SSE
+  if(m_bUseSSE)
+  { // 4 pixels at once, rows start at 16 byte boundary
+    int nXStart = nX1 & ~3;
+    float fX = (float)nXStart + 0.5f;
+    float fY = (float)nY1 + 0.5f;
+    const __m128 vStepX = _mm_set_ps(3.f,2.f,1.f,0.f);
+    const __m128 vZero = _mm_setzero_ps();
+
+    __m128 vRowE0 = _mm_add_ps(_mm_set1_ps(arrA[0]*fX + arrB[0]*fY + arrC[0]), _mm_mul_ps(_mm_set1_ps(arrA[0]), vStepX));
+    __m128 vRowE1 = _mm_add_ps(_mm_set1_ps(arrA[1]*fX + arrB[1]*fY + arrC[1]), _mm_mul_ps(_mm_set1_ps(arrA[1]), vStepX));
+    __m128 vRowE2 = _mm_add_ps(_mm_set1_ps(arrA[2]*fX + arrB[2]*fY + arrC[2]), _mm_mul_ps(_mm_set1_ps(arrA[2]), vStepX));
+    __m128 vRowZ  = _mm_add_ps(_mm_set1_ps(fDZDX*fX + fDZDY*fY + fZC), _mm_mul_ps(_mm_set1_ps(fDZDX), vStepX));
+
+    const __m128 vDX0 = _mm_set1_ps(arrA[0]*4.f);
+    const __m128 vDX1 = _mm_set1_ps(arrA[1]*4.f);
+    const __m128 vDX2 = _mm_set1_ps(arrA[2]*4.f);
+    const __m128 vDXZ = _mm_set1_ps(fDZDX*4.f);
+    const __m128 vDY0 = _mm_set1_ps(arrB[0]);
+    const __m128 vDY1 = _mm_set1_ps(arrB[1]);
+    const __m128 vDY2 = _mm_set1_ps(arrB[2]);
+    const __m128 vDYZ = _mm_set1_ps(fDZDY);
+
+    for(int y=nY1; y<=nY2; y++)
     {
-      for( int y = fastfround(p1.y); y >= y2; y-- )
-      {        
-        ScanLine(fastfround(x1), fastfround(x2), y, dxdyl, dxdyr);
-        x1 -= dxdyl;
-        x2 -= dxdyr;
-      }
-    }
-  }
-
-  { // draw bottom part
-    Point2d vLeft  = (p3-p1);
-    Point2d vRight = (p3-p2);
+      __m128 vE0 = vRowE0, vE1 = vRowE1, vE2 = vRowE2, vZ = vRowZ;
+      __m128 * pDst = (__m128*)&m_pDepth[y*COVERAGEBUFFER_SIZE+nXStart];
 
-    float dxdyl = vLeft.x /vLeft.y;
-    float dxdyr = vRight.x/vRight.y;
-
-    float x1 = p3.x;
-    float x2 = p3.x;
-
-    if(dxdyl>dxdyr)
-    { // swap
-      float x = x1;
-      x1 = x2;
-      x2 = x;
+      for(int x=nXStart; x<=nX2; x+=4, pDst++)
+      {
+        __m128 vMask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vE0,vZero), _mm_cmpge_ps(vE1,vZero)), _mm_cmpge_ps(vE2,vZero));
+        if(_mm_movemask_ps(vMask))
+          *pDst = _mm_max_ps(*pDst, _mm_and_ps(vMask, vZ));
+
+        vE0 = _mm_add_ps(vE0, vDX0);
+        vE1 = _mm_add_ps(vE1, vDX1);
+        vE2 = _mm_add_ps(vE2, vDX2);
+        vZ  = _mm_add_ps(vZ,  vDXZ);
+      }
 
-      float d = dxdyl;
-      dxdyl = dxdyr;
-      dxdyr = d;
+      vRowE0 = _mm_add_ps(vRowE0, vDY0);
+      vRowE1 = _mm_add_ps(vRowE1, vDY1);
+      vRowE2 = _mm_add_ps(vRowE2, vDY2);
+      vRowZ  = _mm_add_ps(vRowZ,  vDYZ);
     }
-  
-    int y2 = min(fastfround(p2.y),COVERAGEBUFFER_SIZE);// limit by screen top
-    if(p2.y>p3.y && y2>0) // if bottom side of triangle is visible ((y2) line was already drawn)
+  }
+  else
+#endif
+  {
+    for(int y=nY1; y<=nY2; y++)
     {
-      for( int y = fastfround(p3.y); y < y2; y++ ) // ((y2) line was already drawn)
+      float fY = (float)y + 0.5f;
+      float * pRow = &m_pDepth[y*COVERAGEBUFFER_SIZE];
+      for(int x=nX1; x<=nX2; x++)
       {
-        ScanLine(fastfround(x1), fastfround(x2), y, dxdyl, dxdyr);
-        x1 += dxdyl;
-        x2 += dxdyr;
+        float fX = (float)x + 0.5f;
+        if(arrA[0]*fX + arrB[0]*fY + arrC[0] < 0 || 
+           arrA[1]*fX + arrB[1]*fY + arrC[1] < 0 || 
+           arrA[2]*fX + arrB[2]*fY + arrC[2] < 0)
+          continue;
+
+        float fZ = fDZDX*fX + fDZDY*fY + fZC;
+        if(fZ > pRow[x])
+          pRow[x] = fZ;
       }
     }
   }
 
+  // tile bounds have to be updated before next test
+  for(int ty=nY1/COVERAGEBUFFER_TILE_SIZE; ty<=nY2/COVERAGEBUFFER_TILE_SIZE; ty++)
+  for(int tx=nX1/COVERAGEBUFFER_TILE_SIZE; tx<=nX2/COVERAGEBUFFER_TILE_SIZE; tx++)
+    m_TileDirty[ty*COVERAGEBUFFER_TILES+tx] = true;
+
   m_nTrisInBuffer++;
 }
 
@@ -671,14 +753,91 @@ void CCoverageBuffer::BeginFrame(const CCamera & camera)
   m_matViewPort[2] = COVERAGEBUFFER_SIZE;
   m_matViewPort[3] = COVERAGEBUFFER_SIZE;
 
-  float matModel[16];
+  // same projection as the renderer makes from the camera (D3DXMatrixPerspectiveFovRH),
+  // this way it does not depend on renderer state and also works with NULL renderer
+  Matrix44 matModel = camera.GetVCMatrixD3D9();
   float matProj[16];
-  m_pRenderer->GetModelViewMatrix(matModel);
-  m_pRenderer->GetProjectionMatrix(matProj);
-  MatMul4(m_matCombined,matProj,matModel);
+  memset(matProj,0,sizeof(matProj));
+  float fZMin = camera.GetZMin();
+  float fZMax = camera.GetZMax();
+  float fYScale = 1.f / cry_tanf(camera.GetFov()*camera.GetProjRatio()*0.5f);
+  matProj[0]  = fYScale*camera.GetProjRatio();
+  matProj[5]  = fYScale;
+  matProj[10] = fZMax/(fZMin-fZMax);
+  matProj[11] = -1.f;
+  matProj[14] = fZMin*fZMax/(fZMin-fZMax);
+  MatMul4(m_matCombined,matProj,(float*)&matModel);
 
   // reset buffer
-  memset(m_Buffer,0,sizeof(m_Buffer)); 
+  ClearBuffer();
 
   m_nTrisInBuffer=0;
-}
\ No newline at end of file
+}
+
+void CCoverageBuffer::RunBenchmark(int nBoxes)
+{
+  const int nFrames = 16;
+
+  CCoverageBuffer * pBuffer = new CCoverageBuffer(NULL);
+
+  // camera in the origin looking along y
+  CCamera cam;
+  cam.Init(COVERAGEBUFFER_SIZE,COVERAGEBUFFER_SIZE);
+  cam.SetPos(Vec3d(0,0,0));
+  cam.SetAngle(Vec3d(0,0,0));
+  cam.Update();
+
+  // random boxes in front of the camera, same set every run
+  srand(0);
+  std::vector<Vec3d> arrOccluders, arrTesters;
+  for(int i=0; i<nBoxes; i++)
+  {
+    float fDist = 5.f + rnd()*95.f;
+    Vec3d vPos((rnd()-0.5f)*fDist*1.6f, fDist, (rnd()-0.5f)*fDist*1.2f);
+    Vec3d vSize(1.f+rnd()*6.f, 1.f+rnd()*6.f, 1.f+rnd()*4.f);
+    arrOccluders.push_back(vPos-vSize);
+    arrOccluders.push_back(vPos+vSize);
+
+    fDist = 2.f + rnd()*198.f;
+    vPos.Set((rnd()-0.5f)*fDist*1.6f, fDist, (rnd()-0.5f)*fDist*1.2f);
+    vSize.Set(0.25f+rnd()*2.f, 0.25f+rnd()*2.f, 0.25f+rnd()*2.f);
+    arrTesters.push_back(vPos-vSize);
+    arrTesters.push_back(vPos+vSize);
+  }
+
+  ITimer * pTimer = Cry3DEngineBase::GetTimer();
+  float fRenderTime = 0, fTestTime = 0;
+  int nOccluded = 0;
+
+  for(int nFrame=0; nFrame<nFrames; nFrame++)
+  {
+    float fStart = pTimer->GetAsyncCurTime();
+
+    pBuffer->BeginFrame(cam);
+    for(int i=0; i<nBoxes; i++)
+    {
+      const Vec3d & vMin = arrOccluders[i*2];
+      const Vec3d & vMax = arrOccluders[i*2+1];
+      pBuffer->AddBBox(vMin, vMax, cam.GetPos()-(vMin+vMax)*0.5f);
+    }
+
+    float fMiddle = pTimer->GetAsyncCurTime();
+
+    nOccluded = 0;
+    for(int i=0; i<nBoxes; i++)
+      if(!pBuffer->IsBBoxVisible(arrTesters[i*2], arrTesters[i*2+1]))
+        nOccluded++;
+
+    float fEnd = pTimer->GetAsyncCurTime();
+
+    fRenderTime += fMiddle-fStart;
+    fTestTime += fEnd-fMiddle;
+  }
+
+  Cry3DEngineBase::GetLog()->Log("Occlusion buffer benchmark: %d occluders, %d tested boxes (%d occluded), SSE %s", 
+    nBoxes, nBoxes, nOccluded, pBuffer->m_bUseSSE ? "on" : "off");
+  Cry3DEngineBase::GetLog()->Log("  render: %.3f ms per frame, test: %.3f ms per frame (%.3f us per box)", 
+    fRenderTime*1000.f/nFrames, fTestTime*1000.f/nFrames, fTestTime*1000000.f/nFrames/max(nBoxes,1));
+
+  delete pBuffer;
+}
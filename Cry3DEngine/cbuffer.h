@@ -17,21 +17,41 @@
 
 #define COVERAGEBUFFER_SIZE 128
 #define COVERAGEBUFFER_OCCLUDERS_MAX_DISTANCE 32
-#define COVERAGEBUFFER_OCCLUSION_TESTERS_MIN_DISTANCE 32
-
+#define COVERAGEBUFFER_TILE_SIZE 8
+#define COVERAGEBUFFER_TILES (COVERAGEBUFFER_SIZE/COVERAGEBUFFER_TILE_SIZE)
+// occluder has to be this much closer (relative) than the tested object to hide it
+#define COVERAGEBUFFER_DEPTH_BIAS 1.01f
+
+// SSE rasterization, on x86 it's also checked at runtime (CPUF_SSE)
+#if defined(_CPU_AMD64) || (defined(_CPU_X86) && !defined(__GNUC__)) || defined(__SSE__)
+#define COVERAGEBUFFER_SSE
+#endif
+
+// Software depth buffer for occlusion culling.
+// Occluders are rasterized with their 1/w (0 means nothing was rendered, bigger is closer),
+// objects are tested with the depth of their closest point. The buffer is split into tiles
+// that keep min/max depth, so most tests are decided without looking at single pixels.
 class CCoverageBuffer
 {
-  uchar m_Buffer[COVERAGEBUFFER_SIZE][COVERAGEBUFFER_SIZE];
+  // 1/w per pixel, [y*COVERAGEBUFFER_SIZE+x], m_pDepth is 16 byte aligned inside of m_DepthData
+  float m_DepthData[COVERAGEBUFFER_SIZE*COVERAGEBUFFER_SIZE+4];
+  float * m_pDepth;
+  // min/max depth of tiles, updated on demand after rendering into the tile
+  float m_TileMin[COVERAGEBUFFER_TILES*COVERAGEBUFFER_TILES];
+  float m_TileMax[COVERAGEBUFFER_TILES*COVERAGEBUFFER_TILES];
+  bool  m_TileDirty[COVERAGEBUFFER_TILES*COVERAGEBUFFER_TILES];
   IRenderer * m_pRenderer;
   int   m_matViewPort[4];
   float m_matCombined[16];
   Plane m_Planes[6];
+  bool  m_bUseSSE;
 
   struct Point2d 
   { 
     float x,y; 
+    float z; // 1/w, only valid for projected vertices
     Point2d(){};
-    Point2d(float _x, float _y) { x=_x; y=_y; }
+    Point2d(float _x, float _y) { x=_x; y=_y; z=0; }
     Point2d operator - (Point2d & o) { return Point2d (x - o.x,y - o.y); }
   };
 
@@ -39,8 +59,9 @@ class CCoverageBuffer
   void ScanTriangle(Point2d p1,Point2d p2,Point2d p3);
   void ScanTriangleWithCliping(Point2d p1,Point2d p2,Point2d p3,
                                const Vec3d & v1,const Vec3d & v2,const Vec3d & v3);
-  void ScanLine(int x1, int x2, int y, float & dxdyl, float & dxdyr);
-  bool IsQuadVisible(const Point2d & min2d, const Point2d & max2d);
+  bool IsQuadVisible(const Point2d & min2d, const Point2d & max2d, float fZ);
+  void UpdateTile(int nTile);
+  void ClearBuffer();
 
 	#if defined(WIN32) && defined(_CPU_X86)
   inline int fastfround(float f) // note: only positive numbers works correct
@@ -66,14 +87,9 @@ class CCoverageBuffer
 
 public:
 
-  CCoverageBuffer(IRenderer * pRenderer)
-  { 
-    m_pRenderer = pRenderer; 
-    memset(m_Buffer,0,sizeof(m_Buffer)); 
-    m_nTrisInBuffer=0;
-  }
+  CCoverageBuffer(IRenderer * pRenderer);
 
-  // start new frame
+  // start new frame, matrices are taken from the camera so it works without renderer as well
   void BeginFrame(const CCamera & camera);
 
   // render into buffer
@@ -90,6 +106,9 @@ public:
 
   // can be used by other classes
   static void ClipPolygon(list2<Vec3d> * pPolygon, const Plane & ClipPlane);
+
+  // renders and tests random boxes in front of a fixed camera and logs the timings (e_cbuffer_bench)
+  static void RunBenchmark(int nBoxes);
 };
 
 
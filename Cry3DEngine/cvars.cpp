@@ -65,8 +65,10 @@ void CVars::Init()
   INIT_CVAR_CHEAT(e_water_ocean,								1, "Activates drawing of ocean");
   INIT_CVAR_CHEAT(e_vegetation_debug,						0, "Debug");
   INIT_CVAR_CHEAT(e_shadow_maps_frustums,				0, "Debug");
-  INIT_CVAR_CHEAT(e_terrain_occlusion_culling,	1, "heightmap occlusion culling with time coherency 0=off, 1=on(distant occluders not processed),\n"
-																				"4=on(distant occluders still processed but with less precision) ]");
+  INIT_CVAR_CHEAT(e_terrain_occlusion_culling,	1, "heightmap occlusion culling with time coherency 0=off, 1=on, 4=same as 1\n"
+																				"(rays are traced through max height pyramid, distant occluders are always processed)");
+  INIT_CVAR_CHEAT(e_terrain_occlusion_culling_bench,	0, "Records this number of terrain occlusion queries in current level,\n"
+																				"then replays them with old (fixed steps) and new (max height pyramid) ray test and logs timings");
   INIT_CVAR_CHEAT(e_terrain_texture_bind,				1, "Debug");
   INIT_CVAR_CHEAT(e_terrain_log,								0, "Debug");
   INIT_CVAR_CHEAT(e_out_space,									0, "Debug");
@@ -82,6 +84,9 @@ void CVars::Init()
 #else
   INIT_CVAR_CHEAT(e_cbuffer,										1, "Activates usage of software coverage buffer");
 #endif
+  INIT_CVAR_CHEAT(e_cbuffer_bench,							0, "Benchmarks the coverage buffer with this number of random boxes (once), works with NULL renderer");
+  INIT_CVAR_CHEAT(e_vis_area_bench,							0, "Tests this number of random points against the vis areas of the level and of a generated\n"
+																				"level of 1024 rooms (once), with the area grid and with the plain list walk, and logs timings");
 
   INIT_CVAR_SER_R(e_stencil_shadows,						1, "Activates drawing of shadow volumes");
   INIT_CVAR_CHEAT(e_shadow_maps_debug,					0, "Debug");
@@ -148,6 +153,11 @@ void CVars::Init()
 	INIT_CVAR_CHEAT(e_stencil_shadows_build_on_load,		1, "Build connectivity during level loading");
 	INIT_CVAR_PUBL_(e_vegetation_update_shadow_every_frame, 1, "Allow updating vegetations shadow maps every frame");
 	INIT_CVAR_CHEAT(e_particles_receive_shadows, 0, "Enable shadow maps receiving for particles");
+	INIT_CVAR_CHEAT(e_particles_soa, 1, "Simulate simple billboard particles in SIMD batches per emitter");
+	INIT_CVAR_CHEAT(e_vegetation_soa, 1, "Cull simple vegetation of a sector in SIMD batches and draw it grouped by object type,\n"
+																				"applied on level load");
+	INIT_CVAR_CHEAT(e_vegetation_soa_bench, 0, "Culls this number of random vegetation instances (once) with the per instance code\n"
+																				"and with the SIMD streams and logs instances per millisecond, works with NULL renderer");
 	INIT_CVAR_CHEAT(e_light_maps_occlusion, 0, "Enable usage of occlusion maps");
 	INIT_CVAR_CHEAT(e_shadow_maps_self_shadowing, 0, "Allow self-shadowing with shadow maps");
 	INIT_CVAR_CHEAT(e_voxel_build,								0, "Regenerate voxel world");
@@ -41,6 +41,9 @@ struct CVars : public Cry3DEngineBase
     e_particles_debug,
 		e_particles_max_count,
 		e_particles_receive_shadows,
+		e_particles_soa,
+		e_vegetation_soa,
+		e_vegetation_soa_bench,
     e_decals,
     e_bflyes,
     e_vegetation_bending,
@@ -55,6 +58,7 @@ struct CVars : public Cry3DEngineBase
     e_vegetation_debug,
     e_shadow_maps_frustums,
     e_terrain_occlusion_culling,
+    e_terrain_occlusion_culling_bench,
     e_terrain_texture_pool,
     e_terrain_texture_bind,
     e_terrain_log,
@@ -76,6 +80,7 @@ struct CVars : public Cry3DEngineBase
 		e_timedemo_milliseconds,
     
 		e_cbuffer,
+		e_cbuffer_bench,
 		e_dynamic_light,
 		e_dynamic_light_exact_vis_test,
     e_stencil_shadows,
@@ -84,6 +89,7 @@ struct CVars : public Cry3DEngineBase
 		e_hw_occlusion_culling_objects,
 		e_hires_screenshoot,
 		e_portals,
+		e_vis_area_bench,
 		e_max_entity_lights,
 		e_max_shadow_map_size,
 		e_water_volumes,
@@ -20,6 +20,7 @@
 #include "visareas.h"
 #include "ParticleEffect.h"
 #include "3dEngine.h"
+#include "ParticleSoA.h"
 
 #define PARTICLES_FILE_TYPE 2
 #define PARTICLES_FILE_VERSION 4
@@ -336,7 +337,7 @@ int CPartManager::Count(int * pCurSpritesCount, int * pCurFreeCount, int * pCurE
   //  nSumm += m_lstpPartEmitters[i]->Count(); 
 
   if(pCurSpritesCount)
-    *pCurSpritesCount = m_pSpriteMan->m_nCurSpritesCount;
+    *pCurSpritesCount = m_pSpriteMan->m_nCurSpritesCount + m_pSpriteMan->m_nSoASpritesCount;
 
 	/*
   if(pCurFreeCount)
@@ -425,7 +426,10 @@ void CPartManager::GetMemoryUsage(ICrySizer*pSizer)const
 	pSizer->Add (*this);
 
 	if(m_pSpriteMan)
+	{
 		pSizer->AddObject(m_pSpriteMan, sizeof(*m_pSpriteMan));
+		m_pSpriteMan->GetSoAMemoryUsage(pSizer);
+	}
 }
 
 void CPartManager::Reset()
@@ -436,6 +440,7 @@ void CPartManager::Reset()
 	for (i = 0; i < m_pSpriteMan->m_nCurSpritesCount && i<m_pSpriteMan->m_nMaxSpritesCount; i++)
 		m_pSpriteMan->m_arrSprites[i].DeActivateParticle( pPhysWorld );
 	m_pSpriteMan->m_nCurSpritesCount=0;
+	m_pSpriteMan->ClearSoA();
 
 	// Clear all emitters.
 	for (ActiveEmitters::iterator it = m_activeEmitters.begin(); it != m_activeEmitters.end(); ++it)
@@ -509,6 +514,20 @@ void CSpriteManager::OnEntityDeleted(IEntityRender * pEntityRender)
       i--;
     }
   }
+
+	for(int e=0; e<(int)m_lstSoAEmitters.size(); e++)
+	{
+		CParticleEmitter * pEmitter = m_lstSoAEmitters[e];
+		if(pEmitter->m_pSpawnerEntity == pEntityRender)
+		{ // remove
+			m_nSoASpritesCount -= pEmitter->m_pSoA->Count();
+			pEmitter->m_pSoA->Clear();
+			if(e < (int)m_lstSoAEmitters.size()-1)
+				m_lstSoAEmitters[e] = m_lstSoAEmitters.back();
+			m_lstSoAEmitters.pop_back();
+			e--;
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -231,13 +231,21 @@ public:
   void Spawn( CParticleEmitter &emitter,bool bChildProcess );
   void Render( CObjManager * pObjManager, CTerrain * pTerrain, int nRecursionLevel, CPartManager * pPartManager, IShader * pPartLightShader);
   void OnEntityDeleted(IEntityRender * pEntityRender);
+	void ClearSoA();
+	void GetSoAMemoryUsage(ICrySizer* pSizer) const;
 
   CSprite * m_arrSprites;//[MAX_SPRITES_COUNT];
   int m_nCurSpritesCount;  
 	int m_nMaxSpritesCount;  
+	int m_nSoASpritesCount;		//!< Particles living in the streams of m_lstSoAEmitters.
 
 private:
 	void SpawnParticle( CParticleEmitter &emitter,bool bChildProcess,float fCurrTime,CParticle *pParticle );
+	void SpawnSoA( CParticleEmitter &emitter,float fCurrTime,int nCount );
+	void RenderSoA( const PartProcessParams &PPP,int nRecursionLevel,IShader * pPartLightShader );
+
+	//! Emitters with particles in their CParticleSoA.
+	std::vector<_smart_ptr<CParticleEmitter> > m_lstSoAEmitters;
 
 	ISystem* m_pSystem;
 	I3DEngine* m_p3DEngine;
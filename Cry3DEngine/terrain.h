@@ -106,11 +106,32 @@ public:
 	void GetMemoryUsage (class ICrySizer*pSizer);
 };
 
+// max number of levels in the max height pyramid (level 1 cell is 2x2 hmap units)
+#define HMAP_MAX_MIPS 16
+
 // HM data
 class CHighMap : public Cry3DEngineBase
 {
   Array2d<unsigned short> m_arrusHightMapData;
 
+  // max height pyramid, level L cell covers 2^L x 2^L hmap units including borders,
+  // used to skip empty space in ray queries; m_arrHMapMaxMips[L-1] is level L
+  Array2d<unsigned short> m_arrHMapMaxMips[HMAP_MAX_MIPS];
+  int m_nHMapMaxMips;
+
+  // terrain occlusion queries recorded for e_terrain_occlusion_culling_bench
+  struct STerrainOcclQuery
+  {
+    Vec3d vStart, vStop;
+    float fDist;
+    int nMaxTestsToScip;
+  };
+  list2<STerrainOcclQuery> m_lstOcclQueries;
+  int m_nOcclQueriesToRecord;
+  int m_nOcclSamples; // hmap samples done by ray queries, for benchmark
+
+  float GetHMapLowerBound(int nX, int nY, float fX, float fY);
+
 public:
   // Access to hmap data
   float GetZSafe(const int x, const int y);
@@ -128,10 +149,21 @@ public:
   inline unsigned short & GetHMValue(const int & x, const int & y) { return m_arrusHightMapData[x>>HMAP_BIT_SHIFT][y>>HMAP_BIT_SHIFT]; }
   void SetLightValue(const int x, const int y, const bool bValue) ;
   bool IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fDist, int nMaxTestsToScip);
+  // old version, fixed steps along the ray, kept for comparison
+  bool IntersectWithSectorSteps(Vec3d vStartPoint, Vec3d vStopPoint, float fDist, int nMaxTestsToScip);
   bool IsPointOccludedByTerrain(const Vec3d & _vPoint, float fDist, const Vec3d & vCamPos, int nMaxTestsToScip);
   bool LoadHighMap(const char * file_name, struct ICryPak * pCryPak);
+  // rebuild max height pyramid for modified area (world units)
+  void UpdateHMapMaxMips(int x1, int y1, int x2, int y2);
+  // records nQueries occlusion queries and replays them with both ray methods
+  void UpdateOcclusionBenchmark(int nQueries);
   int HMAP_BIT_SHIFT;
-	void GetHighMapMemoryUsage(ICrySizer*pSizer) { m_arrusHightMapData.GetMemoryUsage(pSizer); }
+	void GetHighMapMemoryUsage(ICrySizer*pSizer) 
+  { 
+    m_arrusHightMapData.GetMemoryUsage(pSizer); 
+    for(int i=0; i<m_nHMapMaxMips; i++)
+      m_arrHMapMaxMips[i].GetMemoryUsage(pSizer);
+  }
   bool m_bHightMapModified;
 };
 
@@ -153,6 +153,9 @@ void CTerrain::ExplodeTerrain(Vec3d vExploPos, float fExploRadius, CObjManager *
 			fResultZMin = sValue*TERRAIN_Z_RATIO;
 	}
 
+  if(bDeformTerrain)
+    UpdateHMapMaxMips(x1,y1,x2,y2);
+
   // update terrain video buffers
   for(s=0; s<lstNearSecInfos.Count(); s++)
   {
@@ -64,7 +64,7 @@ inline int fastround_positive(float f) // note: only positive numbers works corr
 inline int fastround_positive(float f) { int i; i=(int)(f+0.5f); return i; } // note: only positive numbers works correct
 #endif
 
-bool CHighMap::IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fDist, int nMaxTestsToScip)
+bool CHighMap::IntersectWithSectorSteps(Vec3d vStartPoint, Vec3d vStopPoint, float fDist, int nMaxTestsToScip)
 {
   // convert into hmap space
 	float fInvUnitSize = CTerrain::GetInvUnitSize();
@@ -101,6 +101,7 @@ bool CHighMap::IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fD
 	int nTest=0;
   for(nTest=0; nTest<nSteps && nTest<nMaxTestsToScip; nTest++)
   {
+    m_nOcclSamples++;
     if(vPos.z < m_arrusHightMapData[fastround_positive(vPos.x)][fastround_positive(vPos.y)])
       vPos += vDir;
     else
@@ -111,6 +112,7 @@ bool CHighMap::IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fD
   for(; nTest<nSteps-nMaxTestsToScip; nTest++)
   {
     vPos += vDir;
+    m_nOcclSamples++;
     if(vPos.z < m_arrusHightMapData[fastround_positive(vPos.x)][fastround_positive(vPos.y)])
       return true;
   }
@@ -118,6 +120,136 @@ bool CHighMap::IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fD
   return false;
 }
 
+// lowest possible terrain surface in hmap quad (nX,nY) at hmap space point (fX,fY)
+float CHighMap::GetHMapLowerBound(int nX, int nY, float fX, float fY)
+{
+  unsigned short h00 = m_arrusHightMapData[nX  ][nY  ];
+  unsigned short h10 = m_arrusHightMapData[nX+1][nY  ];
+  unsigned short h01 = m_arrusHightMapData[nX  ][nY+1];
+  unsigned short h11 = m_arrusHightMapData[nX+1][nY+1];
+
+  // quads with holes are not rendered
+  if( (h00 & STYPE_BIT_MASK) == STYPE_HOLE || (h10 & STYPE_BIT_MASK) == STYPE_HOLE ||
+      (h01 & STYPE_BIT_MASK) == STYPE_HOLE || (h11 & STYPE_BIT_MASK) == STYPE_HOLE )
+    return -1.f;
+
+  float z00 = (float)(h00 & (~INFO_BITS_MASK));
+  float z10 = (float)(h10 & (~INFO_BITS_MASK));
+  float z01 = (float)(h01 & (~INFO_BITS_MASK));
+  float z11 = (float)(h11 & (~INFO_BITS_MASK));
+
+  float u = fX - nX; u = max(0.f,min(1.f,u));
+  float v = fY - nY; v = max(0.f,min(1.f,v));
+
+  // quad may be split by any of the diagonals, take the lower surface
+  float fA = (u>v) ? 
+    z00 + u*(z10-z00) + v*(z11-z10) : 
+    z00 + v*(z01-z00) + u*(z11-z01);
+  float fB = (u+v<1.f) ? 
+    z00 + u*(z10-z00) + v*(z01-z00) : 
+    z11 + (1.f-u)*(z01-z11) + (1.f-v)*(z10-z11);
+
+  return min(fA,fB);
+}
+
+// Walks the ray through the max height pyramid: cells where the ray stays above the highest
+// point are skipped at once, only hmap quads close to the ray are tested against the surface.
+// Returns true only if the ray really goes under the terrain (between the ends of a quad).
+bool CHighMap::IntersectWithSector(Vec3d vStartPoint, Vec3d vStopPoint, float fDist, int nMaxTestsToScip)
+{
+  if(!m_nHMapMaxMips)
+    return IntersectWithSectorSteps(vStartPoint, vStopPoint, fDist, nMaxTestsToScip);
+
+  // convert into hmap space
+	float fInvUnitSize = CTerrain::GetInvUnitSize();
+  vStopPoint.x *= fInvUnitSize;
+  vStopPoint.y *= fInvUnitSize;
+  vStopPoint.z = vStopPoint.z*INV_TERRAIN_Z_RATIO + INFO_BITS_MASK;
+  vStartPoint.x *= fInvUnitSize;
+  vStartPoint.y *= fInvUnitSize;
+  vStartPoint.z = vStartPoint.z*INV_TERRAIN_Z_RATIO + INFO_BITS_MASK;
+
+  Vec3d vDir = (vStopPoint - vStartPoint);
+  float fLen2d = cry_sqrtf(vDir.x*vDir.x + vDir.y*vDir.y);
+
+  // like in old version do not test last 4 units steps close to the object, it stays on the ground
+  const float fStep = 4.f;
+  float fSkipEnd = fStep*min(nMaxTestsToScip,4);
+  if(fLen2d <= fSkipEnd)
+    return false;
+
+  float fInvLen = 1.f/fLen2d;
+  float tEnd = 1.f - fSkipEnd*fInvLen;
+  float tStep = fStep*fInvLen;
+  float tEps = 0.001f*fInvLen;
+  float t = 0;
+
+  // skip start of the ray while it's under the ground (camera in the building, tunnel, etc.)
+  for(int nTest=0; nTest<nMaxTestsToScip && t<tEnd; nTest++, t+=tStep)
+  {
+    Vec3d vPos = vStartPoint + vDir*t;
+    m_nOcclSamples++;
+    if(vPos.z >= (m_arrusHightMapData[fastround_positive(vPos.x)][fastround_positive(vPos.y)] & (~INFO_BITS_MASK)))
+      break;
+  }
+
+  int nHMapSize = m_arrusHightMapData.m_nSize-1;
+  int nLevel = m_nHMapMaxMips;
+
+  while(t < tEnd)
+  {
+    // cell of this level containing the ray just after t
+    float fT = t + tEps;
+    int nCells = nHMapSize>>nLevel;
+    int nX = fastftol_positive(vStartPoint.x + vDir.x*fT)>>nLevel;
+    int nY = fastftol_positive(vStartPoint.y + vDir.y*fT)>>nLevel;
+    nX = max(0,min(nCells-1,nX));
+    nY = max(0,min(nCells-1,nY));
+
+    // where the ray leaves the cell
+    float tExit = tEnd;
+    if(vDir.x>0)
+      tExit = min(tExit, ((nX+1)*(1<<nLevel) - vStartPoint.x)/vDir.x);
+    else if(vDir.x<0)
+      tExit = min(tExit, (nX*(1<<nLevel) - vStartPoint.x)/vDir.x);
+    if(vDir.y>0)
+      tExit = min(tExit, ((nY+1)*(1<<nLevel) - vStartPoint.y)/vDir.y);
+    else if(vDir.y<0)
+      tExit = min(tExit, (nY*(1<<nLevel) - vStartPoint.y)/vDir.y);
+    if(tExit < fT)
+      tExit = fT;
+
+    m_nOcclSamples++;
+
+    if(nLevel)
+    { 
+      // lowest point of the ray inside of the cell
+      float fRayZ = vStartPoint.z + vDir.z*((vDir.z>0) ? t : tExit);
+      if(fRayZ >= m_arrHMapMaxMips[nLevel-1][nX][nY])
+      { // above everything in this cell - skip it and try bigger cells
+        t = tExit;
+        if(nLevel < m_nHMapMaxMips)
+          nLevel++;
+      }
+      else
+        nLevel--;
+    }
+    else
+    { // single quad, ray and surface are (almost) linear here - test ends of the segment
+      Vec3d vPos0 = vStartPoint + vDir*t;
+      Vec3d vPos1 = vStartPoint + vDir*tExit;
+      if( vPos0.z < GetHMapLowerBound(nX, nY, vPos0.x, vPos0.y) ||
+          vPos1.z < GetHMapLowerBound(nX, nY, vPos1.x, vPos1.y) )
+        return true;
+
+      t = tExit;
+      nLevel++;
+    }
+  }
+
+  return false;
+}
+
 bool CHighMap::IsPointOccludedByTerrain(const Vec3d & _vPoint, float fDist, const Vec3d & vCamPos, int nMaxTestsToScip)
 {
 	FUNCTION_PROFILER_FAST( GetSystem(),PROFILE_3DENGINE,m_bProfilerEnabled );
@@ -128,9 +260,85 @@ bool CHighMap::IsPointOccludedByTerrain(const Vec3d & _vPoint, float fDist, cons
   if( vCamPos.x<0 || vCamPos.y<0 || vCamPos.x>CTerrain::GetTerrainSize() || vCamPos.y>CTerrain::GetTerrainSize() )
     return false;
 
+  if(m_lstOcclQueries.Count() < m_nOcclQueriesToRecord)
+  { // record for benchmark
+    STerrainOcclQuery q;
+    q.vStart = vCamPos;
+    q.vStop = _vPoint;
+    q.fDist = fDist;
+    q.nMaxTestsToScip = nMaxTestsToScip;
+    m_lstOcclQueries.Add(q);
+  }
+
   return IntersectWithSector(vCamPos, _vPoint, fDist, nMaxTestsToScip);
 }
 
+void CHighMap::UpdateOcclusionBenchmark(int nQueries)
+{
+  if(nQueries<=0)
+  {
+    if(m_nOcclQueriesToRecord)
+    {
+      m_nOcclQueriesToRecord = 0;
+      m_lstOcclQueries.Reset();
+    }
+    return;
+  }
+
+  m_nOcclQueriesToRecord = nQueries;
+  if(m_lstOcclQueries.Count() < nQueries)
+    return; // still recording
+
+  // replay recorded queries with both methods
+  const int nRepeat = 10;
+  int nCount = m_lstOcclQueries.Count();
+  list2<uchar> lstResults;
+  lstResults.PreAllocate(nCount,nCount);
+
+  int nOccludedSteps=0, nOccludedHier=0, nOnlySteps=0, nOnlyHier=0;
+
+  m_nOcclSamples = 0;
+  float fStart = GetTimer()->GetAsyncCurTime();
+  for(int r=0; r<nRepeat; r++)
+  for(int i=0; i<nCount; i++)
+  {
+    STerrainOcclQuery & q = m_lstOcclQueries[i];
+    lstResults[i] = IntersectWithSectorSteps(q.vStart, q.vStop, q.fDist, q.nMaxTestsToScip);
+  }
+  float fTimeSteps = GetTimer()->GetAsyncCurTime() - fStart;
+  int nSamplesSteps = m_nOcclSamples;
+
+  m_nOcclSamples = 0;
+  fStart = GetTimer()->GetAsyncCurTime();
+  for(int r=0; r<nRepeat; r++)
+  for(int i=0; i<nCount; i++)
+  {
+    STerrainOcclQuery & q = m_lstOcclQueries[i];
+    bool bOccluded = IntersectWithSector(q.vStart, q.vStop, q.fDist, q.nMaxTestsToScip);
+    if(r)
+      continue;
+
+    nOccludedHier += bOccluded;
+    nOccludedSteps += lstResults[i];
+    if(bOccluded && !lstResults[i])
+      nOnlyHier++;
+    if(!bOccluded && lstResults[i])
+      nOnlySteps++;
+  }
+  float fTimeHier = GetTimer()->GetAsyncCurTime() - fStart;
+  int nSamplesHier = m_nOcclSamples;
+
+  GetLog()->Log("Terrain occlusion benchmark: %d recorded queries, %d mip levels", nCount, m_nHMapMaxMips);
+  GetLog()->Log("  steps:   %6.3f us/query, %5.1f samples/query, %d occluded (%d only by steps)", 
+    fTimeSteps*1000000.f/(nCount*nRepeat), (float)nSamplesSteps/(nCount*nRepeat), nOccludedSteps, nOnlySteps);
+  GetLog()->Log("  pyramid: %6.3f us/query, %5.1f samples/query, %d occluded (%d only by pyramid)", 
+    fTimeHier*1000000.f/(nCount*nRepeat), (float)nSamplesHier/(nCount*nRepeat), nOccludedHier, nOnlyHier);
+
+  m_nOcclQueriesToRecord = 0;
+  m_lstOcclQueries.Reset();
+  GetCVars()->e_terrain_occlusion_culling_bench = 0;
+}
+
 #ifdef WIN64
 #pragma warning( push )									//AMD Port
 #pragma warning( disable : 4267 )
@@ -179,6 +387,12 @@ bool CHighMap::LoadHighMap(const char* file_name, ICryPak * pCryPak)
 
   delete [] pTmpBuff;
 
+  // max height pyramid
+  m_nHMapMaxMips = 0;
+  for(int nCells = CTerrain::GetTerrainSize()/CTerrain::GetHeightMapUnitSize()/2; nCells>=1 && m_nHMapMaxMips<HMAP_MAX_MIPS; nCells/=2)
+    m_arrHMapMaxMips[m_nHMapMaxMips++].Allocate(nCells);
+  UpdateHMapMaxMips(0, 0, CTerrain::GetTerrainSize(), CTerrain::GetTerrainSize());
+
   m_bHightMapModified = false;
 
   return f!=0;
@@ -188,6 +402,45 @@ bool CHighMap::LoadHighMap(const char* file_name, ICryPak * pCryPak)
 #pragma warning( pop )									//AMD Port
 #endif
 
+void CHighMap::UpdateHMapMaxMips(int x1, int y1, int x2, int y2)
+{
+  // modified hmap points
+  int nHMapSize = m_arrusHightMapData.m_nSize-1;
+  x1 = max(0, x1/CTerrain::GetHeightMapUnitSize());
+  y1 = max(0, y1/CTerrain::GetHeightMapUnitSize());
+  x2 = min(nHMapSize, x2/CTerrain::GetHeightMapUnitSize());
+  y2 = min(nHMapSize, y2/CTerrain::GetHeightMapUnitSize());
+
+  for(int nLevel=1; nLevel<=m_nHMapMaxMips; nLevel++)
+  {
+    Array2d<unsigned short> & arrMip = m_arrHMapMaxMips[nLevel-1];
+
+    // cells containing modified points, border points belong to 2 cells
+    int cx1 = max(0, (x1>>nLevel)-1);
+    int cy1 = max(0, (y1>>nLevel)-1);
+    int cx2 = min(arrMip.m_nSize-1, x2>>nLevel);
+    int cy2 = min(arrMip.m_nSize-1, y2>>nLevel);
+
+    for(int cx=cx1; cx<=cx2; cx++)
+    for(int cy=cy1; cy<=cy2; cy++)
+    {
+      unsigned short nMax = 0;
+      if(nLevel==1)
+      { // 3x3 hmap points
+        for(int x=cx*2; x<=cx*2+2 && x<=nHMapSize; x++)
+        for(int y=cy*2; y<=cy*2+2 && y<=nHMapSize; y++)
+          nMax = max(nMax, (unsigned short)(m_arrusHightMapData[x][y] & (~INFO_BITS_MASK)));
+      }
+      else
+      { // 2x2 cells of previous level
+        Array2d<unsigned short> & arrPrev = m_arrHMapMaxMips[nLevel-2];
+        nMax = max(max(arrPrev[cx*2][cy*2], arrPrev[cx*2+1][cy*2]), max(arrPrev[cx*2][cy*2+1], arrPrev[cx*2+1][cy*2+1]));
+      }
+      arrMip[cx][cy] = nMax;
+    }
+  }
+}
+
 bool CHighMap::GetHoleSafe(const int & x, const int & y) 
 {
   if(x>=0 && y>=0 && x<CTerrain::GetTerrainSize() && y<CTerrain::GetTerrainSize())
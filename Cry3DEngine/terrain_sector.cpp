@@ -17,6 +17,7 @@
 #include "terrain_sector.h"
 #include "terrain.h"
 #include "objman.h"
+#include "VegetationSoA.h"
 
 CSectorInfo::CSectorInfo(CTerrain * pTerrain) 
 { 
@@ -336,5 +337,8 @@ void CSectorInfo::GetMemoryUsage(ICrySizer*pSizer)
   for(int i=0; i<m_lstEntities[nStatic].Count(); i++)
     nSize += m_lstEntities[nStatic][i]->GetMemoryUsage();
 
+  if(m_pVegetSoA)
+    nSize += m_pVegetSoA->GetMemoryUsage();
+
   pSizer->AddObject(this,sizeof(*this)+nSize);
 }
@@ -226,6 +226,9 @@ void CTerrain::SetTerainHightMapBlock(int x1, int y1, int nSizeX, int nSizeY, us
     info->m_vBoxMax.z = max(info->m_vBoxMax.z, fElev);*/
   }
 
+  UpdateHMapMaxMips(x1*CTerrain::GetHeightMapUnitSize(), y1*CTerrain::GetHeightMapUnitSize(), 
+    (x1+nSizeX)*CTerrain::GetHeightMapUnitSize(), (y1+nSizeY)*CTerrain::GetHeightMapUnitSize());
+
   // update detail texture and grass
   m_nDetailTexFocusX=m_nDetailTexFocusY=-CTerrain::GetTerrainSize();
   if(m_pDetailObjects)
@@ -0,0 +1,336 @@
+// AStarSearch.cpp: implementation of the CAStarSearch class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AStarSearch.h"
+#include "Heuristic.h"
+
+#include <algorithm>
+
+#if defined(WIN32) && defined(_DEBUG)
+#include <crtdbg.h>
+#define DEBUG_NEW_NORMAL_CLIENTBLOCK(file, line) new(_NORMAL_BLOCK, file, line)
+#define new DEBUG_NEW_NORMAL_CLIENTBLOCK( __FILE__, __LINE__)
+#endif
+
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CAStarSearch::CAStarSearch()
+{
+	m_nCurrentHistory = 0;
+	m_fDistance = 1.f;
+	m_vRealEnd(0,0,0);
+	m_fPassRadius = 0;
+	m_vRequesterPos(0,0,0);
+	m_vRequesterAngles(0,0,0);
+	m_pHeuristic = 0;
+	m_pVisited = 0;
+	m_pcsAlloc = 0;
+
+	m_vStates.resize(256);
+	m_vStateCandidates.resize(256);
+	for (int i=0;i<(int)m_vStates.size();i++)
+		m_vStates[i].nStamp = 0;
+	m_nStates = 0;
+	m_nStamp = 1;
+
+	m_Candidates.m_vCandidates.reserve(1000);
+	m_Candidates.m_piCandidate = &m_vStateCandidates[0];
+	m_nCandidateOrder = 0;
+	m_nAStarDistance = 0;
+
+	m_pBegin = m_pEnd = m_pCurrent = m_pWalkBackCurrent = 0;
+}
+
+void CAStarSearch::Begin(GraphNode *pBegin, GraphNode *pEnd, const Vec3d &vRealEnd, float fDistance, float fPassRadius,
+												 CHeuristic *pHeuristic, const Vec3d &vRequesterPos, const Vec3d &vRequesterAngles)
+{
+	m_pBegin = m_pCurrent = pBegin;
+	m_pEnd = pEnd;
+	m_pWalkBackCurrent = 0;
+	m_vRealEnd = vRealEnd;
+	m_fDistance = fDistance;
+	m_fPassRadius = fPassRadius;
+	m_pHeuristic = pHeuristic;
+	m_vRequesterPos = vRequesterPos;
+	m_vRequesterAngles = vRequesterAngles;
+
+	m_nCurrentHistory = 0;
+	m_nAStarDistance = 0;
+	m_Candidates.m_vCandidates.clear();
+	m_nCandidateOrder = 0;
+
+	m_nStates = 0;
+	if (++m_nStamp == 0)
+	{
+		for (int i=0;i<(int)m_vStates.size();i++)
+			m_vStates[i].nStamp = 0;
+		m_nStamp = 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// node table
+//////////////////////////////////////////////////////////////////////
+
+int CAStarSearch::FindState(const GraphNode *pNode) const
+{
+	int nMask = m_vStates.size()-1;
+	int i = (int)((UINT_PTR)pNode>>4 ^ (UINT_PTR)pNode>>12) & nMask;
+	while (m_vStates[i].nStamp==m_nStamp && m_vStates[i].pNode!=pNode)
+		i = (i+1) & nMask;
+	return i;
+}
+
+int CAStarSearch::GetState(GraphNode *pNode)
+{
+	int i = FindState(pNode);
+	if (m_vStates[i].nStamp == m_nStamp)
+		return i;
+
+	if ((m_nStates+1)*2 > (int)m_vStates.size())
+	{
+		GrowStates();
+		i = FindState(pNode);
+	}
+	NodeState &state = m_vStates[i];
+	state.pNode = pNode;
+	state.nStamp = m_nStamp;
+	state.bTagged = false;
+	m_vStateCandidates[i] = -1;
+	state.fHeuristic = -9999.f;
+	state.fDistance = 0;
+	m_nStates++;
+	return i;
+}
+
+void CAStarSearch::GrowStates()
+{
+	if (m_pcsAlloc)
+		EnterCriticalSection(m_pcsAlloc);
+	std::vector<NodeState> vOld;
+	std::vector<int> vOldCandidates;
+	vOld.swap(m_vStates);
+	vOldCandidates.swap(m_vStateCandidates);
+	m_vStates.resize(vOld.size()*2);
+	m_vStateCandidates.resize(vOld.size()*2);
+	for (int i=0;i<(int)m_vStates.size();i++)
+		m_vStates[i].nStamp = 0;
+
+	for (int i=0;i<(int)vOld.size();i++)
+		if (vOld[i].nStamp == m_nStamp)
+		{
+			int j = FindState(vOld[i].pNode);
+			m_vStates[j] = vOld[i];
+			m_vStateCandidates[j] = vOldCandidates[i];
+			if (vOldCandidates[i] >= 0)
+				m_Candidates.m_vCandidates[vOldCandidates[i]].iState = j;
+		}
+	m_Candidates.m_piCandidate = &m_vStateCandidates[0];
+	// free the old tables while still holding the lock
+	std::vector<NodeState>().swap(vOld);
+	std::vector<int>().swap(vOldCandidates);
+	if (m_pcsAlloc)
+		LeaveCriticalSection(m_pcsAlloc);
+}
+
+bool CAStarSearch::IsTagged(const GraphNode *pNode) const
+{
+	const NodeState &state = m_vStates[FindState(pNode)];
+	return state.nStamp==m_nStamp && state.bTagged;
+}
+
+float CAStarSearch::GetNodeHeuristic(const GraphNode *pNode) const
+{
+	const NodeState &state = m_vStates[FindState(pNode)];
+	return state.nStamp==m_nStamp && state.bTagged ? state.fHeuristic : -9999.f;
+}
+
+float CAStarSearch::GetNodeDistance(const GraphNode *pNode) const
+{
+	const NodeState &state = m_vStates[FindState(pNode)];
+	return state.nStamp==m_nStamp ? state.fDistance : 0;
+}
+
+void CAStarSearch::SetNodeDistance(GraphNode *pNode, float fDistance)
+{
+	m_vStates[GetState(pNode)].fDistance = fDistance;
+}
+
+//////////////////////////////////////////////////////////////////////
+// search
+//////////////////////////////////////////////////////////////////////
+
+int CAStarSearch::Continue(int &nIterations)
+{
+	m_pCurrent = Step(m_pCurrent);
+	while (m_pCurrent && !m_Candidates.m_vCandidates.empty() && (m_pCurrent != m_pEnd) && (nIterations--))
+		m_pCurrent = Step(m_pCurrent);
+
+	if (!m_pCurrent)
+		return PATHFINDER_NOPATH;
+	if (m_pCurrent == m_pEnd)
+		return PATHFINDER_WALKINGBACK;
+
+	return PATHFINDER_STILLTRACING;
+}
+
+GraphNode * CAStarSearch::Step(GraphNode *pBegin)
+{
+	NodeState &state = m_vStates[GetState(pBegin)];
+	state.bTagged = true;
+	state.fHeuristic = 10000 - (float)m_nAStarDistance;
+	if (pBegin == m_pEnd)
+		return m_pEnd; // reached the end
+	m_nAStarDistance++;
+
+	VectorOfLinks::iterator vi;
+	for (vi=pBegin->link.begin();vi!=pBegin->link.end();vi++)
+	{
+		if ((*vi).fMaxRadius >= m_fPassRadius)
+			EvaluateNode( (*vi).pLink, pBegin);
+	}
+
+	if (m_Candidates.m_vCandidates.empty())
+		return 0;
+
+	const AStarCandidate &best = m_Candidates.m_vCandidates[0];
+	GraphNode *pNextNode = best.pNode;
+	float f = best.fDesirability;
+	m_pCurrentHistory[0] = best.pHistory[0];
+	m_pCurrentHistory[1] = best.pHistory[1];
+	m_nCurrentHistory = best.nHistory;
+	m_Candidates.PopCandidate();
+	if (m_pVisited)
+	 m_pVisited->insert(CandidateMap::iterator::value_type(f,pNextNode));
+	return pNextNode;
+}
+
+void CAStarSearch::EvaluateNode(GraphNode *pNode, GraphNode *pParent)
+{
+	if (!pNode) return;
+	if (IsTagged(pNode)) return;
+	float desirability=0;
+	float thisdist = (pNode->data.m_pos - m_vRealEnd).GetLength();
+
+	desirability = 1.f - (thisdist / m_fDistance) * 0.5f;
+	desirability += m_pHeuristic->Estimate(pNode, this) * 0.5f;
+
+	// the history a candidate sees is at most two nodes long
+	if (m_nCurrentHistory > 1)
+		m_nCurrentHistory--;
+	m_pCurrentHistory[1] = m_pCurrentHistory[0];
+	m_pCurrentHistory[0] = pParent;
+	m_nCurrentHistory++;
+
+	// a node is queued once, with the best of its evaluations; this pops nodes in the same order as
+	// keeping every evaluation and skipping the stale ones
+	std::vector<AStarCandidate> &vCandidates = m_Candidates.m_vCandidates;
+	int iState = GetState(pNode);
+	int i = m_vStateCandidates[iState], nOrder = m_nCandidateOrder++;
+	if (i < 0)
+	{
+		i = vCandidates.size();
+		if (m_pcsAlloc && i == (int)vCandidates.capacity())
+		{
+			EnterCriticalSection(m_pcsAlloc);
+			vCandidates.reserve(i*2);
+			LeaveCriticalSection(m_pcsAlloc);
+		}
+		vCandidates.resize(i+1);
+	}
+	else if (desirability < vCandidates[i].fDesirability)
+		return;
+
+	AStarCandidate &cand = vCandidates[i];
+	cand.pNode = pNode;
+	cand.iState = iState;
+	cand.fDesirability = desirability;
+	cand.nOrder = nOrder;
+	cand.pHistory[0] = m_pCurrentHistory[0];
+	cand.pHistory[1] = m_pCurrentHistory[1];
+	cand.nHistory = m_nCurrentHistory;
+	m_Candidates.SiftCandidateUp(i);
+}
+
+int CAStarSearch::WalkBack(GraphNode *pBegin, GraphNode *pEnd, int &nIterations, ListNodes &lstNodeStack, ListPositions &lstPath)
+{
+	if (!m_pWalkBackCurrent)
+	{
+		lstNodeStack.clear();
+		lstPath.clear();
+		m_pWalkBackCurrent = pBegin;
+	}
+
+	while (m_pWalkBackCurrent!=pEnd && --nIterations)
+	{
+		lstPath.push_front(m_pWalkBackCurrent->data.m_pos);		// push in path
+		lstNodeStack.push_front(m_pWalkBackCurrent);						// push in nodestack
+
+		GraphNode *pNext = 0;
+		float maxheur = GetNodeHeuristic(m_pWalkBackCurrent);
+		VectorOfLinks::iterator vi;
+		for (vi=m_pWalkBackCurrent->link.begin(); vi!=m_pWalkBackCurrent->link.end(); vi++)
+		{
+			GraphNode *pLink = (*vi).pLink;
+			if (GetNodeHeuristic(pLink) > maxheur && (*vi).fMaxRadius>=1.f)
+			{
+				maxheur = GetNodeHeuristic(pLink);
+				pNext = pLink;
+			}
+		}
+
+		m_vStates[GetState(m_pWalkBackCurrent)].fHeuristic = -9999.f;
+
+		if (pNext)
+			m_pWalkBackCurrent = pNext;
+		else
+		{
+			// dead end hit... retrace
+			// try to continue moving with a revised heuristic
+			for (vi=m_pWalkBackCurrent->link.begin(); vi!=m_pWalkBackCurrent->link.end(); vi++)
+			{
+				GraphNode *pLink = (*vi).pLink;
+				if (GetNodeHeuristic(pLink) > GetNodeHeuristic(m_pWalkBackCurrent))
+				{
+					maxheur = GetNodeHeuristic(pLink);
+					pNext = pLink;
+				}
+			}
+
+			if (pNext)
+				m_pWalkBackCurrent = pNext;
+			else
+			{
+				if (!lstPath.empty())
+					lstPath.pop_front();
+				if (!lstNodeStack.empty())
+					lstNodeStack.pop_front();
+				if (lstNodeStack.empty())
+					return PATHFINDER_NOPATH;
+				m_pWalkBackCurrent = lstNodeStack.front();
+				if (!lstNodeStack.empty())
+					lstNodeStack.pop_front();
+				if (!lstPath.empty())
+					lstPath.pop_front();
+			}
+		}
+	}
+
+	if (m_pWalkBackCurrent == pEnd)
+	{
+		m_pWalkBackCurrent = 0;
+		if (std::find(lstNodeStack.begin(),lstNodeStack.end(),pEnd)==lstNodeStack.end())
+		{
+			lstNodeStack.push_front(pEnd);
+			lstPath.push_front(pEnd->data.m_pos);
+		}
+		return PATHFINDER_BEAUTIFYINGPATH;
+	}
+	else
+		return PATHFINDER_WALKINGBACK;
+}
@@ -0,0 +1,82 @@
+// AStarSearch.h: interface for the CAStarSearch class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_ASTARSEARCH_H__3B9A1F62_7C41_4E0B_9D57_2A6F4C1E8B03__INCLUDED_)
+#define AFX_ASTARSEARCH_H__3B9A1F62_7C41_4E0B_9D57_2A6F4C1E8B03__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include "Graph.h"
+
+class CHeuristic;
+
+// State of one path search. Everything the search writes is kept here rather than in the
+// GraphNodes, so searches with separate CAStarSearch objects can run at the same time
+// as long as the graph itself is not changed under them.
+class CAStarSearch
+{
+public:
+	CAStarSearch();
+
+	void Begin(GraphNode *pBegin, GraphNode *pEnd, const Vec3d &vRealEnd, float fDistance, float fPassRadius,
+		CHeuristic *pHeuristic, const Vec3d &vRequesterPos, const Vec3d &vRequesterAngles);
+	// returns PATHFINDER_STILLTRACING, PATHFINDER_WALKINGBACK or PATHFINDER_NOPATH
+	int Continue(int &nIterations);
+	// returns PATHFINDER_WALKINGBACK, PATHFINDER_BEAUTIFYINGPATH or PATHFINDER_NOPATH
+	int WalkBack(GraphNode *pBegin, GraphNode *pEnd, int &nIterations, ListNodes &lstNodeStack, ListPositions &lstPath);
+	void ResetWalkBack() { m_pWalkBackCurrent = 0; }
+	GraphNode *GetCurrent() const { return m_pCurrent; }
+
+	// node state of this search, used by the heuristics
+	bool IsTagged(const GraphNode *pNode) const;
+	float GetNodeHeuristic(const GraphNode *pNode) const;
+	float GetNodeDistance(const GraphNode *pNode) const;
+	void SetNodeDistance(GraphNode *pNode, float fDistance);
+
+	GraphNode *m_pCurrentHistory[2];	// parent and grandparent of the node being expanded
+	int m_nCurrentHistory;
+	float m_fDistance;
+	Vec3d m_vRealEnd;
+	float m_fPassRadius;
+	Vec3d m_vRequesterPos;
+	Vec3d m_vRequesterAngles;
+	CHeuristic *m_pHeuristic;
+	CandidateMap *m_pVisited;		// debug list of expanded nodes, set only for searches on the main thread
+	CRITICAL_SECTION *m_pcsAlloc;	// set for searches on worker threads, guards buffer growth
+
+protected:
+	typedef struct NodeState
+	{
+		GraphNode *pNode;
+		unsigned int nStamp;
+		bool bTagged;
+		float fHeuristic;
+		float fDistance;
+	} NodeState;
+
+	int FindState(const GraphNode *pNode) const;
+	int GetState(GraphNode *pNode);
+	void GrowStates();
+
+	GraphNode *Step(GraphNode *pBegin);
+	void EvaluateNode(GraphNode *pNode, GraphNode *pParent);
+
+	std::vector<NodeState> m_vStates;	// open addressing table, at most half full
+	std::vector<int> m_vStateCandidates;	// heap position of the candidate of each slot, valid for used slots
+	int m_nStates;
+	unsigned int m_nStamp;						// slots with an older stamp are free, so a new search clears the table at once
+
+	CCandidateHeap m_Candidates;			// binary max-heap on desirability
+	int m_nCandidateOrder;
+	int m_nAStarDistance;
+
+	GraphNode *m_pBegin;
+	GraphNode *m_pEnd;
+	GraphNode *m_pCurrent;
+	GraphNode *m_pWalkBackCurrent;
+};
+
+#endif // !defined(AFX_ASTARSEARCH_H__3B9A1F62_7C41_4E0B_9D57_2A6F4C1E8B03__INCLUDED_)
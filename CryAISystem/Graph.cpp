@@ -5,6 +5,8 @@
 #include "stdafx.h"
 #include "Graph.h"
 #include "Heuristic.h"
+#include "AStarSearch.h"
+#include "PathService.h"
 #include "CAISystem.h"
 
 
@@ -26,6 +28,7 @@
 #include "AIObject.h"
 #include "VertexList.h"
 #include <CryFile.h>
+#include <ITimer.h>
 
 #if defined(WIN32) && defined(_DEBUG) 
 #include <crtdbg.h> 
@@ -52,17 +55,24 @@ CGraph::CGraph(CAISystem *pSystem)
 	m_pHeuristic = 0;
 	m_nTagged = 0;
 	m_pPathBegin = 0;
-	m_pPathfinderCurrent = 0;
-	m_pWalkBackCurrent = 0;
 	m_bBeautifying = true;
 
 	m_pAISystem = pSystem;
-	m_lstTagTracker.reserve(1000);
+	m_nTagStamp = 1;
+	m_nVersion = 0;
+	m_pSearch = new CAStarSearch;
+	m_pPathService = new CPathService(this,pSystem);
+	m_cvRecordPathQueries = 0;
+	m_cvBenchmarkPathQueries = 0;
+	m_bReplayingQueries = false;
 	m_lstMarkTracker.reserve(1000);
 }
 
 CGraph::~CGraph()
 {
+	RecordPathQueries(0);
+	delete m_pPathService;
+	delete m_pSearch;
 	m_vNodes.clear();
 	DeleteGraph(m_pSafeFirst,0);
 	char str[255];
@@ -534,15 +544,24 @@ void CGraph::DEBUG_DrawCenters(GraphNode *pNode, IRenderer *pRenderer, int dist)
 
 int CGraph::WalkAStar(GraphNode *pBegin, GraphNode *pEnd, int &nIterations)
 {
-		m_lstCurrentHistory.clear();
 		ClearPath();	// clear the previously generated path
 	//	m_lstVisited.clear();
-		if (!ClearTags())	// clear all the tags in the diagram
-			return PATHFINDER_CLEANING_GRAPH;
 			
 
 		if ((!pBegin) || (!pEnd)) return PATHFINDER_NOPATH;
 
+		if (!m_bReplayingQueries)
+			CheckPathQueryCommands();
+		if (!m_sRecordFile.empty() && !m_bReplayingQueries)
+		{
+			PathQueryRecord rec;
+			rec.vBegin = pBegin->data.m_pos;
+			rec.vEnd = pEnd->data.m_pos;
+			rec.vRealEnd = m_vRealPathfinderEnd;
+			rec.fDistance = m_fDistance;
+			m_vRecordedQueries.push_back(rec);
+		}
+
 		// lets check if last generated path was similar to this one
 		if (!m_lstLastPath.empty())
 		{
@@ -554,132 +573,72 @@ int CGraph::WalkAStar(GraphNode *pBegin, GraphNode *pEnd, int &nIterations)
 		}
 
 	
-		m_pPathfinderCurrent = pBegin;
 		m_pPathBegin = pBegin;
 
-		m_nAStarDistance = 0;
-		m_pPathfinderCurrent->fDistance = 0;
-
 		//m_fDistance = (pBegin->data.m_pos - pEnd->data.m_pos).GetLength();
-		m_mapCandidates.clear();
-		m_pPathfinderCurrent = ASTARStep(pBegin, pEnd);
-		while (m_pPathfinderCurrent && !m_mapCandidates.empty() && (m_pPathfinderCurrent != pEnd) && (nIterations--))
-			m_pPathfinderCurrent = ASTARStep(m_pPathfinderCurrent, pEnd);
-
-		if (!m_pPathfinderCurrent)
-			return PATHFINDER_NOPATH;
-		if (m_pPathfinderCurrent == pEnd)
-			return PATHFINDER_WALKINGBACK;
-
-		return PATHFINDER_STILLTRACING;
-
-}
-
-GraphNode * CGraph::ASTARStep(GraphNode *pBegin, GraphNode *pEnd)
-{
-	TagNode(pBegin);
-	if (pEnd == pBegin) 
-	{
-		pEnd->fHeuristic = 10000 - (float)m_nAStarDistance;
-		return pEnd; // reached the end
-	}
-
-		// this piece evaluates simple distance heuristic for backtracking----------
-	///float thisdist = (pBegin->data.m_pos - m_pPathBegin->data.m_pos).GetLength();
-	//pBegin->fHeuristic =  1.f - (thisdist / m_fDistance);
-	//--------------------------------------------------------------------------
-	pBegin->fHeuristic = 10000 - (float)m_nAStarDistance;
-	m_nAStarDistance++;
-
-	VectorOfLinks::iterator vi;
-	for (vi=pBegin->link.begin();vi!=pBegin->link.end();vi++)
-	{
-//		if ((*vi).fMaxRadius >= 1.f)
-		if ((*vi).fMaxRadius >= m_pRequester->m_fPassRadius)
-		{
-				EvaluateNode( (*vi).pLink, pEnd, pBegin);
-		}
-	}
-
-
-
-	 
-	if (!m_mapCandidates.empty())
-	{
-		CandidateHistoryMap::reverse_iterator ci = m_mapCandidates.rbegin();
-
-		GraphNode *pNextNode = 0;
-		if (ci!=m_mapCandidates.rend())
-		{
-			pNextNode = (ci->second).pNode;
-			
-			while ((pNextNode == pBegin)||(pNextNode->tag))
-			{
-				m_mapCandidates.erase((++ci).base());
-				ci = m_mapCandidates.rbegin();
-				if (ci==m_mapCandidates.rend())
-					break;
-				pNextNode = (ci->second).pNode;
-			}
-		}
-
-		if (ci==m_mapCandidates.rend())
-			return 0;
-
-		m_lstCurrentHistory = (ci->second).lstParents;
-		float f = ci->first;
-		m_mapCandidates.erase((++ci).base());
-		if (GetAISystem()->m_cvDrawPath->GetIVal()==2) 
-		 m_lstVisited.insert(CandidateMap::iterator::value_type(f,pNextNode));
-		return pNextNode;
-	}
-	else
-		return 0;
+		m_pSearch->Begin(pBegin,pEnd,m_vRealPathfinderEnd,m_fDistance,m_pRequester->m_fPassRadius,m_pHeuristic,
+			m_pRequester->GetPos(),m_pRequester->GetAngles());
+		m_pSearch->m_pVisited = GetAISystem()->m_cvDrawPath->GetIVal()==2 ? &m_lstVisited : 0;
+		return m_pSearch->Continue(nIterations);
 
 }
 
 void CGraph::TagNode(GraphNode *pNode)
 {
-	pNode->tag = true;
-	m_lstTagTracker.push_back(pNode);
+	pNode->nTag = m_nTagStamp;
 }
 
 bool CGraph::ClearTags()
 {
+	// a new generation untags every node at once; after a wraparound nodes untouched for 2^32 generations
+	// could read as tagged, which is not a practical concern
+	if (++m_nTagStamp == 0)
+		m_nTagStamp = 1;
+	return true;
+}
 
-	int nIterations = PATHFINDER_ITERATIONS;
+// candidate a goes before b if it is more desirable; equal ones go latest first, like the rbegin of a multimap
+static inline bool CandidateBefore(const AStarCandidate &a, const AStarCandidate &b)
+{
+	return a.fDesirability > b.fDesirability || a.fDesirability == b.fDesirability && a.nOrder > b.nOrder;
+}
 
-	while (!m_lstTagTracker.empty() && (nIterations--))
+void CCandidateHeap::SiftCandidateUp(int i)
+{
+	AStarCandidate cand = m_vCandidates[i];
+	for(int iParent; i>0 && CandidateBefore(cand, m_vCandidates[iParent=(i-1)>>1]); i=iParent)
 	{
-		GraphNode *pLastNode = m_lstTagTracker.back();
-		pLastNode->tag = false;
-		pLastNode->fHeuristic = -9999.f;
-		m_lstTagTracker.pop_back();
+		m_vCandidates[i] = m_vCandidates[iParent];
+		m_piCandidate[m_vCandidates[i].iState] = i;
 	}
-		
-	if (!m_lstTagTracker.empty()) 
-		return false; // we are still cleaning up
-
-	return true;
+	m_vCandidates[i] = cand;
+	m_piCandidate[cand.iState] = i;
 }
 
-void CGraph::EvaluateNode(GraphNode *pNode,GraphNode *pEnd, GraphNode *pParent)
+void CCandidateHeap::SiftCandidateDown(int i)
 {
-	if (!pNode) return;
-	if (pNode->tag) return;
-	float desirability=0;
-	float thisdist = (pNode->data.m_pos - m_vRealPathfinderEnd).GetLength();
-
-	desirability = 1.f - (thisdist / m_fDistance) * 0.5f;
-	desirability += m_pHeuristic->Estimate(pNode, this) * 0.5f;
+	int nCandidates = m_vCandidates.size();
+	AStarCandidate cand = m_vCandidates[i];
+	for(int iChild; (iChild=i*2+1) < nCandidates; i=iChild)
+	{
+		if (iChild+1 < nCandidates && CandidateBefore(m_vCandidates[iChild+1], m_vCandidates[iChild]))
+			iChild++;
+		if (!CandidateBefore(m_vCandidates[iChild], cand))
+			break;
+		m_vCandidates[i] = m_vCandidates[iChild];
+		m_piCandidate[m_vCandidates[i].iState] = i;
+	}
+	m_vCandidates[i] = cand;
+	m_piCandidate[cand.iState] = i;
+}
 
-	NodeWithHistory nwh;
-	nwh.pNode = pNode;
-	if (m_lstCurrentHistory.size() > 1	)
-		m_lstCurrentHistory.pop_back();
-	m_lstCurrentHistory.push_front(pParent);
-	nwh.lstParents = m_lstCurrentHistory;
-	m_mapCandidates.insert(CandidateHistoryMap::iterator::value_type(desirability,nwh));
+void CCandidateHeap::PopCandidate()
+{
+	m_piCandidate[m_vCandidates[0].iState] = -1;
+	m_vCandidates[0] = m_vCandidates.back();
+	m_vCandidates.pop_back();
+	if (!m_vCandidates.empty())
+		SiftCandidateDown(0);
 }
 
 int CGraph::ContinueAStar(GraphNode *pEnd, int &nIterations)
@@ -689,106 +648,45 @@ int CGraph::ContinueAStar(GraphNode *pEnd, int &nIterations)
 
 		//int nIterations = PATHFINDER_ITERATIONS;
 
-		m_pPathfinderCurrent = ASTARStep(m_pPathfinderCurrent, pEnd);
-		while (!m_mapCandidates.empty() && (m_pPathfinderCurrent != pEnd) && (nIterations--))
-			m_pPathfinderCurrent = ASTARStep(m_pPathfinderCurrent, pEnd);
-
-		if (!m_pPathfinderCurrent)
-			return PATHFINDER_NOPATH;
-		if (m_pPathfinderCurrent == pEnd)
-			return PATHFINDER_WALKINGBACK;
-
-	  return PATHFINDER_STILLTRACING;
+		return m_pSearch->Continue(nIterations);
 }
 
 int CGraph::WalkBack(GraphNode *pBegin, GraphNode *pEnd, int &nIterations)
 {
-	//int nIterations = PATHFINDER_ITERATIONS;
-	//GraphNode *pCurrent;
-	if (!m_pWalkBackCurrent)
-	{
-		m_lstNodeStack.clear();
-		m_lstPath.clear();
-		m_pWalkBackCurrent = pBegin;
-	}
-	//else
-		//m_pWalkBackCurrent = m_pWalkBackCurrent;
-	
-	float maxHeur = m_pWalkBackCurrent->fHeuristic;
-	while (m_pWalkBackCurrent!=pEnd && --nIterations)
-	{
-		m_lstPath.push_front(m_pWalkBackCurrent->data.m_pos);		// push in path
-		m_lstNodeStack.push_front(m_pWalkBackCurrent);						// push in nodestack
-		
-		GraphNode *pNext = 0;
-		float maxheur = m_pWalkBackCurrent->fHeuristic;
-		VectorOfLinks::iterator vi;
-		for (vi=m_pWalkBackCurrent->link.begin(); vi!=m_pWalkBackCurrent->link.end(); vi++)
-		{
-			GraphNode *pLink = (*vi).pLink;
-			if (pLink->fHeuristic > maxheur && (*vi).fMaxRadius>=1.f)
-			{
-				maxheur = pLink->fHeuristic;
-				pNext = pLink;
-			}
-		}
-
-		m_pWalkBackCurrent->fHeuristic = -9999.f;
-		
-		if (pNext)
-			m_pWalkBackCurrent = pNext;
-		else
-		{
-			// dead end hit... retrace
-			// try to continue moving with a revised heuristic
-			for (vi=m_pWalkBackCurrent->link.begin(); vi!=m_pWalkBackCurrent->link.end(); vi++)
-			{
-				GraphNode *pLink = (*vi).pLink;
-				if (pLink->fHeuristic > m_pWalkBackCurrent->fHeuristic)
-				{
-					maxheur = pLink->fHeuristic;
-					pNext = pLink;
-				}
-			}
-
-			if (pNext)
-				m_pWalkBackCurrent = pNext;
-			else
-			{
-				if (!m_lstPath.empty())
-					m_lstPath.pop_front();
-				if (!m_lstNodeStack.empty())
-					m_lstNodeStack.pop_front();
-				if (m_lstNodeStack.empty())
-					return PATHFINDER_NOPATH;;
-				m_pWalkBackCurrent = m_lstNodeStack.front();
-				if (!m_lstNodeStack.empty())
-					m_lstNodeStack.pop_front();
-				if (!m_lstPath.empty())
-					m_lstPath.pop_front();
-			}
-			
-		}
-
-//		if (std::find(m_lstNodeStack.begin(),m_lstNodeStack.end(),pCurrent) != m_lstNodeStack.end())
-	//			DEBUG_BREAK;
-	}
-
-	if (m_pWalkBackCurrent == pEnd)
+	int nResult = m_pSearch->WalkBack(pBegin,pEnd,nIterations,m_lstNodeStack,m_lstPath);
+	if (nResult == PATHFINDER_BEAUTIFYINGPATH)
 	{
-		m_pWalkBackCurrent = 0;
 		m_mapGreedyWalkCandidates.clear();
-		if (std::find(m_lstNodeStack.begin(),m_lstNodeStack.end(),pEnd)==m_lstNodeStack.end())
-		{
-			m_lstNodeStack.push_front(pEnd);
-			m_lstPath.push_front(pEnd->data.m_pos);
-		}
 		m_lstLastPath.clear();
 		m_lstLastPath.insert(m_lstLastPath.begin(),m_lstNodeStack.begin(),m_lstNodeStack.end());
-		return PATHFINDER_BEAUTIFYINGPATH;
 	}
-	else
-		return PATHFINDER_WALKINGBACK;
+	return nResult;
+}
+
+void CGraph::BeautifyPathNow(CAIObject *pRequester, ListNodes &lstNodes, ListPositions &lstPath, const Vec3d &start, const Vec3d &end)
+{
+	// the beautifier works on the graph's node stack and path, swap the lists in and out so that the
+	// iterators of a beautification in progress stay valid
+	CAIObject *pOldRequester = m_pRequester;
+	bool bOldBeautifying = m_bBeautifying;
+	ListNodes::iterator iOldFirst=m_iFirst, iOldSecond=m_iSecond, iOldThird=m_iThird;
+	Vec3d vOldStart = m_vBeautifierStart, vOldIntersection = m_vLastIntersection;
+
+	m_lstNodeStack.swap(lstNodes);
+	m_lstPath.swap(lstPath);
+	m_pRequester = pRequester;
+	m_bBeautifying = true;
+	int nIterations;
+	do
+		nIterations = 1<<30;
+	while (BeautifyPath(nIterations,start,end) == PATHFINDER_BEAUTIFYINGPATH);
+	m_lstNodeStack.swap(lstNodes);
+	m_lstPath.swap(lstPath);
+
+	m_pRequester = pOldRequester;
+	m_bBeautifying = bOldBeautifying;
+	m_iFirst = iOldFirst; m_iSecond = iOldSecond; m_iThird = iOldThird;
+	m_vBeautifierStart = vOldStart; m_vLastIntersection = vOldIntersection;
 }
 
 
@@ -1302,6 +1200,7 @@ bool CGraph::ReadFromFile(const char * szName)
 	CCryFile file;;
 	if (file.Open( szName,"rb"))
 	{
+		m_pPathService->Clear();
 		ReadNodes( file );
 		return true;
 	}
@@ -2543,9 +2442,7 @@ GraphNode * CGraph::GetThirdNode(const Vec3d & vFirst, const Vec3d & vSecond, co
 
 void CGraph::Reset(void)
 {
-	m_pWalkBackCurrent = 0;
-	m_pPathfinderCurrent = 0;
-	m_lstCurrentHistory.clear();
+	m_pSearch->ResetWalkBack();
 	m_lstLastPath.clear();
 	m_lstNodeStack.clear();
 	m_bBeautifying = true;
@@ -2854,6 +2751,7 @@ void CGraph::FixDegenerateTriangles(void)
 
 void CGraph::DisableInSphere(const Vec3 &pos,float fRadius)
 {
+	m_nVersion++;	// path service searches restart on the changed graph
 	GetNodesInSphere(pos,fRadius);
 	ListNodes::iterator li = m_lstNodesInsideSphere.begin(),liend = m_lstNodesInsideSphere.end();
 	for (;li!=liend;++li)
@@ -2885,6 +2783,7 @@ void CGraph::DisableInSphere(const Vec3 &pos,float fRadius)
 
 void CGraph::EnableInSphere(const Vec3 &pos,float fRadius)
 {
+	m_nVersion++;	// path service searches restart on the changed graph
 	GetNodesInSphere(pos,fRadius);
 	ListNodes::iterator li = m_lstNodesInsideSphere.begin(),liend = m_lstNodesInsideSphere.end();
 	for (;li!=liend;++li)
@@ -2924,7 +2823,7 @@ int CGraph::GetNodesInSphere(const Vec3 &pos, float fRadius)
 
 	
 	m_lstNodesInsideSphere.push_front(pNode);
-	while(m_lstNodesInsideSphere.front()->tag == false)
+	while(!IsTagged(m_lstNodesInsideSphere.front()))
 	{
 
 		ListNodes::iterator li = m_lstNodesInsideSphere.begin(),liend = m_lstNodesInsideSphere.end();
@@ -2934,7 +2833,7 @@ int CGraph::GetNodesInSphere(const Vec3 &pos, float fRadius)
 			++linext;
 			if (linext!=liend)
 			{
-				if ((*linext)->tag)
+				if (IsTagged(*linext))
 					break;
 			}
 			++li;
@@ -2948,7 +2847,7 @@ int CGraph::GetNodesInSphere(const Vec3 &pos, float fRadius)
 		for (;vli!=vliend;++vli)
 		{
 			GraphNode *pLink = (*vli).pLink;
-			if (pLink->tag)
+			if (IsTagged(pLink))
 				continue;
 			if ( GetLength(pLink->data.m_pos-pos) < fRadius )
 			{
@@ -2961,3 +2860,111 @@ int CGraph::GetNodesInSphere(const Vec3 &pos, float fRadius)
 	return m_lstNodesInsideSphere.size();
 
 }
+
+void CGraph::RecordPathQueries(const char * szFileName)
+{
+	if (!m_sRecordFile.empty())
+	{
+		CCryFile file;
+		if (file.Open(m_sRecordFile.c_str(),"wb"))
+		{
+			int nQueries = m_vRecordedQueries.size();
+			file.Write(&nQueries,sizeof(int));
+			if (nQueries)
+				file.Write(&m_vRecordedQueries[0],nQueries*sizeof(PathQueryRecord));
+		}
+		m_pAISystem->m_pSystem->GetILog()->Log("\003[AISYSTEM] Recorded %d path queries to %s",m_vRecordedQueries.size(),m_sRecordFile.c_str());
+	}
+	m_vRecordedQueries.clear();
+	m_sRecordFile = szFileName ? szFileName : "";
+}
+
+void CGraph::CheckPathQueryCommands()
+{
+	if (!m_cvRecordPathQueries)
+	{
+		// the graph can be created before the console is available, so register on first use
+		IConsole *pConsole = m_pAISystem->m_pSystem->GetIConsole();
+		m_cvRecordPathQueries = pConsole->CreateVariable("ai_RecordPathQueries","",0,
+			"Records the path requests of the AI system's pathfinder to the given file, the file is written\n"
+			"when the variable is cleared or changed, or when the graph is released.\n"
+			"Usage: ai_RecordPathQueries <file name>");
+		m_cvBenchmarkPathQueries = pConsole->CreateVariable("ai_BenchmarkPathQueries","",0,
+			"Replays the path requests recorded with ai_RecordPathQueries once, on behalf of the puppet\n"
+			"that makes the next path request, logs the timing and resets itself.\n"
+			"Usage: ai_BenchmarkPathQueries <file name>");
+	}
+
+	const char *szRecordFile = m_cvRecordPathQueries->GetString();
+	if (strcmp(szRecordFile,m_sRecordFile.c_str()))
+		RecordPathQueries(*szRecordFile ? szRecordFile : 0);
+
+	const char *szBenchmarkFile = m_cvBenchmarkPathQueries->GetString();
+	if (*szBenchmarkFile)
+	{
+		string sBenchmarkFile = szBenchmarkFile;
+		m_cvBenchmarkPathQueries->Set("");
+		BenchmarkPathQueries(sBenchmarkFile.c_str(),m_pRequester);
+	}
+}
+
+void CGraph::BenchmarkPathQueries(const char * szFileName, CAIObject * pRequester)
+{
+	CCryFile file;
+	int nQueries = 0;
+	if (!pRequester || !m_pHeuristic || !file.Open(szFileName,"rb") || !file.Read(&nQueries,sizeof(int)) || nQueries<=0)
+	{
+		m_pAISystem->m_pSystem->GetILog()->Log("\003[AISYSTEM] No path queries to replay from %s",szFileName);
+		return;
+	}
+	PathQueryBuffer vQueries(nQueries);
+	nQueries = file.Read(&vQueries[0],nQueries*sizeof(PathQueryRecord))/sizeof(PathQueryRecord);
+
+	CAIObject *pOldRequester = m_pRequester;
+	Vec3d vOldEnd = m_vRealPathfinderEnd;
+	float fOldDistance = m_fDistance;
+	ITimer *pTimer = m_pAISystem->m_pSystem->GetITimer();
+	int nFound = 0, nPathNodes = 0;
+	float fChecksum = 0, fTime = 0;
+
+	m_pRequester = pRequester;
+	m_bReplayingQueries = true;
+	for (int i=0;i<nQueries;i++)
+	{
+		GraphNode *pBegin = GetEnclosing(vQueries[i].vBegin);
+		GraphNode *pEnd = GetEnclosing(vQueries[i].vEnd);
+		m_vRealPathfinderEnd = vQueries[i].vRealEnd;
+		m_fDistance = vQueries[i].fDistance;
+		Reset();	// don't let the last path be reused
+
+		float fStart = pTimer->GetAsyncCurTime();
+		int nIterations = 1<<30;
+		int nResult = WalkAStar(pBegin,pEnd,nIterations);
+		while (nResult == PATHFINDER_STILLTRACING || nResult == PATHFINDER_WALKINGBACK)
+		{
+			nIterations = 1<<30;
+			if (nResult == PATHFINDER_STILLTRACING)
+				nResult = ContinueAStar(pEnd,nIterations);
+			else
+				nResult = WalkBack(pEnd,pBegin,nIterations);
+		}
+		fTime += pTimer->GetAsyncCurTime() - fStart;
+
+		if (nResult == PATHFINDER_BEAUTIFYINGPATH)
+		{
+			nFound++;
+			for (ListPositions::iterator pi=m_lstPath.begin();pi!=m_lstPath.end();pi++,nPathNodes++)
+				fChecksum += (*pi).x + (*pi).y*3.f + (*pi).z*7.f;
+		}
+	}
+
+	m_bReplayingQueries = false;
+	Reset();
+	ClearPath();
+	m_pRequester = pOldRequester;
+	m_vRealPathfinderEnd = vOldEnd;
+	m_fDistance = fOldDistance;
+
+	m_pAISystem->m_pSystem->GetILog()->Log("\003[AISYSTEM] Replayed %d path queries in %.3f ms (%.0f queries/s): %d found, %d path nodes, checksum %.2f",
+		nQueries,fTime*1000.f,fTime>0 ? nQueries/fTime : 0.f,nFound,nPathNodes,fChecksum);
+}
@@ -23,6 +23,8 @@
 
 struct IRenderer;
 class CCryFile;
+class CAStarSearch;
+class CPathService;
 
 #define PATHFINDER_STILLTRACING				0
 #define PATHFINDER_WALKINGBACK				1
@@ -43,6 +45,7 @@ class ICrySizer;
 class CAIObject;
 
 struct IVisArea;
+struct ICVar;
 
 typedef struct NodeDescriptor
 {
@@ -60,11 +63,23 @@ typedef struct NodeDescriptor
 typedef std::list<GraphNode *> ListNodes;
 typedef std::vector<GraphNode *> VectorNodes;
 
-typedef struct NodeWithHistory
+typedef struct AStarCandidate
 {
 	GraphNode	*pNode;
-	ListNodes	lstParents;
-} NodeWithHistory;
+	int iState;								// slot of the node in the search's node table
+	float fDesirability;
+	int nOrder;								// insertion order, ties go to the latest candidate
+	GraphNode	*pHistory[2];		// parent and grandparent at the time of evaluation
+	int nHistory;
+} AStarCandidate;
+
+typedef struct PathQueryRecord
+{
+	Vec3d vBegin;
+	Vec3d vEnd;
+	Vec3d vRealEnd;
+	float fDistance;
+} PathQueryRecord;
 
 typedef struct LinkDescriptor
 {
@@ -79,7 +94,23 @@ typedef struct LinkDescriptor
 
 class CHeuristic;
 typedef std::multimap<float,GraphNode*> CandidateMap;
-typedef std::multimap<float,NodeWithHistory> CandidateHistoryMap;
+typedef std::vector<PathQueryRecord> PathQueryBuffer;
+
+// Pathfinder open list, a binary max-heap on desirability. m_piCandidate[iState] holds the heap
+// position of the candidate of each node slot of the search (-1 when the node is not queued),
+// so a candidate can be found and improved in place.
+class CCandidateHeap
+{
+public:
+	CCandidateHeap() { m_piCandidate = 0; }
+
+	void SiftCandidateUp(int i);
+	void SiftCandidateDown(int i);
+	void PopCandidate();
+
+	std::vector<AStarCandidate> m_vCandidates;
+	int *m_piCandidate;
+};
 
 // NOTE: INT_PTR here avoids a tiny performance impact on 32-bit platform
 // for the cost of loss of full compatibility: 64-bit generated BAI files
@@ -102,20 +133,19 @@ class CGraph : public IGraph
 {
 
 protected:
-	int	m_nAStarDistance;
 	GraphNode *m_pCurrent;
-	GraphNode *m_pPathfinderCurrent;
 //	GraphNode *m_pFirst;
 	GraphNode *m_pPathBegin;
-	GraphNode *m_pWalkBackCurrent;
 	CHeuristic *m_pHeuristic;
 
 	
 
-	CandidateHistoryMap m_mapCandidates;			// used by pathfinder
+	CAStarSearch *m_pSearch;					// used by pathfinder
+	CPathService *m_pPathService;			// pathfinding on worker threads
+	unsigned int m_nTagStamp;					// current tag generation, bumped instead of clearing the tags
+	int m_nVersion;										// bumped whenever links are enabled or disabled
 	CandidateMap m_mapGreedyWalkCandidates;	// used by get enclosing
 
-	VectorNodes m_lstTagTracker;		// for quick cleaning of the tag
 	VectorNodes m_lstMarkTracker;		// for quick cleaning of the mark
 
 	ListNodes m_lstDeleteStack;	// for non-recursive deletion of the graph (stack emulator)
@@ -177,7 +207,6 @@ public:
 	ListNodes m_lstTrapNodes;
 
 	ListNodes m_lstSaveStack;
-	ListNodes m_lstCurrentHistory;
 
 	int nNodes;
 	float m_fDistance;
@@ -194,9 +223,6 @@ protected:
 	int GetNodesInSphere(const Vec3 &pos, float fRadius);
 	void DeleteGraph(GraphNode *, int depth);
 	void ClearPath();
-	void EvaluateNode(GraphNode *pNode,GraphNode *pEnd, GraphNode *pParent);
-	
-	GraphNode * ASTARStep(GraphNode *pBegin, GraphNode *pEnd);
 	void DebugWalk(GraphNode *pNode, const Vec3d &pos);
 
 
@@ -207,6 +233,7 @@ private:
 	int m_nTagged;
 public:
 	void TagNode(GraphNode *pNode);
+	bool IsTagged(const GraphNode *pNode) const { return pNode->nTag==m_nTagStamp; }
 	void Disconnect(GraphNode * pDisconnected, bool bDelete = true);
 	// walk that will always produce a result, for indoors
 	void IndoorDebugWalk(GraphNode * pNode, const Vec3d & pos, IVisArea *pArea = 0);
@@ -297,6 +324,25 @@ typedef std::list<int>			ObstacleIndexList;
 	GraphNode * GetEntrance(int nBuildingID,const Vec3d &pos);
 	void RemoveDegenerateTriangle(GraphNode * pDegenerate, bool bRecurse = true);
 	void FixDegenerateTriangles(void);
+
+	CPathService *GetPathService() { return m_pPathService; }
+	int GetVersion() const { return m_nVersion; }
+	// beautifies a path found outside of the graph's own pathfinder, leaving the pathfinder's state alone
+	void BeautifyPathNow(CAIObject *pRequester, ListNodes &lstNodes, ListPositions &lstPath, const Vec3d &start, const Vec3d &end);
+
+	// starts recording the path requests to a file, or stops when szFileName is 0 (ai_RecordPathQueries)
+	void RecordPathQueries(const char *szFileName);
+	// replays recorded path requests on behalf of pRequester and logs the timing; call between path requests (ai_BenchmarkPathQueries)
+	void BenchmarkPathQueries(const char *szFileName, CAIObject *pRequester);
+protected:
+	// applies ai_RecordPathQueries and ai_BenchmarkPathQueries at the start of a path request
+	void CheckPathQueryCommands();
+
+	PathQueryBuffer m_vRecordedQueries;
+	string m_sRecordFile;
+	ICVar *m_cvRecordPathQueries;
+	ICVar *m_cvBenchmarkPathQueries;
+	bool m_bReplayingQueries;						// the requests of BenchmarkPathQueries are neither recorded nor checked for commands
 };
 
 
@@ -5,7 +5,7 @@
 #include "stdafx.h"
 #include "IAgent.h"
 #include "Heuristic.h"
-#include "Graph.h"
+#include "AStarSearch.h"
 #include "AIObject.h"
 #include "Cry_Math.h"
 
@@ -23,7 +23,7 @@ CHeuristic::~CHeuristic()
 
 }
 
-float CHeuristic::Estimate(GraphNode *pNode, CGraph* graph)
+float CHeuristic::Estimate(GraphNode *pNode, CAStarSearch* search)
 {
 	// DEFAULT HEURISTIC LIKES EVERYTHING :)
 	
@@ -36,7 +36,7 @@ float CHeuristic::Estimate(GraphNode *pNode, CGraph* graph)
 }
 
 
-float CStandardHeuristic::Estimate(GraphNode *pNode, CGraph* graph)
+float CStandardHeuristic::Estimate(GraphNode *pNode, CAStarSearch* search)
 {
 float	estimation = 0.0f;
 	GameNodeData data = pNode->data;
@@ -54,7 +54,7 @@ float	estimation = 0.0f;
 	VectorOfLinks::iterator vli;
 	for (vli=pNode->link.begin();vli!=pNode->link.end();vli++)
 	{
-		if ((*vli).pLink->tag)
+		if (search->IsTagged((*vli).pLink))
 		{
 			float dist = ((*vli).pLink->data.m_pos - pNode->data.m_pos).GetLength();
 			if (dist < mindist)
@@ -67,20 +67,21 @@ float	estimation = 0.0f;
 	if (pPrevious)
 	{
 		// paths that are very much longer than the straight path should be suppressed
-		pNode->fDistance = pPrevious->fDistance + mindist;
-		estimation += 1.f - (pNode->fDistance / graph->m_fDistance) * 0.5f;
+		float fDistance = search->GetNodeDistance(pPrevious) + mindist;
+		search->SetNodeDistance(pNode,fDistance);
+		estimation += 1.f - (fDistance / search->m_fDistance) * 0.5f;
 	}
 	return estimation;
 }
 
 
-float CVehicleHeuristic::Estimate(GraphNode *pNode, CGraph* graph)
+float CVehicleHeuristic::Estimate(GraphNode *pNode, CAStarSearch* search)
 {
 float	estimation = 0.0f;
 Vec3d candidateDir;
 Vec3d curDir;
 GraphNode *pPrev = 0;
-float maxheur=pNode->fHeuristic;
+float maxheur=search->GetNodeHeuristic(pNode);
 //VectorOfLinks::iterator vi;
 bool	firstStep = false;
 
@@ -89,40 +90,33 @@ bool	firstStep = false;
 	if( pNode->nBuildingID<0 )	// outdoors
 	{
 		CStandardHeuristic outdoorHeur;
-		estimation = outdoorHeur.Estimate(pNode, graph);
+		estimation = outdoorHeur.Estimate(pNode, search);
 		// just use it for now - somehove vehicle heuristic seems not to work, blin
 		return estimation;
-//		return 	outdoorHeur.Estimate(pNode, graph);
+//		return 	outdoorHeur.Estimate(pNode, search);
 	}
 
 //return 5 - estimation;
 
-	size_t sz = graph->m_lstCurrentHistory.size();
-	if(sz>2)
-int tooBig=1;
-
-	if(graph->m_lstCurrentHistory.size()==2)
+	if(search->m_nCurrentHistory==2)
 	{
-ListNodes::iterator prev = graph->m_lstCurrentHistory.begin();
-ListNodes::iterator prevPrev = prev;
-++prevPrev;
-		curDir = (*graph->m_lstCurrentHistory.begin())->data.m_pos - (*(++graph->m_lstCurrentHistory.begin()))->data.m_pos;	
-		candidateDir = pNode->data.m_pos - (*graph->m_lstCurrentHistory.begin())->data.m_pos;
+		curDir = search->m_pCurrentHistory[0]->data.m_pos - search->m_pCurrentHistory[1]->data.m_pos;	
+		candidateDir = pNode->data.m_pos - search->m_pCurrentHistory[0]->data.m_pos;
 	}
-	else if(graph->m_lstCurrentHistory.size()==1)
+	else if(search->m_nCurrentHistory==1)
 	{
-		curDir = (*graph->m_lstCurrentHistory.begin())->data.m_pos - graph->GetRequester()->GetPos();		
-		candidateDir = pNode->data.m_pos - (*graph->m_lstCurrentHistory.begin())->data.m_pos;
+		curDir = search->m_pCurrentHistory[0]->data.m_pos - search->m_vRequesterPos;		
+		candidateDir = pNode->data.m_pos - search->m_pCurrentHistory[0]->data.m_pos;
 	}
 	else
 	{
-		Vec3d vAngles = graph->GetRequester()->GetAngles();
+		Vec3d vAngles = search->m_vRequesterAngles;
 		curDir = Vec3d(0, -1, 0);
 		Matrix44 mat;
 		mat.SetIdentity();
 		mat=Matrix44::CreateRotationZYX(-gf_DEGTORAD*vAngles)*mat; //NOTE: angles in radians and negated
 		curDir = mat.TransformPointOLD(curDir);
-		candidateDir = pNode->data.m_pos - graph->GetRequester()->GetPos();
+		candidateDir = pNode->data.m_pos - search->m_vRequesterPos;
 		firstStep = true;
 	}
 
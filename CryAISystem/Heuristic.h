@@ -10,7 +10,7 @@
 #endif // _MSC_VER > 1000
 
 
-class CGraph;
+class CAStarSearch;
 
 class CHeuristic  
 {
@@ -19,19 +19,19 @@ public:
 	CHeuristic(/*const GameNodeData &basevalues*/);
 	virtual ~CHeuristic();
 
-	virtual float Estimate(GraphNode *pNode, CGraph* graph );
+	virtual float Estimate(GraphNode *pNode, CAStarSearch* search );
 };
 
 class CStandardHeuristic : public CHeuristic
 {
 public:
-	float Estimate(GraphNode *pNode, CGraph* graph);
+	float Estimate(GraphNode *pNode, CAStarSearch* search);
 };
 
 class CVehicleHeuristic : public CHeuristic
 {
 public:
-	float Estimate(GraphNode *pNode, CGraph* graph);
+	float Estimate(GraphNode *pNode, CAStarSearch* search);
 };
 
 
@@ -0,0 +1,256 @@
+// PathService.cpp: implementation of the CPathService class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PathService.h"
+#include "AStarSearch.h"
+#include "Heuristic.h"
+#include "CAISystem.h"
+#include "PipeUser.h"
+
+#include <ISystem.h>
+#include <IConsole.h>
+#include <IJobManager.h>
+
+#if defined(WIN32) && defined(_DEBUG)
+#include <crtdbg.h>
+#define DEBUG_NEW_NORMAL_CLIENTBLOCK(file, line) new(_NORMAL_BLOCK, file, line)
+#define new DEBUG_NEW_NORMAL_CLIENTBLOCK( __FILE__, __LINE__)
+#endif
+
+#define PATHSERVICE_MAX_LANES 16
+
+typedef struct PathServiceLane
+{
+	CPathService *pService;
+	int iLane;
+	int nLanes;
+} PathServiceLane;
+
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CPathService::CPathService(CGraph *pGraph, CAISystem *pAISystem)
+{
+	m_pGraph = pGraph;
+	m_pAISystem = pAISystem;
+	m_pHeuristics[AIHEURISTIC_DEFAULT] = new CHeuristic;
+	m_pHeuristics[AIHEURISTIC_STANDARD] = new CStandardHeuristic;
+	m_pHeuristics[AIHEURISTIC_VEHICLE] = new CVehicleHeuristic;
+	m_cvWorkers = 0;
+	m_cvIterations = 0;
+	m_nIterations = 0;
+	InitializeCriticalSection(&m_csAlloc);
+}
+
+CPathService::~CPathService()
+{
+	Clear();
+	for (int i=0;i<(int)m_vFreeSearches.size();i++)
+		delete m_vFreeSearches[i];
+	for (int i=0;i<3;i++)
+		delete m_pHeuristics[i];
+	DeleteCriticalSection(&m_csAlloc);
+}
+
+bool CPathService::IsEnabled()
+{
+	if (!m_cvWorkers)
+	{
+		// the graph can be created before the console is available, so register on first use
+		IConsole *pConsole = m_pAISystem->m_pSystem->GetIConsole();
+		m_cvWorkers = pConsole->CreateVariable("ai_PathServiceWorkers","0",0,
+			"Number of threads that search paths requested by puppets, 0 uses the AI system's own pathfinder.\n"
+			"Usage: ai_PathServiceWorkers [0..16]");
+		m_cvIterations = pConsole->CreateVariable("ai_PathServiceIterations","500",0,
+			"Number of nodes each path request may expand per frame when searched by the path service.\n"
+			"Usage: ai_PathServiceIterations 500");
+	}
+	return m_cvWorkers->GetIVal() > 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// requests
+//////////////////////////////////////////////////////////////////////
+
+void CPathService::RequestPath(CPipeUser *pRequester, const Vec3d &vStart, const Vec3d &vEnd, unsigned int nHeuristic)
+{
+	CancelRequests(pRequester);
+
+	PathRequest *pRequest = new PathRequest;
+	pRequest->pRequester = pRequester;
+	pRequest->vStart = vStart;
+	pRequest->vEnd = vEnd;
+	pRequest->pBegin = m_pGraph->GetEnclosing(vStart);
+	pRequest->pEnd = m_pGraph->GetEnclosing(vEnd);
+	pRequest->nHeuristic = nHeuristic<3 ? nHeuristic : AIHEURISTIC_STANDARD;
+	pRequest->fPassRadius = pRequester->m_fPassRadius;
+	pRequest->vRequesterPos = pRequester->GetPos();
+	pRequest->vRequesterAngles = pRequester->GetAngles();
+	pRequest->nVersion = -1;
+	pRequest->nState = pRequest->pBegin && pRequest->pEnd ? PATHFINDER_STILLTRACING : PATHFINDER_NOPATH;
+	if (m_vFreeSearches.empty())
+		pRequest->pSearch = new CAStarSearch;
+	else
+	{
+		pRequest->pSearch = m_vFreeSearches.back();
+		m_vFreeSearches.pop_back();
+	}
+	m_lstRequests.push_back(pRequest);
+}
+
+void CPathService::CancelRequests(CPipeUser *pRequester)
+{
+	ListPathRequests::iterator ri=m_lstRequests.begin();
+	while (ri!=m_lstRequests.end())
+	{
+		if ((*ri)->pRequester == pRequester)
+		{
+			ReleaseRequest(*ri);
+			ri = m_lstRequests.erase(ri);
+		}
+		else
+			++ri;
+	}
+}
+
+void CPathService::Clear()
+{
+	for (ListPathRequests::iterator ri=m_lstRequests.begin();ri!=m_lstRequests.end();++ri)
+		ReleaseRequest(*ri);
+	m_lstRequests.clear();
+	m_vActive.clear();
+}
+
+void CPathService::ReleaseRequest(PathRequest *pRequest)
+{
+	pRequest->pSearch->m_pcsAlloc = 0;
+	m_vFreeSearches.push_back(pRequest->pSearch);
+	delete pRequest;
+}
+
+//////////////////////////////////////////////////////////////////////
+// update
+//////////////////////////////////////////////////////////////////////
+
+void CPathService::Update()
+{
+	FUNCTION_PROFILER(m_pAISystem->m_pSystem,PROFILE_AI);
+
+	if (m_lstRequests.empty())
+		return;
+	IsEnabled();
+	m_nIterations = m_cvIterations->GetIVal()>0 ? m_cvIterations->GetIVal() : 1;
+
+	// (re)start the searches that are new or were started on an older graph
+	int nVersion = m_pGraph->GetVersion();
+	m_vActive.clear();
+	ListPathRequests::iterator ri;
+	for (ri=m_lstRequests.begin();ri!=m_lstRequests.end();++ri)
+	{
+		PathRequest *pRequest = *ri;
+		if (pRequest->nState == PATHFINDER_NOPATH)
+			continue;
+		if (pRequest->nVersion != nVersion)
+		{
+			float fDistance = (pRequest->vEnd - pRequest->vStart).GetLength();
+			if (fDistance < 0.01f)
+				fDistance = 0.01f;
+			pRequest->pSearch->Begin(pRequest->pBegin,pRequest->pEnd,pRequest->vEnd,fDistance,pRequest->fPassRadius,
+				m_pHeuristics[pRequest->nHeuristic],pRequest->vRequesterPos,pRequest->vRequesterAngles);
+			pRequest->nVersion = nVersion;
+			pRequest->nState = PATHFINDER_STILLTRACING;
+		}
+		if (pRequest->nState == PATHFINDER_STILLTRACING)
+			m_vActive.push_back(pRequest);
+	}
+
+	// search; the main thread waits, so the graph can't change under the workers
+	IJobManager *pJobManager = m_pAISystem->m_pSystem->GetIJobManager();
+	int i,nLanes = m_cvWorkers->GetIVal();
+	if (nLanes > PATHSERVICE_MAX_LANES)
+		nLanes = PATHSERVICE_MAX_LANES;
+	if (nLanes > (int)m_vActive.size())
+		nLanes = m_vActive.size();
+	if (nLanes<2 || !pJobManager)
+	{
+		for (i=0;i<(int)m_vActive.size();i++)
+			ProcessRequest(m_vActive[i]);
+	}
+	else
+	{
+		PathServiceLane lanes[PATHSERVICE_MAX_LANES];
+		for (i=0;i<(int)m_vActive.size();i++)
+			m_vActive[i]->pSearch->m_pcsAlloc = &m_csAlloc;
+		for (i=0;i<nLanes;i++)
+		{
+			lanes[i].pService = this;
+			lanes[i].iLane = i;
+			lanes[i].nLanes = nLanes;
+		}
+		JobCounter lanesDone;
+		for (i=1;i<nLanes;i++)
+			pJobManager->AddJob(SearchLane,lanes+i,&lanesDone);
+		SearchLane(lanes);
+		pJobManager->WaitForJobs(&lanesDone);
+		for (i=0;i<(int)m_vActive.size();i++)
+			m_vActive[i]->pSearch->m_pcsAlloc = 0;
+	}
+	m_vActive.clear();
+
+	// hand the finished paths to the requesters, in the order they were requested
+	for (ri=m_lstRequests.begin();ri!=m_lstRequests.end();)
+	{
+		PathRequest *pRequest = *ri;
+		if (pRequest->nState == PATHFINDER_STILLTRACING)
+		{
+			++ri;
+			continue;
+		}
+		ri = m_lstRequests.erase(ri);
+		DeliverRequest(pRequest);
+		ReleaseRequest(pRequest);
+	}
+}
+
+void CPathService::SearchLane(void *pData)
+{
+	PathServiceLane *pLane = (PathServiceLane*)pData;
+	CPathService *pService = pLane->pService;
+	for (int i=pLane->iLane;i<(int)pService->m_vActive.size();i+=pLane->nLanes)
+		pService->ProcessRequest(pService->m_vActive[i]);
+}
+
+void CPathService::ProcessRequest(PathRequest *pRequest)
+{
+	int nIterations = m_nIterations;
+	pRequest->nState = pRequest->pSearch->Continue(nIterations);
+}
+
+void CPathService::DeliverRequest(PathRequest *pRequest)
+{
+	ListNodes lstNodes;
+	ListPositions lstPath;
+	int nResult = pRequest->nState;
+	if (nResult == PATHFINDER_WALKINGBACK)
+	{
+		// walking back allocates the path lists, so it is left to the main thread
+		int nIterations;
+		do
+		{
+			nIterations = 1<<30;
+			nResult = pRequest->pSearch->WalkBack(pRequest->pEnd,pRequest->pBegin,nIterations,lstNodes,lstPath);
+		} while (nResult == PATHFINDER_WALKINGBACK);
+	}
+
+	if (nResult == PATHFINDER_BEAUTIFYINGPATH)
+	{
+		m_pGraph->BeautifyPathNow(pRequest->pRequester,lstNodes,lstPath,pRequest->vStart,pRequest->vEnd);
+		pRequest->pRequester->HandlePathResult(true,lstPath,pRequest->vEnd);
+	}
+	else
+		pRequest->pRequester->HandlePathResult(false,lstPath,pRequest->vEnd);
+}
@@ -0,0 +1,82 @@
+// PathService.h: interface for the CPathService class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#if !defined(AFX_PATHSERVICE_H__8E1C2D4A_5F37_4B69_A0D2_7C9B3E64F215__INCLUDED_)
+#define AFX_PATHSERVICE_H__8E1C2D4A_5F37_4B69_A0D2_7C9B3E64F215__INCLUDED_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include "Graph.h"
+
+class CAStarSearch;
+class CPipeUser;
+class CHeuristic;
+struct ICVar;
+
+typedef struct PathRequest
+{
+	CPipeUser *pRequester;
+	Vec3d vStart;
+	Vec3d vEnd;
+	GraphNode *pBegin;
+	GraphNode *pEnd;
+	unsigned int nHeuristic;
+	float fPassRadius;
+	Vec3d vRequesterPos;
+	Vec3d vRequesterAngles;
+	int nVersion;					// graph version the search runs against, -1 if not started
+	int nState;						// PATHFINDER_STILLTRACING while searching, then PATHFINDER_WALKINGBACK or PATHFINDER_NOPATH
+	CAStarSearch *pSearch;
+} PathRequest;
+
+typedef std::list<PathRequest*> ListPathRequests;
+typedef std::vector<PathRequest*> VectorPathRequests;
+
+// Path request queue with a separate search state per request. Searches of all pending
+// requests run on the job manager's workers from Update, on the main thread's frame time,
+// so they see the graph read-only. When links are enabled or disabled the graph version
+// changes, and searches that were started on the older version start again, so a search
+// never mixes two states of the graph. Results are walked back, beautified and handed to the
+// requesters on the main thread.
+class CPathService
+{
+public:
+	CPathService(CGraph *pGraph, CAISystem *pAISystem);
+	~CPathService();
+
+	// true if path requests should go through the service rather than the AI system's own pathfinder
+	bool IsEnabled();
+	void RequestPath(CPipeUser *pRequester, const Vec3d &vStart, const Vec3d &vEnd, unsigned int nHeuristic);
+	void CancelRequests(CPipeUser *pRequester);
+	// drops all requests without notifying the requesters; the graph nodes they refer to are going away
+	void Clear();
+	// called once per frame by CAISystem::Update on the main thread, before the puppets are updated
+	void Update();
+
+	int GetPendingCount() const { return m_lstRequests.size(); }
+
+protected:
+	static void SearchLane(void *pData);
+	void ProcessRequest(PathRequest *pRequest);
+	void DeliverRequest(PathRequest *pRequest);
+	void ReleaseRequest(PathRequest *pRequest);
+
+	CGraph *m_pGraph;
+	CAISystem *m_pAISystem;
+	CHeuristic *m_pHeuristics[3];		// indexed by AIHEURISTIC_ type
+
+	ListPathRequests m_lstRequests;
+	VectorPathRequests m_vActive;
+	std::vector<CAStarSearch*> m_vFreeSearches;
+
+	ICVar *m_cvWorkers;
+	ICVar *m_cvIterations;
+	int m_nIterations;
+
+	CRITICAL_SECTION m_csAlloc;			// serializes search buffer growth on the workers
+};
+
+#endif // !defined(AFX_PATHSERVICE_H__8E1C2D4A_5F37_4B69_A0D2_7C9B3E64F215__INCLUDED_)
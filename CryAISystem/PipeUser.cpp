@@ -5,6 +5,7 @@
 #include <ITimer.h>
 #include "GoalOp.h"
 #include "pipeuser.h"
+#include "PathService.h"
 #include <stream.h>
 
 
@@ -21,6 +22,9 @@ CPipeUser::CPipeUser(void)
 
 CPipeUser::~CPipeUser(void)
 {
+	CGraph *pGraph = GetAISystem()->GetGraph();
+	if (pGraph && pGraph->GetPathService())
+		pGraph->GetPathService()->CancelRequests(this);
 }
 
 void CPipeUser::GetStateFromActiveGoals(SOBJECTSTATE &state)
@@ -181,7 +185,24 @@ void CPipeUser::RequestPathTo(const Vec3d &pos)
 	Vec3d myPos = m_vPosition;
 	if (m_nObjectType == AIOBJECT_PUPPET)
 		myPos.z-=m_fEyeHeight;
-	GetAISystem()->TracePath(myPos,pos,this);
+	CPathService *pPathService = GetAISystem()->GetGraph()->GetPathService();
+	if (pPathService->IsEnabled())
+		pPathService->RequestPath(this,myPos,pos,m_nObjectType==AIOBJECT_VEHICLE ? AIHEURISTIC_VEHICLE : AIHEURISTIC_STANDARD);
+	else
+		GetAISystem()->TracePath(myPos,pos,this);
+}
+
+void CPipeUser::HandlePathResult(bool bFound, const ListPositions &lstPath, const Vec3d &vEnd)
+{
+	if (bFound)
+	{
+		m_nPathDecision = PATHFINDER_PATHFOUND;
+		m_lstPath.clear();
+		m_lstPath.insert(m_lstPath.begin(),lstPath.begin(),lstPath.end());
+		m_lstPath.push_back(vEnd);
+	}
+	else
+		m_nPathDecision = PATHFINDER_NOPATH;
 }
 
 CGoalPipe *CPipeUser::GetGoalPipe(const char *name)
@@ -37,6 +37,9 @@ public:
 	CPipeUser(void);
 	virtual ~CPipeUser(void);
 
+	// receives the result of a path requested through the path service
+	void HandlePathResult(bool bFound, const ListPositions &lstPath, const Vec3d &vEnd);
+
 	void GetStateFromActiveGoals(SOBJECTSTATE &state);
 	CGoalPipe *GetGoalPipe(const char *name);
 	void RemoveActiveGoal(int nOrder);
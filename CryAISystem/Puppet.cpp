@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "GoalOp.h"
 #include "Graph.h"
+#include "PathService.h"
 #include "AIPlayer.h"
 
 #include <IConsole.h>
@@ -1112,7 +1113,11 @@ void CPuppet::RequestPathTo(const Vec3d &pos)
 	Vec3d myPos = m_vPosition;
 	if (m_nObjectType == AIOBJECT_PUPPET)
 		myPos.z-=m_fEyeHeight;
-	m_pAISystem->TracePath(myPos,pos,this);
+	CPathService *pPathService = m_pAISystem->GetGraph()->GetPathService();
+	if (pPathService->IsEnabled())
+		pPathService->RequestPath(this,myPos,pos,m_nObjectType==AIOBJECT_VEHICLE ? AIHEURISTIC_VEHICLE : AIHEURISTIC_STANDARD);
+	else
+		m_pAISystem->TracePath(myPos,pos,this);
 }
 
 void CPuppet::HandlePathDecision(SAIEVENT *pEvent)
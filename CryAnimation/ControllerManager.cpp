@@ -167,6 +167,7 @@ bool CControllerManager::LoadAnimation(int nAnimId)
 		params.dwUserData = (DWORD_PTR)(PendingAnimLoad*)pAnimLoad;
 		params.nSize = nFileSize;
 		params.pBuffer = pAnimLoad->pFile->getData();
+		params.nPriorityClass = SRPC_NORMAL;
 
 		// now we're prepared to read, register the pending operation and start reading
 		m_setPendingAnimLoads.insert (pAnimLoad);
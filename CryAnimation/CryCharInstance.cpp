@@ -823,7 +823,7 @@ void CryCharInstance::Update(Vec3d vPos, float fRadius, unsigned uFlags)
 	if ( update || (fFrameTime>0.25f) )
 #endif
 	{
-		m_pModelState->ProcessAnimations(fFrameTime * g_GetCVars()->ca_UpdateSpeed(), (uFlags & flagDontUpdateBones) == 0, this);
+		m_pModelState->ProcessAnimations(fFrameTime * g_GetCVars()->ca_UpdateSpeed(), (uFlags & flagDontUpdateBones) == 0, this, (uFlags & flagDeferBoneUpdate) != 0);
 /*
 	{
 			char str[256];
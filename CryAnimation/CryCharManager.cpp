@@ -29,6 +29,11 @@
 
 #include "CryCharDecalManager.h"
 #include "SSEUtils.h"
+#include "CryModel.h"
+#include "CryModelSubmesh.h"
+#include "CryGeometryInfo.h"
+#include "CrySkinRigidBasis.h"
+#include <IJobManager.h>
 
 #ifdef _DEBUG
 #undef THIS_FILE
@@ -541,6 +546,9 @@ void CryCharManager::Update()
 
 	g_nFrameID = g_GetIRenderer()->GetFrameID();
 	g_bProfilerOn = g_GetISystem()->GetIProfileSystem()->IsProfiling();
+
+	// the characters deferred last frame by somebody who didn't call UpdateDeferredCharacters()
+	CryModelState::EvaluateDeferredPoses();
 	
 	IGame* pGame = g_GetISystem()->GetIGame();
 	g_bUpdateBonesAlways = pGame? (pGame->GetModuleState(EGameServer) && pGame->GetModuleState(EGameMultiplayer)) : false;
@@ -550,6 +558,151 @@ void CryCharManager::Update()
 
 	if (g_GetCVars()->ca_DrawBones() > 1) 
 		ExecScriptCommand(CASCMD_DEBUG_DRAW);
+
+	if (g_GetCVars()->ca_BenchCharacters() > 0)
+	{
+		RunCharacterBenchmark (g_GetCVars()->ca_BenchCharacters());
+		g_GetCVars()->m_p_ca_BenchCharacters->Set(0);
+	}
+}
+
+//! Evaluates the bones of the characters updated with flagDeferBoneUpdate, in parallel
+void CryCharManager::UpdateDeferredCharacters()
+{
+	CryModelState::EvaluateDeferredPoses();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// the characters skinned by one thread of the benchmark, with its own output buffers
+struct CharBenchLane
+{
+	CryModelState** ppStates;
+	int numStates;
+	int nThread, nThreads;
+	TElementaryArray<Vec3dA16, TAllocator16<Vec3dA16> > arrVertices;
+	TElementaryArray<SPipTangentsA, TAllocator16<SPipTangentsA> > arrTangents;
+};
+
+static void CharBenchSkinJob (void* pData)
+{
+	CharBenchLane* pLane = (CharBenchLane*)pData;
+	for (int i = pLane->nThread; i < pLane->numStates; i += pLane->nThreads)
+	{
+		CryModelState* pState = pLane->ppStates[i];
+		CryModelSubmesh* pSubmesh = pState->GetCryModelSubmesh(0);
+		pSubmesh->SelfSkin (0, (Vec3d*)pLane->arrVertices.begin());
+
+		CrySkinRigidBasis* pTangSkin = pSubmesh->GetCryModel()->getGeometryInfo(0)->getTangSkin();
+		if (!pTangSkin)
+			continue;
+#if defined(_CPU_X86) && !defined(LINUX)
+		if (g_GetCVars()->ca_SSEEnable() && cpu::hasSSE())
+			pTangSkin->skinSSE (pState->getBoneGlobalMatrices(), pLane->arrTangents.begin());
+		else
+#endif
+		pTangSkin->skin (pState->getBoneGlobalMatrices(), pLane->arrTangents.begin());
+	}
+}
+
+// poses and skins the given number of copies of the ca_BenchModel character
+// with 1..N threads and logs the time per frame
+void CryCharManager::RunCharacterBenchmark (int numCharacters)
+{
+	CryCharBody* pBody = NULL;
+	const char* szModel = g_GetCVars()->ca_BenchModel();
+	if (szModel && szModel[0])
+	{
+		string strPath = szModel;
+		UnifyFilePath(strPath);
+		pBody = FetchBody (strPath);
+	}
+	else if (!m_arrBodyCache.empty())
+		pBody = m_arrBodyCache[0];
+
+	if (!pBody)
+	{
+		g_GetLog()->LogWarning ("\004ca_BenchCharacters: no character to benchmark, load one or set ca_BenchModel");
+		return;
+	}
+	// keeps the body alive while the copies exist
+	CryCharBody_AutoPtr pBodyLock = pBody;
+
+	CryModel* pModel = pBody->GetModel();
+	CryGeometryInfo* pGeomInfo = pModel->getGeometryInfo(0);
+	CrySkinRigidBasis* pTangSkin = pGeomInfo->getTangSkin();
+	unsigned numAnims = (unsigned)pModel->numAnimations();
+
+	std::vector<CryModelState*> arrStates;
+	arrStates.reserve (numCharacters);
+	for (int i = 0; i < numCharacters; ++i)
+	{
+		CryModelState* pState = pModel->m_pDefaultModelState->MakeCopy();
+		if (!pState)
+			break;
+		// spread the copies over the animations, so that they don't all share the same keys
+		if (numAnims > 1)
+			pState->RunAnimation (1 + i % (numAnims-1), CryCharAnimationParams(), 1);
+		arrStates.push_back (pState);
+	}
+	if (arrStates.empty())
+	{
+		g_GetLog()->LogWarning ("\004ca_BenchCharacters: %s has no bones", pBody->GetFilePathCStr());
+		return;
+	}
+
+	IJobManager* pJobManager = g_GetISystem()->GetIJobManager();
+	int nMaxThreads = (pJobManager ? pJobManager->GetWorkerCount() : 0) + 1;
+	enum {nMaxLanes = 32, nFrames = 100};
+	if (nMaxThreads > nMaxLanes)
+		nMaxThreads = nMaxLanes;
+
+	CharBenchLane arrLanes[nMaxLanes];
+	for (int nLane = 0; nLane < nMaxThreads; ++nLane)
+	{
+		arrLanes[nLane].ppStates  = &arrStates[0];
+		arrLanes[nLane].numStates = (int)arrStates.size();
+		arrLanes[nLane].nThread   = nLane;
+		arrLanes[nLane].arrVertices.reinit (pGeomInfo->numUsedVertices());
+		if (pTangSkin)
+			arrLanes[nLane].arrTangents.reinit (pTangSkin->size());
+	}
+
+	g_GetLog()->Log ("ca_BenchCharacters: %d x %s, %u vertices, %d frames", (int)arrStates.size(), pBody->GetFilePathCStr(), pGeomInfo->numUsedVertices(), (int)nFrames);
+
+	ITimer* pTimer = g_GetTimer();
+	for (int nThreads = 1; nThreads <= nMaxThreads; ++nThreads)
+	{
+		float fPose = 0, fSkin = 0;
+		for (int nFrame = 0; nFrame < nFrames; ++nFrame)
+		{
+			float fStart = pTimer->GetAsyncCurTime();
+			for (unsigned i = 0; i < arrStates.size(); ++i)
+				arrStates[i]->ProcessAnimations (1.0f/30, true, NULL, true);
+			CryModelState::EvaluateDeferredPoses (nThreads);
+			float fPosed = pTimer->GetAsyncCurTime();
+
+			JobCounter jobsSkin;
+			for (int nLane = 1; nLane < nThreads; ++nLane)
+			{
+				arrLanes[nLane].nThreads = nThreads;
+				pJobManager->AddJob (CharBenchSkinJob, &arrLanes[nLane], &jobsSkin);
+			}
+			arrLanes[0].nThreads = nThreads;
+			CharBenchSkinJob (&arrLanes[0]);
+			if (nThreads > 1)
+				pJobManager->WaitForJobs (&jobsSkin);
+			float fSkinned = pTimer->GetAsyncCurTime();
+
+			fPose += fPosed - fStart;
+			fSkin += fSkinned - fPosed;
+		}
+		g_GetLog()->Log ("ca_BenchCharacters: %2d thread(s): pose %.3f ms, skin %.3f ms, total %.3f ms per frame",
+			nThreads, fPose*1000/nFrames, fSkin*1000/nFrames, (fPose+fSkin)*1000/nFrames);
+	}
+
+	for (unsigned i = 0; i < arrStates.size(); ++i)
+		delete arrStates[i];
 }
 
 //! The specified animation will be unloaded from memory; it will be loaded back upon the first invokation (via StartAnimation())
@@ -67,6 +67,9 @@ public:
 	// should be called every frame
 	void Update();
 
+	//! Evaluates the bones of the characters updated with flagDeferBoneUpdate, in parallel
+	virtual void UpdateDeferredCharacters();
+
 	//! Cleans up all resources - currently deletes all bodies and characters (even if there are references on them)
 	virtual void ClearResources();
 
@@ -107,6 +110,10 @@ protected:
 	// locks or unlocks the given body if needed, depending on the hint and console variables
 	void DecideModelLockStatus(CryCharBody* pBody, unsigned nHints);
 	void ClearDecals();
+
+	// poses and skins the given number of copies of the ca_BenchModel character
+	// with 1..N threads and logs the time per frame
+	void RunCharacterBenchmark (int numCharacters);
 private:
 	CControllerManager * m_pControllerManager;
 	// manager of animated objects.
@@ -17,6 +17,7 @@
 #include "CryCharBody.h"
 #include "CryCharAnimationParams.h"
 #include "CryCharFxTrail.h"
+#include <IJobManager.h>
 
 #ifdef _DEBUG
 #undef THIS_FILE
@@ -27,7 +28,7 @@ using namespace CryStringUtils;
 
 #define m_pMesh GetMesh()
 
-CryModelState::ActiveLayerArray CryModelState::g_arrActiveLayers;
+std::vector<CryModelState*> CryModelState::g_arrDeferredPoses;
 
 unsigned CryModelState::g_nInstanceCount = 0;
 
@@ -49,6 +50,7 @@ CryModelState::CryModelState (CryModel* pMesh):
 #endif
 {
 	m_uFlags = nFlagsNeedReskinAllLODs;
+	m_nDeferredPose = -1;
 	m_ModelMatrix44.SetIdentity();
 	m_nInstanceNumber = g_nInstanceCount++;
 	m_nLastTangentsUpdatedFrameId = 0;
@@ -79,6 +81,7 @@ CryModelState::CryModelState (CryModel* pMesh):
 
 CryModelState::~CryModelState()
 { 
+	CancelDeferredPose();
 	m_arrBones.clear();
 	m_arrBoneGlobalMatrices.clear();
 
@@ -165,6 +168,7 @@ void CryModelState::InitDefaultPose(bool bInitBoneInfos, bool bTakePoseFromBoneI
 	{
 		// apply the default animation
 		// for those bones that have no controller in the default animation, we can do little
+		m_pMesh->OnAnimationApply(0);
 		ApplyAnimationToBones (CAnimationLayerInfo(0,0,1));
 	}
 	m_uFlags &= ~nFlagNeedBoneUpdate;
@@ -417,7 +421,9 @@ void CryModelState::UpdateAnimatedEffectors (float fDeltaTimeSec, ActiveLayerArr
 // Moves the animations in time by the given time interval, applies the
 // animation to bones, sends required notification to the animation sinks
 // Calculates bone matrices. Processes physics. Updates BBox.
-void CryModelState::ProcessAnimations (float fDeltaTimeSec, bool bUpdateBones, CryCharInstance* instance)
+// With bDeferBones, only the animation time and the events are processed here; the bones are
+// evaluated by the next EvaluateDeferredPoses() together with the other deferred instances.
+void CryModelState::ProcessAnimations (float fDeltaTimeSec, bool bUpdateBones, CryCharInstance* instance, bool bDeferBones)
 {
 	FUNCTION_PROFILER( g_GetISystem(),PROFILE_ANIMATION );
 
@@ -426,8 +432,11 @@ void CryModelState::ProcessAnimations (float fDeltaTimeSec, bool bUpdateBones, C
   if (g_GetCVars()->ca_NoAnim())
     return;	
 
-	g_arrActiveLayers.clear();
-	UpdateAnimatedEffectors (fDeltaTimeSec, g_arrActiveLayers);
+	// the layers computed now replace the ones that were waiting for evaluation
+	CancelDeferredPose();
+
+	m_arrActiveLayers.clear();
+	UpdateAnimatedEffectors (fDeltaTimeSec, m_arrActiveLayers);
 
 	if (g_GetCVars()->ca_Debug() && *g_GetCVars()->ca_LogAnimation() && stristr(m_pMesh->getFilePathCStr(), g_GetCVars()->ca_LogAnimation()))
 	{
@@ -439,7 +448,7 @@ void CryModelState::ProcessAnimations (float fDeltaTimeSec, bool bUpdateBones, C
 			else
 				strLayers += "  <I>";
 		string strInfo;
-		for (CAnimationLayerInfoArray::iterator it = g_arrActiveLayers.begin(); it != g_arrActiveLayers.end(); ++it)
+		for (CAnimationLayerInfoArray::iterator it = m_arrActiveLayers.begin(); it != m_arrActiveLayers.end(); ++it)
 		{
 			const AnimData& anim = getAnimationSet()->getAnimation(it->nAnimId);
 			strInfo += " \"" + anim.strName + "\"";
@@ -452,12 +461,12 @@ void CryModelState::ProcessAnimations (float fDeltaTimeSec, bool bUpdateBones, C
 	
 	if (g_GetCVars()->ca_EnableCubicBlending())
 	{
-		ActiveLayerArray::iterator it, itEnd = g_arrActiveLayers.end();
-		for (it = g_arrActiveLayers.begin(); it != itEnd; ++it)
+		ActiveLayerArray::iterator it, itEnd = m_arrActiveLayers.end();
+		for (it = m_arrActiveLayers.begin(); it != itEnd; ++it)
 			it->fBlending = SmoothBlendValue(it->fBlending);
 	}
 
-	if (!g_arrActiveLayers.empty())
+	if (!m_arrActiveLayers.empty())
 	{
 
 /*
@@ -493,15 +502,15 @@ if (g_YLine==16.0f) {
 			g_pIRenderer->Draw2dLabel( 1,g_YLine, 1.3f, fColor, false,"model: %1x %s",bUpdateBones, ModelName );
 			g_YLine+=16.0f;
 
-			u32 NumLayer=g_arrActiveLayers.size();
-			g_pIRenderer->Draw2dLabel( 1,g_YLine, 1.3f, fColor, false,"g_arrActiveLayers %d %s",g_arrActiveLayers.size(),m_pMesh->getAnimationInfo(0)->strName );
+			u32 NumLayer=m_arrActiveLayers.size();
+			g_pIRenderer->Draw2dLabel( 1,g_YLine, 1.3f, fColor, false,"m_arrActiveLayers %d %s",m_arrActiveLayers.size(),m_pMesh->getAnimationInfo(0)->strName );
 			g_YLine+=0x10;
 
-			for (ActiveLayerArray::const_iterator it = g_arrActiveLayers.begin(); it != g_arrActiveLayers.end(); ++it)
+			for (ActiveLayerArray::const_iterator it = m_arrActiveLayers.begin(); it != m_arrActiveLayers.end(); ++it)
 			{
 				float fColor[4] = {1,1,1,1};
 				const char* AnimationName = m_pMesh->GetName(it->nAnimId);
-				g_pIRenderer->Draw2dLabel( 1,g_YLine, 1.3f, fColor, false,"g_arrActiveLayers.nAnimId %d %s",it->nAnimId, AnimationName );
+				g_pIRenderer->Draw2dLabel( 1,g_YLine, 1.3f, fColor, false,"m_arrActiveLayers.nAnimId %d %s",it->nAnimId, AnimationName );
 				g_YLine+=0x10;
 			}
 			g_YLine+=0x10;
@@ -509,9 +518,17 @@ if (g_YLine==16.0f) {
 		}
 		*/
 
-		if (bUpdateBones)
+		if (bUpdateBones && bDeferBones)
+		{
+			// the animations get loaded here, EvaluateDeferredPoses() may run on other threads
+			PrepareBoneUpdate (m_arrActiveLayers);
+			m_nDeferredPose = (int)g_arrDeferredPoses.size();
+			g_arrDeferredPoses.push_back(this);
+			m_uFlags |= nFlagsNeedReskinAllLODs;
+		}
+		else if (bUpdateBones)
 		{
-			UpdateBones (g_arrActiveLayers);
+			UpdateBones (m_arrActiveLayers);
 			UpdateBBox(); //use vertices for update
 			m_uFlags |= nFlagsNeedReskinAllLODs;
 		}
@@ -547,11 +564,19 @@ void CryModelState::UpdateBones (const ActiveLayerArray& arrActiveLayers)
 
 	SelfValidate();
 	//PROFILE_FRAME(BoneUpdate);
-	unsigned numBones = this->numBones();
 	// now calculate the actual target PQ for each bone and apply that to it
 	if (arrActiveLayers.empty())
 		return;
 
+	PrepareBoneUpdate (arrActiveLayers);
+	EvaluateBones (arrActiveLayers);
+	FinishBoneUpdate();
+}
+
+
+// makes sure the animations of the layers are loaded; must be called on the main thread
+void CryModelState::PrepareBoneUpdate (const ActiveLayerArray& arrActiveLayers)
+{
 #ifdef _DEBUG
 	//if (g_GetCVars()->ca_AnimWarningLevel()>=2)
 	{
@@ -583,18 +608,112 @@ void CryModelState::UpdateBones (const ActiveLayerArray& arrActiveLayers)
 	}
 #endif
 
+	// loading an animation isn't thread safe, so it's done before the bones are evaluated
+	for (ActiveLayerArray::const_iterator it = arrActiveLayers.begin(); it != arrActiveLayers.end(); ++it)
+		m_pMesh->OnAnimationApply(it->nAnimId);
+}
+
+
+// applies the layers to the bones and builds the global matrices.
+// Only this instance is modified, so different instances may be evaluated on different threads
+void CryModelState::EvaluateBones (const ActiveLayerArray& arrActiveLayers)
+{
 	if (arrActiveLayers.size() == 1)
 		ApplyAnimationToBones (arrActiveLayers.back());
 	else
 		ApplyAnimationsToBones (&arrActiveLayers[0], (unsigned)arrActiveLayers.size());
 
 	m_uFlags &= ~nFlagNeedBoneUpdate;
+}
 
+
+// updates what depends on the new bones and must be done on the main thread
+void CryModelState::FinishBoneUpdate()
+{
 	for (CryCharFxTrailArray::iterator it = m_arrFxTrails.begin(); it != m_arrFxTrails.end(); ++it)
 		if (*it)(*it)->Deform (getBoneGlobalMatrices());
 }
 
 
+// forgets the pending bone evaluation of this instance, if any
+void CryModelState::CancelDeferredPose()
+{
+	if (m_nDeferredPose < 0)
+		return;
+	assert (g_arrDeferredPoses[m_nDeferredPose] == this);
+	g_arrDeferredPoses[m_nDeferredPose] = NULL;
+	m_nDeferredPose = -1;
+}
+
+
+// the deferred poses evaluated by one thread: every nThreads-th starting from nThread
+struct DeferredPoseLane
+{
+	int nThread, nThreads;
+};
+
+void CryModelState::EvaluateDeferredPosesJob (void* pData)
+{
+	const DeferredPoseLane* pLane = (const DeferredPoseLane*)pData;
+	for (size_t i = pLane->nThread; i < g_arrDeferredPoses.size(); i += pLane->nThreads)
+	{
+		CryModelState* pState = g_arrDeferredPoses[i];
+		if (!pState)
+			continue;
+		pState->EvaluateBones (pState->m_arrActiveLayers);
+		pState->UpdateBBox();
+	}
+}
+
+
+// Evaluates the bones of all the instances that were processed with bDeferBones since the last call.
+// The list is only read by the jobs; the fx trails are updated afterwards, on this thread
+void CryModelState::EvaluateDeferredPoses (int nMaxThreads)
+{
+	if (g_arrDeferredPoses.empty())
+		return;
+
+	FUNCTION_PROFILER( g_GetISystem(),PROFILE_ANIMATION );
+
+	IJobManager* pJobManager = g_GetISystem()->GetIJobManager();
+	int nThreads = 1;
+	if (pJobManager && g_GetCVars()->ca_ParallelUpdate())
+		nThreads = pJobManager->GetWorkerCount() + 1;
+	if (nMaxThreads > 0 && nThreads > nMaxThreads)
+		nThreads = nMaxThreads;
+	if (nThreads > (int)g_arrDeferredPoses.size())
+		nThreads = (int)g_arrDeferredPoses.size();
+
+	enum {nMaxLanes = 32};
+	DeferredPoseLane arrLanes[nMaxLanes];
+	if (nThreads > nMaxLanes)
+		nThreads = nMaxLanes;
+
+	// lane 0 is evaluated by this thread
+	JobCounter jobs;
+	for (int nThread = 0; nThread < nThreads; ++nThread)
+	{
+		arrLanes[nThread].nThread  = nThread;
+		arrLanes[nThread].nThreads = nThreads;
+		if (nThread)
+			pJobManager->AddJob (EvaluateDeferredPosesJob, &arrLanes[nThread], &jobs);
+	}
+	EvaluateDeferredPosesJob (&arrLanes[0]);
+	if (nThreads > 1)
+		pJobManager->WaitForJobs (&jobs);
+
+	for (size_t i = 0; i < g_arrDeferredPoses.size(); ++i)
+	{
+		CryModelState* pState = g_arrDeferredPoses[i];
+		if (!pState)
+			continue;
+		pState->m_nDeferredPose = -1;
+		pState->FinishBoneUpdate();
+	}
+	g_arrDeferredPoses.clear();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 // Calculates the relative-to-parent position and rotation of the bone
 // applies the given set of animations, the last overrides the first
@@ -607,8 +726,6 @@ void CryModelState::ApplyAnimationsToBones (const CAnimationLayerInfo* pAnims, u
 {
 	FUNCTION_PROFILER( g_GetISystem(),PROFILE_ANIMATION );
 	SelfValidate();
-	for (unsigned i = 0; i < numAnims; ++i)
-		m_pMesh->OnAnimationApply(pAnims[i].nAnimId);
 	assert(numAnims > 1);
 	CryBone* pBoneBegin = &m_arrBones[0], *pBone = pBoneBegin;
 	CryBone* pBoneEnd = pBone + numBones();
@@ -685,7 +802,6 @@ void CryModelState::ApplyAnimationToBones (CAnimationLayerInfo rAnim)
 {
 	FUNCTION_PROFILER( g_GetISystem(),PROFILE_ANIMATION );
 	SelfValidate();
-	m_pMesh->OnAnimationApply(rAnim.nAnimId);
 	CryBone* pBoneBegin = &m_arrBones[0], *pBone = pBoneBegin;
 	CryBone* pBoneEnd = pBone + numBones();
 	const CryBoneInfo* pBoneInfoBegin = getBoneInfo(0), *pBoneInfo = pBoneInfoBegin;
@@ -1428,7 +1544,7 @@ void CryModelState::initClass()
 void CryModelState::deinitClass()
 {
 	//assert(g_arrEmptyAnimEventArray.empty());
-	g_arrActiveLayers.clear();
+	g_arrDeferredPoses.clear();
 }
 
 
@@ -1628,11 +1744,12 @@ CryModel* CryModelState::getAnimationSet()
 void CryModelState::GetSize(ICrySizer* pSizer)
 {
 #if ENABLE_GET_MEMORY_USAGE
-	pSizer->AddContainer(g_arrActiveLayers);
+	pSizer->AddContainer(g_arrDeferredPoses);
 	
 	unsigned i;
 	size_t nSize = sizeof(*this);
 	nSize += sizeofArray (m_arrAnimationLayers);
+	nSize += sizeofArray (m_arrActiveLayers);
 	nSize += sizeofArray (m_arrBoneGlobalMatrices, numBones());
 	nSize += sizeofArray (m_arrBones);
 	nSize += sizeofArray (m_arrHeatSources);
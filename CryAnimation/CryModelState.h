@@ -95,7 +95,12 @@ public:
 
 	void Render(const struct SRendParams & RendParams, Matrix44& mtxObjMatrix, struct CryCharInstanceRenderParams& rCharParams, const Vec3& t);
   
-  void ProcessAnimations(float deltatime_anim, bool bUpdateBones, CryCharInstance* instance); // Process this model's animations
+  void ProcessAnimations(float deltatime_anim, bool bUpdateBones, CryCharInstance* instance, bool bDeferBones = false); // Process this model's animations
+
+	// Evaluates the bones of all the instances that were processed with bDeferBones since the last call.
+	// With ca_ParallelUpdate the instances are distributed among the job manager threads,
+	// nMaxThreads limits the number of threads used (0 - all of them)
+	static void EvaluateDeferredPoses (int nMaxThreads = 0);
 
   CryModelState* MakeCopy();    // Makes an exact copy of this 
                                 // model and returns it
@@ -375,10 +380,19 @@ private:
 	std::vector<float> m_arrLayerSpeedScale;
 
 
-	// this array is used for temporal storage many times on every frame to compute the animations
-	// to apply to the character instance. In order to avoid frequent reallocations, it's here
+	// the animations to apply to the bones, computed by the last ProcessAnimations.
+	// It's per instance, because a deferred bone update uses it later, possibly on another thread;
+	// the capacity is kept, so there are no reallocations in the steady state
 	typedef std::vector<CAnimationLayerInfo> ActiveLayerArray;
-	static ActiveLayerArray g_arrActiveLayers;
+	ActiveLayerArray m_arrActiveLayers;
+
+	// the instances waiting for EvaluateDeferredPoses(); removed instances leave NULL
+	static std::vector<CryModelState*> g_arrDeferredPoses;
+	// index of this instance in g_arrDeferredPoses, -1 if its bones aren't waiting for evaluation
+	int m_nDeferredPose;
+	// forgets the pending bone evaluation of this instance, if any
+	void CancelDeferredPose();
+	static void EvaluateDeferredPosesJob (void* pData);
 
 	// updates the *ModEff* - adds the given delta to the current time,
 	// calls the callbacks, etc. Returns the array describing the updated anim layers,
@@ -389,6 +403,12 @@ private:
 	// applies the animation layers to the bones
 	void UpdateBones (const ActiveLayerArray& arrActiveLayers);
 
+	// the three steps of UpdateBones. Only EvaluateBones may run on a job thread:
+	// it touches nothing but this instance, the others load animations and update the fx.
+	void PrepareBoneUpdate (const ActiveLayerArray& arrActiveLayers);
+	void EvaluateBones (const ActiveLayerArray& arrActiveLayers);
+	void FinishBoneUpdate ();
+
 	void ApplyAnimationToBones (CAnimationLayerInfo AnimLayer);
 	void ApplyAnimationsToBones (const CAnimationLayerInfo* pAnims, unsigned numAnims);
 
@@ -16,9 +16,11 @@
 #include "CryModEffMorph.h"
 #include "CrySkinMorph.h"
 #include "CrySkinFull.h"
+#include "CrySkinRigidBasis.h"
 #include "CryCharInstance.h"
 #include "DebugUtils.h"
 #include "Cry_Camera.h"
+#include <IJobManager.h>
 
 // initializes and binds the submesh to the given model
 // there's no way to change the model at runtime
@@ -494,6 +496,28 @@ void CryModelSubmesh::MorphWithSkin (Vec3d* pDst, Vec3dA16* pDstNormalsA16)
 
 
 
+// a bone range of the tangent basis skin, skinned by a job while Deform skins the vertices
+struct TangSkinJob
+{
+	const CrySkinRigidBasis* pSkin;
+	const Matrix44* pBones;
+	SPipTangentsA* pDest;
+	unsigned nBoneBegin, nBoneEnd;
+	bool bSSE;
+};
+
+static void SkinTangentsJob (void* pData)
+{
+	const TangSkinJob* pJob = (const TangSkinJob*)pData;
+#if defined(_CPU_X86) && !defined(LINUX)
+	if (pJob->bSSE)
+		pJob->pSkin->skinSSE (pJob->pBones, pJob->pDest, pJob->nBoneBegin, pJob->nBoneEnd);
+	else
+#endif
+		pJob->pSkin->skin (pJob->pBones, pJob->pDest, pJob->nBoneBegin, pJob->nBoneEnd);
+}
+
+
 // Software skinning: calculate positions and normals
 //////////////////////////////////////////////////////////////////////
 void CryModelSubmesh::Deform( int nLodToDeform, unsigned nDeformFlags)
@@ -600,8 +624,50 @@ void CryModelSubmesh::Deform( int nLodToDeform, unsigned nDeformFlags)
 		else
 			nDeformFlags &= ~FLAG_DEFORM_UPDATE_TANGENTS;
 	}
-	// we won't need tangents simultaneously with the vertices/normals
-	g_Temp.reserve (max(sizeTangents, sizeVertices+sizeNormals));
+	// the tangents may be skinned by jobs while the vertices and normals are skinned here;
+	// then they get their own part of the temporary storage after the vertices and normals
+	enum {nMaxTangSkinJobs = 8};
+	TangSkinJob arrTangJobs[nMaxTangSkinJobs];
+	JobCounter jobsTangents;
+	IJobManager* pJobManager = g_GetISystem()->GetIJobManager();
+	bool bTangentJobs = pTangSkin && g_GetCVars()->ca_EnableTangentSkinning() && g_GetCVars()->ca_ParallelSkinning()
+		&& pJobManager && pJobManager->GetWorkerCount() > 0;
+
+	if (bTangentJobs)
+		g_Temp.reserve (sizeVertices+sizeNormals+sizeTangents);
+	else
+		// we won't need tangents simultaneously with the vertices/normals
+		g_Temp.reserve (max(sizeTangents, sizeVertices+sizeNormals));
+
+	if (bTangentJobs)
+	{
+		assert(m_pMesh->numBoneInfos());
+		pTangentBases = (SPipTangentsA*)((char*)g_Temp.data() + sizeVertices + sizeNormals);
+
+		unsigned numJobs = (unsigned)pJobManager->GetWorkerCount();
+		if (numJobs > nMaxTangSkinJobs)
+			numJobs = nMaxTangSkinJobs;
+		unsigned arrBounds[nMaxTangSkinJobs+1];
+		pTangSkin->splitBones (arrBounds, numJobs);
+
+		for (unsigned nJob = 0; nJob < numJobs; ++nJob)
+		{
+			if (arrBounds[nJob] == arrBounds[nJob+1])
+				continue;
+			TangSkinJob& job = arrTangJobs[nJob];
+			job.pSkin      = pTangSkin;
+			job.pBones     = m_pParent->getBoneGlobalMatrices();
+			job.pDest      = pTangentBases;
+			job.nBoneBegin = arrBounds[nJob];
+			job.nBoneEnd   = arrBounds[nJob+1];
+#if defined(_CPU_X86) && !defined(LINUX)
+			job.bSSE = g_GetCVars()->ca_SSEEnable() && cpu::hasSSE();
+#else
+			job.bSSE = false;
+#endif
+			pJobManager->AddJob (SkinTangentsJob, &job, &jobsTangents);
+		}
+	}
 
 	const unsigned* pExtToIntMap = pGeomInfo->getExtToIntMapEntries();
 
@@ -708,15 +774,24 @@ if((nDeformFlags&FLAG_DEFORM_UPDATE_TANGENTS)/* && pTangents*/)
 			// this is the number of bases and the bases themselves, as
 			// they are to be copied to the videomemory (directly)
 
-			pTangentBases = (SPipTangentsA*)g_Temp.data(); // use the same mem for the tangents
-			assert(m_pMesh->numBoneInfos());
 			numTangents = pTangSkin->size();
+			if (bTangentJobs)
+			{
+				// skinned by the jobs started before the vertices
+				DEFINE_PROFILER_SECTION("WaitForTangentSkin");
+				pJobManager->WaitForJobs (&jobsTangents);
+			}
+			else
+			{
+				pTangentBases = (SPipTangentsA*)g_Temp.data(); // use the same mem for the tangents
+				assert(m_pMesh->numBoneInfos());
 			#if defined(_CPU_X86) && !defined(LINUX)
 				if (g_GetCVars()->ca_SSEEnable() && cpu::hasSSE())
 					pTangSkin->skinSSE (m_pParent->getBoneGlobalMatrices(), pTangentBases);
 				else
 			#endif
 				pTangSkin->skin (m_pParent->getBoneGlobalMatrices(), pTangentBases);
+			}
 
 			#if 0 && defined(_DEBUG)
 				for (unsigned nTang = 0; nTang < numTangents; ++nTang)
@@ -817,12 +892,13 @@ const Vec3d* CryModelSubmesh::SelfSkin(int nLOD, Vec3d*pVertices, Vec3dA16* pNor
 				pVertices = (Vec3d*)g_Temp.data();
 			}
 			CrySkinFull* pSkin = pGeomInfo->getGeomSkin();
-			pSkin->skinSSE (m_pParent->getBoneGlobalMatrices(), (Vec3dA16*)pVertices);
+			DEFINE_ALIGNED_DATA( CryBBoxA16, bbox, 16 );
+			pSkin->skinSSE (m_pParent->getBoneGlobalMatrices(), (Vec3dA16*)pVertices, &bbox);
 			packVec3d16 (pVertices, numVertices);
 
 			CryAABB caabb;
-			caabb.vMin=pSkin->g_BBox.vMin.v;
-			caabb.vMax=pSkin->g_BBox.vMax.v;
+			caabb.vMin=bbox.vMin.v;
+			caabb.vMax=bbox.vMax.v;
 			m_SubBBox = caabb;
 			m_nLastSkinBBoxUpdateFrameId = g_nFrameID;
 		}
@@ -299,14 +299,12 @@ void CrySkinFull::validate (const ICrySkinSource* pGeometry)
 
 #if ( defined (_CPU_X86) || defined (_CPU_AMD64) ) & !defined(LINUX)
 
-DEFINE_ALIGNED_DATA( CryBBoxA16, CrySkinFull::g_BBox, 32 ); // align by cache line boundaries
-
 #if defined (_CPU_AMD64)
 extern "C" void Amd64Skinner(CrySkinAuxInt* pAux, CrySkinVertexAligned* pVertex, Vec3dA16* pDest, const Matrix44* pBone, Vec3dA16* pvMin,const Matrix44* pBoneEnd);
 #endif
 
 
-void CrySkinFull::skinSSE (const Matrix44* pBones, Vec3dA16* pDest)
+void CrySkinFull::skinSSE (const Matrix44* pBones, Vec3dA16* pDest, CryBBoxA16* pBBox)
 {	
 
 #ifdef DEFINE_PROFILER_FUNCTION
@@ -319,15 +317,15 @@ void CrySkinFull::skinSSE (const Matrix44* pBones, Vec3dA16* pDest)
 	Vertex* pVertex = &m_arrVertices[0];
 
 	// set the bbox to the negative volume to make sure the bbox will calculate starting from the first vertex
-	g_BBox.vMin.v = Vec3d(1e6,1e6,1e6);// = pBone->GetTranslation();
-	g_BBox.vMax.v = Vec3d(-1e6,-1e6,-1e6);// = pBone->GetTranslation();
+	pBBox->vMin.v = Vec3d(1e6,1e6,1e6);// = pBone->GetTranslation();
+	pBBox->vMax.v = Vec3d(-1e6,-1e6,-1e6);// = pBone->GetTranslation();
 
 #if FOR_TEST
 	for (int i = 0; i < g_GetCVars()->ca_TestSkinningRepeats(); ++i)
 #endif
 
 #if defined(_CPU_AMD64)
-	Amd64Skinner(pAux, pVertex, pDest, pBone, &g_BBox.vMin, pBoneEnd);
+	Amd64Skinner(pAux, pVertex, pDest, pBone, &pBBox->vMin, pBoneEnd);
 #else
 		_asm
 		{	
@@ -386,12 +384,14 @@ void CrySkinFull::skinSSE (const Matrix44* pBones, Vec3dA16* pDest)
 			//----------------------
 			// Calculation of BBox
 			// xmm5 will be the min, xmm6 will be the max of bbox
+			// EAX is free after the store, it points to the bbox {vMin,vMax}
+			mov EAX, pBBox
 			movaps xmm5, xmm7
 			movaps xmm6, xmm7
-			minps xmm5, g_BBox.vMin
-			maxps xmm6, g_BBox.vMax
-			movaps g_BBox.vMin, xmm5
-			movaps g_BBox.vMax, xmm6
+			minps xmm5, [EAX]
+			maxps xmm6, [EAX+0x10]
+			movaps [EAX], xmm5
+			movaps [EAX+0x10], xmm6
 
 			loop startLoopRigid
 	endLoopRigid:
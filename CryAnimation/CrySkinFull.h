@@ -20,9 +20,9 @@ public:
 	void skinAsVec3d16 (const Matrix44* pBones, Vec3dA16* pDest);
 #if ( defined (_CPU_X86) || defined (_CPU_AMD64) ) & !defined(LINUX)
 	// skins using the given bone matrices, into the given destination array,
-	// SIDE EFFECT: calculates the bounding box into the g_BBox
-	void skinSSE (const Matrix44* pBones, Vec3dA16* pDest);	
-	DEFINE_ALIGNED_DATA_STATIC( CryBBoxA16, g_BBox, 32 ); // align by cache line boundaries
+	// SIDE EFFECT: calculates the bounding box (of the rigid vertices) into pBBox, which must be 16-aligned.
+	// Doesn't touch any shared data, so different characters can be skinned on different threads
+	void skinSSE (const Matrix44* pBones, Vec3dA16* pDest, CryBBoxA16* pBBox);	
 #endif
 
 	// takes each offset and includes it into the bbox of corresponding bone
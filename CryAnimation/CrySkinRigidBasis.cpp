@@ -63,9 +63,40 @@ void CrySkinRigidBasis::CStatistics::addDest(unsigned nDest)
 }
 
 
+// returns the first aux counter and the first vertex of the given bone
+void CrySkinRigidBasis::getBoneStart (unsigned nBone, const CrySkinAuxInt*& pAux, const Vertex*& pVertex)const
+{
+	assert (nBone >= m_numSkipBones && nBone <= m_numBones);
+	pAux = &m_arrAux[0];
+	pVertex = &m_arrVertices[0];
+	// each bone has two groups (non-flipped and flipped), two vertices per basis
+	for (unsigned i = m_numSkipBones; i < nBone; ++i, pAux += 2)
+		pVertex += (pAux[0] + pAux[1]) << 1;
+}
+
+
+// splits the bones into numParts ranges with about the same number of bases each:
+// fills in numParts+1 bone indices, part i is [pBounds[i], pBounds[i+1])
+void CrySkinRigidBasis::splitBones (unsigned* pBounds, unsigned numParts)const
+{
+	const CrySkinAuxInt* pAux = &m_arrAux[0];
+	unsigned nPart = 0, numBases = 0;
+	pBounds[0] = m_numSkipBones;
+	for (unsigned nBone = m_numSkipBones; nBone < m_numBones && nPart + 1 < numParts; ++nBone, pAux += 2)
+	{
+		numBases += pAux[0] + pAux[1];
+		// the part ends after the bone that reaches its share of the bases
+		if (numBases * numParts >= m_numDestBases * (nPart + 1))
+			pBounds[++nPart] = nBone + 1;
+	}
+	while (nPart < numParts)
+		pBounds[++nPart] = m_numBones;
+}
+
+
 // does the skinning out of the given array of global matrices:
 // calculates the bases and fills the PipVertices in
-void CrySkinRigidBasis::skin (const Matrix44* pBones, SPipTangentsA* pDest)const
+void CrySkinRigidBasis::skin (const Matrix44* pBones, SPipTangentsA* pDest, unsigned nBoneBegin, unsigned nBoneEnd)const
 {
 #ifdef DEFINE_PROFILER_FUNCTION
 	DEFINE_PROFILER_FUNCTION();
@@ -75,9 +106,10 @@ void CrySkinRigidBasis::skin (const Matrix44* pBones, SPipTangentsA* pDest)const
 	for (int i = 0; i < g_GetCVars()->ca_TestSkinningRepeats(); ++i)
 #endif
 	{
-		const Matrix44* pBone = pBones + m_numSkipBones, *pBonesEnd = pBones + m_numBones;
-		const CrySkinAuxInt* pAux = &m_arrAux[0];
-		const Vertex* pVertex = &m_arrVertices[0];
+		const Matrix44* pBone = pBones + nBoneBegin, *pBonesEnd = pBones + nBoneEnd;
+		const CrySkinAuxInt* pAux;
+		const Vertex* pVertex;
+		getBoneStart (nBoneBegin, pAux, pVertex);
 
 		for (; pBone!= pBonesEnd; ++pBone)
 		{
@@ -121,7 +153,7 @@ void CrySkinRigidBasis::skin (const Matrix44* pBones, SPipTangentsA* pDest)const
 #if defined(_CPU_X86) && !defined(LINUX)
 // uses SSE for skinning; NOTE: EVERYTHING must be 16-aligned:
 // destination, bones, and the data in this object
-void CrySkinRigidBasis::skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)const
+void CrySkinRigidBasis::skinSSE (const Matrix44* pBones, SPipTangentsA* pDest, unsigned nBoneBegin, unsigned nBoneEnd)const
 {
 #ifdef DEFINE_PROFILER_FUNCTION
 	DEFINE_PROFILER_FUNCTION();
@@ -130,16 +162,17 @@ void CrySkinRigidBasis::skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)co
 #if defined(_DEBUG) && FOR_TEST
 	TElementaryArray<SPipTangentsA> arrTest ("CrySkinRigidBasis::skinSSE");
 	arrTest.reinit(size());
-  skin (pBones, &arrTest[0]);
+  skin (pBones, &arrTest[0], nBoneBegin, nBoneEnd);
 #endif
 
 #if FOR_TEST
 	for (int i = 0; i < g_GetCVars()->ca_TestSkinningRepeats(); ++i)
 #endif
 	{
-		const Matrix44* pBone = pBones + m_numSkipBones, *pBoneEnd = pBones + m_numBones;
-		const CrySkinAuxInt* pAux = &m_arrAux[0];
-		const Vertex* pVertex = &m_arrVertices[0];
+		const Matrix44* pBone = pBones + nBoneBegin, *pBoneEnd = pBones + nBoneEnd;
+		const CrySkinAuxInt* pAux;
+		const Vertex* pVertex;
+		getBoneStart (nBoneBegin, pAux, pVertex);
 
 		_asm
 		{	
@@ -372,9 +405,12 @@ void CrySkinRigidBasis::skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)co
 		}
 	}
 #if defined(_DEBUG) && FOR_TEST
-	unsigned numBases = 0;
+	const CrySkinAuxInt* pAuxBegin;
+	const Vertex* pVertexBegin;
+	getBoneStart (nBoneBegin, pAuxBegin, pVertexBegin);
+	unsigned numBases = unsigned(pVertexBegin - &m_arrVertices[0]) / 2;
 
-	for (unsigned nBone = m_numSkipBones; nBone < m_numBones; ++nBone)
+	for (unsigned nBone = nBoneBegin; nBone < nBoneEnd; ++nBone)
 	{
 		assert (numBases < size());
 		const CrySkinAuxInt* pAux = &m_arrAux[(nBone-m_numSkipBones)*2];
@@ -404,7 +440,7 @@ void CrySkinRigidBasis::skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)co
 			assert (dT < 1e-6 && dB < 1e-6 && dN < 1e-6);
 		}
 	}
-	assert (numBases == size());
+	assert (numBases <= size());
 #endif
 }
 #endif
@@ -25,12 +25,21 @@ public:
 
 	// does the skinning out of the given array of global matrices:
 	// calculates the bases and fills the PipVertices in
-	void skin (const Matrix44* pBones, SPipTangentsA* pDest)const;
+	void skin (const Matrix44* pBones, SPipTangentsA* pDest)const {skin (pBones, pDest, m_numSkipBones, m_numBones);}
+	// skins only the bases of the bones [nBoneBegin, nBoneEnd), m_numSkipBones <= nBoneBegin <= nBoneEnd <= m_numBones.
+	// Each basis belongs to exactly one bone, so different ranges may be skinned into the same destination
+	// on different threads at the same time
+	void skin (const Matrix44* pBones, SPipTangentsA* pDest, unsigned nBoneBegin, unsigned nBoneEnd)const;
 #if defined(_CPU_X86) && !defined(LINUX)
 	// uses SSE for skinning; NOTE: EVERYTHING must be 16-aligned:
 	// destination, bones, and the data in this object
-	void skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)const;
+	void skinSSE (const Matrix44* pBones, SPipTangentsA* pDest)const {skinSSE (pBones, pDest, m_numSkipBones, m_numBones);}
+	void skinSSE (const Matrix44* pBones, SPipTangentsA* pDest, unsigned nBoneBegin, unsigned nBoneEnd)const;
 #endif
+
+	// splits the bones into numParts ranges with about the same number of bases each:
+	// fills in numParts+1 bone indices, part i is [pBounds[i], pBounds[i+1])
+	void splitBones (unsigned* pBounds, unsigned numParts)const;
 	friend class CrySkinBasisBuilder;
 
 	// does the same as the base class init() but also remembers the number of bases (numVerts/2)
@@ -64,6 +73,9 @@ public:
 
 	unsigned Serialize (bool bSave, void* pBuffer, unsigned nBufSize);
 protected:
+	// returns the first aux counter and the first vertex of the given bone
+	void getBoneStart (unsigned nBone, const CrySkinAuxInt*& pAux, const Vertex*& pVertex)const;
+
 	// The size of the skin, the number of bases being calculated
 	// by this skin. The bases are calculated into a 0-base continuous array
 	unsigned m_numDestBases;
@@ -290,4 +290,12 @@ DECLARE_FLOAT_VARIABLE (ca_DeathBlendTime, 0.3, "Specifies the blending time bet
 
 DECLARE_INT_VARIABLE_IMMEDIATE (ca_DecalAntiflickerHack, 1, "Enable this to draw decals only during light or fog pass - can be used to reduce decal flickering on characters");
 
-DECLARE_FLOAT_VARIABLE(ca_BoundZOffset, 0.0015f, "This is the relative offset of the bound objects with the corresponding flag set. It's a hack to avoid hemlets from penetrating the head when looking at a character from far away");
\ No newline at end of file
+DECLARE_FLOAT_VARIABLE(ca_BoundZOffset, 0.0015f, "This is the relative offset of the bound objects with the corresponding flag set. It's a hack to avoid hemlets from penetrating the head when looking at a character from far away");
+
+DECLARE_INT_VARIABLE_IMMEDIATE (ca_ParallelUpdate, 1, "1 - the bones of the characters whose update was deferred (by the entity system) are evaluated on the job manager threads, 0 - on the main thread");
+
+DECLARE_INT_VARIABLE_IMMEDIATE (ca_ParallelSkinning, 1, "1 - the tangent bases are skinned by jobs while the vertices of the same character are skinned, 0 - everything is skinned on the rendering thread");
+
+DECLARE_INT_VARIABLE_IMMEDIATE (ca_BenchCharacters, 0, "Animates and skins the given number of characters with 1 to all job manager threads and logs ms/frame for each thread count, then resets itself to 0.\nThe model is ca_BenchModel or, if that's empty, the first loaded one");
+
+DECLARE_STRING_VARIABLE (ca_BenchModel, "");
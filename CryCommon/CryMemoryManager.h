@@ -31,6 +31,21 @@ struct CryModuleMemoryInfo
 	int num_allocations;
 };
 
+//! Structure filled by call to CryGetThreadCacheStats(), one per thread that uses the allocator
+struct CryThreadCacheStats
+{
+	//! Id of the thread owning the cache.
+	unsigned int thread_id;
+	//! Number of allocations/deallocations served by the cache.
+	unsigned int num_allocations;
+	unsigned int num_frees;
+	//! Number of batches taken from/given back to the shared allocator.
+	unsigned int num_refills;
+	unsigned int num_returns;
+	//! Size of the free objects currently held by the cache.
+	unsigned int cached_bytes;
+};
+
 #if defined(LINUX)
 #undef _ACCESS_POOL
 #undef _SYSTEM_POOL
@@ -88,6 +103,9 @@ struct CryModuleMemoryInfo
 	CRYMEMORYMANAGER_API void CryFreeSize(void *p,size_t size);
 	CRYMEMORYMANAGER_API int CryStats(char *buf);
 	CRYMEMORYMANAGER_API void CryFlushAll();
+	CRYMEMORYMANAGER_API void CryFlushThreadCache();
+	CRYMEMORYMANAGER_API int CryGetThreadCacheStats(CryThreadCacheStats *pStats, int nMax);
+	CRYMEMORYMANAGER_API void CryBenchmarkAllocator(int nThreads, int nAllocsPerThread);
 #endif
 
 #ifdef __cplusplus
@@ -1628,6 +1628,11 @@ struct I3DEngine : public IProcess
 	//   Gets the VisArea which is present at a specified point.
 	virtual	IVisArea * GetVisAreaFromPos(const Vec3 &vPos) = 0;	
 
+	// Description:
+	//   Same as GetVisAreaFromPos for a number of points, cheaper than separate calls.
+	//   ppAreas receives one VisArea (or NULL) per point.
+	virtual	void GetVisAreasFromPos(const Vec3 * pPos, int nCount, IVisArea ** ppAreas) = 0;
+
 	//! enable/disable outdoor water and beaches rendering
 
 	// Summary:
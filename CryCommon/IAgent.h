@@ -539,7 +539,7 @@ typedef struct GraphNode
 {
 	VectorOfLinks link;
 	ObstacleIndexVector vertex;
-	bool tag;
+	unsigned int nTag;	// tag generation of the graph this node was tagged in (see CGraph::IsTagged)
 	bool mark;
 	bool bCreated;		// is true if designer created node
 	float fHeuristic;
@@ -554,7 +554,7 @@ typedef struct GraphNode
 	{
 		bCreated = true;
 		link.reserve(5);	
-		tag = false;
+		nTag = 0;
 		data.Reset();
 		mark = false;
 		nRefCount = 0;
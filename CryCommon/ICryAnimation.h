@@ -1036,7 +1036,10 @@ struct ICryCharInstance: public IBindable
 	enum UpdateEnum
 	{
 		flagDontUpdateBones = 1,
-		flagDontUpdateAttachments = 1 << 1
+		flagDontUpdateAttachments = 1 << 1,
+		// only the animation time and the events are updated now, the bones are evaluated
+		// by the next ICryCharManager::UpdateDeferredCharacters (together with the other deferred characters)
+		flagDeferBoneUpdate = 1 << 2
 	};
 
   //! Processes skining (call this function every frame to animate character)
@@ -1358,6 +1361,14 @@ struct ICryCharManager
 	//     Update the Animation System
 	virtual void Update() = 0;
 
+	// Description:
+	//     Evaluates the bones of all the characters updated with ICryCharInstance::flagDeferBoneUpdate
+	//     since the last call. The characters are distributed among the job manager threads.
+	//     Must be called before the bones of those characters are used (physics, IK, rendering).
+	// Summary:
+	//     Evaluate the bones of the deferred characters
+	virtual void UpdateDeferredCharacters() = 0;
+
 	//! The specified animation will be unloaded from memory; it will be loaded back upon the first invokation (via StartAnimation())
 
 	// Description:
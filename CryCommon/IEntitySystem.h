@@ -1272,6 +1272,10 @@ struct IEntityContainer
 	//	todo: find better solution later like store lsourses in same place as other entity components - in entity
 	virtual float GetLightRadius() { return 0; }
 
+	//! tells if Write() gives the same data for every serverslot that uses the same clone state flags,
+	//! the server then encodes the entity once per frame and shares it between the slots
+	virtual bool IsNetWriteShareable() { return true; }
+
 	//! called before the entity is synched over network - to calculate priority or neccessarity
 	//! \param pXServerSlot must not be 0
 	//! \param inoutPriority 0 means no update at all
@@ -6,13 +6,31 @@
 // Job function prototype
 typedef void (*JobFunc)(void* pData);
 
+// ParallelFor body prototype, called for the index range [nBegin,nEnd)
+typedef void (*ParallelForFunc)(void* pData, int nBegin, int nEnd);
+
+// Counts the unfinished jobs that were added with it.
+// It can be waited for, and jobs can be added that only start when it reached 0 (dependency).
+// A job can add child jobs with the counter it was added with (e.g. passed in its data), the
+// counter then only reaches 0 when the children are done as well.
+// Must stay alive until it reached 0.
+struct JobCounter
+{
+    volatile long nJobs;
+
+    JobCounter() : nJobs(0) {}
+    bool IsDone() const { return nJobs == 0; }
+};
+
 struct Job
 {
-    JobFunc pFunc;
-    void*   pData;
+    JobFunc     pFunc;
+    void*       pData;
+    JobCounter* pCounter;
 
-    Job() : pFunc(0), pData(0) {}
-    Job(JobFunc f, void* d) : pFunc(f), pData(d) {}
+    Job() : pFunc(0), pData(0), pCounter(0) {}
+    Job(JobFunc f, void* d) : pFunc(f), pData(d), pCounter(0) {}
+    Job(JobFunc f, void* d, JobCounter* c) : pFunc(f), pData(d), pCounter(c) {}
 };
 
 struct IJobManager
@@ -25,9 +43,24 @@ struct IJobManager
     // Add a job to the queue
     virtual void AddJob(JobFunc pFunc, void* pData) = 0;
 
+    // Add a job that decrements pCounter when it is done (pCounter may be 0).
+    // If pDependsOn is given, the job is only started after pDependsOn reached 0.
+    virtual void AddJob(JobFunc pFunc, void* pData, JobCounter* pCounter, JobCounter* pDependsOn = 0) = 0;
+
     // Wait for all current jobs to finish
     // This is a simple synchronization barrier
     virtual void WaitForAllJobs() = 0;
+
+    // Wait until pCounter reached 0; the calling thread runs queued jobs meanwhile,
+    // so it may also be called from inside a job
+    virtual void WaitForJobs(JobCounter* pCounter) = 0;
+
+    // Splits [0,nCount) into ranges of at least nGranularity indices, runs them on the
+    // workers and the calling thread and returns when all are done
+    virtual void ParallelFor(int nCount, int nGranularity, ParallelForFunc pFunc, void* pData) = 0;
+
+    // Number of worker threads (the thread that waits runs jobs as well)
+    virtual int GetWorkerCount() = 0;
 };
 
 #endif // _IJOBMANAGER_H_
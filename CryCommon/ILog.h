@@ -100,6 +100,12 @@ struct ILog: public IMiniLog
 	virtual void	SetVerbosity( int verbosity ) = 0;
 
 	virtual int		GetVerbosityLevel()=0;
+
+	//writes the lines that are still queued to the log file, e.g. before the application dies
+	virtual void	Flush() {}
+
+	//same as Flush, for exception handlers: doesn't wait for a lock that the crashed thread may hold
+	virtual void	FlushAfterCrash() { Flush(); }
 };
 
 
@@ -32,6 +32,34 @@ enum {
 typedef int(*SCRIPT_FUNCTION)(HSCRIPT hScript);
 typedef int HBREAKPOINT;
 
+/*! key of a table member interned once with IScriptSystem::CreateKey.
+	GetValue/SetValue with it don't hash and look up the key string on every access,
+	use it for the members accessed every frame.
+*/
+struct ScriptKey
+{
+	int nRef;		//!< lua reference of the key string, 0 if not created
+
+	ScriptKey() : nRef(0) {}
+	bool IsValid() const { return nRef>0; }
+};
+
+//! state of the lua garbage collector, see IScriptSystem::GetGCStats
+struct ScriptGCStats
+{
+	int		nHeapKb;					//!< allocated by lua
+	int		nThresholdKb;			//!<
+	int		nState;						//!< 0=idle, 1=marking, 2=sweeping
+	int		nCycles;					//!< finished incremental cycles since the last reset
+	int		nSteps;						//!< incremental steps since the last reset
+	float	fLastStepTime;		//!< in ms
+	float	fMaxStepTime;			//!< in ms, since the last reset
+	float	fTotalStepTime;		//!< in ms, since the last reset
+	int		nPauses;					//!< full (stop the world) collections since the last reset
+	float	fLastPauseTime;		//!< in ms
+	float	fMaxPauseTime;		//!< in ms, since the last reset
+};
+
 enum BreakState{
 	bsStepNext,
 	bsStepInto,
@@ -274,6 +302,16 @@ struct IScriptSystem
 	*/
 	virtual void ForceGarbageCollection() = 0;
 
+	/*! does a frame budgeted part of an incremental garbage collection cycle (lua_GCStepSize)
+		@param bStartCycle starts a new cycle if none is running, otherwise only a running cycle is continued
+		@return false if the incremental collection is disabled (lua_IncrementalGC 0),
+			ForceGarbageCollection has to be used then
+	*/
+	virtual bool GarbageCollectionStep(bool bStartCycle) = 0;
+
+	//! @param bReset resets the cycle count and the max step time
+	virtual void GetGCStats(ScriptGCStats &stats,bool bReset) = 0;
+
 	/*! number of "garbaged" object
 	*/
 	virtual int GetCGCount() = 0;
@@ -322,6 +360,23 @@ struct IScriptSystem
 	// Called one time after initialization of system to register script system console vars.
 	//////////////////////////////////////////////////////////////////////////
 	virtual void PostInit() = 0;
+
+	//////////////////////////////////////////////////////////////////////////
+	// Number of executed script files that were loaded precompiled from the script cache
+	// and that had to be compiled from the source, since the last reset.
+	//////////////////////////////////////////////////////////////////////////
+	virtual void GetScriptCacheStats( int &nHits,int &nMisses,bool bReset ) = 0;
+
+	/*! Interns a key for the GetValue/SetValue overloads taking a ScriptKey
+		@param sKey member name
+		@return the key, it stays valid until ReleaseKey
+	*/
+	virtual ScriptKey CreateKey(const char *sKey) = 0;
+	//! the key is invalid afterwards
+	virtual void ReleaseKey(ScriptKey &key) = 0;
+	//! @param nAxis 0..2 
+	//! @return the interned key "x","y" or "z" of the vector tables
+	virtual const ScriptKey &GetVecKey(int nAxis) = 0;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -554,6 +609,32 @@ struct IScriptObject
 	//! @param szPath e.g. "cnt.table1.table2", "", "mytable", max 255 characters
 	//! @return true=path was valid, false otherwise
 	virtual bool GetValueRecursive( const char *szPath, IScriptObject *pObj ) = 0;
+
+	/*! Same as the GetValue/SetValue (and chain) functions with the key string,
+		but with a key created by IScriptSystem::CreateKey
+	*/
+	//##@{
+	virtual void SetValue(const ScriptKey &key, int nVal) = 0;
+	virtual void SetValue(const ScriptKey &key, float fVal) = 0;
+	virtual void SetValue(const ScriptKey &key, const char *sVal) = 0;
+	virtual void SetValue(const ScriptKey &key, bool bVal) = 0;
+	virtual void SetValue(const ScriptKey &key, IScriptObject *pObj) = 0;
+	virtual bool GetValue(const ScriptKey &key, int &nVal) = 0;
+	virtual bool GetValue(const ScriptKey &key, float &fVal) = 0;
+	virtual bool GetValue(const ScriptKey &key, bool &bVal) = 0;
+	virtual bool GetValue(const ScriptKey &key, const char* &sVal) = 0;
+	virtual bool GetValue(const ScriptKey &key, IScriptObject *pObj) = 0;
+	virtual void SetValueChain(const ScriptKey &key, int nVal) = 0;
+	virtual void SetValueChain(const ScriptKey &key, float fVal) = 0;
+	virtual void SetValueChain(const ScriptKey &key, const char *sVal) = 0;
+	virtual void SetValueChain(const ScriptKey &key, bool bVal) = 0;
+	virtual void SetValueChain(const ScriptKey &key, IScriptObject *pObj) = 0;
+	virtual bool GetValueChain(const ScriptKey &key, int &nVal) = 0;
+	virtual bool GetValueChain(const ScriptKey &key, float &fVal) = 0;
+	virtual bool GetValueChain(const ScriptKey &key, bool &bVal) = 0;
+	virtual bool GetValueChain(const ScriptKey &key, const char* &sVal) = 0;
+	virtual bool GetValueChain(const ScriptKey &key, IScriptObject *pObj) = 0;
+	//##@}
 };
 
 
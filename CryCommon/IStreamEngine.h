@@ -79,6 +79,24 @@ enum StreamReadParamsFlagEnum
 	SRP_QUICK_STARTREAD      = 1 << 7
 };
 
+// the priority classes of the reads (StreamReadParams::nPriorityClass).
+// All the waiting reads of a higher class are started before any read of a lower class;
+// inside a class, the reads that are due (see nLoadTime) go first, then the higher nPriority
+enum StreamPriorityClassEnum
+{
+	// someone waits for this read right now (the reads raised to INT_MAX priority get here too)
+	SRPC_URGENT = 0,
+	// the data is needed for the current view, e.g. the geometry or the textures of visible objects
+	SRPC_HIGH,
+	// the data is needed soon, but nothing stalls without it
+	SRPC_NORMAL,
+	// precaching, the data may be needed later; the default, so that a read that doesn't set
+	// its class doesn't delay the ones that do
+	SRPC_IDLE,
+
+	SRPC_COUNT
+};
+
 //////////////////////////////////////////////////////////////////////////
 // this is used as parameter to the asynchronous read function
 // all the unnecessary parameters go here, because there are many of them
@@ -94,7 +112,8 @@ struct StreamReadParams
 		unsigned _nOffset = 0,
 		unsigned _nSize = 0,
 		void* _pBuffer = NULL,
-		unsigned _nFlags = 0
+		unsigned _nFlags = 0,
+		unsigned _nPriorityClass = SRPC_IDLE
 	):
 		//szFile (_szFile),
 		//pCallback(_pCallback),
@@ -105,7 +124,8 @@ struct StreamReadParams
 		pBuffer (_pBuffer),
 		nOffset (_nOffset),
 		nSize (_nSize),
-		nFlags (_nFlags)
+		nFlags (_nFlags),
+		nPriorityClass (_nPriorityClass)
 	{
 	}
 
@@ -121,6 +141,7 @@ struct StreamReadParams
 
 	// the desirable loading time, in milliseconds, from the time of call
 	// 0 means as fast as possible (desirably in this frame)
+	// the reads of the same class that are due are started before the ones that aren't
 	unsigned nLoadTime;
 
 	// the maximum load time, in milliseconds. 0 means forever. If the read lasts longer, it can be discarded.
@@ -146,6 +167,9 @@ struct StreamReadParams
 
 	// the combination of one or several flags from StreamReadParamsFlagEnum
 	unsigned nFlags;
+
+	// one of StreamPriorityClassEnum
+	unsigned nPriorityClass;
 };
 
 class IReadStream;
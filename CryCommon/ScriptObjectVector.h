@@ -18,18 +18,29 @@ public _SmartScriptObject
 public:
 	CScriptObjectVector()
 	{
+		m_pSS=NULL;
 	}
 	CScriptObjectVector(IScriptSystem *pScriptSystem,bool bCreateEmpty=false):_SmartScriptObject(pScriptSystem,bCreateEmpty)
 	{
+		m_pSS=pScriptSystem;
 	}
 	
 	void Set(const Vec3 &v)
 	{
 		if(m_pSO->BeginSetGetChain())
 		{
-			m_pSO->SetValueChain("x",v.x);
-			m_pSO->SetValueChain("y",v.y);
-			m_pSO->SetValueChain("z",v.z);
+			if(m_pSS)
+			{
+				m_pSO->SetValueChain(m_pSS->GetVecKey(0),v.x);
+				m_pSO->SetValueChain(m_pSS->GetVecKey(1),v.y);
+				m_pSO->SetValueChain(m_pSS->GetVecKey(2),v.z);
+			}
+			else
+			{
+				m_pSO->SetValueChain("x",v.x);
+				m_pSO->SetValueChain("y",v.y);
+				m_pSO->SetValueChain("z",v.z);
+			}
 			m_pSO->EndSetGetChain();
 		}
 	}
@@ -38,9 +49,18 @@ public:
 		Vec3 v(0,0,0);
 		if(m_pSO->BeginSetGetChain())
 		{
-			m_pSO->GetValueChain("x",v.x);
-			m_pSO->GetValueChain("y",v.y);
-			m_pSO->GetValueChain("z",v.z);
+			if(m_pSS)
+			{
+				m_pSO->GetValueChain(m_pSS->GetVecKey(0),v.x);
+				m_pSO->GetValueChain(m_pSS->GetVecKey(1),v.y);
+				m_pSO->GetValueChain(m_pSS->GetVecKey(2),v.z);
+			}
+			else
+			{
+				m_pSO->GetValueChain("x",v.x);
+				m_pSO->GetValueChain("y",v.y);
+				m_pSO->GetValueChain("z",v.z);
+			}
 			m_pSO->EndSetGetChain();
 		}
 		else assert(0 && "validate before calling Get()");
@@ -58,6 +78,8 @@ public:
 		Set(v3);
 		return *this;
 	}
+private:
+	IScriptSystem *m_pSS;		//!< for the interned "x","y","z" keys, NULL with the default constructor
 };
 
 /*! this calss map an "color" to a LUA table with x,y,z members
@@ -1296,6 +1296,10 @@ struct PhysicsVars : SolverSettings {
 	float penaltyScale;
 	int bSkipRedundantColldet;
 	int bLimitSimpleSolverEnergy;
+	int nIslandWorkers;
+	int bLogStepChecksums;
+	int nRayBatchWorkers;
+	int nBenchmarkRays;
 };
 
 struct ray_hit {
@@ -1309,6 +1313,16 @@ struct ray_hit {
 	int bTerrain;
 };
 
+struct ray_query { // one ray of a RayWorldIntersectionBatch request; parameters have the same meaning as in RayWorldIntersection
+	vectorf org,dir;
+	int objtypes;
+	unsigned int flags;
+	ray_hit *hits;
+	int nMaxHits;
+	IPhysicalEntity *pSkipEnt,*pSkipEntAux;
+	int nHits; // output: the value RayWorldIntersection would have returned
+};
+
 class IPhysicalWorld {
 public:
 	/*! Inits world
@@ -1423,6 +1437,13 @@ public:
 	*/
 	virtual int RayWorldIntersection(vectorf org,vectorf dir, int objtypes, unsigned int flags, ray_hit *hits,int nMaxHits,
 		IPhysicalEntity *pSkipEnt=0,IPhysicalEntity *pSkipEntAux=0) = 0;
+	/*! Shoots a batch of rays into world; rays are distributed among p_ray_batch_workers threads, each ray fills only its own hits array
+		Must not be called while the world is being stepped or modified
+		@param pQueries array of ray descriptions, nHits of each receives the number of collisions
+		@param nQueries number of rays
+		@return total number of collisions
+	*/
+	virtual int RayWorldIntersectionBatch(ray_query *pQueries,int nQueries) = 0;
 
 	/*! Freezes (resets velocities of) all physical, living, and detached entities
 	*/
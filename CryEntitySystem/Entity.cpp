@@ -138,6 +138,9 @@ m_pObjectCollide(pSS),m_vObjPosCollide(pSS),m_vObjVelCollide(pSS),m_pSplashList(
 	}
 
 	// m_qsplat=NULL;
+	m_bRegistered = false;
+	m_nActiveIndex = -1;
+	m_nDeferredIndex = -1;
 	SetName("No entity loaded");
 
 	m_pSaveFunc = 0;
@@ -535,6 +538,7 @@ void CEntity::SetPos(const Vec3d &pos, bool	bWorldOnly /* = true */)
 		{
 			// If moved
 			m_awakeCounter = 1;
+			ActivateUpdate();
 		}
 		m_realcenter = pos;
 		return;
@@ -663,7 +667,7 @@ bool CEntity::Init(CEntityDesc &ed)
 {
 	m_nID = ed.id;
 	m_netPresence = ed.netPresence;
-	m_name = ed.name.c_str();
+	SetName(ed.name.c_str());
 	m_fScale = ed.scale;
 	//SetPos(ed.pos);
 	m_center = ed.pos;
@@ -754,6 +758,8 @@ bool CEntity::Init(CEntityDesc &ed)
 		if (m_pScriptObject->GetValue("Properties", pPropTable))
 			pPropTable->GetValue("bTrackable", bTrackable);
 		m_bTrackable = bTrackable;
+		if (bTrackable)
+			ActivateUpdate();
 	}
 
 	//Timur[1/31/2002] 
@@ -858,7 +864,18 @@ void CEntity::SetCommonCallbacks(IScriptSystem *pScriptSystem)
 //////////////////////////////////////////////////////////////////////////
 void CEntity::SetName(const char*name)
 {
+	if (m_bRegistered)
+		m_pEntitySystem->RemoveEntityName(this);
 	m_name = name;
+	if (m_bRegistered)
+		m_pEntitySystem->AddEntityName(this);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntity::ActivateUpdate()
+{
+	if (m_nActiveIndex<0 && m_bRegistered)
+		m_pEntitySystem->ActivateEntity(this);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -921,6 +938,7 @@ void CEntity::MoveTo(const Vec3d &pos, bool moveObjects, bool bUpdatePhysics)
 	// assign the new position
 	m_center = pos;
 	m_awakeCounter = 1; // Awake object for one frame at least if sleeping.
+	ActivateUpdate();
 
 	if (moveObjects)
 	{
@@ -1164,9 +1182,17 @@ void CEntity::Update( SEntityUpdateContext &ctx )
 	// Update Characters.
 	if (m_bUpdateCharacters || m_physPlaceholder)
 	{
-		UpdateCharacters( ctx );
+		// the rest is done by the entity system when the bones are evaluated
+		if (UpdateCharacters( ctx ))
+			return;
 	}
 
+	UpdateAfterCharacters( ctx );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntity::UpdateAfterCharacters( SEntityUpdateContext &ctx )
+{
 	// update camera
 	if (m_bUpdateCamera)
 	{
@@ -1189,15 +1215,20 @@ void CEntity::Update( SEntityUpdateContext &ctx )
 
 	if (m_bTrackColliders)
 		CheckColliders();
- 
-	return;
 }
 
 //////////////////////////////////////////////////////////////////////////
-void CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
+void CEntity::FinishCharacterUpdate( SEntityUpdateContext &ctx )
+{
+	UpdateCharacterPhysicsAndIK( ctx );
+	UpdateAfterCharacters( ctx );
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
 {
 	if(!m_pEntitySystem->m_pUpdateBonePositions->GetIVal())
-		return;
+		return false;
 
 	bool bProcess=m_bVisible;
 
@@ -1212,6 +1243,10 @@ void CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
 	if(m_eUpdateVisLevel == eUT_Physics)
 		bProcess = true;
 
+	// The bones of the top level entities are evaluated in parallel after the entity walk.
+	// Bound entities and the parents of bound entities need the bones right away.
+	bool bDefer = bProcess && m_pEntitySystem->m_bDeferCharacters && !m_bIsBound && !m_bForceBindCalculation && !m_bUpdateBinds && m_lstBindings.empty();
+
 	if(bProcess)
 	{
 		ENTITY_PROFILER
@@ -1220,7 +1255,7 @@ void CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
 		{
 			if(m_pCryCharInstance[k] && (m_pCryCharInstance[k]->GetFlags() & CS_FLAG_UPDATE))
 			{
-				m_pCryCharInstance[k]->Update(m_center,m_fRadius);  
+				m_pCryCharInstance[k]->Update(m_center,m_fRadius,bDefer ? ICryCharInstance::flagDeferBoneUpdate : 0);  
 
 				// recalc bbox if animated
 				if(m_pCryCharInstance[k]->IsCharacterActive())
@@ -1238,6 +1273,12 @@ void CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
 		}
 	}
 
+	if(bDefer)
+	{
+		m_pEntitySystem->DeferCharacterUpdate(this);
+		return true;
+	}
+
 	if(bProcess)
 	{
 		UpdateCharacterPhysicsAndIK( ctx );
@@ -1248,6 +1289,7 @@ void CEntity::UpdateCharacters( SEntityUpdateContext &ctx )
 		ps.nSensors = 0;
 		m_physic->SetParams(&ps);
 	}
+	return false;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -2407,6 +2449,7 @@ void CEntity::Bind(EntityId id,unsigned char cBind, const bool bClientOnly, cons
 	if (std::find(m_lstBindings.begin(), m_lstBindings.end(), id) == m_lstBindings.end())
 	{
 		m_bUpdateBinds = 1;
+		ActivateUpdate();
 		m_lstBindings.push_back(id);
 		pEntity->m_bIsBound = 1;
 		pEntity->m_bForceBindCalculation = 0;
@@ -2436,6 +2479,7 @@ void CEntity::Unbind(EntityId id,unsigned char cBind, const bool bClientOnly)
 		if (pEntity)
 		{
 			pEntity->m_bIsBound = false;
+			pEntity->ActivateUpdate();
 	
 			if(!bClientOnly)																			// to prevent circular loop between client and server
 				m_pEntitySystem->OnUnbind(GetId(),id,cBind);
@@ -3290,7 +3334,10 @@ void CEntity::SetParentLocale(const Matrix44 & matParent)
 {
 	// If matrices differ, entity moved so update it.
 	if (memcmp(&m_matParentMatrix,&matParent,sizeof(matParent)) != 0)
+	{
 		m_awakeCounter = 1; // Awake for at least one frame.
+		ActivateUpdate();
+	}
 	m_matParentMatrix = matParent;
 }
 
@@ -3393,6 +3440,8 @@ void CEntity::Hide( bool bHide)
 			CryLogComment( "Entity %s Hidden",m_name.c_str() );
 	}
 	m_bHidden = bHide;
+	if (!bHide)
+		ActivateUpdate();
 }
 
 
@@ -3637,6 +3686,7 @@ void CEntity::CallStateFunction( EScriptStateFunctions function )
 void CEntity::MarkAsGarbage()
 {
 	m_bGarbage = true;	
+	ActivateUpdate();
 	if (m_registeredInSector)
 		UnregisterInSector();
 }
@@ -3645,6 +3695,8 @@ void CEntity::MarkAsGarbage()
 void CEntity::SetGarbageFlag( bool bGarbage )
 {
 	m_bGarbage = bGarbage;
+	if (m_bGarbage)
+		ActivateUpdate();
 	if (m_bGarbage && m_registeredInSector)
 		UnregisterInSector();
 }
@@ -3759,6 +3811,7 @@ void CEntity::OnPhysicsBBoxOverlap(IEntity *pOther)
 
 	// Awake entity for at least 5 frames.
 	m_awakeCounter = 5;
+	ActivateUpdate();
 //#endif
 }
 
@@ -3770,6 +3823,7 @@ void CEntity::OnPhysicsStateChange( int nNewSymClass,int nPrevSymClass )
 	{
 		// Awake entity for few frames.
 		m_awakeCounter = 4;
+		ActivateUpdate();
 		if (nNewSymClass == SC_ACTIVE_RIGID)
 		{
 			//m_pISystem->GetILog()->Log("Phys AWAKE" );
@@ -3837,6 +3891,7 @@ void CEntity::TrackColliders( bool bEnable )
 		m_bTrackColliders = bEnable;
 		CreatePhysicsBBox();
 		m_awakeCounter = 5; // Awake entity for few updates.
+		ActivateUpdate();
 	}
 	m_bTrackColliders = bEnable;
 }
@@ -3855,6 +3910,7 @@ void CEntity::SetPhysicsState( const char *sPhysicsState )
 		m_physic->SetStateFromSnapshotTxt( sPhysicsState,strlen(sPhysicsState) );
 		// Update entity few times to get physics data to character.
 		m_awakeCounter = 5;
+		ActivateUpdate();
 	}
 }
 
@@ -3863,6 +3919,7 @@ void CEntity::InvalidateBBox()
 {
 	m_awakeCounter = 1;
 	m_bRecalcBBox = true;
+	ActivateUpdate();
 }
 
 
@@ -3870,6 +3927,7 @@ void CEntity::InvalidateBBox()
 void CEntity::SetUpdateVisLevel(EEntityUpdateVisLevel nUpdateVisLevel) 
 { 
 	m_eUpdateVisLevel = nUpdateVisLevel; 
+	ActivateUpdate();
 	if (m_physic)
 	{
 		pe_params_flags pf;
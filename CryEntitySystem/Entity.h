@@ -217,6 +217,8 @@ public:
 	void SetSleep( bool bSleep )
 	{
 		m_bSleeping = bSleep;
+		if (!bSleep)
+			ActivateUpdate();
 	}
 
 	/////////////////////////////////////////////////////////////////////////
@@ -359,12 +361,34 @@ public:
 	void SetNeedUpdate( bool needUpdate ) 
 	{ 
 		m_bUpdate = needUpdate; 
-		if (needUpdate) m_bSleeping = false; 
+		if (needUpdate)
+		{
+			m_bSleeping = false; 
+			ActivateUpdate();
+		}
 	}
 	bool NeedUpdate(){ return m_bUpdate;}
 
 	bool IsBound() { return m_bIsBound;}
 
+	//! True as long as CEntitySystem::Update has something to do with the entity
+	//! (removal, visibility tracking, update or update of the bound entities).
+	bool NeedsSystemUpdate() const
+	{
+		if (m_bGarbage)
+			return true;
+		if (m_bHidden)
+			return false;
+		if (m_bTrackable)
+			return true;
+		if (m_bIsBound || m_eUpdateVisLevel==eUT_PhysicsPostStep)
+			return false;
+		return (m_bUpdate && !m_bSleeping) || m_awakeCounter>0 || m_bUpdateBinds;
+	}
+	//! Puts the entity into the active list of the entity system again,
+	//! must be called whenever NeedsSystemUpdate may have changed to true.
+	void ActivateUpdate();
+
 	void SetRegisterInSectors( bool needToRegister );
 	
   bool IsMoving() const 
@@ -623,7 +647,13 @@ protected:
 	void UpdateCharacterPhysicsAndIK( SEntityUpdateContext &ctx );
 	void UpdateLipSync( SEntityUpdateContext &ctx );
 	void UpdateParticleEmitters( SEntityUpdateContext &ctx );
-	void UpdateCharacters( SEntityUpdateContext &ctx );
+	//! Returns true if the bones were deferred to CEntitySystem::UpdateDeferredCharacters,
+	//! the rest of the update is then done by FinishCharacterUpdate.
+	bool UpdateCharacters( SEntityUpdateContext &ctx );
+	//! Physics, IK and everything after the characters in Update, for the deferred characters.
+	void FinishCharacterUpdate( SEntityUpdateContext &ctx );
+	//! Camera, bbox, placeholders and colliders, the end of Update.
+	void UpdateAfterCharacters( SEntityUpdateContext &ctx );
 	//////////////////////////////////////////////////////////////////////////
 
 	//! Called from set position.
@@ -725,6 +755,7 @@ private:
 	unsigned int m_bWasVisible : 1;							//!< Remembers visibility state from the update before the last one
 	unsigned int m_bHasEnvLighting : 1;					//!< 
 	unsigned int m_bStateClientside : 1;				//!< prevents error when state changes on the client and does not sync state changes to the client 
+	unsigned int m_bRegistered : 1;							//!< In the entity map and the name index of the entity system.
 
 	//////////////////////////////////////////////////////////////////////////
 	//! As long as this counter is not 0, entity will be forced to be updated.
@@ -827,6 +858,10 @@ private:
 	int m_iPhysStateSize;
 
 	CEntitySystem *m_pEntitySystem;
+	//! Index in the active list of the entity system, -1 if not in it.
+	int m_nActiveIndex;
+	//! Index in the deferred character list of the entity system, -1 if not in it.
+	int m_nDeferredIndex;
 
 	IntToIntMap		m_mapSlotToPhysicalPartID;
 
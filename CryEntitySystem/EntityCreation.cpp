@@ -621,6 +621,7 @@ bool CEntity::CreateRigidBody(pe_type type, float density,float mass,int surface
 	m_physic->SetParams(&pf);
 
 	m_awakeCounter = 4;
+	ActivateUpdate();
 	// Timur[19/11/2003] This should not be here // SetNeedUpdate( true );
 
 	return true;
@@ -920,6 +921,7 @@ void CEntity::KillCharacter(int pos)
 			}
 			m_bIsADeadBody = 1;
 			m_awakeCounter = 4;
+			ActivateUpdate();
 			// Timur[19/11/2003] This should not be here //SetNeedUpdate( true );
 		}
 
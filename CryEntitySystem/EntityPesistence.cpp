@@ -580,6 +580,7 @@ bool CEntity::Load(CStream& stream , IScriptObject *pStream)
 	_VERIFY(stream.Read(nState));
 	GotoState(nState);
 	m_awakeCounter = 4; // give entity a chance to fetch the updated physics state
+	ActivateUpdate();
 
 	return true;
 }
@@ -628,6 +629,7 @@ bool CEntity::LoadPATCH1(CStream& stream , IScriptObject *pStream)
 	_VERIFY(stream.Read(nState));
 	GotoState(nState);
 	m_awakeCounter = 4; // give entity a chance to fetch the updated physics state
+	ActivateUpdate();
 
 	return true;
 }
@@ -675,6 +677,7 @@ bool CEntity::LoadRELEASE(CStream& stream , IScriptObject *pStream)
 	_VERIFY(stream.Read(nState));
 	GotoState(nState);
 	m_awakeCounter = 4; // give entity a chance to fetch the updated physics state
+	ActivateUpdate();
 
 	return true;
 }
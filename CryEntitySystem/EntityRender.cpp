@@ -75,6 +75,7 @@ bool CEntity::DrawEntity(const SRendParams & _EntDrawParams)
 		if (m_eUpdateVisLevel == eUT_PhysicsVisible || m_eUpdateVisLevel == eUT_Visible)
 		{
 			m_awakeCounter = 2;
+			ActivateUpdate();
 		}
 	}
 
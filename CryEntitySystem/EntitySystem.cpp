@@ -177,10 +177,14 @@ CEntitySystem::CEntitySystem(ISystem *pSystem)
 		"specifies whether cloth will be physicalized (0 or 1)");
 	m_pCharZOffsetSpeed = pSystem->GetIConsole()->CreateVariable("es_CharZOffsetSpeed","2.0",VF_DUMPTODISK,
 		"sets the character Z-offset change speed (in m/s), used for IK");
+	m_pDeferCharacterUpdate = pSystem->GetIConsole()->CreateVariable("es_DeferCharacterUpdate","1",VF_CHEAT,
+		"evaluates the bones of the characters of all the updated entities together on the job threads (0 or 1)");
+	m_bDeferCharacters=false;
 	m_bClient=false;
 	m_bServer=false;	
 	m_bTimersPause=false;
 	m_nStartPause=-1;
+	m_nActiveHoles=0;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -206,7 +210,100 @@ void CEntitySystem::InsertEntity( EntityId id, CEntity *pEntity )
 		
 //		CConsole::Exit("CEntitySystem::InsertEntity - Entity already in map !");
 
-	m_mapEntities.insert( EntityMap::value_type(id, pEntity) );
+	if (m_mapEntities.insert( EntityMap::value_type(id, pEntity) ).second)
+	{
+		// from now on it keeps the name index and the active list up to date
+		pEntity->m_bRegistered = true;
+		AddEntityName(pEntity);
+		ActivateEntity(pEntity);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::AddEntityName( CEntity *pEntity )
+{
+	m_mapEntityNames.insert( EntityNameMap::value_type(pEntity->m_name,pEntity) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::RemoveEntityName( CEntity *pEntity )
+{
+	std::pair<EntityNameMap::iterator,EntityNameMap::iterator> range = m_mapEntityNames.equal_range(pEntity->m_name);
+	for (EntityNameMap::iterator it = range.first; it != range.second; ++it)
+	{
+		if (it->second == pEntity)
+		{
+			m_mapEntityNames.erase(it);
+			break;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::ActivateEntity( CEntity *pEntity )
+{
+	if (pEntity->m_nActiveIndex >= 0)
+		return;
+	pEntity->m_nActiveIndex = (int)m_vActiveEntities.size();
+	m_vActiveEntities.push_back(pEntity);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::DeactivateEntity( CEntity *pEntity )
+{
+	if (pEntity->m_nActiveIndex < 0)
+		return;
+	// Update may be iterating over the list, the slot is only cleared
+	m_vActiveEntities[pEntity->m_nActiveIndex] = 0;
+	pEntity->m_nActiveIndex = -1;
+	m_nActiveHoles++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::DeferCharacterUpdate( CEntity *pEntity )
+{
+	if (pEntity->m_nDeferredIndex >= 0)
+		return;
+	pEntity->m_nDeferredIndex = (int)m_vDeferredCharacters.size();
+	m_vDeferredCharacters.push_back(pEntity);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::UpdateDeferredCharacters( SEntityUpdateContext &ctx )
+{
+	if (m_vDeferredCharacters.empty())
+		return;
+
+	m_pISystem->GetIAnimationSystem()->UpdateDeferredCharacters();
+
+	// the finish may delete entities or queue new ones (they're not deferred now), so index each time
+	for (int i = 0; i < (int)m_vDeferredCharacters.size(); i++)
+	{
+		CEntity *ce = m_vDeferredCharacters[i];
+		if (!ce)
+			continue;
+		ce->m_nDeferredIndex = -1;
+		m_vDeferredCharacters[i] = 0;
+		ce->FinishCharacterUpdate(ctx);
+	}
+	m_vDeferredCharacters.resize(0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CEntitySystem::CompactActiveEntities()
+{
+	int nActive = 0;
+	for (int i = 0; i < (int)m_vActiveEntities.size(); i++)
+	{
+		CEntity *ce = m_vActiveEntities[i];
+		if (ce)
+		{
+			ce->m_nActiveIndex = nActive;
+			m_vActiveEntities[nActive++] = ce;
+		}
+	}
+	m_vActiveEntities.resize(nActive);
+	m_nActiveHoles = 0;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -285,11 +382,27 @@ void CEntitySystem::Reset()
 		if (ent)
 		{ 
  			ent->ShutDown();
+			// like DeleteEntity: the entities shut down after this one must not find it by name
+			if (ent->m_bRegistered)
+			{
+				RemoveEntityName(ent);
+				DeactivateEntity(ent);
+				ent->m_bRegistered = false;
+			}
+			if (ent->m_nDeferredIndex >= 0)
+			{
+				m_vDeferredCharacters[ent->m_nDeferredIndex] = 0;
+				ent->m_nDeferredIndex = -1;
+			}
 			delete ent;
 		}
 		m_mapEntities.erase( it );
 		it = m_mapEntities.begin();
 	}
+	m_mapEntityNames.clear();
+	m_vActiveEntities.clear();
+	m_nActiveHoles=0;
+	m_vDeferredCharacters.clear();
 
 	m_EntityIDGenerator.Reset();
 	m_timersMap.clear();
@@ -323,6 +436,17 @@ void CEntitySystem::DeleteEntity( IEntity *entity )
 		ce->ShutDown();
 		int id = ce->GetId();
 		m_mapEntities.erase( id );
+		if (ce->m_bRegistered)
+		{
+			RemoveEntityName(ce);
+			DeactivateEntity(ce);
+			ce->m_bRegistered = false;
+		}
+		if (ce->m_nDeferredIndex >= 0)
+		{
+			m_vDeferredCharacters[ce->m_nDeferredIndex] = 0;
+			ce->m_nDeferredIndex = -1;
+		}
 
 //		m_pISystem->GetILog()->Log("CEntitySystem::DeleteEntity %d",id);
 
@@ -565,17 +689,9 @@ IEntity* CEntitySystem::GetEntity( EntityId id )
 //////////////////////////////////////////////////////////////////////
 EntityId CEntitySystem::FindEntity( const char *name ) const
 {
-	EntityMap::const_iterator itor;
-	itor=m_mapEntities.begin();
-	while(itor!=m_mapEntities.end())
-	{
-		CEntity *ce = itor->second;
-		if (stricmp( ce->GetName(),name) == 0)
-		{
-			return ce->GetId();
-		}
-		++itor;
-	}
+	EntityNameMap::const_iterator itor = m_mapEntityNames.find(name);
+	if (itor != m_mapEntityNames.end())
+		return itor->second->GetId();
 
 	//CryWarning( "<CryEntitySystem> Entity %s not found",name );
  // if you are here you are doing something wrong!!!!
@@ -589,16 +705,9 @@ IEntity* CEntitySystem::GetEntity(const char *sEntityName)
 	if (!sEntityName || !sEntityName[0])
 		return 0; // no entity name specified
 
-	EntityMapItor itor=m_mapEntities.begin();
-		while(itor!=m_mapEntities.end())
-	{
-		CEntity *ce = itor->second;
-		if (stricmp( ce->GetName(),sEntityName) == 0)
-		{
-			return ce;
-		}
-		++itor;
-	}
+	EntityNameMap::iterator itor = m_mapEntityNames.find(sEntityName);
+	if (itor != m_mapEntityNames.end())
+		return itor->second;
 	return NULL;
 }
 //////////////////////////////////////////////////////////////////////
@@ -729,7 +838,6 @@ void CEntitySystem::Update()
 
 	CCamera Cam=m_pISystem->GetViewCamera();
 	Vec3d Min, Max;
-	EntityMap::iterator next;
 	int nRendererFrameID=0;
 	if(m_pISystem)
 	{
@@ -756,13 +864,22 @@ void CEntitySystem::Update()
 	ctx.fMaxViewDistSquared = ctx.fMaxViewDist*ctx.fMaxViewDist;
 	ctx.vCameraPos = Cam.GetPos();
 
+	// the per entity profile has to see the whole cost of the character
+	m_bDeferCharacters = m_pDeferCharacterUpdate->GetIVal() && !bProfileEntities;
+
+	// Only the active entities are visited, entities activated during the update are appended
+	// and visited in this frame as well. An entity that has nothing to do anymore leaves the list.
 	if (!bProfileEntities)
 	{	
-		for (EntityMap::iterator it = m_mapEntities.begin(); it != m_mapEntities.end();it = next)
+		for (int i = 0; i < (int)m_vActiveEntities.size(); i++)
 		{
-			next = it; next++;
-			CEntity *ce= it->second;
+			CEntity *ce = m_vActiveEntities[i];
+			if (!ce)
+				continue;
 			UpdateEntity(ce,ctx);
+			// the slot is 0 if the entity was deleted
+			if (m_vActiveEntities[i] == ce && !ce->NeedsSystemUpdate())
+				DeactivateEntity(ce);
 		}
 	}
 	else
@@ -776,10 +893,11 @@ void CEntitySystem::Update()
 		float colorsRed[4]={1,0,0,1};
 		int prevNumUpdated;
 		float fProfileStartTime;
-		for (EntityMap::iterator it = m_mapEntities.begin(); it != m_mapEntities.end();it = next)
+		for (int i = 0; i < (int)m_vActiveEntities.size(); i++)
 		{
-			next = it; next++;
-			CEntity *ce= it->second;
+			CEntity *ce = m_vActiveEntities[i];
+			if (!ce)
+				continue;
 
 			fProfileStartTime = m_pTimer->GetAsyncCurTime();
 			prevNumUpdated = ctx.numUpdatedEntities;
@@ -791,6 +909,9 @@ void CEntitySystem::Update()
 			if (bGarbage)
 				continue;
 
+			if (m_vActiveEntities[i] == ce && !ce->NeedsSystemUpdate())
+				DeactivateEntity(ce);
+
 			if (prevNumUpdated != ctx.numUpdatedEntities || bProfileEntitiesAll)
 			{
 				float time = m_pTimer->GetAsyncCurTime() - fProfileStartTime;
@@ -815,6 +936,7 @@ void CEntitySystem::Update()
 		{
 			m_pISystem->GetILog()->Log( "\001================= Entity Update Times =================" );
 			m_pISystem->GetILog()->Log( "\001%d Entities Updated.",ctx.numUpdatedEntities );
+			m_pISystem->GetILog()->Log( "\001%d Active Entities of %d.",(int)(m_vActiveEntities.size()-m_nActiveHoles),(int)m_mapEntities.size() );
 			m_pISystem->GetILog()->Log( "\001%d Visible Entities Updated.",ctx.numVisibleEntities );
 			m_pISystem->GetILog()->Log( "\001%d Active Entity Timers.",(int)m_timersMap.size() );
 			m_pISystem->GetILog()->Log( "\001%d Trackable Visible Entities.",(int)m_vEntitiesInFrustrum.size() );
@@ -826,6 +948,12 @@ void CEntitySystem::Update()
 
 		m_pISystem->GetITimer()->MeasureTime("REALEntUp");
 	}
+
+	m_bDeferCharacters = false;
+	UpdateDeferredCharacters(ctx);
+
+	if (m_nActiveHoles)
+		CompactActiveEntities();
  					
 	m_nGetEntityCounter=0;
 }
@@ -942,6 +1070,8 @@ void CEntitySystem::GetMemoryStatistics(ICrySizer *pSizer)
 	}
 	
 	nSize += m_lstSinks.size() * sizeof(IEntitySystemSink*);
+	nSize += m_mapEntityNames.size() * sizeof(EntityNameMap::value_type);
+	nSize += m_vActiveEntities.capacity() * sizeof(CEntity*);
 
 	{
 		nSize += m_vEntitiesInFrustrum.size() * sizeof(m_vEntitiesInFrustrum[0]);
@@ -27,6 +27,7 @@
 #include "EntityCamera.h"
 #include "IDGenerator.h"
 #include <ISystem.h>
+#include <StlUtils.h>
 //#include "EntityIt.h"
 
 class CEntity;
@@ -58,6 +59,9 @@ class CEntityClonesMgr;
 typedef std::vector<CEntity*> EntityVector;
 typedef EntityVector::iterator EntityVectorItor;
 
+// Case insensitive entity name index, names are not unique.
+typedef std::multimap<string,CEntity*,stl::less_stricmp<string> > EntityNameMap;
+
 typedef std::set<int> EntityIdSet;
 typedef EntityIdSet::iterator EntityIdSetItor;
 
@@ -173,10 +177,25 @@ public:
 	void	MarkId( EntityId id )		{ m_EntityIDGenerator.Mark( id ); }
 	void	ClearId( EntityId id )		{ m_EntityIDGenerator.Remove( id ); }
 
+	//////////////////////////////////////////////////////////////////////////
+	// Called by the entities.
+	//////////////////////////////////////////////////////////////////////////
+	//! Adds the entity to the active list visited by Update, see CEntity::ActivateUpdate.
+	void	ActivateEntity( CEntity *pEntity );
+	void	AddEntityName( CEntity *pEntity );
+	void	RemoveEntityName( CEntity *pEntity );
+	//! Queues the entity for UpdateDeferredCharacters, see CEntity::UpdateCharacters.
+	void	DeferCharacterUpdate( CEntity *pEntity );
+
 
 private:
 	// Return true if updated.
 	void UpdateEntity(CEntity *ce,SEntityUpdateContext &ctx);
+	//! Leaves an empty slot in the active list, removed by CompactActiveEntities.
+	void DeactivateEntity( CEntity *pEntity );
+	void CompactActiveEntities();
+	//! Evaluates the bones of the queued characters in parallel and finishes the update of their entities.
+	void UpdateDeferredCharacters( SEntityUpdateContext &ctx );
 
 	//////////////////////////////////////////////////////////////////////////
 	// Variables.
@@ -189,6 +208,13 @@ private:
 
 	SinkList								m_lstSinks;
 	EntityMap								m_mapEntities;
+	EntityNameMap						m_mapEntityNames;					//!< for FindEntity and GetEntity by name
+	//! Entities Update has to visit (CEntity::NeedsSystemUpdate), the others are skipped
+	//! without touching them. Removed ones leave a 0 until the next compaction.
+	EntityVector						m_vActiveEntities;
+	int											m_nActiveHoles;						//!< 0 slots in m_vActiveEntities
+	//! Entities whose characters wait for UpdateDeferredCharacters, deleted ones leave a 0.
+	EntityVector						m_vDeferredCharacters;
 	EntityVector						m_vEntitiesInFrustrum;
 	//[kirill] - need this one to get visible entities on update of some entity - so we don't depend on update's order 
 	EntityVector						m_vEntitiesInFrustrumPrevFrame;
@@ -239,6 +265,9 @@ public:
 	ICVar *m_pHitDeadBodies;
 	ICVar *m_pEnableCloth;
 	ICVar *m_pCharZOffsetSpeed;
+	ICVar *m_pDeferCharacterUpdate;
+	//! True during the entity walk of Update if es_DeferCharacterUpdate is on.
+	bool m_bDeferCharacters;
 	bool m_bClient;
 	bool m_bServer;
 	int m_nGetEntityCounter;
@@ -508,7 +508,10 @@ bool CLipSync::LoadDialog(const char *pszFilename, int nSoundVolume, float fMinS
 	// ATTENTION,PlayDialog may be already called here.
 	m_pSound->Preload();	// this will force starting to load ansynchronously
 	
-	m_pReadStream=m_pStreamEngine->StartRead("LipSync", sSyncFilename, this);
+	// needed together with the dialog sound
+	StreamReadParams params;
+	params.nPriorityClass = SRPC_HIGH;
+	m_pReadStream=m_pStreamEngine->StartRead("LipSync", sSyncFilename, this, &params);
 	if (m_pReadStream->IsFinished())
 	{
 		//m_pLog->LogToFile("\006io:CLipSync(%p)::LoadDialog IsFinished", this);
@@ -550,6 +550,10 @@ void CXGame::InitConsoleVars()
 		"Bit 0 (value 1) display net statistics\n"
 		"Bit 1 (value 2) display a updatecount graph\n"
 		"Bit 2 (value 4) log netentities sent/count");
+	pConsole->CreateVariable("sv_snapshotcache","1",0,
+		"Toggles sharing of the entity encodings between the snapshots of all clients.\n"
+		"Usage: sv_snapshotcache [0/1]\n"
+		"Default is 1 (on). Statistics are shown with sv_netstats 1.");
 	pConsole->CreateVariable("sv_max_scheduling_delay","200",0,
 		"Sets the scheduling delay upper limit for fixed timestep multiplayer physics (in milliseconds).\n"
 		"Usage: sv_max_scheduling_delay 200"
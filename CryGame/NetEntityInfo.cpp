@@ -68,7 +68,7 @@ bool CNetEntityInfo::Write( CXServer *pServer, CStream &stm)
 
 	size_t dwPos = stm.GetSize();
 
-	bRes=m_pEntity->Write(stm,&m_ecsClone);
+	bRes=pServer->m_SnapshotCache.Write(m_pEntity,stm,m_ecsClone);
 
 	m_dwBitSizeEstimate = 5+9 + (uint32)(stm.GetSize()-dwPos);	// 5 for XSERVERMSG_UPDATEENTITY, 9 for EntityId
 
@@ -32,6 +32,27 @@ IScriptObject *CScriptObjectPlayer::m_pTempBloodObj = 0;
 IScriptObject *CScriptObjectPlayer::m_pBlindScreenPos = 0;
 
 IScriptObject* CScriptObjectPlayer::m_memberSO[SOP_MEMBER_LAST];
+ScriptKey CScriptObjectPlayer::m_keys[SOP_KEY_LAST];
+// names of SOP_KEYS
+static const char *s_szKeyNames[SOP_KEY_LAST] = {
+	"max_ammo",
+	"owns",
+	"reloading",
+	"fire_time",
+	"firemode",
+	"angles",
+	"len",
+	"winx",
+	"winy",
+	"id",
+	"ent",
+	"count",
+	"scale",
+	"random_scale",
+	"random_rotation",
+	"life_time",
+	"grow_time",
+};
 
 CScriptObjectPlayer::CScriptObjectPlayer():
 m_fSpeedRun(0.0f),
@@ -70,6 +91,11 @@ void CScriptObjectPlayer::ReleaseTemplate()
 	{
 		SAFE_RELEASE( m_memberSO[i] );
 	}
+	if (m_pSS)
+	{
+		for (int i = 0; i < SOP_KEY_LAST; i++)
+			m_pSS->ReleaseKey( m_keys[i] );
+	}
 	_ScriptableEx<CScriptObjectPlayer>::ReleaseTemplate();
 }
 
@@ -85,6 +111,10 @@ void CScriptObjectPlayer::InitializeTemplate(IScriptSystem *pSS)
 	{
 		m_memberSO[i] = pSS->CreateObject();
 	}
+	for (int i = 0; i < SOP_KEY_LAST; i++)
+	{
+		m_keys[i] = pSS->CreateKey(s_szKeyNames[i]);
+	}
 
 	REG_FUNC(CScriptObjectPlayer,GetWeaponInfo);
 	REG_FUNC(CScriptObjectPlayer,GetWeaponsSlots);
@@ -240,9 +270,9 @@ void CScriptObjectPlayer::SetMemberVector( SOP_MEMBER_LUA_TABLES member,const Ve
 {
 	IScriptObject *pVec = m_memberSO[member];
 	pVec->BeginSetGetChain();
-	pVec->SetValueChain("x",vec.x);
-	pVec->SetValueChain("y",vec.y);
-	pVec->SetValueChain("z",vec.z);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(0),vec.x);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(1),vec.y);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(2),vec.z);
 	pVec->EndSetGetChain();
 }
 
@@ -305,12 +335,12 @@ int CScriptObjectPlayer::GetWeaponInfo(IFunctionHandler *pH)
 	WeaponInfo &wi = m_pPlayer->GetWeaponInfo();
 
 	m_pWeaponInfo->BeginSetGetChain();
-	m_pWeaponInfo->SetValue( "max_ammo",wi.maxAmmo );
-	m_pWeaponInfo->SetValue( "owns",wi.owns );
-	m_pWeaponInfo->SetValue( "reloading",wi.reloading );
+	m_pWeaponInfo->SetValue( m_keys[SOP_KEY_MAX_AMMO],wi.maxAmmo );
+	m_pWeaponInfo->SetValue( m_keys[SOP_KEY_OWNS],wi.owns );
+	m_pWeaponInfo->SetValue( m_keys[SOP_KEY_RELOADING],wi.reloading );
 	// Only get, script can't change theose.
-	m_pWeaponInfo->SetValue( "fire_time",wi.fireTime );
-	m_pWeaponInfo->SetValue( "firemode",wi.iFireMode );
+	m_pWeaponInfo->SetValue( m_keys[SOP_KEY_FIRE_TIME],wi.fireTime );
+	m_pWeaponInfo->SetValue( m_keys[SOP_KEY_FIREMODE],wi.iFireMode );
 	m_pWeaponInfo->EndSetGetChain();
 
 	return pH->EndFunction(m_pWeaponInfo);
@@ -481,11 +511,11 @@ int CScriptObjectPlayer::GetViewIntersection(IFunctionHandler *pH)
 		//m_pTempAng->EndSetGetChain();
 		//////////////////////////////////////////
 		m_pTempObj->BeginSetGetChain(); 
-		m_pTempObj->SetValueChain("x",hit.pt.x);
-		m_pTempObj->SetValueChain("y",hit.pt.y);
-		m_pTempObj->SetValueChain("z",hit.pt.z);
-		m_pTempObj->SetValueChain("angles",m_pTempAng);
-		m_pTempObj->SetValueChain("len",fDist);
+		m_pTempObj->SetValueChain(m_pScriptSystem->GetVecKey(0),hit.pt.x);
+		m_pTempObj->SetValueChain(m_pScriptSystem->GetVecKey(1),hit.pt.y);
+		m_pTempObj->SetValueChain(m_pScriptSystem->GetVecKey(2),hit.pt.z);
+		m_pTempObj->SetValueChain(m_keys[SOP_KEY_ANGLES],m_pTempAng);
+		m_pTempObj->SetValueChain(m_keys[SOP_KEY_LEN],fDist);
 
 		float fWinX,fWinY,fWinZ;
 		IRenderer *pRend=m_pPlayer->GetGame()->GetSystem()->GetIRenderer();
@@ -495,8 +525,8 @@ int CScriptObjectPlayer::GetViewIntersection(IFunctionHandler *pH)
 		fWinX=fWinX*pRend->GetWidth()/100.0f;
 		fWinY=fWinY*pRend->GetHeight()/100.0f;
 
-		m_pTempObj->SetValueChain("winx",fWinX);
-		m_pTempObj->SetValueChain("winy",fWinY);
+		m_pTempObj->SetValueChain(m_keys[SOP_KEY_WINX],fWinX);
+		m_pTempObj->SetValueChain(m_keys[SOP_KEY_WINY],fWinY);
 
 		m_pTempObj->SetToNullChain("id");
 		m_pTempObj->SetToNullChain("ent");
@@ -504,10 +534,10 @@ int CScriptObjectPlayer::GetViewIntersection(IFunctionHandler *pH)
 		if(hit.pCollider){
 			IEntity *pE=(IEntity *)hit.pCollider->GetForeignData();
 			if(pE){
-				m_pTempObj->SetValueChain("id",pE->GetId());
+				m_pTempObj->SetValueChain(m_keys[SOP_KEY_ID],pE->GetId());
 				IScriptObject *p=pE->GetScriptObject();
 				if(p)
-					m_pTempObj->SetValueChain("ent",p);
+					m_pTempObj->SetValueChain(m_keys[SOP_KEY_ENT],p);
 			}
 		}
 		
@@ -716,9 +746,9 @@ int CScriptObjectPlayer::CalcDmgShakeAxis(IFunctionHandler *pH)
 	_SmartScriptObject pTable(m_pScriptSystem, true);
 	pH->GetParam(1, *pTable);
 	Vec3 ProjDir;
-	pTable->GetValue("x", ProjDir.x);
-	pTable->GetValue("y", ProjDir.y);
-	pTable->GetValue("z", ProjDir.z);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(0), ProjDir.x);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(1), ProjDir.y);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(2), ProjDir.z);
 	ProjDir.Normalize();
 	Vec3 PlayerDir=m_pPlayer->GetWalkParams().dir;
 	PlayerDir.z=0.0f;
@@ -739,9 +769,9 @@ int CScriptObjectPlayer::ShakeCamera(IFunctionHandler *pH)
 	_SmartScriptObject pTable(m_pScriptSystem, true);
 	pH->GetParam(1, *pTable);
 	Vec3 Axis;
-	pTable->GetValue("x", Axis.x);
-	pTable->GetValue("y", Axis.y);
-	pTable->GetValue("z", Axis.z);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(0), Axis.x);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(1), Axis.y);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(2), Axis.z);
 	float fDeg, fFreq, fTime;
 	pH->GetParam(2, fDeg);
 	pH->GetParam(3, fFreq);
@@ -761,9 +791,9 @@ int CScriptObjectPlayer::SetCameraOffset(IFunctionHandler *pH)
 	pH->GetParam(1, *pTable);
 	
 	Vec3 Offset;
-	pTable->GetValue("x", Offset.x );
-	pTable->GetValue("y", Offset.y );
-	pTable->GetValue("z", Offset.z );
+	pTable->GetValue(m_pScriptSystem->GetVecKey(0), Offset.x );
+	pTable->GetValue(m_pScriptSystem->GetVecKey(1), Offset.y );
+	pTable->GetValue(m_pScriptSystem->GetVecKey(2), Offset.z );
 
 	m_pPlayer->SetCameraOffset(Offset);
 	return pH->EndFunction();
@@ -832,18 +862,18 @@ int CScriptObjectPlayer::StartDie(IFunctionHandler *pH)
 	if(!pH->GetParam(1, *pTable))
 		{ CryError("CScriptObjectPlayer::StartDie parameter 1 failed");return pH->EndFunction(); }
 
-	pTable->GetValue("x", impuls.x);
-	pTable->GetValue("y", impuls.y);
-	pTable->GetValue("z", impuls.z);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(0), impuls.x);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(1), impuls.y);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(2), impuls.z);
 
 	Vec3 point;
 
 	if(!pH->GetParam(2, *pTable))
 		{ CryError("CScriptObjectPlayer::StartDie parameter 2 failed");return pH->EndFunction(); }
 	
-	pTable->GetValue("x", point.x);
-	pTable->GetValue("y", point.y);
-	pTable->GetValue("z", point.z);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(0), point.x);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(1), point.y);
+	pTable->GetValue(m_pScriptSystem->GetVecKey(2), point.z);
 
 	int	partid,deathType;
 
@@ -863,9 +893,9 @@ int CScriptObjectPlayer::SetDimOverride(IFunctionHandler *pH)
 	pe_player_dimensions	dim;
 	pObj->GetValue("eye_height",dim.heightEye);
 	pObj->GetValue("ellipsoid_height",dim.heightCollider);
-	pObj->GetValue("x",dim.sizeCollider.x);
-	pObj->GetValue("y",dim.sizeCollider.y);
-	pObj->GetValue("z",dim.sizeCollider.z); 
+	pObj->GetValue(m_pScriptSystem->GetVecKey(0),dim.sizeCollider.x);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(1),dim.sizeCollider.y);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(2),dim.sizeCollider.z); 
 	dim.headRadius = 0;
 	dim.heightHead = dim.heightCollider;
 	pObj->GetValue("head_height", dim.heightHead);
@@ -891,9 +921,9 @@ int CScriptObjectPlayer::SetDimNormal(IFunctionHandler *pH)
 	pe_player_dimensions	dim;
 	pObj->GetValue("eye_height",dim.heightEye);
 	pObj->GetValue("ellipsoid_height",dim.heightCollider);
-	pObj->GetValue("x",dim.sizeCollider.x);
-	pObj->GetValue("y",dim.sizeCollider.y);
-	pObj->GetValue("z",dim.sizeCollider.z); 
+	pObj->GetValue(m_pScriptSystem->GetVecKey(0),dim.sizeCollider.x);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(1),dim.sizeCollider.y);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(2),dim.sizeCollider.z); 
 	dim.headRadius = 0;
 	dim.heightHead = dim.heightCollider;
 	pObj->GetValue("head_height", dim.heightHead);
@@ -912,9 +942,9 @@ int CScriptObjectPlayer::SetDimCrouch(IFunctionHandler *pH)
 	pe_player_dimensions	dim;
 	pObj->GetValue("eye_height",dim.heightEye);
 	pObj->GetValue("ellipsoid_height",dim.heightCollider);
-	pObj->GetValue("x",dim.sizeCollider.x);
-	pObj->GetValue("y",dim.sizeCollider.y);
-	pObj->GetValue("z",dim.sizeCollider.z);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(0),dim.sizeCollider.x);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(1),dim.sizeCollider.y);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(2),dim.sizeCollider.z);
 	dim.headRadius = 0;
 	dim.heightHead = dim.heightCollider;
 	pObj->GetValue("head_height", dim.heightHead);
@@ -933,9 +963,9 @@ int CScriptObjectPlayer::SetDimProne(IFunctionHandler *pH)
 	pe_player_dimensions	dim;
 	pObj->GetValue("eye_height",dim.heightEye);
 	pObj->GetValue("ellipsoid_height",dim.heightCollider);
-	pObj->GetValue("x",dim.sizeCollider.x);
-	pObj->GetValue("y",dim.sizeCollider.y);
-	pObj->GetValue("z",dim.sizeCollider.z);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(0),dim.sizeCollider.x);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(1),dim.sizeCollider.y);
+	pObj->GetValue(m_pScriptSystem->GetVecKey(2),dim.sizeCollider.z);
 	dim.headRadius = 0;
 	dim.heightHead = dim.heightCollider;
 	pObj->GetValue("head_height", dim.heightHead);
@@ -1374,9 +1404,9 @@ int	CScriptObjectPlayer::GetCharacterAngles(IFunctionHandler *pH)
 	Vec3 vec;
 	vec=m_pPlayer->m_vCharacterAngles;
 	vec=ConvertToRadAngles(vec);
-	m_pTempAng->SetValue("x",vec.x);
-	m_pTempAng->SetValue("y",vec.y);
-	m_pTempAng->SetValue("z",vec.z);
+	m_pTempAng->SetValue(m_pScriptSystem->GetVecKey(0),vec.x);
+	m_pTempAng->SetValue(m_pScriptSystem->GetVecKey(1),vec.y);
+	m_pTempAng->SetValue(m_pScriptSystem->GetVecKey(2),vec.z);
 	return pH->EndFunction(m_pTempAng);
 }
 
@@ -1741,9 +1771,9 @@ int CScriptObjectPlayer::GetBlindScreenPos(IFunctionHandler *pH)
 
 	Vec3 vec = m_pPlayer->m_LastUsed->second;
 	m_pBlindScreenPos->BeginSetGetChain();
-	m_pBlindScreenPos->SetValueChain("x",vec.x);
-	m_pBlindScreenPos->SetValueChain("y",vec.y);
-	m_pBlindScreenPos->SetValueChain("z",vec.z);
+	m_pBlindScreenPos->SetValueChain(m_pScriptSystem->GetVecKey(0),vec.x);
+	m_pBlindScreenPos->SetValueChain(m_pScriptSystem->GetVecKey(1),vec.y);
+	m_pBlindScreenPos->SetValueChain(m_pScriptSystem->GetVecKey(2),vec.z);
 	m_pBlindScreenPos->EndSetGetChain();
 
 	m_pPlayer->m_LastUsed++;
@@ -2181,7 +2211,7 @@ int CScriptObjectPlayer::GetProjectedBloodPos(IFunctionHandler *pH)
 
 	if(!m_pScriptSystem->GetGlobalValue(decalTableName,pDecalsTable))
 		return pH->EndFunctionNull();
-	pDecalsTable->GetValue("count", decalNumber);
+	pDecalsTable->GetValue(m_keys[SOP_KEY_COUNT], decalNumber);
 
 	if(decalNumber == 0)
 		return pH->EndFunctionNull();
@@ -2196,11 +2226,11 @@ int CScriptObjectPlayer::GetProjectedBloodPos(IFunctionHandler *pH)
 
 	if(!pTheDecalTable->GetUDValue("texture",Decal.nTid, nCookie))
 		return pH->EndFunctionNull();
-	pTheDecalTable->GetValue("scale",Decal.fSize);
-	pTheDecalTable->GetValue("random_scale",rand_size);
-	pTheDecalTable->GetValue("random_rotation",Decal.fAngle);
-	pTheDecalTable->GetValue("life_time",Decal.fLifeTime);
-	pTheDecalTable->GetValue("grow_time",Decal.m_fGrowTime);
+	pTheDecalTable->GetValue(m_keys[SOP_KEY_SCALE],Decal.fSize);
+	pTheDecalTable->GetValue(m_keys[SOP_KEY_RANDOM_SCALE],rand_size);
+	pTheDecalTable->GetValue(m_keys[SOP_KEY_RANDOM_ROTATION],Decal.fAngle);
+	pTheDecalTable->GetValue(m_keys[SOP_KEY_LIFE_TIME],Decal.fLifeTime);
+	pTheDecalTable->GetValue(m_keys[SOP_KEY_GROW_TIME],Decal.m_fGrowTime);
 
 	if( rand_size>0 )
 		Decal.fSize += ((Decal.fSize*0.01f)*(rand()%rand_size));
@@ -34,6 +34,29 @@ enum SOP_MEMBER_LUA_TABLES {
 	SOP_MEMBER_LAST
 };
 
+//! members of the tables the frequently called functions fill or read, interned once (see m_keys)
+enum SOP_KEYS {
+	SOP_KEY_MAX_AMMO,
+	SOP_KEY_OWNS,
+	SOP_KEY_RELOADING,
+	SOP_KEY_FIRE_TIME,
+	SOP_KEY_FIREMODE,
+	SOP_KEY_ANGLES,
+	SOP_KEY_LEN,
+	SOP_KEY_WINX,
+	SOP_KEY_WINY,
+	SOP_KEY_ID,
+	SOP_KEY_ENT,
+	SOP_KEY_COUNT,
+	SOP_KEY_SCALE,
+	SOP_KEY_RANDOM_SCALE,
+	SOP_KEY_RANDOM_ROTATION,
+	SOP_KEY_LIFE_TIME,
+	SOP_KEY_GROW_TIME,
+
+	SOP_KEY_LAST
+};
+
 class CScriptObjectPlayer :
 public _ScriptableEx<CScriptObjectPlayer>,
 public IScriptObjectSink
@@ -197,6 +220,8 @@ private:
 
 	// member script objects (preallocated)
 	static IScriptObject* m_memberSO[SOP_MEMBER_LAST];
+	// interned member keys, SOP_KEYS
+	static ScriptKey m_keys[SOP_KEY_LAST];
 	void SetMemberVector( SOP_MEMBER_LUA_TABLES member,const Vec3 &vec );
 
 	int		m_LastTouchedMaterialID;
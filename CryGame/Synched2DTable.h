@@ -50,6 +50,7 @@ public:
 	void PreloadInstanceResources(Vec3d vPrevPortalPos, float fPrevPortalDistance, float fTime) {};
 	virtual void OnEntityNetworkUpdate( const EntityId &idViewerEntity, const Vec3d &v3dViewer, uint32 &inoutPriority,
 		EntityCloneState &inoutCloneState ) const;
+	virtual bool IsNetWriteShareable() { return false; }		// every slot has its own dirty list
 
 private: // -----------------------------------------------------------------------
 
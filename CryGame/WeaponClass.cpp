@@ -28,6 +28,38 @@
 
 //#define FIRE_DEBUG			// only for debugging
 
+// names of EWeaponKey
+static const char *s_szWeaponKeyNames[WeaponKey_Count] =
+{
+	"pos",
+	"angles",
+	"dir",
+	"normal",
+	"firemode",
+	"shooter",
+	"bullets",
+	"fire_event_type",
+	"underwater",
+	"BulletPlayerPos",
+	"HitPt",
+	"HitDist",
+	"objtype",
+	"ipart",
+	"weapon",
+	"damage",
+	"inwater",
+	"target_material",
+	"weapon_death_anim_id",
+	"impact_force_mul",
+	"impact_force_mul_final",
+	"impact_force_mul_final_torso",
+	"melee",
+	"play_mat_sound",
+	"projectile",
+	"target_id",
+	"target",
+};
+
 CWeaponClass::CWeaponClass(CWeaponSystemEx& rWeaponSystem) :
 m_rWeaponSystem(rWeaponSystem)
 {
@@ -146,6 +178,8 @@ void CWeaponClass::Reset()
 		if (m_hServerFuncs[i])
 			m_pScriptSystem->ReleaseFunc(m_hServerFuncs[i]);
 	}
+	for (int i = 0; i < WeaponKey_Count; ++i)
+		m_pScriptSystem->ReleaseKey(m_keys[i]);
 
 	//Never force Lua GC, m_pScriptSystem->ForceGarbageCollection();
 
@@ -466,6 +500,8 @@ bool CWeaponClass::InitWeaponClassVariables()
 	m_sso_Params_OnAnimationKey.Create(m_pScriptSystem);
 	m_sso_Params_OnActivate.Create(m_pScriptSystem);
 	m_sso_Params_OnDeactivate.Create(m_pScriptSystem);
+	for (int i = 0; i < WeaponKey_Count; ++i)
+		m_keys[i] = m_pScriptSystem->CreateKey(s_szWeaponKeyNames[i]);
 
 	// get entry in WeaponClasses table
 	IScriptObject *soWeaponClasses = m_rWeaponSystem.GetWeaponClassesTable();
@@ -648,7 +684,7 @@ bool CWeaponClass::CancelFire()
 	FUNCTION_PROFILER( GetISystem(),PROFILE_GAME );
 
 	m_ssoFireTable->BeginSetGetChain();
-	m_ssoFireTable->SetValueChain("fire_event_type", (int) eCancel);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_FireEventType], (int) eCancel);
 	m_ssoFireTable->EndSetGetChain();
 
 	bool bWeaponReady;
@@ -787,17 +823,17 @@ int CWeaponClass::Fire(const Vec3d &origin, const Vec3d &angles, CPlayer *pPlaye
 	float fWaterLevel=m_rWeaponSystem.GetGame()->GetSystem()->GetI3DEngine()->GetWaterLevel(&origin);
 	//BULDING PARAMS FOR WeaponScript:Fire
 	m_ssoFireTable->BeginSetGetChain();
-	m_ssoFireTable->SetValueChain("pos",m_ssoHitPosVec);
-	m_ssoFireTable->SetValueChain("angles",m_ssoHitNormVec);
-	m_ssoFireTable->SetValueChain("dir",m_ssoHitDirVec);
-	m_ssoFireTable->SetValueChain("firemode",winfo.iFireMode);
-	m_ssoFireTable->SetValueChain("shooter",pIShooter->GetScriptObject());
-	m_ssoFireTable->SetValueChain("bullets", (int) iNumShots);
-	m_ssoFireTable->SetValueChain("fire_event_type", (int) ft);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Pos],m_ssoHitPosVec);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Angles],m_ssoHitNormVec);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Dir],m_ssoHitDirVec);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Firemode],winfo.iFireMode);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Shooter],pIShooter->GetScriptObject());
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Bullets], (int) iNumShots);
+	m_ssoFireTable->SetValueChain(m_keys[WeaponKey_FireEventType], (int) ft);
 
 	if (fWaterLevel>origin.z)
 	{
-		m_ssoFireTable->SetValueChain("underwater",0);
+		m_ssoFireTable->SetValueChain(m_keys[WeaponKey_Underwater],0);
 		if (!m_fireParams.bShootUnderwater)
 			return 0;
 	}
@@ -831,7 +867,7 @@ int CWeaponClass::Fire(const Vec3d &origin, const Vec3d &angles, CPlayer *pPlaye
 					if (fDist2<=m_fireParams.whizz_sound_radius)
 					{
 						m_ssoBulletPlayerPos.Set( BulletPlayerPos );
-						m_ssoFireTable->SetValue("BulletPlayerPos", m_ssoBulletPlayerPos );
+						m_ssoFireTable->SetValue(m_keys[WeaponKey_BulletPlayerPos], m_ssoBulletPlayerPos );
 					}
 				}
 			}
@@ -1032,12 +1068,12 @@ int CWeaponClass::Fire(const Vec3d &origin, const Vec3d &angles, CPlayer *pPlaye
 				dir=ConvertToRadAngles(currangles);
 				m_ssoHitDirVec = dir;
 			}
-			m_ssoFireTable->SetValue("dir",m_ssoHitDirVec);
+			m_ssoFireTable->SetValue(m_keys[WeaponKey_Dir],m_ssoHitDirVec);
       
 			m_ssoHitPt = (Vec3d) hits[0].pt;
-			m_ssoFireTable->SetValue("HitPt", m_ssoHitPt);
+			m_ssoFireTable->SetValue(m_keys[WeaponKey_HitPt], m_ssoHitPt);
 
-			m_ssoFireTable->SetValue("HitDist", hits[0].dist);
+			m_ssoFireTable->SetValue(m_keys[WeaponKey_HitDist], hits[0].dist);
 
 			if (!ScriptOnFire(*m_ssoFireTable))
 				return false;
@@ -1192,9 +1228,9 @@ void CWeaponClass::ProcessHitTarget(const SWeaponHit &hit)
 #ifdef FIRE_DEBUG
 		m_rWeaponSystem.GetGame()->GetSystem()->GetILog()->Log("hit.target!=NULL id=%d target=%s %x",hit.target->GetId(),(const char *)hit.target->GetName(),hit.target->GetScriptObject());
 #endif
-		m_ssoProcessHit->SetValueChain("target_id",hit.target->GetId());
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_TargetId],hit.target->GetId());
 		if (hit.target->GetScriptObject())
-			m_ssoProcessHit->SetValueChain("target",hit.target->GetScriptObject());
+			m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Target],hit.target->GetScriptObject());
 		else
 			m_ssoProcessHit->SetToNullChain("target");
 		m_ssoProcessHit->SetToNullChain("targetStat");
@@ -1217,7 +1253,7 @@ void CWeaponClass::ProcessHitTarget(const SWeaponHit &hit)
 		m_ssoProcessHit->SetToNullChain("targetStat");
 		m_ssoProcessHit->SetToNullChain("target");
 		m_ssoProcessHit->SetToNullChain("target_id");
-		m_ssoProcessHit->SetValueChain("objtype",hit.objecttype);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Objtype],hit.objecttype);
 	}	
 }
 
@@ -1252,21 +1288,21 @@ void CWeaponClass::ProcessHit(const SWeaponHit &hit)
 		m_ssoHitNormVec=vWaterNormal;
 		m_ssoHitDirVec=hit.dir;
 		m_ssoProcessHit->BeginSetGetChain();
-		m_ssoProcessHit->SetValueChain("pos",m_ssoHitPosVec);
-		m_ssoProcessHit->SetValueChain("normal",m_ssoHitNormVec);
-		m_ssoProcessHit->SetValueChain("dir",m_ssoHitPosVec);		
-		m_ssoProcessHit->SetValueChain("objtype",hit.objecttype);
-		m_ssoProcessHit->SetValueChain("ipart",hit.ipart);
-		m_ssoProcessHit->SetValueChain("shooter",hit.shooter->GetScriptObject());
-		m_ssoProcessHit->SetValueChain("weapon",hit.weapon);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Pos],m_ssoHitPosVec);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Normal],m_ssoHitNormVec);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Dir],m_ssoHitPosVec);		
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Objtype],hit.objecttype);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Ipart],hit.ipart);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Shooter],hit.shooter->GetScriptObject());
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Weapon],hit.weapon);
 
 		// [marco] decrease damage if the hit pos is underwater
-		m_ssoProcessHit->SetValueChain("damage",hit.damage*0.5f); 
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Damage],hit.damage*0.5f); 
 
 		if(pTargetMaterial=m_rWeaponSystem.GetGame()->m_XSurfaceMgr.GetMaterialByName("mat_water"))
 		{
-			m_ssoProcessHit->SetValueChain("inwater",(bool)true );
-			m_ssoProcessHit->SetValueChain("target_material",pTargetMaterial);
+			m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Inwater],(bool)true );
+			m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_TargetMaterial],pTargetMaterial);
 		}
 		else
 		{
@@ -1284,22 +1320,22 @@ void CWeaponClass::ProcessHit(const SWeaponHit &hit)
 	m_ssoHitNormVec=hit.normal;
 	m_ssoHitDirVec=hit.dir;
 	_VERIFY(m_ssoProcessHit->BeginSetGetChain());
-	m_ssoProcessHit->SetValueChain("pos",m_ssoHitPosVec);
-	m_ssoProcessHit->SetValueChain("normal",m_ssoHitNormVec);
-	m_ssoProcessHit->SetValueChain("dir",m_ssoHitDirVec);	
-	m_ssoProcessHit->SetValueChain("ipart",hit.ipart);
-	m_ssoProcessHit->SetValueChain("shooter",hit.shooter->GetScriptObject());
-	m_ssoProcessHit->SetValueChain("weapon",hit.weapon);
-	m_ssoProcessHit->SetValueChain("damage",hit.damage);
-	m_ssoProcessHit->SetValueChain("weapon_death_anim_id", hit.weapon_death_anim_id);
-	m_ssoProcessHit->SetValueChain("impact_force_mul", hit.iImpactForceMul);
-	m_ssoProcessHit->SetValueChain("impact_force_mul_final", hit.iImpactForceMulFinal);
-	m_ssoProcessHit->SetValueChain("impact_force_mul_final_torso", hit.iImpactForceMulFinalTorso);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Pos],m_ssoHitPosVec);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Normal],m_ssoHitNormVec);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Dir],m_ssoHitDirVec);	
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Ipart],hit.ipart);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Shooter],hit.shooter->GetScriptObject());
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Weapon],hit.weapon);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Damage],hit.damage);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_WeaponDeathAnimId], hit.weapon_death_anim_id);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_ImpactForceMul], hit.iImpactForceMul);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_ImpactForceMulFinal], hit.iImpactForceMulFinal);
+	m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_ImpactForceMulFinalTorso], hit.iImpactForceMulFinalTorso);
 
 	if (m_fireParams.iFireModeType == FireMode_Melee)
-		m_ssoProcessHit->SetValueChain("melee", true);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Melee], true);
 	else
-		m_ssoProcessHit->SetValueChain("melee", false);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Melee], false);
 
 
 	// [marco] hit target code moved into a common function
@@ -1307,7 +1343,7 @@ void CWeaponClass::ProcessHit(const SWeaponHit &hit)
 
 	if(pTargetMaterial=m_rWeaponSystem.GetGame()->m_XSurfaceMgr.GetMaterialBySurfaceID(hit.surface_id))
 	{
-		m_ssoProcessHit->SetValueChain("target_material",pTargetMaterial);
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_TargetMaterial],pTargetMaterial);
 		//avoid to play the same materials sound twice in a row(avoid phasing)
 		if(m_nLastMaterial==hit.surface_id)
 		{
@@ -1315,7 +1351,7 @@ void CWeaponClass::ProcessHit(const SWeaponHit &hit)
 		}
 		else
 		{
-			m_ssoProcessHit->SetValueChain("play_mat_sound",1);
+			m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_PlayMatSound],1);
 			m_nLastMaterial=hit.surface_id;
 		}
 	}
@@ -1324,7 +1360,7 @@ void CWeaponClass::ProcessHit(const SWeaponHit &hit)
 		m_ssoProcessHit->SetToNullChain("target_material");
 	}
 	if (hit.projectile)
-		m_ssoProcessHit->SetValueChain("projectile",hit.projectile->GetScriptObject());
+		m_ssoProcessHit->SetValueChain(m_keys[WeaponKey_Projectile],hit.projectile->GetScriptObject());
 	m_ssoProcessHit->EndSetGetChain();
 
 	ScriptOnHit(m_ssoProcessHit);
@@ -44,6 +44,39 @@ enum EWeaponFunc
 	WeaponFunc_Count
 };
 
+// members of the fire and hit tables, interned once per weapon class (CWeaponClass::m_keys)
+enum EWeaponKey
+{
+	WeaponKey_Pos = 0,
+	WeaponKey_Angles,
+	WeaponKey_Dir,
+	WeaponKey_Normal,
+	WeaponKey_Firemode,
+	WeaponKey_Shooter,
+	WeaponKey_Bullets,
+	WeaponKey_FireEventType,
+	WeaponKey_Underwater,
+	WeaponKey_BulletPlayerPos,
+	WeaponKey_HitPt,
+	WeaponKey_HitDist,
+	WeaponKey_Objtype,
+	WeaponKey_Ipart,
+	WeaponKey_Weapon,
+	WeaponKey_Damage,
+	WeaponKey_Inwater,
+	WeaponKey_TargetMaterial,
+	WeaponKey_WeaponDeathAnimId,
+	WeaponKey_ImpactForceMul,
+	WeaponKey_ImpactForceMulFinal,
+	WeaponKey_ImpactForceMulFinalTorso,
+	WeaponKey_Melee,
+	WeaponKey_PlayMatSound,
+	WeaponKey_Projectile,
+	WeaponKey_TargetId,
+	WeaponKey_Target,
+	WeaponKey_Count
+};
+
 #define OT_ENTITY			0
 #define OT_STAT_OBJ		1
 #define OT_TERRAIN		2
@@ -259,6 +292,8 @@ private:
 	// script function callback tables
 	HSCRIPTFUNCTION			m_hClientFuncs[WeaponFunc_Count];
 	HSCRIPTFUNCTION			m_hServerFuncs[WeaponFunc_Count];
+	// interned keys of m_ssoFireTable and m_ssoProcessHit
+	ScriptKey						m_keys[WeaponKey_Count];
 
 	// rendering related
 	IStatObj*						m_pObject;				//!< third person weapon model
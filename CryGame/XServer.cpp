@@ -132,6 +132,7 @@ CXServer::CXServer(CXGame *pGame, WORD nPort, const char *szName, bool listen)
 	sv_maxrate_lan = pConsole->GetCVar("sv_maxrate_lan");
 
 	sv_netstats = pConsole->GetCVar("sv_netstats");
+	sv_snapshotcache = pConsole->GetCVar("sv_snapshotcache");
 	sv_max_scheduling_delay = pConsole->GetCVar("sv_max_scheduling_delay");
 	sv_min_scheduling_delay = pConsole->GetCVar("sv_min_scheduling_delay");
 	m_bIsLoadingLevel=false;
@@ -310,6 +311,20 @@ void CXServer::DrawNetStats(IRenderer *pRenderer)
 			fIncomingKbPerSec, fIncomingKbPerSec+fPacketSize*nIncomingPacketsPerSec, nIncomingPacketsPerSec,
 			fOutgoingKbPerSec, fOutgoingKbPerSec+fPacketSize*nOutgoingPacketsPerSec, nOutgoingPacketsPerSec);
 
+		{
+			DWORD dwEncoded,dwShared,dwDirect;
+			float fEncodeMs;
+
+			m_SnapshotCache.GetStats(dwEncoded,dwShared,dwDirect,fEncodeMs);
+
+			// the shared writes would have cost about the same as the encoded ones
+			float fSavedMs = dwEncoded ? fEncodeMs*(float)dwShared/(float)dwEncoded : 0.0f;
+
+			y+=3;
+			pRenderer->TextToScreen(10.0f,(float)y,"SNAPSHOTCACHE ENCODED=%d/sec (%.2fms) SHARED=%d/sec (~%.2fms saved) UNSHARED=%d/sec",
+				dwEncoded,fEncodeMs,dwShared,fSavedMs,dwDirect);
+		}
+
 	// just for internal testing purpose
 #ifndef REDUCED_FOR_PUBLIC_RELEASE
 		y+=3;
@@ -765,6 +780,7 @@ void CXServer::Update()
 	UpdateXServerNetwork();
 	float time = m_pTimer->GetCurrTime();
 	bool sendevents=m_pGame->UseFixedStep() && m_pGame->HasScheduledEvents(); 
+	m_SnapshotCache.BeginFrame(time,sv_snapshotcache->GetIVal()!=0);
 	// Garbage collection and update of the slots
 	XSlotMap::iterator i = m_mapXSlots.begin();
 	while(i != m_mapXSlots.end())
@@ -1077,6 +1093,7 @@ void CXServer::UnbindEntity(EntityId idParent,EntityId idChild,unsigned char cPa
 void CXServer::OnMapChanged()
 {
 	m_ServerRules.MapChanged();
+	m_SnapshotCache.Clear();
 };
 
 int CXServer::GetNumPlayers()
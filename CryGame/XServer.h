@@ -20,6 +20,7 @@
 #include "XNetwork.h"
 #include "XServerRules.h"
 #include "XSnapshot.h"
+#include "XSnapshotCache.h"
 #include "INetwork.h"					// IServerSlotFactory
 #include "ScriptObjectServer.h"
 #include <map>
@@ -264,10 +265,12 @@ public:
 	ICVar *								sv_maxrate;								//!< bitspersecond, Internet, maximum for all player, value is for one player
 	ICVar *								sv_maxrate_lan;						//!< bitspersecond, LAN, maximum for all player, value is for one player
 	ICVar *								sv_netstats;							//!<
+	ICVar *								sv_snapshotcache;					//!< 0=every slot encodes the entities itself
 	ICVar *								sv_max_scheduling_delay;	//!<
 	ICVar *								sv_min_scheduling_delay;	//!<
 	
 	CXNetworkStats				m_NetStats;								//!< for network statistics (count and size per packet type)
+	CXSnapshotCache				m_SnapshotCache;					//!< entity encodings shared by the snapshots of all slots
 
 	static const char *GetMsgName( XSERVERMSG inValue );
 
@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////
+//
+//	Crytek Source code
+//	Copyright (c) Crytek 2001-2004
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "XSnapshotCache.h"
+#include <IEntitySystem.h>
+#include <ITimer.h>
+
+// encodings that were not used for that many frames are removed (entity was removed or the flags changed)
+#define SNAPSHOTCACHE_CLEANUP_FRAMES		64
+
+//////////////////////////////////////////////////////////////////////////
+CXSnapshotCache::CXSnapshotCache()
+{
+	m_dwFrame=1;
+	m_bEnabled=true;
+	m_fLastTimeReset=0;
+	m_dwGatherEncoded=m_dwGatherShared=m_dwGatherDirect=0;
+	m_fGatherEncodeTime=0;
+	m_dwDrawEncoded=m_dwDrawShared=m_dwDrawDirect=0;
+	m_fDrawEncodeTime=0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CXSnapshotCache::BeginFrame( const float fCurrentTime, const bool bEnabled )
+{
+	m_bEnabled=bEnabled;
+
+	if(++m_dwFrame==0)
+	{
+		// stamps wrapped around, start over
+		m_mapEncodings.clear();
+		m_dwFrame=1;
+	}
+
+	if(m_dwFrame%SNAPSHOTCACHE_CLEANUP_FRAMES==0)
+		RemoveOldEncodings();
+
+	float fRelTime=fCurrentTime-m_fLastTimeReset;
+
+	if(fRelTime>1.0f || fRelTime<0)		// after one sec or if timer was reseted
+	{
+		m_dwDrawEncoded=m_dwGatherEncoded;
+		m_dwDrawShared=m_dwGatherShared;
+		m_dwDrawDirect=m_dwGatherDirect;
+		m_fDrawEncodeTime=m_fGatherEncodeTime;
+		m_dwGatherEncoded=m_dwGatherShared=m_dwGatherDirect=0;
+		m_fGatherEncodeTime=0;
+		m_fLastTimeReset=fCurrentTime;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CXSnapshotCache::Clear()
+{
+	m_mapEncodings.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CXSnapshotCache::RemoveOldEncodings()
+{
+	EncodingMap::iterator it=m_mapEncodings.begin();
+
+	while(it!=m_mapEncodings.end())
+	{
+		if(m_dwFrame-it->second.m_dwFrame>=SNAPSHOTCACHE_CLEANUP_FRAMES)
+		{
+			EncodingMap::iterator itDel=it;
+			++it;
+			m_mapEncodings.erase(itDel);
+		}
+		else
+			++it;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+DWORD CXSnapshotCache::GetKey( const EntityId id, const EntityCloneState &cs )
+{
+	DWORD dwFlags=0;
+
+	if(cs.m_bSyncYAngle)		dwFlags|=0x1;
+	if(cs.m_bSyncAngles)		dwFlags|=0x2;
+	if(cs.m_bSyncPosition)	dwFlags|=0x4;
+	if(cs.m_bOffSync)				dwFlags|=0x8;
+
+	return (dwFlags<<16) | (DWORD)id;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CXSnapshotCache::IsShareable( IEntity *pEntity, const EntityCloneState &cs )
+{
+	if(cs.m_bLocalplayer)
+		return false;				// m_fWriteStepBack and the private player data are only sent to the owner
+
+	IEntityContainer *pC=pEntity->GetContainer();
+
+	if(pC && !pC->IsNetWriteShareable())
+		return false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CXSnapshotCache::Write( IEntity *pEntity, CStream &stm, EntityCloneState &inoutCloneState )
+{
+	assert(pEntity);
+
+	if(!m_bEnabled || !IsShareable(pEntity,inoutCloneState))
+	{
+		++m_dwGatherDirect;
+		return pEntity->Write(stm,&inoutCloneState);
+	}
+
+	SEncoding &enc=m_mapEncodings[GetKey(pEntity->GetId(),inoutCloneState)];
+
+	if(enc.m_dwFrame!=m_dwFrame || enc.m_pEntity!=pEntity)
+	{
+		ITimer *pTimer=GetISystem()->GetITimer();
+		float fStart=pTimer->GetAsyncCurTime();
+
+		enc.m_stmData.Reset();
+		enc.m_bResult=pEntity->Write(enc.m_stmData,&inoutCloneState);
+		enc.m_v3Angles=inoutCloneState.m_v3Angles;
+		enc.m_pEntity=pEntity;
+		enc.m_dwFrame=m_dwFrame;
+
+		m_fGatherEncodeTime+=pTimer->GetAsyncCurTime()-fStart;
+		++m_dwGatherEncoded;
+	}
+	else
+	{
+		inoutCloneState.m_v3Angles=enc.m_v3Angles;
+		++m_dwGatherShared;
+	}
+
+	if(!stm.Write(enc.m_stmData))
+		return false;
+
+	return enc.m_bResult;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CXSnapshotCache::GetStats( DWORD &outdwEncoded, DWORD &outdwShared, DWORD &outdwDirect, float &outfEncodeMs ) const
+{
+	outdwEncoded=m_dwDrawEncoded;
+	outdwShared=m_dwDrawShared;
+	outdwDirect=m_dwDrawDirect;
+	outfEncodeMs=m_fDrawEncodeTime*1000.0f;
+}
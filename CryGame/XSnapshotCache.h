@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+//
+//	Crytek Source code
+//	Copyright (c) Crytek 2001-2004
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef XSNAPSHOTCACHE_H
+#define XSNAPSHOTCACHE_H
+
+#include <map>					// STL map<>
+#include <Stream.h>			// CStream
+#include <IEntitySystem.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/*!per server frame cache of the entity network encodings (IEntity::Write).
+The snapshots of all serverslots are built in the same server frame, so an entity that is sent to
+several clients is encoded once and the stream is copied into the other snapshots.
+The per-slot parts of the clone state (sync flags, m_bOffSync) select a separate encoding,
+so a slot only gets an encoding that was written for the same flags.
+The local player entity of a slot (which has m_fWriteStepBack and private player data)
+and containers that write per-slot data are never shared.
+*/
+class CXSnapshotCache
+{
+public:
+	//! constructor
+	CXSnapshotCache();
+
+	//! called once per server frame before the snapshots are built, invalidates all encodings
+	//! \param fCurrentTime absolute time, used for the per second statistics
+	//! \param bEnabled false=every Write() encodes the entity directly
+	void BeginFrame( const float fCurrentTime, const bool bEnabled );
+
+	//! drops all cached encodings (e.g. on map change)
+	void Clear();
+
+	//! writes the entity into the stream, the same way as pEntity->Write(stm,&inoutCloneState)
+	//! \param pEntity must not be 0
+	//! \return result of IEntity::Write
+	bool Write( IEntity *pEntity, CStream &stm, EntityCloneState &inoutCloneState );
+
+	//! statistics of the last second (for sv_netstats)
+	//! \param outdwEncoded number of entity encodings
+	//! \param outdwShared number of writes that reused an encoding from another slot
+	//! \param outdwDirect number of writes that can't be shared (local player, per-slot containers)
+	//! \param outfEncodeMs time spent in encoding, in milliseconds
+	void GetStats( DWORD &outdwEncoded, DWORD &outdwShared, DWORD &outdwDirect, float &outfEncodeMs ) const;
+
+private: // -------------------------------------------------------------------
+
+	struct SEncoding
+	{
+		//! constructor
+		SEncoding() :m_pEntity(0), m_dwFrame(0), m_bResult(false) {}
+
+		IEntity *					m_pEntity;					//!< the id can be reused by a new entity in the same frame
+		CStream						m_stmData;					//!< result of IEntity::Write
+		Vec3							m_v3Angles;					//!< m_v3Angles of the clone state after the write
+		DWORD							m_dwFrame;					//!< server frame the encoding was written in
+		bool							m_bResult;					//!< return value of IEntity::Write
+	};
+
+	//! \return key of the encoding, EntityId in the lower 16 bits, the clone state flags above
+	static DWORD GetKey( const EntityId id, const EntityCloneState &cs );
+	//! \return true if the entity writes the same data for every slot with the same clone state flags
+	static bool IsShareable( IEntity *pEntity, const EntityCloneState &cs );
+
+	void RemoveOldEncodings();
+
+	typedef std::map<DWORD,SEncoding>	EncodingMap;
+
+	EncodingMap					m_mapEncodings;				//!< kept between frames to reuse the stream buffers
+	DWORD								m_dwFrame;						//!< current server frame, 0 is never used
+	bool								m_bEnabled;						//!<
+
+	// statistics
+	float								m_fLastTimeReset;			//!< absolute time
+	DWORD								m_dwGatherEncoded;		//!<
+	DWORD								m_dwGatherShared;			//!<
+	DWORD								m_dwGatherDirect;			//!<
+	float								m_fGatherEncodeTime;	//!< in seconds
+	DWORD								m_dwDrawEncoded;			//!<
+	DWORD								m_dwDrawShared;				//!<
+	DWORD								m_dwDrawDirect;				//!<
+	float								m_fDrawEncodeTime;		//!< in seconds
+};
+
+#endif // XSNAPSHOTCACHE_H
@@ -1529,6 +1529,8 @@ bool CXSystemBase::LoadLevelCommon( SMissionInfo &missionInfo )
 {
 	// Start time of level loading.
 	CTimeValue time0 = m_pSystem->GetITimer()->GetCurrTimePrecise();
+	int nScriptCacheHits,nScriptCacheMisses;
+	m_pGame->GetScriptSystem()->GetScriptCacheStats(nScriptCacheHits,nScriptCacheMisses,true);
 	AutoSuspendTimeQuota AutoSuspender(m_pSystem->GetStreamEngine());
 		
 	string sPreviousLevelFolder = m_pGame->m_currentLevelFolder;
@@ -1784,6 +1786,8 @@ bool CXSystemBase::LoadLevelCommon( SMissionInfo &missionInfo )
 	CTimeValue timeLoad = m_pSystem->GetITimer()->GetCurrTimePrecise() - time0;
 	// Log level load times.
 	m_pLog->LogToFile( "\001 Level %s loaded in %.3f seconds",missionInfo.sLevelName.c_str(),timeLoad.GetSeconds() );
+	m_pGame->GetScriptSystem()->GetScriptCacheStats(nScriptCacheHits,nScriptCacheMisses,false);
+	m_pLog->LogToFile( "\001 Scripts: %d precompiled from the script cache, %d compiled",nScriptCacheHits,nScriptCacheMisses );
 	//////////////////////////////////////////////////////////////////////////
 
 	m_pGame->GetSystem()->GetIEntitySystem()->PauseTimers(false,true);	
@@ -63,6 +63,8 @@ void CDatagramSocket::Close()
 {
 	if (m_hSocket == INVALID_SOCKET)
 		return;
+	// send what is still queued (e.g. disconnect messages)
+	Flush();
 	// disable receiving 
 #if defined(LINUX)
 	setsockopt(m_hSocket,IPPROTO_IP,IP_DROP_MEMBERSHIP,(char *)&m_imMulticastReq, sizeof(m_imMulticastReq));
@@ -259,12 +261,46 @@ NRESULT CDatagramSocket::Send(BYTE *pBuffer, int nLenBytes, CIPAddress *saAddres
 		return NET_SOCKET_NOT_CREATED;
 	if (!saAddress)
 		saAddress = &m_saDefaultAddress;
+
+	if (m_nBatchSize && nLenBytes<=DATAGRAM_BATCH_BYTESIZE)
+	{
+		SDatagram &dg = m_pSendRing[m_nSendQueued++];
+
+		memcpy(dg.m_Data, pBuffer, nLenBytes);
+		dg.m_nLen = nLenBytes;
+		dg.m_Address.Set(*saAddress);
+
+		if (m_nSendQueued==m_nBatchSize)
+			return Flush();
+
+		return NET_OK;
+	}
+
+	// bigger than a batch buffer, send the queued ones first to keep the order
+	if (m_nSendQueued)
+		Flush();
+
+	return SendTo(pBuffer, nLenBytes, saAddress);
+}
+
+//////////////////////////////////////////////////////////////////////////
+NRESULT CDatagramSocket::SendTo(BYTE *pBuffer, int nLenBytes, CIPAddress *saAddress)
+{
+	m_nSendCallsInThisSec++;
 	if (sendto(m_hSocket, (const char *)pBuffer, nLenBytes, 0, (sockaddr*)&saAddress->m_Address, sizeof(sockaddr)) == SOCKET_ERROR)
 	{
 		int nErr = WSAGetLastError();
 		//			Close();
 		return MAKE_NRESULT(NET_FAIL, NET_FACILITY_SOCKET, nErr);
 	}
+	OnSent(nLenBytes, *saAddress);
+
+	return NET_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CDatagramSocket::OnSent(int nLenBytes, CIPAddress &saAddress)
+{
 	/// compute the bandwitdh///////////////////////
 	if ((::GetTickCount() - m_nStartTick)>1000)
 		ComputeBandwidth();
@@ -276,10 +312,27 @@ NRESULT CDatagramSocket::Send(BYTE *pBuffer, int nLenBytes, CIPAddress *saAddres
 	CNetwork *pNetwork = (CNetwork*)GetISystem()->GetINetwork();
 	if (pNetwork && pNetwork->GetLogLevel() == 1)
 	{
-		CryLog( "[NET] Send to %s, PacketSize=%d bytes",saAddress->GetAsString(),nLenBytes );
+		CryLog( "[NET] Send to %s, PacketSize=%d bytes",saAddress.GetAsString(),nLenBytes );
 	}
+}
 
-	return NET_OK;
+//////////////////////////////////////////////////////////////////////////
+void CDatagramSocket::OnReceived(int nLenBytes, CIPAddress &saFrom)
+{
+	/// compute the bandwith///////////////////////
+	if ((::GetTickCount() - m_nStartTick)>1000)
+	{
+		ComputeBandwidth();
+	}
+	m_nReceivedBytesInThisSec += nLenBytes;
+	m_nReceivedPacketsInThisSec++;
+	///////////////////////////////////////////////
+
+	CNetwork *pNetwork = (CNetwork*)GetISystem()->GetINetwork();
+	if (pNetwork && pNetwork->GetLogLevel() == 1)
+	{
+		CryLog( "[NET] Recv from %s, PacketSize=%d bytes",saFrom.GetAsString(),nLenBytes );
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -293,6 +346,7 @@ NRESULT CDatagramSocket::Receive(unsigned char *pBuf/*[MAX_UDP_PACKET_SIZE]*/, i
 #else
 	int n = sizeof(sockaddr_in);
 #endif
+	m_nReceiveCallsInThisSec++;
 #if defined(LINUX)
 	if ((nRetValue = recvfrom(m_hSocket, (char *)pBuf, nBufLen, 0, (sockaddr*)&pFrom.m_Address, &n)) < 0)
 #else
@@ -323,23 +377,164 @@ NRESULT CDatagramSocket::Receive(unsigned char *pBuf/*[MAX_UDP_PACKET_SIZE]*/, i
 #endif
 	}
 	nRecvBytes = nRetValue;
-	/// compute the bandwith///////////////////////
-	if ((::GetTickCount() - m_nStartTick)>1000)
+	OnReceived(nRecvBytes, pFrom);
+
+	return NET_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CDatagramSocket::SetBatchSize(int nBatchSize)
+{
+	if (nBatchSize<0)
+		nBatchSize = 0;
+	if (nBatchSize==m_nBatchSize)
+		return;
+
+	if (m_hSocket != INVALID_SOCKET)
+		Flush();
+
+	delete [] m_pReceiveRing;
+	delete [] m_pSendRing;
+	m_pReceiveRing = 0;
+	m_pSendRing = 0;
+#if defined(DATAGRAM_MMSG)
+	delete [] m_pReceiveMsgs;
+	delete [] m_pSendMsgs;
+	delete [] m_pIOVecs;
+	m_pReceiveMsgs = 0;
+	m_pSendMsgs = 0;
+	m_pIOVecs = 0;
+#endif
+
+	m_nBatchSize = nBatchSize;
+	m_nSendQueued = 0;
+	if (!m_nBatchSize)
+		return;
+
+	m_pReceiveRing = new SDatagram[m_nBatchSize];
+	m_pSendRing = new SDatagram[m_nBatchSize];
+#if defined(DATAGRAM_MMSG)
+	// the message headers point to the datagram buffers for good, only the lengths change
+	m_pReceiveMsgs = new struct mmsghdr[m_nBatchSize];
+	m_pSendMsgs = new struct mmsghdr[m_nBatchSize];
+	m_pIOVecs = new struct iovec[m_nBatchSize*2];
+	memset(m_pReceiveMsgs, 0, sizeof(struct mmsghdr)*m_nBatchSize);
+	memset(m_pSendMsgs, 0, sizeof(struct mmsghdr)*m_nBatchSize);
+
+	for (int i=0; i<m_nBatchSize; i++)
 	{
-		ComputeBandwidth();
+		struct iovec *pRecvIOVec = &m_pIOVecs[i];
+		struct iovec *pSendIOVec = &m_pIOVecs[m_nBatchSize+i];
+
+		pRecvIOVec->iov_base = m_pReceiveRing[i].m_Data;
+		pRecvIOVec->iov_len = DATAGRAM_BATCH_BYTESIZE;
+		m_pReceiveMsgs[i].msg_hdr.msg_name = &m_pReceiveRing[i].m_Address.m_Address;
+		m_pReceiveMsgs[i].msg_hdr.msg_iov = pRecvIOVec;
+		m_pReceiveMsgs[i].msg_hdr.msg_iovlen = 1;
+
+		pSendIOVec->iov_base = m_pSendRing[i].m_Data;
+		m_pSendMsgs[i].msg_hdr.msg_name = &m_pSendRing[i].m_Address.m_Address;
+		m_pSendMsgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		m_pSendMsgs[i].msg_hdr.msg_iov = pSendIOVec;
+		m_pSendMsgs[i].msg_hdr.msg_iovlen = 1;
 	}
-	m_nReceivedBytesInThisSec += nRecvBytes;
-	m_nReceivedPacketsInThisSec++;
-	///////////////////////////////////////////////
+#endif
+}
 
-	CNetwork *pNetwork = (CNetwork*)GetISystem()->GetINetwork();
-	if (pNetwork && pNetwork->GetLogLevel() == 1)
+//////////////////////////////////////////////////////////////////////////
+NRESULT CDatagramSocket::ReceiveBatch(int &outnCount)
+{
+	outnCount = 0;
+	if (m_hSocket == INVALID_SOCKET)
+		return NET_SOCKET_NOT_CREATED;
+	assert(m_nBatchSize);
+
+#if defined(DATAGRAM_MMSG)
+	for (int i=0; i<m_nBatchSize; i++)
+		m_pReceiveMsgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+
+	m_nReceiveCallsInThisSec++;
+	int nRetValue = recvmmsg(m_hSocket, m_pReceiveMsgs, m_nBatchSize, MSG_DONTWAIT, NULL);
+
+	if (nRetValue < 0)
+	{
+		if (errno==EAGAIN || errno==EWOULDBLOCK)
+			return NET_OK;
+		return MAKE_NRESULT(NET_FAIL, NET_FACILITY_SOCKET, errno);
+	}
+
+	for (int i=0; i<nRetValue; i++)
 	{
-		CryLog( "[NET] Recv from %s, PacketSize=%d bytes",pFrom.GetAsString(),nRecvBytes );
+		SDatagram &dg = m_pReceiveRing[i];
+
+		dg.m_nLen = (int)m_pReceiveMsgs[i].msg_len;
+		OnReceived(dg.m_nLen, dg.m_Address);
 	}
+	outnCount = nRetValue;
+#else
+	while (outnCount<m_nBatchSize)
+	{
+		SDatagram &dg = m_pReceiveRing[outnCount];
+		int nRecvBytes = 0;
+		NRESULT nRes = Receive(dg.m_Data, DATAGRAM_BATCH_BYTESIZE, nRecvBytes, dg.m_Address);
+
+		if (NET_FAILED(nRes))
+			return outnCount ? NET_OK : nRes;
+		if (nRecvBytes<=0)
+			break;
 
+		dg.m_nLen = nRecvBytes;
+		outnCount++;
+	}
+#endif
 	return NET_OK;
 }
+
+//////////////////////////////////////////////////////////////////////////
+NRESULT CDatagramSocket::Flush()
+{
+	if (!m_nSendQueued)
+		return NET_OK;
+
+	NRESULT nRes = NET_OK;
+
+#if defined(DATAGRAM_MMSG)
+	int i, nSent = 0;
+
+	for (i=0; i<m_nSendQueued; i++)
+		m_pSendMsgs[i].msg_hdr.msg_iov->iov_len = m_pSendRing[i].m_nLen;
+
+	while (nSent<m_nSendQueued)
+	{
+		m_nSendCallsInThisSec++;
+		int nRetValue = sendmmsg(m_hSocket, m_pSendMsgs+nSent, m_nSendQueued-nSent, 0);
+
+		if (nRetValue <= 0)
+		{
+			// the datagram at nSent failed, drop it like a failed sendto() and go on with the rest
+			nRes = MAKE_NRESULT(NET_FAIL, NET_FACILITY_SOCKET, errno);
+			nSent++;
+			continue;
+		}
+
+		for (i=nSent; i<nSent+nRetValue; i++)
+			OnSent(m_pSendRing[i].m_nLen, m_pSendRing[i].m_Address);
+
+		nSent += nRetValue;
+	}
+#else
+	for (int i=0; i<m_nSendQueued; i++)
+	{
+		NRESULT nSendRes = SendTo(m_pSendRing[i].m_Data, m_pSendRing[i].m_nLen, &m_pSendRing[i].m_Address);
+
+		if (NET_FAILED(nSendRes))
+			nRes = nSendRes;
+	}
+#endif
+
+	m_nSendQueued = 0;
+	return nRes;
+}
 const char *GetHostName()
 {
 #ifdef _XBOX
@@ -374,6 +569,8 @@ void CDatagramSocket::ComputeBandwidth()
 	m_fIncomingKbPerSec = ((float)(m_nReceivedBytesInThisSec*8))/1024.f;
 	m_nOutgoingPacketsPerSec = m_nSentPacketsInThisSec;
 	m_nIncomingPacketsPerSec = m_nReceivedPacketsInThisSec;
+	m_nSendCallsPerSec = m_nSendCallsInThisSec;
+	m_nReceiveCallsPerSec = m_nReceiveCallsInThisSec;
 
 	m_nStartTick=::GetTickCount();
 
@@ -381,4 +578,6 @@ void CDatagramSocket::ComputeBandwidth()
 	m_nReceivedBytesInThisSec = 0;
 	m_nSentPacketsInThisSec = 0;
 	m_nReceivedPacketsInThisSec = 0;
+	m_nSendCallsInThisSec = 0;
+	m_nReceiveCallsInThisSec = 0;
 }
@@ -39,6 +39,22 @@
 #include <time.h>
 #endif //LINUX
 
+// recvmmsg/sendmmsg: many datagrams with one system call
+#if defined(LINUX) && defined(MSG_WAITFORONE)
+#define DATAGRAM_MMSG
+#endif
+
+// the server processes received datagrams in place as CStream, so they may not be bigger than a CStream
+#define DATAGRAM_BATCH_BYTESIZE		DEFAULT_STREAM_BYTESIZE
+
+//! one datagram buffer of a CDatagramSocket batch
+struct SDatagram
+{
+	BYTE							m_Data[DATAGRAM_BATCH_BYTESIZE];	//!<
+	int								m_nLen;										//!< in bytes
+	CIPAddress				m_Address;								//!< sender or receiver
+};
+
 /*inline int	gethostname(char *__name, size_t __len)
 {
 #pragma message ("gethostname not implemented")
@@ -69,11 +85,27 @@ public:
 		m_fOutgoingKbPerSec=0.0f;
 		m_nIncomingPacketsPerSec=0;
 		m_nOutgoingPacketsPerSec=0;
+
+		m_nSendCallsInThisSec=0;
+		m_nReceiveCallsInThisSec=0;
+		m_nSendCallsPerSec=0;
+		m_nReceiveCallsPerSec=0;
+
+		m_nBatchSize=0;
+		m_nSendQueued=0;
+		m_pReceiveRing=0;
+		m_pSendRing=0;
+#if defined(DATAGRAM_MMSG)
+		m_pReceiveMsgs=0;
+		m_pSendMsgs=0;
+		m_pIOVecs=0;
+#endif
 	}
 	//! destructor
 	virtual ~CDatagramSocket()
 	{
 		Close(); 
+		SetBatchSize(0);
 		//<<FIXME>>
 	}
 	//!
@@ -89,6 +121,18 @@ public:
 	NRESULT Send(BYTE *pBuffer, int nLenBytes, CIPAddress *saAddress = NULL);
 	//!
 	NRESULT Receive(unsigned char *pBuf/*[MAX_UDP_PACKET_SIZE]*/, int nBufLen, int &nRecvBytes, CIPAddress &pFrom);
+	//! enables batching with nBatchSize preallocated datagram buffers for receiving and for sending, 0 disables it
+	//! with batching Send() only queues the datagram, it's sent with Flush() or when the queue is full
+	void SetBatchSize(int nBatchSize);
+	//!
+	int GetBatchSize() const { return m_nBatchSize; }
+	//! receives up to GetBatchSize() datagrams (one recvmmsg on Linux, a recvfrom loop elsewhere)
+	//! \param outnCount number of datagrams received, they are valid until the next ReceiveBatch()
+	NRESULT ReceiveBatch(int &outnCount);
+	//! \param n 0..outnCount-1 of the last ReceiveBatch()
+	SDatagram &GetReceived(int n) { return m_pReceiveRing[n]; }
+	//! sends the datagrams queued by Send() (one sendmmsg on Linux, a sendto loop elsewhere)
+	NRESULT Flush();
 
 	const char *GetHostName();
 	//!
@@ -101,6 +145,13 @@ public:
 	void Close();
 
 private:
+	//! bandwidth statistics and net_log for one datagram
+	void OnSent(int nLenBytes, CIPAddress &saAddress);
+	//!
+	void OnReceived(int nLenBytes, CIPAddress &saFrom);
+	//!
+	NRESULT SendTo(BYTE *pBuffer, int nLenBytes, CIPAddress *saAddress);
+
 	SOCKET						m_hSocket;										//!<
 	SocketType				m_stSocketType;								//!<
 	CIPAddress				m_saDefaultAddress;						//!< Default target host and port [optional] for Send()
@@ -110,6 +161,18 @@ private:
 	unsigned int			m_nReceivedBytesInThisSec;		//!< is counting up and reseted every second
 	unsigned int			m_nSentPacketsInThisSec;			//!< is counting up and reseted every second
 	unsigned int			m_nReceivedPacketsInThisSec;	//!< is counting up and reseted every second
+	unsigned int			m_nSendCallsInThisSec;				//!< is counting up and reseted every second
+	unsigned int			m_nReceiveCallsInThisSec;			//!< is counting up and reseted every second
+
+	int								m_nBatchSize;									//!< 0=no batching
+	int								m_nSendQueued;								//!< datagrams in m_pSendRing waiting for Flush()
+	SDatagram *				m_pReceiveRing;								//!< [m_nBatchSize]
+	SDatagram *				m_pSendRing;									//!< [m_nBatchSize]
+#if defined(DATAGRAM_MMSG)
+	struct mmsghdr *	m_pReceiveMsgs;								//!< [m_nBatchSize]
+	struct mmsghdr *	m_pSendMsgs;									//!< [m_nBatchSize]
+	struct iovec *		m_pIOVecs;										//!< [m_nBatchSize*2], receive then send
+#endif
 #if defined(LINUX)
 	struct ip_mreq		m_imMulticastReq;							//!< needed for call to IP_DROP_MEMBERSHIP
 #endif
@@ -119,6 +182,8 @@ public:
 	float							m_fIncomingKbPerSec;					//!< is updated every second
 	unsigned int			m_nOutgoingPacketsPerSec;			//!< is updated every second
 	unsigned int			m_nIncomingPacketsPerSec;			//!< is updated every second
+	unsigned int			m_nSendCallsPerSec;						//!< system calls, is updated every second
+	unsigned int			m_nReceiveCallsPerSec;				//!< system calls, is updated every second
 };
 
 
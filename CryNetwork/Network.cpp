@@ -218,6 +218,22 @@ void CNetwork::CreateConsoleVars()
 		"Sets the local port for a CDKey authentication comunications.\n"
 		"Usage: sv_auth_port portnumber\n"
 		"Default is '0' (first free).");
+	m_pSystem->GetIConsole()->CreateVariable("net_batch_packets","32",0,
+		"Number of datagrams the server receives and sends with one system call (next server creation).\n"
+		"Uses recvmmsg/sendmmsg on Linux, elsewhere only the sends are collected until the end of the server update.\n"
+		"Usage: net_batch_packets 32\n"
+		"Default is 32, 0 sends and receives every datagram on its own.");
+	m_pSystem->GetIConsole()->CreateVariable("net_loadtest_clients","0",0,
+		"Number of clients the server impersonates over loopback to measure its receive path.\n"
+		"The results are logged once per second.\n"
+		"Usage: net_loadtest_clients 64\n"
+		"Default is 0 (off).");
+	m_pSystem->GetIConsole()->CreateVariable("net_loadtest_rate","30",0,
+		"Datagrams per second every net_loadtest_clients client sends.\n"
+		"Usage: net_loadtest_rate 30");
+	m_pSystem->GetIConsole()->CreateVariable("net_loadtest_size","100",0,
+		"Size of the net_loadtest_clients datagrams in bytes.\n"
+		"Usage: net_loadtest_size 100");
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -16,8 +16,10 @@
 #include "CNP.h"
 #include "Server.h"
 #include "ServerSlot.h"
+#include "ServerLoadTest.h"
 #include "ILog.h"
 #include "IConsole.h"
+#include "ITimer.h"
 #include <IScriptSystem.h>
 
 #if defined(_DEBUG) && !defined(LINUX)
@@ -151,6 +153,13 @@ CServer::CServer(CNetwork *pNetwork)
 	m_bMulticastSocket=true;
 	m_pSecuritySink=0;
 	m_MPServerType=eMPST_LAN;
+	m_pLoadTest=0;
+	m_pVarLoadTestClients=0;
+	m_pVarLoadTestRate=0;
+	m_pVarLoadTestSize=0;
+	m_nProcessedInThisSec=0;
+	m_fProcessTimeInThisSec=0;
+	m_fLastLoadTestLog=0;
 }
 
 CServer::~CServer()
@@ -164,6 +173,8 @@ CServer::~CServer()
 #endif
 	//------------------------------------------------------------------------------------------------- 
 
+	delete m_pLoadTest;
+
 	m_pNetwork->UnregisterServer(m_wPort);
 }
 
@@ -222,6 +233,14 @@ bool CServer::Init(IServerSlotFactory *pFactory, WORD wPort, bool listen)
 		if (NET_FAILED(m_socketMain.Listen(wPort, 0, &ipLocal)))
 			return false;
 
+		ICVar *pVarBatch = GetISystem()->GetIConsole()->GetCVar("net_batch_packets");
+		if (pVarBatch)
+			m_socketMain.SetBatchSize(pVarBatch->GetIVal());
+
+		m_pVarLoadTestClients = GetISystem()->GetIConsole()->GetCVar("net_loadtest_clients");
+		m_pVarLoadTestRate = GetISystem()->GetIConsole()->GetCVar("net_loadtest_rate");
+		m_pVarLoadTestSize = GetISystem()->GetIConsole()->GetCVar("net_loadtest_size");
+
 		//------------------------------------------------------------------------------------------------- 
 		// ASE Initialization
 		//------------------------------------------------------------------------------------------------- 
@@ -295,31 +314,22 @@ void CServer::Update(unsigned int nTime)
 
 	m_nCurrentTime = nTime;
 	int nRecvBytes;
+
+	// send what was queued since the last update (e.g. the snapshots) before processing new packets
+	m_socketMain.Flush();
+
+	if(m_bListen)
+	{
+		UpdateLoadTest();
+		ReceivePackets();
+	}
+
 	//	do{
 	/////////////////////////////////////////////////////////
 	/////////////////////////////////////////////////////////
 		static CIPAddress ipFrom;
 		static CStream buf;
 		
-		/////////////////////////////////////////////////////////
-		if(m_bListen)
-		do
-		{
-			buf.Reset();
-			nRecvBytes = 0;
-			m_socketMain.Receive(buf.GetPtr(),
-				(int)BITS2BYTES(buf.GetAllocatedSize()),
-				nRecvBytes,
-				ipFrom);
-						
-			///////////////////////////////////////////////////////
-			if (nRecvBytes>0)
-			{
-				buf.SetSize(BYTES2BITS(nRecvBytes));
-				ProcessPacket(buf, ipFrom);
-			}
-		}while (nRecvBytes>0);
-
 		/////////////////////////////////////////////////////////
 		// handle multicast packets
 		/////////////////////////////////////////////////////////
@@ -356,9 +366,106 @@ void CServer::Update(unsigned int nTime)
 			++itr;
 		}
 
+	m_socketMain.Flush();
+
 	m_pNetwork->OnServerUpdate();
 }
 
+//////////////////////////////////////////////////////////////////////////
+void CServer::ReceivePackets()
+{
+	ITimer *pTimer = GetISystem()->GetITimer();
+	float fStartTime = pTimer->GetAsyncCurTime();
+	int nBatchSize = m_socketMain.GetBatchSize();
+
+	if(nBatchSize)
+	{
+		int nCount;
+		do
+		{
+			nCount = 0;
+			m_socketMain.ReceiveBatch(nCount);
+
+			for(int n=0;n<nCount;n++)
+			{
+				SDatagram &dg = m_socketMain.GetReceived(n);
+
+				if(dg.m_nLen>0)
+				{
+					// the stream reads straight from the batch buffer
+					CStream stm(dg.m_nLen, dg.m_Data);
+					ProcessPacket(stm, dg.m_Address);
+					m_nProcessedInThisSec++;
+				}
+			}
+		}while (nCount==nBatchSize);		// a partial batch means the socket is empty
+	}
+	else
+	{
+		static CIPAddress ipFrom;
+		static CStream buf;
+		int nRecvBytes;
+
+		do
+		{
+			buf.Reset();
+			nRecvBytes = 0;
+			m_socketMain.Receive(buf.GetPtr(),
+				(int)BITS2BYTES(buf.GetAllocatedSize()),
+				nRecvBytes,
+				ipFrom);
+						
+			///////////////////////////////////////////////////////
+			if (nRecvBytes>0)
+			{
+				buf.SetSize(BYTES2BITS(nRecvBytes));
+				ProcessPacket(buf, ipFrom);
+				m_nProcessedInThisSec++;
+			}
+		}while (nRecvBytes>0);
+	}
+
+	m_fProcessTimeInThisSec += pTimer->GetAsyncCurTime()-fStartTime;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CServer::UpdateLoadTest()
+{
+	int nClients = m_pVarLoadTestClients ? m_pVarLoadTestClients->GetIVal() : 0;
+
+	if(nClients>0 && !m_pLoadTest)
+		m_pLoadTest = new CServerLoadTest;
+
+	if(m_pLoadTest)
+	{
+		m_pLoadTest->Update(m_wPort, nClients>0 ? nClients : 0, m_pVarLoadTestRate->GetIVal(), m_pVarLoadTestSize->GetIVal());
+
+		if(!m_pLoadTest->GetClientCount())
+		{
+			delete m_pLoadTest;
+			m_pLoadTest = 0;
+		}
+	}
+
+	float fTime = GetISystem()->GetITimer()->GetAsyncCurTime();
+
+	if(fTime-m_fLastLoadTestLog>1.0f || fTime<m_fLastLoadTestLog)
+	{
+		if(m_pLoadTest)
+		{
+			float fMsPerPacket = m_nProcessedInThisSec ? m_fProcessTimeInThisSec*1000.0f/(float)m_nProcessedInThisSec : 0.0f;
+
+			CryLog("[NET] loadtest %d clients: sent %d/s, processed %d/s in %.2fms (%.4fms per packet), %d recv calls/s, %d send calls/s, batch %d",
+				m_pLoadTest->GetClientCount(), m_pLoadTest->GetSentPerSec(), m_nProcessedInThisSec, m_fProcessTimeInThisSec*1000.0f,
+				fMsPerPacket, m_socketMain.m_nReceiveCallsPerSec, m_socketMain.m_nSendCallsPerSec, m_socketMain.GetBatchSize());
+		}
+
+		m_nProcessedInThisSec = 0;
+		m_fProcessTimeInThisSec = 0;
+		m_fLastLoadTestLog = fTime;
+	}
+}
+
 void CServer::GetBandwidth( float &fIncomingKbPerSec, float &fOutgoinKbPerSec, DWORD &nIncomingPackets, DWORD &nOutgoingPackets )
 {
 	fIncomingKbPerSec = m_socketMain.m_fIncomingKbPerSec;
@@ -457,6 +564,7 @@ void CServer::OnDestructSlot( const CServerSlot *inpServerSlot )
 		if(pSlot==inpServerSlot)
 		{
 			m_mapSlots.erase(itr);
+			RebuildSlotIndex();
 			return;
 		}
 		++itr;
@@ -479,17 +587,74 @@ void CServer::UnregisterSlot(CIPAddress &ip)
 void CServer::RegisterLocalServerSlot(CServerSlot *pSlot,CIPAddress &ip)
 {
 	m_mapSlots.insert(SLOTS_MAPItr::value_type(ip,pSlot));
+	RebuildSlotIndex();
 	if(m_pFactory)
 		m_pFactory->CreateServerSlot(pSlot);
 }
 
 CServerSlot *CServer::GetPacketOwner(CIPAddress &ip)
 {
-	SLOTS_MAPItr itor;
-	itor=m_mapSlots.find(ip);
-	if(itor==m_mapSlots.end())
+	return FindSlot(ip);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static inline unsigned int SlotIndexHash(UINT dwAddr, WORD wPort)
+{
+	unsigned int h = (unsigned int)dwAddr*0x9E3779B1u;
+	return h ^ (h>>16) ^ ((unsigned int)wPort*0x85EBCA6Bu);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CServer::RebuildSlotIndex()
+{
+	// at most half full, so the probe sequences stay short
+	size_t nSize = 16;
+	while(nSize < m_mapSlots.size()*2)
+		nSize *= 2;
+
+	SSlotIndexEntry empty;
+	empty.m_dwAddr = 0;
+	empty.m_wPort = 0;
+	empty.m_pSlot = 0;
+	m_vSlotIndex.assign(nSize, empty);
+
+	for(SLOTS_MAPItr it=m_mapSlots.begin();it!=m_mapSlots.end();++it)
+	{
+		UINT dwAddr = it->first.m_Address.ADDR;
+		WORD wPort = it->first.m_Address.sin_port;
+		size_t i = SlotIndexHash(dwAddr, wPort) & (nSize-1);
+
+		while(m_vSlotIndex[i].m_pSlot)
+			i = (i+1) & (nSize-1);
+
+		m_vSlotIndex[i].m_dwAddr = dwAddr;
+		m_vSlotIndex[i].m_wPort = wPort;
+		m_vSlotIndex[i].m_pSlot = it->second;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+CServerSlot *CServer::FindSlot(const CIPAddress &ip) const
+{
+	if(m_vSlotIndex.empty())
 		return 0;
-	return itor->second;
+
+	size_t nMask = m_vSlotIndex.size()-1;
+	UINT dwAddr = ip.m_Address.ADDR;
+	WORD wPort = ip.m_Address.sin_port;
+	size_t i = SlotIndexHash(dwAddr, wPort) & nMask;
+
+	while(m_vSlotIndex[i].m_pSlot)
+	{
+		const SSlotIndexEntry &entry = m_vSlotIndex[i];
+
+		if(entry.m_dwAddr==dwAddr && entry.m_wPort==wPort)
+			return entry.m_pSlot;
+
+		i = (i+1) & nMask;
+	}
+
+	return 0;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -687,6 +852,7 @@ void CServer::ProcessSetup(CNP &cnp, CStream &stmStream, CIPAddress &ip)
 		if (m_pFactory->CreateServerSlot(pSSlot) == true)
 		{
 			m_mapSlots.insert(SLOTS_MAPItr::value_type(ip, pSSlot));
+			RebuildSlotIndex();
 			//m_mapIPs.insert(IPS_MAPItr::value_type(ip,nID));
 
 			// if this is a lan server
@@ -759,11 +925,10 @@ bool CServer::IsLANIP(const CIPAddress &ip)
 
 void CServer::DispatchToServerSlots(CNP &cnp, CStream &stm, CIPAddress &ip)
 {
-	SLOTS_MAPItr itr;
-	itr = m_mapSlots.find(ip);
-	if (itr != m_mapSlots.end())
+	CServerSlot *pSlot = FindSlot(ip);
+	if (pSlot)
 	{
-		(itr->second)->Update(m_nCurrentTime, &cnp, &stm); // update the server slot
+		pSlot->Update(m_nCurrentTime, &cnp, &stm); // update the server slot
 	}
 	else
 	{
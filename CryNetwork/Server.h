@@ -22,9 +22,12 @@
 #include <map>
 #include <queue>
 #include <list>
+#include <vector>
 
 class CServerSlot;
 class CNetwork;
+class CServerLoadTest;
+struct ICVar;
 
 #if !defined(LINUX)
 #pragma warning(disable:4786) 
@@ -106,6 +109,14 @@ private:
 	void ProcessMulticastPacket(CStream &stmPacket,CIPAddress &ip);
 	//!
 	unsigned char GenerateNewClientID();
+	//! \return the slot of the sender, 0 if there is none (same result as m_mapSlots.find())
+	CServerSlot *FindSlot(const CIPAddress &ip) const;
+	//! has to be called whenever m_mapSlots changes
+	void RebuildSlotIndex();
+	//! receive path of Update(), with or without batching
+	void ReceivePackets();
+	//! loopback load generator and its log
+	void UpdateLoadTest();
 
 
 	typedef std::map<unsigned char,INetworkPacketSink *> TPacketSinks;
@@ -132,6 +143,23 @@ private:
 	TPacketSinks							m_PacketSinks;					//!< <inPacketID,callback interface>
 	EMPServerType							m_MPServerType;					//!< depends on sv_Servertype at Init() time
 
+	struct SSlotIndexEntry
+	{
+		UINT										m_dwAddr;								//!<
+		WORD										m_wPort;								//!<
+		CServerSlot *						m_pSlot;								//!< 0 for an empty entry
+	};
+
+	std::vector<SSlotIndexEntry>	m_vSlotIndex;					//!< open addressing hash of m_mapSlots for the packet dispatch, power of 2 size
+
+	CServerLoadTest *					m_pLoadTest;						//!< 0 if not used
+	ICVar *										m_pVarLoadTestClients;	//!<
+	ICVar *										m_pVarLoadTestRate;			//!<
+	ICVar *										m_pVarLoadTestSize;			//!<
+	unsigned int							m_nProcessedInThisSec;	//!< received packets, is counting up and reseted every second
+	float											m_fProcessTimeInThisSec;//!< in seconds, receiving and dispatching
+	float											m_fLastLoadTestLog;			//!< absolute time
+
 	// -----------------------------------------------------------------------------------
 
 #ifdef _INTERNET_SIMULATOR
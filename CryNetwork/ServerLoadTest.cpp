@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////
+//
+//	Crytek Network source code
+//
+//	File: ServerLoadTest.cpp
+//  Description: loopback load generator for the server socket
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "CNP.h"
+#include "ServerLoadTest.h"
+#include <ITimer.h>
+
+#if defined(_DEBUG) && !defined(LINUX)
+static char THIS_FILE[] = __FILE__;
+#define DEBUG_CLIENTBLOCK new( _NORMAL_BLOCK, THIS_FILE, __LINE__)
+#define new DEBUG_CLIENTBLOCK
+#endif
+
+// upper limit for the datagrams one client sends in one update (after a long frame)
+#define LOADTEST_MAX_BURST		64
+
+//////////////////////////////////////////////////////////////////////////
+CServerLoadTest::CServerLoadTest()
+{
+	m_fLastTime=0;
+	m_fPacketsDue=0;
+	m_fLastSecond=0;
+	m_nSentInThisSec=0;
+	m_nSentPerSec=0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+CServerLoadTest::~CServerLoadTest()
+{
+	Update(0,0,0,0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CServerLoadTest::Update(WORD wServerPort, int nClients, int nPacketsPerSec, int nPacketBytes)
+{
+	// remove clients
+	while((int)m_vClients.size()>nClients)
+	{
+		delete m_vClients.back();
+		m_vClients.pop_back();
+	}
+
+	if(m_vClients.empty() && !nClients)
+		return;
+
+	CIPAddress ipServer(wServerPort,"127.0.0.1");
+
+	// add clients, the socket gets its own port with the first send
+	while((int)m_vClients.size()<nClients)
+	{
+		CDatagramSocket *pSocket=new CDatagramSocket;
+
+		if(NET_FAILED(pSocket->Create()))
+		{
+			delete pSocket;
+			CryLog("[NET] loadtest: can't create more than %d client sockets",(int)m_vClients.size());
+			break;
+		}
+		pSocket->SetDefaultTarget(ipServer);
+		m_vClients.push_back(pSocket);
+	}
+
+	float fTime=GetISystem()->GetITimer()->GetAsyncCurTime();
+
+	if(m_fLastTime==0 || fTime<m_fLastTime)
+		m_fLastTime=fTime;
+
+	m_fPacketsDue+=(fTime-m_fLastTime)*(float)nPacketsPerSec;
+	m_fLastTime=fTime;
+
+	int nPackets=(int)m_fPacketsDue;
+
+	m_fPacketsDue-=(float)nPackets;
+	if(nPackets>LOADTEST_MAX_BURST)
+		nPackets=LOADTEST_MAX_BURST;
+
+	if(nPackets>0)
+	{
+		// a pong is dispatched to the server slot of the sender without further checks
+		CStream stm;
+		CNP cnp;
+
+		cnp.m_cFrameType=FT_CTP_PONG;
+		cnp.Save(stm);
+
+		int nBits=BYTES2BITS(nPacketBytes);
+
+		if(nBits>(int)stm.GetAllocatedSize())
+			nBits=(int)stm.GetAllocatedSize();
+		while((int)stm.GetSize()<nBits)
+			stm.Write(false);
+
+		for(std::vector<CDatagramSocket*>::iterator it=m_vClients.begin();it!=m_vClients.end();++it)
+		for(int i=0;i<nPackets;i++)
+		{
+			if(NET_SUCCEDED((*it)->Send(stm.GetPtr(),BITS2BYTES(stm.GetSize()))))
+				m_nSentInThisSec++;
+		}
+	}
+
+	if(fTime-m_fLastSecond>1.0f || fTime<m_fLastSecond)
+	{
+		m_nSentPerSec=m_nSentInThisSec;
+		m_nSentInThisSec=0;
+		m_fLastSecond=fTime;
+	}
+}
@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////
+//
+//	Crytek Network source code
+//
+//	File: ServerLoadTest.h
+//  Description: loopback load generator for the server socket
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _SERVER_LOAD_TEST_H_
+#define _SERVER_LOAD_TEST_H_
+
+#if _MSC_VER > 1000
+#pragma once
+#endif // _MSC_VER > 1000
+
+#include <vector>
+
+class CDatagramSocket;
+
+/*! sends datagrams to the local server from many loopback sockets, one per impersonated client,
+so the receive path and the slot lookup of the server can be measured without real clients.
+The clients don't do the connection setup, the server drops their packets after the slot lookup.
+Controlled with net_loadtest_clients, net_loadtest_rate and net_loadtest_size.
+*/
+class CServerLoadTest
+{
+public:
+	//! constructor
+	CServerLoadTest();
+	//! destructor
+	~CServerLoadTest();
+
+	//! called every server update, creates or removes clients and sends the datagrams due
+	//! \param wServerPort port of the server on this machine
+	//! \param nClients number of clients to impersonate
+	//! \param nPacketsPerSec per client
+	//! \param nPacketBytes size of a datagram
+	void Update(WORD wServerPort, int nClients, int nPacketsPerSec, int nPacketBytes);
+
+	//! \return number of impersonated clients
+	int GetClientCount() const { return (int)m_vClients.size(); }
+	//! \return number of datagrams sent in the last second
+	unsigned int GetSentPerSec() const { return m_nSentPerSec; }
+
+private:
+	std::vector<CDatagramSocket*>		m_vClients;								//!<
+	float														m_fLastTime;							//!< absolute time of the last Update
+	float														m_fPacketsDue;						//!< per client, fraction carried to the next Update
+	float														m_fLastSecond;						//!< absolute time
+	unsigned int										m_nSentInThisSec;					//!< is counting up and reseted every second
+	unsigned int										m_nSentPerSec;						//!< is updated every second
+};
+
+#endif //_SERVER_LOAD_TEST_H_
@@ -2,10 +2,12 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "bvtree.h"
 #include "geometry.h"
 #include "aabbtree.h"
 #include "trimesh.h"
+#include "geomscratch.h"
 
 struct BBoxExt : BBox {
 	box aboxStatic;
@@ -24,7 +24,7 @@
 #include "rigidentity.h"
 #include "articulatedentity.h"
 
-int __ae_step=0; // for debugging
+volatile long __ae_step=0; // for debugging, incremented from island worker lanes
 
 CArticulatedEntity::CArticulatedEntity(CPhysicalWorld *pWorld) : CRigidEntity(pWorld)
 {
@@ -2066,9 +2066,9 @@ void CArticulatedEntity::GetJointTorqueResponseMatrix(int idx, matrix3x3f &K)
 }
 
 
-entity_contact *CArticulatedEntity::CreateConstraintContact(int idx)
+entity_contact *CArticulatedEntity::CreateConstraintContact(int idx, SolverContext *psc)
 {
-	entity_contact *pcontact = (entity_contact*)AllocSolverTmpBuf(sizeof(entity_contact));
+	entity_contact *pcontact = (entity_contact*)AllocSolverTmpBuf(psc,sizeof(entity_contact));
 	if (!pcontact) 
 		return 0;
 	pcontact->flags = 0;
@@ -2093,12 +2093,12 @@ entity_contact *CArticulatedEntity::CreateConstraintContact(int idx)
 }
 
 
-int CArticulatedEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
+int CArticulatedEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc)
 {
 	int idx,i,j,iAxes[3];
 	masktype contacts_mask,constraints_mask;
 	entity_contact *pcontact;
-__ae_step++;
+InterlockedIncrement(&__ae_step);
 
 	UpdateConstraints();
 
@@ -2113,7 +2113,7 @@ __ae_step++;
 		m_joints[idx].iContacts &= contacts_mask;
 		for(i=0; i<NMASKBITS && getmask(i)<=m_joints[idx].iContacts; i++) 
 		if (m_joints[idx].iContacts & getmask(i) && !(m_pContacts[i].flags & contact_2b_verified)) {
-			RegisterContact(m_pContacts+i);
+			RegisterContact(psc,m_pContacts+i);
 			if (i==31 || getmask(i+1)>m_joints[idx].iContacts) // register only the last contact in history
 				ArchiveContact(i);
 		}
@@ -2121,11 +2121,11 @@ __ae_step++;
 		for(i=0;i<NMASKBITS && getmask(i)<=constraints_mask;i++) 
 		if (constraints_mask&getmask(i) && m_pConstraintInfos[i].bActive && 
 				(unsigned int)(m_pConstraints[i].ipart[0]-m_joints[idx].iStartPart) < (unsigned int)m_joints[idx].nParts)
-			RegisterContact(m_pConstraints+i);
+			RegisterContact(psc,m_pConstraints+i);
 
 		if (m_bGrounded || m_joints[idx].iParent>=0) {
 			vectorf pivot[2],axisDrift(zero);
-			if (!(pcontact = CreateConstraintContact(idx)))
+			if (!(pcontact = CreateConstraintContact(idx,psc)))
 				break;
 			pcontact->flags = contact_constraint_3dof;
 			GetContactMatrix(pcontact->pt[0], pcontact->ipart[0], pcontact->K);
@@ -2143,14 +2143,14 @@ __ae_step++;
 				pcontact->pt[1] = pivot[0];
 			} else
 				pcontact->n.Set(0,0,1);
-			RegisterContact(pcontact);
+			RegisterContact(psc,pcontact);
 
 			for(i=j=0;i<3;i++) if (!(m_joints[idx].flags & (angle0_locked|angle0_gimbal_locked)<<i))
 				iAxes[j++] = i;
 			else
 				axisDrift += m_joints[idx].rotaxes[i]*min(1.0f,m_joints[idx].q0[i]-m_joints[idx].q[i]);
 			if ((unsigned int)j-1u<2u) {
-				if (!(pcontact = CreateConstraintContact(idx)))
+				if (!(pcontact = CreateConstraintContact(idx,psc)))
 					break;
 
 				if (m_iSimTypeCur && j==1 && m_joints[idx].flags&joint_expand_hinge) {
@@ -2220,11 +2220,11 @@ __ae_step++;
 					if (pcontact->vreq.len2()>sqr(5.0f))
 						pcontact->vreq.normalize() *= 5.0f;
 				}
-				RegisterContact(pcontact);
+				RegisterContact(psc,pcontact);
 			}
 
 			for(i=0;i<3;i++) if (m_joints[idx].flags & angle0_limit_reached<<i) {
-				if (!(pcontact = CreateConstraintContact(idx)))
+				if (!(pcontact = CreateConstraintContact(idx,psc)))
 					break;
 				pcontact->K = m_joints[idx].body.Iinv;
 				if (m_joints[idx].iParent>=0)
@@ -2234,7 +2234,7 @@ __ae_step++;
 				if (m_iSimTypeCur)
 					pcontact->vreq = pcontact->n*min(5.0f,fabsf(m_joints[idx].dq_limit[i])*4.0f);
 				//pcontact->vsep = -0.01f;
-				RegisterContact(pcontact);
+				RegisterContact(psc,pcontact);
 			}
 		}
 	}
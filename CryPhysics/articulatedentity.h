@@ -146,7 +146,7 @@ class CArticulatedEntity : public CRigidEntity, public IRigidBodyOwner {
 	virtual float GetMaxTimeStep(float time_interval);
 	virtual int Step(float time_interval);
 	virtual void StepBack(float time_interval);
-	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts);
+	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc);
 	virtual int Update(float time_interval, float damping);
 	virtual float CalcEnergy(float time_interval);
 	virtual float GetDamping(float time_interval);
@@ -174,7 +174,7 @@ class CArticulatedEntity : public CRigidEntity, public IRigidBodyOwner {
 	void GetJointTorqueResponseMatrix(int idx, matrix3x3f &K);
 
 	int IsChildOf(int idx, int iParent) { return isnonneg(iParent) & isneg(iParent-idx) & isneg(idx-iParent-m_joints[iParent].nChildrenTree-1); }
-	entity_contact *CreateConstraintContact(int idx);
+	entity_contact *CreateConstraintContact(int idx, SolverContext *psc);
 
 	ae_part_info *m_infos;
 	ae_joint *m_joints;
@@ -9,6 +9,7 @@
 #include "geometry.h"
 #include "trimesh.h"
 #include "boxgeom.h"
+#include "geomscratch.h"
 
 vector2df g_BoxCont[8];
 int g_BoxVtxId[8],g_BoxEdgeId[8];
@@ -52,10 +53,6 @@ int CBoxGeom::PointInsideStatus(const vectorf &pt)
 
 int CBoxGeom::PrepareForIntersectionTest(geometry_under_test *pGTest, CGeometry *pCollider,geometry_under_test *pGTestColl, bool bKeepPrevContacts)
 {
-	static short g_BoxIdBuf[3];
-	static surface_desc g_BoxSurfaceBuf[3];
-	static edge_desc g_BoxEdgeBuf[3];
-
 	pGTest->pGeometry = this;
 	pGTest->pBVtree = &m_Tree;
 	m_Tree.PrepareForIntersectionTest(pGTest);
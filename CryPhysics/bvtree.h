@@ -1,15 +1,6 @@
 #ifndef bvtree_h
 #define bvtree_h
 
-extern indexed_triangle g_IdxTriBuf[256];
-extern int g_IdxTriBufPos;
-extern cylinder g_CylBuf[2];
-extern int g_CylBufPos;
-extern sphere g_SphBuf[2];
-extern int g_SphBufPos;
-extern box g_BoxBuf[2];
-extern int g_BoxBufPos;
-
 ////////////////////////// bounding volumes ////////////////////////
 
 struct BV {
@@ -21,8 +12,6 @@ struct BV {
 struct BBox : BV {
 	box abox;
 };
-extern BBox g_BBoxBuf[128];
-extern int g_BBoxBufPos;
 
 struct BVheightfield : BV {
 	heightfield hf;
@@ -32,15 +21,6 @@ struct BVray : BV {
 	ray aray;
 };
 
-inline void ResetGlobalPrimsBuffers()
-{
-	g_BBoxBufPos = 0;
-	g_IdxTriBufPos = 0;
-	g_CylBufPos = 0;
-	g_BoxBufPos = 0;
-	g_SphBufPos = 0;
-}
-
 class CGeometry;
 class CBVTree;
 
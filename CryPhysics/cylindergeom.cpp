@@ -2,6 +2,7 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "unprojectionchecks.h"
 #include "bvtree.h"
 #include "singleboxtree.h"
@@ -9,6 +10,7 @@
 #include "cylindergeom.h"
 #include "trimesh.h"
 #include "boxgeom.h"
+#include "geomscratch.h"
 
 vector2df g_CylCont[64];
 int g_CylContId[64];
@@ -59,10 +61,6 @@ int CCylinderGeom::PointInsideStatus(const vectorf &pt)
 
 int CCylinderGeom::PrepareForIntersectionTest(geometry_under_test *pGTest, CGeometry *pCollider,geometry_under_test *pGTestColl, bool bKeepPrevContacts)
 {
-	static short g_CylIdBuf[1];
-	static surface_desc g_CylSurfaceBuf[1];
-	static edge_desc g_CylEdgeBuf[1];
-
 	pGTest->pGeometry = this;
 	pGTest->pBVtree = &m_Tree;
 	m_Tree.PrepareForIntersectionTest(pGTest);
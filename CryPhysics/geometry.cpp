@@ -9,60 +9,10 @@
 #include "geometry.h"
 #include "singleboxtree.h"
 #include "spheregeom.h"
-
-
-indexed_triangle g_IdxTriBuf[256];
-int g_IdxTriBufPos;
-cylinder g_CylBuf[2];
-int g_CylBufPos;
-sphere g_SphBuf[2];
-int g_SphBufPos;
-box g_BoxBuf[2];
-int g_BoxBufPos;
-
-BBox g_BBoxBuf[128];
-int g_BBoxBufPos;
-
-surface_desc g_SurfaceDescBuf[64];
-int g_SurfaceDescBufPos;
-
-edge_desc g_EdgeDescBuf[64];
-int g_EdgeDescBufPos;
-
-int g_iFeatureBuf[64];
-int g_iFeatureBufPos;
-
-short g_IdBuf[256];
-int g_IdBufPos;
-
-int g_UsedNodesMap[8192];
-int g_UsedNodesMapPos;
-int g_UsedNodesIdx[64];
-int g_UsedNodesIdxPos;
-
-geom_contact g_Contacts[64];
-int g_nTotContacts;
-geom_contact_area g_AreaBuf[32];
-int g_nAreas;
-vectorf g_AreaPtBuf[256];
-int g_AreaPrimBuf0[256],g_AreaFeatureBuf0[256],g_AreaPrimBuf1[256],g_AreaFeatureBuf1[256];
-int g_nAreaPt;
-extern vectorf g_BrdPtBuf[2048]; // from trimesh.cpp
-extern int g_BrdPtBufPos;				 // 
-
-struct InitGeometryGlobals {
-	InitGeometryGlobals() {
-		memset(g_UsedNodesMap, 0, sizeof(g_UsedNodesMap));
-		g_EdgeDescBufPos = 0;	g_IdBufPos = 0;	g_IdxTriBufPos = 0;
-		g_SurfaceDescBufPos = 0; g_UsedNodesMapPos = 0;	g_UsedNodesIdxPos = 0;
-		g_iFeatureBufPos = 0;
-		g_nAreas = 0;	g_nAreaPt = 0; g_nTotContacts = 0;
-	}
-};
-static InitGeometryGlobals now;
-
 #include "raybv.h"
 #include "raygeom.h"
+#include "geomscratch.h"
+
 
 int IntersectBVs(geometry_under_test *pGTest, BV *pBV1,BV *pBV2) 
 {
@@ -111,13 +61,12 @@ int IntersectBVs(geometry_under_test *pGTest, BV *pBV1,BV *pBV2)
 		int nPrims1,nPrims2,iClient,i,j;
 		primitive *ptr[2];
 		prim_inters inters;
-		static vectorf ptborder[16];
 		inters.minPtDist2 = sqr(min(pGTest[0].pGeometry->m_minVtxDist, pGTest[1].pGeometry->m_minVtxDist));
 		iClient = -(pGTest[1].pGeometry->m_iCollPriority-pGTest[0].pGeometry->m_iCollPriority>>31);
 		inters.pt[1].Set(0,0,0);
-		inters.ptborder = ptborder;
+		inters.ptborder = g_IntersBorderBuf;
 		inters.nborderpt = inters.nBestPtVal = 0;
-		inters.nbordersz = sizeof(ptborder)/sizeof(ptborder[0]);
+		inters.nbordersz = sizeof(g_IntersBorderBuf)/sizeof(g_IntersBorderBuf[0]);
 
 		nPrims1 = pGTest[0].pBVtree->GetNodeContents(pBV1->iNode, pBV2,bNodeUsed[1],1, pGTest+0,pGTest+1);
 		nPrims2 = pGTest[1].pBVtree->GetNodeContents(pBV2->iNode, pBV1,bNodeUsed[0],0, pGTest+1,pGTest+0);
@@ -135,7 +84,7 @@ int IntersectBVs(geometry_under_test *pGTest, BV *pBV1,BV *pBV2)
 			if (pGTest[0].bStopIntersection+pGTest[1].bStopIntersection + pGTest[0].bCurNodeUsed+pGTest[1].bCurNodeUsed> 0)
 				return res;
 			inters.nborderpt = inters.nBestPtVal = 0;
-			inters.nbordersz = sizeof(ptborder)/sizeof(ptborder[0]);
+			inters.nbordersz = sizeof(g_IntersBorderBuf)/sizeof(g_IntersBorderBuf[0]);
 		}
 	}
 
@@ -3,32 +3,6 @@
 #pragma once
 
 
-extern surface_desc g_SurfaceDescBuf[64];
-extern int g_SurfaceDescBufPos;
-
-extern edge_desc g_EdgeDescBuf[64];
-extern int g_EdgeDescBufPos;
-
-extern int g_iFeatureBuf[64];
-extern int g_iFeatureBufPos;
-
-extern short g_IdBuf[256];
-extern int g_IdBufPos;
-
-extern int g_UsedNodesMap[8192];
-extern int g_UsedNodesMapPos;
-extern int g_UsedNodesIdx[64];
-extern int g_UsedNodesIdxPos;
-
-extern geom_contact g_Contacts[64];
-extern int g_nTotContacts;
-
-extern geom_contact_area g_AreaBuf[32];
-extern int g_nAreas;
-extern vectorf g_AreaPtBuf[256];
-extern int g_AreaPrimBuf0[256],g_AreaFeatureBuf0[256],g_AreaPrimBuf1[256],g_AreaFeatureBuf1[256];
-extern int g_nAreaPt;
-
 class CGeometry : public IGeometry {
 public:
 	CGeometry() { m_bIsConvex=0; }
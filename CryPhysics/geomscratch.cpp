@@ -0,0 +1,37 @@
+#include "stdafx.h"
+
+#include "utils.h"
+#include "primitives.h"
+#include "overlapchecks.h"
+#include "bvtree.h"
+#include "geometry.h"
+#include "geomscratch.h"
+
+#if defined(LINUX)
+static pthread_key_t CreateGeomScratchKey() { pthread_key_t key; pthread_key_create(&key,0); return key; }
+pthread_key_t g_GeomScratchKey = CreateGeomScratchKey();
+#else
+DWORD g_iGeomScratchTls = TlsAlloc();
+#endif
+geom_scratch g_GeomScratch;
+
+geom_scratch::geom_scratch()
+{
+	memset(UsedNodesMap, 0, sizeof(UsedNodesMap));
+	memset(UsedVtxMap, 0, sizeof(UsedVtxMap));
+	memset(UsedTriMap, 0, sizeof(UsedTriMap));
+	IdxTriBufPos = CylBufPos = SphBufPos = BoxBufPos = BBoxBufPos = 0;
+	SurfaceDescBufPos = EdgeDescBufPos = iFeatureBufPos = IdBufPos = UsedNodesMapPos = UsedNodesIdxPos = 0;
+	nTotContacts = nAreas = nAreaPt = 0;
+	BrdPtBufPos = BrdPtBufStart = PolyPtBufPos = 0;
+	Overlapper.Init();
+}
+
+void SetGeomScratch(geom_scratch *pgs)
+{
+#if defined(LINUX)
+	pthread_setspecific(g_GeomScratchKey, pgs);
+#else
+	TlsSetValue(g_iGeomScratchTls, pgs);
+#endif
+}
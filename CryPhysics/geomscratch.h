@@ -0,0 +1,169 @@
+#ifndef geomscratch_h
+#define geomscratch_h
+#pragma once
+
+// temporary buffers of geometry intersection tests. The thread that steps the world uses g_GeomScratch;
+// threads that run intersection tests at the same time (ray batch lanes) install their own instance
+// with SetGeomScratch, so the code below keeps using the old global names
+
+struct tritem {
+	int itri;
+	int itri_parent;
+	int ivtx0;
+};
+struct vtxitem {
+	int ivtx;
+	int id;
+	int ibuddy[2];
+};
+
+struct geom_scratch {
+	geom_scratch();
+
+	// primitives and bounding volumes (bvtree.h)
+	indexed_triangle IdxTriBuf[256];
+	int IdxTriBufPos;
+	cylinder CylBuf[2];
+	int CylBufPos;
+	sphere SphBuf[2];
+	int SphBufPos;
+	box BoxBuf[2];
+	int BoxBufPos;
+	BBox BBoxBuf[128];
+	int BBoxBufPos;
+	BVray RayBV;
+
+	// features, node maps and contacts (geometry.h)
+	surface_desc SurfaceDescBuf[64];
+	int SurfaceDescBufPos;
+	edge_desc EdgeDescBuf[64];
+	int EdgeDescBufPos;
+	int iFeatureBuf[64];
+	int iFeatureBufPos;
+	short IdBuf[256];
+	int IdBufPos;
+	int UsedNodesMap[8192];
+	int UsedNodesMapPos;
+	int UsedNodesIdx[64];
+	int UsedNodesIdxPos;
+	geom_contact Contacts[64];
+	int nTotContacts;
+	geom_contact_area AreaBuf[32];
+	int nAreas;
+	vectorf AreaPtBuf[256];
+	int AreaPrimBuf0[256],AreaFeatureBuf0[256],AreaPrimBuf1[256],AreaFeatureBuf1[256];
+	int nAreaPt;
+	vectorf IntersBorderBuf[16];
+	COverlapChecker Overlapper; // caches the box-box basis between checks
+
+	// primitive geometries
+	short BoxIdBuf[3];
+	surface_desc BoxSurfaceBuf[3];
+	edge_desc BoxEdgeBuf[3];
+	short CylIdBuf[1];
+	surface_desc CylSurfaceBuf[1];
+	edge_desc CylEdgeBuf[1];
+	short SphIdBuf[1];
+
+	// triangle meshes (contact borders and polygons)
+	vectorf BrdPtBuf[2048];
+	int BrdPtBufPos,BrdPtBufStart;
+	int BrdiTriBuf[2048][2];
+	float BrdSeglenBuf[2048];
+	int UsedVtxMap[4096];
+	int UsedTriMap[4096];
+	vector2df PolyPtBuf[1024];
+	int PolyVtxIdBuf[1024];
+	int PolyEdgeIdBuf[1024];
+	int PolyPtBufPos;
+	tritem TriQueue[512];
+	vtxitem VtxList[512];
+};
+
+extern geom_scratch g_GeomScratch;
+#if defined(LINUX)
+extern pthread_key_t g_GeomScratchKey;
+inline geom_scratch *GetGeomScratch() {
+	geom_scratch *pgs = (geom_scratch*)pthread_getspecific(g_GeomScratchKey);
+	return pgs ? pgs : &g_GeomScratch;
+}
+#else
+extern DWORD g_iGeomScratchTls;
+inline geom_scratch *GetGeomScratch() {
+	geom_scratch *pgs = (geom_scratch*)TlsGetValue(g_iGeomScratchTls);
+	return pgs ? pgs : &g_GeomScratch;
+}
+#endif
+// pass 0 to switch the calling thread back to g_GeomScratch
+void SetGeomScratch(geom_scratch *pgs);
+
+#define g_IdxTriBuf				(GetGeomScratch()->IdxTriBuf)
+#define g_IdxTriBufPos		(GetGeomScratch()->IdxTriBufPos)
+#define g_CylBuf					(GetGeomScratch()->CylBuf)
+#define g_CylBufPos				(GetGeomScratch()->CylBufPos)
+#define g_SphBuf					(GetGeomScratch()->SphBuf)
+#define g_SphBufPos				(GetGeomScratch()->SphBufPos)
+#define g_BoxBuf					(GetGeomScratch()->BoxBuf)
+#define g_BoxBufPos				(GetGeomScratch()->BoxBufPos)
+#define g_BBoxBuf					(GetGeomScratch()->BBoxBuf)
+#define g_BBoxBufPos			(GetGeomScratch()->BBoxBufPos)
+#define g_BVray						(GetGeomScratch()->RayBV)
+
+#define g_SurfaceDescBuf		(GetGeomScratch()->SurfaceDescBuf)
+#define g_SurfaceDescBufPos	(GetGeomScratch()->SurfaceDescBufPos)
+#define g_EdgeDescBuf				(GetGeomScratch()->EdgeDescBuf)
+#define g_EdgeDescBufPos		(GetGeomScratch()->EdgeDescBufPos)
+#define g_iFeatureBuf				(GetGeomScratch()->iFeatureBuf)
+#define g_iFeatureBufPos		(GetGeomScratch()->iFeatureBufPos)
+#define g_IdBuf							(GetGeomScratch()->IdBuf)
+#define g_IdBufPos					(GetGeomScratch()->IdBufPos)
+#define g_UsedNodesMap			(GetGeomScratch()->UsedNodesMap)
+#define g_UsedNodesMapPos		(GetGeomScratch()->UsedNodesMapPos)
+#define g_UsedNodesIdx			(GetGeomScratch()->UsedNodesIdx)
+#define g_UsedNodesIdxPos		(GetGeomScratch()->UsedNodesIdxPos)
+#define g_Contacts					(GetGeomScratch()->Contacts)
+#define g_nTotContacts			(GetGeomScratch()->nTotContacts)
+#define g_AreaBuf						(GetGeomScratch()->AreaBuf)
+#define g_nAreas						(GetGeomScratch()->nAreas)
+#define g_AreaPtBuf					(GetGeomScratch()->AreaPtBuf)
+#define g_AreaPrimBuf0			(GetGeomScratch()->AreaPrimBuf0)
+#define g_AreaFeatureBuf0		(GetGeomScratch()->AreaFeatureBuf0)
+#define g_AreaPrimBuf1			(GetGeomScratch()->AreaPrimBuf1)
+#define g_AreaFeatureBuf1		(GetGeomScratch()->AreaFeatureBuf1)
+#define g_nAreaPt						(GetGeomScratch()->nAreaPt)
+#define g_IntersBorderBuf		(GetGeomScratch()->IntersBorderBuf)
+#define g_Overlapper				(GetGeomScratch()->Overlapper)
+
+#define g_BoxIdBuf					(GetGeomScratch()->BoxIdBuf)
+#define g_BoxSurfaceBuf			(GetGeomScratch()->BoxSurfaceBuf)
+#define g_BoxEdgeBuf				(GetGeomScratch()->BoxEdgeBuf)
+#define g_CylIdBuf					(GetGeomScratch()->CylIdBuf)
+#define g_CylSurfaceBuf			(GetGeomScratch()->CylSurfaceBuf)
+#define g_CylEdgeBuf				(GetGeomScratch()->CylEdgeBuf)
+#define g_SphIdBuf					(GetGeomScratch()->SphIdBuf)
+
+#define g_BrdPtBuf					(GetGeomScratch()->BrdPtBuf)
+#define g_BrdPtBufPos				(GetGeomScratch()->BrdPtBufPos)
+#define g_BrdPtBufStart			(GetGeomScratch()->BrdPtBufStart)
+#define g_BrdiTriBuf				(GetGeomScratch()->BrdiTriBuf)
+#define g_BrdSeglenBuf			(GetGeomScratch()->BrdSeglenBuf)
+#define g_UsedVtxMap				(GetGeomScratch()->UsedVtxMap)
+#define g_UsedTriMap				(GetGeomScratch()->UsedTriMap)
+#define g_PolyPtBuf					(GetGeomScratch()->PolyPtBuf)
+#define g_PolyVtxIdBuf			(GetGeomScratch()->PolyVtxIdBuf)
+#define g_PolyEdgeIdBuf			(GetGeomScratch()->PolyEdgeIdBuf)
+#define g_PolyPtBufPos			(GetGeomScratch()->PolyPtBufPos)
+#define g_TriQueue					(GetGeomScratch()->TriQueue)
+#define g_VtxList						(GetGeomScratch()->VtxList)
+
+inline void ResetGlobalPrimsBuffers()
+{
+	geom_scratch *pgs = GetGeomScratch();
+	pgs->BBoxBufPos = 0;
+	pgs->IdxTriBufPos = 0;
+	pgs->CylBufPos = 0;
+	pgs->BoxBufPos = 0;
+	pgs->SphBufPos = 0;
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include "raygeom.h"
 #include "heightfieldbv.h"
 #include "heightfieldgeom.h"
+#include "geomscratch.h"
 
 CHeightfield* CHeightfield::CreateHeightfield(heightfield *phf)
 {
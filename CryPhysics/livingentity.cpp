@@ -1649,7 +1649,7 @@ float CLivingEntity::CalcEnergy(float time_interval)
 	return E; 
 }
 
-int CLivingEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
+int CLivingEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc)
 {
 	int i,j;
 	vectorf pt[2];
@@ -1666,7 +1666,7 @@ int CLivingEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
 		} 
 
 		for(j=0;j<2;j++) {
-			if (!(pcontact=(entity_contact*)AllocSolverTmpBuf(sizeof(entity_contact)))) 
+			if (!(pcontact=(entity_contact*)AllocSolverTmpBuf(psc,sizeof(entity_contact)))) 
 				return 0;
 			pcontact->flags = 0;
 			pcontact->pent[0] = m_pContacts[i].pent;
@@ -1681,7 +1681,7 @@ int CLivingEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
 			pcontact->n = m_pContacts[i].n;
 			pcontact->K.SetZero();
 			m_pContacts[i].pent->GetContactMatrix(m_pContacts[i].pt, m_pContacts[i].ipart, pcontact->K);
-			::RegisterContact(pcontact);
+			::RegisterContact(psc,pcontact);
 		}
 	}
 
@@ -1690,10 +1690,13 @@ int CLivingEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
 
 int CLivingEntity::Update(float time_interval, float damping)
 {
+	// colliders with infinite mass can belong to groups that other island lanes update
+	if (m_pWorld->m_bIslandLanes) EnterCriticalSection(&m_pWorld->m_csSolver);
 	for(int i=0;i<m_nColliders;i++) {
 		m_pColliders[i]->RemoveCollider(this);
 		m_pColliders[i]->Release();
 	}
+	if (m_pWorld->m_bIslandLanes) LeaveCriticalSection(&m_pWorld->m_csSolver);
 	m_nColliders = 0;
 	m_nContacts = 0;	
 	return 1;
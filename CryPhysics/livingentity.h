@@ -57,7 +57,7 @@ public:
 	void StepBackEx(float time_interval,bool bRollbackHistory=true);
 	virtual void StepBack(float time_interval) { StepBackEx(time_interval); }
 	virtual float CalcEnergy(float time_interval);
-	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts);
+	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc);
 	virtual int Update(float time_interval, float damping);
 	virtual int Awake(int bAwake=1,int iSource=0);
 	virtual void AlertNeighbourhoodND() { ReleaseGroundCollider(); CPhysicalEntity::AlertNeighbourhoodND(); }
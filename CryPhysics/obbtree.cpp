@@ -2,10 +2,12 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "bvtree.h"
 #include "geometry.h"
 #include "obbtree.h"
 #include "trimesh.h"
+#include "geomscratch.h"
 
 
 void COBBTree::SetParams(int nMinTrisPerNode, int nMaxTrisPerNode, float skipdim)
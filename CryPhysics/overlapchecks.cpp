@@ -3,8 +3,8 @@
 #include "utils.h"
 #include "primitives.h"
 #include "overlapchecks.h"
-
-COverlapChecker g_Overlapper;
+#include "bvtree.h"
+#include "geomscratch.h"
 
 COverlapChecker::COverlapChecker() 
 {
@@ -35,9 +35,10 @@ int default_overlap_check(const primitive*, const primitive *)
 int box_box_overlap_check(const box *box1, const box *box2)
 {
 	int i;
-	matrix3x3RMf &Basis21((matrix3x3RMf&)*(matrix3x3RMf*)g_Overlapper.Basis21);
+	COverlapChecker &ovl = g_Overlapper;
+	matrix3x3RMf &Basis21((matrix3x3RMf&)*(matrix3x3RMf*)ovl.Basis21);
 
-	if ((box1->bOriented|box2->bOriented<<16)!=g_Overlapper.iPrevCode) {
+	if ((box1->bOriented|box2->bOriented<<16)!=ovl.iPrevCode) {
 		if (!box1->bOriented)
 			Basis21 = box2->Basis.T();
 		else if (box2->bOriented)
@@ -45,8 +46,8 @@ int box_box_overlap_check(const box *box1, const box *box2)
 		else
 			Basis21 = box1->Basis;
 		for(i=0;i<9;i++) 
-			g_Overlapper.Basis21abs[i] = fabsf(g_Overlapper.Basis21[i]);
-		g_Overlapper.iPrevCode = box1->bOriented|box2->bOriented<<16;
+			ovl.Basis21abs[i] = fabsf(ovl.Basis21[i]);
+		ovl.iPrevCode = box1->bOriented|box2->bOriented<<16;
 	}
 
 	vectorf center21 = box2->center-box1->center;
@@ -56,84 +57,84 @@ int box_box_overlap_check(const box *box1, const box *box2)
 	float t1,t2,t3,e=(a.x+a.y+a.z)*1e-4f;
 
 	// node1 basis vectors
-	if (fabsf(center21.x) > a.x+b*vectorf(g_Overlapper.Basis21abs+0))
+	if (fabsf(center21.x) > a.x+b*vectorf(ovl.Basis21abs+0))
 		return 0;
-	if (fabsf(center21.y) > a.y+b*vectorf(g_Overlapper.Basis21abs+3))
+	if (fabsf(center21.y) > a.y+b*vectorf(ovl.Basis21abs+3))
 		return 0;
-	if (fabsf(center21.z) > a.z+b*vectorf(g_Overlapper.Basis21abs+6))
+	if (fabsf(center21.z) > a.z+b*vectorf(ovl.Basis21abs+6))
 		return 0;
 
 	// node2 basis vectors
-	if (fabsf(center21.x*g_Overlapper.Basis21[0]+center21.y*g_Overlapper.Basis21[3]+center21.z*g_Overlapper.Basis21[6]) > 
-			a.x*g_Overlapper.Basis21abs[0]+a.y*g_Overlapper.Basis21abs[3]+a.z*g_Overlapper.Basis21abs[6]+b.x)
+	if (fabsf(center21.x*ovl.Basis21[0]+center21.y*ovl.Basis21[3]+center21.z*ovl.Basis21[6]) > 
+			a.x*ovl.Basis21abs[0]+a.y*ovl.Basis21abs[3]+a.z*ovl.Basis21abs[6]+b.x)
 		return 0;
-	if (fabsf(center21.x*g_Overlapper.Basis21[1]+center21.y*g_Overlapper.Basis21[4]+center21.z*g_Overlapper.Basis21[7]) > 
-			a.x*g_Overlapper.Basis21abs[1]+a.y*g_Overlapper.Basis21abs[4]+a.z*g_Overlapper.Basis21abs[7]+b.y)
+	if (fabsf(center21.x*ovl.Basis21[1]+center21.y*ovl.Basis21[4]+center21.z*ovl.Basis21[7]) > 
+			a.x*ovl.Basis21abs[1]+a.y*ovl.Basis21abs[4]+a.z*ovl.Basis21abs[7]+b.y)
 		return 0;
-	if (fabsf(center21.x*g_Overlapper.Basis21[2]+center21.y*g_Overlapper.Basis21[5]+center21.z*g_Overlapper.Basis21[8]) > 
-			a.x*g_Overlapper.Basis21abs[2]+a.y*g_Overlapper.Basis21abs[5]+a.z*g_Overlapper.Basis21abs[8]+b.z)
+	if (fabsf(center21.x*ovl.Basis21[2]+center21.y*ovl.Basis21[5]+center21.z*ovl.Basis21[8]) > 
+			a.x*ovl.Basis21abs[2]+a.y*ovl.Basis21abs[5]+a.z*ovl.Basis21abs[8]+b.z)
 		return 0;
 
 	// node1->axes[0] x node2->axes[0]
-	t1 = a.y*g_Overlapper.Basis21abs[6] + a.z*g_Overlapper.Basis21abs[3];
-	t2 = b.y*g_Overlapper.Basis21abs[2] + b.z*g_Overlapper.Basis21abs[1];
-	t3 = center21.z*g_Overlapper.Basis21[3] - center21.y*g_Overlapper.Basis21[6];
+	t1 = a.y*ovl.Basis21abs[6] + a.z*ovl.Basis21abs[3];
+	t2 = b.y*ovl.Basis21abs[2] + b.z*ovl.Basis21abs[1];
+	t3 = center21.z*ovl.Basis21[3] - center21.y*ovl.Basis21[6];
 	if (fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[0] x node2->axes[1]
-	t1 = a.y*g_Overlapper.Basis21abs[7] + a.z*g_Overlapper.Basis21abs[4];
-	t2 = b.x*g_Overlapper.Basis21abs[2] + b.z*g_Overlapper.Basis21abs[0];
-	t3 = center21.z*g_Overlapper.Basis21[4] - center21.y*g_Overlapper.Basis21[7];;
+	t1 = a.y*ovl.Basis21abs[7] + a.z*ovl.Basis21abs[4];
+	t2 = b.x*ovl.Basis21abs[2] + b.z*ovl.Basis21abs[0];
+	t3 = center21.z*ovl.Basis21[4] - center21.y*ovl.Basis21[7];;
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[0] x node2->axes[2]
-	t1 = a.y*g_Overlapper.Basis21abs[8] + a.z*g_Overlapper.Basis21abs[5];
-	t2 = b.x*g_Overlapper.Basis21abs[1] + b.y*g_Overlapper.Basis21abs[0];
-	t3 = center21.z*g_Overlapper.Basis21[5] - center21.y*g_Overlapper.Basis21[8];
+	t1 = a.y*ovl.Basis21abs[8] + a.z*ovl.Basis21abs[5];
+	t2 = b.x*ovl.Basis21abs[1] + b.y*ovl.Basis21abs[0];
+	t3 = center21.z*ovl.Basis21[5] - center21.y*ovl.Basis21[8];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[1] x node2->axes[0]
-	t1 = a.x*g_Overlapper.Basis21abs[6] + a.z*g_Overlapper.Basis21abs[0];
-	t2 = b.y*g_Overlapper.Basis21abs[5] + b.z*g_Overlapper.Basis21abs[4];
-	t3 = center21.x*g_Overlapper.Basis21[6] - center21.z*g_Overlapper.Basis21[0];
+	t1 = a.x*ovl.Basis21abs[6] + a.z*ovl.Basis21abs[0];
+	t2 = b.y*ovl.Basis21abs[5] + b.z*ovl.Basis21abs[4];
+	t3 = center21.x*ovl.Basis21[6] - center21.z*ovl.Basis21[0];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[1] x node2->axes[1]
-	t1 = a.x*g_Overlapper.Basis21abs[7] + a.z*g_Overlapper.Basis21abs[1];
-	t2 = b.x*g_Overlapper.Basis21abs[5] + b.z*g_Overlapper.Basis21abs[3];
-	t3 = center21.x*g_Overlapper.Basis21[7] - center21.z*g_Overlapper.Basis21[1];
+	t1 = a.x*ovl.Basis21abs[7] + a.z*ovl.Basis21abs[1];
+	t2 = b.x*ovl.Basis21abs[5] + b.z*ovl.Basis21abs[3];
+	t3 = center21.x*ovl.Basis21[7] - center21.z*ovl.Basis21[1];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[1] x node2->axes[2]
-	t1 = a.x*g_Overlapper.Basis21abs[8] + a.z*g_Overlapper.Basis21abs[2];
-	t2 = b.x*g_Overlapper.Basis21abs[4] + b.y*g_Overlapper.Basis21abs[3];
-	t3 = center21.x*g_Overlapper.Basis21[8] - center21.z*g_Overlapper.Basis21[2];
+	t1 = a.x*ovl.Basis21abs[8] + a.z*ovl.Basis21abs[2];
+	t2 = b.x*ovl.Basis21abs[4] + b.y*ovl.Basis21abs[3];
+	t3 = center21.x*ovl.Basis21[8] - center21.z*ovl.Basis21[2];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[2] x node2->axes[0]
-	t1 = a.x*g_Overlapper.Basis21abs[3] + a.y*g_Overlapper.Basis21abs[0];
-	t2 = b.y*g_Overlapper.Basis21abs[8] + b.z*g_Overlapper.Basis21abs[7];
-	t3 = center21.y*g_Overlapper.Basis21[0] - center21.x*g_Overlapper.Basis21[3];
+	t1 = a.x*ovl.Basis21abs[3] + a.y*ovl.Basis21abs[0];
+	t2 = b.y*ovl.Basis21abs[8] + b.z*ovl.Basis21abs[7];
+	t3 = center21.y*ovl.Basis21[0] - center21.x*ovl.Basis21[3];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 	
 	// node1->axes[2] x node2->axes[1]
-	t1 = a.x*g_Overlapper.Basis21abs[4] + a.y*g_Overlapper.Basis21abs[1];
-	t2 = b.x*g_Overlapper.Basis21abs[8] + b.z*g_Overlapper.Basis21abs[6];
-	t3 = center21.y*g_Overlapper.Basis21[1] - center21.x*g_Overlapper.Basis21[4];
+	t1 = a.x*ovl.Basis21abs[4] + a.y*ovl.Basis21abs[1];
+	t2 = b.x*ovl.Basis21abs[8] + b.z*ovl.Basis21abs[6];
+	t3 = center21.y*ovl.Basis21[1] - center21.x*ovl.Basis21[4];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
 	// node1->axes[2] x node2->axes[2]
-	t1 = a.x*g_Overlapper.Basis21abs[5] + a.y*g_Overlapper.Basis21abs[2];
-	t2 = b.x*g_Overlapper.Basis21abs[7] + b.y*g_Overlapper.Basis21abs[6];
-	t3 = center21.y*g_Overlapper.Basis21[2] - center21.x*g_Overlapper.Basis21[5];
+	t1 = a.x*ovl.Basis21abs[5] + a.y*ovl.Basis21abs[2];
+	t2 = b.x*ovl.Basis21abs[7] + b.y*ovl.Basis21abs[6];
+	t3 = center21.y*ovl.Basis21[2] - center21.x*ovl.Basis21[5];
 	if(fabsf(t3) > t1+t2+e)
 		return 0;
 
@@ -37,6 +37,5 @@ public:
 	float Basis21[9];
 	float Basis21abs[9];
 };
-extern COverlapChecker g_Overlapper;
 
 #endif
\ No newline at end of file
@@ -62,7 +62,7 @@ public:
 	virtual int Step(float time_interval) { return 1; }
 	virtual void StepBack(float time_interval) {} 
 	virtual int GetContactCount(int nMaxPlaneContacts) { return 0; }
-	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts) { return 0; }
+	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc) { return 0; }
 	virtual int Update(float time_interval, float damping) { return 1; }
 	virtual float CalcEnergy(float time_interval) { return 0; }
 	virtual float GetDamping(float time_interval) { return 1.0f; } 
@@ -15,6 +15,7 @@
 #include "bvtree.h"
 #include "geometry.h"
 #include "overlapchecks.h"
+#include "geomscratch.h"
 #include "raybv.h"
 #include "raygeom.h"
 #include "geoman.h"
@@ -32,6 +33,10 @@
 #include "ropeentity.h"
 #include "softentity.h"
 #include "physicalworld.h"
+#include <IJobManager.h>
+#include <ITimer.h>
+
+float frand(float range);
 
 
 CPhysicalWorld *g_pPhysWorlds[64];
@@ -47,12 +52,18 @@ CPhysicalWorld::CPhysicalWorld(ILog *pLog)
 	m_pEntBeingDeleted = 0;
 	m_bGridThunksChanged = 0;
 	m_bUpdateOnlyFlagged = 0;
+	InitializeCriticalSection(&m_csSolver);
+	for(int i=0;i<MAX_ISLAND_WORKERS;i++) m_pSolvers[i] = 0;
+	m_bIslandLanes = 0;
 }
 
 CPhysicalWorld::~CPhysicalWorld()
 {
 	Shutdown();
 	int i;
+	for(i=0;i<MAX_ISLAND_WORKERS;i++) if (m_pSolvers[i])
+		delete m_pSolvers[i];
+	DeleteCriticalSection(&m_csSolver);
 	for(i=0; i<g_nPhysWorlds && g_pPhysWorlds[i]!=this; i++);
 	if (i<g_nPhysWorlds)
 		g_nPhysWorlds--;
@@ -63,7 +74,7 @@ CPhysicalWorld::~CPhysicalWorld()
 void CPhysicalWorld::Init()
 {
 	InitGeoman();
-	m_pTmpEntList=0; m_pTmpEntList1=0; m_pGroupMass=0; m_pMassList = 0; m_pGroupIds = 0; m_pGroupNums = 0;
+	m_pTmpEntList=0; m_pTmpEntList1=0; m_pGroupMass=0; m_pMassList = 0; m_pGroupIds = 0; m_pGroupNums = 0; m_pIslands = 0;
 	m_nEnts = 0; m_nEntsAlloc = 0;
 	m_pEntGrid = 0;
 	m_timePhysics = m_timeSurplus = 0;
@@ -132,6 +143,10 @@ void CPhysicalWorld::Init()
 	m_vars.penaltyScale = 0.3f;
 	m_vars.maxContactGapSimple = 0.03f;
 	m_vars.bLimitSimpleSolverEnergy = 1;
+	m_vars.nIslandWorkers = 0;
+	m_vars.bLogStepChecksums = 0;
+	m_vars.nRayBatchWorkers = 0;
+	m_vars.nBenchmarkRays = 0;
 	m_iNextId = 1;
 	m_pEntsById = 0;
 	m_nIdsAlloc = 0;
@@ -173,6 +188,7 @@ void CPhysicalWorld::Shutdown(int bDeleteGeometries)
 	if (m_pMassList) delete[] m_pMassList; m_pMassList = 0;
 	if (m_pGroupIds) delete[] m_pGroupIds; m_pGroupIds = 0;
 	if (m_pGroupNums) delete[] m_pGroupNums; m_pGroupNums = 0;
+	if (m_pIslands) delete[] m_pIslands; m_pIslands = 0;
 	if (m_pEntsById) delete[] m_pEntsById; m_pEntsById = 0;
 	if (m_nOccRes) for(i=0;i<6;i++) {
 		delete[] m_pGridStat[i]; delete[] m_pGridDyn[i];
@@ -338,6 +354,7 @@ IPhysicalEntity* CPhysicalWorld::CreatePhysicalEntity(pe_type type, float lifeTi
 			ReallocateList(m_pMassList,m_nEnts-1,m_nEntsAlloc);
 			ReallocateList(m_pGroupIds,m_nEnts-1,m_nEntsAlloc);
 			ReallocateList(m_pGroupNums,m_nEnts-1,m_nEntsAlloc);
+			ReallocateList(m_pIslands,m_nEnts-1,m_nEntsAlloc);
 		}
 	}
 
@@ -498,6 +515,7 @@ DEBUG_BREAK;
 			ReallocateList(m_pMassList,0,m_nEntsAlloc-512);
 			ReallocateList(m_pGroupIds,0,m_nEntsAlloc-512);
 			ReallocateList(m_pGroupNums,0,m_nEntsAlloc-512);
+			ReallocateList(m_pIslands,0,m_nEntsAlloc-512);
 			m_nEntsAlloc -= 512;
 		}
 	} else if (pent->m_iSimClass>=0) {
@@ -731,9 +749,9 @@ void CPhysicalWorld::TimeStep(float time_interval, int flags)
 {
 	FUNCTION_PROFILER( GetISystem(),PROFILE_PHYSICS );
 
-	float m,max_time_step,time_interval_org = time_interval, Ebefore,Eafter,damping;
+	float m,max_time_step,time_interval_org = time_interval;
 	CPhysicalEntity *pent,*phead,*ptail,**pentlist,*pent_next,*pent1,*pentmax;
-	int i,j,n,iter,ipass,nGroups,bHeadAdded,bGroupFinished,bAllGroupsFinished,bStepValid,nAnimatedObjects,nEnts,bSkipFlagged;
+	int i,j,n,iter,ipass,nGroups,bHeadAdded,bAllGroupsFinished,bStepValid,nAnimatedObjects,bSkipFlagged,bParallelIslands;
 
 	if (time_interval<0)
 		return;
@@ -772,6 +790,7 @@ void CPhysicalWorld::TimeStep(float time_interval, int flags)
 				bAllGroupsFinished = 1;
 				m_pGroupNums[m_nEntsAlloc-1] = -1; // special group for rigid bodies w/ infinite mass
 				m_iSubstep++;
+				bParallelIslands = isneg(1-m_vars.nIslandWorkers);
 
 				for(ipass=0; ipass<2; ipass++) {
 					// build lists of intercolliding groups of entities
@@ -872,50 +891,26 @@ void CPhysicalWorld::TimeStep(float time_interval, int flags)
 							}
 							for(pent=m_pTmpEntList1[i]; pent; pent=pent->m_next_coll) pent->m_bMoved = 0;
 						} else {
-							InitContactSolver(max_time_step);
-							Ebefore = Eafter = 0.0f; 
-
-							if (m_vars.nMaxPlaneContactsDistress!=m_vars.nMaxPlaneContacts) {
-								for(pent=m_pTmpEntList1[i],j=nEnts=0; pent; pent=pent->m_next_coll,nEnts++)	{
-									j += pent->GetContactCount(m_vars.nMaxPlaneContacts);
-									Ebefore += pent->CalcEnergy(max_time_step);
-								}
-								n = j>m_vars.nMaxContacts ? m_vars.nMaxPlaneContactsDistress : m_vars.nMaxPlaneContacts;
-								for(pent=m_pTmpEntList1[i]; pent; pent=pent->m_next_coll)
-									pent->RegisterContacts(max_time_step,n);
-							} else for(pent=m_pTmpEntList1[i],nEnts=0; pent; pent=pent->m_next_coll,nEnts++) {
-								pent->RegisterContacts(max_time_step, m_vars.nMaxPlaneContacts);
-								Ebefore += pent->CalcEnergy(max_time_step);
+							m_pIslands[i].time_interval = max_time_step;
+							m_pIslands[i].nAnimatedObjects = nAnimatedObjects;
+							if (!bParallelIslands) {
+								SolveIsland(i,GetSolverContext(0));
+								bAllGroupsFinished &= UpdateIsland(i);
 							}
-
-							Ebefore = max(m_pGroupMass[i]*sqr(0.005f),Ebefore);
-							
-							InvokeContactSolver(max_time_step, &m_vars);
-
-							//if (nAnimatedObjects==0) 
-							damping = 1.0f-max_time_step*m_vars.groupDamping*isneg(m_vars.nGroupDamping-1-max(nEnts,g_nBodies));
-							for(pent=m_pTmpEntList1[i],bGroupFinished=1; pent; pent=pent->m_next_coll) {
-								Eafter += pent->CalcEnergy(0);	
-								if (!(pent->m_flags & pef_fixed_damping))
-									damping = min(damping,pent->GetDamping(max_time_step));
-								else {
-									damping = pent->GetDamping(max_time_step);
-									break;
-								}
-							}
-							Ebefore *= isneg(-nAnimatedObjects)+1; // increase energy growth limit if we have animated bodies involved
-							if (Eafter>Ebefore*(1.0f+0.1f*isneg(g_nBodies-15)))
-								damping = min(damping, sqrt_tpl(Ebefore/Eafter));
-							for(pent=m_pTmpEntList1[i],bGroupFinished=1; pent; pent=pent->m_next_coll)
-								bGroupFinished &= pent->Update(max_time_step, damping);
-							for(pent=m_pTmpEntList1[i]; pent; pent=pent->m_next_coll)
-								pent->m_bMoved = bGroupFinished;
-							bAllGroupsFinished &= bGroupFinished;
 						}
 					}
+
+					if (ipass==1 && bParallelIslands) {
+						// each lane solves and updates its groups the same way the serial loop does; the grid and entity list 
+						// changes of the updates are applied afterwards in group order, so the result is bit-identical to p_island_workers 0
+						bAllGroupsFinished &= StepIslandsParallel(nGroups);
+					}
 				}
 			} while (!bAllGroupsFinished && ++iter<m_vars.nMaxSubsteps);
 
+			if (m_vars.bLogStepChecksums)
+				LogStepChecksum();
+
 			for(pent=m_pTypedEnts[1]; pent; pent=pent->m_next) {
 				pent->m_bMoved=0; pent->m_iGroup=-1;
 			}
@@ -978,6 +973,194 @@ void CPhysicalWorld::TimeStep(float time_interval, int flags)
 }
 
 
+SolverContext *CPhysicalWorld::GetSolverContext(int iLane)
+{
+	if (!m_pSolvers[iLane])
+		m_pSolvers[iLane] = new SolverContext(&m_csSolver);
+	return m_pSolvers[iLane];
+}
+
+void CPhysicalWorld::SolveIsland(int iGroup, SolverContext *psc)
+{
+	CPhysicalEntity *pent;
+	int j,n,nEnts;
+	float Ebefore,Eafter,damping,time_interval=m_pIslands[iGroup].time_interval;
+
+	InitContactSolver(psc, time_interval);
+	Ebefore = Eafter = 0.0f; 
+
+	if (m_vars.nMaxPlaneContactsDistress!=m_vars.nMaxPlaneContacts) {
+		for(pent=m_pTmpEntList1[iGroup],j=nEnts=0; pent; pent=pent->m_next_coll,nEnts++)	{
+			j += pent->GetContactCount(m_vars.nMaxPlaneContacts);
+			Ebefore += pent->CalcEnergy(time_interval);
+		}
+		n = j>m_vars.nMaxContacts ? m_vars.nMaxPlaneContactsDistress : m_vars.nMaxPlaneContacts;
+		for(pent=m_pTmpEntList1[iGroup]; pent; pent=pent->m_next_coll)
+			pent->RegisterContacts(time_interval,n, psc);
+	} else for(pent=m_pTmpEntList1[iGroup],nEnts=0; pent; pent=pent->m_next_coll,nEnts++) {
+		pent->RegisterContacts(time_interval, m_vars.nMaxPlaneContacts, psc);
+		Ebefore += pent->CalcEnergy(time_interval);
+	}
+
+	Ebefore = max(m_pGroupMass[iGroup]*sqr(0.005f),Ebefore);
+	
+	InvokeContactSolver(psc, time_interval, &m_vars);
+
+	//if (nAnimatedObjects==0) 
+	damping = 1.0f-time_interval*m_vars.groupDamping*isneg(m_vars.nGroupDamping-1-max(nEnts,psc->nBodies));
+	for(pent=m_pTmpEntList1[iGroup]; pent; pent=pent->m_next_coll) {
+		Eafter += pent->CalcEnergy(0);	
+		if (!(pent->m_flags & pef_fixed_damping))
+			damping = min(damping,pent->GetDamping(time_interval));
+		else {
+			damping = pent->GetDamping(time_interval);
+			break;
+		}
+	}
+	Ebefore *= isneg(-m_pIslands[iGroup].nAnimatedObjects)+1; // increase energy growth limit if we have animated bodies involved
+	if (Eafter>Ebefore*(1.0f+0.1f*isneg(psc->nBodies-15)))
+		damping = min(damping, sqrt_tpl(Ebefore/Eafter));
+	m_pIslands[iGroup].damping = damping;
+}
+
+
+int CPhysicalWorld::UpdateIsland(int iGroup)
+{
+	CPhysicalEntity *pent;
+	int bGroupFinished;
+
+	for(pent=m_pTmpEntList1[iGroup],bGroupFinished=1; pent; pent=pent->m_next_coll)
+		bGroupFinished &= pent->Update(m_pIslands[iGroup].time_interval, m_pIslands[iGroup].damping);
+	for(pent=m_pTmpEntList1[iGroup]; pent; pent=pent->m_next_coll)
+		pent->m_bMoved = bGroupFinished;
+
+	return bGroupFinished;
+}
+
+
+struct island_lane {
+	CPhysicalWorld *pWorld;
+	int iLane,nLanes;
+	int nGroups;
+	SolverContext *psc;
+};
+
+static void StepIslandLane(void *pData)
+{
+	island_lane *plane = (island_lane*)pData;
+	CPhysicalWorld *pWorld = plane->pWorld;
+	// groups are dealt to lanes in a fixed order, so the result doesn't depend on which thread picks up which lane
+	for(int i=plane->iLane; i<plane->nGroups; i+=plane->nLanes) {
+		pWorld->SolveIsland(i, plane->psc);
+		pWorld->m_pIslands[i].bFinished = pWorld->UpdateIsland(i);
+	}
+}
+
+int CPhysicalWorld::StepIslandsParallel(int nGroups)
+{
+	FUNCTION_PROFILER( GetISystem(),PROFILE_PHYSICS );
+
+	island_lane lanes[MAX_ISLAND_WORKERS];
+	IJobManager *pJobManager = GetISystem() ? GetISystem()->GetIJobManager() : 0;
+	int i,bAllGroupsFinished,nLanes = max(1,min(min(m_vars.nIslandWorkers,MAX_ISLAND_WORKERS),nGroups));
+
+	for(i=0;i<nLanes;i++) {
+		lanes[i].pWorld = this;
+		lanes[i].iLane = i; lanes[i].nLanes = nLanes;
+		lanes[i].nGroups = nGroups;
+		lanes[i].psc = GetSolverContext(i);
+		m_repositionQueues[i].nReqs = 0;
+	}
+	for(i=0;i<nGroups;i++)
+		m_pIslands[i].iLane = i%nLanes;
+
+	m_bIslandLanes = 1;
+	if (!pJobManager) 
+		for(i=0;i<nLanes;i++) StepIslandLane(lanes+i);
+	else {
+		JobCounter lanesDone;
+		for(i=1;i<nLanes;i++)
+			pJobManager->AddJob(StepIslandLane, lanes+i, &lanesDone);
+		StepIslandLane(lanes); // the calling thread takes the first lane
+		pJobManager->WaitForJobs(&lanesDone);
+	}
+	m_bIslandLanes = 0;
+
+	ApplyRepositionQueues(nGroups,nLanes);
+	for(i=0,bAllGroupsFinished=1;i<nGroups;i++)
+		bAllGroupsFinished &= m_pIslands[i].bFinished;
+	return bAllGroupsFinished;
+}
+
+// Updates on island lanes don't touch the entity grid and the typed entity lists, the calls are queued on the group's 
+// lane together with the bbox and sim class the entity had at that moment
+void CPhysicalWorld::QueueReposition(CPhysicalPlaceholder *pobj, int flags)
+{
+	CPhysicalEntity *pent = (CPhysicalEntity*)pobj;
+	assert(!IsPlaceholder(pobj) && (unsigned int)pent->m_iGroup<(unsigned int)m_nEntsAlloc);
+	int iGroup = m_pGroupNums[pent->m_iGroup];
+	reposition_queue *pq = m_repositionQueues+m_pIslands[iGroup].iLane;
+
+	if (pq->nReqs==pq->nReqsAlloc) {
+		EnterCriticalSection(&m_csSolver);
+		ReallocateList(pq->pReqs, pq->nReqs,pq->nReqsAlloc+=64);
+		LeaveCriticalSection(&m_csSolver);
+	}
+	reposition_request &req = pq->pReqs[pq->nReqs++];
+	req.pobj = pobj; req.flags = flags; req.iGroup = iGroup;
+	req.BBox[0] = pobj->m_BBox[0]; req.BBox[1] = pobj->m_BBox[1];
+	req.iSimClass = pobj->m_iSimClass;
+}
+
+// Replays the queued calls group by group, in the order the serial loop would have made them
+void CPhysicalWorld::ApplyRepositionQueues(int nGroups,int nLanes)
+{
+	int i,iSimClass;
+	vectorf BBox[2];
+	reposition_queue *pq;
+	CPhysicalPlaceholder *pobj;
+
+	for(i=0;i<nLanes;i++) m_repositionQueues[i].iReplay = 0;
+	for(i=0;i<nGroups;i++) 
+	for(pq=m_repositionQueues+m_pIslands[i].iLane; pq->iReplay<pq->nReqs && pq->pReqs[pq->iReplay].iGroup==i; pq->iReplay++) {
+		reposition_request &req = pq->pReqs[pq->iReplay];
+		pobj = req.pobj;
+		BBox[0] = pobj->m_BBox[0]; BBox[1] = pobj->m_BBox[1]; iSimClass = pobj->m_iSimClass;
+		pobj->m_BBox[0] = req.BBox[0]; pobj->m_BBox[1] = req.BBox[1]; pobj->m_iSimClass = req.iSimClass;
+		RepositionEntity(pobj, req.flags);
+		pobj->m_BBox[0] = BBox[0]; pobj->m_BBox[1] = BBox[1]; pobj->m_iSimClass = iSimClass;
+	}
+	for(i=0;i<nLanes;i++)
+		m_repositionQueues[i].nReqs = 0;
+}
+
+static inline unsigned int HashFloatBits(unsigned int hash, const float *pdata,int n)
+{
+	for(int i=0;i<n;i++) hash = (hash ^ *(const unsigned int*)(pdata+i))*16777619u;
+	return hash;
+}
+
+// Logs a hash of the exact positions, orientations and velocities of the rigid bodies in entity list order. Two runs
+// of the same scene with different p_island_workers must log the same lines
+void CPhysicalWorld::LogStepChecksum()
+{
+	int i,nEnts=0;
+	unsigned int hash = 2166136261u;
+	CPhysicalEntity *pent;
+	RigidBody *pbody;
+
+	for(i=1;i<=2;i++) for(pent=m_pTypedEnts[i]; pent; pent=pent->m_next,nEnts++) {
+		pbody = pent->GetRigidBody();
+		hash = HashFloatBits(hash, &pent->m_pos.x,3);
+		hash = HashFloatBits(hash, &pent->m_qrot.w,1);
+		hash = HashFloatBits(hash, &pent->m_qrot.v.x,3);
+		hash = HashFloatBits(hash, &pbody->v.x,3);
+		hash = HashFloatBits(hash, &pbody->w.x,3);
+	}
+	m_pLog->Log("\001physics step %d, substep %d: %d rigid bodies, state checksum %08x", m_iTimePhysics,m_iSubstep, nEnts,hash);
+}
+
+
 void CPhysicalWorld::DetachEntityGridThunks(CPhysicalPlaceholder *pobj)
 {
 	for(int i=0;i<pobj->m_nGridThunks;i++) {
@@ -998,6 +1181,9 @@ void CPhysicalWorld::RepositionEntity(CPhysicalPlaceholder *pobj, int flags)
 {
 	int i,j,igx[2],igy[2],n,ix,iy;
 	if ((unsigned int)pobj->m_iSimClass>=7u) return; // entity is frozen
+	if (m_bIslandLanes) {
+		QueueReposition(pobj,flags); return;
+	}
 
 	if (flags&1 && m_pEntGrid) {
 		for(i=0;i<2;i++) {
@@ -1104,10 +1290,57 @@ DEBUG_BREAK;
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+ray_scratch::~ray_scratch() 
+{ 
+	if (pSlots) delete[] pSlots; 
+	if (pStamps) delete[] pStamps;
+	if (pGeomScratch) delete pGeomScratch;
+}
+
+void ray_scratch::Reset()
+{
+	if (!pSlots) {
+		pSlots = new CPhysicalPlaceholder*[nSlots=256];
+		memset(pStamps = new int[nSlots], 0,nSlots*sizeof(int));
+	}
+	nUsed = 0;
+	if (++iStamp==0) { // stamp wrapped around, clear the slots for real
+		memset(pStamps, 0,nSlots*sizeof(int)); iStamp = 1;
+	}
+}
+
+int ray_scratch::Find(CPhysicalPlaceholder *pent)
+{
+	int i = (int)((UINT_PTR)pent>>4 ^ (UINT_PTR)pent>>12) & nSlots-1;
+	for(; pStamps[i]==iStamp && pSlots[i]!=pent; i=i+1&nSlots-1);
+	return i;
+}
+
+void ray_scratch::Mark(CPhysicalPlaceholder *pent)
+{
+	int i;
+	if (!pent || pStamps[i=Find(pent)]==iStamp)
+		return;
+	pSlots[i] = pent; pStamps[i] = iStamp; 
+	if (++nUsed*2 > nSlots) { // keep the table at most half full
+		CPhysicalPlaceholder **pOldSlots = pSlots;
+		int *pOldStamps=pStamps,nOldSlots=nSlots,iOldStamp=iStamp;
+		pSlots = new CPhysicalPlaceholder*[nSlots*=2];
+		memset(pStamps = new int[nSlots], 0,nSlots*sizeof(int));
+		iStamp = 1;
+		for(i=0;i<nOldSlots;i++) if (pOldStamps[i]==iOldStamp) {
+			int j = Find(pOldSlots[i]);
+			pSlots[j] = pOldSlots[i]; pStamps[j] = iStamp;
+		}
+		delete[] pOldSlots; delete[] pOldStamps;
+	}
+}
+
+
 struct entity_grid_checker {
 	geom_world_data gwd;
 	intersection_params ip;
-	int nMaxHits,nThroughHits,nThroughHitsAux,objtypes,nEnts,bCallbackUsed;
+	int nMaxHits,nThroughHits,nThroughHitsAux,objtypes,bCallbackUsed,bAbort;
 	unsigned int flags,flagsCollider;
 	vector2df org2d,dir2d;
 	float dir2d_len,maxt;
@@ -1116,11 +1349,13 @@ struct entity_grid_checker {
 	CPhysicalPlaceholder *pGridEnt;
 	void *pSkipForeignData;
 	CRayGeom aray;
+	ray_scratch *pScratch;
+	int bLane; // set when tracing on a batch lane, geometry tests then use the lane's geom_scratch
 	entity_grid_checker() {}
 
 	int check_cell(const vector2di &icell, int &ilastcell) {
 		quotientf t((org2d+icell)*dir2d, dir2d_len*dir2d_len);
-		if (t.x>maxt && (icell.x&icell.y)!=-1)
+		if (bAbort || t.x>maxt && (icell.x&icell.y)!=-1)
 			return 1;
 
 		box bbox;
@@ -1132,7 +1367,7 @@ struct entity_grid_checker {
 
 		for(thunk=pWorld->m_pEntGrid[pWorld->m_entgrid.getcell_safe(icell.x,icell.y)]; thunk; thunk=thunk_next) {
 			thunk_next = thunk->next;
-			if (!thunk->pent->m_bProcessed && objtypes & 1u<<thunk->pent->m_iSimClass && 
+			if (!pScratch->IsMarked(thunk->pent) && objtypes & 1u<<thunk->pent->m_iSimClass && 
 					(!pSkipForeignData || thunk->pent->GetForeignData()!=pSkipForeignData)) 
 			{
 				bbox.center = (thunk->pent->m_BBox[0]+thunk->pent->m_BBox[1])*0.5f;
@@ -1147,11 +1382,21 @@ struct entity_grid_checker {
 				if (!box_ray_overlap_check(&bbox,&aray.m_ray))
 					continue;
 				nEntsChecked++;	
-				pWorld->m_bGridThunksChanged = 0;
-				CPhysicalEntity *pent = (pGridEnt=thunk->pent)->GetEntity();
-				if (pWorld->m_bGridThunksChanged)
-					thunk_next = pWorld->m_pEntGrid[pWorld->m_entgrid.getcell_safe(icell.x,icell.y)];
-				pWorld->m_bGridThunksChanged = 0;
+				CPhysicalEntity *pent;
+				if (!bLane) {
+					pWorld->m_bGridThunksChanged = 0;
+					pent = (pGridEnt=thunk->pent)->GetEntity();
+					if (pWorld->m_bGridThunksChanged)
+						thunk_next = pWorld->m_pEntGrid[pWorld->m_entgrid.getcell_safe(icell.x,icell.y)];
+					pWorld->m_bGridThunksChanged = 0;
+				} else if (!(pent = (pGridEnt=thunk->pent)->GetEntityFast())) {
+					bAbort = 1; // on-demand entity creation changes the grid, leave this ray to the calling thread
+					return 1;
+				} else if (pent->m_nParts==0 || pent->m_flags&pef_use_geom_callbacks) {
+					bAbort = 1; // entity ray callbacks keep their own static contacts, same as above
+					return 1;
+				} else
+					pent->m_timeIdle = 0;
 
 				bCallbackUsed = 0;
 				if (pent->m_nParts==0 || pent->m_flags&pef_use_geom_callbacks) {
@@ -1219,8 +1464,7 @@ struct entity_grid_checker {
 					}
 				}
 
-				pWorld->m_pTmpEntList[nEnts++] = pent;
-				pGridEnt->m_bProcessed = 1;
+				pScratch->Mark(pGridEnt);
 			}
 		}
 		return (sgn((icell.y<<16|icell.x)-ilastcell)&1)^1;
@@ -1239,16 +1483,23 @@ int CPhysicalWorld::RayWorldIntersection(vectorf org,vectorf dir, int objtypes,
 	}
 	if (dir.len2()==0)
 		return 0;
+	return TraceRay(org,dir,objtypes,flags,hits,nMaxHits,pSkipEnt,pSkipEntAux, m_rayScratch,0);
+}
+
+
+int CPhysicalWorld::TraceRay(vectorf org,vectorf dir, int objtypes, unsigned int flags, ray_hit *hits,int nMaxHits, 
+														 IPhysicalEntity *pSkipEnt,IPhysicalEntity *pSkipEntAux, ray_scratch *pScratch,int bLane)
+{
 	int i,nHits; for(i=0;i<nMaxHits;i++) { hits[i].dist=1E10; hits[i].bTerrain=0; }
+	// entities that were already checked are tracked in the scratch, so that the query doesn't write into entities
+	pScratch->Reset();
 	if (pSkipEnt) {
-		((CPhysicalPlaceholder*)pSkipEnt)->m_bProcessed = 1;
-		if (((CPhysicalPlaceholder*)pSkipEnt)->m_pEntBuddy)
-			((CPhysicalPlaceholder*)pSkipEnt)->m_pEntBuddy->m_bProcessed = 1;
+		pScratch->Mark((CPhysicalPlaceholder*)pSkipEnt);
+		pScratch->Mark(((CPhysicalPlaceholder*)pSkipEnt)->m_pEntBuddy);
 	}
 	if (pSkipEntAux) {
-		((CPhysicalPlaceholder*)pSkipEntAux)->m_bProcessed = 1;
-		if (((CPhysicalPlaceholder*)pSkipEntAux)->m_pEntBuddy)
-			((CPhysicalPlaceholder*)pSkipEntAux)->m_pEntBuddy->m_bProcessed = 1;
+		pScratch->Mark((CPhysicalPlaceholder*)pSkipEntAux);
+		pScratch->Mark(((CPhysicalPlaceholder*)pSkipEntAux)->m_pEntBuddy);
 	}
 
 	if ((objtypes & ent_terrain) && m_pHeightfield) {
@@ -1291,7 +1542,9 @@ int CPhysicalWorld::RayWorldIntersection(vectorf org,vectorf dir, int objtypes,
 	egc.dir2d.set(dir_grid.x*m_entgrid.stepr.x, dir_grid.y*m_entgrid.stepr.y);
 	egc.dir2d_len = egc.dir2d.len();
 	egc.maxt = egc.dir2d_len*(egc.dir2d_len+sqrt2);
-	egc.nEnts = 0;
+	egc.pScratch = pScratch;
+	egc.bLane = bLane;
+	egc.bAbort = 0;
 
 	if (fabsf(origin_grid.x*m_entgrid.stepr.x*2-m_entgrid.size.x)>m_entgrid.size.x || 
 			fabsf(origin_grid.y*m_entgrid.stepr.y*2-m_entgrid.size.y)>m_entgrid.size.y || 
@@ -1300,21 +1553,8 @@ int CPhysicalWorld::RayWorldIntersection(vectorf org,vectorf dir, int objtypes,
 		egc.check_cell(vector2di(-1,-1),i);
 
 	DrawRayOnGrid(&m_entgrid, origin_grid,dir_grid, egc);
-	for(i=0;i<egc.nEnts;i++) { 
-		m_pTmpEntList[i]->m_bProcessed = 0;
-		if (m_pTmpEntList[i]->m_pEntBuddy)
-			m_pTmpEntList[i]->m_pEntBuddy->m_bProcessed = 0;
-	}
-	if (pSkipEnt) {
-		((CPhysicalPlaceholder*)pSkipEnt)->m_bProcessed = 0;
-		if (((CPhysicalPlaceholder*)pSkipEnt)->m_pEntBuddy)
-			((CPhysicalPlaceholder*)pSkipEnt)->m_pEntBuddy->m_bProcessed = 0;
-	}
-	if (pSkipEntAux) {
-		((CPhysicalPlaceholder*)pSkipEntAux)->m_bProcessed = 0;
-		if (((CPhysicalPlaceholder*)pSkipEntAux)->m_pEntBuddy)
-			((CPhysicalPlaceholder*)pSkipEntAux)->m_pEntBuddy->m_bProcessed = 0;
-	}
+	if (egc.bAbort)
+		return -1;
 
 	if (flags & rwi_separate_important_hits) {
 		int j,idx[2]; ray_hit thit;
@@ -1343,6 +1583,76 @@ int CPhysicalWorld::RayWorldIntersection(vectorf org,vectorf dir, int objtypes,
 }
 
 
+
+struct ray_lane {
+	CPhysicalWorld *pWorld;
+	ray_query *pQueries;
+	int iLane,nLanes;
+	int nQueries;
+};
+
+static void TraceRayLane(void *pData)
+{
+	ray_lane *plane = (ray_lane*)pData;
+	ray_scratch *pScratch = plane->pWorld->m_rayScratch+plane->iLane;
+	ray_query *pq;
+	SetGeomScratch(pScratch->pGeomScratch);
+	for(int i=plane->iLane; i<plane->nQueries; i+=plane->nLanes) if ((pq=plane->pQueries+i)->nHits>=0)
+		pq->nHits = plane->pWorld->TraceRay(pq->org,pq->dir,pq->objtypes,pq->flags,pq->hits,pq->nMaxHits,pq->pSkipEnt,pq->pSkipEntAux, 
+			pScratch,1);
+	SetGeomScratch(0);
+}
+
+int CPhysicalWorld::RayWorldIntersectionBatch(ray_query *pQueries,int nQueries)
+{
+	FUNCTION_PROFILER( GetISystem(),PROFILE_PHYSICS );
+
+	int i,nHits,nLanes = max(1,min(min(m_vars.nRayBatchWorkers,MAX_ISLAND_WORKERS),nQueries));
+	IJobManager *pJobManager = GetISystem() ? GetISystem()->GetIJobManager() : 0;
+	ray_lane lanes[MAX_ISLAND_WORKERS];
+
+	// validate on the calling thread, so that worker lanes never log
+	for(i=0;i<nQueries;i++) {
+		pQueries[i].nHits = 0;
+		if (!(pQueries[i].dir.len2()<25E6f && pQueries[i].org.len2()<4E8f)) {
+			VALIDATOR_LOG(m_pLog,"RayWorldIntersectionBatch: ray is out of bounds");
+			if (m_vars.bBreakOnValidation) DoBreak
+			pQueries[i].nHits = -1;
+		} else if (pQueries[i].dir.len2()==0)
+			pQueries[i].nHits = -1;
+	}
+
+	if (nLanes<2 || !pJobManager) {
+		for(i=0;i<nQueries;i++) if (pQueries[i].nHits>=0)
+			pQueries[i].nHits = TraceRay(pQueries[i].org,pQueries[i].dir,pQueries[i].objtypes,pQueries[i].flags,pQueries[i].hits,pQueries[i].nMaxHits, 
+				pQueries[i].pSkipEnt,pQueries[i].pSkipEntAux, m_rayScratch,0);
+	}	else {
+		for(i=0;i<nLanes;i++) {
+			lanes[i].pWorld = this; lanes[i].pQueries = pQueries;
+			lanes[i].iLane = i; lanes[i].nLanes = nLanes;
+			lanes[i].nQueries = nQueries;
+			m_rayScratch[i].Reset(); // allocate the tables here rather than on the lanes
+			if (!m_rayScratch[i].pGeomScratch)
+				m_rayScratch[i].pGeomScratch = new geom_scratch;
+		}
+		JobCounter lanesDone;
+		for(i=1;i<nLanes;i++)
+			pJobManager->AddJob(TraceRayLane, lanes+i, &lanesDone);
+		TraceRayLane(lanes);
+		pJobManager->WaitForJobs(&lanesDone);
+
+		// rays that need on-demand entity creation are retraced here, where the grid can be changed
+		for(i=0;i<nQueries;i++) if (pQueries[i].nHits==-1 && pQueries[i].dir.len2()>0 && pQueries[i].dir.len2()<25E6f && pQueries[i].org.len2()<4E8f)
+			pQueries[i].nHits = TraceRay(pQueries[i].org,pQueries[i].dir,pQueries[i].objtypes,pQueries[i].flags,pQueries[i].hits,pQueries[i].nMaxHits, 
+				pQueries[i].pSkipEnt,pQueries[i].pSkipEntAux, m_rayScratch,0);
+	}
+
+	for(i=nHits=0;i<nQueries;i++) 
+		nHits += pQueries[i].nHits = max(0,pQueries[i].nHits);
+	return nHits;
+}
+
+
 float CPhysicalWorld::IsAffectedByExplosion(IPhysicalEntity *pobj)
 {
 	int i;
@@ -1561,6 +1871,51 @@ void CPhysicalWorld::DrawPhysicsHelperInformation(void (*DrawLineFunc)(float*,fl
 		}
 		m_pLog->Log("\001%d active object(s)",nCount);
 	}
+
+	if (m_vars.nBenchmarkRays>0) {
+		int nRays = m_vars.nBenchmarkRays;
+		m_vars.nBenchmarkRays = 0;
+		BenchmarkRays(nRays);
+	}
+}
+
+
+void CPhysicalWorld::BenchmarkRays(int nRays)
+{
+	ITimer *pTimer = GetISystem() ? GetISystem()->GetITimer() : 0;
+	if (!pTimer || !m_pEntGrid)
+		return;
+	int i,nHitsSingle,nHitsBatch;
+	float t0,tSingle,tBatch;
+	vectorf gridsz,orgrnd;
+	ray_query *pQueries = new ray_query[nRays];
+	ray_hit *pHits = new ray_hit[nRays];
+
+	// random rays of ~50m in the area covered by the entity grid
+	gridsz[inc_mod3[m_iEntAxisz]] = m_entgrid.size.x*m_entgrid.step.x;
+	gridsz[dec_mod3[m_iEntAxisz]] = m_entgrid.size.y*m_entgrid.step.y;
+	gridsz[m_iEntAxisz] = 100.0f;
+	for(i=0;i<nRays;i++) {
+		orgrnd.Set(frand(1),frand(1),frand(1));
+		pQueries[i].org = m_entgrid.origin+vectorf(gridsz.x*orgrnd.x,gridsz.y*orgrnd.y,gridsz.z*orgrnd.z);
+		pQueries[i].dir.Set(frand(2)-1,frand(2)-1,frand(2)-1);
+		pQueries[i].dir *= 50.0f/max(0.01f,pQueries[i].dir.len());
+		pQueries[i].objtypes = ent_all; pQueries[i].flags = rwi_stop_at_pierceable;
+		pQueries[i].hits = pHits+i; pQueries[i].nMaxHits = 1;
+		pQueries[i].pSkipEnt = pQueries[i].pSkipEntAux = 0;
+	}
+
+	t0 = pTimer->GetAsyncCurTime();
+	for(i=nHitsSingle=0;i<nRays;i++)
+		nHitsSingle += RayWorldIntersection(pQueries[i].org,pQueries[i].dir,pQueries[i].objtypes,pQueries[i].flags,pQueries[i].hits,1);
+	tSingle = pTimer->GetAsyncCurTime()-t0;
+	t0 = pTimer->GetAsyncCurTime();
+	nHitsBatch = RayWorldIntersectionBatch(pQueries,nRays);
+	tBatch = pTimer->GetAsyncCurTime()-t0;
+
+	m_pLog->Log("\001ray benchmark: %d rays, single %.0f rays/s (%d hits), batch %.0f rays/s (%d hits, %d lane(s))", nRays,
+		nRays/max(1E-6f,tSingle),nHitsSingle, nRays/max(1E-6f,tBatch),nHitsBatch, max(1,min(m_vars.nRayBatchWorkers,MAX_ISLAND_WORKERS)));
+	delete[] pHits; delete[] pQueries;
 }
 
 
@@ -1685,6 +2040,9 @@ void CPhysicalWorld::GetMemoryStatistics(ICrySizer *pSizer)
 		pSizer->AddObject(m_pMassList, m_nEntsAlloc*sizeof(m_pMassList[0]));
 		pSizer->AddObject(m_pGroupIds, m_nEntsAlloc*sizeof(m_pGroupIds[0]));
 		pSizer->AddObject(m_pGroupNums, m_nEntsAlloc*sizeof(m_pGroupNums[0]));
+		pSizer->AddObject(m_pIslands, m_nEntsAlloc*sizeof(m_pIslands[0]));
+		for(int i=0;i<MAX_ISLAND_WORKERS;i++)
+			pSizer->AddObject(m_repositionQueues[i].pReqs, m_repositionQueues[i].nReqsAlloc*sizeof(reposition_request));
 		pSizer->AddObject(m_pEntsById, m_nEntsAlloc*sizeof(m_pEntsById[0]));
 		pSizer->AddObject(m_pEntGrid, (m_entgrid.size.x*m_entgrid.size.y+1)*sizeof(m_pEntGrid[0]));
 		pSizer->AddObject(m_pGridStat, m_nOccRes*6*2*sizeof(m_pGridStat[0][0]));
@@ -22,7 +22,48 @@ const int PLACEHOLDER_CHUNK_SZ = 1<<PLACEHOLDER_CHUNK_SZLG2;
 class CPhysicalPlaceholder;
 class CPhysicalEntity;
 struct pe_gridthunk;
+struct SolverContext;
+struct geom_scratch;
 enum { pef_step_requested = 0x10000000 };
+const int MAX_ISLAND_WORKERS = 16;
+
+struct island_info { // per-group data passed between contact solving and entity update stages
+	float time_interval;
+	float damping;
+	int nAnimatedObjects;
+	int iLane;
+	int bFinished;
+};
+
+struct reposition_request { // RepositionEntity call made by an island lane, with the entity state it saw
+	CPhysicalPlaceholder *pobj;
+	vectorf BBox[2];
+	int iSimClass;
+	int flags;
+	int iGroup;
+};
+
+struct reposition_queue { // requests of one island lane, in the order its groups were updated
+	reposition_queue() { pReqs=0; nReqs=nReqsAlloc=iReplay=0; }
+	~reposition_queue() { if (pReqs) delete[] pReqs; }
+	reposition_request *pReqs;
+	int nReqs,nReqsAlloc;
+	int iReplay;
+};
+
+struct ray_scratch { // per-thread set of entities already checked by a ray query; reset in O(1) by bumping the stamp
+	ray_scratch() { pSlots=0; pStamps=0; nSlots=nUsed=iStamp=0; pGeomScratch=0; }
+	~ray_scratch();
+	void Reset();
+	int Find(CPhysicalPlaceholder *pent);
+	int IsMarked(CPhysicalPlaceholder *pent) { return pStamps[Find(pent)]==iStamp; }
+	void Mark(CPhysicalPlaceholder *pent);
+
+	CPhysicalPlaceholder **pSlots;
+	int *pStamps;
+	int nSlots,nUsed,iStamp;
+	geom_scratch *pGeomScratch; // geometry buffers of a batch lane
+};
 
 class CPhysicalWorld : public IPhysicalWorld, public IPhysUtils, public CGeomManager {
 public:
@@ -78,6 +119,10 @@ public:
 
 	virtual int RayWorldIntersection(vectorf org,vectorf dir, int objtypes, unsigned int flags, ray_hit *hits,int nmaxhits, 
 		IPhysicalEntity *pSkipEnt=0,IPhysicalEntity *pSkipEntAux=0);
+	virtual int RayWorldIntersectionBatch(ray_query *pQueries,int nQueries);
+	int TraceRay(vectorf org,vectorf dir, int objtypes, unsigned int flags, ray_hit *hits,int nMaxHits, 
+		IPhysicalEntity *pSkipEnt,IPhysicalEntity *pSkipEntAux, ray_scratch *pScratch,int bLane);
+	void BenchmarkRays(int nRays);
 
 	virtual void SimulateExplosion(vectorf epicenter,vectorf epicenterImp, float rmin,float rmax, float r,float impulsive_pressure_at_r, 
 		int nOccRes=0,int nGrow=0,float rmin_occ=0.1f, IPhysicalEntity **pSkipEnts=0,int nSkipEnts=0,
@@ -99,8 +144,15 @@ public:
 	}
 	int GetEntitiesAround(const vectorf &ptmin,const vectorf &ptmax, CPhysicalEntity **&pList, int objtypes, CPhysicalEntity *pPetitioner=0);
 	void RepositionEntity(CPhysicalPlaceholder *pobj, int flags=3);
+	void QueueReposition(CPhysicalPlaceholder *pobj, int flags);
+	void ApplyRepositionQueues(int nGroups,int nLanes);
 	void DetachEntityGridThunks(CPhysicalPlaceholder *pobj);
 	void ScheduleForStep(CPhysicalEntity *pent);
+	void SolveIsland(int iGroup, SolverContext *psc);
+	SolverContext *GetSolverContext(int iLane);
+	int UpdateIsland(int iGroup);
+	int StepIslandsParallel(int nGroups);
+	void LogStepChecksum();
 	CPhysicalEntity *CheckColliderListsIntegrity();
 
 	virtual int BreakPolygon(vector2df *ptSrc,int nPt, int nCellx,int nCelly, int maxPatchTris, vector2df *&ptout,int *&nPtOut, 
@@ -129,6 +181,12 @@ public:
 	CPhysicalEntity **m_pTmpEntList,**m_pTmpEntList1;
 	float *m_pGroupMass,*m_pMassList;
 	int *m_pGroupIds,*m_pGroupNums;
+	island_info *m_pIslands;
+	SolverContext *m_pSolvers[MAX_ISLAND_WORKERS]; // one contact solver context per worker lane
+	CRITICAL_SECTION m_csSolver; // guards buffer growth and colliders shared between groups on island lanes
+	reposition_queue m_repositionQueues[MAX_ISLAND_WORKERS];
+	int m_bIslandLanes; // set while island lanes solve and update groups, RepositionEntity calls are queued
+	ray_scratch m_rayScratch[MAX_ISLAND_WORKERS]; // one per ray batch lane, [0] is also used by RayWorldIntersection
 	grid m_entgrid;
 	int m_iEntAxisz;
 	pe_gridthunk **m_pEntGrid;
@@ -2,11 +2,11 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "bvtree.h"
 #include "geometry.h"
 #include "raybv.h"
-
-BVray CRayBV::g_BVray;
+#include "geomscratch.h"
 
 int CRayBV::GetNodeContents(int iNode, BV *pBVCollider,int bColliderUsed,int bColliderLocal, 
 														geometry_under_test *pGTest,geometry_under_test *pGTestOp)
@@ -17,7 +17,6 @@ public:
 
 	CGeometry *m_pGeom;
 	ray *m_pray;
-	static BVray g_BVray;
 };
 
 #endif
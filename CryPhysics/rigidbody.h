@@ -16,7 +16,6 @@
 
 struct entity_contact;
 
-const int MAX_CONTACTS = 4096;
 enum solver_events { solver_initialize, solver_end_iter, solver_end };
 
 class IRigidBodyOwner {
@@ -105,11 +104,46 @@ struct entity_contact {
 	float dPn;
 };
 
-extern bool g_bUsePreCG;
-extern int g_nContacts,g_nBodies;
-void InitContactSolver(float time_interval);
-void RegisterContact(entity_contact *pcontact);
-void InvokeContactSolver(float time_interval, SolverSettings *pss);
-char *AllocSolverTmpBuf(int size);
+struct contact_helper;
+struct body_helper;
+struct body_info;
+struct contact_sandwich;
+struct buddy_info;
+struct follower_thunk;
+struct solver_buf_chunk;
+
+// contact solver state; each thread that solves contacts needs its own context, groups solved with different contexts
+// must not share movable bodies (immovable bodies are replaced with context-private copies for the duration of the solve)
+struct SolverContext {
+	SolverContext(CRITICAL_SECTION *pcsAlloc=0);
+	~SolverContext();
+
+	int nContacts,nBodies;
+	bool bUsePreCG;
+
+	entity_contact **pContacts; int nContactsAlloc;
+	entity_contact **pContactsCG; int nContactsCGAlloc;
+	contact_helper *pCHelpers; int nCHelpersAlloc;
+	RigidBody **pBodies; int nBodiesAlloc;
+	body_helper *pBHelpers; int nBHelpersAlloc;
+	body_info *pInfos; int nInfosAlloc;
+	contact_sandwich *pSandwiches; int nSandwichesAlloc;
+	buddy_info *pBuddies; int nBuddiesAlloc;
+	follower_thunk *pFollowers; int nFollowersAlloc;
+	int nFollowers,idLastUpdate,nUnprojLoops;
+
+	RigidBody **pStaticsOrg; int nStaticsOrgAlloc;
+	RigidBody *pStatics; int nStaticsAlloc;
+	int nStatics;
+
+	solver_buf_chunk *pFirstChunk,*pCurChunk; // temporary contacts; chunks are never moved, so pointers stay valid until the next init
+
+	CRITICAL_SECTION *pcsAlloc; // serializes buffer growth if contexts are used from several threads
+};
+
+void InitContactSolver(SolverContext *psc, float time_interval);
+void RegisterContact(SolverContext *psc, entity_contact *pcontact);
+void InvokeContactSolver(SolverContext *psc, float time_interval, SolverSettings *pss);
+char *AllocSolverTmpBuf(SolverContext *psc, int size);
 
 #endif
\ No newline at end of file
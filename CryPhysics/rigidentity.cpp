@@ -1988,7 +1988,7 @@ int CRigidEntity::GetContactCount(int nMaxPlaneContacts)
 }
 
 
-int CRigidEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
+int CRigidEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc)
 {
 	FUNCTION_PROFILER( GetISystem(),PROFILE_PHYSICS );
 
@@ -2028,8 +2028,8 @@ int CRigidEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
 				mindim1 = min(sz.x,min(sz.y,sz.z));
 				bStable = CompactContactBlock(contact_mask, min(mindim,mindim1)*0.15f, nMaxPlaneContacts,nContacts, n,dist, m_body.pos,m_gravity);
 				if (bStable && dist<min(mindim,mindim1)*0.05f) {
-					pContactLin = (entity_contact*)AllocSolverTmpBuf(sizeof(entity_contact));
-					pContactAng = (entity_contact*)AllocSolverTmpBuf(sizeof(entity_contact));
+					pContactLin = (entity_contact*)AllocSolverTmpBuf(psc,sizeof(entity_contact));
+					pContactAng = (entity_contact*)AllocSolverTmpBuf(psc,sizeof(entity_contact));
 					if (pContactLin && pContactAng) {
 						bUseAreaContact = 1;
 						pContactLin->pent[0]=pContactAng->pent[0] = this;
@@ -2057,19 +2057,19 @@ int CRigidEntity::RegisterContacts(float time_interval,int nMaxPlaneContacts)
 			for(j=0;j<NMASKBITS && getmask(j)<=contact_mask;j++) if (contact_mask & getmask(j)) {
 				m_pContacts[j].pBounceCount = &pContactLin->iCount;
 				m_pContacts[j].flags |= contact_maintain_count&-bUseAreaContact;
-				RegisterContact(m_pContacts+j);
+				RegisterContact(psc,m_pContacts+j);
 				ArchiveContact(j);
 			}
 			if (bUseAreaContact) {
-				RegisterContact(pContactLin);
-				RegisterContact(pContactAng);
+				RegisterContact(psc,pContactLin);
+				RegisterContact(psc,pContactAng);
 			}
 		}
 		for(j=0;j<NMASKBITS && getmask(j)<=m_pColliderConstraints[i];j++) if (m_pColliderConstraints[i] & getmask(j) && m_pConstraintInfos[j].bActive)
-			RegisterContact(m_pConstraints+j);
+			RegisterContact(psc,m_pConstraints+j);
 	}
 	if (m_submergedFraction>0)
-		g_bUsePreCG = false;
+		psc->bUsePreCG = false;
 	return 1;
 }
 
@@ -83,7 +83,7 @@ class CRigidEntity : public CPhysicalEntity {
 	virtual int Step(float time_interval);
 	virtual void StepBack(float time_interval);
 	virtual int GetContactCount(int nMaxPlaneContacts);
-	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts);
+	virtual int RegisterContacts(float time_interval,int nMaxPlaneContacts, SolverContext *psc);
 	virtual int Update(float time_interval, float damping);
 	virtual float CalcEnergy(float time_interval);
 	virtual float GetDamping(float time_interval);
@@ -23,6 +23,7 @@
 #include "geoman.h"
 #include "physicalworld.h"
 #include "ropeentity.h"
+#include "geomscratch.h"
 
 
 CRopeEntity::CRopeEntity(CPhysicalWorld *pWorld) : CPhysicalEntity(pWorld)
@@ -2,9 +2,11 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "bvtree.h"
 #include "geometry.h"
 #include "singleboxtree.h"
+#include "geomscratch.h"
 
 float CSingleBoxTree::Build(CGeometry *pGeom) 
 { 
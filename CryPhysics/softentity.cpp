@@ -26,6 +26,7 @@
 #include "geoman.h"
 #include "physicalworld.h"
 #include "softentity.h"
+#include "geomscratch.h"
 
 
 CSoftEntity::CSoftEntity(CPhysicalWorld *pworld) : CPhysicalEntity(pworld)
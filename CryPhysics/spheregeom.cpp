@@ -2,11 +2,13 @@
 
 #include "utils.h"
 #include "primitives.h"
+#include "overlapchecks.h"
 #include "unprojectionchecks.h"
 #include "bvtree.h"
 #include "singleboxtree.h"
 #include "geometry.h"
 #include "spheregeom.h"
+#include "geomscratch.h"
 
 
 CSphereGeom* CSphereGeom::CreateSphere(sphere *psphere)
@@ -45,8 +47,6 @@ int CSphereGeom::PointInsideStatus(const vectorf &pt)
 
 int CSphereGeom::PrepareForIntersectionTest(geometry_under_test *pGTest, CGeometry *pCollider,geometry_under_test *pGTestColl, bool bKeepPrevContacts)
 {
-	static short g_SphIdBuf[1];
-
 	pGTest->pGeometry = this;
 	pGTest->pBVtree = &m_Tree;
 	m_Tree.PrepareForIntersectionTest(pGTest);
@@ -13,39 +13,7 @@
 #include "trimesh.h"
 #include "raybv.h"
 #include "raygeom.h"
-
-vectorf g_BrdPtBuf[2048];
-int g_BrdPtBufPos,g_BrdPtBufStart;
-int g_BrdiTriBuf[2048][2];
-float g_BrdSeglenBuf[2048];
-int g_UsedVtxMap[4096];
-int g_UsedTriMap[4096];
-vector2df g_PolyPtBuf[1024];
-int g_PolyVtxIdBuf[1024];
-int g_PolyEdgeIdBuf[1024];
-int g_PolyPtBufPos;
-
-struct tritem {
-	int itri;
-	int itri_parent;
-	int ivtx0;
-};
-struct vtxitem {
-	int ivtx;
-	int id;
-	int ibuddy[2];
-};
-tritem g_TriQueue[512];
-vtxitem g_VtxList[512];
-
-struct InitTriMeshGlobals {
-	InitTriMeshGlobals() {
-		memset(g_UsedVtxMap, 0, sizeof(g_UsedVtxMap));
-		memset(g_UsedTriMap, 0, sizeof(g_UsedTriMap));
-		g_BrdPtBufPos = 0; g_PolyPtBufPos = 0;
-	}
-};
-static InitTriMeshGlobals now;
+#include "geomscratch.h"
 
 
 CTriMesh::CTriMesh() 
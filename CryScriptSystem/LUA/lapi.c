@@ -22,6 +22,7 @@
 #include "lstring.h"
 #include "ltable.h"
 #include "ltm.h"
+#include "lundump.h"
 #include "lvm.h"
 #include "platform.h"
 
@@ -680,6 +681,21 @@ LUA_API int lua_dostring (lua_State *L, const l_char *str) {
 }
 
 
+LUA_API int lua_dump (lua_State *L, lua_Chunkwriter writer, void *data) {
+  int status;
+  TObject *o;
+  lua_lock(L);
+  api_checknelems(L, 1);
+  o = L->top - 1;
+  if (ttype(o) == LUA_TFUNCTION && !clvalue(o)->isC)
+    status = luaU_dump(L, clvalue(o)->f.l, writer, data);
+  else
+    status = 1;
+  lua_unlock(L);
+  return status;
+}
+
+
 
 /*
 ** Garbage-collection functions
@@ -707,14 +723,37 @@ LUA_API int lua_getgccount (lua_State *L) {
 
 LUA_API void lua_setgcthreshold (lua_State *L, int newthreshold) {
   lua_lock(L);
-  if (newthreshold > GCscale(ULONG_MAX))
-    G(L)->GCthreshold = ULONG_MAX;
+  if (newthreshold >= GCscale(MAX_LUMEM))
+    G(L)->GCthreshold = MAX_LUMEM;
   else
     G(L)->GCthreshold = GCunscale(newthreshold);
   luaC_checkGC(L);
   lua_unlock(L);
 }
 
+LUA_API int lua_gcstep (lua_State *L, int nworkkb) {
+  int done = 0;
+  lua_lock(L);
+  if (nworkkb > 0)
+    done = luaC_step(L, (nworkkb >= GCscale(MAX_LUMEM)) ? MAX_LUMEM : GCunscale(nworkkb));
+  else if (G(L)->gcstate != GCSpause)
+    done = luaC_step(L, MAX_LUMEM);
+  lua_unlock(L);
+  return done;
+}
+
+LUA_API int lua_getgcstate (lua_State *L) {
+  int state;
+  lua_lock(L);
+  switch (G(L)->gcstate) {
+    case GCSpause: state = LUA_GCIDLE; break;
+    case GCSpropagate: state = LUA_GCMARK; break;
+    default: state = LUA_GCSWEEP; break;
+  }
+  lua_unlock(L);
+  return state;
+}
+
 
 /*
 ** miscellaneous functions
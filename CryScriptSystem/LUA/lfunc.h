@@ -11,6 +11,8 @@
 #include "lobject.h"
 
 
+#define sizeclosure(n)	((int)sizeof(Closure) + (int)sizeof(TObject)*((n)-1))
+
 
 Proto *luaF_newproto (lua_State *L);
 Closure *luaF_newclosure (lua_State *L, int nelems);
@@ -20,19 +20,24 @@
 
 
 
-typedef struct GCState {
-  Hash *tmark;  /* list of marked tables to be visited */
-  Closure *cmark;  /* list of marked closures to be visited */
-} GCState;
-
-
+/*
+** The collector is incremental: a cycle marks from the roots and then sweeps,
+** luaC_step does a limited amount of this work between runs of the program.
+** Tables are white (unmarked), gray (marked, in `tmark') or black (traversed);
+** storing into a black table makes it gray again (luaC_barrierback), it is
+** traversed again in the atomic step, together with the stacks, the tag
+** methods and the weak tables, which have no barrier.
+** The sweep detaches the lists of the objects that existed in the atomic step,
+** objects created meanwhile are not visited before the next cycle.
+*/
 
 /* mark a string; marks larger than 1 cannot be changed */
 #define strmark(s)    {if ((s)->tsv.marked == 0) (s)->tsv.marked = 1;}
 
 
 
-static void protomark (Proto *f) {
+static lu_mem protomark (Proto *f) {
+  lu_mem work = 0;
   if (!f->marked) {
     int i;
     f->marked = 1;
@@ -42,34 +47,38 @@ static void protomark (Proto *f) {
         strmark(tsvalue(f->k+i));
     }
     for (i=0; i<f->sizep; i++)
-      protomark(f->p[i]);
+      work += protomark(f->p[i]);
     for (i=0; i<f->sizelocvars; i++)  /* mark local-variable names */
       strmark(f->locvars[i].varname);
+    work += sizeof(Proto) + f->sizecode*sizeof(Instruction) + f->sizek*sizeof(TObject);
   }
+  return work;
 }
 
 
-static void markclosure (GCState *st, Closure *cl) {
+static lu_mem markclosure (global_State *g, Closure *cl) {
+  lu_mem work = 0;
   if (!ismarked(cl)) {
     if (!cl->isC) {
       lua_assert(cl->nupvalues == cl->f.l->nupvalues);
-      protomark(cl->f.l);
+      work = protomark(cl->f.l);
     }
-    cl->mark = st->cmark;  /* chain it for later traversal */
-    st->cmark = cl;
+    cl->mark = g->cmark;  /* chain it for later traversal */
+    g->cmark = cl;
   }
+  return work;
 }
 
 
-static void marktable (GCState *st, Hash *h) {
+static void marktable (global_State *g, Hash *h) {
   if (!ismarked(h)) {
-    h->mark = st->tmark;  /* chain it for later traversal */
-    st->tmark = h;
+    h->mark = g->tmark;  /* chain it for later traversal */
+    g->tmark = h;
   }
 }
 
 
-static void markobject (GCState *st, TObject *o) {
+static lu_mem markobject (global_State *g, TObject *o) {
   switch (ttype(o)) {
     case LUA_TSTRING:
       strmark(tsvalue(o));
@@ -79,24 +88,24 @@ static void markobject (GCState *st, TObject *o) {
         switchudatamark(uvalue(o));
       break;
     case LUA_TFUNCTION:
-      markclosure(st, clvalue(o));
-      break;
+      return markclosure(g, clvalue(o));
     case LUA_TTABLE: {
-      marktable(st, hvalue(o));
+      marktable(g, hvalue(o));
       break;
     }
     default: break;  /* numbers, etc */
   }
+  return 0;
 }
 
 
-static void markstacks (lua_State *L, GCState *st) {
+static void markstacks (lua_State *L, global_State *g) {
   lua_State *L1 = L;
   do {  /* for each thread */
     StkId o, lim;
-    marktable(st, L1->gt);  /* mark table of globals */
+    marktable(g, L1->gt);  /* mark table of globals */
     for (o=L1->stack; o<L1->top; o++)
-      markobject(st, o);
+      markobject(g, o);
     lim = (L1->stack_last - L1->ci->base > MAXSTACK) ? L1->ci->base+MAXSTACK
                                                      : L1->stack_last;
     for (; o<=lim; o++) setnilvalue(o);
@@ -106,24 +115,25 @@ static void markstacks (lua_State *L, GCState *st) {
 }
 
 
-static void marktagmethods (global_State *G, GCState *st) {
+static void marktagmethods (global_State *g) {
   int t;
-  for (t=0; t<G->ntag; t++) {
-    struct TM *tm = &G->TMtable[t];
+  for (t=0; t<g->ntag; t++) {
+    struct TM *tm = &g->TMtable[t];
     int e;
     if (tm->name) strmark(tm->name);
     for (e=0; e<TM_N; e++) {
       Closure *cl = tm->method[e];
-      if (cl) markclosure(st, cl);
+      if (cl) markclosure(g, cl);
     }
   }
 }
 
 
-static void traverseclosure (GCState *st, Closure *f) {
+static lu_mem traverseclosure (global_State *g, Closure *f) {
   int i;
   for (i=0; i<f->nupvalues; i++)  /* mark its upvalues */
-    markobject(st, &f->upvalue[i]);
+    markobject(g, &f->upvalue[i]);
+  return sizeclosure(f->nupvalues);
 }
 
 
@@ -134,11 +144,18 @@ static void removekey (Node *n) {
 }
 
 
-static void traversetable (GCState *st, Hash *h) {
+static lu_mem traversetable (global_State *g, Hash *h) {
   int i;
   int mode = h->weakmode;
+  lu_mem work = sizeof(Hash) + h->size*sizeof(Node);
+  if (mode) {  /* weak tables are traversed again and cleared in the atomic step */
+    h->mark = g->weak;
+    g->weak = h;
+  }
+  else
+    h->gcblack = 1;
   if (mode == (LUA_WEAK_KEY | LUA_WEAK_VALUE))
-    return;  /* avoid traversing if both keys and values are weak */
+    return work;  /* avoid traversing if both keys and values are weak */
   for (i=0; i<h->size; i++) {
     Node *n = node(h, i);
     if (ttype(val(n)) == LUA_TNIL)
@@ -146,36 +163,53 @@ static void traversetable (GCState *st, Hash *h) {
     else {
       lua_assert(ttype(key(n)) != LUA_TNIL);
       if (ttype(key(n)) != LUA_TNUMBER && !(mode & LUA_WEAK_KEY))
-        markobject(st, key(n));
+        work += markobject(g, key(n));
       if (!(mode & LUA_WEAK_VALUE))
-        markobject(st, val(n));
+        work += markobject(g, val(n));
     }
   }
+  return work;
 }
 
 
-static void markall (lua_State *L) {
-  GCState st;
-  st.cmark = NULL;
-  st.tmark = NULL;
-  marktagmethods(G(L), &st);  /* mark tag methods */
-  markstacks(L, &st); /* mark all stacks */
-  marktable(&st, G(L)->type2tag);
-  marktable(&st, G(L)->registry);
-	marktable(&st, G(L)->xregistry);
-  marktable(&st, G(L)->weakregistry);
-	for (;;) {  /* mark tables and closures */
-    if (st.cmark) {
-      Closure *f = st.cmark;  /* get first closure from list */
-      st.cmark = f->mark;  /* remove it from list */
-      traverseclosure(&st, f);
-    }
-    else if (st.tmark) {
-      Hash *h = st.tmark;  /* get first table from list */
-      st.tmark = h->mark;  /* remove it from list */
-      traversetable(&st, h);
-    }
-    else break;  /* nothing else to mark */
+static lu_mem propagatemark (global_State *g) {
+  if (g->cmark) {
+    Closure *f = g->cmark;  /* get first closure from list */
+    g->cmark = f->mark;  /* remove it from list */
+    return traverseclosure(g, f);
+  }
+  else {
+    Hash *h = g->tmark;  /* get first table from list */
+    g->tmark = h->mark;  /* remove it from list */
+    return traversetable(g, h);
+  }
+}
+
+
+static void propagateall (global_State *g) {
+  while (g->cmark || g->tmark)
+    propagatemark(g);
+}
+
+
+static void markroots (lua_State *L) {
+  global_State *g = G(L);
+  marktagmethods(g);  /* mark tag methods */
+  markstacks(L, g); /* mark all stacks */
+  marktable(g, g->type2tag);
+  marktable(g, g->registry);
+  marktable(g, g->xregistry);
+  marktable(g, g->weakregistry);
+}
+
+
+void luaC_barrierback (lua_State *L, Hash *h) {
+  global_State *g = G(L);
+  lua_assert(h->gcblack && ismarked(h));
+  h->gcblack = 0;
+  if (g->gcstate == GCSpropagate) {  /* else it is only waiting for the sweep */
+    h->mark = g->grayagain;
+    g->grayagain = h;
   }
 }
 
@@ -209,104 +243,171 @@ static void cleardeadnodes (Hash *h) {
 }
 
 
-static void cleartables (global_State *G) {
-  Hash *h;
-  for (h = G->roottable; h; h = h->next) {
-    if (h->weakmode && ismarked(h))
+static void cleartables (global_State *g) {
+  Hash *h = g->weak;
+  g->weak = NULL;
+  while (h) {
+    Hash *next = h->mark;
+    h->mark = NULL;  /* still marked */
+    if (h->weakmode)
       cleardeadnodes(h);
+    h = next;
+  }
+}
+
+
+static void startcycle (lua_State *L) {
+  global_State *g = G(L);
+  g->cmark = NULL;
+  g->tmark = NULL;
+  g->grayagain = NULL;
+  g->weak = NULL;
+  markroots(L);
+  g->gcstate = GCSpropagate;
+}
+
+
+static void atomic (lua_State *L) {
+  global_State *g = G(L);
+  Hash *h;
+  markroots(L);  /* they have no barrier */
+  while ((h = g->grayagain) != NULL) {  /* tables written to after traversal */
+    g->grayagain = h->mark;
+    h->mark = g->tmark;
+    g->tmark = h;
+  }
+  propagateall(g);
+  h = g->weak;  /* traverse the weak tables again */
+  g->weak = NULL;
+  while (h) {
+    Hash *next = h->mark;
+    traversetable(g, h);
+    h = next;
   }
+  propagateall(g);
+  cleartables(g);
+  /* detach the lists to sweep */
+  g->sweepstr = 0;
+  g->sweepudata = g->rootudata;
+  g->rootudata = NULL;
+  g->sweeptable = g->roottable;
+  g->roottable = NULL;
+  g->sweepproto = g->rootproto;
+  g->rootproto = NULL;
+  g->sweepcl = g->rootcl;
+  g->rootcl = NULL;
+  g->gcstate = GCSsweepstring;
 }
 
 
-static void collectproto (lua_State *L) {
-  Proto **p = &G(L)->rootproto;
+static lu_mem sweepproto (lua_State *L, lu_mem limit) {
+  global_State *g = G(L);
+  lu_mem work = 0;
   Proto *curr;
-  while ((curr = *p) != NULL) {
+  while ((curr = g->sweepproto) != NULL && work < limit) {
+    g->sweepproto = curr->next;
+    work += sizeof(Proto) + curr->sizecode*sizeof(Instruction);
     if (curr->marked) {
       curr->marked = 0;
-      p = &curr->next;
+      curr->next = g->rootproto;  /* back to the list of all prototypes */
+      g->rootproto = curr;
     }
-    else {
-      *p = curr->next;
+    else
       luaF_freeproto(L, curr);
-    }
   }
+  return work;
 }
 
 
-static void collectclosure (lua_State *L) {
-  Closure **p = &G(L)->rootcl;
+static lu_mem sweepclosure (lua_State *L, lu_mem limit) {
+  global_State *g = G(L);
+  lu_mem work = 0;
   Closure *curr;
-  while ((curr = *p) != NULL) {
+  while ((curr = g->sweepcl) != NULL && work < limit) {
+    g->sweepcl = curr->next;
+    work += sizeclosure(curr->nupvalues);
     if (ismarked(curr)) {
       curr->mark = curr;  /* unmark */
-      p = &curr->next;
+      curr->next = g->rootcl;
+      g->rootcl = curr;
     }
-    else {
-      *p = curr->next;
+    else
       luaF_freeclosure(L, curr);
-    }
   }
+  return work;
 }
 
 
-static void collecttable (lua_State *L) {
-  Hash **p = &G(L)->roottable;
+static lu_mem sweeptable (lua_State *L, lu_mem limit) {
+  global_State *g = G(L);
+  lu_mem work = 0;
   Hash *curr;
-  while ((curr = *p) != NULL) {
+  while ((curr = g->sweeptable) != NULL && work < limit) {
+    g->sweeptable = curr->next;
+    work += sizeof(Hash) + curr->size*sizeof(Node);
     if (ismarked(curr)) {
       curr->mark = curr;  /* unmark */
-      p = &curr->next;
+      curr->gcblack = 0;
+      curr->next = g->roottable;
+      g->roottable = curr;
     }
-    else {
-      *p = curr->next;
+    else
       luaH_free(L, curr);
-    }
   }
+  return work;
 }
 
 
-static void collectudata (lua_State *L, int keep) {
-  Udata **p = &G(L)->rootudata;
+static lu_mem sweepudata (lua_State *L, lu_mem limit, int keep) {
+  global_State *g = G(L);
+  lu_mem work = 0;
   Udata *curr;
-  while ((curr = *p) != NULL) {
+  while ((curr = g->sweepudata) != NULL && work < limit) {
+    g->sweepudata = curr->uv.next;
+    work += sizeudata(curr->uv.len);
     if (ismarkedudata(curr)) {
       switchudatamark(curr);  /* unmark */
-      p = &curr->uv.next;
+      curr->uv.next = g->rootudata;
+      g->rootudata = curr;
     }
     else {  /* collect */
       int tag = curr->uv.tag;
-      *p = curr->uv.next;
       if (keep ||  /* must keep all of them (to close state)? */
-          luaT_gettm(G(L), tag, TM_GC)) {  /* or is there a GC tag method? */
-        curr->uv.next = G(L)->TMtable[tag].collected;  /* chain udata ... */
-        G(L)->TMtable[tag].collected = curr;  /* ... to call its TM later */
+          luaT_gettm(g, tag, TM_GC)) {  /* or is there a GC tag method? */
+        curr->uv.next = g->TMtable[tag].collected;  /* chain udata ... */
+        g->TMtable[tag].collected = curr;  /* ... to call its TM later */
       }
       else  /* no tag method; delete udata */
         luaM_free(L, curr, sizeudata(curr->uv.len));
     }
   }
+  return work;
 }
 
 
-static void collectstrings (lua_State *L, int all) {
-  int i;
-  for (i=0; i<G(L)->strt.size; i++) {  /* for each list */
-    TString **p = &G(L)->strt.hash[i];
-    TString *curr;
-    while ((curr = *p) != NULL) {
-      if (curr->tsv.marked && !all) {  /* preserve? */
-        if (curr->tsv.marked < FIXMARK)  /* does not change FIXMARKs */
-          curr->tsv.marked = 0;
-        p = &curr->tsv.nexthash;
-      } 
-      else {  /* collect */
-        *p = curr->tsv.nexthash;
-        G(L)->strt.nuse--;
-        luaM_free(L, curr, sizestring(curr->tsv.len));
-      }
+/* sweeps one hash list of the string table */
+static lu_mem sweepstrings (lua_State *L, int i, int all) {
+  lu_mem work = 0;
+  TString **p = &G(L)->strt.hash[i];
+  TString *curr;
+  while ((curr = *p) != NULL) {
+    work += sizestring(curr->tsv.len);
+    if (curr->tsv.marked && !all) {  /* preserve? */
+      if (curr->tsv.marked < FIXMARK)  /* does not change FIXMARKs */
+        curr->tsv.marked = 0;
+      p = &curr->tsv.nexthash;
+    } 
+    else {  /* collect */
+      *p = curr->tsv.nexthash;
+      G(L)->strt.nuse--;
+      luaM_free(L, curr, sizestring(curr->tsv.len));
     }
   }
+  return work;
+}
+
+
+static void checkstrings (lua_State *L) {
   if (G(L)->strt.nuse < (ls_nstr)(G(L)->strt.size/4) &&
       G(L)->strt.size > MINPOWER2)
     luaS_resize(L, G(L)->strt.size/2);  /* table is too big */
@@ -361,62 +462,129 @@ static void callgcTMudata (lua_State *L) {
 
 void luaC_callallgcTM (lua_State *L) {
   if (G(L)->rootudata) {  /* avoid problems with incomplete states */
-    collectudata(L, 1);  /* collect all udata into tag lists */
+    lua_assert(G(L)->gcstate == GCSpause);
+    G(L)->sweepudata = G(L)->rootudata;
+    G(L)->rootudata = NULL;
+    sweepudata(L, MAX_LUMEM, 1);  /* collect all udata into tag lists */
     callgcTMudata(L);  /* call their GC tag methods */
   }
 }
 
 
 void luaC_collect (lua_State *L, int all) {
-  collectudata(L, 0);
-  collectstrings(L, all);
-  collecttable(L);
-  collectproto(L);
-  collectclosure(L);
+  global_State *g = G(L);
+  int i;
+  lua_assert(g->gcstate == GCSpause);
+  g->sweepudata = g->rootudata;
+  g->rootudata = NULL;
+  sweepudata(L, MAX_LUMEM, 0);
+  for (i=0; i<g->strt.size; i++)
+    sweepstrings(L, i, all);
+  checkstrings(L);
+  g->sweeptable = g->roottable;
+  g->roottable = NULL;
+  sweeptable(L, MAX_LUMEM);
+  g->sweepproto = g->rootproto;
+  g->rootproto = NULL;
+  sweepproto(L, MAX_LUMEM);
+  g->sweepcl = g->rootcl;
+  g->rootcl = NULL;
+  sweepclosure(L, MAX_LUMEM);
+}
+
+
+int luaC_step (lua_State *L, lu_mem limit) {
+  global_State *g = G(L);
+  lu_mem work = 0;
+  if (g->gcstate == GCSpause)
+    startcycle(L);
+  while (work < limit) {
+    switch (g->gcstate) {
+      case GCSpropagate:
+        if (g->cmark || g->tmark)
+          work += propagatemark(g);
+        else
+          atomic(L);
+        break;
+      case GCSsweepstring:
+        if (g->sweepstr < g->strt.size)
+          work += sweepstrings(L, g->sweepstr++, 0);
+        else {
+          checkstrings(L);
+          g->gcstate = GCSsweepudata;
+        }
+        break;
+      case GCSsweepudata:
+        work += sweepudata(L, limit-work, 0);
+        if (g->sweepudata == NULL) g->gcstate = GCSsweeptable;
+        break;
+      case GCSsweeptable:
+        work += sweeptable(L, limit-work);
+        if (g->sweeptable == NULL) g->gcstate = GCSsweepproto;
+        break;
+      case GCSsweepproto:
+        work += sweepproto(L, limit-work);
+        if (g->sweepproto == NULL) g->gcstate = GCSsweepclosure;
+        break;
+      case GCSsweepclosure:
+        work += sweepclosure(L, limit-work);
+        if (g->sweepcl == NULL) {  /* end of the cycle */
+          g->gcstate = GCSpause;
+          checkMbuffer(L);
+          g->GCthreshold = 2*g->nblocks;  /* new threshold */
+          callgcTMudata(L);
+          callgcTM(L, &luaO_nilobject);
+          return 1;
+        }
+        break;
+      default: lua_assert(0);
+    }
+  }
+  return 0;
 }
 
 
 void luaC_collectgarbage (lua_State *L) {
-  markall(L);
-  cleartables(G(L));
-  luaC_collect(L, 0);
-  checkMbuffer(L);
-  G(L)->GCthreshold = 2*G(L)->nblocks;  /* new threshold */
-  callgcTMudata(L);
-  callgcTM(L, &luaO_nilobject);
+  luaC_step(L, MAX_LUMEM);  /* a whole cycle, or the rest of the running one */
 }
 
 //ALBERTO
 void lua_getstatestats(lua_State *L,lua_StateStats *LSS)
 {
-	Proto *proto=L->G->rootproto;
-	Closure *closure=L->G->rootcl;
-	Hash *hash=L->G->roottable;
-  Udata *udata=L->G->rootudata;
+	int i;
 	LSS->nProto=0;
 	LSS->nClosure=0;
 	LSS->nHash=0;
 	LSS->nString=L->G->strt.nuse;
 	LSS->nUdata=0;
 
-	while(proto!=NULL)
-	{
-		LSS->nProto++;
-		proto=proto->next;
-	}
-	while(closure!=NULL)
-	{
-		LSS->nClosure++;
-		closure=closure->next;
-	}
-	while(hash!=NULL)
-	{
-		LSS->nHash++;
-		hash=hash->next;
-	}
-	while(udata!=NULL)
+	// the objects not swept yet are in the sweep lists
+	for(i=0;i<2;i++)
 	{
-		LSS->nUdata++;
-		udata=udata->uv.next;
+		Proto *proto=i?L->G->sweepproto:L->G->rootproto;
+		Closure *closure=i?L->G->sweepcl:L->G->rootcl;
+		Hash *hash=i?L->G->sweeptable:L->G->roottable;
+		Udata *udata=i?L->G->sweepudata:L->G->rootudata;
+
+		while(proto!=NULL)
+		{
+			LSS->nProto++;
+			proto=proto->next;
+		}
+		while(closure!=NULL)
+		{
+			LSS->nClosure++;
+			closure=closure->next;
+		}
+		while(hash!=NULL)
+		{
+			LSS->nHash++;
+			hash=hash->next;
+		}
+		while(udata!=NULL)
+		{
+			LSS->nUdata++;
+			udata=udata->uv.next;
+		}
 	}
 }
\ No newline at end of file
@@ -11,13 +11,28 @@
 #include "lobject.h"
 
 
+/* states of the incremental collector */
+#define GCSpause	0	/* no cycle running */
+#define GCSpropagate	1	/* marking */
+#define GCSsweepstring	2
+#define GCSsweepudata	3
+#define GCSsweeptable	4
+#define GCSsweepproto	5
+#define GCSsweepclosure	6
+
+
 #define luaC_checkGC(L) if (G(L)->nblocks >= G(L)->GCthreshold) \
 			  luaC_collectgarbage(L)
 
+/* to call before storing into a table */
+#define luaC_barriert(L,t) if ((t)->gcblack) luaC_barrierback(L,t)
+
 
 void luaC_callallgcTM (lua_State *L);
 void luaC_collect (lua_State *L, int all);
 void luaC_collectgarbage (lua_State *L);
+int luaC_step (lua_State *L, lu_mem limit);
+void luaC_barrierback (lua_State *L, Hash *h);
 
 
 #endif
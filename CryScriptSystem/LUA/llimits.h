@@ -58,6 +58,8 @@ typedef unsigned char lu_byte;
 
 #define MAX_SIZET	((size_t)(~(size_t)0)-2)
 
+#define MAX_LUMEM	((lu_mem)(~(lu_mem)0))
+
 
 #define MAX_INT (INT_MAX-2)  /* maximum value of an int (-2 for safety) */
 
@@ -185,6 +185,7 @@ typedef struct Hash {
   struct Hash *next;
   struct Hash *mark;  /* marked tables (point to itself when not marked) */
   int weakmode;
+  int gcblack;  /* traversed in the running GC cycle (see lgc.c) */
   void *nativedata;   // evil hack by alberto
 } Hash;
 
@@ -62,6 +62,16 @@ static void f_luaopen (lua_State *L, void *ud) {
     G(L)->sizeTM = 0;
     G(L)->ntag = 0;
     G(L)->nblocks = sizeof(lua_State) + sizeof(global_State);
+    G(L)->gcstate = GCSpause;
+    G(L)->tmark = NULL;
+    G(L)->cmark = NULL;
+    G(L)->grayagain = NULL;
+    G(L)->weak = NULL;
+    G(L)->sweepstr = 0;
+    G(L)->sweepudata = NULL;
+    G(L)->sweeptable = NULL;
+    G(L)->sweepproto = NULL;
+    G(L)->sweepcl = NULL;
     luaD_init(L, so->stacksize);  /* init stack */
     L->gt = luaH_new(L, 10);  /* table of globals */
     G(L)->type2tag = luaH_new(L, 10);
@@ -117,6 +127,8 @@ static void close_state (lua_State *L, lua_State *OL) {
     L->next->previous = L->previous;
   }
   else if (G(L)) {  /* last thread; close global state */
+    if (G(L)->gcstate != GCSpause)
+      luaC_collectgarbage(L);  /* finish the running cycle */
     luaC_callallgcTM(L);  /* call GC tag methods for all udata */
     luaC_collect(L, 1);  /* collect all elements */
     lua_assert(G(L)->rootproto == NULL);
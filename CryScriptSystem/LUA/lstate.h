@@ -70,6 +70,17 @@ typedef struct global_State {
   int ntag;  /* number of tags in TMtable */
   lu_mem GCthreshold;
   lu_mem nblocks;  /* number of `bytes' currently allocated */
+  /* incremental collector (see lgc.c) */
+  int gcstate;
+  Hash *tmark;  /* list of marked tables to be visited */
+  Closure *cmark;  /* list of marked closures to be visited */
+  Hash *grayagain;  /* traversed tables stored into, visited in the atomic step */
+  Hash *weak;  /* traversed weak tables */
+  int sweepstr;  /* next list of the string table to sweep */
+  Udata *sweepudata;  /* objects of the cycle not swept yet */
+  Hash *sweeptable;
+  Proto *sweepproto;
+  Closure *sweepcl;
 } global_State;
 
 
@@ -10,6 +10,7 @@
 #define LUA_PRIVATE
 #include "lua.h"
 
+#include "lgc.h"
 #include "lmem.h"
 #include "lobject.h"
 #include "lstate.h"
@@ -53,7 +54,8 @@ static TString *newlstr (lua_State *L, const l_char *str, size_t l, lu_hash h) {
   ts->tsv.nexthash = NULL;
   ts->tsv.len = l;
   ts->tsv.hash = h;
-  ts->tsv.marked = 0;
+  /* the hash lists not swept yet must not free it */
+  ts->tsv.marked = (G(L)->gcstate == GCSsweepstring);
   ts->tsv.constindex = 0;
   memcpy(getstr(ts), str, l*sizeof(l_char));
   getstr(ts)[l] = l_c('\0');  /* ending 0 */
@@ -62,7 +64,9 @@ static TString *newlstr (lua_State *L, const l_char *str, size_t l, lu_hash h) {
   ts->tsv.nexthash = tb->hash[h];  /* chain new entry */
   tb->hash[h] = ts;
   tb->nuse++;
-  if (tb->nuse > (ls_nstr)tb->size && tb->size <= MAX_INT/2)
+  /* no rehash while the hash lists are swept, it would mix swept and unswept strings */
+  if (tb->nuse > (ls_nstr)tb->size && tb->size <= MAX_INT/2 &&
+      G(L)->gcstate != GCSsweepstring)
     luaS_resize(L, tb->size*2);  /* too crowded */
   return ts;
 }
@@ -101,8 +105,12 @@ TString *luaS_newlstr (lua_State *L, const l_char *str, size_t l) {
   for (ts = G(L)->strt.hash[lmod(h, G(L)->strt.size)];
        ts != NULL;
        ts = ts->tsv.nexthash) {
-    if (ts->tsv.len == l && (memcmp(str, getstr(ts), l) == 0))
+    if (ts->tsv.len == l && (memcmp(str, getstr(ts), l) == 0)) {
+      /* may be dead, it is in use again */
+      if (G(L)->gcstate == GCSsweepstring && ts->tsv.marked == 0)
+        ts->tsv.marked = 1;
       return ts;
+    }
   }
   return newlstr(L, str, l, h);  /* not found */
 }
@@ -23,6 +23,7 @@
 #include "lua.h"
 
 #include "ldo.h"
+#include "lgc.h"
 #include "lmem.h"
 #include "lobject.h"
 #include "lstate.h"
@@ -118,6 +119,7 @@ Hash *luaH_new (lua_State *L, int size) {
   t->next = G(L)->roottable;
   G(L)->roottable = t;
   t->mark = t;
+  t->gcblack = 0;
   t->size = 0;
   t->weakmode = 0;
   t->node = NULL;
@@ -310,6 +312,7 @@ const TObject *luaH_get (Hash *t, const TObject *key) {
 
 TObject *luaH_set (lua_State *L, Hash *t, const TObject *key) {
   const TObject *p = luaH_get(t, key);
+  luaC_barriert(L, t);
   if (p != &luaO_nilobject) return (TObject *)p;
   else if (ttype(key) == LUA_TNIL) luaD_error(L, l_s("table index is nil"));
   return newkey(L, t, key);
@@ -318,6 +321,7 @@ TObject *luaH_set (lua_State *L, Hash *t, const TObject *key) {
 
 TObject *luaH_setstr (lua_State *L, Hash *t, TString *key) {
   const TObject *p = luaH_getstr(t, key);
+  luaC_barriert(L, t);
   if (p != &luaO_nilobject) return (TObject *)p;
   else {
     TObject k;
@@ -329,6 +333,7 @@ TObject *luaH_setstr (lua_State *L, Hash *t, TString *key) {
 
 TObject *luaH_setnum (lua_State *L, Hash *t, int key) {
   const TObject *p = luaH_getnum(t, key);
+  luaC_barriert(L, t);
   if (p != &luaO_nilobject) return (TObject *)p;
   else {
     TObject k;
@@ -51,6 +51,11 @@ typedef struct lua_State lua_State;
 
 typedef int (*lua_CFunction) (lua_State *L);
 
+/*
+** functions that write precompiled chunks (see lua_dump); return non-0 to stop
+*/
+typedef int (*lua_Chunkwriter) (lua_State *L, const void *p, size_t sz, void *ud);
+
 
 /*
 ** an invalid `tag'
@@ -203,6 +208,8 @@ LUA_API int   lua_loadbuffer (lua_State *L, const lua_char *buff, size_t size,
                             const lua_char *name);
 LUA_API int   lua_dobuffer (lua_State *L, const lua_char *buff, size_t size,
                             const lua_char *name);
+/* writes the Lua function on the top as precompiled chunk, loadable with lua_loadbuffer */
+LUA_API int   lua_dump (lua_State *L, lua_Chunkwriter writer, void *data);
 
 /*
 ** Garbage-collection functions
@@ -210,6 +217,16 @@ LUA_API int   lua_dobuffer (lua_State *L, const lua_char *buff, size_t size,
 LUA_API int   lua_getgcthreshold (lua_State *L);
 LUA_API int   lua_getgccount (lua_State *L);
 LUA_API void  lua_setgcthreshold (lua_State *L, int newthreshold);
+/* incremental collection: about nworkkb Kbytes of marking or sweeping, a cycle
+** is started if none is running; nworkkb<=0 only finishes the running cycle.
+** returns 1 if the cycle was finished */
+LUA_API int   lua_gcstep (lua_State *L, int nworkkb);
+LUA_API int   lua_getgcstate (lua_State *L);
+
+/* lua_getgcstate */
+#define LUA_GCIDLE	0
+#define LUA_GCMARK	1
+#define LUA_GCSWEEP	2
 
 /*
 ** miscellaneous functions
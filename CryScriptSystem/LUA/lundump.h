@@ -16,6 +16,9 @@ Proto* luaU_undump (lua_State* L, ZIO* Z);
 /* find byte order */
 int luaU_endianness (void);
 
+/* dump one chunk (ldump.c) */
+int luaU_dump (lua_State* L, const Proto* Main, lua_Chunkwriter w, void* data);
+
 /* definitions for headers of binary files */
 #define	VERSION		0x41		/* last format change was in 4.1 */
 #define	VERSION0	0x41		/* last major  change was in 4.1 */
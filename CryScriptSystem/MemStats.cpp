@@ -50,13 +50,18 @@ void CScriptSystem::GetMemoryStatistics(ICrySizer *pSizer)
 	//////////////////////////////////////////////////////////////////////////
 
 
+	// a running incremental cycle only gets its usual bounded step (lua_GCStepSize), it isn't finished
+	// here. During the sweep the objects are spread over the root lists (new and swept ones) and the
+	// sweep lists, both are walked
+	GarbageCollectionStep(false);
+	global_State *G=m_pLS->G;
 	lua_StateStats lss;
 	lua_StateStats *LSS=&lss;
-	Proto *proto=m_pLS->G->rootproto;
-	Closure *closure=m_pLS->G->rootcl;
-	Hash *hash=m_pLS->G->roottable;
-	Udata *udata=m_pLS->G->rootudata;
-	TString *string=m_pLS->G->strt.hash[0];
+	Proto *proto=G->rootproto;
+	Closure *closure=G->rootcl;
+	Hash *hash=G->roottable;
+	Udata *udata=G->rootudata;
+	TString *string=G->strt.hash[0];
 
 	LSS->nProto=0;
 	LSS->nProtoMem=0;
@@ -75,6 +80,7 @@ void CScriptSystem::GetMemoryStatistics(ICrySizer *pSizer)
 /////BYTECODE////////////////////////////////////////////
 	{
 		SIZER_SUBCOMPONENT_NAME(pSizer,"Bytecode");
+		for(int nList=0;nList<2;nList++,proto=G->sweepproto)
 		while(proto!=NULL)
 		{
 			LSS->nProto++;
@@ -87,7 +93,7 @@ void CScriptSystem::GetMemoryStatistics(ICrySizer *pSizer)
 #endif
 			proto=proto->next;
 		}
-		pSizer->AddObject(m_pLS->G->rootproto,LSS->nProtoMem);
+		pSizer->AddObject(G->rootproto ? G->rootproto : G->sweepproto,LSS->nProtoMem);
 	}
 #ifdef TRACE_TO_FILE
 	if(f)fclose(f);
@@ -95,18 +101,20 @@ void CScriptSystem::GetMemoryStatistics(ICrySizer *pSizer)
 	/////FUNCTIONS/////////////////////////////////////////
 	{
 		SIZER_SUBCOMPONENT_NAME(pSizer,"Functions");
+		for(int nList=0;nList<2;nList++,closure=G->sweepcl)
 		while(closure!=NULL)
 		{
 			LSS->nClosure++;
 			LSS->nClosureMem+=calcclosuresize(closure->nupvalues);
 			closure=closure->next;
 		}
-		pSizer->AddObject(m_pLS->G->rootcl,LSS->nClosureMem);
+		pSizer->AddObject(G->rootcl ? G->rootcl : G->sweepcl,LSS->nClosureMem);
 	}
 	/////TABLES/////////////////////////////////////////
 	{
 		int maxsize=0;
 		int size=0;
+		for(int nList=0;nList<2;nList++,hash=G->sweeptable)
 		while(hash!=NULL)
 		{
 			LSS->nHash++;
@@ -117,18 +125,19 @@ void CScriptSystem::GetMemoryStatistics(ICrySizer *pSizer)
 		}
 		char ctemp[200]="Unknown";
 		SIZER_SUBCOMPONENT_NAME(pSizer,ctemp);
-		pSizer->AddObject(m_pLS->G->roottable,LSS->nHashMem);
+		pSizer->AddObject(G->roottable ? G->roottable : G->sweeptable,LSS->nHashMem);
 	}
 	/////USERDATA///////////////////////////////////////
 	{
 		SIZER_SUBCOMPONENT_NAME(pSizer,"User Data");
+		for(int nList=0;nList<2;nList++,udata=G->sweepudata)
 		while(udata!=NULL)
 		{
 			LSS->nUdata++;
 			LSS->nUdataMem+=sizeudata(udata->uv.len);
 			udata=udata->uv.next;
 		}
-		pSizer->AddObject(m_pLS->G->rootudata,LSS->nUdataMem);
+		pSizer->AddObject(G->rootudata ? G->rootudata : G->sweepudata,LSS->nUdataMem);
 	}
 	/////STRINGS///////////////////////////////////////
 	{
@@ -196,13 +196,152 @@ void CScriptObject::EndSetGetChain()
 	}
 }
 
-void CScriptObject::SetValueChain(const char *sKey, int nVal)
+//////////////////////////////////////////////////////////////////////
+inline void CScriptObject::PushKey(const char *sKey)
 {
 	lua_pushstring(m_pLS, sKey);
+}
+
+// the registry lookup is a number index, the key string isn't hashed again
+inline void CScriptObject::PushKey(const ScriptKey &key)
+{
+	if (!lua_getref(m_pLS, key.nRef))
+	{
+		// a nil key would raise a lua error in the raw get/set
+		assert(0 && "ScriptKey not created or released");
+		lua_pushstring(m_pLS, "");
+	}
+}
+
+template <class Key> void CScriptObject::SetValueChainT(const Key &key, int nVal)
+{
+	PushKey(key);
 	lua_pushnumber(m_pLS, (lua_Number)nVal);
 	SET_FUNCTION(m_pLS, - 3);
 }
 
+template <class Key> void CScriptObject::SetValueChainT(const Key &key, float fVal)
+{
+	PushKey(key);
+	lua_pushnumber(m_pLS, fVal);
+	SET_FUNCTION(m_pLS, - 3);
+}
+
+template <class Key> void CScriptObject::SetValueChainT(const Key &key, bool bVal)
+{
+	PushKey(key);
+	if (bVal)
+		lua_pushnumber(m_pLS, 1);
+	else
+		lua_pushnil(m_pLS);
+	SET_FUNCTION(m_pLS, - 3);
+}
+
+template <class Key> void CScriptObject::SetValueChainT(const Key &key, const char *sVal)
+{
+	PushKey(key);
+	lua_pushstring(m_pLS, sVal);
+	SET_FUNCTION(m_pLS, - 3);
+}
+
+template <class Key> void CScriptObject::SetValueChainT(const Key &key, IScriptObject *pObj)
+{
+	PushKey(key);
+	if (!pObj)	
+	{
+		CryWarning( VALIDATOR_MODULE_GAME,VALIDATOR_WARNING,"\001 ERROR! Passing NULL IScriptObject to SETVALUE CHAIN!");
+#if defined(_DEBUG) && !defined(WIN64)
+		DEBUG_BREAK;
+#endif
+		lua_pushnil(m_pLS);
+	}
+	else
+	  lua_xgetref(m_pLS, pObj->GetRef());
+	SET_FUNCTION(m_pLS, - 3);
+}
+
+template <class Key> bool CScriptObject::GetValueChainT(const Key &key, int &nVal)
+{
+	_GUARD_STACK(m_pLS);
+	bool res=false;
+	PushKey(key);
+	GET_FUNCTION(m_pLS, - 2);
+	if (lua_isnumber(m_pLS, - 1))
+	{
+		res = true;
+		nVal =(int)lua_tonumber(m_pLS, - 1);
+	}
+	return res;
+}
+
+template <class Key> bool CScriptObject::GetValueChainT(const Key &key, float &fVal)
+{
+	_GUARD_STACK(m_pLS);
+	bool res=false;
+	PushKey(key);
+	GET_FUNCTION(m_pLS, - 2);
+	if (lua_isnumber(m_pLS, - 1))
+	{
+		res = true;
+		fVal =(float)lua_tonumber(m_pLS, - 1);
+	}
+	return res;
+}
+
+template <class Key> bool CScriptObject::GetValueChainT(const Key &key, bool &bVal)
+{
+	_GUARD_STACK(m_pLS);
+	bool res=false;
+	PushKey(key);
+	GET_FUNCTION(m_pLS, - 2);
+	if (lua_isnil(m_pLS, - 1))
+	{
+		res = true;
+		bVal = false;
+	}
+	else if (lua_isnumber(m_pLS, - 1))
+	{
+		res = true;
+		bVal = ((int)lua_tonumber(m_pLS, - 1))!=0;
+	}
+	return res;
+}
+
+template <class Key> bool CScriptObject::GetValueChainT(const Key &key, const char* &sVal)
+{
+	_GUARD_STACK(m_pLS);
+	bool res=false;
+	PushKey(key);
+	GET_FUNCTION(m_pLS, - 2);
+	if (lua_isstring(m_pLS, - 1))
+	{
+		res = true;
+		sVal =(char *)lua_tostring(m_pLS, - 1);
+	}
+	return res;
+}
+
+template <class Key> bool CScriptObject::GetValueChainT(const Key &key, IScriptObject *pObj)
+{
+	_GUARD_STACK(m_pLS);
+	bool res=false;
+	PushKey(key);
+	GET_FUNCTION(m_pLS, - 2);
+	if (lua_istable(m_pLS, - 1))
+	{
+		res = true;
+		lua_pushvalue(m_pLS, - 1);
+		pObj->Attach();
+	}
+	return res;
+}
+
+//////////////////////////////////////////////////////////////////////
+void CScriptObject::SetValueChain(const char *sKey, int nVal)
+{
+	SetValueChainT(sKey,nVal);
+}
+
 void CScriptObject::SetValue(const char *sKey, int nVal)
 {
 	_GUARD_STACK(m_pLS);
@@ -215,9 +354,7 @@ void CScriptObject::SetValue(const char *sKey, int nVal)
 
 void CScriptObject::SetValueChain(const char *sKey, float fVal)
 {
-	lua_pushstring(m_pLS, sKey);
-	lua_pushnumber(m_pLS, fVal);
-	SET_FUNCTION(m_pLS, - 3);
+	SetValueChainT(sKey,fVal);
 }
 
 void CScriptObject::SetValue(const char *sKey, float fVal)
@@ -231,12 +368,7 @@ void CScriptObject::SetValue(const char *sKey, float fVal)
 
 void CScriptObject::SetValueChain(const char *sKey, bool bVal)
 {
-  lua_pushstring(m_pLS, sKey);
-	if (bVal)
-		lua_pushnumber(m_pLS, 1);
-	else
-		lua_pushnil(m_pLS);
-	SET_FUNCTION(m_pLS, - 3);
+	SetValueChainT(sKey,bVal);
 }
 
 void CScriptObject::SetValue(const char *sKey, bool bVal)
@@ -250,9 +382,7 @@ void CScriptObject::SetValue(const char *sKey, bool bVal)
 
 void CScriptObject::SetValueChain(const char *sKey, const char *sVal)
 {
-		lua_pushstring(m_pLS, sKey);
-		lua_pushstring(m_pLS, sVal);
-		SET_FUNCTION(m_pLS, - 3);
+	SetValueChainT(sKey,sVal);
 }
 
 void CScriptObject::SetValue(const char *sKey, const char *sVal)
@@ -265,18 +395,7 @@ void CScriptObject::SetValue(const char *sKey, const char *sVal)
 
 void CScriptObject::SetValueChain(const char *sKey, IScriptObject *pObj)
 { 
-	lua_pushstring(m_pLS, sKey);
-	if (!pObj)	
-	{
-		CryWarning( VALIDATOR_MODULE_GAME,VALIDATOR_WARNING,"\001 ERROR! Passing NULL IScriptObject to SETVALUE CHAIN!");
-#if defined(_DEBUG) && !defined(WIN64)
-		DEBUG_BREAK;
-#endif
-		lua_pushnil(m_pLS);
-	}
-	else
-	  lua_xgetref(m_pLS, pObj->GetRef());
-	SET_FUNCTION(m_pLS, - 3);
+	SetValueChainT(sKey,pObj);
 }
 
 void CScriptObject::SetValue(const char *sKey, IScriptObject *pObj)
@@ -328,16 +447,7 @@ void CScriptObject::SetToNull(const char *sKey)
 
 bool CScriptObject::GetValueChain(const char *sKey, int &nVal)
 {
-	_GUARD_STACK(m_pLS);
-	bool res=false;
-	lua_pushstring(m_pLS, sKey);
-	GET_FUNCTION(m_pLS, - 2);
-	if (lua_isnumber(m_pLS, - 1))
-	{
-		res = true;
-		nVal =(int)lua_tonumber(m_pLS, - 1);
-	}
-	return res;
+	return GetValueChainT(sKey,nVal);
 }
 
 bool CScriptObject::GetValue(const char *sKey, int &nVal)
@@ -379,27 +489,7 @@ bool CScriptObject::GetValue(const char *sKey, HSCRIPTFUNCTION &funcVal)
 
 bool CScriptObject::GetValueChain(const char *sKey, bool &bVal)
 {
-	_GUARD_STACK(m_pLS);
-	int nVal;
-	bool res;
-	lua_pushstring(m_pLS, sKey);
-	GET_FUNCTION(m_pLS, - 2);
-	if (lua_isnil(m_pLS, - 1))
-	{
-		res = true;
-		bVal = false;
-	}
-	else if (lua_isnumber(m_pLS, - 1))
-	{
-		res = true;
-		nVal =(int)lua_tonumber(m_pLS, - 1);
-		if (nVal)
-			bVal = true;
-		else
-			bVal = false;
-	}
-	
-	return res;
+	return GetValueChainT(sKey,bVal);
 }
 
 bool CScriptObject::GetValue(const char *sKey, bool &bVal)
@@ -418,17 +508,7 @@ bool CScriptObject::GetValue(const char *sKey, bool &bVal)
 
 bool CScriptObject::GetValueChain(const char *sKey, float &fVal)
 {
-	_GUARD_STACK(m_pLS);
-	bool res=false;
-	lua_pushstring(m_pLS, sKey);
-	GET_FUNCTION(m_pLS, - 2);
-	if (lua_isnumber(m_pLS, - 1))
-	{
-		res = true;
-		fVal =(float)lua_tonumber(m_pLS, - 1);
-	}
-	
-	return res;
+	return GetValueChainT(sKey,fVal);
 }
 
 bool CScriptObject::GetValue(const char *sKey, float &fVal)
@@ -443,17 +523,7 @@ bool CScriptObject::GetValue(const char *sKey, float &fVal)
 
 bool CScriptObject::GetValueChain(const char *sKey, const char* &sVal)
 {
-	_GUARD_STACK(m_pLS);
-	bool res=false;
-	lua_pushstring(m_pLS, sKey);
-	GET_FUNCTION(m_pLS, - 2);
-	if (lua_isstring(m_pLS, - 1))
-	{
-		res = true;
-		sVal =(char *)lua_tostring(m_pLS, - 1);
-	}
-	
-	return res;
+	return GetValueChainT(sKey,sVal);
 }
 
 bool CScriptObject::GetValue(const char *sKey, const char* &sVal)
@@ -469,18 +539,7 @@ bool CScriptObject::GetValue(const char *sKey, const char* &sVal)
 
 bool CScriptObject::GetValueChain(const char *sKey, IScriptObject *pObj)
 {
-	_GUARD_STACK(m_pLS);
-	bool res=false;
-	lua_pushstring(m_pLS, sKey);
-	GET_FUNCTION(m_pLS, - 2);
-	if (lua_istable(m_pLS, - 1))
-	{
-		res = true;
-		lua_pushvalue(m_pLS, - 1);
-		pObj->Attach();
-	}
-	
-	return res;
+	return GetValueChainT(sKey,pObj);
 }
 
 bool CScriptObject::GetValue(const char *sKey, IScriptObject *pObj)
@@ -493,6 +552,139 @@ bool CScriptObject::GetValue(const char *sKey, IScriptObject *pObj)
 	return res;
 }
 
+//////////////////////////////////////////////////////////////////////
+// interned keys
+//////////////////////////////////////////////////////////////////////
+void CScriptObject::SetValueChain(const ScriptKey &key, int nVal)
+{
+	SetValueChainT(key,nVal);
+}
+
+void CScriptObject::SetValue(const ScriptKey &key, int nVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return;
+	SetValueChainT(key,nVal);
+}
+
+void CScriptObject::SetValueChain(const ScriptKey &key, float fVal)
+{
+	SetValueChainT(key,fVal);
+}
+
+void CScriptObject::SetValue(const ScriptKey &key, float fVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return;
+	SetValueChainT(key,fVal);
+}
+
+void CScriptObject::SetValueChain(const ScriptKey &key, const char *sVal)
+{
+	SetValueChainT(key,sVal);
+}
+
+void CScriptObject::SetValue(const ScriptKey &key, const char *sVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return;
+	SetValueChainT(key,sVal);
+}
+
+void CScriptObject::SetValueChain(const ScriptKey &key, bool bVal)
+{
+	SetValueChainT(key,bVal);
+}
+
+void CScriptObject::SetValue(const ScriptKey &key, bool bVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return;
+	SetValueChainT(key,bVal);
+}
+
+void CScriptObject::SetValueChain(const ScriptKey &key, IScriptObject *pObj)
+{
+	SetValueChainT(key,pObj);
+}
+
+void CScriptObject::SetValue(const ScriptKey &key, IScriptObject *pObj)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return;
+	SetValueChainT(key,pObj);
+}
+
+bool CScriptObject::GetValueChain(const ScriptKey &key, int &nVal)
+{
+	return GetValueChainT(key,nVal);
+}
+
+bool CScriptObject::GetValue(const ScriptKey &key, int &nVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return false;
+	return GetValueChainT(key,nVal);
+}
+
+bool CScriptObject::GetValueChain(const ScriptKey &key, float &fVal)
+{
+	return GetValueChainT(key,fVal);
+}
+
+bool CScriptObject::GetValue(const ScriptKey &key, float &fVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return false;
+	return GetValueChainT(key,fVal);
+}
+
+bool CScriptObject::GetValueChain(const ScriptKey &key, const char* &sVal)
+{
+	return GetValueChainT(key,sVal);
+}
+
+bool CScriptObject::GetValue(const ScriptKey &key, const char* &sVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return false;
+	return GetValueChainT(key,sVal);
+}
+
+bool CScriptObject::GetValueChain(const ScriptKey &key, bool &bVal)
+{
+	return GetValueChainT(key,bVal);
+}
+
+bool CScriptObject::GetValue(const ScriptKey &key, bool &bVal)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return false;
+	return GetValueChainT(key,bVal);
+}
+
+bool CScriptObject::GetValueChain(const ScriptKey &key, IScriptObject *pObj)
+{
+	return GetValueChainT(key,pObj);
+}
+
+bool CScriptObject::GetValue(const ScriptKey &key, IScriptObject *pObj)
+{
+	_GUARD_STACK(m_pLS);
+	if (!_GET_THIS())
+		return false;
+	return GetValueChainT(key,pObj);
+}
+
 bool CScriptObject::GetValueRecursive( const char *szPath, IScriptObject *pObj )
 {
 	assert(pObj);
@@ -111,6 +111,26 @@ public:
 	virtual void Detach();
 	virtual void Release();
 	virtual bool GetValueRecursive( const char *szPath, IScriptObject *pObj );
+	virtual void SetValue(const ScriptKey &key, int nVal);
+	virtual void SetValue(const ScriptKey &key, float fVal);
+	virtual void SetValue(const ScriptKey &key, const char *sVal);
+	virtual void SetValue(const ScriptKey &key, bool bVal);
+	virtual void SetValue(const ScriptKey &key, IScriptObject *pObj);
+	virtual bool GetValue(const ScriptKey &key, int &nVal);
+	virtual bool GetValue(const ScriptKey &key, float &fVal);
+	virtual bool GetValue(const ScriptKey &key, bool &bVal);
+	virtual bool GetValue(const ScriptKey &key, const char* &sVal);
+	virtual bool GetValue(const ScriptKey &key, IScriptObject *pObj);
+	virtual void SetValueChain(const ScriptKey &key, int nVal);
+	virtual void SetValueChain(const ScriptKey &key, float fVal);
+	virtual void SetValueChain(const ScriptKey &key, const char *sVal);
+	virtual void SetValueChain(const ScriptKey &key, bool bVal);
+	virtual void SetValueChain(const ScriptKey &key, IScriptObject *pObj);
+	virtual bool GetValueChain(const ScriptKey &key, int &nVal);
+	virtual bool GetValueChain(const ScriptKey &key, float &fVal);
+	virtual bool GetValueChain(const ScriptKey &key, bool &bVal);
+	virtual bool GetValueChain(const ScriptKey &key, const char* &sVal);
+	virtual bool GetValueChain(const ScriptKey &key, IScriptObject *pObj);
 
 	// --------------------------------------------------------------------------
 
@@ -129,6 +149,20 @@ private: // -------------------------------------------------------------------
 	static int IndexTagHandler(lua_State *L);
 	//!
 	int GetThisRef();
+	//! pushes the key of a raw get/set
+	void PushKey(const char *sKey);
+	void PushKey(const ScriptKey &key);
+	//! the chain functions for both kinds of keys, the table is on the top of the stack
+	template <class Key> void SetValueChainT(const Key &key, int nVal);
+	template <class Key> void SetValueChainT(const Key &key, float fVal);
+	template <class Key> void SetValueChainT(const Key &key, bool bVal);
+	template <class Key> void SetValueChainT(const Key &key, const char *sVal);
+	template <class Key> void SetValueChainT(const Key &key, IScriptObject *pObj);
+	template <class Key> bool GetValueChainT(const Key &key, int &nVal);
+	template <class Key> bool GetValueChainT(const Key &key, float &fVal);
+	template <class Key> bool GetValueChainT(const Key &key, bool &bVal);
+	template <class Key> bool GetValueChainT(const Key &key, const char* &sVal);
+	template <class Key> bool GetValueChainT(const Key &key, IScriptObject *pObj);
 
 	struct SetGetParams
 	{
@@ -15,6 +15,7 @@
 #include <ICryPak.h>
 #include <IConsole.h>
 #include <ILog.h>
+#include <ITimer.h>
 #include <IDataProbe.h>
 
 extern "C"
@@ -75,6 +76,29 @@ sprintf(sTemp, "STACK=%d\n", __nStack); \
 static int I = 0;
 extern "C" int g_dumpStackOnAlloc = 0; // used in .c file.
 
+// 0=off, 1=load and update the script cache, 2=only load
+static int g_nScriptCache = 1;
+
+// incremental garbage collection, the work of a step is in Kb of the heap
+static int g_nIncrementalGC = 0;
+static int g_nGCStepSize = 256;
+
+// the precompiled chunks are stored in the cache directory (or a pak with it) under the script path,
+// they are only used when the source they were compiled from has the same size and hash
+#define SCRIPT_CACHE_DIR				"ScriptCache"
+#define SCRIPT_CACHE_SIGNATURE	"CLBC"
+// increase when the format of the chunks or of the header changes
+#define SCRIPT_CACHE_VERSION		1
+
+struct SScriptCacheHeader
+{
+	char					sSignature[4];
+	unsigned int	nVersion;
+	unsigned int	nSourceSize;
+	unsigned int	nSourceHash;
+	unsigned int	nCodeSize;
+};
+
 //static int64 g_numScriptSystemValidations = 0;
 
 inline void CScriptSystem::Validate()
@@ -358,6 +382,18 @@ CScriptSystem::CScriptSystem()
 	m_nGCTag=0;
 	m_bsBreakState=bsNoBreak;
 	m_BreakPoint.nLine=0;
+	m_nScriptCacheHits=0;
+	m_nScriptCacheMisses=0;
+	m_bScriptCacheDirCreated=false;
+	m_nGCCycles=0;
+	m_nGCLastStepCount=0;
+	m_fGCLastStepTime=0;
+	m_fGCMaxStepTime=0;
+	m_nGCSteps=0;
+	m_fGCTotalStepTime=0;
+	m_nGCPauses=0;
+	m_fGCLastPauseTime=0;
+	m_fGCMaxPauseTime=0;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -434,6 +470,10 @@ bool CScriptSystem::Init(IScriptSystemSink *pSink, IScriptDebugSink *pDebugSink,
 	RegisterErrorHandler(m_bDebug);
 	RegisterTagHandlers();
 
+	m_vecKeys[0]=CreateKey("x");
+	m_vecKeys[1]=CreateKey("y");
+	m_vecKeys[2]=CreateKey("z");
+
 	//initvectortag(m_pLS);
 	return m_pLS?true:false;
 }
@@ -446,6 +486,18 @@ void CScriptSystem::PostInit()
 	if (GetISystem()->GetIConsole())
 	{
 		GetISystem()->GetIConsole()->Register( "lua_stackonmalloc",&g_dumpStackOnAlloc,0 );
+		GetISystem()->GetIConsole()->Register( "lua_ScriptCache",&g_nScriptCache,1,VF_DUMPTODISK,
+			"Loads the script files precompiled from the ScriptCache directory when they didn't change.\n"
+			"Usage: lua_ScriptCache [0/1/2]\n"
+			"0=compile the sources, 1=use and update the cache (default), 2=only use the cache" );
+		GetISystem()->GetIConsole()->Register( "lua_IncrementalGC",&g_nIncrementalGC,0,VF_DUMPTODISK,
+			"Spreads the lua garbage collection over the frames instead of stopping for a whole cycle.\n"
+			"Usage: lua_IncrementalGC [0/1]\n"
+			"0=full collections (default), 1=incremental steps of lua_GCStepSize" );
+		GetISystem()->GetIConsole()->Register( "lua_GCStepSize",&g_nGCStepSize,256,VF_DUMPTODISK,
+			"Kb of the lua heap marked or swept per frame by the incremental garbage collection,\n"
+			"twice the Kb allocated since the last step are added so the collection keeps up.\n"
+			"Usage: lua_GCStepSize 256" );
 	}
 }
 
@@ -894,6 +946,7 @@ bool CScriptSystem::_ExecuteFile(const char *sFileName, bool bRaiseError)
 	fclose(pFile);
 #endif		
 */
+	bool bEncrypted = false;
 	char script_decr_key[32] = "3CE2698701289029F3926DF0191189A";
 	//////////////////////////////////////////////////////////////////////////
 	// Check if it is encrypted script.
@@ -905,6 +958,7 @@ bool CScriptSystem::_ExecuteFile(const char *sFileName, bool bRaiseError)
 		{
 			// Decrypt this buffer.
 			GetISystem()->GetIDataProbe()->AESDecryptBuffer( pBuffer,nSize,pBuffer,nSize,script_decr_key );
+			bEncrypted = true;
 		}
 	}
 	//////////////////////////////////////////////////////////////////////////
@@ -919,7 +973,10 @@ bool CScriptSystem::_ExecuteFile(const char *sFileName, bool bRaiseError)
 	szFileName[0] = '@';
 	strcpy(&szFileName[1], sFileName);
 
-	int nRes=lua_dobuffer(m_pLS,pBuffer,nSize,/*sFileName*/ szFileName);
+	// the chunks of encrypted scripts are not written to the cache in the clear
+	int nRes=LoadScriptChunk(sFileName,szFileName,pBuffer,nSize,!bEncrypted);
+	if (nRes==0)
+		nRes=lua_call(m_pLS,0,LUA_MULTRET);
 
 	delete [] pBuffer;
 
@@ -934,6 +991,152 @@ bool CScriptSystem::_ExecuteFile(const char *sFileName, bool bRaiseError)
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////
+static unsigned int HashScriptSource(const char *pSource,int nSize)
+{
+	// FNV-1a
+	unsigned int nHash = 2166136261u;
+	for (int i=0;i<nSize;i++)
+		nHash = (nHash ^ (unsigned char)pSource[i]) * 16777619u;
+	return nHash;
+}
+
+//////////////////////////////////////////////////////////////////////
+// scripts/default/entities/door.lua -> ScriptCache/scripts_default_entities_door.lua.lbc
+static string GetScriptCacheFileName(const char *sFileName)
+{
+	string sCacheFile = SCRIPT_CACHE_DIR "/";
+	for (const char *p=sFileName;*p;p++)
+	{
+		if (*p=='/' || *p=='\\' || *p==':')
+			sCacheFile += '_';
+		else
+			sCacheFile += (char)tolower(*p);
+	}
+	sCacheFile += ".lbc";
+	return sCacheFile;
+}
+
+//////////////////////////////////////////////////////////////////////
+static int ScriptCacheWriter(lua_State *L,const void *p,size_t sz,void *ud)
+{
+	std::vector<char> *pCode = (std::vector<char>*)ud;
+	pCode->insert(pCode->end(),(const char*)p,(const char*)p+sz);
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+int CScriptSystem::LoadScriptChunk(const char *sFileName,const char *sChunkName,const char *pSource,int nSize,bool bWriteCache)
+{
+	// already precompiled sources are loaded as they are
+	if (!g_nScriptCache || pSource[0]=='\033')
+		return lua_loadbuffer(m_pLS,pSource,nSize,sChunkName);
+
+	ICryPak *pPak=GetISystem()->GetIPak();
+	unsigned int nHash = HashScriptSource(pSource,nSize);
+	string sCacheFile = GetScriptCacheFileName(sFileName);
+
+	FILE *pFile = pPak->FOpen(sCacheFile.c_str(),"rb");
+	if (pFile)
+	{
+		SScriptCacheHeader header;
+		bool bValid = pPak->FRead(&header,sizeof(header),1,pFile)==1
+			&& memcmp(header.sSignature,SCRIPT_CACHE_SIGNATURE,sizeof(header.sSignature))==0
+			&& header.nVersion==SCRIPT_CACHE_VERSION
+			&& header.nSourceSize==(unsigned int)nSize
+			&& header.nSourceHash==nHash
+			&& header.nCodeSize>0;
+
+		if (bValid)
+		{
+			char *pCode = new char[header.nCodeSize];
+			bValid = pPak->FRead(pCode,header.nCodeSize,1,pFile)==1
+				&& lua_loadbuffer(m_pLS,pCode,header.nCodeSize,sChunkName)==0;
+			delete [] pCode;
+		}
+		pPak->FClose(pFile);
+
+		if (bValid)
+		{
+			m_nScriptCacheHits++;
+			return 0;
+		}
+	}
+
+	m_nScriptCacheMisses++;
+	int nRes=lua_loadbuffer(m_pLS,pSource,nSize,sChunkName);
+	if (nRes==0 && bWriteCache && g_nScriptCache==1)
+		WriteScriptCache(sCacheFile.c_str(),nSize,nHash);
+	return nRes;
+}
+
+//////////////////////////////////////////////////////////////////////
+void CScriptSystem::WriteScriptCache(const char *sCacheFile,int nSourceSize,unsigned int nSourceHash)
+{
+	std::vector<char> arrCode;
+	if (lua_dump(m_pLS,ScriptCacheWriter,&arrCode) || arrCode.empty())
+		return;
+
+	ICryPak *pPak=GetISystem()->GetIPak();
+	if (!m_bScriptCacheDirCreated)
+	{
+		pPak->MakeDir(SCRIPT_CACHE_DIR);
+		m_bScriptCacheDirCreated=true;
+	}
+
+	FILE *pFile = pPak->FOpen(sCacheFile,"wb");
+	if (!pFile)
+		return;
+
+	SScriptCacheHeader header;
+	memcpy(header.sSignature,SCRIPT_CACHE_SIGNATURE,sizeof(header.sSignature));
+	header.nVersion=SCRIPT_CACHE_VERSION;
+	header.nSourceSize=(unsigned int)nSourceSize;
+	header.nSourceHash=nSourceHash;
+	header.nCodeSize=(unsigned int)arrCode.size();
+
+	if (pPak->FWrite(&header,sizeof(header),1,pFile)!=1
+		|| pPak->FWrite(&arrCode[0],arrCode.size(),1,pFile)!=1)
+	{
+		// a broken header is not accepted, but a short chunk would be
+		pPak->FSeek(pFile,0,SEEK_SET);
+		memset(&header,0,sizeof(header));
+		pPak->FWrite(&header,sizeof(header),1,pFile);
+	}
+	pPak->FClose(pFile);
+}
+
+//////////////////////////////////////////////////////////////////////
+void CScriptSystem::GetScriptCacheStats( int &nHits,int &nMisses,bool bReset )
+{
+	nHits=m_nScriptCacheHits;
+	nMisses=m_nScriptCacheMisses;
+	if (bReset)
+	{
+		m_nScriptCacheHits=0;
+		m_nScriptCacheMisses=0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// the string is locked in the registry, pushing it back is a number index
+// instead of hashing and interning the key string on every access
+ScriptKey CScriptSystem::CreateKey(const char *sKey)
+{
+	ScriptKey key;
+	lua_pushstring(m_pLS,sKey);
+	key.nRef=lua_ref(m_pLS,1);
+	return key;
+}
+
+//////////////////////////////////////////////////////////////////////
+void CScriptSystem::ReleaseKey(ScriptKey &key)
+{
+	if (key.IsValid() && m_pLS)
+		lua_unref(m_pLS,key.nRef);
+	key.nRef=0;
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 bool CScriptSystem::ExecuteFile(const char *sFileName, bool bRaiseError,bool bForceReload)
@@ -1653,9 +1856,20 @@ void CScriptSystem::ForceGarbageCollection()
 	OutputDebugString("BEFORE GC STATS :");
 	OutputDebugString(sTemp);*/
 
+	ITimer *pTimer=GetISystem()->GetITimer();
+	float fStart=pTimer->GetAsyncCurTime();
+
 	Validate();
+	// a running incremental cycle is finished first, it keeps what was alive when it started
+	if (lua_getgcstate(m_pLS)!=LUA_GCIDLE)
+		lua_gcstep(m_pLS, 0);
 	lua_setgcthreshold(m_pLS, 0);
 	Validate();
+
+	m_nGCPauses++;
+	m_fGCLastPauseTime=(pTimer->GetAsyncCurTime()-fStart)*1000.0f;
+	if (m_fGCLastPauseTime>m_fGCMaxPauseTime)
+		m_fGCMaxPauseTime=m_fGCLastPauseTime;
 	/*lua_getstatestats(m_pLS,&lss);
 	sprintf(sTemp,"protos=%d closures=%d tables=%d udata=%d strings=%d\n",lss.nProto,lss.nClosure,lss.nHash,lss.nUdata,lss.nString);
 	OutputDebugString("AFTER GC STATS :");
@@ -1663,6 +1877,68 @@ void CScriptSystem::ForceGarbageCollection()
 
 }
 
+//////////////////////////////////////////////////////////////////////
+// the work of a step grows with the allocations since the last one, otherwise
+// scripts that allocate faster than lua_GCStepSize would never let a cycle finish
+bool CScriptSystem::GarbageCollectionStep(bool bStartCycle)
+{
+	if (!g_nIncrementalGC)
+		return false;
+
+	int nCount=lua_getgccount(m_pLS);
+
+	if (!bStartCycle && lua_getgcstate(m_pLS)==LUA_GCIDLE)
+	{
+		m_nGCLastStepCount=nCount;
+		return true;
+	}
+
+	int nWork=g_nGCStepSize>0 ? g_nGCStepSize : 1;
+	if (nCount>m_nGCLastStepCount)
+		nWork+=2*(nCount-m_nGCLastStepCount);
+
+	ITimer *pTimer=GetISystem()->GetITimer();
+	float fStart=pTimer->GetAsyncCurTime();
+
+	Validate();
+	if (lua_gcstep(m_pLS, nWork))
+		m_nGCCycles++;
+	Validate();
+
+	m_nGCSteps++;
+	m_fGCLastStepTime=(pTimer->GetAsyncCurTime()-fStart)*1000.0f;
+	m_fGCTotalStepTime+=m_fGCLastStepTime;
+	if (m_fGCLastStepTime>m_fGCMaxStepTime)
+		m_fGCMaxStepTime=m_fGCLastStepTime;
+	m_nGCLastStepCount=lua_getgccount(m_pLS);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+void CScriptSystem::GetGCStats(ScriptGCStats &stats,bool bReset)
+{
+	stats.nHeapKb=lua_getgccount(m_pLS);
+	stats.nThresholdKb=lua_getgcthreshold(m_pLS);
+	stats.nState=lua_getgcstate(m_pLS);
+	stats.nCycles=m_nGCCycles;
+	stats.nSteps=m_nGCSteps;
+	stats.fLastStepTime=m_fGCLastStepTime;
+	stats.fMaxStepTime=m_fGCMaxStepTime;
+	stats.fTotalStepTime=m_fGCTotalStepTime;
+	stats.nPauses=m_nGCPauses;
+	stats.fLastPauseTime=m_fGCLastPauseTime;
+	stats.fMaxPauseTime=m_fGCMaxPauseTime;
+	if (bReset)
+	{
+		m_nGCCycles=0;
+		m_fGCMaxStepTime=0;
+		m_nGCSteps=0;
+		m_fGCTotalStepTime=0;
+		m_nGCPauses=0;
+		m_fGCMaxPauseTime=0;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 int CScriptSystem::GetCGCount()
@@ -134,6 +134,8 @@ public:
 	virtual USER_DATA CreateUserData(INT_PTR nVal,int nCookie);
 	virtual void RaiseError(const char *sErr,...);
 	virtual void ForceGarbageCollection();
+	virtual bool GarbageCollectionStep(bool bStartCycle);
+	virtual void GetGCStats(ScriptGCStats &stats,bool bReset);
 	virtual int GetCGCount();
 	virtual void SetGCThreshhold(int nKb);
 	virtual void UnbindUserdata();
@@ -151,6 +153,10 @@ public:
 	virtual void GetMemoryStatistics(ICrySizer *pSizer);
 	virtual void GetScriptHash( const char *sPath, const char *szKey, unsigned int &dwHash );
 	virtual void PostInit();
+	virtual void GetScriptCacheStats( int &nHits,int &nMisses,bool bReset );
+	virtual ScriptKey CreateKey(const char *sKey);
+	virtual void ReleaseKey(ScriptKey &key);
+	virtual const ScriptKey &GetVecKey(int nAxis) { return m_vecKeys[nAxis]; }
 
 private: // ---------------------------------------------------------------------
 
@@ -178,6 +184,12 @@ private: // --------------------------------------------------------------------
 	void RegisterTagHandlers();
 	//!
 	static int GCTagHandler(lua_State *L);
+	//! loads the chunk of the script file precompiled from the script cache if it was compiled
+	//! from the same source, otherwise compiles the source and updates the cache
+	//! \return lua error code, the chunk is on the stack if 0
+	int LoadScriptChunk(const char *sFileName,const char *sChunkName,const char *pSource,int nSize,bool bWriteCache);
+	//! writes the chunk on the top of the stack into the script cache
+	void WriteScriptCache(const char *sCacheFile,int nSourceSize,unsigned int nSourceHash);
 
 //	void GetScriptHashFunction( IScriptObject &Current, unsigned int &dwHash);
 	
@@ -204,6 +216,22 @@ private: // --------------------------------------------------------------------
 
 	UserDataMap								m_mapUserData;
 
+	int												m_nScriptCacheHits;						//!< since the last GetScriptCacheStats with reset
+	int												m_nScriptCacheMisses;					//!<
+	bool											m_bScriptCacheDirCreated;			//!<
+
+	ScriptKey									m_vecKeys[3];									//!< "x","y","z"
+
+	int												m_nGCCycles;									//!< incremental cycles since the last GetGCStats with reset
+	int												m_nGCLastStepCount;						//!< lua heap in Kb after the last step
+	float											m_fGCLastStepTime;						//!< ms
+	float											m_fGCMaxStepTime;							//!< ms, since the last GetGCStats with reset
+	int												m_nGCSteps;										//!< since the last GetGCStats with reset
+	float											m_fGCTotalStepTime;						//!< ms, since the last GetGCStats with reset
+	int												m_nGCPauses;									//!< full collections since the last GetGCStats with reset
+	float											m_fGCLastPauseTime;						//!< ms
+	float											m_fGCMaxPauseTime;						//!< ms, since the last GetGCStats with reset
+
 public: // -----------------------------------------------------------------------
 
 	BreakPoint								m_BreakPoint;									//!
@@ -269,7 +269,10 @@ bool CSoundBuffer::Load(bool bLooping, CSound *pSound)
 	{
 		ASSERT(m_pSoundSystem->m_pStreamEngine);
 		//TRACE("Starting Sound-Streaming for %s.", m_Props.sName.c_str());
-		m_pReadStream=m_pSoundSystem->m_pStreamEngine->StartRead("SoundSystem", m_Props.sName.c_str(), this);
+		// the sound is about to play
+		StreamReadParams params;
+		params.nPriorityClass = SRPC_HIGH;
+		m_pReadStream=m_pSoundSystem->m_pStreamEngine->StartRead("SoundSystem", m_Props.sName.c_str(), this, &params);
 		if (pSound->m_nFlags & FLAG_SOUND_LOAD_SYNCHRONOUSLY)
 		{
 			if (m_pReadStream)
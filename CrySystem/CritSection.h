@@ -27,6 +27,26 @@ public:
 			}
 };
 
+// locks the section only if no other thread holds it, check IsLocked
+template <class T>
+class CAutoTryLock
+{
+	T& m_csThis;
+	bool m_bLocked;
+public:
+	CAutoTryLock(T& csThis):
+			m_csThis(csThis)
+			{
+				m_bLocked = csThis.TryLock();
+			}
+			~CAutoTryLock()
+			{
+				if (m_bLocked)
+					m_csThis.Unlock();
+			}
+			bool IsLocked() const { return m_bLocked; }
+};
+
 template <class T>
 class CAutoUnlock
 {
@@ -72,6 +92,10 @@ public:
 	{
 		LeaveCriticalSection(&csThis);
 	}
+	bool TryLock ()
+	{
+		return TryEnterCriticalSection(&csThis) != 0;
+	}
 
 	// the lock and unlock facilities are disabled for explicit use,
 	// the client functions should use auto-lockers and auto-unlockers
@@ -80,6 +104,7 @@ private:
 
 	friend class CAutoLock<CCritSection>;
 	friend class CAutoUnlock<CCritSection>;
+	friend class CAutoTryLock<CCritSection>;
 };
 
 #define AUTO_LOCK(csLock) CAutoLock<CCritSection> __AL__##csLock(csLock)
@@ -8,6 +8,9 @@
 #include <new.h>
 
 #include <ISystem.h>
+#include <ILog.h>
+#include <ITimer.h>
+#include <IJobManager.h>
 
 #include "platform.h"
 
@@ -17,6 +20,8 @@
 
 //////////////////////////////////////////////////////////////////////////
 // Some globals for fast profiling.
+// Only count what is allocated without a thread cache (under the bucket lock),
+// every thread cache keeps its own counters, CryMemoryGetAllocatedSize() sums them up.
 //////////////////////////////////////////////////////////////////////////
 size_t g_TotalAllocatedMemory = 0;
 size_t g_ScriptAllocatedMemory = 0;
@@ -107,6 +112,8 @@ static int foo = clearstats();
 
 class PageBucketAllocator
 {
+	friend class ThreadBucketCache;
+
 	/*
 	Generic allocator that combines bucket allocation with reference counted 1 size object pages.
 	manages to perform well along each axis:
@@ -242,20 +249,329 @@ public:
 
 PageBucketAllocator g_GlobPageBucketAllocator;
 
+//////////////////////////////////////////////////////////////////////////
+// Lock of g_GlobPageBucketAllocator.
+// It must work without construction, the allocator is used before the static constructors ran.
+//////////////////////////////////////////////////////////////////////////
+#if defined(LINUX)
+static pthread_mutex_t g_BucketLock = PTHREAD_MUTEX_INITIALIZER;
+inline void LockBuckets() { pthread_mutex_lock(&g_BucketLock); }
+inline void UnlockBuckets() { pthread_mutex_unlock(&g_BucketLock); }
+#else
+static volatile LONG g_nBucketLock = 0;
+inline void LockBuckets() { while(InterlockedCompareExchange(&g_nBucketLock, 1, 0)!=0) Sleep(0); }
+inline void UnlockBuckets() { InterlockedExchange(&g_nBucketLock, 0); }
+#endif
+
+// objects moved between a thread cache and the shared allocator at once: about 1k, 4 to 32 objects
+#define THREADCACHE_BATCHBYTES 1024
+#define THREADCACHE_MINBATCH 4
+#define THREADCACHE_MAXBATCH 32
+
+class ThreadBucketCache
+{
+	/*
+	Per thread front end of g_GlobPageBucketAllocator, which is not thread safe.
+	Every thread keeps a free list per bucket and only takes the lock to move a batch of
+	objects between its lists and the shared allocator, so allocating and freeing small
+	objects is as cheap as before on any thread.
+	An object freed by another thread goes into the list of the freeing thread and is given
+	back to the shared allocator (and its page counter) with the next batch of that bucket.
+	Caches of finished threads are emptied and reused by the next new thread.
+	*/
+	typedef PageBucketAllocator PBA;
+
+	void *lists[PBA::MAXBUCKETS];
+	int counts[PBA::MAXBUCKETS];
+	bool inuse;
+	ThreadBucketCache *next;
+	CryThreadCacheStats stats;
+	// written only by the owning thread, kept when the cache is reused by another thread
+	// (an object can be freed by another thread than the one which allocated it, only the sum is meaningful)
+	size_t allocated;
+	size_t scriptallocated;
+	unsigned int biggest;
+
+	static ThreadBucketCache *first;
+	static volatile bool keyready;
+#if defined(LINUX)
+	static pthread_key_t key;
+	static void onthreadexit(void *c) { ((ThreadBucketCache *)c)->release(); };
+#else
+	static DWORD key;
+#endif
+
+	static int bucket(unsigned int s) { return (s+PBA::PTRSIZE-1)>>PBA::PTRBITS; };
+	static int batch(int b)
+	{
+		int n = THREADCACHE_BATCHBYTES/(b*PBA::PTRSIZE);
+		return n<THREADCACHE_MINBATCH ? THREADCACHE_MINBATCH : n>THREADCACHE_MAXBATCH ? THREADCACHE_MAXBATCH : n;
+	};
+
+	static ThreadBucketCache *current()
+	{
+		if(!keyready)
+		{
+			LockBuckets();
+			if(!keyready)
+			{
+#if defined(LINUX)
+				pthread_key_create(&key, onthreadexit);
+#else
+				key = TlsAlloc();
+#endif
+				keyready = true;
+			};
+			UnlockBuckets();
+		};
+#if defined(LINUX)
+		ThreadBucketCache *c = (ThreadBucketCache *)pthread_getspecific(key);
+#else
+		ThreadBucketCache *c = (ThreadBucketCache *)TlsGetValue(key);
+#endif
+		return c ? c : create();
+	};
+
+	static ThreadBucketCache *create()
+	{
+		LockBuckets();
+		ThreadBucketCache *c = first;
+		while(c && c->inuse) c = c->next;
+		if(!c)
+		{
+			c = (ThreadBucketCache *)::calloc(1, sizeof(ThreadBucketCache));
+			if(c)
+			{
+				c->next = first;
+				first = c;
+			};
+		};
+		if(c)
+		{
+			memset(&c->stats, 0, sizeof(c->stats));
+#if defined(LINUX)
+			c->stats.thread_id = (unsigned int)pthread_self();
+#else
+			c->stats.thread_id = GetCurrentThreadId();
+#endif
+			c->inuse = true;
+		};
+		UnlockBuckets();
+#if defined(LINUX)
+		pthread_setspecific(key, c);
+#else
+		TlsSetValue(key, c);
+#endif
+		return c;
+	};
+
+	void refill(int b)
+	{
+		int n = batch(b);
+		LockBuckets();
+		for(int i = 0; i<n; i++)
+		{
+			void **p = (void **)g_GlobPageBucketAllocator.alloc(b*PBA::PTRSIZE);
+			*p = lists[b];
+			lists[b] = p;
+		};
+		UnlockBuckets();
+		counts[b] += n;
+		stats.num_refills++;
+	};
+
+	void giveback(int b) // keeps the most recently freed objects, they are likely to be in the cache
+	{
+		int n = batch(b);
+		void **keep = (void **)lists[b];
+		for(int i = 1; i<n; i++) keep = (void **)*keep;
+		void **r = (void **)*keep;
+		*keep = NULL;
+		counts[b] = n;
+		LockBuckets();
+		while(r)
+		{
+			void **p = r;
+			r = (void **)*r;
+			g_GlobPageBucketAllocator.dealloc(p, b*PBA::PTRSIZE);
+		};
+		UnlockBuckets();
+		stats.num_returns++;
+	};
+
+	void release()
+	{
+		LockBuckets();
+		for(int b = 0; b<PBA::MAXBUCKETS; b++)
+		{
+			for(void **r = (void **)lists[b]; r; )
+			{
+				void **p = r;
+				r = (void **)*r;
+				g_GlobPageBucketAllocator.dealloc(p, b*PBA::PTRSIZE);
+			};
+			lists[b] = NULL;
+			counts[b] = 0;
+		};
+		inuse = false;
+		UnlockBuckets();
+	};
+
+public:
+
+	static void *alloc(unsigned int size)
+	{
+		ThreadBucketCache *c = current();
+		if(!c)
+		{
+			LockBuckets();
+			g_TotalAllocatedMemory += size;
+			void *p = g_GlobPageBucketAllocator.alloc(size);
+			UnlockBuckets();
+			return p;
+		};
+		c->allocated += size;
+		if(size>PBA::MAXREUSESIZE)
+		{
+			if(size>c->biggest) c->biggest = size;
+			return ::malloc(size);
+		};
+		int b = bucket(size);
+		if(!c->lists[b]) c->refill(b);
+		void **r = (void **)c->lists[b];
+		c->lists[b] = *r;
+		c->counts[b]--;
+		c->stats.num_allocations++;
+		return (void *)r;
+	};
+
+	static void dealloc(void *p, unsigned int size)
+	{
+		ThreadBucketCache *c = current();
+		if(!c)
+		{
+			LockBuckets();
+			g_TotalAllocatedMemory -= size;
+			g_GlobPageBucketAllocator.dealloc(p, size);
+			UnlockBuckets();
+			return;
+		};
+		c->allocated -= size;
+		if(size>PBA::MAXREUSESIZE)
+		{
+			::free(p);
+			return;
+		};
+		int b = bucket(size);
+		*((void **)p) = c->lists[b];
+		c->lists[b] = p;
+		c->stats.num_frees++;
+		if(++c->counts[b]>2*batch(b)) c->giveback(b);
+	};
+
+	// gives the objects of the calling thread back to the shared allocator, called when a thread ends
+	static void flushthread()
+	{
+		if(!keyready) return;
+#if defined(LINUX)
+		ThreadBucketCache *c = (ThreadBucketCache *)pthread_getspecific(key);
+		pthread_setspecific(key, NULL);
+#else
+		ThreadBucketCache *c = (ThreadBucketCache *)TlsGetValue(key);
+		TlsSetValue(key, NULL);
+#endif
+		if(c) c->release();
+	};
+
+	// forgets all cached objects, their pages are gone after CryFlushAll()
+	static void reset()
+	{
+		LockBuckets();
+		for(ThreadBucketCache *c = first; c; c = c->next)
+		{
+			for(int b = 0; b<PBA::MAXBUCKETS; b++)
+			{
+				c->lists[b] = NULL;
+				c->counts[b] = 0;
+			};
+			c->allocated = 0;
+			c->scriptallocated = 0;
+		};
+		g_TotalAllocatedMemory = 0;
+		g_ScriptAllocatedMemory = 0;
+		UnlockBuckets();
+	};
+
+	// memory handed out to the lua allocator (CryReallocSize/CryFreeSize), nSize is negative when freed
+	static void countscript(INT_PTR nSize)
+	{
+		ThreadBucketCache *c = current();
+		if(!c)
+		{
+			LockBuckets();
+			g_ScriptAllocatedMemory += nSize;
+			UnlockBuckets();
+			return;
+		};
+		c->scriptallocated += nSize;
+	};
+
+	// sums up the counters of all caches, also of the ones no thread uses at the moment
+	static void gettotals(size_t &total, size_t &script, unsigned int &biggest)
+	{
+		LockBuckets();
+		total = g_TotalAllocatedMemory;
+		script = g_ScriptAllocatedMemory;
+		biggest = biggestalloc;
+		for(ThreadBucketCache *c = first; c; c = c->next)
+		{
+			total += c->allocated;
+			script += c->scriptallocated;
+			if(c->biggest>biggest) biggest = c->biggest;
+		};
+		UnlockBuckets();
+	};
+
+	static int getstats(CryThreadCacheStats *pStats, int nMax)
+	{
+		int n = 0;
+		LockBuckets();
+		for(ThreadBucketCache *c = first; c; c = c->next)
+		{
+			if(!c->inuse) continue;
+			if(n<nMax)
+			{
+				pStats[n] = c->stats;
+				pStats[n].cached_bytes = 0;
+				for(int b = 0; b<PBA::MAXBUCKETS; b++) pStats[n].cached_bytes += c->counts[b]*b*PBA::PTRSIZE;
+			};
+			n++;
+		};
+		UnlockBuckets();
+		return n;
+	};
+};
+
+ThreadBucketCache *ThreadBucketCache::first = NULL;
+volatile bool ThreadBucketCache::keyready = false;
+#if defined(LINUX)
+pthread_key_t ThreadBucketCache::key;
+#else
+DWORD ThreadBucketCache::key;
+#endif
+
 CRYMEMORYMANAGER_API void *CryMalloc(size_t size)
 {
 	if (!g_bProfilerEnabled)
 	{
-		g_TotalAllocatedMemory += size+sizeof(int);
-		int *p = (int *)g_GlobPageBucketAllocator.alloc(size+sizeof(int));
+		int *p = (int *)ThreadBucketCache::alloc(size+sizeof(int));
 		*p++ = size;  // stores 2 sizes for big objects!
 		return p;
 	}
 	else
 	{
 		FUNCTION_PROFILER_FAST( g_System,PROFILE_SYSTEM,g_bProfilerEnabled );
-		g_TotalAllocatedMemory += size+sizeof(int);
-		int *p = (int *)g_GlobPageBucketAllocator.alloc(size+sizeof(int));
+		int *p = (int *)ThreadBucketCache::alloc(size+sizeof(int));
 		*p++ = size;  // stores 2 sizes for big objects!
 		return p;
 	}
@@ -281,8 +597,7 @@ CRYMEMORYMANAGER_API void CryFree(void *p)
 #ifdef GARBAGEMEMORY     //FIXME: *disabling* memset caused random crash???
 			memset(t, 0xBA, size); 
 #endif
-			g_TotalAllocatedMemory -= size;
-			g_GlobPageBucketAllocator.dealloc(t, size);
+			ThreadBucketCache::dealloc(t, size);
 		}
 	}
 	else
@@ -305,16 +620,14 @@ CRYMEMORYMANAGER_API void CryFree(void *p)
 #ifdef GARBAGEMEMORY     //FIXME: *disabling* memset caused random crash???
 			memset(t, 0xBA, size); 
 #endif
-			g_TotalAllocatedMemory -= size;
-			g_GlobPageBucketAllocator.dealloc(t, size);
+			ThreadBucketCache::dealloc(t, size);
 		}
 	}
 }
 
 CRYMEMORYMANAGER_API void CryFreeSize(void *p, size_t size)
 {
-	g_ScriptAllocatedMemory -= size;
-	g_TotalAllocatedMemory -= size;
+	ThreadBucketCache::countscript(-(INT_PTR)size);
 	if (!g_bProfilerEnabled)
 	{
 		if (p != NULL)
@@ -329,7 +642,7 @@ CRYMEMORYMANAGER_API void CryFreeSize(void *p, size_t size)
 #ifdef GARBAGEMEMORY      //FIXME: idem
 			memset(p, 0xBB, size); 
 #endif
-			g_GlobPageBucketAllocator.dealloc(p, size);
+			ThreadBucketCache::dealloc(p, size);
 		}
 	}
 	else
@@ -348,7 +661,7 @@ CRYMEMORYMANAGER_API void CryFreeSize(void *p, size_t size)
 #ifdef GARBAGEMEMORY      //FIXME: idem
 			memset(p, 0xBB, size); 
 #endif
-			g_GlobPageBucketAllocator.dealloc(p, size);
+			ThreadBucketCache::dealloc(p, size);
 		}
 	}
 }
@@ -388,17 +701,16 @@ CRYMEMORYMANAGER_API void *CryRealloc(void *memblock, size_t size)
 
 CRYMEMORYMANAGER_API void *CryReallocSize(void *memblock, size_t oldsize, size_t size)
 {
-	g_ScriptAllocatedMemory += size; // -old size done in CryFreeSize
-	g_TotalAllocatedMemory += size;
+	ThreadBucketCache::countscript(size); // -old size done in CryFreeSize
 	if (!g_bProfilerEnabled)
 	{
 		if(memblock==NULL)
 		{
-			return (char*)g_GlobPageBucketAllocator.alloc(size) + g_nPrecaution;
+			return (char*)ThreadBucketCache::alloc(size) + g_nPrecaution;
 		}
 		else
 		{
-			void *np = (char*)g_GlobPageBucketAllocator.alloc(size) + g_nPrecaution;
+			void *np = (char*)ThreadBucketCache::alloc(size) + g_nPrecaution;
 			memcpy(np, memblock, size>oldsize ? oldsize : size);
 			CryFreeSize(memblock, oldsize);
 			return np;
@@ -409,11 +721,11 @@ CRYMEMORYMANAGER_API void *CryReallocSize(void *memblock, size_t oldsize, size_t
 		FUNCTION_PROFILER_FAST( g_System,PROFILE_SYSTEM,g_bProfilerEnabled );
 		if(memblock==NULL)
 		{
-			return (char*)g_GlobPageBucketAllocator.alloc(size) + g_nPrecaution;
+			return (char*)ThreadBucketCache::alloc(size) + g_nPrecaution;
 		}
 		else
 		{
-			void *np = (char*)g_GlobPageBucketAllocator.alloc(size) + g_nPrecaution;
+			void *np = (char*)ThreadBucketCache::alloc(size) + g_nPrecaution;
 			memcpy(np, memblock, size>oldsize ? oldsize : size);
 			CryFreeSize(memblock, oldsize);
 			return np;
@@ -428,9 +740,8 @@ CRYMEMORYMANAGER_API void CryFlushAll()  // releases/resets ALL memory... this i
 	for(int i = 0; i<numpools; i++) 
 		bpool(g_pool, poolbufs[i], poolsizes[i]);
 		*/
+	ThreadBucketCache::reset();
 	new (&g_GlobPageBucketAllocator) PageBucketAllocator();
-	g_ScriptAllocatedMemory = 0;
-	g_TotalAllocatedMemory = 0;
 };
 
 /* MarcoK: This is never used anywhere ... commented out (LINUX port)
@@ -452,13 +763,19 @@ extern "C" CRYMEMORYMANAGER_API void CryFreeMemoryPools()  // releases/resets AL
 //////////////////////////////////////////////////////////////////////////
 CRYMEMORYMANAGER_API int CryMemoryGetAllocatedSize()
 {
-	return g_TotalAllocatedMemory;
+	size_t total, script;
+	unsigned int biggest;
+	ThreadBucketCache::gettotals(total, script, biggest);
+	return total;
 }
 
 //////////////////////////////////////////////////////////////////////////
 CRYMEMORYMANAGER_API int CryMemoryGetAllocatedInScriptSize()
 {
-	return g_ScriptAllocatedMemory;
+	size_t total, script;
+	unsigned int biggest;
+	ThreadBucketCache::gettotals(total, script, biggest);
+	return script;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -478,15 +795,139 @@ CRYMEMORYMANAGER_API int CryStats(char *buf)
 	if(buf)
 	{
 		int poolsize = CryMemoryGetPoolSize();
-		int scriptalloc = CryMemoryGetAllocatedInScriptSize();
+		size_t totalalloc, scriptalloc;
+		unsigned int biggest;
+		ThreadBucketCache::gettotals(totalalloc, scriptalloc, biggest);
 		sprintf(buf, "Memory Allocated = %d K, totfree = %d K , maxfree = %d K, nmalloc = %d, nfree = %d, biggestalloc = %d, Pool Size = %d K, Lua Allocated = %d K",
-			curalloc/1024, totfree/1024, maxfree/1024, nget, nrel, biggestalloc,poolsize/1024,scriptalloc/1024);
+			curalloc/1024, totfree/1024, maxfree/1024, nget, nrel, biggest,poolsize/1024,(int)(scriptalloc/1024));
 		//printstats();
+		LockBuckets();
 		g_GlobPageBucketAllocator.stats();
+		UnlockBuckets();
 	};
 	return curalloc/1024;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Gives the free objects cached by the calling thread back to the shared allocator.
+// Must be called by threads that use the allocator before they end (done in DllMain on Win32).
+//////////////////////////////////////////////////////////////////////////
+CRYMEMORYMANAGER_API void CryFlushThreadCache()
+{
+	ThreadBucketCache::flushthread();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Fills up to nMax entries, returns the number of threads with a cache.
+//////////////////////////////////////////////////////////////////////////
+CRYMEMORYMANAGER_API int CryGetThreadCacheStats(CryThreadCacheStats *pStats, int nMax)
+{
+	return ThreadBucketCache::getstats(pStats, nMax);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Allocation micro benchmark (sys_BenchAlloc).
+// Every lane frees and allocates small objects of random size in a ring of slots,
+// once through the thread caches and once through the shared allocator under its lock,
+// which is what the allocator did before it had the caches.
+//////////////////////////////////////////////////////////////////////////
+#define ALLOCBENCH_MAXLANES 16
+#define ALLOCBENCH_SLOTS 256
+
+struct AllocBenchLane
+{
+	int nAllocs;
+	bool bShared;
+	unsigned int nSeed;
+};
+
+static void AllocBenchLaneFunc(void *pData)
+{
+	AllocBenchLane *pLane = (AllocBenchLane *)pData;
+	void *slots[ALLOCBENCH_SLOTS];
+	unsigned int sizes[ALLOCBENCH_SLOTS];
+	memset(slots, 0, sizeof(slots));
+	unsigned int seed = pLane->nSeed;
+	int i;
+	for(i = 0; i<pLane->nAllocs; i++)
+	{
+		seed = seed*1103515245+12345;
+		int s = (seed>>8)%ALLOCBENCH_SLOTS;
+		unsigned int size = 8+((seed>>16)&0xff);
+		if(pLane->bShared)
+		{
+			LockBuckets();
+			if(slots[s]) g_GlobPageBucketAllocator.dealloc(slots[s], sizes[s]);
+			slots[s] = g_GlobPageBucketAllocator.alloc(size);
+			UnlockBuckets();
+		}
+		else
+		{
+			if(slots[s]) ThreadBucketCache::dealloc(slots[s], sizes[s]);
+			slots[s] = ThreadBucketCache::alloc(size);
+		};
+		sizes[s] = size;
+		*(char *)slots[s] = (char)i;
+	};
+	for(i = 0; i<ALLOCBENCH_SLOTS; i++)
+	{
+		if(!slots[i]) continue;
+		if(pLane->bShared)
+		{
+			LockBuckets();
+			g_GlobPageBucketAllocator.dealloc(slots[i], sizes[i]);
+			UnlockBuckets();
+		}
+		else
+			ThreadBucketCache::dealloc(slots[i], sizes[i]);
+	};
+}
+
+// returns millions of allocations per second
+static float RunAllocBench(int nLanes, int nAllocsPerLane, bool bShared)
+{
+	IJobManager *pJobManager = g_System->GetIJobManager();
+	ITimer *pTimer = g_System->GetITimer();
+	AllocBenchLane lanes[ALLOCBENCH_MAXLANES];
+	int i;
+	for(i = 0; i<nLanes; i++)
+	{
+		lanes[i].nAllocs = nAllocsPerLane;
+		lanes[i].bShared = bShared;
+		lanes[i].nSeed = 0x9e3779b9*(i+1);
+	};
+	JobCounter lanesDone;
+	float fStart = pTimer->GetAsyncCurTime();
+	for(i = 1; i<nLanes; i++)
+		pJobManager->AddJob(AllocBenchLaneFunc, lanes+i, &lanesDone);
+	AllocBenchLaneFunc(lanes);
+	if(nLanes>1)
+		pJobManager->WaitForJobs(&lanesDone);
+	float fTime = pTimer->GetAsyncCurTime()-fStart;
+	if(fTime<=0) fTime = 0.001f;
+	return (float)nLanes*nAllocsPerLane/fTime/1000000.0f;
+}
+
+CRYMEMORYMANAGER_API void CryBenchmarkAllocator(int nThreads, int nAllocsPerThread)
+{
+	if(!g_System || !g_System->GetITimer())
+		return;
+	if(nThreads>ALLOCBENCH_MAXLANES) nThreads = ALLOCBENCH_MAXLANES;
+	if(nThreads<1 || !g_System->GetIJobManager()) nThreads = 1;
+	if(nAllocsPerThread<ALLOCBENCH_SLOTS) nAllocsPerThread = ALLOCBENCH_SLOTS;
+
+	ILog *pLog = g_System->GetILog();
+	float fShared1 = RunAllocBench(1, nAllocsPerThread, true);
+	float fCached1 = RunAllocBench(1, nAllocsPerThread, false);
+	pLog->Log("AllocBench 1 thread: shared allocator %.2f M/s, thread caches %.2f M/s", fShared1, fCached1);
+	if(nThreads>1)
+	{
+		float fSharedN = RunAllocBench(nThreads, nAllocsPerThread, true);
+		float fCachedN = RunAllocBench(nThreads, nAllocsPerThread, false);
+		pLog->Log("AllocBench %d threads: shared allocator %.2f M/s, thread caches %.2f M/s", nThreads, fSharedN, fCachedN);
+	};
+}
+
 /*
 extern "C" void debug(int n)
 {
@@ -19,6 +19,7 @@
 #include "CryPak.h"
 #include <ilog.h>
 #include <StringUtils.h>
+#include "zlib/zlib.h"
 
 /////////////////////////////////////////////////////
 
@@ -109,6 +110,7 @@ void CCryPak::AddMod(const char* szMod)
 			return; // already added
 	}
 	m_arrMods.push_back(strPrepend);
+	ClearAdjustedPaths();
 	m_pLog->Log("Added MOD %s to crypak",strPrepend.c_str());
 }
 
@@ -127,6 +129,7 @@ void CCryPak::RemoveMod(const char* szMod)
 			break;
 		}
 	} //it
+	ClearAdjustedPaths();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -205,6 +208,77 @@ char* CCryPak::BeautifyPath(char* dst)
 //////////////////////////////////////////////////////////////////////////
 // given the source relative path, constructs the full path to the file according to the flags
 const char* CCryPak::AdjustFileName(const char *src, char *dst, unsigned nFlags,bool *bFoundInPak)
+{
+	// wildcards are resolved by the file system, they can't be cached
+	if (strchr(src, '*') || strchr(src, '?'))
+	{
+		bool bCacheable;
+		return AdjustFileNameImpl (src, dst, nFlags, bFoundInPak, bCacheable);
+	}
+
+	// the relative paths depend on the current directory, and the editor changes it in the file dialogs
+	bool bRelative = !(src[0] == g_cNativeSlash || src[0] == g_cNonNativeSlash || (src[0] && src[1] == ':'));
+	char szCurDir[g_nMaxPath];
+	if (bRelative && !GetCurrentDirectory(sizeof(szCurDir), szCurDir))
+		szCurDir[0] = '\0';
+
+	CPathHash hashKey(src);
+	hashKey.AddValue (nFlags);
+	string strSrc;
+	CPathHash::Normalize (src, strSrc);
+	{
+		AUTO_LOCK(m_csIndex);
+		if (bRelative && strcmp(szCurDir, m_strAdjustedPathsCurDir.c_str()))
+		{
+			m_mapAdjustedPaths.clear();
+			m_strAdjustedPathsCurDir = szCurDir;
+		}
+
+		AdjustedPath* pCached = m_mapAdjustedPaths.find (hashKey);
+		if (pCached && pCached->nFlags == nFlags && pCached->strSrc == strSrc)
+		{
+			if (bFoundInPak)
+				*bFoundInPak = pCached->bFoundInPak;
+			if (pCached->strPath.empty())
+				return NULL;
+			strcpy (dst, pCached->strPath.c_str());
+			return dst;
+		}
+	}
+
+	// resolve without the lock: it may touch the disk
+	bool bCacheable = true, bFoundInPakResult = false;
+	const char* szResult = AdjustFileNameImpl (src, dst, nFlags, &bFoundInPakResult, bCacheable);
+	if (bFoundInPak)
+		*bFoundInPak = bFoundInPakResult;
+
+	if (bCacheable)
+	{
+		AdjustedPath entry;
+		entry.strSrc = strSrc;
+		entry.nFlags = nFlags;
+		if (szResult)
+			entry.strPath = szResult;
+		entry.bFoundInPak = bFoundInPakResult;
+
+		AUTO_LOCK(m_csIndex);
+		// the paths of a level rarely repeat in the next one; don't let it grow forever
+		if (m_mapAdjustedPaths.size() >= 0x8000)
+			m_mapAdjustedPaths.clear();
+		m_mapAdjustedPaths.insert (hashKey, entry);
+	}
+	return szResult;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CCryPak::ClearAdjustedPaths()
+{
+	AUTO_LOCK(m_csIndex);
+	m_mapAdjustedPaths.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+const char* CCryPak::AdjustFileNameImpl(const char *src, char *dst, unsigned nFlags, bool *bFoundInPak, bool& bCacheable)
 {
 	// in many cases, the path will not be long, so there's no need to allocate so much..
 	// I'd use _alloca, but I don't like non-portable solutions. besides, it tends to confuse new developers. So I'm just using a big enough array
@@ -213,6 +287,7 @@ const char* CCryPak::AdjustFileName(const char *src, char *dst, unsigned nFlags,
 	BeautifyPath(szNewSrc);
 	if (!_fullpath (dst, szNewSrc, g_nMaxPath))
 	{
+		bCacheable = false;
 		src = szNewSrc;
 		m_pLog->LogError("\002Cannot transform file name %s to absolute path, resorting to desparate measures!", src);
 		if (src[0] == '.' && (src[1] == g_cNativeSlash || src[1] == g_cNonNativeSlash))
@@ -262,7 +337,13 @@ const char* CCryPak::AdjustFileName(const char *src, char *dst, unsigned nFlags,
 		strcpy(dst, fileName.c_str());
 	}
 	else
+	{
+		// the file may be created later with a different case, unless it's in a pak: the paks
+		// don't change without clearing the cache
+		if (!HasFileEntry(adjustedFilename.c_str()))
+			bCacheable = false;
 		strcpy(dst, adjustedFilename.c_str());
+	}
 	if ((nFlags & FLAGS_ADD_TRAILING_SLASH) && pEnd > dst && (pEnd[-1]!=g_cNativeSlash && pEnd[-1]!=g_cNonNativeSlash))
 #else
 	// p now points to the end of string
@@ -276,7 +357,7 @@ const char* CCryPak::AdjustFileName(const char *src, char *dst, unsigned nFlags,
 	unsigned nLength = pEnd - dst;
 
 	if (bFoundInPak)
-		bFoundInPak=false;
+		*bFoundInPak=false;
 
 	if (nFlags & FLAGS_PATH_REAL)
 		return dst;
@@ -335,6 +416,8 @@ const char* CCryPak::AdjustFileName(const char *src, char *dst, unsigned nFlags,
 
 		if (it == m_arrMods.rend())
 		{
+			// the file may appear in one of the MOD directories later
+			bCacheable = false;
 			if (nFlags & FLAGS_ONLY_MOD_DIRS)
 				return NULL; // we didn't find the corresponding file
 			else
@@ -418,7 +501,6 @@ return (false);
 //////////////////////////////////////////////////////////////////////////
 FILE *CCryPak::FOpen(const char *pName, const char *szMode,char *szFileGamePath,int nLen)
 {
-	AUTO_LOCK(m_csMain);
 	FILE *fp = NULL;
 	char szFullPathBuf[g_nMaxPath];
 	const char* szFullPath = AdjustFileName(pName, szFullPathBuf, 0);
@@ -436,9 +518,10 @@ FILE *CCryPak::FOpen(const char *pName, const char *szMode,char *szFileGamePath,
 
 
 //////////////////////////////////////////////////////////////////////////
+// the path resolution and the pak lookup don't need m_csMain, it's only locked
+// to allocate the pseudo-file slot
 FILE *CCryPak::FOpen(const char *pName, const char *szMode,unsigned nFlags2)
 {
-	AUTO_LOCK(m_csMain);
 	FILE *fp = NULL;
 	char szFullPathBuf[g_nMaxPath];
 
@@ -588,6 +671,7 @@ FILE *CCryPak::FOpen(const char *pName, const char *szMode,unsigned nFlags2)
 
 	RecordFile( pName );
 
+	AUTO_LOCK(m_csMain);
 	size_t nFile;
 	// find the empty slot and open the file there; return the handle
 	for (nFile = 0; nFile < m_arrOpenFiles.size() && m_arrOpenFiles[nFile].GetFile(); ++nFile)
@@ -621,69 +705,75 @@ CCachedFileDataPtr CCryPak::GetFileData(const char* szName)
 #if defined(LINUX)
 	replaceDoublePathFilename((char*)szName);
 #endif
-	unsigned nNameLen = (unsigned)strlen(szName);
-	AUTO_LOCK(m_csZips);
-	// scan through registered pak files and try to find this file
-	for (ZipArray::reverse_iterator itZip = m_arrZips.rbegin(); itZip != m_arrZips.rend(); ++itZip)
-	{
-		size_t nBindRootLen = itZip->strBindRoot.length();
-#if defined(LINUX)
-		if (nNameLen > nBindRootLen	&&!comparePathNames(itZip->strBindRoot.c_str(), szName, nBindRootLen))
-#else
-		if (nNameLen > nBindRootLen	&&!memcmp(itZip->strBindRoot.c_str(), szName, nBindRootLen))
-#endif
-		{
-			//const char	*szDebug1=itZip->strBindRoot.c_str();
-			//const char	*szDebug2=itZip->pZip->GetFilePath();
+	CPathHash hashName(szName);
+	AUTO_LOCK(m_csIndex);
+	PakFileRef* pRef = m_mapPakFiles.find(hashName);
+	if (!pRef)
+		return NULL;
 
-			ZipDir::FileEntry* pFileEntry = itZip->pZip->FindFile (szName+nBindRootLen);
-			if (pFileEntry)
-			{
-				CCachedFileData Result(NULL, itZip->pZip, pFileEntry);
-				AUTO_LOCK(m_csCachedFiles);
+	// the zip can only be released by ClosePack, which waits for m_csIndex
+	CCachedFileData Result(NULL, pRef->pZip, pRef->pFileEntry);
+	AUTO_LOCK(m_csCachedFiles);
 
-				CachedFileDataSet::iterator it = m_setCachedFiles.find(&Result);
-				if (it != m_setCachedFiles.end())
-				{
-					assert((*it)->GetFileEntry() == pFileEntry); // cached data
-					return *it;
-				}
-				else
-					return new CCachedFileData (this, itZip->pZip, pFileEntry);
-			}
-		}
+	CachedFileDataSet::iterator it = m_setCachedFiles.find(&Result);
+	if (it != m_setCachedFiles.end())
+	{
+		assert((*it)->GetFileEntry() == pRef->pFileEntry); // cached data
+		return *it;
 	}
-	return NULL;
+	else
+		return new CCachedFileData (this, pRef->pZip, pRef->pFileEntry);
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 // tests if the given file path refers to an existing file inside registered (opened) packs
-// the path must be absolute normalized lower-case with forward-slashes
 bool CCryPak::HasFileEntry (const char* szPath)
 {
-	unsigned nNameLen = (unsigned)strlen(szPath);
-	AUTO_LOCK(m_csZips);
-	// scan through registered pak files and try to find this file
-	for (ZipArray::reverse_iterator itZip = m_arrZips.rbegin(); itZip != m_arrZips.rend(); ++itZip)
+	CPathHash hashName(szPath);
+	AUTO_LOCK(m_csIndex);
+	return m_mapPakFiles.find(hashName) != NULL;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+void CCryPak::IndexPack (const PackDesc& desc)
+{
+	// the bind root has the trailing slash
+	CPathHash hashRoot(desc.strBindRoot.c_str());
+	IndexPackDir (desc.pZip, desc.pZip->GetRoot(), hashRoot);
+}
+
+void CCryPak::IndexPackDir (ZipDir::Cache* pZip, ZipDir::DirHeader* pDir, const CPathHash& hashDir)
+{
+	const char* pNamePool = pDir->GetNamePool();
+	PakFileRef ref;
+	ref.pZip = pZip;
+	for (unsigned nFile = 0; nFile < pDir->numFiles; ++nFile)
 	{
-		size_t nBindRootLen = itZip->strBindRoot.length();
-		//const char	*szDebug1=itZip->strBindRoot.c_str();
-		//const char	*szDebug2=itZip->pZip->GetFilePath();
-#if defined(LINUX)
-		if (nNameLen > nBindRootLen	&&!comparePathNames(itZip->strBindRoot.c_str(), szPath, nBindRootLen))
-#else
-		if (nNameLen > nBindRootLen	&&!memcmp(itZip->strBindRoot.c_str(), szPath, nBindRootLen))
-#endif
-		{
-			ZipDir::FileEntry* pFileEntry = itZip->pZip->FindFile (szPath+nBindRootLen);
-			if (pFileEntry)
-			{
-				return true;
-			}
-		}
+		ref.pFileEntry = pDir->GetFileEntry(nFile);
+		CPathHash hashFile = hashDir;
+		hashFile.Add (ref.pFileEntry->GetName(pNamePool));
+		m_mapPakFiles.insert (hashFile, ref);
+	}
+
+	for (unsigned nDir = 0; nDir < pDir->numDirs; ++nDir)
+	{
+		ZipDir::DirEntry* pDirEntry = pDir->GetSubdirEntry(nDir);
+		CPathHash hashSubdir = hashDir;
+		hashSubdir.Add (pDirEntry->GetName(pNamePool));
+		hashSubdir.Add ("\\");
+		IndexPackDir (pZip, pDirEntry->GetDirectory(), hashSubdir);
 	}
-	return false;
+}
+
+void CCryPak::RebuildPakIndex()
+{
+	m_mapPakFiles.clear();
+	// in the order of opening, so that the later paks override the earlier ones
+	for (ZipArray::iterator itZip = m_arrZips.begin(); itZip != m_arrZips.end(); ++itZip)
+		IndexPack (*itZip);
+	m_mapAdjustedPaths.clear();
 }
 
 
@@ -1003,6 +1093,11 @@ bool CCryPak::OpenPackCommon(const char* szBindRoot, const char *szFullPath, uns
 		m_pLog->Log("Opening pack file %s",szFullPath);
 		desc.pZip = static_cast<CryArchive*>((ICryArchive*)desc.pArchive)->GetCache();
 		m_arrZips.push_back(desc);
+
+		AUTO_LOCK(m_csIndex);
+		IndexPack (desc);
+		// the MOD directory resolution depends on the pak contents
+		m_mapAdjustedPaths.clear();
 		return true;
 	}
 	else
@@ -1032,7 +1127,11 @@ bool CCryPak::ClosePack(const char* pName, unsigned nFlags)
 			if (bResult)
 			{
 				m_pLog->Log("Closing pack file %s",szZipPath);
+				// the index refers to the zip without holding it, so it's removed from
+				// both under the index lock
+				AUTO_LOCK(m_csIndex);
 				m_arrZips.erase (it);
+				RebuildPakIndex();
 			}
 			return bResult;
 		}
@@ -1344,6 +1443,28 @@ CCachedFileData::~CCachedFileData()
 	m_pFileEntry = NULL;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// the reads from one zip share its FILE*, so they're serialized per zip.
+// The inflate only waits for the other threads unpacking the same file:
+// the stream engine workers unpack different files in parallel
+static CCritSection g_csZipFiles[8];
+static CCritSection g_csFileDatas[32];
+
+CCritSection& CCachedFileData::GetZipFileLock(ZipDir::Cache* pZip)
+{
+	return g_csZipFiles[((UINT_PTR)pZip >> 6) % (sizeof(g_csZipFiles)/sizeof(g_csZipFiles[0]))];
+}
+
+unsigned CCachedFileData::GetFileDataOffset()
+{
+	if (m_pFileEntry->nFileDataOffset == m_pFileEntry->INVALID_DATA_OFFSET)
+	{
+		CAutoLock<CCritSection> lockZip(GetZipFileLock(m_pZip));
+		m_pZip->Refresh (m_pFileEntry);
+	}
+	return m_pFileEntry->nFileDataOffset;
+}
+
 // return the data in the file, or NULL if error
 void* CCachedFileData::GetData(bool bRefreshCache)
 {
@@ -1357,16 +1478,33 @@ void* CCachedFileData::GetData(bool bRefreshCache)
 
 		// Then, lock it and check whether the data is still not there.
 		// if it's not, allocate memory and unpack the file
-		CCritSection& csCachedFileDataLock = m_pPak->GetCachedFileLock();
-		AUTO_LOCK(csCachedFileDataLock);
+		CAutoLock<CCritSection> lockData(g_csFileDatas[((UINT_PTR)this >> 4) % (sizeof(g_csFileDatas)/sizeof(g_csFileDatas[0]))]);
 		if (!m_pFileData)
 		{
-			m_pFileData = g_pBigHeap->Alloc (m_pFileEntry->desc.lSizeUncompressed, "CCachedFileData::GetData");
-			if (ZipDir::ZD_ERROR_SUCCESS != m_pZip->ReadFile (m_pFileEntry, NULL, m_pFileData))
+			void* pData = g_pBigHeap->Alloc (m_pFileEntry->desc.lSizeUncompressed, "CCachedFileData::GetData");
+			bool bOk;
+			if (m_pFileEntry->nMethod == ZipFile::METHOD_STORE)
+			{
+				CAutoLock<CCritSection> lockZip(GetZipFileLock(m_pZip));
+				bOk = ZipDir::ZD_ERROR_SUCCESS == m_pZip->ReadFile (m_pFileEntry, NULL, pData);
+			}
+			else
 			{
-				g_pBigHeap->Free(m_pFileData);
-				m_pFileData = NULL;
+				// read the compressed data under the zip lock and unpack it without
+				void* pCompressed = g_pBigHeap->Alloc (m_pFileEntry->desc.lSizeCompressed, "CCachedFileData::GetData: compressed");
+				{
+					CAutoLock<CCritSection> lockZip(GetZipFileLock(m_pZip));
+					bOk = ZipDir::ZD_ERROR_SUCCESS == m_pZip->ReadFile (m_pFileEntry, pCompressed, NULL);
+				}
+				unsigned long nSizeUncompressed = m_pFileEntry->desc.lSizeUncompressed;
+				bOk = bOk && Z_OK == ZipDir::ZipRawUncompress (g_pBigHeap, pData, &nSizeUncompressed, pCompressed, m_pFileEntry->desc.lSizeCompressed);
+				g_pBigHeap->Free (pCompressed);
 			}
+
+			if (bOk)
+				m_pFileData = pData;
+			else
+				g_pBigHeap->Free(pData);
 		}
 	}
 	return m_pFileData;
@@ -1539,6 +1677,11 @@ void CCryPak::GetMemoryStatistics(ICrySizer *pSizer)
 
 	nSize += m_arrOpenFiles.capacity() * sizeof(CZipPseudoFile);
 
+	{
+		AUTO_LOCK(m_csIndex);
+		nSize += m_mapPakFiles.sizeofThis() + m_mapAdjustedPaths.sizeofThis();
+	}
+
 	pSizer->AddObject(this, nSize);
 }
 
@@ -1794,6 +1937,7 @@ void CCryPak::RecordFileOpen( bool bEnable )
 void CCryPak::EnumerateRecordedFiles( RecordedFilesEnumCallback enumCallback )
 {
 	assert( enumCallback );
+	AUTO_LOCK(m_csRecordedFiles);
 	for (RecordedFilesSet::const_iterator it = m_recordedFilesSet.begin(); it != m_recordedFilesSet.end(); ++it)
 	{
 		enumCallback( (*it).c_str() );
@@ -1805,6 +1949,8 @@ void CCryPak::RecordFile( const char *szFilename )
 {
 	if (m_bRememberOpenedFiles)
 	{
+		// may be called from the stream engine thread as well
+		AUTO_LOCK(m_csRecordedFiles);
 		m_recordedFilesSet.insert( szFilename );
 	}
 }
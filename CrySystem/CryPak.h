@@ -48,12 +48,10 @@ struct CCachedFileData: public _reference_target_MT_novtbl<CCachedFileData>
 	void * __cdecl operator new   (size_t size) { return g_pSmallHeap->Alloc(size, "CCachedFileData::new"); } 
 	void __cdecl operator delete  (void *p) { g_pSmallHeap->Free(p); };
 
-	unsigned GetFileDataOffset()
-	{
-		if (m_pFileEntry->nFileDataOffset == m_pFileEntry->INVALID_DATA_OFFSET)
-			m_pZip->Refresh (m_pFileEntry);
-		return m_pFileEntry->nFileDataOffset;
-	}
+	unsigned GetFileDataOffset();
+
+	// the lock for the operations on the FILE* of the zip
+	static CCritSection& GetZipFileLock(ZipDir::Cache* pZip);
 
 	unsigned sizeofThis()const
 	{
@@ -211,6 +209,164 @@ protected:
 TYPEDEF_AUTOPTR(CCryPakFindData);
 
 
+//////////////////////////////////////////////////////////////////////
+// identifies a path by two independent 32-bit hashes of its normalized form:
+// case-insensitive, both slashes are the same and duplicate slashes are skipped,
+// so differently spelled paths of the same file give the same hash.
+// The hash can be built incrementally (directory, then the name in it)
+struct CPathHash
+{
+	unsigned nHash1, nHash2;
+	bool bLastSlash;
+
+	CPathHash():
+		nHash1(2166136261u), nHash2(5381), bLastSlash(false)
+	{
+	}
+
+	explicit CPathHash (const char* szPath):
+		nHash1(2166136261u), nHash2(5381), bLastSlash(false)
+	{
+		Add(szPath);
+	}
+
+	void Add (const char* szPath)
+	{
+		for (; *szPath; ++szPath)
+		{
+			unsigned c = (unsigned char)*szPath;
+			if (c == '/' || c == '\\')
+			{
+				if (bLastSlash)
+					continue;
+				bLastSlash = true;
+				c = '\\';
+			}
+			else
+			{
+				bLastSlash = false;
+				c = tolower(c);
+			}
+			nHash1 = (nHash1 ^ c) * 16777619u;
+			nHash2 = nHash2 * 33 + c;
+		}
+	}
+
+	// the form of the path that's hashed, for the tables that compare the paths on a hit
+	static void Normalize (const char* szPath, string& strOut)
+	{
+		strOut.resize(0);
+		bool bSlash = false;
+		for (; *szPath; ++szPath)
+		{
+			char c = *szPath;
+			if (c == '/' || c == '\\')
+			{
+				if (bSlash)
+					continue;
+				bSlash = true;
+				c = '\\';
+			}
+			else
+			{
+				bSlash = false;
+				c = tolower(c);
+			}
+			strOut += c;
+		}
+	}
+
+	// mixes in something that's not part of the path, e.g. flags
+	void AddValue (unsigned nValue)
+	{
+		nHash1 = (nHash1 ^ nValue) * 16777619u;
+		nHash2 = nHash2 * 33 + (nValue ^ 0x5bd1e995);
+	}
+
+	bool operator == (const CPathHash& right)const
+	{
+		return nHash1 == right.nHash1 && nHash2 == right.nHash2;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// open addressing (linear probing) hash table keyed by CPathHash.
+// The table doesn't keep the path strings: with 64 bits of hash, the collisions are negligible
+// for the number of files in the paks. Values that can't afford a wrong hit keep the path themselves
+template <class T>
+class CPathHashTable
+{
+public:
+	CPathHashTable(): m_nCount(0) {}
+
+	size_t size()const {return m_nCount;}
+	bool empty()const {return m_nCount == 0;}
+
+	void clear()
+	{
+		m_arrEntries.clear();
+		m_nCount = 0;
+	}
+
+	T* find (const CPathHash& key)
+	{
+		if (m_arrEntries.empty())
+			return NULL;
+		size_t nMask = m_arrEntries.size() - 1;
+		for (size_t i = key.nHash1 & nMask; m_arrEntries[i].bUsed; i = (i + 1) & nMask)
+			if (m_arrEntries[i].key == key)
+				return &m_arrEntries[i].value;
+		return NULL;
+	}
+
+	// inserts the value or replaces the one that's already there with the same key
+	void insert (const CPathHash& key, const T& value)
+	{
+		if ((m_nCount + 1) * 2 > m_arrEntries.size())
+			grow();
+		size_t nMask = m_arrEntries.size() - 1;
+		size_t i = key.nHash1 & nMask;
+		while (m_arrEntries[i].bUsed && !(m_arrEntries[i].key == key))
+			i = (i + 1) & nMask;
+		if (!m_arrEntries[i].bUsed)
+		{
+			m_arrEntries[i].bUsed = true;
+			m_arrEntries[i].key = key;
+			++m_nCount;
+		}
+		m_arrEntries[i].value = value;
+	}
+
+	size_t sizeofThis()const
+	{
+		return m_arrEntries.capacity() * sizeof(Entry);
+	}
+
+protected:
+	void grow()
+	{
+		std::vector<Entry> arrOld;
+		arrOld.swap (m_arrEntries);
+		m_arrEntries.resize (arrOld.empty() ? 1024 : arrOld.size() * 2);
+		m_nCount = 0;
+		for (typename std::vector<Entry>::iterator it = arrOld.begin(); it != arrOld.end(); ++it)
+			if (it->bUsed)
+				insert (it->key, it->value);
+	}
+
+	struct Entry
+	{
+		CPathHash key;
+		T value;
+		bool bUsed;
+		Entry(): value(), bUsed(false) {}
+	};
+	// the size is always a power of 2
+	std::vector<Entry> m_arrEntries;
+	size_t m_nCount;
+};
+
+
 
 
 //////////////////////////////////////////////////////////////////////
@@ -259,6 +415,46 @@ class CCryPak : public ICryPak
 	ZipArray m_arrZips;
 	friend class CCryPakFindData;
 
+	// the index of all files in the opened paks by their full path (bind root + path inside the zip),
+	// replaces the scan through m_arrZips. Later opened paks override the files of the earlier ones
+	struct PakFileRef
+	{
+		ZipDir::Cache* pZip; // kept alive by the m_arrZips entry while it's in the index
+		ZipDir::FileEntry* pFileEntry;
+		PakFileRef(): pZip(NULL), pFileEntry(NULL) {}
+	};
+	CPathHashTable<PakFileRef> m_mapPakFiles;
+
+	// the results of AdjustFileName by source path and flags, to skip _fullpath,
+	// the MOD directory probing and the case-insensitive search on Linux
+	struct AdjustedPath
+	{
+		string strSrc; // normalized source path, a hit with a different one is a hash collision
+		unsigned nFlags;
+		string strPath; // empty if AdjustFileName returned NULL
+		bool bFoundInPak;
+		AdjustedPath(): nFlags(0), bFoundInPak(false) {}
+	};
+	CPathHashTable<AdjustedPath> m_mapAdjustedPaths;
+	// the current directory the relative paths in m_mapAdjustedPaths were resolved against
+	string m_strAdjustedPathsCurDir;
+
+	// protects m_mapPakFiles and m_mapAdjustedPaths; only held for the lookup itself,
+	// so the stream engine thread and the main thread don't wait for each other's file I/O.
+	// Lock order: m_csZips, then m_csIndex, then m_csCachedFiles
+	CCritSection m_csIndex;
+
+	// adds the files of the pack to m_mapPakFiles; m_csIndex must be locked
+	void IndexPack (const PackDesc& desc);
+	void IndexPackDir (ZipDir::Cache* pZip, ZipDir::DirHeader* pDir, const CPathHash& hashDir);
+	// rebuilds m_mapPakFiles from m_arrZips; m_csZips and m_csIndex must be locked
+	void RebuildPakIndex();
+	// forgets the results of AdjustFileName, they depend on the set of paks and MODs
+	void ClearAdjustedPaths();
+	// AdjustFileName without the cache; bCacheable is reset if the result depends on
+	// something that isn't tracked, like the existence of a file on disk
+	const char* AdjustFileNameImpl (const char *src, char *dst, unsigned nFlags, bool *bFoundInPak, bool& bCacheable);
+
 	typedef std::set<CCryPakFindData_AutoPtr> CryPakFindDataSet;
 	CryPakFindDataSet m_setFindData;
 
@@ -277,6 +473,7 @@ class CCryPak : public ICryPak
 	bool m_bRememberOpenedFiles;
 	typedef std::set<string,stl::less_stricmp<string> > RecordedFilesSet;
 	RecordedFilesSet m_recordedFilesSet;
+	CCritSection m_csRecordedFiles;
 
 	const PakVars* m_pPakVars;
 
@@ -360,11 +557,11 @@ public:
 	// The file data object may be created in this function,
 	// and it's important that the autoptr is returned: another thread may release the existing
 	// cached data before the function returns
-	// the path must be absolute normalized lower-case with forward-slashes
+	// the path must be absolute; the case and the kind of slashes don't matter
 	CCachedFileDataPtr GetFileData(const char* szName);
 
 	// tests if the given file path refers to an existing file inside registered (opened) packs
-	// the path must be absolute normalized lower-case with forward-slashes
+	// the path must be absolute; the case and the kind of slashes don't matter
 	bool HasFileEntry (const char* szPath);
 
   virtual FILE *FOpen(const char *pName, const char *mode, unsigned nFlags);
@@ -152,6 +152,22 @@ void CrySizerStats::refresh()
 }
 
 
+// gets the statistics of the thread caches from the memory manager
+void CrySizerStats::refreshThreadCaches()
+{
+#if !defined(LINUX)
+	m_arrThreadCaches.resize (16);
+	int numThreads = CryGetThreadCacheStats (&m_arrThreadCaches[0], (int)m_arrThreadCaches.size());
+	if (numThreads > (int)m_arrThreadCaches.size())
+	{
+		m_arrThreadCaches.resize (numThreads);
+		numThreads = CryGetThreadCacheStats (&m_arrThreadCaches[0], numThreads);
+	}
+	m_arrThreadCaches.resize (numThreads < (int)m_arrThreadCaches.size() ? numThreads : m_arrThreadCaches.size());
+#endif
+}
+
+
 bool CrySizerStats::Component::GenericOrder::operator () (const Component& left, const Component& right)const
 {
 	return left.strName < right.strName;
@@ -296,6 +312,21 @@ void CrySizerStatsRenderer::render(bool bRefreshMark)
 				"%-*s:%7.1f ms",nNameWidth,szOverheadNames[i], fTime);
 		fTop += fVStep;
 	}
+
+	if (m_pStats->numThreadCaches())
+	{
+		m_pRenderer->WriteXY(m_pFont, (int)fLeft, (int)(fTop), fCharScaleX, fCharScaleY, fLightGray,fLightGray,fLightGray,1,
+			"%-*s   cached   allocs    frees refills returns",nNameWidth,"Thread caches");
+		fTop += fVStep;
+	}
+	for (unsigned i = 0; i < m_pStats->numThreadCaches(); ++i)
+	{
+		const CryThreadCacheStats& rCache = m_pStats->getThreadCache(i);
+		m_pRenderer->WriteXY(m_pFont, (int)fLeft, (int)(fTop), fCharScaleX, fCharScaleY, fLightGray,fLightGray,fLightGray,1,
+			".%-*x:%7.1fK %8u %8u %7u %7u",nNameWidth-1,rCache.thread_id, rCache.cached_bytes/1024.0f,
+			rCache.num_allocations, rCache.num_frees, rCache.num_refills, rCache.num_returns);
+		fTop += fVStep;
+	}
 }
 
 void CrySizerStatsRenderer::dump()
@@ -347,6 +378,15 @@ void CrySizerStatsRenderer::dump()
 
 		m_pLog->LogToFile ("%s%-*s:%s%s",szDepth, nNameWidth-rComp.nDepth,rComp.strName.c_str(), szSize, szCount);
 	}
+
+	if (m_pStats->numThreadCaches())
+		m_pLog->LogToFile("%-*s   cached   allocs    frees refills returns",nNameWidth,"Thread caches:");
+	for (unsigned i = 0; i < m_pStats->numThreadCaches(); ++i)
+	{
+		const CryThreadCacheStats& rCache = m_pStats->getThreadCache(i);
+		m_pLog->LogToFile(" %-*x:%7.1fK %8u %8u %7u %7u",nNameWidth-1,rCache.thread_id, rCache.cached_bytes/1024.0f,
+			rCache.num_allocations, rCache.num_frees, rCache.num_refills, rCache.num_returns);
+	}
 }
 
 
@@ -93,6 +93,12 @@ public:
 	float getTime(unsigned nTimer)const {assert (nTimer < g_numTimers);return m_fTime[nTimer];}
 	int getAgeFrames() const {return m_nAgeFrames;}
 	void incAgeFrames() {++m_nAgeFrames;}
+
+	// statistics of the per-thread caches of the memory manager
+	unsigned numThreadCaches()const {return (unsigned)m_arrThreadCaches.size();}
+	const CryThreadCacheStats& getThreadCache(unsigned nThread)const {return m_arrThreadCaches[nThread];}
+	// gets the statistics of the thread caches from the memory manager
+	void refreshThreadCaches();
 protected:
 	// refreshes the statistics built after the component array is built
 	void refresh();
@@ -110,6 +116,9 @@ protected:
 	// the age of the statistics, in frames
 	int m_nAgeFrames;
 
+	// one entry per thread that uses the memory manager
+	std::vector<CryThreadCacheStats> m_arrThreadCaches;
+
 	friend class CrySizerStatsBuilder;
 };
 
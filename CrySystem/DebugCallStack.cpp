@@ -387,6 +387,8 @@ int	DebugCallStack::handleException( void *exception_pointer )
 	if (!firstTime)
 	{
 		CryLogAlways( "Critical Exception! Called Multiple Times!" );
+		if (m_pSystem && m_pSystem->GetILog())
+			m_pSystem->GetILog()->FlushAfterCrash();
 		// Exception called more then once.
 		exit(1);
 	}
@@ -406,6 +408,10 @@ int	DebugCallStack::handleException( void *exception_pointer )
 		// Rise exception to call updateCallStack method.
 		updateCallStack( exception_pointer );
 
+		// the log must be in the file whatever happens in the dialog
+		if (m_pSystem && m_pSystem->GetILog())
+			m_pSystem->GetILog()->FlushAfterCrash();
+
 		//! Print exception dialog.
 		ret = PrintException( pex );
 
@@ -422,6 +428,10 @@ int	DebugCallStack::handleException( void *exception_pointer )
 	}
 	*/
 
+	// the dialog logs the call stack
+	if (m_pSystem && m_pSystem->GetILog())
+		m_pSystem->GetILog()->FlushAfterCrash();
+
 	if (pex->ExceptionRecord->ExceptionFlags & EXCEPTION_NONCONTINUABLE)
 	{
 		// This is non continuable exception. abort application now.
@@ -47,6 +47,9 @@ BOOL APIENTRY DllMain( HANDLE hModule,
 		
 		break;
 	case DLL_THREAD_DETACH:
+		// the small objects cached by the thread go back to the memory manager
+		CryFlushThreadCache();
+		break;
 	case DLL_PROCESS_DETACH: 
 		break;
 	}
@@ -149,6 +149,7 @@ CFrameProfileSystem::CFrameProfileSystem()
 	m_displayQuantity = SELF_TIME;
 
 	m_bCollect = false;
+	m_nMainThreadId = 0;
 	m_bDisplay = false;
 	m_bDisplayMemoryInfo = false;
 	m_bLogMemoryInfo = false;
@@ -214,6 +215,7 @@ CFrameProfileSystem::~CFrameProfileSystem()
 void CFrameProfileSystem::Init( ISystem *pSystem )
 {
 	m_pSystem = pSystem;
+	m_nMainThreadId = GetCurrentThreadId();
 
 	CFrameProfilerTimer::Init();
 }
@@ -418,7 +420,7 @@ void CFrameProfileSystem::AddFrameProfiler( CFrameProfiler *pProfiler )
 //////////////////////////////////////////////////////////////////////////
 void CFrameProfileSystem::StartProfilerSection( CFrameProfilerSection *pSection )
 {
-	if (!m_bCollect)
+	if (!m_bCollect || GetCurrentThreadId()!=m_nMainThreadId)
 		return;
 
 	pSection->m_excludeTime = 0;
@@ -430,7 +432,7 @@ void CFrameProfileSystem::StartProfilerSection( CFrameProfilerSection *pSection
 //////////////////////////////////////////////////////////////////////////
 void CFrameProfileSystem::EndProfilerSection( CFrameProfilerSection *pSection )
 {
-	if (!m_bCollect)
+	if (!m_bCollect || GetCurrentThreadId()!=m_nMainThreadId)
 		return;
 
 	int64 endTime;
@@ -59,6 +59,8 @@ public:
 	
 	//! If set profiling data will be collected.
 	bool m_bCollect;
+	//! Thread that owns the profiler section stack, sections opened on other threads are ignored.
+	DWORD m_nMainThreadId;
 	//! If set profiling data will be displayed.
 	bool m_bDisplay;
 	//! True if network profiling is enabled.
@@ -1,39 +1,46 @@
 #include "StdAfx.h"
 #include "JobManager.h"
 #include <ISystem.h>
+#include <ITimer.h>
+#include <ILog.h>
 
 #if defined(WIN32) || defined(WIN64)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <process.h>
+#else
+#include <sched.h>
 #endif
 
+// upper limit for the ranges of one ParallelFor call
+#define JOBMANAGER_MAX_RANGES 64
+// empty polls of a waiting thread before it starts to give up its time slice for longer
+#define JOBMANAGER_WAIT_SPINS 1000
+
 CJobManager::CJobManager()
 {
-    m_hJobAvailable = NULL;
-    m_hAllJobsCompleted = NULL;
+    m_hWorkAvailable = NULL;
+    m_nSleeping = 0;
     m_bShutdown = false;
-    m_nJobsPending = 0;
+#if defined(WIN32) || defined(WIN64)
+    m_dwQueueTls = TLS_OUT_OF_INDEXES;
+#else
+    m_dwQueueTls = 0;
+#endif
+    // the shared queue exists without workers, so jobs still run (on the waiting thread)
+    m_queues.push_back(new SQueue);
 }
 
 CJobManager::~CJobManager()
 {
     ShutDown();
+    for (size_t i = 0; i < m_queues.size(); i++)
+        delete m_queues[i];
 }
 
 bool CJobManager::Init(int nThreads)
 {
 #if defined(WIN32) || defined(WIN64)
-    // Manual-reset, initially unsignaled
-    m_hJobAvailable = CreateEvent(NULL, TRUE, FALSE, NULL);
-    // Manual-reset, initially signaled (0 jobs)
-    m_hAllJobsCompleted = CreateEvent(NULL, TRUE, TRUE, NULL);
-
-    if (!m_hJobAvailable || !m_hAllJobsCompleted)
-        return false;
-
-    m_bShutdown = false;
-
     // Determine number of threads if nThreads <= 0
     if (nThreads <= 0)
     {
@@ -43,10 +50,27 @@ bool CJobManager::Init(int nThreads)
         if (nThreads < 1) nThreads = 1;
     }
 
+    m_hWorkAvailable = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+    m_dwQueueTls = TlsAlloc();
+    if (!m_hWorkAvailable || m_dwQueueTls == TLS_OUT_OF_INDEXES)
+        return false;
+
+    m_bShutdown = false;
+
+    // worker queues in front of the shared one; the params are not moved any more once the threads run
+    SQueue* pShared = m_queues.back();
+    m_queues.resize(nThreads + 1);
+    for (int i = 0; i < nThreads; i++)
+        m_queues[i] = new SQueue;
+    m_queues[nThreads] = pShared;
+    m_params.resize(nThreads);
+
     for (int i = 0; i < nThreads; i++)
     {
+        m_params[i].pMgr = this;
+        m_params[i].nQueue = i;
         DWORD dwThreadId;
-        THREAD_HANDLE hThread = CreateThread(NULL, 0, WorkerThreadEntry, this, 0, &dwThreadId);
+        THREAD_HANDLE hThread = CreateThread(NULL, 0, WorkerThreadEntry, &m_params[i], 0, &dwThreadId);
         if (hThread)
         {
             m_threads.push_back(hThread);
@@ -61,13 +85,16 @@ bool CJobManager::Init(int nThreads)
 
 void CJobManager::ShutDown()
 {
+    // let the workers finish what was queued
+    WaitForAllJobs();
+
     m_bShutdown = true;
 
 #if defined(WIN32) || defined(WIN64)
-    if (m_hJobAvailable)
+    if (m_hWorkAvailable && !m_threads.empty())
     {
-        // Signal event to wake up all threads (Manual Reset)
-        SetEvent((HANDLE)m_hJobAvailable);
+        // wake up all threads
+        ReleaseSemaphore((HANDLE)m_hWorkAvailable, (LONG)m_threads.size(), NULL);
     }
 
     for (size_t i = 0; i < m_threads.size(); i++)
@@ -80,143 +107,332 @@ void CJobManager::ShutDown()
     }
     m_threads.clear();
 
-    if (m_hJobAvailable)
+    if (m_hWorkAvailable)
     {
-        CloseHandle((HANDLE)m_hJobAvailable);
-        m_hJobAvailable = NULL;
+        CloseHandle((HANDLE)m_hWorkAvailable);
+        m_hWorkAvailable = NULL;
     }
-    if (m_hAllJobsCompleted)
+    if (m_dwQueueTls != TLS_OUT_OF_INDEXES)
     {
-        CloseHandle((HANDLE)m_hAllJobsCompleted);
-        m_hAllJobsCompleted = NULL;
+        TlsFree(m_dwQueueTls);
+        m_dwQueueTls = TLS_OUT_OF_INDEXES;
     }
 #endif
 }
 
+int CJobManager::GetQueueIndex()
+{
+#if defined(WIN32) || defined(WIN64)
+    if (!m_threads.empty())
+    {
+        INT_PTR nIndex = (INT_PTR)TlsGetValue(m_dwQueueTls);
+        if (nIndex > 0)
+            return (int)nIndex - 1;
+    }
+#endif
+    return (int)m_queues.size() - 1;
+}
+
 void CJobManager::AddJob(JobFunc pFunc, void* pData)
 {
-    AUTO_LOCK(m_csJobQueue);
+    AddJob(pFunc, pData, 0, 0);
+}
+
+void CJobManager::AddJob(JobFunc pFunc, void* pData, JobCounter* pCounter, JobCounter* pDependsOn)
+{
+    Job job(pFunc, pData, pCounter);
 
-    if (m_nJobsPending == 0)
+    // counted before it is queued, so a waiter can't miss it
+    InterlockedIncrement(&m_allJobs.nJobs);
+    if (pCounter)
+        InterlockedIncrement(&pCounter->nJobs);
+
+    if (pDependsOn)
     {
-#if defined(WIN32) || defined(WIN64)
-        ResetEvent((HANDLE)m_hAllJobsCompleted);
-#endif
+        // the counter is checked under the same lock the finishing job takes to release the waiting jobs
+        AUTO_LOCK(m_csWaiting);
+        if (pDependsOn->nJobs != 0)
+        {
+            m_waitingJobs.insert(WaitingJobs::value_type(pDependsOn, job));
+            return;
+        }
     }
 
-    m_jobQueue.push_back(Job(pFunc, pData));
-    m_nJobsPending++;
+    PushJob(job, GetQueueIndex());
+}
 
-#if defined(WIN32) || defined(WIN64)
-    SetEvent((HANDLE)m_hJobAvailable);
-#endif
+void CJobManager::PushJob(const Job& job, int nQueue)
+{
+    {
+        SQueue* pQueue = m_queues[nQueue];
+        CAutoLock<CCritSection> lock(pQueue->cs);
+        pQueue->jobs.push_back(job);
+    }
+    WakeWorker();
 }
 
-void CJobManager::WaitForAllJobs()
+void CJobManager::WakeWorker()
 {
+#if defined(WIN32) || defined(WIN64)
+    // only pay for the semaphore if a worker sleeps
     while (true)
     {
-        m_csJobQueue.Lock();
-        if (m_nJobsPending == 0)
+        long nSleeping = m_nSleeping;
+        if (nSleeping <= 0)
+            return;
+        if (InterlockedCompareExchange(&m_nSleeping, nSleeping - 1, nSleeping) == nSleeping)
         {
-            m_csJobQueue.Unlock();
+            ReleaseSemaphore((HANDLE)m_hWorkAvailable, 1, NULL);
             return;
         }
+    }
+#endif
+}
 
-        if (!m_jobQueue.empty())
+bool CJobManager::PopJob(Job& job, int nQueue)
+{
+    int nQueues = (int)m_queues.size();
+    int nShared = nQueues - 1;
+
+    if (nQueue != nShared)
+    {
+        SQueue* pQueue = m_queues[nQueue];
+        CAutoLock<CCritSection> lock(pQueue->cs);
+        if (!pQueue->jobs.empty())
         {
-            // Steal a job
-            Job job = m_jobQueue.front();
-            m_jobQueue.pop_front();
+            job = pQueue->jobs.back();
+            pQueue->jobs.pop_back();
+            return true;
+        }
+    }
 
-            if (m_jobQueue.empty())
-            {
-#if defined(WIN32) || defined(WIN64)
-                ResetEvent((HANDLE)m_hJobAvailable);
-#endif
-            }
-            m_csJobQueue.Unlock();
-
-            // Execute job
-            if (job.pFunc)
-            {
-                job.pFunc(job.pData);
-            }
-
-            // Decrement pending
-            m_csJobQueue.Lock();
-            m_nJobsPending--;
-            if (m_nJobsPending == 0)
-            {
-#if defined(WIN32) || defined(WIN64)
-                SetEvent((HANDLE)m_hAllJobsCompleted);
-#endif
-            }
-            m_csJobQueue.Unlock();
+    // steal, starting with the shared queue and then the next worker
+    for (int i = 0; i < nQueues; i++)
+    {
+        int nVictim = (nShared + i) % nQueues;
+        if (nVictim == nQueue && i)
+            continue;
+        SQueue* pQueue = m_queues[nVictim];
+        if (pQueue->jobs.empty())
+            continue; // unlocked peek, checked again under the lock
+        CAutoLock<CCritSection> lock(pQueue->cs);
+        if (!pQueue->jobs.empty())
+        {
+            job = pQueue->jobs.front();
+            pQueue->jobs.pop_front();
+            return true;
         }
-        else
+    }
+    return false;
+}
+
+void CJobManager::RunJob(const Job& job, int nQueue)
+{
+    if (job.pFunc)
+    {
+        job.pFunc(job.pData);
+    }
+
+    if (job.pCounter && InterlockedDecrement(&job.pCounter->nJobs) == 0)
+    {
+        // start the jobs that waited for this counter
+        std::vector<Job> released;
+        {
+            AUTO_LOCK(m_csWaiting);
+            std::pair<WaitingJobs::iterator, WaitingJobs::iterator> range = m_waitingJobs.equal_range(job.pCounter);
+            for (WaitingJobs::iterator it = range.first; it != range.second; ++it)
+                released.push_back(it->second);
+            m_waitingJobs.erase(range.first, range.second);
+        }
+        for (size_t i = 0; i < released.size(); i++)
+            PushJob(released[i], nQueue);
+    }
+
+    InterlockedDecrement(&m_allJobs.nJobs);
+}
+
+void CJobManager::WaitForAllJobs()
+{
+    WaitForJobs(&m_allJobs);
+}
+
+void CJobManager::WaitForJobs(JobCounter* pCounter)
+{
+    if (!pCounter)
+        return;
+
+    int nQueue = GetQueueIndex();
+    int nSpins = 0;
+    Job job;
+    while (pCounter->nJobs != 0)
+    {
+        if (PopJob(job, nQueue))
         {
-            m_csJobQueue.Unlock();
+            RunJob(job, nQueue);
+            nSpins = 0;
+            continue;
+        }
 #if defined(WIN32) || defined(WIN64)
-            WaitForSingleObject((HANDLE)m_hAllJobsCompleted, INFINITE);
+        // the remaining jobs run on the workers
+        Sleep(++nSpins < JOBMANAGER_WAIT_SPINS ? 0 : 1);
 #else
-            return;
+        // no workers: the remaining jobs run on other threads that wait as well, the jobs that
+        // depend on them are released into the shared queue when they are done and popped here
+        sched_yield();
 #endif
-        }
     }
+    assert(pCounter->nJobs == 0);
+}
+
+struct SParallelForRange
+{
+    ParallelForFunc pFunc;
+    void*           pData;
+    int             nBegin;
+    int             nEnd;
+};
+
+static void ParallelForJob(void* pData)
+{
+    SParallelForRange* pRange = (SParallelForRange*)pData;
+    pRange->pFunc(pRange->pData, pRange->nBegin, pRange->nEnd);
+}
+
+void CJobManager::ParallelFor(int nCount, int nGranularity, ParallelForFunc pFunc, void* pData)
+{
+    if (nCount <= 0)
+        return;
+    if (nGranularity < 1)
+        nGranularity = 1;
+
+    // a few ranges per thread, so the stealing can even out ranges of different cost
+    int nRanges = (nCount + nGranularity - 1) / nGranularity;
+    int nMaxRanges = (GetWorkerCount() + 1) * 4;
+    if (nMaxRanges > JOBMANAGER_MAX_RANGES)
+        nMaxRanges = JOBMANAGER_MAX_RANGES;
+    if (nRanges > nMaxRanges)
+        nRanges = nMaxRanges;
+    if (nRanges < 2 || m_threads.empty())
+    {
+        pFunc(pData, 0, nCount);
+        return;
+    }
+
+    SParallelForRange ranges[JOBMANAGER_MAX_RANGES];
+    for (int i = 0; i < nRanges; i++)
+    {
+        ranges[i].pFunc = pFunc;
+        ranges[i].pData = pData;
+        ranges[i].nBegin = (int)((int64)nCount * i / nRanges);
+        ranges[i].nEnd = (int)((int64)nCount * (i + 1) / nRanges);
+    }
+
+    JobCounter counter;
+    for (int i = 1; i < nRanges; i++)
+        AddJob(ParallelForJob, ranges + i, &counter);
+    ParallelForJob(ranges);
+    WaitForJobs(&counter);
 }
 
 DWORD WINAPI CJobManager::WorkerThreadEntry(void* pParam)
 {
-    CJobManager* pMgr = (CJobManager*)pParam;
-    pMgr->WorkerThread();
+    SWorkerParam* pWorker = (SWorkerParam*)pParam;
+    pWorker->pMgr->WorkerThread(pWorker->nQueue);
     return 0;
 }
 
-void CJobManager::WorkerThread()
+void CJobManager::WorkerThread(int nQueue)
 {
 #if defined(WIN32) || defined(WIN64)
-    while (true)
-    {
-        WaitForSingleObject((HANDLE)m_hJobAvailable, INFINITE);
+    TlsSetValue(m_dwQueueTls, (void*)(INT_PTR)(nQueue + 1));
 
-        m_csJobQueue.Lock();
-        if (m_bShutdown)
+    Job job;
+    while (!m_bShutdown)
+    {
+        if (PopJob(job, nQueue))
         {
-            m_csJobQueue.Unlock();
-            break;
+            RunJob(job, nQueue);
+            continue;
         }
 
-        if (m_jobQueue.empty())
+        // announce the sleep before the last look, so a job added meanwhile wakes this worker
+        InterlockedIncrement(&m_nSleeping);
+        if (PopJob(job, nQueue))
         {
-            ResetEvent((HANDLE)m_hJobAvailable);
-            m_csJobQueue.Unlock();
+            // undo the announcement; if a waker took it already, the extra count only causes one spurious wake
+            long nSleeping = m_nSleeping;
+            while (nSleeping > 0 && InterlockedCompareExchange(&m_nSleeping, nSleeping - 1, nSleeping) != nSleeping)
+                nSleeping = m_nSleeping;
+            RunJob(job, nQueue);
             continue;
         }
+        WaitForSingleObject((HANDLE)m_hWorkAvailable, INFINITE);
+    }
+#endif
+}
 
-        Job job = m_jobQueue.front();
-        m_jobQueue.pop_front();
+//////////////////////////////////////////////////////////////////////////
+// Benchmark (sys_BenchJobs)
+//////////////////////////////////////////////////////////////////////////
+static void EmptyJob(void* pData)
+{
+}
 
-        if (m_jobQueue.empty())
-        {
-            ResetEvent((HANDLE)m_hJobAvailable);
-        }
+struct SBenchFanOut
+{
+    CJobManager* pMgr;
+    JobCounter*  pCounter;
+    int          nChildren;
+};
+
+// adds its children to the counter it was added with, so the waiter sees them before it reaches 0
+static void FanOutJob(void* pData)
+{
+    SBenchFanOut* pFanOut = (SBenchFanOut*)pData;
+    for (int i = 0; i < pFanOut->nChildren; i++)
+        pFanOut->pMgr->AddJob(EmptyJob, 0, pFanOut->pCounter);
+}
 
-        m_csJobQueue.Unlock();
+void CJobManager::RunBenchmark(int nMaxWorkers, int nJobs)
+{
+    ITimer* pTimer = GetISystem()->GetITimer();
+    ILog* pLog = GetISystem()->GetILog();
+    if (nJobs < 1)
+        nJobs = 1;
 
-        // Execute job
-        if (job.pFunc)
+    for (int nWorkers = 1; nWorkers <= nMaxWorkers; nWorkers++)
+    {
+        CJobManager mgr;
+        if (!mgr.Init(nWorkers))
         {
-            job.pFunc(job.pData);
+            pLog->Log("JobBench: can't start %d workers", nWorkers);
+            break;
         }
 
-        m_csJobQueue.Lock();
-        m_nJobsPending--;
-        if (m_nJobsPending == 0)
+        // jobs added by the waiting thread
+        JobCounter counter;
+        float fStart = pTimer->GetAsyncCurTime();
+        for (int i = 0; i < nJobs; i++)
+            mgr.AddJob(EmptyJob, 0, &counter);
+        mgr.WaitForJobs(&counter);
+        float fAdded = pTimer->GetAsyncCurTime() - fStart;
+
+        // jobs added by jobs on the workers, 64 per parent
+        const int nChildren = 64;
+        int nParents = (nJobs + nChildren - 1) / nChildren;
+        std::vector<SBenchFanOut> parents(nParents);
+        fStart = pTimer->GetAsyncCurTime();
+        for (int i = 0; i < nParents; i++)
         {
-            SetEvent((HANDLE)m_hAllJobsCompleted);
+            parents[i].pMgr = &mgr;
+            parents[i].pCounter = &counter;
+            parents[i].nChildren = nChildren;
+            mgr.AddJob(FanOutJob, &parents[i], &counter);
         }
-        m_csJobQueue.Unlock();
+        mgr.WaitForJobs(&counter);
+        float fSpawned = pTimer->GetAsyncCurTime() - fStart;
+
+        pLog->Log("JobBench %d workers: %.3f us per empty job added by the caller, %.3f us per job added by jobs",
+            nWorkers, fAdded * 1000000.0f / nJobs, fSpawned * 1000000.0f / (nParents * (nChildren + 1)));
     }
-#endif
 }
@@ -8,7 +8,13 @@
 #include "CritSection.h"
 #include <deque>
 #include <vector>
+#include <map>
 
+// Work-stealing job manager.
+// Every worker has its own queue: it pushes and pops its own jobs at the back (the most recent
+// job is the one with the warm caches) and idle threads steal from the front of the other queues.
+// Jobs added by threads that are not workers go to an extra shared queue. Each queue has its own
+// lock, so the workers only meet on a lock when they steal.
 class CJobManager : public IJobManager
 {
 public:
@@ -20,23 +26,55 @@ public:
 
     // IJobManager interface
     virtual void AddJob(JobFunc pFunc, void* pData);
+    virtual void AddJob(JobFunc pFunc, void* pData, JobCounter* pCounter, JobCounter* pDependsOn = 0);
     virtual void WaitForAllJobs();
+    virtual void WaitForJobs(JobCounter* pCounter);
+    virtual void ParallelFor(int nCount, int nGranularity, ParallelForFunc pFunc, void* pData);
+    virtual int GetWorkerCount() { return (int)m_threads.size(); }
+
+    // Measures the scheduling overhead of empty jobs with 1..nMaxWorkers workers and logs it
+    static void RunBenchmark(int nMaxWorkers, int nJobs);
 
 private:
-    void WorkerThread();
+    struct SQueue
+    {
+        std::deque<Job> jobs;
+        CCritSection    cs;
+    };
+
+    struct SWorkerParam
+    {
+        CJobManager* pMgr;
+        int          nQueue;
+    };
+
+    void WorkerThread(int nQueue);
     static DWORD WINAPI WorkerThreadEntry(void* pParam);
 
-private:
-    std::deque<Job> m_jobQueue;
-    CCritSection    m_csJobQueue;
+    // index of the queue of the calling thread, the shared queue for non-workers
+    int  GetQueueIndex();
+    void PushJob(const Job& job, int nQueue);
+    // own queue from the back, then the shared queue and the other workers from the front
+    bool PopJob(Job& job, int nQueue);
+    void RunJob(const Job& job, int nQueue);
+    void WakeWorker();
 
+private:
+    std::vector<SQueue*>       m_queues;        // one per worker + the shared queue at the end
     std::vector<THREAD_HANDLE> m_threads;
+    std::vector<SWorkerParam>  m_params;
+
+    EVENT_HANDLE   m_hWorkAvailable;            // semaphore, one count per worker to wake
+    volatile long  m_nSleeping;                 // workers waiting on m_hWorkAvailable
+    volatile bool  m_bShutdown;
+    DWORD          m_dwQueueTls;                // TLS index, holds the queue index+1 in the workers
 
-    EVENT_HANDLE m_hJobAvailable;
-    bool         m_bShutdown;
+    JobCounter     m_allJobs;                   // all jobs not done yet, for WaitForAllJobs
 
-    int             m_nJobsPending; // Jobs in queue + jobs running
-    EVENT_HANDLE    m_hAllJobsCompleted;
+    // jobs that wait for a counter to reach 0
+    typedef std::multimap<JobCounter*, Job> WaitingJobs;
+    WaitingJobs    m_waitingJobs;
+    CCritSection   m_csWaiting;
 };
 
 #endif // _JOBMANAGER_H_
@@ -28,6 +28,13 @@
 //#define RETURN return
 #define RETURN
 
+// if the writer thread falls this far behind, the logging thread writes the lines itself
+#define LOG_MAX_QUEUED_LINES	4096
+// size of the line queue in bytes, power of 2 and much bigger than a line (MAX_TEMP_LENGTH_SIZE)
+#define LOG_QUEUE_SIZE				0x40000
+// stdio buffer of the log file
+#define LOG_FILE_BUFFER_SIZE	0x10000
+
 
 //////////////////////////////////////////////////////////////////////
 
@@ -40,11 +47,29 @@ CLog::CLog( ISystem *pSystem )
 	m_pLogVerbosity = 0;
 	m_pLogFileVerbosity = 0;
 	m_pLogIncludeTime = 0;
+
+	// allocated once, logging doesn't allocate memory
+	m_pQueue = (char*)malloc(LOG_QUEUE_SIZE);
+	memset(m_pQueue,0,LOG_QUEUE_SIZE);
+	m_nQueueWrite = 0;
+	m_nQueueRead = 0;
+	m_nQueued = 0;
+	m_pFile = 0;
+	m_bNewLinePending = false;
+	m_hWriter = 0;
+	m_hWakeWriter = 0;
+	m_bStopWriter = false;
 }
 
 //////////////////////////////////////////////////////////////////////
 CLog::~CLog()
 {
+	StopWriter();
+	{
+		AUTO_LOCK(m_csFile);
+		CloseFile();
+	}
+	free(m_pQueue);
 	Done();
 }
 
@@ -199,7 +224,12 @@ void CLog::LogV( const ELogType type, const char* szFormat, va_list args )
 	szBuffer[sizeof(szBuffer)-8]=0;
 
 	if (bfile)
+	{
 		LogStringToFile( szString );
+		// errors must be on disk in case the application doesn't survive them
+		if (type == eError || type == eErrorAlways || szFormat[0] == '\001')
+			Flush();
+	}
 	if (bconsole)
 		LogStringToConsole( szString );	
 
@@ -418,31 +448,244 @@ void CLog::LogStringToFile( const char *szString,bool bAdd )
 	}
 #endif
 
-	if (bAdd)
+	PushLine( szTemp,bAdd );
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::PushLine( const char* szString,bool bAdd )
+{
+	size_t nLen = strlen(szString);
+	if (nLen >= MAX_TEMP_LENGTH_SIZE)
+		nLen = MAX_TEMP_LENGTH_SIZE-1;
+	LONG nSize = (LONG)(offsetof(SLogLine,szText)+nLen+1+7) & ~7;
+
+	// take the space of the line; a line never wraps around the end of the buffer, when it doesn't
+	// fit the end is taken too and skipped by the writer
+	LONG nWrite,nOffset,nSkip;
+	for(;;)
 	{
-		FILE *fp=fxopen(m_szFilename,"r+t");
-		if (fp)
+		nWrite = m_nQueueWrite;
+		nOffset = nWrite & (LOG_QUEUE_SIZE-1);
+		nSkip = nOffset+nSize > LOG_QUEUE_SIZE ? LOG_QUEUE_SIZE-nOffset : 0;
+		if ((DWORD)(nWrite+nSkip+nSize-m_nQueueRead) > LOG_QUEUE_SIZE)
 		{
-			int p1 = ftell(fp);
-			fseek(fp,0,SEEK_END);
-			p1 = ftell(fp);
-			fseek(fp,-2,SEEK_CUR);
-			p1 = ftell(fp);
-
-			fputs(szTemp,fp);		
-			fclose(fp);
+			// the queue is full
+			WriteQueuedLines(false);
+			continue;
 		}
+		if (InterlockedCompareExchange(&m_nQueueWrite,nWrite+nSkip+nSize,nWrite) == nWrite)
+			break;
+	}
+	LONG nQueued = InterlockedIncrement(&m_nQueued);
+
+	if (nSkip)
+	{
+		SLogLine *pSkip = (SLogLine*)(m_pQueue+nOffset);
+		pSkip->bSkip = true;
+		InterlockedExchange(&pSkip->nSize,nSkip);
+		nOffset = 0;
 	}
+	SLogLine *pLine = (SLogLine*)(m_pQueue+nOffset);
+	pLine->bAdd = bAdd;
+	pLine->bSkip = false;
+	memcpy(pLine->szText,szString,nLen);
+	pLine->szText[nLen] = 0;
+	// the writer takes the line once the size is set
+	InterlockedExchange(&pLine->nSize,nSize);
+
+	if (!m_hWriter || nQueued > LOG_MAX_QUEUED_LINES)
+		WriteQueuedLines(false);
 	else
+	if (nQueued == 1)
+		SetEvent(m_hWakeWriter);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::WriteQueuedLines( bool bFlush )
+{
+	AUTO_LOCK(m_csFile);
+	WriteQueue(bFlush);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// m_csFile must be locked
+void CLog::WriteQueue( bool bFlush )
+{
+	if (!m_pFile)
+		OpenFile();
+
+	LONG nRead = m_nQueueRead, nLines = 0;
+	while (nRead != m_nQueueWrite)
+	{
+		SLogLine *pLine = (SLogLine*)(m_pQueue+(nRead & (LOG_QUEUE_SIZE-1)));
+		LONG nSize = pLine->nSize;
+		if (!nSize)
+			break;	// still being copied in, the next call continues here
+		if (!pLine->bSkip)
+		{
+			WriteLine(pLine->szText,pLine->bAdd);
+			++nLines;
+		}
+		// a line can start anywhere, so the sizes read as 0 only if the whole space is cleared
+		memset(pLine,0,nSize);
+		nRead += nSize;
+		InterlockedExchange(&m_nQueueRead,nRead);
+	}
+	if (nLines)
+		InterlockedExchangeAdd(&m_nQueued,-nLines);
+
+	if (m_pFile)
 	{
-		if(FILE * fp = fxopen(m_szFilename,"at"))
+		// a LogToFilePlus after a flush starts a new line
+		if (bFlush && m_bNewLinePending)
 		{
-			fputs(szTemp,fp);
-			fclose(fp);
-		}  
+			fputc('\n',m_pFile);
+			m_bNewLinePending = false;
+		}
+		fflush(m_pFile);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// m_csFile must be locked
+void CLog::WriteLine( const char* szString,bool bAdd )
+{
+	if (!m_pFile)
+		return;
+
+	if (m_bNewLinePending && !bAdd)
+		fputc('\n',m_pFile);
+
+	// the '\n' is held back until the next line, LogToFilePlus continues the previous line
+	size_t nLen = strlen(szString);
+	if (nLen && szString[nLen-1] == '\n')
+	{
+		fwrite(szString,1,nLen-1,m_pFile);
+		m_bNewLinePending = true;
+	}
+	else
+	{
+		fputs(szString,m_pFile);
+		m_bNewLinePending = false;
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+// m_csFile must be locked
+void CLog::OpenFile()
+{
+	if (m_pFile || !m_szFilename[0])
+		return;
+
+	m_pFile = fxopen(m_szFilename,"at");
+	if (m_pFile)
+		setvbuf(m_pFile,NULL,_IOFBF,LOG_FILE_BUFFER_SIZE);
+	m_bNewLinePending = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// m_csFile must be locked
+void CLog::CloseFile()
+{
+	if (!m_pFile)
+		return;
+
+	if (m_bNewLinePending)
+		fputc('\n',m_pFile);
+	m_bNewLinePending = false;
+	fclose(m_pFile);
+	m_pFile = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::StartWriter()
+{
+	if (m_hWriter)
+		return;
+
+	m_bStopWriter = false;
+	m_hWakeWriter = CreateEvent(NULL,FALSE,FALSE,NULL);
+	if (!m_hWakeWriter)
+		return;
+
+	DWORD dwThreadId;
+	m_hWriter = CreateThread(NULL,0x8000,WriterThreadProc,this,0,&dwThreadId);
+	if (!m_hWriter)
+	{
+		// the lines are written by the logging threads then
+		CloseHandle(m_hWakeWriter);
+		m_hWakeWriter = 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::StopWriter()
+{
+	if (!m_hWriter)
+		return;
+
+	m_bStopWriter = true;
+	SetEvent(m_hWakeWriter);
+	WaitForSingleObject(m_hWriter,INFINITE);
+	CloseHandle(m_hWriter);
+	CloseHandle(m_hWakeWriter);
+	m_hWriter = 0;
+	m_hWakeWriter = 0;
+
+	WriteQueuedLines(true);
+}
+
+//////////////////////////////////////////////////////////////////////////
+DWORD WINAPI CLog::WriterThreadProc( void* pParam )
+{
+	CLog *pLog = (CLog*)pParam;
+
+	while (!pLog->m_bStopWriter)
+	{
+		WaitForSingleObject(pLog->m_hWakeWriter,INFINITE);
+		// lines pushed while writing don't signal the event again (the count didn't drop to 0)
+		do
+			pLog->WriteQueuedLines(false);
+		while (pLog->m_nQueued > 0 && !pLog->m_bStopWriter);
+	}
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::Flush()
+{
+	WriteQueuedLines(true);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CLog::FlushAfterCrash()
+{
+	// the writer thread may be busy for a moment, but a crashed thread never releases the lock
+	for (int i=0; i<100; i++)
+	{
+		CAutoTryLock<CCritSection> lock(m_csFile);
+		if (lock.IsLocked())
+		{
+			WriteQueue(true);
+			return;
+		}
+		Sleep(1);
+	}
+
+	// the thread holding the lock may have crashed inside of a write to m_pFile, so the
+	// lines go through a file handle of our own
+	FILE *pFile = m_szFilename[0] ? fxopen(m_szFilename,"at") : 0;
+	if (!pFile)
+		return;
+	FILE *pLogFile = m_pFile;
+	m_pFile = pFile;
+	m_bNewLinePending = false;
+	fputc('\n',m_pFile);
+	WriteQueue(true);
+	fclose(pFile);
+	m_pFile = pLogFile;
+}
+
 //same as above but to a file
 //////////////////////////////////////////////////////////////////////
 void CLog::LogToFilePlus(const char *szFormat,...)
@@ -511,13 +754,22 @@ void CLog::SetFileName(const char *command)
 	if (!command) 
     return;
 
-	strcpy(m_szFilename,command); 
+	// the lines queued so far go to the previous file
+	WriteQueuedLines(true);
+	{
+		AUTO_LOCK(m_csFile);
+		CloseFile();
+
+		strcpy(m_szFilename,command); 
 
 #ifndef _XBOX
 		FILE *fp=fxopen(m_szFilename,"wt");
     if (fp)
 		  fclose(fp);
 #endif
+		OpenFile();
+	}
+	StartWriter();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -18,6 +18,7 @@
 #endif
 
 #include <ILog.h>
+#include "CritSection.h"
 
 //////////////////////////////////////////////////////////////////////
 #define MAX_TEMP_LENGTH_SIZE	2048
@@ -54,14 +55,37 @@ public:
 	virtual void EnableVerbosity( bool bEnable );
 	virtual void SetVerbosity( int verbosity );
 	virtual	int	 GetVerbosityLevel();
+	virtual void Flush();
+	virtual void FlushAfterCrash();
 
 private:
+
+	// one line of the log file in the queue, followed by the text
+	struct SLogLine
+	{
+		volatile LONG nSize;		// bytes taken in the queue, 0 while the line is being copied in
+		bool bAdd;							// continues the previous line (LogToFilePlus)
+		bool bSkip;							// fills the end of the queue that was too short for the next line
+		char szText[1];
+	};
 	
 	virtual void LogV( const ELogType ineType, const char* szFormat, va_list args );
 	void LogStringToFile( const char* szString,bool bAdd=false );
 	void LogStringToConsole( const char* szString,bool bAdd=false );
 	void Done();
 
+	// queues the line for the writer thread, any thread may call it
+	void PushLine( const char* szString,bool bAdd );
+	// takes the queued lines and writes them in the order they were pushed
+	void WriteQueuedLines( bool bFlush );
+	void WriteQueue( bool bFlush );
+	void WriteLine( const char* szString,bool bAdd );
+	void OpenFile();
+	void CloseFile();
+	void StartWriter();
+	void StopWriter();
+	static DWORD WINAPI WriterThreadProc( void* pParam );
+
 	//will format the message into m_szTemp
 	void	FormatMessage(const char *szCommand,...);
 
@@ -74,6 +98,20 @@ private:
 	
 	ICVar			*m_pLogColoredText;	
 	IConsole	*m_pConsole;	
+
+	// the log lines are copied lock-free into the ring buffer m_pQueue by any thread and written by the
+	// writer thread into the file that stays open; errors and crashes flush the queue synchronously.
+	// The positions only grow, the offset in the buffer is the position modulo LOG_QUEUE_SIZE
+	char			*m_pQueue;
+	volatile LONG	m_nQueueWrite;			// end of the space taken by the logging threads
+	volatile LONG	m_nQueueRead;				// start of the lines not written yet
+	volatile LONG	m_nQueued;
+	FILE			*m_pFile;
+	bool			m_bNewLinePending;				// the last line was written without its '\n' so LogToFilePlus can continue it
+	CCritSection	m_csFile;						// m_pFile and the order of the writes
+	THREAD_HANDLE	m_hWriter;
+	EVENT_HANDLE	m_hWakeWriter;
+	volatile bool	m_bStopWriter;
 public:
 	// checks the verbosity of the message and returns NULL if the message must NOT be
 	// logged, or the pointer to the part of the message that should be logged
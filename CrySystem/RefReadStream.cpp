@@ -15,6 +15,7 @@ CRefReadStream::CRefReadStream (const string& strFileName, CRefStreamEngine* pEn
 	m_nSectorSize(0),
 	m_hFile (INVALID_HANDLE_VALUE),
 	m_bOverlapped ( false),
+	m_bMissingReported (false),
 	m_pZipEntry (NULL)
 {
 	pEngine->Register(this);
@@ -74,7 +75,11 @@ bool CRefReadStream::Activate()
 		{
 			DWORD dwError = GetLastError();
 			m_bError = true;
-			m_pEngine->GetPak()->OnMissingFile(m_strFileName.c_str());
+			if (!m_bMissingReported)
+			{
+				m_bMissingReported = true;
+				m_pEngine->GetPak()->OnMissingFile(m_strFileName.c_str());
+			}
 			return false;
 		}
 	}
@@ -4,6 +4,7 @@
 #include "ZipDir.h"
 #include <IStreamEngine.h>
 #include "CryPak.h"
+#include "CritSection.h"
 
 class CRefStreamEngine;
 class CRefReadStreamProxy;
@@ -79,6 +80,19 @@ public:
 		else
 			return NULL;
 	}
+
+	// returns the zip from which the data is read and the offset of the file in it,
+	// or NULL if it's not in a pak or the stream isn't activated yet
+	ZipDir::Cache* GetPakLocation (unsigned& nOffset)
+	{
+		if (!m_pZipEntry)
+			return NULL;
+		nOffset = m_pZipEntry->GetFileEntry()->nFileHeaderOffset;
+		return m_pZipEntry->GetZip();
+	}
+
+	// serializes the seek+read on the file handle when it isn't overlapped
+	CCritSection& GetFileLock() {return m_csFile;}
 private:
 	// the clients are not allowed to destroy this object directly; only via Release()
 	~CRefReadStream();
@@ -113,6 +127,11 @@ private:
 	// this flag is meaningful only with valid m_hFile. If it's true, it means the 
 	// file was opened for Overlapped access (it can't be opened so in Win 9x)
 	bool m_bOverlapped;
+
+	// the missing file was reported to the pak; the stream may be activated several times
+	bool m_bMissingReported;
+
+	CCritSection m_csFile;
 };
 
 TYPEDEF_AUTOPTR(CRefReadStream);
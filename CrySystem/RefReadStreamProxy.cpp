@@ -30,6 +30,10 @@ CRefReadStreamProxy::CRefReadStreamProxy (const char* szSource, CRefReadStream*
 	if (pParams)
 		m_Params = *pParams;
 	m_pBuffer = m_Params.pBuffer;
+
+	int64 nPerfFreq = pStream->GetEngine()->GetPerfFreq();
+	QueryPerformanceCounter ((LARGE_INTEGER*)&m_nStartTime);
+	m_nDeadline = m_nStartTime + m_Params.nLoadTime * nPerfFreq / 1000;
 #if LOG_IO
 	g_System->GetILog()->LogToFile ("\006io:CRefReadStreamProxy %p(%s, %p)", this, szSource, pCallback);
 #endif
@@ -239,12 +243,12 @@ bool CRefReadStreamProxy::StartRead (unsigned nMemQuota)
 		m_pCallback->StreamOnProgress(this);
 
 	m_bPending = true;
-	++g_numPendingOperations;
+	InterlockedIncrement(&g_numPendingOperations);
 	DWORD dwError = CallReadFileEx ();
 	if (dwError)
 	{
 		m_bPending = false;
-		--g_numPendingOperations;
+		InterlockedDecrement(&g_numPendingOperations);
 
 		bool bResult = true; // by default, signal an error
 		switch (dwError)
@@ -268,7 +272,16 @@ bool CRefReadStreamProxy::StartRead (unsigned nMemQuota)
 		return true;
 }
 
-unsigned CRefReadStreamProxy::g_numPendingOperations = 0;
+volatile LONG CRefReadStreamProxy::g_numPendingOperations = 0;
+
+// activates the stream and returns the zip from which the data will be read and
+// the offset of the data in it, or NULL if it isn't read from a pak
+ZipDir::Cache* CRefReadStreamProxy::GetPakLocation (unsigned& nOffset)
+{
+	if (m_bError || m_bFinished || m_bPending || !m_pStream->Activate())
+		return NULL;
+	return m_pStream->GetPakLocation(nOffset);
+}
 
 VOID CALLBACK CRefReadStreamProxy::FileIOCompletionRoutine (
 	DWORD dwErrorCode,                // completion code
@@ -296,7 +309,7 @@ void CRefReadStreamProxy::OnIOComplete(unsigned nError, unsigned numBytesRead)
 	if (!nError && m_numBytesRead > m_Params.nSize)
 		m_numBytesRead = m_Params.nSize;
 
-	--g_numPendingOperations;
+	InterlockedDecrement(&g_numPendingOperations);
 	m_bPending = false;
 
 	// calculate the next piece offset/length
@@ -336,7 +349,7 @@ void CRefReadStreamProxy::OnIOComplete(unsigned nError, unsigned numBytesRead)
 		}
 		else
 		{
-			++g_numPendingOperations;
+			InterlockedIncrement(&g_numPendingOperations);
 		}
 	}
 }
@@ -384,15 +397,21 @@ DWORD CRefReadStreamProxy::CallReadFileEx ()
 	{
 		// the actual number of bytes read
 		DWORD dwRead = 0;
+		BOOL bRead;
 		unsigned newOffset = m_Params.nOffset + m_nPieceOffset + m_pStream->GetArchiveOffset();
-		if (SetFilePointer (hFile, newOffset, NULL, FILE_BEGIN) != newOffset)
 		{
-			// the positioning error is strange, we should examine it and perhaps retry (in case the file write wasn't finished.)
-			DWORD dwError = GetLastError();
-			return dwError;
+			// the other proxies of this stream may be read by the other workers: seek and read at once
+			CAutoLock<CCritSection> lockFile(m_pStream->GetFileLock());
+			if (SetFilePointer (hFile, newOffset, NULL, FILE_BEGIN) != newOffset)
+			{
+				// the positioning error is strange, we should examine it and perhaps retry (in case the file write wasn't finished.)
+				DWORD dwError = GetLastError();
+				return dwError;
+			}
+			// just read the file
+			bRead = ReadFile (hFile, ((char*)m_pBuffer) + m_nPieceOffset, m_nPieceLength, &dwRead, NULL);
 		}
-		// just read the file
-		if (!ReadFile (hFile, ((char*)m_pBuffer) + m_nPieceOffset, m_nPieceLength, &dwRead, NULL))
+		if (!bRead)
 		{
 			// we failed to read; we don't call the callback, but we could as well call OnIOComplete()
 			// with this error code and return 0 as success flag emulating error during load
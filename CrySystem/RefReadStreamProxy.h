@@ -9,18 +9,31 @@
 
 #include "IStreamEngine.h"
 
+namespace ZipDir {struct Cache;}
+
 
 class CRefReadStreamProxy: public IReadStream
 {
 public:
 	// we need a MT-safe reference counting here..
 
-	// this class sets the priority order for the proxes
+	// this class sets the priority order for the proxes:
+	// the priority class, then the reads that are due at nNow, then the priority, then the earliest deadline
 	struct Order
 	{
+		int64 nNow;
+		Order(int64 _nNow): nNow(_nNow) {}
+
 		bool operator ()(const CRefReadStreamProxy* pLeft, const CRefReadStreamProxy* pRight)const 
 		{
-			return pLeft->GetPriority() > pRight->GetPriority();
+			if (pLeft->GetPriorityClass() != pRight->GetPriorityClass())
+				return pLeft->GetPriorityClass() < pRight->GetPriorityClass();
+			bool bLeftDue = pLeft->GetDeadline() <= nNow, bRightDue = pRight->GetDeadline() <= nNow;
+			if (bLeftDue != bRightDue)
+				return bLeftDue;
+			if (pLeft->GetPriority() != pRight->GetPriority())
+				return pLeft->GetPriority() > pRight->GetPriority();
+			return pLeft->GetDeadline() < pRight->GetDeadline();
 		}
 	};
 
@@ -70,6 +83,21 @@ public:
 	//static unsigned numPendingOperations() {return g_numPendingOperations;}
 
 	int GetPriority()const{return m_Params.nPriority;}
+	// one of StreamPriorityClassEnum; the reads someone waits for are urgent
+	unsigned GetPriorityClass()const
+	{
+		if (m_Params.nPriority == INT_MAX)
+			return SRPC_URGENT;
+		return m_Params.nPriorityClass < SRPC_COUNT ? m_Params.nPriorityClass : SRPC_IDLE;
+	}
+	// the time (performance counter) by which the read should be done, from nLoadTime
+	int64 GetDeadline()const {return m_nDeadline;}
+	// the time (performance counter) of the StartRead call
+	int64 GetStartTime()const {return m_nStartTime;}
+
+	// activates the stream and returns the zip from which the data will be read and
+	// the offset of the data in it, or NULL if it isn't read from a pak
+	ZipDir::Cache* GetPakLocation (unsigned& nOffset);
 
 	// this returns true after the main IO job has been executed (either in worker or in main thread)
 	bool IsIOExecuted();
@@ -89,7 +117,7 @@ public:
 protected:
 	// the number of times the StartRead was retried; after too many retries unrecoverable error is returned
 	unsigned m_numRetries;
-	static unsigned g_numPendingOperations;
+	static volatile LONG g_numPendingOperations;
 	void OnIOComplete(unsigned nError, unsigned numBytesRead);
 	// on the platforms that support overlapped IO, calls ReadFileEx.
 	// on other platforms merely reads the file, calling OnIOComplete()
@@ -125,6 +153,9 @@ protected:
 
 	bool m_bError, m_bFinished, m_bFreeBuffer, m_bPending;
 	unsigned m_nIOError;
+
+	// performance counter times, see GetStartTime() and GetDeadline()
+	int64 m_nStartTime, m_nDeadline;
 };
 
 TYPEDEF_AUTOPTR(CRefReadStreamProxy);
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <TArrays.h>
 #include <ilog.h>
+#include <CrySizer.h>
 #include "RefStreamEngine.h"
 #include "RefReadStream.h"
 #include "RefReadStreamProxy.h"
@@ -11,9 +12,16 @@
 extern CMTSafeHeap* g_pSmallHeap;
 extern CMTSafeHeap* g_pBigHeap;
 
+// the max number of jobs started in one batch (see PopIOJobBatch)
+#define STREAM_MAX_BATCH 8
+// how far in the IO queue the jobs for a batch are looked for
+#define STREAM_MAX_BATCH_SCAN 32
+
+static const char* g_szPriorityClassNames[SRPC_COUNT] = {"urgent", "high", "normal", "idle"};
+
 //////////////////////////////////////////////////////////////////////////
 // useWorkerThreads is the number of worker threads  to use;
-// currently only values 0 and 1 are supported: 0 - overlapped IO in the main thread, and 1 - overlapped IO in the worker thread
+// 0 - overlapped IO in the main thread, otherwise the IO and the unpacking of the zipped files is done by the workers
 // MT: Main thread only
 CRefStreamEngine::CRefStreamEngine (CCryPak* pPak, IMiniLog* pLog, unsigned useWorkerThreads, bool bOverlappedIO):
 	m_pPak(pPak),
@@ -21,12 +29,7 @@ CRefStreamEngine::CRefStreamEngine (CCryPak* pPak, IMiniLog* pLog, unsigned useW
 	m_nMaxReadDepth (16),
 	m_nMaxQueueLength (4*1024),
 	m_nMaxIOMemPool (128*1024*1024),
-#if defined(LINUX)
-	m_hIOWorker (INVALID_HANDLE_VALUE),//only diff is here, but what can i do?
-#else
-	m_hIOWorker (NULL),
-#endif
-	m_dwWorkerThreadId(0),
+	m_nLastSortTime(0),
 	m_queIOJobs(ProxyPtrAllocator(g_pSmallHeap)),
 	m_setIOPending(ProxyPtrPredicate(), ProxyPtrAllocator(g_pSmallHeap)),
 	m_queIOExecuted(ProxyPtrAllocator(g_pSmallHeap)),
@@ -47,20 +50,29 @@ CRefStreamEngine::CRefStreamEngine (CCryPak* pPak, IMiniLog* pLog, unsigned useW
 	SetCallbackTimeQuota (50000);
 	m_dwMask=0;
 
-	m_hIOJob = CreateEvent (NULL, FALSE, FALSE, NULL);
+	memset (m_numLatencies, 0, sizeof(m_numLatencies));
+	memset (m_numFinished, 0, sizeof(m_numFinished));
+	m_numBatched = 0;
+	m_nMaxWaiting = 0;
+	m_nBytesRead = 0;
+	m_nBytesReadLastSecond = 0;
+	m_nLastSecondTime = 0;
+	m_fBytesPerSec = 0;
+
+	m_hIOJob = CreateSemaphore (NULL, 0, 0x7FFFFFFF, NULL);
 	m_hIOExecuted = CreateEvent (NULL, TRUE, FALSE, NULL);
 	m_hDummyEvent = CreateEvent (NULL, FALSE, FALSE, NULL);
 	memset (m_nSectorSizes, 0, sizeof(m_nSectorSizes));
 
 	if (useWorkerThreads)
-		StartWorkerThread();
+		StartWorkerThreads(useWorkerThreads);
 }
 
 //////////////////////////////////////////////////////////////////////////
 // MT: Main thread only
 CRefStreamEngine::~CRefStreamEngine()
 {
-	StopWorkerThread();
+	StopWorkerThreads();
 
 	m_setLockedStreams.clear();
 
@@ -102,7 +114,11 @@ bool CRefStreamEngine::IsMainThread()
 
 bool CRefStreamEngine::IsWorkerThread()
 {
-	return GetCurrentThreadId() == m_dwWorkerThreadId;
+	DWORD dwThreadId = GetCurrentThreadId();
+	for (size_t i = 0; i < m_arrWorkerThreadIds.size(); ++i)
+		if (m_arrWorkerThreadIds[i] == dwThreadId)
+			return true;
+	return false;
 } 
 
 //////////////////////////////////////////////////////////////////////////
@@ -161,24 +177,18 @@ IReadStream_AutoPtr CRefStreamEngine::StartRead (const char* szSource, const cha
 // signals that this proxy needs to be executed (StartRead called)
 void CRefStreamEngine::AddIOJob (CRefReadStreamProxy* pJobProxy)
 {
-	if (!m_hIOWorker)
-	{ // its very simple with single-threaded model: we just put the job to the queue
-		// for the next update will execute it
-		m_queIOJobs.push_back(pJobProxy);
-		SortIOJobs_NoLock();
-	}
-	else
-	// for multi-threaded model, we need to put the job to the queue and signal the worker
-	// thread about it.
 	{
-		// put to the queue
-		{
-			AUTO_LOCK (m_csIOJobs);
-			m_queIOJobs.push_back(pJobProxy);
-			SortIOJobs_NoLock();
-		}
-		SetEvent (m_hIOJob);
-	} 
+		// put to the queue (it doesn't matter if there are no workers: then the next update will execute it).
+		// The queue is sorted, so the job is just inserted at its place
+		AUTO_LOCK (m_csIOJobs);
+		m_queIOJobs.insert (std::upper_bound(m_queIOJobs.begin(), m_queIOJobs.end(), pJobProxy, CRefReadStreamProxy::Order(m_nLastSortTime)), pJobProxy);
+		if (m_queIOJobs.size() > m_nMaxWaiting)
+			m_nMaxWaiting = (unsigned)m_queIOJobs.size();
+	}
+
+	// for multi-threaded model, signal one of the workers about it
+	if (IsMultiThreaded())
+		ReleaseSemaphore (m_hIOJob, 1, NULL);
 } 
  
   
@@ -230,9 +240,25 @@ void CRefStreamEngine::Update(unsigned nFlags)
 {
 	unsigned numRemovedJobs = 0;
 	unsigned numFinalizedJobs = 0;
+
+	// the read throughput over the last second
+	if (m_nPerfFreq)
+	{
+		int64 nTime;
+		QueryPerformanceCounter ((LARGE_INTEGER*)&nTime);
+		if (nTime - m_nLastSecondTime >= m_nPerfFreq)
+		{
+			AUTO_LOCK(m_csStats);
+			if (m_nLastSecondTime)
+				m_fBytesPerSec = float(m_nBytesRead - m_nBytesReadLastSecond) * m_nPerfFreq / float(nTime - m_nLastSecondTime);
+			m_nBytesReadLastSecond = m_nBytesRead;
+			m_nLastSecondTime = nTime;
+		}
+	}
+
 	do {
 	
-		if (!m_hIOWorker)
+		if (!IsMultiThreaded())
 		{
 			// If we're in single-threaded mode, update means the whole cycle:
 			// start the jobs, wait for their IO completion routine and finalize them
@@ -273,7 +299,7 @@ unsigned CRefStreamEngine::Wait(unsigned nMilliseconds, unsigned nFlags)
 
 	AddCallbackTimeQuota (nMilliseconds * 1000);
 
-	if (m_hIOWorker)
+	if (IsMultiThreaded())
 	{
 		unsigned nFinalized = FinalizeIOJobs(nFlags); // finalize whatever may not have been finalized
 		if (nFinalized)
@@ -367,6 +393,7 @@ unsigned CRefStreamEngine::FinalizeIOJobs(unsigned nFlags)
 
 
 // this will be the thread that executes everything that can take time
+// there may be several of them: every worker issues the reads and gets the completion routines of its own reads
 void CRefStreamEngine::IOWorkerThread ()
 {
 	do
@@ -395,15 +422,8 @@ void CRefStreamEngine::IOWorkerThread ()
 // sort the IO jobs in the IOQueue by priority
 void CRefStreamEngine::SortIOJobs()
 {
-	if (m_hIOWorker)
-	{
-		AUTO_LOCK(m_csIOJobs);
-		SortIOJobs_NoLock();
-	}
-	else
-	{
-		SortIOJobs_NoLock();
-	}
+	AUTO_LOCK(m_csIOJobs);
+	SortIOJobs_NoLock();
 }
 
 
@@ -411,7 +431,9 @@ void CRefStreamEngine::SortIOJobs()
 // this sorts the IO jobs, without bothering about synchronization
 void CRefStreamEngine::SortIOJobs_NoLock()
 {
-	std::sort (m_queIOJobs.begin(), m_queIOJobs.end(), CRefReadStreamProxy::Order());
+	// the jobs that became due since the last sort move ahead
+	QueryPerformanceCounter ((LARGE_INTEGER*)&m_nLastSortTime);
+	std::sort (m_queIOJobs.begin(), m_queIOJobs.end(), CRefReadStreamProxy::Order(m_nLastSortTime));
 }
 
 bool CRefStreamEngine::IsSuspended()
@@ -420,37 +442,105 @@ bool CRefStreamEngine::IsSuspended()
 }
 
 //////////////////////////////////////////////////////////////////////////
-// 
-unsigned CRefStreamEngine::StartIOJobs()
+// takes the job that's to be started next out of the IO Queue, together with the waiting jobs of the same
+// priority class that read from the same pak, ordered by their offset in the pak
+bool CRefStreamEngine::PopIOJobBatch (std::vector<CRefReadStreamProxy_AutoPtr>& arrBatch)
 {
-	unsigned numMovedJobs = 0;
-	AUTO_LOCK(m_csIOJobs);
+	arrBatch.clear();
+
+	CRefReadStreamProxy_AutoPtr pFirst;
+	std::vector<CRefReadStreamProxy_AutoPtr> arrCandidates;
 	{
-		AUTO_LOCK(m_csIOPending);
+		AUTO_LOCK(m_csIOJobs);
+		unsigned numPending = numIOJobs(ePending);
+		if (m_queIOJobs.empty() || numPending >= m_nMaxReadDepth || IsSuspended())
+			return false;
+
+		// the order depends on the time: re-sort when the deadlines of some jobs may have come
+		int64 nTime;
+		QueryPerformanceCounter ((LARGE_INTEGER*)&nTime);
+		if (nTime - m_nLastSortTime > m_nPerfFreq / 200)
+			SortIOJobs_NoLock();
 
-		CRefReadStreamProxy* pEndJob = NULL; // the job that will mark the end of loop
-		// TODO: implement limitation on the number of simultaneous read requests
-		while(!m_queIOJobs.empty() 
-			&& m_setIOPending.size() < m_nMaxReadDepth
-			&& !IsSuspended())
+		pFirst = m_queIOJobs.front();
+		m_queIOJobs.pop_front();
 		{
-			CRefReadStreamProxy_AutoPtr pProxy = m_queIOJobs.front();
+			AUTO_LOCK(m_csIOPending);
+			m_setIOPending.insert (pFirst);
+		}
 
-			m_queIOJobs.pop_front();
-			m_setIOPending.insert (pProxy);
+		unsigned nMaxBatch = min((unsigned)STREAM_MAX_BATCH, m_nMaxReadDepth - numPending);
+		for (size_t i = 0; i < m_queIOJobs.size() && i < STREAM_MAX_BATCH_SCAN && arrCandidates.size() + 1 < nMaxBatch; ++i)
+			if (m_queIOJobs[i]->GetPriorityClass() == pFirst->GetPriorityClass())
+				arrCandidates.push_back(m_queIOJobs[i]);
+	}
 
-			// temporary unlock both queue and set and start the reading
-			bool bReadStarted;
+	arrBatch.push_back(pFirst);
+	if (arrCandidates.empty())
+		return true;
+
+	// without the lock: this opens the files that aren't open yet
+	typedef std::pair<unsigned, CRefReadStreamProxy*> OffsetProxy;
+	std::vector<OffsetProxy> arrOffsets;
+	unsigned nOffset;
+	ZipDir::Cache* pZip = pFirst->GetPakLocation(nOffset);
+	if (!pZip)
+		return true;
+	arrOffsets.push_back (OffsetProxy(nOffset, pFirst));
+	for (size_t i = 0; i < arrCandidates.size(); ++i)
+		if (arrCandidates[i]->GetPakLocation(nOffset) == pZip)
+			arrOffsets.push_back (OffsetProxy(nOffset, arrCandidates[i]));
+
+	if (arrOffsets.size() > 1)
+	{
+		AUTO_LOCK(m_csIOJobs);
+		AUTO_LOCK(m_csIOPending);
+		// the other workers may have taken some of them meanwhile
+		for (size_t i = 1; i < arrOffsets.size(); ++i)
+		{
+			CRefReadStreamProxy_AutoDeque_MT::iterator it;
+			for (it = m_queIOJobs.begin(); it != m_queIOJobs.end() && (CRefReadStreamProxy*)*it != arrOffsets[i].second; ++it)
+				continue;
+			if (it != m_queIOJobs.end())
 			{
-				AUTO_UNLOCK(m_csIOPending);
-				{
-					AUTO_UNLOCK(m_csIOJobs);
-					// try to start reading
-					bReadStarted = pProxy->StartRead();
-				}
+				m_setIOPending.insert (*it);
+				m_queIOJobs.erase (it);
 			}
+			else
+				arrOffsets[i].second = NULL;
+		}
+	}
+
+	std::sort (arrOffsets.begin(), arrOffsets.end());
+	arrBatch.clear();
+	for (size_t i = 0; i < arrOffsets.size(); ++i)
+		if (arrOffsets[i].second)
+			arrBatch.push_back (arrOffsets[i].second);
+
+	if (arrBatch.size() > 1)
+	{
+		AUTO_LOCK(m_csStats);
+		m_numBatched += (unsigned)arrBatch.size();
+	}
+	return true;
+}
 
-			if (bReadStarted)
+//////////////////////////////////////////////////////////////////////////
+// 
+unsigned CRefStreamEngine::StartIOJobs()
+{
+	unsigned numMovedJobs = 0;
+	CRefReadStreamProxy* pEndJob = NULL; // the job that will mark the end of loop
+	std::vector<CRefReadStreamProxy_AutoPtr> arrBatch;
+
+	while (PopIOJobBatch(arrBatch))
+	{
+		bool bStarted = false, bLooping = false;
+		for (size_t i = 0; i < arrBatch.size(); ++i)
+		{
+			CRefReadStreamProxy* pProxy = arrBatch[i];
+			// try to start reading
+			if (pProxy->StartRead())
 			{
 				// in case of no error - this should be in most cases:
 				// we started the operation successfully
@@ -459,35 +549,52 @@ unsigned CRefStreamEngine::StartIOJobs()
 				// in case of unrecoverable error:
 				// we didn't start reading and can't do so. It's already moved into Executed queue as errorneous
 				++numMovedJobs;
-
-				pEndJob = NULL; // start the whole loop all over again.
+				bStarted = true;
 			}
 			else
 			{
 				// recoverable error - we'll try again next time
-				m_queIOJobs.push_back(pProxy);
-				m_setIOPending.erase (pProxy);
-
-				if (pEndJob)
 				{
-					if (pEndJob == pProxy)
-						break; // we are looping - we can't start this job for the second time in a row now
+					AUTO_LOCK(m_csIOJobs);
+					AUTO_LOCK(m_csIOPending);
+					m_queIOJobs.push_back(pProxy);
+					m_setIOPending.erase (pProxy);
 				}
+
+				if (pEndJob == pProxy)
+					bLooping = true; // we are looping - we can't start this job for the second time in a row now
 				else
-				{
+				if (!pEndJob)
 					pEndJob = pProxy; // mark this job as the end of loop; we'll erase the marker if the job is started
-				}
 			}
 		}
+
+		if (bStarted)
+			pEndJob = NULL; // start the whole loop all over again.
+		else
+		if (bLooping)
+			break;
 	}
 	return numMovedJobs;
 }
 
 void CRefStreamEngine::OnIOJobExecuted (CRefReadStreamProxy* pJobProxy)
 {
-	if (m_hIOWorker && (pJobProxy->GetParams().nFlags & SRP_FLAGS_ASYNC_CALLBACK))
+	if (IsMultiThreaded() && (pJobProxy->GetParams().nFlags & SRP_FLAGS_ASYNC_CALLBACK))
 		pJobProxy->FinalizeIO();
 
+	if (m_nPerfFreq)
+	{
+		int64 nTime;
+		QueryPerformanceCounter ((LARGE_INTEGER*)&nTime);
+		unsigned nClass = min(pJobProxy->GetPriorityClass(), (unsigned)SRPC_IDLE);
+		AUTO_LOCK(m_csStats);
+		m_arrLatencies[nClass][m_numLatencies[nClass]++ % g_nLatencySamples] = float(nTime - pJobProxy->GetStartTime()) * 1000.0f / float(m_nPerfFreq);
+		if (pJobProxy->GetPriorityClass() < SRPC_COUNT)
+			++m_numFinished[pJobProxy->GetPriorityClass()];
+		m_nBytesRead += pJobProxy->GetBytesRead(false);
+	}
+
 	{
 		AUTO_LOCK(m_csIOPending);
 		{
@@ -586,23 +693,48 @@ unsigned CRefStreamEngine::GetDriveSectorSize (char cDrive)
 }
 #endif //LINUX
 
-void CRefStreamEngine::StopWorkerThread()
+void CRefStreamEngine::StopWorkerThreads()
 {
-	if (m_hIOWorker)
+	if (!m_arrIOWorkers.empty())
 	{
 		m_bStopIOWorker = true;
-		SetEvent(m_hIOJob);
-		WaitForSingleObject (m_hIOWorker, INFINITE);
-		CloseHandle (m_hIOWorker);
-		m_hIOWorker = NULL;
+		ReleaseSemaphore (m_hIOJob, (LONG)m_arrIOWorkers.size(), NULL);
+		for (size_t i = 0; i < m_arrIOWorkers.size(); ++i)
+		{
+			WaitForSingleObject (m_arrIOWorkers[i], INFINITE);
+			CloseHandle (m_arrIOWorkers[i]);
+		}
+		m_arrIOWorkers.clear();
+		m_arrWorkerThreadIds.clear();
 	}
 }
 
-void CRefStreamEngine::StartWorkerThread()
+void CRefStreamEngine::StartWorkerThreads(unsigned numWorkers)
 {
-	StopWorkerThread();
+	StopWorkerThreads();
 	m_bStopIOWorker = false;
-	m_hIOWorker = CreateThread (NULL, 0x8000, IOWorkerThreadProc, this, 0, &m_dwWorkerThreadId);
+	for (unsigned i = 0; i < numWorkers; ++i)
+	{
+		DWORD dwThreadId = 0;
+		THREAD_HANDLE hWorker = CreateThread (NULL, 0x8000, IOWorkerThreadProc, this, 0, &dwThreadId);
+		if (!hWorker)
+			break;
+		m_arrIOWorkers.push_back (hWorker);
+		m_arrWorkerThreadIds.push_back (dwThreadId);
+	}
+}
+
+// restarts the worker threads with the given number of workers
+// MT: Main thread only
+void CRefStreamEngine::SetWorkerCount (unsigned numWorkers)
+{
+	if (numWorkers == m_arrIOWorkers.size())
+		return;
+	m_pLog->Log("StreamEngine: %u IO workers", numWorkers);
+	StartWorkerThreads (numWorkers);
+	// the jobs that are waiting already need to get the attention of the new workers
+	if (IsMultiThreaded() && numIOJobs(eWaiting))
+		ReleaseSemaphore (m_hIOJob, (LONG)m_arrIOWorkers.size(), NULL);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -692,20 +824,48 @@ void CRefStreamEngine::GetMemoryStatistics(ICrySizer *pSizer)
 	nSize += m_setLockedStreams.size() * sizeof(CRefReadStream_AutoSet::value_type);
 
 	// here we calculate the capacities of 3 arrays; we don't want a deadlock so we lock them one by one, 
-	// small discrepancies because something can be moved somewhere don't matter
+	// small discrepancies because something can be moved somewhere don't matter.
+	// They're separate components to show the depth of the queues
 	{
+		SIZER_COMPONENT_NAME(pSizer, "Waiting IO Jobs");
 		AUTO_LOCK(m_csIOJobs);
-		nSize += m_queIOJobs.size() * sizeof(CRefReadStreamProxy_AutoDeque_MT::value_type);
+		pSizer->AddObject(&m_queIOJobs, m_queIOJobs.size() * sizeof(CRefReadStreamProxy_AutoDeque_MT::value_type));
 	}
 
 	{
+		SIZER_COMPONENT_NAME(pSizer, "Pending IO Jobs");
 		AUTO_LOCK(m_csIOPending);
-		nSize += m_setIOPending.size() * sizeof(CRefReadStreamProxy_AutoSet_MT::value_type);
+		pSizer->AddObject(&m_setIOPending, m_setIOPending.size() * sizeof(CRefReadStreamProxy_AutoSet_MT::value_type));
 	}
 
 	{
+		SIZER_COMPONENT_NAME(pSizer, "Executed IO Jobs");
 		AUTO_LOCK(m_csIOExecuted);
-		nSize += m_queIOExecuted.size() * sizeof(CRefReadStreamProxy_AutoDeque_MT::value_type);
+		pSizer->AddObject(&m_queIOExecuted, m_queIOExecuted.size() * sizeof(CRefReadStreamProxy_AutoDeque_MT::value_type));
+	}
+
+	// the statistics are put into the component names, each one with the buffer it was computed from
+	{
+		Statistics stats;
+		GetStatistics (stats);
+		char szName[160];
+		nSize -= sizeof(m_numLatencies) + sizeof(m_arrLatencies);
+
+		SIZER_COMPONENT_NAME(pSizer, "Statistics");
+		{
+			sprintf (szName, "%u waiting (max %u), %u pending, %u executed, %u batched, %.1f KB/s",
+				stats.numWaiting, stats.nMaxWaiting, stats.numPending, stats.numExecuted, stats.numBatched, stats.fBytesPerSec / 1024);
+			SIZER_SUBCOMPONENT_NAME(pSizer, szName);
+			pSizer->AddObject(m_numLatencies, sizeof(m_numLatencies));
+		}
+		for (unsigned nClass = 0; nClass < SRPC_COUNT; ++nClass)
+		{
+			const Statistics::Latency& latency = stats.arrLatency[nClass];
+			sprintf (szName, "%s: %u finished, latency median %.1f ms, 90%% %.1f ms, 99%% %.1f ms, max %.1f ms", g_szPriorityClassNames[nClass],
+				stats.numFinished[nClass], latency.fMedian, latency.f90, latency.f99, latency.fMax);
+			SIZER_SUBCOMPONENT_NAME(pSizer, szName);
+			pSizer->AddObject(m_arrLatencies[nClass], sizeof(m_arrLatencies[nClass]));
+		}
 	}
 
 	// this is calculated because each queue capacity is taken into account
@@ -741,4 +901,67 @@ void CRefStreamEngine::ResumeCallbackTimeQuota ()
 DWORD CRefStreamEngine::GetStreamCompressionMask() const
 {
 	return m_dwMask;
-}
\ No newline at end of file
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+void CRefStreamEngine::GetStatistics (Statistics& stats)
+{
+	stats.numWorkers = GetWorkerCount();
+	stats.numWaiting = numIOJobs(eWaiting);
+	stats.numPending = numIOJobs(ePending);
+	stats.numExecuted = numIOJobs(eExecuted);
+
+	std::vector<float> arrLatencies[SRPC_COUNT], arrAllLatencies;
+	{
+		AUTO_LOCK(m_csStats);
+		stats.nMaxWaiting = m_nMaxWaiting;
+		memcpy (stats.numFinished, m_numFinished, sizeof(stats.numFinished));
+		stats.numBatched = m_numBatched;
+		stats.fBytesPerSec = m_fBytesPerSec;
+		for (unsigned nClass = 0; nClass < SRPC_COUNT; ++nClass)
+			arrLatencies[nClass].assign (m_arrLatencies[nClass], m_arrLatencies[nClass] + min(m_numLatencies[nClass], (unsigned)g_nLatencySamples));
+	}
+
+	for (unsigned nClass = 0; nClass < SRPC_COUNT; ++nClass)
+	{
+		arrAllLatencies.insert (arrAllLatencies.end(), arrLatencies[nClass].begin(), arrLatencies[nClass].end());
+		GetLatencyPercentiles (arrLatencies[nClass], stats.arrLatency[nClass]);
+	}
+	GetLatencyPercentiles (arrAllLatencies, stats.latency);
+}
+
+// sorts the given latencies and takes the percentiles, all 0 if there are no latencies
+void CRefStreamEngine::GetLatencyPercentiles (std::vector<float>& arrLatencies, Statistics::Latency& latency)
+{
+	latency.fMedian = latency.f90 = latency.f99 = latency.fMax = 0;
+	if (!arrLatencies.empty())
+	{
+		std::sort (arrLatencies.begin(), arrLatencies.end());
+		size_t nLast = arrLatencies.size() - 1;
+		latency.fMedian = arrLatencies[nLast / 2];
+		latency.f90 = arrLatencies[nLast * 90 / 100];
+		latency.f99 = arrLatencies[nLast * 99 / 100];
+		latency.fMax = arrLatencies[nLast];
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// logs the statistics (sys_StreamStats command)
+void CRefStreamEngine::DumpStatistics()
+{
+	Statistics stats;
+	GetStatistics (stats);
+	m_pLog->Log("StreamEngine: %u workers, jobs: %u waiting (max %u), %u pending, %u executed",
+		stats.numWorkers, stats.numWaiting, stats.nMaxWaiting, stats.numPending, stats.numExecuted);
+	m_pLog->Log("StreamEngine: finished reads: %u urgent, %u high, %u normal, %u idle; %u started in batches",
+		stats.numFinished[SRPC_URGENT], stats.numFinished[SRPC_HIGH], stats.numFinished[SRPC_NORMAL], stats.numFinished[SRPC_IDLE], stats.numBatched);
+	m_pLog->Log("StreamEngine: latency median %.1f ms, 90%% %.1f ms, 99%% %.1f ms, max %.1f ms; %.1f KB/s",
+		stats.latency.fMedian, stats.latency.f90, stats.latency.f99, stats.latency.fMax, stats.fBytesPerSec / 1024);
+	for (unsigned nClass = 0; nClass < SRPC_COUNT; ++nClass)
+	{
+		const Statistics::Latency& latency = stats.arrLatency[nClass];
+		m_pLog->Log("StreamEngine: %s latency median %.1f ms, 90%% %.1f ms, 99%% %.1f ms, max %.1f ms",
+			g_szPriorityClassNames[nClass], latency.fMedian, latency.f90, latency.f99, latency.fMax);
+	}
+}
@@ -18,7 +18,7 @@ class CRefStreamEngine:public IStreamEngine
 {
 public:
 	//! useWorkerThreads is the number of worker threads  to use;
-	//! currently only values 0 and 1 are supported: 0 - overlapped IO in the main thread, and 1 - overlapped IO in the worker thread
+	//! 0 - overlapped IO in the main thread, otherwise the IO and the unpacking of the zipped files is done by the workers
 	CRefStreamEngine(CCryPak* pPak, IMiniLog* pLog, unsigned useWorkerThreads = 1, bool bOverlappedIO = true);
 
 	//! destructor
@@ -76,8 +76,42 @@ public:
 	// returns true if called from the main thread for this engine
 	bool IsMainThread();
 
-	// returns true if called from the worker thread
+	// returns true if called from one of the worker threads
 	bool IsWorkerThread();
+
+	// restarts the worker threads with the given number of workers (sys_StreamWorkers)
+	// MT: Main thread only
+	void SetWorkerCount (unsigned numWorkers);
+	unsigned GetWorkerCount() {return (unsigned)m_arrIOWorkers.size();}
+
+	// the frequency of the performance counter, 0 if there's none
+	int64 GetPerfFreq()const {return m_nPerfFreq;}
+
+	struct Statistics
+	{
+		unsigned numWorkers;
+		// the current queue depths
+		unsigned numWaiting, numPending, numExecuted;
+		// the deepest the waiting queue has been
+		unsigned nMaxWaiting;
+		// the number of finished reads per priority class
+		unsigned numFinished[SRPC_COUNT];
+		// the number of reads started in one batch with other reads from the same pak
+		unsigned numBatched;
+		// milliseconds from StartRead until the data was read, over the last reads
+		struct Latency
+		{
+			float fMedian, f90, f99, fMax;
+		};
+		// of all the classes together and of each priority class
+		Latency latency, arrLatency[SRPC_COUNT];
+		// over the last second
+		float fBytesPerSec;
+	};
+	void GetStatistics (Statistics& stats);
+	static void GetLatencyPercentiles (std::vector<float>& arrLatencies, Statistics::Latency& latency);
+	// logs the statistics (sys_StreamStats command)
+	void DumpStatistics();
 protected:
 
 	// this function checks for the OS version and disables some capabilities of Streaming Engine when needed
@@ -86,6 +120,12 @@ protected:
 
 	// this sorts the IO jobs, without bothering about synchronization
 	void SortIOJobs_NoLock();
+
+	// takes the job that's to be started next out of the IO Queue, together with the waiting jobs of the same
+	// priority class that read from the same pak, ordered by their offset in the pak: so they hit the disk in one
+	// sweep instead of seeking back and forth. The jobs are moved to the pending set.
+	// returns false if no job can be started now
+	bool PopIOJobBatch (std::vector<CRefReadStreamProxy_AutoPtr>& arrBatch);
 	// this will be the thread that executes everything that can take time
 	void IOWorkerThread ();
 
@@ -105,8 +145,10 @@ protected:
 	}
 #endif
 
-	void StartWorkerThread();
-	void StopWorkerThread();
+	void StartWorkerThreads(unsigned numWorkers);
+	void StopWorkerThreads();
+
+	bool IsMultiThreaded()const {return !m_arrIOWorkers.empty();}
 
 	// signals that this proxy needs to be executed (StartRead called)
 	void AddIOJob (CRefReadStreamProxy* pJobProxy);
@@ -163,18 +205,20 @@ protected:
 
 	// this is the set of proxies that need to be started (StartRead needs to be called)
 	// These proxies can be rearranged, added to or removed by the main thread;
-	// protected by m_csMainWriter
+	// protected by m_csIOJobs. It's kept sorted by CRefReadStreamProxy::Order(m_nLastSortTime),
+	// and re-sorted from time to time, as the deadlines come
 	typedef CMTSafeAllocator<CRefReadStreamProxy_AutoPtr> ProxyPtrAllocator;
 	typedef std::less<CRefReadStreamProxy_AutoPtr> ProxyPtrPredicate;
 	typedef std::deque<CRefReadStreamProxy_AutoPtr, ProxyPtrAllocator > CRefReadStreamProxy_AutoDeque_MT;
 	CRefReadStreamProxy_AutoDeque_MT m_queIOJobs;
 	CCritSection m_csIOJobs;
+	int64 m_nLastSortTime;
 
 	typedef std::set<CRefReadStreamProxy_AutoPtr, ProxyPtrPredicate, ProxyPtrAllocator> CRefReadStreamProxy_AutoSet_MT;
 	CRefReadStreamProxy_AutoSet_MT m_setIOPending;
 	CCritSection m_csIOPending;
 
-	// the event used to signal the worker thread that a new job arrived
+	// the semaphore used to signal the worker threads that a new job arrived, one count per job
 	// the job can be: ask to suspend, ask to read, ask to stop or basically anything that needs attention of the worker thread
 	EVENT_HANDLE m_hIOJob;//EVENT_HANDLE is a typedef to HANDLE under windows
 
@@ -189,8 +233,8 @@ protected:
 	CRefReadStreamProxy_AutoDeque_MT m_queIOExecuted;
 	CCritSection m_csIOExecuted;
 
-	// the handle to the worker thread, or NULL if single-threaded overlapped IO is used
-	THREAD_HANDLE m_hIOWorker;//THREAD_HANDLE is a typedef to HANDLE under windows
+	// the handles to the worker threads, empty if single-threaded overlapped IO is used
+	std::vector<THREAD_HANDLE> m_arrIOWorkers;//THREAD_HANDLE is a typedef to HANDLE under windows
 
 	// this event is never signaled
 	EVENT_HANDLE m_hDummyEvent;//EVENT_HANDLE is a typedef to HANDLE under windows
@@ -206,8 +250,23 @@ protected:
 	
 	// this is the id of the main thread in which this engine operates
 	DWORD m_dwMainThreadId;
-	// the id of the worker thread, if any 
-	DWORD m_dwWorkerThreadId;
+	// the ids of the worker threads, if any 
+	std::vector<DWORD> m_arrWorkerThreadIds;
+
+	// statistics, see GetStatistics(); protected by m_csStats
+	enum {g_nLatencySamples = 1024};
+	// ring buffers of the latencies of the last finished reads of each priority class, in ms
+	float m_arrLatencies[SRPC_COUNT][g_nLatencySamples];
+	// the total number of the latencies put into each ring buffer
+	unsigned m_numLatencies[SRPC_COUNT];
+	unsigned m_numFinished[SRPC_COUNT];
+	unsigned m_numBatched;
+	unsigned m_nMaxWaiting;
+	int64 m_nBytesRead;
+	CCritSection m_csStats;
+	// for the bytes/sec, updated in the main thread
+	int64 m_nBytesReadLastSecond, m_nLastSecondTime;
+	float m_fBytesPerSec;
 
 	// This critical section protects the objects that can be written to by the main thread only
 	// It must be locked for the time of access from non-main thread and for the time of writing from the main thread
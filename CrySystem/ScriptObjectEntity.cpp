@@ -43,6 +43,48 @@ IScriptObject *CScriptObjectEntity::m_pGenVector=NULL;
 #endif
 
 IScriptObject* CScriptObjectEntity::m_memberSO[SOE_MEMBER_LAST];
+ScriptKey CScriptObjectEntity::m_keys[SOE_KEY_LAST];
+// names of SOE_KEYS
+static const char *s_szKeyNames[SOE_KEY_LAST] = {
+	"id",
+	"min",
+	"max",
+	"pos",
+	"angles",
+	"scale",
+	"offset",
+	"flags",
+	"normal",
+	"dir",
+	"target",
+	"objtype",
+	"IsPlayer",
+	"target_material",
+	"center",
+	"partid0",
+	"partid1",
+	"collider",
+	"contacts",
+	"entities",
+	"useModel",
+	"ProjTexture",
+	"lightShader",
+	"Pos",
+	"orad",
+	"diffR",
+	"diffG",
+	"diffB",
+	"diffA",
+	"specR",
+	"specG",
+	"specB",
+	"specA",
+	"Dir",
+	"projectorFov",
+	"areaonly",
+	"bHeatSource",
+	"bFakeLight",
+};
 
 CScriptObjectEntity::CScriptObjectEntity()
 {
@@ -72,9 +114,9 @@ void CScriptObjectEntity::SetMemberVector( SOE_MEMBER_LUA_TABLES member,const Ve
 {
 	IScriptObject *pVec = m_memberSO[member];
 	pVec->BeginSetGetChain();
-	pVec->SetValueChain("x",vec.x);
-	pVec->SetValueChain("y",vec.y);
-	pVec->SetValueChain("z",vec.z);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(0),vec.x);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(1),vec.y);
+	pVec->SetValueChain(m_pScriptSystem->GetVecKey(2),vec.z);
 	pVec->EndSetGetChain();
 }
 
@@ -106,7 +148,7 @@ void CScriptObjectEntity::SetEntity(IEntity *pEntity)
 	if(m_pEntity!=NULL)
 	{
 		assert(m_pScriptThis);
-		m_pScriptThis->SetValue("id",((int)m_pEntity->GetId()));
+		m_pScriptThis->SetValue(m_keys[SOE_KEY_ID],((int)m_pEntity->GetId()));
 		assert(m_pScriptThis);
 		m_pScriptThis->SetValue("classid",((int)m_pEntity->GetClassId()));
 		assert(m_pScriptThis);
@@ -138,6 +180,11 @@ void CScriptObjectEntity::ReleaseTemplate()
 	{
 		SAFE_RELEASE( m_memberSO[i] );
 	}
+	if (m_pSS)
+	{
+		for (int i = 0; i < SOE_KEY_LAST; i++)
+			m_pSS->ReleaseKey( m_keys[i] );
+	}
 
 	_ScriptableEx<CScriptObjectEntity>::ReleaseTemplate();
 }
@@ -155,6 +202,10 @@ void CScriptObjectEntity::InitializeTemplate(IScriptSystem *pSS)
 	{
 		m_memberSO[i] = pSS->CreateObject();
 	}
+	for (int i = 0; i < SOE_KEY_LAST; i++)
+	{
+		m_keys[i] = pSS->CreateKey(s_szKeyNames[i]);
+	}
 
 	REG_FUNC(CScriptObjectEntity,GetPos);
 	REG_FUNC(CScriptObjectEntity,GetCenterOfMassPos);
@@ -400,9 +451,9 @@ int CScriptObjectEntity::GetPos(IFunctionHandler *pH)
 #else
 	vec=m_pEntity->GetPos(true);
 	m_pObjectPos->BeginSetGetChain();
-	m_pObjectPos->SetValueChain("x",vec.x);
-	m_pObjectPos->SetValueChain("y",vec.y);
-	m_pObjectPos->SetValueChain("z",vec.z);
+	m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(0),vec.x);
+	m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(1),vec.y);
+	m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(2),vec.z);
 	m_pObjectPos->EndSetGetChain();
 	return pH->EndFunction(m_pObjectPos);
 #endif
@@ -430,9 +481,9 @@ int CScriptObjectEntity::GetCenterOfMassPos(IFunctionHandler *pH)
 	return pH->EndFunction(*oVec);
 #else
 	m_pGenVector->BeginSetGetChain();
-	m_pGenVector->SetValueChain("x",sd.centerOfMass.x);
-	m_pGenVector->SetValueChain("y",sd.centerOfMass.y);
-	m_pGenVector->SetValueChain("z",sd.centerOfMass.z);
+	m_pGenVector->SetValueChain(m_pScriptSystem->GetVecKey(0),sd.centerOfMass.x);
+	m_pGenVector->SetValueChain(m_pScriptSystem->GetVecKey(1),sd.centerOfMass.y);
+	m_pGenVector->SetValueChain(m_pScriptSystem->GetVecKey(2),sd.centerOfMass.z);
 	m_pGenVector->EndSetGetChain();
 	return pH->EndFunction(m_pGenVector);
 #endif
@@ -674,9 +725,9 @@ int CScriptObjectEntity::GetObjectPos(IFunctionHandler *pH)
 	if(m_pEntity->GetObjectPos(nSlot,vPos))
 	{
 		m_pObjectPos->BeginSetGetChain();
-		m_pObjectPos->SetValueChain("x",vPos.x);
-		m_pObjectPos->SetValueChain("y",vPos.y);
-		m_pObjectPos->SetValueChain("z",vPos.z);
+		m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(0),vPos.x);
+		m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(1),vPos.y);
+		m_pObjectPos->SetValueChain(m_pScriptSystem->GetVecKey(2),vPos.z);
 		m_pObjectPos->EndSetGetChain();
 		return pH->EndFunction(m_pObjectPos);
 	}
@@ -713,9 +764,9 @@ int CScriptObjectEntity::GetObjectAngles(IFunctionHandler *pH)
 	if(m_pEntity->GetObjectAngles(nSlot,vAng))
 	{
 		m_pObjectAngles->BeginSetGetChain();
-		m_pObjectAngles->SetValueChain("x",vAng.x);
-		m_pObjectAngles->SetValueChain("y",vAng.y);
-		m_pObjectAngles->SetValueChain("z",vAng.z);
+		m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(0),vAng.x);
+		m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(1),vAng.y);
+		m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(2),vAng.z);
 		m_pObjectAngles->EndSetGetChain();
 		return pH->EndFunction(m_pObjectAngles);
 	}
@@ -975,9 +1026,9 @@ int CScriptObjectEntity::GetAngles(IFunctionHandler *pH)
 
 
 	m_pObjectAngles->BeginSetGetChain();
-	m_pObjectAngles->SetValueChain("x",vec.x);
-	m_pObjectAngles->SetValueChain("y",vec.y);
-	m_pObjectAngles->SetValueChain("z",vec.z);
+	m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(0),vec.x);
+	m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(1),vec.y);
+	m_pObjectAngles->SetValueChain(m_pScriptSystem->GetVecKey(2),vec.z);
 	m_pObjectAngles->EndSetGetChain();
 	return pH->EndFunction(m_pObjectAngles);
 }
@@ -1027,9 +1078,9 @@ int CScriptObjectEntity::GetDirectionVector(IFunctionHandler *pH)
 	vec = GetTransposed44(tm)*vec;
 
 	m_pObjectAngles->BeginSetGetChain();
-	m_pObjectAngles->SetValue("x",vec.x);
-	m_pObjectAngles->SetValue("y",vec.y);
-	m_pObjectAngles->SetValue("z",vec.z);
+	m_pObjectAngles->SetValue(m_pScriptSystem->GetVecKey(0),vec.x);
+	m_pObjectAngles->SetValue(m_pScriptSystem->GetVecKey(1),vec.y);
+	m_pObjectAngles->SetValue(m_pScriptSystem->GetVecKey(2),vec.z);
 	m_pObjectAngles->EndSetGetChain();
 	//vec.ConvertToRadAngles();
 	//oVec=vec;
@@ -1106,7 +1157,7 @@ int CScriptObjectEntity::AttachToBone(IFunctionHandler *pH)
 	_SmartScriptObject pObj(m_pScriptSystem,true);
 	pH->GetParam(1,*pObj);
 	pH->GetParam(2,boneName);
-	pObj->GetValue("id",nID);
+	pObj->GetValue(m_keys[SOE_KEY_ID],nID);
 
 	m_pEntity->AttachToBone(nID, boneName);
 
@@ -1123,7 +1174,7 @@ int CScriptObjectEntity::Bind(IFunctionHandler *pH)
 	pH->GetParam(1,*pObj);
 	//optional
 	pH->GetParam(2,cParam);
-	pObj->GetValue("id",nID);
+	pObj->GetValue(m_keys[SOE_KEY_ID],nID);
 
 	//m_pEntity->Bind(nID);
 	//CXServer *pSrv=m_pGame->GetServer();
@@ -1145,7 +1196,7 @@ int CScriptObjectEntity::Unbind(IFunctionHandler *pH)
 	pH->GetParam(1,*pObj);
 	//optional
 	pH->GetParam(2,cParam);
-	pObj->GetValue("id",nID);
+	pObj->GetValue(m_keys[SOE_KEY_ID],nID);
 	//m_pEntity->Unbind(nID);
 	//CXServer *pSrv=m_pGame->GetServer();
 	//if(pSrv)
@@ -1720,7 +1771,7 @@ int CScriptObjectEntity::SetEntityPhysicParams(IPhysicalEntity *pe, IFunctionHan
 				particle_params.waterGravity=(vectorf)vec.Get();
 			if (pTable->GetValue("collider_to_ignore", *pTempObj))
 			{
-				if (pTempObj->GetValue("id",nId))
+				if (pTempObj->GetValue(m_keys[SOE_KEY_ID],nId))
 				{
 					IEntity *pEntity=m_pEntitySystem->GetEntity((EntityId)nId);
 					if (pEntity)
@@ -2035,7 +2086,7 @@ int CScriptObjectEntity::GetParticleCollisionStatus(IFunctionHandler *pH)
 			_SmartScriptObject pObj(m_pScriptSystem);
 			_SmartScriptObject oPos(m_pScriptSystem),oNormal(m_pScriptSystem),oDir(m_pScriptSystem);
 
-			pObj->SetValue("IsPlayer", 0);
+			pObj->SetValue(m_keys[SOE_KEY_ISPLAYER], 0);
 			if (collider)
 			{
 				void *pInterface = NULL;
@@ -2044,7 +2095,7 @@ int CScriptObjectEntity::GetParticleCollisionStatus(IFunctionHandler *pH)
 					if (pICnt->QueryContainerInterface(CIT_IPLAYER, &pInterface))
 					{
 						// We have a player
-						pObj->SetValue("IsPlayer", 1);
+						pObj->SetValue(m_keys[SOE_KEY_ISPLAYER], 1);
 					}
 			}
 
@@ -2056,25 +2107,25 @@ int CScriptObjectEntity::GetParticleCollisionStatus(IFunctionHandler *pH)
 			}
 			else
 			{*/
-				pObj->SetValue("target_material",hit.idmat[1]);
+				pObj->SetValue(m_keys[SOE_KEY_TARGET_MATERIAL],hit.idmat[1]);
 			//}
 
-			oPos->SetValue("x",hit.pt.x);
-			oPos->SetValue("y",hit.pt.y);
-			oPos->SetValue("z",hit.pt.z);
-			oNormal->SetValue("x",hit.n.x);
-			oNormal->SetValue("y",hit.n.y);
-			oNormal->SetValue("z",hit.n.z);
+			oPos->SetValue(m_pScriptSystem->GetVecKey(0),hit.pt.x);
+			oPos->SetValue(m_pScriptSystem->GetVecKey(1),hit.pt.y);
+			oPos->SetValue(m_pScriptSystem->GetVecKey(2),hit.pt.z);
+			oNormal->SetValue(m_pScriptSystem->GetVecKey(0),hit.n.x);
+			oNormal->SetValue(m_pScriptSystem->GetVecKey(1),hit.n.y);
+			oNormal->SetValue(m_pScriptSystem->GetVecKey(2),hit.n.z);
 			Vec3 vrel = (hit.v[0]-hit.v[1]).normalized();
-			oDir->SetValue("x",vrel.x);
-			oDir->SetValue("y",vrel.y);
-			oDir->SetValue("z",vrel.z);
-			pObj->SetValue("objtype",nType);
-			pObj->SetValue("pos",*oPos);
-			pObj->SetValue("normal",*oNormal);
-			pObj->SetValue("dir",*oDir);
+			oDir->SetValue(m_pScriptSystem->GetVecKey(0),vrel.x);
+			oDir->SetValue(m_pScriptSystem->GetVecKey(1),vrel.y);
+			oDir->SetValue(m_pScriptSystem->GetVecKey(2),vrel.z);
+			pObj->SetValue(m_keys[SOE_KEY_OBJTYPE],nType);
+			pObj->SetValue(m_keys[SOE_KEY_POS],*oPos);
+			pObj->SetValue(m_keys[SOE_KEY_NORMAL],*oNormal);
+			pObj->SetValue(m_keys[SOE_KEY_DIR],*oDir);
 			if (collider && collider->GetScriptObject())
-				pObj->SetValue("target",collider->GetScriptObject());
+				pObj->SetValue(m_keys[SOE_KEY_TARGET],collider->GetScriptObject());
 			return pH->EndFunction(*pObj);
 		}
 	}
@@ -2107,11 +2158,11 @@ int CScriptObjectEntity::GetObjectStatus(IFunctionHandler *pH)
 		// Calculate the mispoint of the bounding box
 		oVecOffset = (theEntityObject.object->GetBoxMax() + theEntityObject.object->GetBoxMin()) / 2.0; 
 		
-		pTable->SetValue("flags", theEntityObject.flags);
-		pTable->SetValue("pos", *oVecPos);
-		pTable->SetValue("angles", *oVecAngles);
-		pTable->SetValue("scale", *oVecScale);
-		pTable->SetValue("offset", *oVecOffset);
+		pTable->SetValue(m_keys[SOE_KEY_FLAGS], theEntityObject.flags);
+		pTable->SetValue(m_keys[SOE_KEY_POS], *oVecPos);
+		pTable->SetValue(m_keys[SOE_KEY_ANGLES], *oVecAngles);
+		pTable->SetValue(m_keys[SOE_KEY_SCALE], *oVecScale);
+		pTable->SetValue(m_keys[SOE_KEY_OFFSET], *oVecOffset);
 
 		return pH->EndFunction(*pTable);
 	}
@@ -2138,11 +2189,11 @@ int CScriptObjectEntity::SetObjectStatus(IFunctionHandler *pH)
 
 	if (m_pEntity && m_pEntity->GetEntityObject(nSlot, theEntityObject))
 	{
-		pTable->GetValue("flags", theEntityObject.flags);
-		pTable->GetValue("pos", *oVecPos);
-		pTable->GetValue("angles", *oVecAngles);
-		pTable->GetValue("scale", *oVecScale);
-		pTable->GetValue("offset", *oVecOffset);
+		pTable->GetValue(m_keys[SOE_KEY_FLAGS], theEntityObject.flags);
+		pTable->GetValue(m_keys[SOE_KEY_POS], *oVecPos);
+		pTable->GetValue(m_keys[SOE_KEY_ANGLES], *oVecAngles);
+		pTable->GetValue(m_keys[SOE_KEY_SCALE], *oVecScale);
+		pTable->GetValue(m_keys[SOE_KEY_OFFSET], *oVecOffset);
 
 		theEntityObject.pos = oVecPos.Get();
 		theEntityObject.angles = oVecAngles.Get();
@@ -2590,9 +2641,9 @@ int CScriptObjectEntity::GetCameraPosition(IFunctionHandler *pH)
 
 	vPos = pICam->GetPos();
 	
-	m_pCameraPosition->SetValue("x", vPos.x);
-	m_pCameraPosition->SetValue("y", vPos.y);
-	m_pCameraPosition->SetValue("z", vPos.z);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(0), vPos.x);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(1), vPos.y);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(2), vPos.z);
 	return pH->EndFunction(m_pCameraPosition);
 
 	
@@ -2612,9 +2663,9 @@ int CScriptObjectEntity::GetCameraAngles(IFunctionHandler *pH)
 
 	vAng = pICam->GetAngles();
 	
-	m_pCameraPosition->SetValue("x", vAng.x);
-	m_pCameraPosition->SetValue("y", vAng.y);
-	m_pCameraPosition->SetValue("z", vAng.z);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(0), vAng.x);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(1), vAng.y);
+	m_pCameraPosition->SetValue(m_pScriptSystem->GetVecKey(2), vAng.z);
 	return pH->EndFunction(m_pCameraPosition);
 
 	
@@ -2804,8 +2855,8 @@ int CScriptObjectEntity::GetBBox(IFunctionHandler *pH)
 		}
 		minVec=min;
 		maxVec=max;
-		res->SetValue("min",minVec);
-		res->SetValue("max",maxVec);
+		res->SetValue(m_keys[SOE_KEY_MIN],minVec);
+		res->SetValue(m_keys[SOE_KEY_MAX],maxVec);
 	}
 
 	return pH->EndFunction(res);
@@ -2826,8 +2877,8 @@ int CScriptObjectEntity::GetLocalBBox(IFunctionHandler *pH)
 		m_pEntity->GetLocalBBox(min,max);
 		minVec=min;
 		maxVec=max;
-		res->SetValue("min",minVec);
-		res->SetValue("max",maxVec);
+		res->SetValue(m_keys[SOE_KEY_MIN],minVec);
+		res->SetValue(m_keys[SOE_KEY_MAX],maxVec);
 	}
 	return pH->EndFunction(res);
 }
@@ -3603,17 +3654,17 @@ int CScriptObjectEntity::AddDynamicLight2(IFunctionHandler *pH)
 	//////////////////////////////////////////////////////////////////////////
 	bool bAttachToBone;
 	
-	if (!pITable->GetValueChain( "useModel",bAttachToBone))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_USE_MODEL],bAttachToBone))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> use of model not specified" );
 
 	//////////////////////////////////////////////////////////////////////////
 	const char *sTexName=NULL;
 	const char *sShaderName=NULL;
 
-	if (!pITable->GetValueChain( "ProjTexture",sTexName))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_PROJ_TEXTURE],sTexName))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> ProjTexture not specified" );
 
-	if (!pITable->GetValueChain( "lightShader",sShaderName))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_LIGHT_SHADER],sShaderName))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> sShaderName not specified" );
 
 	if (sTexName && sTexName[0])
@@ -3636,50 +3687,50 @@ int CScriptObjectEntity::AddDynamicLight2(IFunctionHandler *pH)
 		DynLight.m_pShader = m_pISystem->GetIRenderer()->EF_LoadShader(sShaderName, eSH_World);
 
 	//////////////////////////////////////////////////////////////////////////	
-	if (!pITable->GetValueChain("Pos",*oVec))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_LIGHT_POS],*oVec))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> Pos not specified" );
 	else
 		DynLight.m_Origin=oVec.Get();
 	
 	//////////////////////////////////////////////////////////////////////////		
-	if (!pITable->GetValueChain( "orad",DynLight.m_fRadius))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_ORAD],DynLight.m_fRadius))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> use of model not specified" );
 
 	//////////////////////////////////////////////////////////////////////////	
 	float fR,fG,fB,fA;
 
-	if (!pITable->GetValueChain( "diffR",fR))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_DIFF_R],fR))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "diffG",fG))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_DIFF_G],fG))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "diffB",fB))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_DIFF_B],fB))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "diffA",fA))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_DIFF_A],fA))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
 
 	DynLight.m_Color = CFColor (fR,fG,fB,fA);
   //DynLight.m_Color.Clamp();
 
-	if (!pITable->GetValueChain( "specR",fR))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_SPEC_R],fR))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "specG",fG))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_SPEC_G],fG))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "specB",fB))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_SPEC_B],fB))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
-	if (!pITable->GetValueChain( "specA",fA))
+	if (!pITable->GetValueChain( m_keys[SOE_KEY_SPEC_A],fA))
     m_pScriptSystem->RaiseError( "<AddDynamicLight2> diffuse not specified" );
 
 	DynLight.m_SpecColor = CFColor (fR, fG, fB, fA);
   //DynLight.m_SpecColor.Clamp();
 
 	//////////////////////////////////////////////////////////////////////////	
-	if (!pITable->GetValueChain("Dir",*oVec))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_LIGHT_DIR],*oVec))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> Dir not specified" );
 	else	
 		DynLight.m_ProjAngles=oVec.Get();			
 
 	//////////////////////////////////////////////////////////////////////////
-	if (!pITable->GetValueChain("projectorFov",DynLight.m_fLightFrustumAngle))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_PROJECTOR_FOV],DynLight.m_fLightFrustumAngle))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> frustum angle not specified" );
 	else
 		DynLight.m_fLightFrustumAngle/=2; 
@@ -3687,7 +3738,7 @@ int CScriptObjectEntity::AddDynamicLight2(IFunctionHandler *pH)
 	//////////////////////////////////////////////////////////////////////////
 	// cast shadows 
 	int	nThisAreaOnly = 0;
-	if (!pITable->GetValueChain("areaonly",nThisAreaOnly))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_AREA_ONLY],nThisAreaOnly))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> thisareaonly not specified" );
 	else
 	{
@@ -3698,14 +3749,14 @@ int CScriptObjectEntity::AddDynamicLight2(IFunctionHandler *pH)
 	//////////////////////////////////////////////////////////////////////////
 	// shaders stuff
 	bool bDummy=false;
-	if (!pITable->GetValueChain("bHeatSource",bDummy))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_HEAT_SOURCE],bDummy))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> bHeatSource not specified" );
 
 	if (bDummy)
 		DynLight.m_Flags|=DLF_HEATSOURCE;	
 
 	bDummy=false;
-	if (!pITable->GetValueChain("bFakeLight",bDummy))
+	if (!pITable->GetValueChain(m_keys[SOE_KEY_FAKE_LIGHT],bDummy))
 		m_pScriptSystem->RaiseError( "<AddDynamicLight2> bFakeLight not specified" );
 
 	pITable->EndSetGetChain();
@@ -5121,26 +5172,26 @@ int CScriptObjectEntity::CheckCollisions(IFunctionHandler *pH)
 							{
 								psoCenters[nTotCont] = m_pScriptSystem->CreateObject();
 								psoCenters[nTotCont]->BeginSetGetChain();
-								psoCenters[nTotCont]->SetValueChain("x",pContacts[nCont].center.x);
-								psoCenters[nTotCont]->SetValueChain("y",pContacts[nCont].center.y);
-								psoCenters[nTotCont]->SetValueChain("z",pContacts[nCont].center.z);
+								psoCenters[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(0),pContacts[nCont].center.x);
+								psoCenters[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(1),pContacts[nCont].center.y);
+								psoCenters[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(2),pContacts[nCont].center.z);
 								psoCenters[nTotCont]->EndSetGetChain();
 
 								psoNormals[nTotCont] = m_pScriptSystem->CreateObject();
 								psoNormals[nTotCont]->BeginSetGetChain();
-								psoNormals[nTotCont]->SetValueChain("x",-pContacts[nCont].n.x);
-								psoNormals[nTotCont]->SetValueChain("y",-pContacts[nCont].n.y);
-								psoNormals[nTotCont]->SetValueChain("z",-pContacts[nCont].n.z);
+								psoNormals[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(0),-pContacts[nCont].n.x);
+								psoNormals[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(1),-pContacts[nCont].n.y);
+								psoNormals[nTotCont]->SetValueChain(m_pScriptSystem->GetVecKey(2),-pContacts[nCont].n.z);
 								psoNormals[nTotCont]->EndSetGetChain();
 
 								psoContacts[nTotCont] = m_pScriptSystem->CreateObject();
 								psoContacts[nTotCont]->BeginSetGetChain();
-								psoContacts[nTotCont]->SetValueChain("center",psoCenters[nTotCont]);
-								psoContacts[nTotCont]->SetValueChain("normal",psoNormals[nTotCont]);
-								psoContacts[nTotCont]->SetValueChain("partid0",pp[0].partid);
-								psoContacts[nTotCont]->SetValueChain("partid1",pp[1].partid);
+								psoContacts[nTotCont]->SetValueChain(m_keys[SOE_KEY_CENTER],psoCenters[nTotCont]);
+								psoContacts[nTotCont]->SetValueChain(m_keys[SOE_KEY_NORMAL],psoNormals[nTotCont]);
+								psoContacts[nTotCont]->SetValueChain(m_keys[SOE_KEY_PARTID0],pp[0].partid);
+								psoContacts[nTotCont]->SetValueChain(m_keys[SOE_KEY_PARTID1],pp[1].partid);
 								if (psoEnt)
-									psoContacts[nTotCont]->SetValueChain("collider",psoEnt);
+									psoContacts[nTotCont]->SetValueChain(m_keys[SOE_KEY_COLLIDER],psoEnt);
 								else
 									psoContacts[nTotCont]->SetToNullChain("collider");
 								psoContacts[nTotCont]->EndSetGetChain();
@@ -5156,8 +5207,8 @@ int CScriptObjectEntity::CheckCollisions(IFunctionHandler *pH)
 					psoEntList->SetAt(nContactEnts+++1, psoEnt);	
 			}
 
-		psoRes->SetValue("contacts", psoContactList);
-		psoRes->SetValue("entities", psoEntList);
+		psoRes->SetValue(m_keys[SOE_KEY_CONTACTS], psoContactList);
+		psoRes->SetValue(m_keys[SOE_KEY_ENTITIES], psoEntList);
 		for(i=0;i<nTotCont;i++)
 			psoNormals[i]->Release(), psoCenters[i]->Release(), psoContacts[i]->Release();
 
@@ -59,6 +59,50 @@ enum SOE_MEMBER_LUA_TABLES {
 	SOE_MEMBER_LAST
 };
 
+//! members of the tables the frequently called functions fill or read, interned once (see m_keys)
+enum SOE_KEYS {
+	SOE_KEY_ID,
+	SOE_KEY_MIN,
+	SOE_KEY_MAX,
+	SOE_KEY_POS,
+	SOE_KEY_ANGLES,
+	SOE_KEY_SCALE,
+	SOE_KEY_OFFSET,
+	SOE_KEY_FLAGS,
+	SOE_KEY_NORMAL,
+	SOE_KEY_DIR,
+	SOE_KEY_TARGET,
+	SOE_KEY_OBJTYPE,
+	SOE_KEY_ISPLAYER,
+	SOE_KEY_TARGET_MATERIAL,
+	SOE_KEY_CENTER,
+	SOE_KEY_PARTID0,
+	SOE_KEY_PARTID1,
+	SOE_KEY_COLLIDER,
+	SOE_KEY_CONTACTS,
+	SOE_KEY_ENTITIES,
+	SOE_KEY_USE_MODEL,
+	SOE_KEY_PROJ_TEXTURE,
+	SOE_KEY_LIGHT_SHADER,
+	SOE_KEY_LIGHT_POS,
+	SOE_KEY_ORAD,
+	SOE_KEY_DIFF_R,
+	SOE_KEY_DIFF_G,
+	SOE_KEY_DIFF_B,
+	SOE_KEY_DIFF_A,
+	SOE_KEY_SPEC_R,
+	SOE_KEY_SPEC_G,
+	SOE_KEY_SPEC_B,
+	SOE_KEY_SPEC_A,
+	SOE_KEY_LIGHT_DIR,
+	SOE_KEY_PROJECTOR_FOV,
+	SOE_KEY_AREA_ONLY,
+	SOE_KEY_HEAT_SOURCE,
+	SOE_KEY_FAKE_LIGHT,
+
+	SOE_KEY_LAST
+};
+
 /*! In this class are all entity-related script-functions implemented in order tos expose all functionalities provided by an entity.
 
 	IMPLEMENTATIONS NOTES:
@@ -258,6 +302,8 @@ private: // --------------------------------------------------------------------
 
 	// member script objects (preallocated)
 	static IScriptObject* m_memberSO[SOE_MEMBER_LAST];
+	// interned member keys, SOE_KEYS
+	static ScriptKey m_keys[SOE_KEY_LAST];
 
 	// copy of function from ScriptObjectParticle
 	bool ReadParticleTable(IScriptObject *pITable, struct ParticleParams &sParamOut);
@@ -2214,6 +2214,12 @@ int CScriptObjectSystem::DumpMMStats(IFunctionHandler *pH)
 	m_pSystem->DumpMMStats(true);
 	//m_pScriptSystem->GetMemoryStatistics(NULL);
 	m_pLog->Log("***SCRIPT GC COUNT [%d kb]",m_pScriptSystem->GetCGCount());
+	ScriptGCStats gc;
+	m_pScriptSystem->GetGCStats(gc,false);
+	m_pLog->Log("***SCRIPT GC threshold=%d kb state=%d cycles=%d steps=%d step=%.2f ms max step=%.2f ms total=%.2f ms",
+		gc.nThresholdKb,gc.nState,gc.nCycles,gc.nSteps,gc.fLastStepTime,gc.fMaxStepTime,gc.fTotalStepTime);
+	m_pLog->Log("***SCRIPT GC full collections=%d pause=%.2f ms max pause=%.2f ms",
+		gc.nPauses,gc.fLastPauseTime,gc.fMaxPauseTime);
 	return pH->EndFunction();
 }
 
@@ -319,7 +319,20 @@ void CScriptSink::Update( bool bNoLuaGC )
 	if(nGCCount-m_nLastGCCount>2000 && !bNoLuaGC)		//
 		bKickIn=true;
 
-	if(bKickIn)
+	bool bIncremental;
+	{
+		FRAME_PROFILER( "Lua GC step",m_pSystem,PROFILE_SCRIPT );
+
+		// a kick starts an incremental cycle, the following frames continue it
+		bIncremental=pScriptSystem->GarbageCollectionStep(bKickIn);
+	}
+
+	if(bKickIn && bIncremental)
+	{
+		m_nLastGCCount=pScriptSystem->GetCGCount();
+		m_lastGCTime = currTime;
+	}
+	else if(bKickIn)
 	{
 		FRAME_PROFILER( "Lua GC",m_pSystem,PROFILE_SCRIPT );
 		
@@ -107,6 +107,57 @@ extern int g_nPrecaution;
 //////////////////////////////////////////////////////////////////////////
 #include "Validator.h"
 
+//////////////////////////////////////////////////////////////////////////
+// times the x,y,z member access of a vector table with the key strings and
+// with the interned keys, as done by the entity and player bindings
+static void BenchScriptKeys(IScriptSystem *pSS, int nAccesses)
+{
+	if (!pSS)
+		return;
+	ITimer *pTimer = GetISystem()->GetITimer();
+	ILog *pLog = GetISystem()->GetILog();
+	const char *sKeys[3] = { "x","y","z" };
+	float fSum = 0, fVal;
+	int nLoops = (nAccesses+2)/3;
+
+	_SmartScriptObject pVec(pSS);
+	for (int i = 0; i < 3; i++)
+		pVec->SetValue(sKeys[i], (float)i);
+
+	float fStart = pTimer->GetAsyncCurTime();
+	for (int n = 0; n < nLoops; n++)
+	{
+		pVec->BeginSetGetChain();
+		for (int i = 0; i < 3; i++)
+		{
+			pVec->SetValueChain(sKeys[i], (float)n);
+			pVec->GetValueChain(sKeys[i], fVal);
+			fSum += fVal;
+		}
+		pVec->EndSetGetChain();
+	}
+	float fStrings = pTimer->GetAsyncCurTime() - fStart;
+
+	fStart = pTimer->GetAsyncCurTime();
+	for (int n = 0; n < nLoops; n++)
+	{
+		pVec->BeginSetGetChain();
+		for (int i = 0; i < 3; i++)
+		{
+			pVec->SetValueChain(pSS->GetVecKey(i), (float)n);
+			pVec->GetValueChain(pSS->GetVecKey(i), fVal);
+			fSum += fVal;
+		}
+		pVec->EndSetGetChain();
+	}
+	float fKeys = pTimer->GetAsyncCurTime() - fStart;
+
+	// a set and a get per access
+	float fAccesses = (float)nLoops*3*2;
+	pLog->Log("ScriptKeyBench: %d accesses, key strings %.3f us, interned keys %.3f us per access (%.0f)",
+		nLoops*3*2, fStrings*1000000.0f/fAccesses, fKeys*1000000.0f/fAccesses, fSum);
+}
+
 //////////////////////////////////////////////////////////////////////////
 enum {
 	nSmallHeapSize =
@@ -179,6 +230,11 @@ CSystem::CSystem():
 	m_pDefaultValidator = NULL;
 	m_sys_StreamCallbackTimeBudget=0;
 	m_sys_StreamCompressionMask=0;
+	m_sys_BenchAlloc=0;
+	m_sys_BenchJobs=0;
+	m_sys_StreamWorkers=0;
+	m_sys_StreamStats=0;
+	m_sys_BenchScriptKeys=0;
 
 	m_pScriptBindings=NULL;
 	//[Timur] m_CreateDOMDocument = NULL;
@@ -490,6 +546,11 @@ void CSystem::ShutDown(bool bRelaunch)
 	SAFE_RELEASE(m_sys_firstlaunch);
 	SAFE_RELEASE(m_sys_StreamCallbackTimeBudget);
 	SAFE_RELEASE(m_sys_StreamCompressionMask);
+	SAFE_RELEASE(m_sys_BenchAlloc);
+	SAFE_RELEASE(m_sys_BenchJobs);
+	SAFE_RELEASE(m_sys_StreamWorkers);
+	SAFE_RELEASE(m_sys_StreamStats);
+	SAFE_RELEASE(m_sys_BenchScriptKeys);
 
 #ifdef WIN32
 	if (m_pLuaDebugger)
@@ -815,10 +876,43 @@ bool CSystem::Update( int updateFlags, int nPauseMode )
 	
 	m_pStreamEngine->SetCallbackTimeQuota( m_sys_StreamCallbackTimeBudget->GetIVal() );
 	m_pStreamEngine->SetStreamCompressionMask( m_sys_StreamCompressionMask->GetIVal() );
+	if (m_sys_StreamWorkers)
+	{
+		int nWorkers = m_sys_StreamWorkers->GetIVal();
+		if (nWorkers < 1)
+			nWorkers = 1;
+		if (nWorkers > 8)
+			nWorkers = 8;
+		if ((unsigned)nWorkers != m_pStreamEngine->GetWorkerCount())
+			m_pStreamEngine->SetWorkerCount(nWorkers);
+	}
+	if (m_sys_StreamStats && m_sys_StreamStats->GetIVal())
+	{
+		m_pStreamEngine->DumpStatistics();
+		m_sys_StreamStats->Set(0);
+	}
 
 	if (m_pICryCharManager)
 		m_pICryCharManager->Update();
 
+#if !defined(LINUX)
+	if (m_sys_BenchAlloc && m_sys_BenchAlloc->GetIVal())
+	{
+		CryBenchmarkAllocator(m_sys_BenchAlloc->GetIVal(), 4000000);
+		m_sys_BenchAlloc->Set(0);
+	}
+#endif
+	if (m_sys_BenchJobs && m_sys_BenchJobs->GetIVal())
+	{
+		CJobManager::RunBenchmark(m_sys_BenchJobs->GetIVal(), 100000);
+		m_sys_BenchJobs->Set(0);
+	}
+	if (m_sys_BenchScriptKeys && m_sys_BenchScriptKeys->GetIVal())
+	{
+		BenchScriptKeys(m_pScriptSystem, m_sys_BenchScriptKeys->GetIVal());
+		m_sys_BenchScriptKeys->Set(0);
+	}
+
 	if (m_bIgnoreUpdates)
 		return true;
 
@@ -461,6 +461,11 @@ private: // ------------------------------------------------------
 	ICVar *m_sys_firstlaunch;
 	ICVar *m_sys_StreamCallbackTimeBudget;
 	ICVar *m_sys_StreamCompressionMask;			//!< bitmask, lossy compression, useful for network comunication, should be 0 for load/save
+	ICVar *m_sys_BenchAlloc;								//!< number of threads, runs the allocator benchmark once and resets to 0
+	ICVar *m_sys_BenchJobs;									//!< number of workers, runs the job manager benchmark once and resets to 0
+	ICVar *m_sys_StreamWorkers;							//!< number of IO worker threads of the stream engine
+	ICVar *m_sys_StreamStats;								//!< logs the stream engine statistics once and resets to 0
+	ICVar *m_sys_BenchScriptKeys;						//!< number of accesses, runs the script key benchmark once and resets to 0
 
 	string	m_sSavedRDriver;								//!< to restore the driver when quitting the dedicated server
 
@@ -718,6 +718,22 @@ bool CSystem::InitPhysics()
 		"Specifies whether the energy added by the simple solver is limited (0 or 1)");
 	pConsole->Register("p_max_world_step", &pVars->maxWorldStep, pVars->maxWorldStep, 0, 
 		"Specifies the maximum step physical world can make (larger steps will be truncated)");
+	pConsole->Register("p_island_workers", &pVars->nIslandWorkers, (float)pVars->nIslandWorkers, 0, 
+		"Number of worker lanes that solve contacts of independent rigid body groups in parallel\n"
+		"Usage: p_island_workers 4\n"
+		"0 or 1 solves all groups on the calling thread. The result is bit-identical for any number of lanes,\n"
+		"p_log_step_checksums 1 can be used to compare runs.");
+	pConsole->Register("p_log_step_checksums", &pVars->bLogStepChecksums, (float)pVars->bLogStepChecksums, 0,
+		"Logs a checksum of the exact rigid body states after every rigid body step (0 or 1)\n"
+		"Usage: p_log_step_checksums 1");
+	pConsole->Register("p_ray_batch_workers", &pVars->nRayBatchWorkers, (float)pVars->nRayBatchWorkers, 0,
+		"Number of worker lanes that trace rays of RayWorldIntersectionBatch requests\n"
+		"Usage: p_ray_batch_workers 4\n"
+		"0 or 1 traces all rays on the calling thread.");
+	pConsole->Register("p_benchmark_rays", &pVars->nBenchmarkRays, (float)pVars->nBenchmarkRays, VF_CHEAT,
+		"Traces the given number of random rays through the world one at a time and as a batch,\n"
+		"then logs rays per second for both and resets itself to 0\n"
+		"Usage: p_benchmark_rays 10000");
 
 	if (m_bEditor)
 	{
@@ -1439,6 +1455,30 @@ void CSystem::CreateSystemVars()
 	// hidden information:
 	// bit 3 (8): cookies removed from network stream 1=on 0=off
 
+	m_sys_BenchAlloc = GetIConsole()->CreateVariable("sys_BenchAlloc", "0", 0,
+		"Runs the small object allocation benchmark once, with and without the per-thread\n"
+		"caches of the memory manager, and logs the throughput.\n"
+		"Usage: sys_BenchAlloc <number of threads>");
+
+	m_sys_BenchJobs = GetIConsole()->CreateVariable("sys_BenchJobs", "0", 0,
+		"Runs the job manager benchmark once with 1 to the given number of workers\n"
+		"and logs the scheduling overhead per empty job.\n"
+		"Usage: sys_BenchJobs <max number of workers>");
+
+	m_sys_StreamWorkers = GetIConsole()->CreateVariable("sys_StreamWorkers", "2", VF_DUMPTODISK,
+		"Number of IO worker threads of the stream engine (1..8).\n"
+		"Reads from different paks and inflating run in parallel on the workers.");
+
+	m_sys_StreamStats = GetIConsole()->CreateVariable("sys_StreamStats", "0", 0,
+		"Logs the stream engine statistics once (queue depth, latency percentiles per\n"
+		"priority class, batched reads, throughput) and resets to 0.\n"
+		"Usage: sys_StreamStats 1");
+
+	m_sys_BenchScriptKeys = GetIConsole()->CreateVariable("sys_BenchScriptKeys", "0", 0,
+		"Runs the script member access benchmark once with the given number of accesses\n"
+		"and logs the time per access with key strings and with interned keys.\n"
+		"Usage: sys_BenchScriptKeys <number of accesses>");
+
 	m_PakVar.nPriority  = 1;
 	m_PakVar.nReadSlice = 0;
 	m_PakVar.nLogMissingFiles = 0;
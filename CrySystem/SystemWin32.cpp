@@ -283,6 +283,7 @@ void CSystem::TickMemStats(MemStatsPurposeEnum nPurpose)
 		m_pMemStats->startTimer(1,GetITimer());
 		CrySizerStatsBuilder builder (m_pSizer);
 		builder.build (m_pMemStats);
+		m_pMemStats->refreshThreadCaches();
 		m_pMemStats->stopTimer(1,GetITimer());
 
 		m_pMemStats->startTimer(2,GetITimer());
@@ -869,6 +870,9 @@ void CSystem::Error( const char *format,... )
 	if (szSysErrorMessage && m_pLog)
 		m_pLog->Log( "<CrySystem> Last System Error: %s",szSysErrorMessage );
 
+	if (m_pLog)
+		m_pLog->Flush();
+
 	bool bHandled = false;
 	if (GetUserCallback())
 		bHandled = GetUserCallback()->OnError( szBuffer );
@@ -881,6 +885,8 @@ void CSystem::Error( const char *format,... )
 		::MessageBox( NULL,szBuffer,"CryEngine Error",MB_OK|MB_ICONERROR|MB_SYSTEMMODAL );
 	// Dump callstack.
 	DebugCallStack::instance()->LogCallstack();
+	if (m_pLog)
+		m_pLog->Flush();
 #endif
 #ifndef PS2
   ::OutputDebugString(szBuffer);
@@ -82,6 +82,10 @@ int CRenderer::CV_r_texgrayoverage;
 int CRenderer::CV_r_texsimplemips;
 int CRenderer::CV_r_texhwmipsgeneration;
 int CRenderer::CV_r_texhwdxtcompression;
+int CRenderer::CV_r_texpreprocessmt;
+int CRenderer::CV_r_texpreprocessinfo;
+int CRenderer::CV_r_texdxtquality;
+int CRenderer::CV_r_texdxtbench;
 
 #ifdef USE_HDR
 int CRenderer::CV_r_hdrrendering;
@@ -115,6 +119,8 @@ int CRenderer::CV_r_offsetbumpforce;
 int CRenderer::CV_r_nopreprocess;
 int CRenderer::CV_r_shaderssave;
 int CRenderer::CV_r_shadersprecache;
+int CRenderer::CV_r_shaderscriptcache;
+int CRenderer::CV_r_shaderscriptcacheinfo;
 int CRenderer::CV_r_precachemesh;
 ICVar *CRenderer::CV_r_shaderdefault;
 
@@ -711,6 +717,24 @@ CRenderer::CRenderer()
   iConsole->Register("r_TexSimpleMips", &CV_r_texsimplemips, 1);
   iConsole->Register("r_TexHWMipsGeneration", &CV_r_texhwmipsgeneration, 1);
   iConsole->Register("r_TexHWDXTCompression", &CV_r_texhwdxtcompression, 1);
+  iConsole->Register("r_TexPreprocessMT", &CV_r_texpreprocessmt, 2, 0,
+    "Selects the code path of the texture preprocessing (normal maps, resampling, mips).\n"
+    "Usage: r_TexPreprocessMT [0/1/2]\n"
+    "0 = scalar on the loading thread, 1 = SIMD kernels, 2 = SIMD kernels split into jobs (default).");
+  iConsole->Register("r_TexPreprocessInfo", &CV_r_texpreprocessinfo, 0, 0,
+    "Logs the time spent in texture preprocessing during loading.\n"
+    "Usage: r_TexPreprocessInfo [1/2/3]\n"
+    "1 logs the totals since the last call, 2 also reprocesses the loaded textures with each r_TexPreprocessMT mode,\n"
+    "3 lists the textures whose results differ between the modes as well.");
+  iConsole->Register("r_TexDXTQuality", &CV_r_texdxtquality, 1, 0,
+    "Preset of the software DXT/3Dc compression of textures (r_TexHWDXTCompression 0).\n"
+    "Usage: r_TexDXTQuality [0/1/2]\n"
+    "0 = fast (bounding box endpoints), 1 = normal (default, same settings as the old nvDXT path),\n"
+    "2 = high (endpoint refinement, slow).");
+  iConsole->Register("r_TexDXTBench", &CV_r_texdxtbench, 0, 0,
+    "Compresses the sources of loaded textures with each DXT format and preset and logs\n"
+    "the throughput in megapixels per second and the error, scalar, SIMD and SIMD+jobs.\n"
+    "Usage: r_TexDXTBench [number of textures]");
 
   iConsole->Register("r_TexturesStreamPoolSize", &CV_r_texturesstreampoolsize, 0, VF_DUMPTODISK );
   iConsole->Register("r_TexturesStreamingSync", &CV_r_texturesstreamingsync, 0);
@@ -805,6 +829,14 @@ CRenderer::CRenderer()
   iConsole->Register("r_OffsetBumpForce", &CV_r_offsetbumpforce, 0, VF_REQUIRE_APP_RESTART);
   iConsole->Register("r_ShadersSave", &CV_r_shaderssave, 0, VF_DUMPTODISK);
   iConsole->Register("r_ShadersPrecache", &CV_r_shadersprecache, 1, VF_DUMPTODISK);
+  iConsole->Register("r_ShaderScriptCache", &CV_r_shaderscriptcache, 1, VF_REQUIRE_APP_RESTART,
+    "Keeps preprocessed shader scripts in memory and in Shaders/Cache/ScriptCache*.bin.\n"
+    "Usage: r_ShaderScriptCache [0/1]\n"
+    "Default is 1. The cache entries are checked against hashes of the script and include files.");
+  iConsole->Register("r_ShaderScriptCacheInfo", &CV_r_shaderscriptcacheinfo, 0, 0,
+    "Logs shader script loading times.\n"
+    "Usage: r_ShaderScriptCacheInfo [1/2]\n"
+    "1 logs the times of the last load, 2 reloads the script lists without and with the cache (cold/warm).");
   iConsole->Register("r_PrecacheMesh", &CV_r_precachemesh, 1);
 
   iConsole->Register("r_SpecAntialias", &CV_r_specantialias, 0, 0,
@@ -1074,6 +1074,10 @@ public:
   static int CV_r_texsimplemips;
   static int CV_r_texhwmipsgeneration;
   static int CV_r_texhwdxtcompression;
+  static int CV_r_texpreprocessmt;
+  static int CV_r_texpreprocessinfo;
+  static int CV_r_texdxtquality;
+  static int CV_r_texdxtbench;
 
   static int CV_r_supportpalettedtextures;
   static int CV_r_supportcompressedtextures;
@@ -1139,6 +1143,8 @@ public:
   static int CV_r_offsetbumpforce;
   static int CV_r_shaderssave;
   static int CV_r_shadersprecache;
+  static int CV_r_shaderscriptcache;
+  static int CV_r_shaderscriptcacheinfo;
   static int CV_r_precachemesh;
 
   static int CV_r_rb_merge;
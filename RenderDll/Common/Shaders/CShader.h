@@ -64,6 +64,45 @@ struct SRegTemplate
   SShader *m_pShader;
 };
 
+// Preprocessed script of one shader file (r_ShaderScriptCache).
+// Kept in memory for the shader spawning and stored in the script cache file
+// together with the list of files (script + includes) it was built from.
+struct SScriptDep
+{
+  string m_Name;
+  int m_nSize;
+  uint m_nHash;
+};
+
+struct SPreparedScript
+{
+  char *m_pScript;
+  int m_nSize;                          // with the terminating 0
+  TArray<SLocalMacros> m_LocalMacros;   // owns the macro states
+  std::vector<SScriptDep> m_Deps;
+
+  SPreparedScript()
+  {
+    m_pScript = NULL;
+    m_nSize = 0;
+  }
+  ~SPreparedScript()
+  {
+    for (int i=0; i<m_LocalMacros.Num(); i++)
+    {
+      delete m_LocalMacros[i].m_Macros;
+    }
+    m_LocalMacros.Free();
+    SAFE_DELETE_ARRAY(m_pScript);
+  }
+  int Size()
+  {
+    int nSize = sizeof(*this) + m_nSize;
+    nSize += m_LocalMacros.GetMemoryUsage();
+    nSize += m_Deps.capacity()*sizeof(SScriptDep);
+    return nSize;
+  }
+};
 
 #define SF_RELOAD 1
 
@@ -85,6 +124,14 @@ private:
   SShader *mfNewShader(EShClass Class, int num);
 
   char *mfRescanScript(int type, int nInd, SShader *pSHOrg, uint64 nMaskGen);
+  SPreparedScript *mfPrepareScript(const char *szName);
+  SPreparedScript *mfGetPreparedScript(int type, int nInd);
+  char *mfRestorePreparedScript(SPreparedScript *ps);
+  bool mfLoadPreparedScript(const char *szName, int n);
+  SPreparedScript *mfReadScriptCache(const char *szName, int n);
+  void mfWriteScriptCache(int num, int nFiles);
+  void mfFreePreparedScripts(int num);
+  void mfScriptCacheInfo(int nMode);
   void mfScanScript (char *scr, int n);
   bool mfCompileShaderGen(SShader *ef, SShaderGen *shg, char *scr);
   SShaderGenBit *mfCompileShaderGenProperty(SShader *ef, char *scr);
@@ -145,12 +192,13 @@ public:
   char *m_pCurScript;
   ShaderMacro m_Macros;
   TArray<SLocalMacros> m_LocalMacros;
+  std::vector<string> m_ScriptIncludes;  // include files of the last preprocessed script
 
   bool PackCache();
   SShaderCacheHeaderItem *GetCacheItem(SShaderCache *pCache, int nMask);
   bool FreeCacheItem(SShaderCache *pCache, int nMask);
   bool AddCacheItem(SShaderCache *pCache, SShaderCacheHeaderItem *pItem, byte *pData, int nLen, bool bFlush);
-  SShaderCache *OpenCacheFile(const char *szName, float fVersion);
+  SShaderCache *OpenCacheFile(const char *szName, float fVersion, bool bCreate=false);
   bool FlushCacheFile(SShaderCache *pCache);
   bool CloseCacheFile(SShaderCache *pCache);
 
@@ -203,6 +251,11 @@ public:
   string m_FileNames[2][MAX_EF_FILES];
   short m_nFrameReload[2][MAX_EF_FILES];
   FILETIME m_WriteTime[2][MAX_EF_FILES];
+  SPreparedScript *m_PreparedScripts[2][MAX_EF_FILES];
+  SShaderCache *m_pScriptCache;
+  float m_fScriptLoadTime[2];
+  int m_nScriptCacheHits[2];
+  int m_nScriptCacheMisses[2];
   int m_NumFiles[2];
   int m_nFrameForceReload;
 
@@ -327,6 +380,8 @@ public:
       {
         if (!m_FileNames[i][j].empty())
           nSize += m_FileNames[i][j].capacity();
+        if (m_PreparedScripts[i][j])
+          nSize += m_PreparedScripts[i][j]->Size();
       }
     }
 
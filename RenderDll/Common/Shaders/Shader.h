@@ -426,6 +426,53 @@ struct SLocalMacros
   ShaderMacro *m_Macros;
 };
 
+// Lower case name -> slot in CVProgram::m_VPrograms / CPShader::m_PShaders.
+// One entry per generation mask, released slots are NULL and skipped.
+typedef std::multimap<string,int> ShaderNameIndex;
+typedef ShaderNameIndex::iterator ShaderNameIndexItor;
+
+template <class T> T *sFindInNameIndex(ShaderNameIndex& Index, TArray<T *>& List, const char *name, uint64 nMaskGen)
+{
+  char nameLwr[256];
+  strncpy(nameLwr, name, 255);
+  nameLwr[255] = 0;
+  strlwr(nameLwr);
+  std::pair<ShaderNameIndexItor,ShaderNameIndexItor> range = Index.equal_range(nameLwr);
+  for (ShaderNameIndexItor it=range.first; it!=range.second; it++)
+  {
+    T *p = List[it->second];
+    if (p && p->m_nMaskGen == nMaskGen)
+      return p;
+  }
+  return NULL;
+}
+
+_inline void sAddToNameIndex(ShaderNameIndex& Index, const char *name, int nId)
+{
+  char nameLwr[256];
+  strncpy(nameLwr, name, 255);
+  nameLwr[255] = 0;
+  strlwr(nameLwr);
+  Index.insert(ShaderNameIndex::value_type(nameLwr, nId));
+}
+
+_inline void sRemoveFromNameIndex(ShaderNameIndex& Index, const char *name, int nId)
+{
+  char nameLwr[256];
+  strncpy(nameLwr, name, 255);
+  nameLwr[255] = 0;
+  strlwr(nameLwr);
+  std::pair<ShaderNameIndexItor,ShaderNameIndexItor> range = Index.equal_range(nameLwr);
+  for (ShaderNameIndexItor it=range.first; it!=range.second; it++)
+  {
+    if (it->second == nId)
+    {
+      Index.erase(it);
+      break;
+    }
+  }
+}
+
 //======================================================================
 
 static _inline float *sfparam(Vec3 param)
@@ -541,6 +588,7 @@ public:
 
 #if !defined(PS2) && !defined (GC) && !defined (NULL_RENDERER)
   static TArray<CVProgram *> m_VPrograms;
+  static ShaderNameIndex m_VProgramsIndex;
 #endif
   static CVProgram *mfForName(const char *name, std::vector<SFXStruct>& Structs, std::vector<SPair>& Macros, char *entryFunc, EShaderVersion eSHV, uint64 nMaskGen=0);
   static CVProgram *mfForName(const char *name, uint64 nMaskGen=0);
@@ -639,6 +687,7 @@ public:
 
 #if !defined(PS2) && !defined (GC) && !defined (NULL_RENDERER)
   static TArray<CPShader *> m_PShaders;
+  static ShaderNameIndex m_PShadersIndex;
 
   static CPShader *mfForName(const char *name, uint64 nMaskGen=0);
   static CPShader *mfForName(const char *name, std::vector<SFXStruct>& Structs, std::vector<SPair>& Macros, char *entryFunc, EShaderVersion eSHV, uint64 nMaskGen=0);
@@ -576,6 +576,7 @@ void CShader::mfClearAll (void)
     delete CVProgram::m_VPrograms[i];
   }
   CVProgram::m_VPrograms.Free();
+  CVProgram::m_VProgramsIndex.clear();
   
   for (i=0; i<CPShader::m_PShaders.Num(); i++)
   {
@@ -584,6 +585,7 @@ void CShader::mfClearAll (void)
     delete CPShader::m_PShaders[i];
   }
   CPShader::m_PShaders.Free();
+  CPShader::m_PShadersIndex.clear();
 #endif
 
   for (i=0; i<CLightStyle::m_LStyles.Num(); i++)
@@ -678,6 +680,7 @@ void CShader::mfShutdown(void)
       if (!m_FileNames[i][j].empty())
         m_FileNames[i][j] = "";
     }
+    mfFreePreparedScripts(i);
 
     if (m_RefEfs[i])
     {
@@ -2531,6 +2534,11 @@ void SEfResTexture::Update(int nTU)
 
 void CShader::mfBeginFrame()
 {
+  if (CRenderer::CV_r_shaderscriptcacheinfo)
+  {
+    mfScriptCacheInfo(CRenderer::CV_r_shaderscriptcacheinfo);
+    CRenderer::CV_r_shaderscriptcacheinfo = 0;
+  }
   memset(&gRenDev->m_RP.m_PS, 0, sizeof(SPipeStat));
   m_Frame++;
   gRenDev->m_RP.m_Profile.Free();
@@ -2560,14 +2568,14 @@ bool CShader::CloseCacheFile(SShaderCache *pC)
   return true;
 }
 
-SShaderCache *CShader::OpenCacheFile(const char *szName, float fVersion)
+SShaderCache *CShader::OpenCacheFile(const char *szName, float fVersion, bool bCreate)
 {
   SShaderCache *pCache = new SShaderCache;
   SShaderCacheHeader hd;
   bool bValid = true;
 
   CResFile *rf = new CResFile(szName, eFSD_id);
-  if (!rf->mfOpen(RA_READ))
+  if (bCreate || !rf->mfOpen(RA_READ))
   {
     rf->mfClose();
     bValid = false;
@@ -242,6 +242,9 @@ void CVProgram::mfReloadScript(const char *szPath, const char *szName, int nFlag
 
 char *CShader::mfRescanScript(int type, int nInd, SShader *pSHOrg, uint64 nMaskGen)
 {
+  // the file was changed, the preprocessed text is rebuilt on the next spawn
+  SAFE_DELETE(m_PreparedScripts[type][nInd]);
+
   char *pFinalScript = mfScriptForFileName(m_FileNames[type][nInd].c_str(), pSHOrg, nMaskGen);
   if (!pFinalScript)
     return NULL;
@@ -853,6 +856,7 @@ char *CShader::mfPreprCheckIncludes (char *buf, const char *drn, const char *nam
       Warning( 0,0,"Warning: Missing include file '%s' for shader file '%s'\n", ni, name);
       continue;
     }
+    m_ScriptIncludes.push_back(ni);
     char drv[16], dirn[512], drnn[512]; 
     _splitpath(ni, drv, dirn, NULL, NULL);
     strcpy(drnn, drv);
@@ -1712,6 +1716,7 @@ char *CShader::mfPreprCheckMacros(char *buf, const char *nameFile)
 void CShader::mfStartScriptPreprocess()
 {
   m_Macros.clear();
+  m_ScriptIncludes.clear();
   for (int i=0; i<m_LocalMacros.Num(); i++)
   {
     delete m_LocalMacros[i].m_Macros;
@@ -1867,6 +1872,462 @@ char *CShader::mfScriptForFileName(const char *name, SShader *shGen, uint64 nMas
   return pFinalScript;
 }
 
+//=============================================================================
+// Preprocessed script cache (r_ShaderScriptCache)
+// Preprocessing (includes, #ifdef's, macros) is the expensive part of the script
+// loading and it was done for the whole file again for every spawned shader.
+// The result is kept per file together with the shader index and the local macro
+// states, and stored in Shaders/Cache/ScriptCache*.bin. An entry is used only if the
+// renderer environment and the sizes/hashes of the script and all its includes match.
+
+#define SCRIPT_CACHE_VER 1.0
+
+#if defined (DIRECT3D9)
+#define SCRIPT_CACHE_RENDERER "D3D9"
+#elif defined (DIRECT3D8)
+#define SCRIPT_CACHE_RENDERER "D3D8"
+#elif defined (OPENGL)
+#define SCRIPT_CACHE_RENDERER "GL"
+#else
+#define SCRIPT_CACHE_RENDERER "Other"
+#endif
+
+struct SScriptFileHash
+{
+  int m_nSize;
+  uint m_nHash;
+};
+
+// Sizes/hashes of the script and include files, reset for every mfLoadFromFiles
+static std::map<string,SScriptFileHash> sScriptFileHashes;
+
+static uint sScriptHash(const void *pData, int nSize, uint nHash=2166136261u)
+{
+  const byte *p = (const byte *)pData;
+  for (int i=0; i<nSize; i++)
+  {
+    nHash = (nHash ^ p[i]) * 16777619u;
+  }
+  return nHash;
+}
+
+static void sScriptCacheName(char *name, const char *szCachePath, int num)
+{
+  sprintf(name, "%sScriptCache%d_%s.bin", szCachePath, num, SCRIPT_CACHE_RENDERER);
+}
+
+static int sScriptCacheID(const char *szName)
+{
+  char name[256];
+  strncpy(name, szName, 255);
+  name[255] = 0;
+  strlwr(name);
+  int nID = sScriptHash(name, strlen(name)) & 0x7fffffff;
+  // 0xffff is the cache header
+  if (nID == 0xffff)
+    nID++;
+  return nID;
+}
+
+// Everything mfPreprCheckConditions depends on
+static uint sScriptEnvHash()
+{
+  char str[512];
+  const char *VP = gRenDev->GetVertexProfile(false);
+  const char *PP = gRenDev->GetPixelProfile(false);
+  const char *VPSup = gRenDev->GetVertexProfile(true);
+  const char *PPSup = gRenDev->GetPixelProfile(true);
+  sprintf(str, "%s %s %s %s %x %d %d %d %s %.2f", VP ? VP : "", PP ? PP : "", VPSup ? VPSup : "", PPSup ? PPSup : "", gRenDev->GetFeatures(), gRenDev->m_nHDRType, gRenDev->m_nEnabled_PS30, gRenDev->m_nEnabled_PS2X, SCRIPT_CACHE_RENDERER, SHADER_VERSION);
+  return sScriptHash(str, strlen(str));
+}
+
+static bool sGetScriptFileHash(const char *szName, SScriptFileHash& fh)
+{
+  char name[256];
+  strncpy(name, szName, 255);
+  name[255] = 0;
+  strlwr(name);
+  std::map<string,SScriptFileHash>::iterator it = sScriptFileHashes.find(name);
+  if (it != sScriptFileHashes.end())
+  {
+    fh = it->second;
+    return true;
+  }
+  FILE *fp = iSystem->GetIPak()->FOpen(szName, "rb");
+  if (!fp)
+    return false;
+  iSystem->GetIPak()->FSeek(fp, 0, SEEK_END);
+  int len = iSystem->GetIPak()->FTell(fp);
+  byte *buf = new byte [len+1];
+  iSystem->GetIPak()->FSeek(fp, 0, SEEK_SET);
+  len = iSystem->GetIPak()->FRead(buf, 1, len, fp);
+  iSystem->GetIPak()->FClose(fp);
+  fh.m_nSize = len;
+  fh.m_nHash = sScriptHash(buf, len);
+  delete [] buf;
+  sScriptFileHashes.insert(std::map<string,SScriptFileHash>::value_type(name, fh));
+  return true;
+}
+
+static void sPutInt(TArray<byte>& Data, int n)
+{
+  int nOffs = Data.Num();
+  Data.AddIndex(sizeof(int));
+  memcpy(&Data[nOffs], &n, sizeof(int));
+}
+
+static void sPutString(TArray<byte>& Data, const char *str)
+{
+  int nLen = strlen(str)+1;
+  sPutInt(Data, nLen);
+  int nOffs = Data.Num();
+  Data.AddIndex(nLen);
+  memcpy(&Data[nOffs], str, nLen);
+}
+
+struct SScriptCacheReader
+{
+  byte *m_pData;
+  byte *m_pEnd;
+  bool m_bError;
+
+  int GetInt()
+  {
+    int n = 0;
+    if (m_pData+sizeof(int) > m_pEnd)
+      m_bError = true;
+    else
+    {
+      memcpy(&n, m_pData, sizeof(int));
+      m_pData += sizeof(int);
+    }
+    return n;
+  }
+  // nLen includes the terminating 0
+  const char *GetString(int *pLen=NULL)
+  {
+    int nLen = GetInt();
+    if (m_bError || nLen < 1 || m_pData+nLen > m_pEnd || m_pData[nLen-1])
+    {
+      m_bError = true;
+      return "";
+    }
+    const char *str = (const char *)m_pData;
+    m_pData += nLen;
+    if (pLen)
+      *pLen = nLen;
+    return str;
+  }
+};
+
+SPreparedScript *CShader::mfPrepareScript(const char *szName)
+{
+  char *pFinalScript = mfScriptForFileName(szName, NULL, 0);
+  if (!pFinalScript)
+    return NULL;
+
+  SPreparedScript *ps = new SPreparedScript;
+  ps->m_pScript = pFinalScript;
+  ps->m_nSize = strlen(pFinalScript)+1;
+
+  // Take over the macro states recorded by the preprocessor
+  ps->m_LocalMacros.Copy(m_LocalMacros);
+  m_LocalMacros.Free();
+
+  SScriptDep dep;
+  SScriptFileHash fh;
+  for (int i=-1; i<(int)m_ScriptIncludes.size(); i++)
+  {
+    const char *szDep = i < 0 ? szName : m_ScriptIncludes[i].c_str();
+    if (!sGetScriptFileHash(szDep, fh))
+      continue;
+    dep.m_Name = szDep;
+    dep.m_nSize = fh.m_nSize;
+    dep.m_nHash = fh.m_nHash;
+    ps->m_Deps.push_back(dep);
+  }
+
+  return ps;
+}
+
+SPreparedScript *CShader::mfGetPreparedScript(int type, int nInd)
+{
+  if (!CRenderer::CV_r_shaderscriptcache)
+    return NULL;
+  if (!m_PreparedScripts[type][nInd])
+    m_PreparedScripts[type][nInd] = mfPrepareScript(m_FileNames[type][nInd].c_str());
+  return m_PreparedScripts[type][nInd];
+}
+
+// Returns a copy of the text (the compiler writes into it) and restores the
+// local macro states for mfScriptPreprocessorMask
+char *CShader::mfRestorePreparedScript(SPreparedScript *ps)
+{
+  mfStartScriptPreprocess();
+  for (int i=0; i<ps->m_LocalMacros.Num(); i++)
+  {
+    SLocalMacros LM;
+    LM.m_nOffset = ps->m_LocalMacros[i].m_nOffset;
+    LM.m_Macros = new ShaderMacro;
+    *LM.m_Macros = *ps->m_LocalMacros[i].m_Macros;
+    m_LocalMacros.AddElem(LM);
+  }
+  char *buf = new char [ps->m_nSize];
+  memcpy(buf, ps->m_pScript, ps->m_nSize);
+
+  return buf;
+}
+
+SPreparedScript *CShader::mfReadScriptCache(const char *szName, int n)
+{
+  if (!m_pScriptCache)
+    return NULL;
+  int nID = sScriptCacheID(szName);
+  SShaderCacheHeaderItem *pItem = GetCacheItem(m_pScriptCache, nID);
+  if (!pItem)
+    return NULL;
+  SDirEntry *de = m_pScriptCache->m_pRes->mfGetEntry(nID);
+
+  int i, j;
+  SScriptCacheReader rd;
+  rd.m_pData = (byte *)&pItem[1];
+  rd.m_pEnd = (byte *)pItem + de->size;
+  rd.m_bError = false;
+
+  SPreparedScript *ps = NULL;
+  TArray<SRefEfs> Refs;
+  std::vector<string> RefNames;
+  bool bValid = !stricmp(rd.GetString(), szName) && (uint)rd.GetInt() == sScriptEnvHash();
+  if (bValid)
+  {
+    ps = new SPreparedScript;
+
+    int nDeps = rd.GetInt();
+    for (i=0; i<nDeps && bValid && !rd.m_bError; i++)
+    {
+      SScriptDep dep;
+      SScriptFileHash fh;
+      dep.m_Name = rd.GetString();
+      dep.m_nSize = rd.GetInt();
+      dep.m_nHash = (uint)rd.GetInt();
+      if (!sGetScriptFileHash(dep.m_Name.c_str(), fh) || fh.m_nSize != dep.m_nSize || fh.m_nHash != dep.m_nHash)
+        bValid = false;
+      ps->m_Deps.push_back(dep);
+    }
+
+    int nShaders = bValid ? rd.GetInt() : 0;
+    for (i=0; i<nShaders && !rd.m_bError; i++)
+    {
+      SRefEfs fe;
+      RefNames.push_back(rd.GetString());
+      fe.m_Ind = n;
+      fe.m_Offset = rd.GetInt();
+      fe.m_Size = rd.GetInt();
+      Refs.AddElem(fe);
+    }
+
+    int nMacros = bValid ? rd.GetInt() : 0;
+    for (i=0; i<nMacros && !rd.m_bError; i++)
+    {
+      SLocalMacros LM;
+      LM.m_nOffset = rd.GetInt();
+      LM.m_Macros = new ShaderMacro;
+      ps->m_LocalMacros.AddElem(LM);
+      int nPairs = rd.GetInt();
+      for (j=0; j<nPairs && !rd.m_bError; j++)
+      {
+        string key = rd.GetString();
+        string val = rd.GetString();
+        LM.m_Macros->insert(ShaderMacroItor::value_type(key, val));
+      }
+    }
+
+    if (bValid)
+    {
+      int nLen = 0;
+      const char *scr = rd.GetString(&nLen);
+      if (!rd.m_bError)
+      {
+        ps->m_pScript = new char [nLen];
+        memcpy(ps->m_pScript, scr, nLen);
+        ps->m_nSize = nLen;
+      }
+    }
+    if (rd.m_bError)
+      bValid = false;
+  }
+  FreeCacheItem(m_pScriptCache, nID);
+
+  if (!bValid)
+  {
+    SAFE_DELETE(ps);
+    return NULL;
+  }
+
+  for (i=0; i<Refs.Num(); i++)
+  {
+    ShaderFilesMapItor it = m_RefEfs[m_CurEfsNum]->find(RefNames[i]);
+    if (it != m_RefEfs[m_CurEfsNum]->end())
+    {
+      Warning( 0,0,"Warning: Shader '%s' is duplicated\n", RefNames[i].c_str());
+      continue;
+    }
+    SRefEfs *fe = new SRefEfs;
+    *fe = Refs[i];
+    m_RefEfs[m_CurEfsNum]->insert(ShaderFilesMapItor::value_type(RefNames[i], fe));
+  }
+
+  return ps;
+}
+
+void CShader::mfWriteScriptCache(int num, int nFiles)
+{
+  char name[256];
+  sScriptCacheName(name, m_ShadersCache, num);
+  SShaderCache *pCache = OpenCacheFile(name, (float)SCRIPT_CACHE_VER, true);
+  if (!pCache)
+    return;
+
+  int i, j;
+  uint nEnvHash = sScriptEnvHash();
+  for (i=0; i<nFiles; i++)
+  {
+    SPreparedScript *ps = m_PreparedScripts[num][i];
+    if (!ps)
+      continue;
+    TArray<byte> Data;
+    sPutString(Data, m_FileNames[num][i].c_str());
+    sPutInt(Data, nEnvHash);
+
+    sPutInt(Data, ps->m_Deps.size());
+    for (j=0; j<ps->m_Deps.size(); j++)
+    {
+      sPutString(Data, ps->m_Deps[j].m_Name.c_str());
+      sPutInt(Data, ps->m_Deps[j].m_nSize);
+      sPutInt(Data, ps->m_Deps[j].m_nHash);
+    }
+
+    int nShaders = 0;
+    ShaderFilesMapItor itor;
+    for (itor=m_RefEfs[num]->begin(); itor!=m_RefEfs[num]->end(); itor++)
+    {
+      if (itor->second->m_Ind == i)
+        nShaders++;
+    }
+    sPutInt(Data, nShaders);
+    for (itor=m_RefEfs[num]->begin(); itor!=m_RefEfs[num]->end(); itor++)
+    {
+      SRefEfs *fe = itor->second;
+      if (fe->m_Ind != i)
+        continue;
+      sPutString(Data, itor->first.c_str());
+      sPutInt(Data, fe->m_Offset);
+      sPutInt(Data, fe->m_Size);
+    }
+
+    sPutInt(Data, ps->m_LocalMacros.Num());
+    for (j=0; j<ps->m_LocalMacros.Num(); j++)
+    {
+      ShaderMacro *pMacros = ps->m_LocalMacros[j].m_Macros;
+      sPutInt(Data, ps->m_LocalMacros[j].m_nOffset);
+      sPutInt(Data, pMacros->size());
+      for (ShaderMacroItor it=pMacros->begin(); it!=pMacros->end(); it++)
+      {
+        sPutString(Data, it->first.c_str());
+        sPutString(Data, it->second.c_str());
+      }
+    }
+
+    sPutString(Data, ps->m_pScript);
+
+    SShaderCacheHeaderItem hi;
+    hi.m_nMask = sScriptCacheID(m_FileNames[num][i].c_str());
+    hi.m_nVariables = 0;
+    AddCacheItem(pCache, &hi, &Data[0], Data.Num(), false);
+  }
+  FlushCacheFile(pCache);
+  CloseCacheFile(pCache);
+}
+
+bool CShader::mfLoadPreparedScript(const char *szName, int n)
+{
+  SAFE_DELETE(m_PreparedScripts[m_CurEfsNum][n]);
+
+  SPreparedScript *ps = mfReadScriptCache(szName, n);
+  if (ps)
+    m_nScriptCacheHits[m_CurEfsNum]++;
+  else
+  {
+    ps = mfPrepareScript(szName);
+    if (!ps)
+      return false;
+    // the scanner writes into the text
+    char *pScript = new char [ps->m_nSize];
+    memcpy(pScript, ps->m_pScript, ps->m_nSize);
+    char Er[1024];
+    sprintf(Er, "File '%s' script error!\n", szName);
+    gShObjectNotFound = Er;
+    mfScanScript(pScript, n);
+    gShObjectNotFound = NULL;
+    delete [] pScript;
+    m_nScriptCacheMisses[m_CurEfsNum]++;
+  }
+  m_PreparedScripts[m_CurEfsNum][n] = ps;
+
+  return true;
+}
+
+void CShader::mfFreePreparedScripts(int num)
+{
+  for (int i=0; i<MAX_EF_FILES; i++)
+  {
+    SAFE_DELETE(m_PreparedScripts[num][i]);
+  }
+}
+
+void CShader::mfScriptCacheInfo(int nMode)
+{
+  int i, j;
+  int nNum = CRenderer::CV_r_usehwshaders ? 2 : 1;
+  static const char *sCategories[] = {"common", "HW"};
+
+  if (nMode == 2)
+  {
+    // cold: the plain preprocessing path, warm: everything from the cache file
+    int nCache = CRenderer::CV_r_shaderscriptcache;
+    for (i=0; i<nNum; i++)
+    {
+      CRenderer::CV_r_shaderscriptcache = 0;
+      mfLoadFromFiles(i);
+      float fCold = m_fScriptLoadTime[i];
+      CRenderer::CV_r_shaderscriptcache = 1;
+      mfLoadFromFiles(i);
+      if (m_nScriptCacheMisses[i])
+        mfLoadFromFiles(i);
+      iLog->Log("Shader scripts (%s): cold %.3f sec, warm %.3f sec (%d files, %d from cache)", sCategories[i], fCold, m_fScriptLoadTime[i], m_NumFiles[i], m_nScriptCacheHits[i]);
+      if (!nCache)
+      {
+        CRenderer::CV_r_shaderscriptcache = 0;
+        mfLoadFromFiles(i);
+      }
+    }
+    CRenderer::CV_r_shaderscriptcache = nCache;
+    m_CurEfsNum = 0;
+    return;
+  }
+
+  for (i=0; i<nNum; i++)
+  {
+    int nSize = 0;
+    for (j=0; j<MAX_EF_FILES; j++)
+    {
+      if (m_PreparedScripts[i][j])
+        nSize += m_PreparedScripts[i][j]->Size();
+    }
+    iLog->Log("Shader scripts (%s): %d files, %d from cache, %d preprocessed, %.3f sec, %d Kb of preprocessed text", sCategories[i], m_NumFiles[i], m_nScriptCacheHits[i], m_nScriptCacheMisses[i], m_fScriptLoadTime[i], nSize/1024);
+  }
+}
+
 int CShader::mfLoadSubdir (char *drn, int n) 
 {
   struct _finddata_t fileinfo;
@@ -2335,15 +2796,23 @@ int CShader::mfLoadSubdir (char *drn, int n)
         continue;
     }
 
-    char *pFinalScript = mfScriptForFileName(nmf, NULL, 0);
-    if (!pFinalScript)
-      continue;
-    char Er[1024];
-    sprintf(Er, "File '%s' script error!\n", nmf);
-    gShObjectNotFound = Er;
-    mfScanScript(pFinalScript, n);
-    gShObjectNotFound = NULL;
-    delete [] pFinalScript;
+    if (CRenderer::CV_r_shaderscriptcache)
+    {
+      if (!mfLoadPreparedScript(nmf, n))
+        continue;
+    }
+    else
+    {
+      char *pFinalScript = mfScriptForFileName(nmf, NULL, 0);
+      if (!pFinalScript)
+        continue;
+      char Er[1024];
+      sprintf(Er, "File '%s' script error!\n", nmf);
+      gShObjectNotFound = Er;
+      mfScanScript(pFinalScript, n);
+      gShObjectNotFound = NULL;
+      delete [] pFinalScript;
+    }
 
     FILE *status = iSystem->GetIPak()->FOpen(nmf, "rb");
     if (status)
@@ -2386,6 +2855,8 @@ void CShader::mfLoadFromFiles (int num)
     }
     m_RefEfs[num]->clear();
     SAFE_DELETE (m_RefEfs[num]);
+    // r_ShaderScriptCacheInfo 2 reloads the lists between frames
+    sFE = NULL;
   }
   
   if (num == 1)
@@ -2398,7 +2869,31 @@ void CShader::mfLoadFromFiles (int num)
     iLog->Log("\n  Load HW-specific shader scripts (scanning directory '%s')...\n", dir);
 
   m_RefEfs[num] = new ShaderFilesMap;
+  mfFreePreparedScripts(num);
+  sScriptFileHashes.clear();
+  m_nScriptCacheHits[num] = 0;
+  m_nScriptCacheMisses[num] = 0;
+  float fTime0 = iTimer->GetAsyncCurTime();
+  if (CRenderer::CV_r_shaderscriptcache)
+  {
+    char name[256];
+    sScriptCacheName(name, m_ShadersCache, num);
+    m_pScriptCache = OpenCacheFile(name, (float)SCRIPT_CACHE_VER);
+  }
+
   n = mfLoadSubdir(dir, n);
+
+  if (m_pScriptCache)
+  {
+    CloseCacheFile(m_pScriptCache);
+    m_pScriptCache = NULL;
+    if (m_nScriptCacheMisses[num])
+      mfWriteScriptCache(num, n);
+  }
+  m_fScriptLoadTime[num] = iTimer->GetAsyncCurTime() - fTime0;
+  if (CRenderer::CV_r_shaderscriptcache)
+    iLog->Log("  Shader script cache: %d files up to date, %d preprocessed (%.3f sec)\n", m_nScriptCacheHits[num], m_nScriptCacheMisses[num], m_fScriptLoadTime[num]);
+
   if (!n)
   {
     Warning( 0,0,"Warning: Shaders couldn't be found in directory '%s'", dir);
@@ -2454,7 +2949,14 @@ char *CShader::mfFindInAllText (char *name, char *&pBuf, SShader *shGen, uint64
       if (!fe)
         return NULL;
     }
-    pFinalScript = mfScriptForFileName(m_FileNames[m_CurEfsNum][fe->m_Ind].c_str(), shGen, nMaskGen);
+    // Generated shaders add their own macros, everything else uses the preprocessed text
+    SPreparedScript *ps = NULL;
+    if (!shGen || !shGen->m_ShaderGenParams)
+      ps = mfGetPreparedScript(m_CurEfsNum, fe->m_Ind);
+    if (ps)
+      pFinalScript = mfRestorePreparedScript(ps);
+    else
+      pFinalScript = mfScriptForFileName(m_FileNames[m_CurEfsNum][fe->m_Ind].c_str(), shGen, nMaskGen);
     if (!pFinalScript)
       return NULL;
     sFE = fe;
@@ -2505,6 +3007,7 @@ SShader *CShader::mfSpawn (char *name, SShader *ef, SShader *efGen, uint64 nMask
   char *txt;
   int BackCurEfsNum;
   char *pScriptBuf;
+  FILETIME WriteTime;
 
   gShObjectNotFound = NULL;
   BackCurEfsNum = m_CurEfsNum;
@@ -2524,6 +3027,10 @@ SShader *CShader::mfSpawn (char *name, SShader *ef, SShader *efGen, uint64 nMask
 
   if (txt)
   {
+    // sFE belongs to the file lists, take the time before compiling (nested spawns overwrite it)
+    WriteTime = m_WriteTime[m_CurEfsNum][sFE->m_Ind];
+    sFE = NULL;
+
     // compile:
     BackEr = gShObjectNotFound;
     sprintf(Er, "Shader '%s' script error!\n", name);
@@ -2535,7 +3042,7 @@ SShader *CShader::mfSpawn (char *name, SShader *ef, SShader *efGen, uint64 nMask
     else
       ef1 = mfCompile(ef, txt);
     if (ef1)
-      ef1->m_WriteTime = m_WriteTime[m_CurEfsNum][sFE->m_Ind];
+      ef1->m_WriteTime = WriteTime;
     else
       assert(0);
     gShObjectNotFound = BackEr;
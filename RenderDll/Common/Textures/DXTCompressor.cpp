@@ -0,0 +1,1018 @@
+/*=============================================================================
+  DXTCompressor.cpp : DXT1/DXT3/DXT5 and 3Dc block compressor.
+  Copyright (c) 2001-2004 Crytek Studios. All Rights Reserved.
+
+  Revision history:
+    * Replaces nvDXTlib for the texture manager and the image compiler
+
+=============================================================================*/
+
+// No precompiled header, the file is shared with the resource compiler
+#include <string.h>
+#include <math.h>
+#include <IJobManager.h>
+#include "DXTCompressor.h"
+
+// SSE kernels; the colors use SSE1 float math, the alpha blocks SSE2 byte math
+#if defined(_M_IX86) || defined(_M_AMD64) || defined(__SSE2__)
+#define DXTC_SSE2
+#include <emmintrin.h>
+#endif
+
+// one job compresses rows of about this many blocks
+#define DXTC_JOB_BLOCKS 256
+// least squares passes of eDXTQ_High, they stop earlier when the error doesn't get smaller
+#define DXTC_HIGH_LSQ_PASSES 4
+// passes of the +-1 endpoint search of eDXTQ_High
+#define DXTC_HIGH_SEARCH_PASSES 8
+
+//============================================================================
+// Tables
+
+// Best endpoint pair for a block of one color: the color is reproduced by index 2
+// (2/3 of the first + 1/3 of the second endpoint), which gets closer than rounding to 5/6 bits.
+static unsigned char s_Match5[256][2];
+static unsigned char s_Match6[256][2];
+
+static void sPrepareMatchTable(unsigned char (*pTable)[2], int nBits)
+{
+  int nSize = 1<<nBits;
+  for (int i=0; i<256; i++)
+  {
+    int nBestErr = 256*100;
+    for (int mx=0; mx<nSize; mx++)
+    {
+      int maxe = (nBits == 5) ? (mx<<3)|(mx>>2) : (mx<<2)|(mx>>4);
+      for (int mn=0; mn<nSize; mn++)
+      {
+        int mine = (nBits == 5) ? (mn<<3)|(mn>>2) : (mn<<2)|(mn>>4);
+        int nErr = (2*maxe + mine)/3 - i;
+        if (nErr < 0)
+          nErr = -nErr;
+        // prefer close endpoints, the hardware interpolation isn't exact
+        nErr = nErr*100 + ((maxe > mine) ? maxe-mine : mine-maxe)*3;
+        if (nErr < nBestErr)
+        {
+          nBestErr = nErr;
+          pTable[i][0] = (unsigned char)mx;
+          pTable[i][1] = (unsigned char)mn;
+        }
+      }
+    }
+  }
+}
+
+struct SDXTTables
+{
+  SDXTTables()
+  {
+    sPrepareMatchTable(s_Match5, 5);
+    sPrepareMatchTable(s_Match6, 6);
+  }
+};
+static SDXTTables s_DXTTables;
+
+//============================================================================
+// Block data
+
+// Texels of one 4x4 block. Colors are floats for the endpoint search.
+struct SColorBlock
+{
+  float r[16];
+  float g[16];
+  float b[16];
+  float w[16];              // 0 for the transparent texels of DXT1a, 1 otherwise
+  unsigned char c[4][16];   // r,g,b,a bytes
+};
+
+// Endpoints and indices of one color block
+struct SColorFit
+{
+  int c0, c1;               // 565
+  bool b3Colors;            // 3 colors + transparent, c0 <= c1 after sWriteColorBlock
+  float fErr;
+  unsigned char idx[16];
+};
+
+struct SDXTJob
+{
+  const unsigned char *m_pSrc;
+  int m_nWidth;
+  int m_nHeight;
+  int m_nPitch;
+  int m_nBpp;
+  unsigned char *m_pDst;
+  int m_nBlocksX;
+  const SDXTCompressOptions *m_pOpt;
+};
+
+static inline int sClamp(int n, int nMax)
+{
+  return n < 0 ? 0 : (n > nMax ? nMax : n);
+}
+
+static void sLoadBlock(const SDXTJob& j, int bx, int by, SColorBlock& blk)
+{
+  int nR = j.m_pOpt->m_bBGRA ? 2 : 0;
+  int nB = 2 - nR;
+  bool bTransp = j.m_pOpt->m_eFormat == eDXTF_DXT1a;
+  int nThreshold = j.m_pOpt->m_nAlphaThreshold;
+  for (int y=0; y<4; y++)
+  {
+    // partial blocks repeat the last row/column
+    int sy = by*4 + y;
+    if (sy >= j.m_nHeight)
+      sy = j.m_nHeight-1;
+    const unsigned char *pRow = &j.m_pSrc[sy*j.m_nPitch];
+    for (int x=0; x<4; x++)
+    {
+      int sx = bx*4 + x;
+      if (sx >= j.m_nWidth)
+        sx = j.m_nWidth-1;
+      const unsigned char *p = &pRow[sx*j.m_nBpp];
+      int i = y*4+x;
+      blk.c[0][i] = p[nR];
+      blk.c[1][i] = p[1];
+      blk.c[2][i] = p[nB];
+      blk.c[3][i] = (j.m_nBpp == 4) ? p[3] : 255;
+      blk.r[i] = (float)p[nR];
+      blk.g[i] = (float)p[1];
+      blk.b[i] = (float)p[nB];
+      blk.w[i] = (bTransp && blk.c[3][i] < nThreshold) ? 0.0f : 1.0f;
+    }
+  }
+}
+
+//============================================================================
+// Color blocks
+
+static inline void sUnpack565(int c, int *pRGB)
+{
+  int r = (c>>11) & 31;
+  int g = (c>>5) & 63;
+  int b = c & 31;
+  pRGB[0] = (r<<3) | (r>>2);
+  pRGB[1] = (g<<2) | (g>>4);
+  pRGB[2] = (b<<3) | (b>>2);
+}
+
+static inline int sQuantize565(const float *pRGB)
+{
+  int r = sClamp((int)(pRGB[0]*(31.0f/255.0f) + 0.5f), 31);
+  int g = sClamp((int)(pRGB[1]*(63.0f/255.0f) + 0.5f), 63);
+  int b = sClamp((int)(pRGB[2]*(31.0f/255.0f) + 0.5f), 31);
+  return (r<<11) | (g<<5) | b;
+}
+
+// Palette as the hardware decodes it, in index order
+static void sColorPalette(int c0, int c1, bool b3Colors, int pal[4][3])
+{
+  sUnpack565(c0, pal[0]);
+  sUnpack565(c1, pal[1]);
+  for (int i=0; i<3; i++)
+  {
+    int a = pal[0][i];
+    int b = pal[1][i];
+    if (!b3Colors)
+    {
+      pal[2][i] = (2*a + b) / 3;
+      pal[3][i] = (a + 2*b) / 3;
+    }
+    else
+    {
+      pal[2][i] = (a + b) / 2;
+      pal[3][i] = 0;
+    }
+  }
+}
+
+// Picks the closest palette entry for every texel, returns the summed squared error.
+// In 3 color mode index 3 is transparent and only used for the texels with w == 0.
+static float sFitColors(const SColorBlock& blk, const int pal[4][3], bool b3Colors, unsigned char *pIdx)
+{
+  int nColors = b3Colors ? 3 : 4;
+  float fErr = 0;
+  for (int i=0; i<16; i++)
+  {
+    float fBest = 1e30f;
+    int nBest = 0;
+    for (int k=0; k<nColors; k++)
+    {
+      float dr = blk.r[i] - (float)pal[k][0];
+      float dg = blk.g[i] - (float)pal[k][1];
+      float db = blk.b[i] - (float)pal[k][2];
+      float d = dr*dr + dg*dg + db*db;
+      if (d < fBest)
+      {
+        fBest = d;
+        nBest = k;
+      }
+    }
+    if (blk.w[i] == 0)
+      nBest = 3;
+    pIdx[i] = (unsigned char)nBest;
+    fErr += fBest * blk.w[i];
+  }
+  return fErr;
+}
+
+#ifdef DXTC_SSE2
+// Same as sFitColors for 4 texels at a time
+static float sFitColorsSSE(const SColorBlock& blk, const int pal[4][3], bool b3Colors, unsigned char *pIdx)
+{
+  int nColors = b3Colors ? 3 : 4;
+  __m128 pr[4], pg[4], pb[4], pk[4];
+  for (int k=0; k<4; k++)
+  {
+    pr[k] = _mm_set1_ps((float)pal[k][0]);
+    pg[k] = _mm_set1_ps((float)pal[k][1]);
+    pb[k] = _mm_set1_ps((float)pal[k][2]);
+    pk[k] = _mm_set1_ps((float)k);
+  }
+  __m128 zero = _mm_setzero_ps();
+  __m128 err = zero;
+  for (int i=0; i<16; i+=4)
+  {
+    __m128 r = _mm_loadu_ps(&blk.r[i]);
+    __m128 g = _mm_loadu_ps(&blk.g[i]);
+    __m128 b = _mm_loadu_ps(&blk.b[i]);
+    __m128 w = _mm_loadu_ps(&blk.w[i]);
+    __m128 best = _mm_set1_ps(1e30f);
+    __m128 idx = zero;
+    for (int k=0; k<nColors; k++)
+    {
+      __m128 dr = _mm_sub_ps(r, pr[k]);
+      __m128 dg = _mm_sub_ps(g, pg[k]);
+      __m128 db = _mm_sub_ps(b, pb[k]);
+      __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+      __m128 m = _mm_cmplt_ps(d, best);
+      best = _mm_min_ps(d, best);
+      idx = _mm_or_ps(_mm_andnot_ps(m, idx), _mm_and_ps(m, pk[k]));
+    }
+    if (b3Colors)
+    {
+      __m128 t = _mm_cmpeq_ps(w, zero);
+      idx = _mm_or_ps(_mm_andnot_ps(t, idx), _mm_and_ps(t, pk[3]));
+    }
+    err = _mm_add_ps(err, _mm_mul_ps(best, w));
+    __m128i n = _mm_cvttps_epi32(idx);
+    n = _mm_packs_epi32(n, n);
+    n = _mm_packus_epi16(n, n);
+    int nPacked = _mm_cvtsi128_si32(n);
+    memcpy(&pIdx[i], &nPacked, 4);
+  }
+  float e[4];
+  _mm_storeu_ps(e, err);
+  return (e[0] + e[1]) + (e[2] + e[3]);
+}
+#endif
+
+// Weighted mean and covariance (rr, rg, rb, gg, gb, bb) of the block, returns the weight sum
+static float sColorStats(const SColorBlock& blk, bool bSSE, float *pMean, float *pCov)
+{
+  float s[10];
+#ifdef DXTC_SSE2
+  if (bSSE)
+  {
+    __m128 sw = _mm_setzero_ps();
+    __m128 sr = sw, sg = sw, sb = sw;
+    __m128 srr = sw, srg = sw, srb = sw, sgg = sw, sgb = sw, sbb = sw;
+    for (int i=0; i<16; i+=4)
+    {
+      __m128 w = _mm_loadu_ps(&blk.w[i]);
+      __m128 r = _mm_mul_ps(_mm_loadu_ps(&blk.r[i]), w);
+      __m128 g = _mm_mul_ps(_mm_loadu_ps(&blk.g[i]), w);
+      __m128 b = _mm_mul_ps(_mm_loadu_ps(&blk.b[i]), w);
+      __m128 r1 = _mm_loadu_ps(&blk.r[i]);
+      __m128 g1 = _mm_loadu_ps(&blk.g[i]);
+      __m128 b1 = _mm_loadu_ps(&blk.b[i]);
+      sw = _mm_add_ps(sw, w);
+      sr = _mm_add_ps(sr, r);
+      sg = _mm_add_ps(sg, g);
+      sb = _mm_add_ps(sb, b);
+      srr = _mm_add_ps(srr, _mm_mul_ps(r, r1));
+      srg = _mm_add_ps(srg, _mm_mul_ps(r, g1));
+      srb = _mm_add_ps(srb, _mm_mul_ps(r, b1));
+      sgg = _mm_add_ps(sgg, _mm_mul_ps(g, g1));
+      sgb = _mm_add_ps(sgb, _mm_mul_ps(g, b1));
+      sbb = _mm_add_ps(sbb, _mm_mul_ps(b, b1));
+    }
+    __m128 v[10] = { sw, sr, sg, sb, srr, srg, srb, sgg, sgb, sbb };
+    for (int n=0; n<10; n++)
+    {
+      float e[4];
+      _mm_storeu_ps(e, v[n]);
+      s[n] = (e[0] + e[1]) + (e[2] + e[3]);
+    }
+  }
+  else
+#endif
+  {
+    for (int n=0; n<10; n++)
+      s[n] = 0;
+    for (int i=0; i<16; i++)
+    {
+      float w = blk.w[i];
+      float r = blk.r[i];
+      float g = blk.g[i];
+      float b = blk.b[i];
+      s[0] += w;
+      s[1] += w*r;
+      s[2] += w*g;
+      s[3] += w*b;
+      s[4] += w*r*r;
+      s[5] += w*r*g;
+      s[6] += w*r*b;
+      s[7] += w*g*g;
+      s[8] += w*g*b;
+      s[9] += w*b*b;
+    }
+  }
+  float fInv = 1.0f / s[0];
+  pMean[0] = s[1] * fInv;
+  pMean[1] = s[2] * fInv;
+  pMean[2] = s[3] * fInv;
+  pCov[0] = s[4]*fInv - pMean[0]*pMean[0];
+  pCov[1] = s[5]*fInv - pMean[0]*pMean[1];
+  pCov[2] = s[6]*fInv - pMean[0]*pMean[2];
+  pCov[3] = s[7]*fInv - pMean[1]*pMean[1];
+  pCov[4] = s[8]*fInv - pMean[1]*pMean[2];
+  pCov[5] = s[9]*fInv - pMean[2]*pMean[2];
+  return s[0];
+}
+
+// Fast preset: corners of the bounding box, moved inside by 1/16 and flipped along the
+// diagonal the colors are spread on
+static void sBoxEndpoints(const SColorBlock& blk, const float *pCov, float *e0, float *e1)
+{
+  float mn[3] = { 255.0f, 255.0f, 255.0f };
+  float mx[3] = { 0, 0, 0 };
+  for (int i=0; i<16; i++)
+  {
+    if (blk.w[i] == 0)
+      continue;
+    float c[3] = { blk.r[i], blk.g[i], blk.b[i] };
+    for (int n=0; n<3; n++)
+    {
+      if (c[n] < mn[n])
+        mn[n] = c[n];
+      if (c[n] > mx[n])
+        mx[n] = c[n];
+    }
+  }
+  for (int n=0; n<3; n++)
+  {
+    float fInset = (mx[n] - mn[n]) / 16.0f;
+    e0[n] = mx[n] - fInset;
+    e1[n] = mn[n] + fInset;
+  }
+  // green is the reference, red and blue are flipped if they go the other way
+  if (pCov[1] < 0)
+  {
+    float f = e0[0]; e0[0] = e1[0]; e1[0] = f;
+  }
+  if (pCov[4] < 0)
+  {
+    float f = e0[2]; e0[2] = e1[2]; e1[2] = f;
+  }
+}
+
+// Texels at both ends of the principal axis. Returns false for a flat block.
+static bool sPrincipalEndpoints(const SColorBlock& blk, bool bSSE, const float *pCov, float *e0, float *e1)
+{
+  // power iteration, starting at the covariance row of the largest variance
+  float v[3];
+  if (pCov[0] >= pCov[3] && pCov[0] >= pCov[5])
+  {
+    v[0] = pCov[0]; v[1] = pCov[1]; v[2] = pCov[2];
+  }
+  else
+  if (pCov[3] >= pCov[5])
+  {
+    v[0] = pCov[1]; v[1] = pCov[3]; v[2] = pCov[4];
+  }
+  else
+  {
+    v[0] = pCov[2]; v[1] = pCov[4]; v[2] = pCov[5];
+  }
+  for (int n=0; n<8; n++)
+  {
+    float x = pCov[0]*v[0] + pCov[1]*v[1] + pCov[2]*v[2];
+    float y = pCov[1]*v[0] + pCov[3]*v[1] + pCov[4]*v[2];
+    float z = pCov[2]*v[0] + pCov[4]*v[1] + pCov[5]*v[2];
+    float fMax = fabsf(x);
+    if (fabsf(y) > fMax)
+      fMax = fabsf(y);
+    if (fabsf(z) > fMax)
+      fMax = fabsf(z);
+    if (fMax < 1e-6f)
+      return false;
+    v[0] = x / fMax;
+    v[1] = y / fMax;
+    v[2] = z / fMax;
+  }
+
+  float t[16];
+#ifdef DXTC_SSE2
+  if (bSSE)
+  {
+    __m128 vr = _mm_set1_ps(v[0]);
+    __m128 vg = _mm_set1_ps(v[1]);
+    __m128 vb = _mm_set1_ps(v[2]);
+    for (int i=0; i<16; i+=4)
+    {
+      __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&blk.r[i]), vr), _mm_mul_ps(_mm_loadu_ps(&blk.g[i]), vg)), _mm_mul_ps(_mm_loadu_ps(&blk.b[i]), vb));
+      _mm_storeu_ps(&t[i], d);
+    }
+  }
+  else
+#endif
+  {
+    for (int i=0; i<16; i++)
+      t[i] = (blk.r[i]*v[0] + blk.g[i]*v[1]) + blk.b[i]*v[2];
+  }
+  int nMin = -1;
+  int nMax = -1;
+  for (int i=0; i<16; i++)
+  {
+    if (blk.w[i] == 0)
+      continue;
+    if (nMin < 0 || t[i] < t[nMin])
+      nMin = i;
+    if (nMax < 0 || t[i] > t[nMax])
+      nMax = i;
+  }
+  e0[0] = blk.r[nMax]; e0[1] = blk.g[nMax]; e0[2] = blk.b[nMax];
+  e1[0] = blk.r[nMin]; e1[1] = blk.g[nMin]; e1[2] = blk.b[nMin];
+  return true;
+}
+
+// Endpoints that minimize the squared error for the given indices
+static bool sLeastSquares(const SColorBlock& blk, const unsigned char *pIdx, bool b3Colors, float *e0, float *e1)
+{
+  static const float fWeights4[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+  static const float fWeights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+  const float *pW = b3Colors ? fWeights3 : fWeights4;
+  float A = 0, B = 0, C = 0;
+  float X[3] = { 0, 0, 0 };
+  float Y[3] = { 0, 0, 0 };
+  for (int i=0; i<16; i++)
+  {
+    if (blk.w[i] == 0)
+      continue;
+    float a = pW[pIdx[i]];
+    float b = 1.0f - a;
+    A += a*a;
+    B += b*b;
+    C += a*b;
+    X[0] += a*blk.r[i]; X[1] += a*blk.g[i]; X[2] += a*blk.b[i];
+    Y[0] += b*blk.r[i]; Y[1] += b*blk.g[i]; Y[2] += b*blk.b[i];
+  }
+  float fDet = A*B - C*C;
+  if (fabsf(fDet) < 1e-4f)
+    return false;
+  float fInv = 1.0f / fDet;
+  for (int n=0; n<3; n++)
+  {
+    float f0 = (X[n]*B - Y[n]*C) * fInv;
+    float f1 = (Y[n]*A - X[n]*C) * fInv;
+    e0[n] = f0 < 0 ? 0 : (f0 > 255.0f ? 255.0f : f0);
+    e1[n] = f1 < 0 ? 0 : (f1 > 255.0f ? 255.0f : f1);
+  }
+  return true;
+}
+
+// Fits the indices for the endpoints and keeps them in Best if the error is smaller
+static bool sTryColors(const SColorBlock& blk, int c0, int c1, bool b3Colors, bool bSSE, SColorFit& Best)
+{
+  int pal[4][3];
+  unsigned char idx[16];
+  sColorPalette(c0, c1, b3Colors, pal);
+  float fErr;
+#ifdef DXTC_SSE2
+  if (bSSE)
+    fErr = sFitColorsSSE(blk, pal, b3Colors, idx);
+  else
+#endif
+    fErr = sFitColors(blk, pal, b3Colors, idx);
+  if (fErr >= Best.fErr)
+    return false;
+  Best.c0 = c0;
+  Best.c1 = c1;
+  Best.b3Colors = b3Colors;
+  Best.fErr = fErr;
+  memcpy(Best.idx, idx, 16);
+  return true;
+}
+
+// High preset: moves the endpoints by one step per channel while that lowers the error
+static void sSearchColors(const SColorBlock& blk, bool bSSE, SColorFit& Best)
+{
+  static const int nShift[3] = { 11, 5, 0 };
+  static const int nMask[3] = { 31, 63, 31 };
+  for (int nPass=0; nPass<DXTC_HIGH_SEARCH_PASSES; nPass++)
+  {
+    bool bImproved = false;
+    for (int e=0; e<2; e++)
+    {
+      for (int ch=0; ch<3; ch++)
+      {
+        for (int d=-1; d<=1; d+=2)
+        {
+          int c[2] = { Best.c0, Best.c1 };
+          int n = ((c[e] >> nShift[ch]) & nMask[ch]) + d;
+          if (n < 0 || n > nMask[ch])
+            continue;
+          c[e] = (c[e] & ~(nMask[ch] << nShift[ch])) | (n << nShift[ch]);
+          if (sTryColors(blk, c[0], c[1], Best.b3Colors, bSSE, Best))
+            bImproved = true;
+        }
+      }
+    }
+    if (!bImproved)
+      break;
+  }
+}
+
+// Orders the endpoints the way the mode needs it and stores the 8 bytes
+static void sWriteColorBlock(SColorFit& Fit, unsigned char *pOut)
+{
+  int c0 = Fit.c0;
+  int c1 = Fit.c1;
+  unsigned char *idx = Fit.idx;
+  int i;
+  if (c0 == c1)
+  {
+    // all entries but the transparent one are the same color
+    for (i=0; i<16; i++)
+    {
+      if (idx[i] != 3 || !Fit.b3Colors)
+        idx[i] = 0;
+    }
+  }
+  else
+  if (Fit.b3Colors ? c0 > c1 : c0 < c1)
+  {
+    c0 = Fit.c1;
+    c1 = Fit.c0;
+    for (i=0; i<16; i++)
+    {
+      // 0<->1, in 4 color mode also 2<->3
+      if (!Fit.b3Colors || idx[i] < 2)
+        idx[i] ^= 1;
+    }
+  }
+  unsigned int nBits = 0;
+  for (i=0; i<16; i++)
+    nBits |= (unsigned int)idx[i] << (i*2);
+  pOut[0] = (unsigned char)c0;
+  pOut[1] = (unsigned char)(c0>>8);
+  pOut[2] = (unsigned char)c1;
+  pOut[3] = (unsigned char)(c1>>8);
+  pOut[4] = (unsigned char)nBits;
+  pOut[5] = (unsigned char)(nBits>>8);
+  pOut[6] = (unsigned char)(nBits>>16);
+  pOut[7] = (unsigned char)(nBits>>24);
+}
+
+static void sCompressColorBlock(const SColorBlock& blk, bool bDXT1, const SDXTCompressOptions& Opt, unsigned char *pOut)
+{
+  bool bSSE = Opt.m_bSSE;
+  int i;
+  int nOpaque = 0;
+  bool bSolid = true;
+  for (i=0; i<16; i++)
+  {
+    if (blk.w[i] == 0)
+      continue;
+    nOpaque++;
+    if (blk.c[0][i] != blk.c[0][0] || blk.c[1][i] != blk.c[1][0] || blk.c[2][i] != blk.c[2][0])
+      bSolid = false;
+  }
+
+  SColorFit Best;
+  Best.fErr = 1e30f;
+  if (!nOpaque)
+  {
+    Best.c0 = Best.c1 = 0;
+    Best.b3Colors = true;
+    memset(Best.idx, 3, 16);
+    sWriteColorBlock(Best, pOut);
+    return;
+  }
+  bool bTransparent = nOpaque < 16;
+  if (bSolid && !bTransparent)
+  {
+    int r = blk.c[0][0];
+    int g = blk.c[1][0];
+    int b = blk.c[2][0];
+    Best.c0 = (s_Match5[r][0]<<11) | (s_Match6[g][0]<<5) | s_Match5[b][0];
+    Best.c1 = (s_Match5[r][1]<<11) | (s_Match6[g][1]<<5) | s_Match5[b][1];
+    Best.b3Colors = false;
+    memset(Best.idx, 2, 16);
+    sWriteColorBlock(Best, pOut);
+    return;
+  }
+
+  float fMean[3], fCov[6];
+  float e0[3], e1[3];
+  sColorStats(blk, bSSE, fMean, fCov);
+  if (Opt.m_eQuality == eDXTQ_Fast || !sPrincipalEndpoints(blk, bSSE, fCov, e0, e1))
+    sBoxEndpoints(blk, fCov, e0, e1);
+
+  // 3 color blocks are needed for the transparent texels, else they're tried when the preset allows
+  bool bTry4 = !bTransparent;
+  bool bTry3 = bTransparent || (bDXT1 && !Opt.m_bForceFourColors && Opt.m_eQuality != eDXTQ_Fast);
+  int nLSQPasses = (Opt.m_eQuality == eDXTQ_Fast) ? 0 : (Opt.m_eQuality == eDXTQ_High ? DXTC_HIGH_LSQ_PASSES : 1);
+  for (int nMode=0; nMode<2; nMode++)
+  {
+    bool b3Colors = nMode == 1;
+    if (b3Colors ? !bTry3 : !bTry4)
+      continue;
+    SColorFit Fit;
+    Fit.fErr = 1e30f;
+    sTryColors(blk, sQuantize565(e0), sQuantize565(e1), b3Colors, bSSE, Fit);
+    for (int n=0; n<nLSQPasses; n++)
+    {
+      float l0[3], l1[3];
+      if (!sLeastSquares(blk, Fit.idx, b3Colors, l0, l1))
+        break;
+      if (!sTryColors(blk, sQuantize565(l0), sQuantize565(l1), b3Colors, bSSE, Fit))
+        break;
+    }
+    if (Opt.m_eQuality == eDXTQ_High)
+      sSearchColors(blk, bSSE, Fit);
+    if (Fit.fErr < Best.fErr)
+      Best = Fit;
+  }
+  sWriteColorBlock(Best, pOut);
+}
+
+//============================================================================
+// Alpha blocks (DXT5 alpha, both 3Dc channels)
+
+// Palette in index order: 8 interpolated values if a0 > a1, else 6 and 0, 255
+static void sAlphaPalette(int a0, int a1, int *pal)
+{
+  pal[0] = a0;
+  pal[1] = a1;
+  if (a0 > a1)
+  {
+    for (int i=1; i<7; i++)
+      pal[i+1] = ((7-i)*a0 + i*a1) / 7;
+  }
+  else
+  {
+    for (int i=1; i<5; i++)
+      pal[i+1] = ((5-i)*a0 + i*a1) / 5;
+    pal[6] = 0;
+    pal[7] = 255;
+  }
+}
+
+static int sFitAlpha(const unsigned char *pA, const int *pal, unsigned char *pIdx)
+{
+  int nErr = 0;
+  for (int i=0; i<16; i++)
+  {
+    int nBest = 256;
+    int nCode = 0;
+    for (int k=0; k<8; k++)
+    {
+      int d = pA[i] - pal[k];
+      if (d < 0)
+        d = -d;
+      if (d < nBest)
+      {
+        nBest = d;
+        nCode = k;
+      }
+    }
+    pIdx[i] = (unsigned char)nCode;
+    nErr += nBest*nBest;
+  }
+  return nErr;
+}
+
+#ifdef DXTC_SSE2
+// Same as sFitAlpha, all 16 texels in one register
+static int sFitAlphaSSE2(const unsigned char *pA, const int *pal, unsigned char *pIdx)
+{
+  __m128i v = _mm_loadu_si128((const __m128i *)pA);
+  __m128i best = _mm_set1_epi8((char)0xff);
+  __m128i code = _mm_setzero_si128();
+  for (int k=0; k<8; k++)
+  {
+    __m128i p = _mm_set1_epi8((char)pal[k]);
+    __m128i d = _mm_or_si128(_mm_subs_epu8(v, p), _mm_subs_epu8(p, v));
+    __m128i nb = _mm_min_epu8(best, d);
+    // keep the old code where d isn't smaller
+    __m128i m = _mm_cmpeq_epi8(nb, best);
+    code = _mm_or_si128(_mm_and_si128(m, code), _mm_andnot_si128(m, _mm_set1_epi8((char)k)));
+    best = nb;
+  }
+  _mm_storeu_si128((__m128i *)pIdx, code);
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_unpacklo_epi8(best, zero);
+  __m128i hi = _mm_unpackhi_epi8(best, zero);
+  __m128i s = _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+  return _mm_cvtsi128_si32(s);
+}
+#endif
+
+struct SAlphaFit
+{
+  int a0, a1;
+  int nErr;
+  unsigned char idx[16];
+};
+
+static bool sTryAlpha(const unsigned char *pA, int a0, int a1, bool bSSE, SAlphaFit& Best)
+{
+  int pal[8];
+  unsigned char idx[16];
+  sAlphaPalette(a0, a1, pal);
+  int nErr;
+#ifdef DXTC_SSE2
+  if (bSSE)
+    nErr = sFitAlphaSSE2(pA, pal, idx);
+  else
+#endif
+    nErr = sFitAlpha(pA, pal, idx);
+  if (nErr >= Best.nErr)
+    return false;
+  Best.a0 = a0;
+  Best.a1 = a1;
+  Best.nErr = nErr;
+  memcpy(Best.idx, idx, 16);
+  return true;
+}
+
+// High preset: moves the endpoints by one while the error gets smaller, keeping the mode
+static void sSearchAlpha(const unsigned char *pA, bool bSSE, SAlphaFit& Best)
+{
+  bool b8 = Best.a0 > Best.a1;
+  for (int nPass=0; nPass<DXTC_HIGH_SEARCH_PASSES; nPass++)
+  {
+    bool bImproved = false;
+    for (int n=0; n<4; n++)
+    {
+      int a0 = Best.a0 + ((n == 0) ? -1 : (n == 1) ? 1 : 0);
+      int a1 = Best.a1 + ((n == 2) ? -1 : (n == 3) ? 1 : 0);
+      if (a0 < 0 || a0 > 255 || a1 < 0 || a1 > 255 || (a0 > a1) != b8)
+        continue;
+      if (sTryAlpha(pA, a0, a1, bSSE, Best))
+        bImproved = true;
+    }
+    if (!bImproved)
+      break;
+  }
+}
+
+static void sCompressAlphaBlock(const unsigned char *pA, const SDXTCompressOptions& Opt, unsigned char *pOut)
+{
+  bool bSSE = Opt.m_bSSE;
+  int i;
+  int nMin = 255, nMax = 0;
+  // range without 0 and 255 for the 6 value mode
+  int nMin6 = 255, nMax6 = 0;
+  for (i=0; i<16; i++)
+  {
+    int a = pA[i];
+    if (a < nMin)
+      nMin = a;
+    if (a > nMax)
+      nMax = a;
+    if (a != 0 && a != 255)
+    {
+      if (a < nMin6)
+        nMin6 = a;
+      if (a > nMax6)
+        nMax6 = a;
+    }
+  }
+
+  SAlphaFit Best;
+  Best.nErr = 0x7fffffff;
+  if (nMin == nMax)
+  {
+    Best.a0 = Best.a1 = nMin;
+    memset(Best.idx, 0, 16);
+  }
+  else
+  {
+    sTryAlpha(pA, nMax, nMin, bSSE, Best);
+    if (Best.nErr && Opt.m_eQuality != eDXTQ_Fast)
+    {
+      SAlphaFit Fit6;
+      Fit6.nErr = 0x7fffffff;
+      if (nMin6 > nMax6)
+        nMin6 = nMax6 = 0;
+      sTryAlpha(pA, nMin6, nMax6, bSSE, Fit6);
+      if (Opt.m_eQuality == eDXTQ_High)
+      {
+        sSearchAlpha(pA, bSSE, Best);
+        sSearchAlpha(pA, bSSE, Fit6);
+      }
+      if (Fit6.nErr < Best.nErr)
+        Best = Fit6;
+    }
+  }
+
+  pOut[0] = (unsigned char)Best.a0;
+  pOut[1] = (unsigned char)Best.a1;
+  for (int n=0; n<2; n++)
+  {
+    unsigned int nBits = 0;
+    for (i=0; i<8; i++)
+      nBits |= (unsigned int)Best.idx[n*8+i] << (i*3);
+    pOut[2+n*3] = (unsigned char)nBits;
+    pOut[3+n*3] = (unsigned char)(nBits>>8);
+    pOut[4+n*3] = (unsigned char)(nBits>>16);
+  }
+}
+
+static void sCompressExplicitAlpha(const unsigned char *pA, unsigned char *pOut)
+{
+  for (int i=0; i<8; i++)
+  {
+    int a0 = (pA[i*2+0]*15 + 127) / 255;
+    int a1 = (pA[i*2+1]*15 + 127) / 255;
+    pOut[i] = (unsigned char)(a0 | (a1<<4));
+  }
+}
+
+//============================================================================
+
+static void sCompressRows(void *pData, int nBegin, int nEnd)
+{
+  SDXTJob *pJ = (SDXTJob *)pData;
+  const SDXTCompressOptions& Opt = *pJ->m_pOpt;
+  int nBlockSize = DXTBlockSize(Opt.m_eFormat);
+  SColorBlock blk;
+  for (int by=nBegin; by<nEnd; by++)
+  {
+    unsigned char *pOut = &pJ->m_pDst[by*pJ->m_nBlocksX*nBlockSize];
+    for (int bx=0; bx<pJ->m_nBlocksX; bx++)
+    {
+      sLoadBlock(*pJ, bx, by, blk);
+      switch (Opt.m_eFormat)
+      {
+        case eDXTF_DXT1:
+        case eDXTF_DXT1a:
+          sCompressColorBlock(blk, true, Opt, pOut);
+          break;
+        case eDXTF_DXT3:
+          sCompressExplicitAlpha(blk.c[3], pOut);
+          sCompressColorBlock(blk, false, Opt, pOut+8);
+          break;
+        case eDXTF_DXT5:
+          sCompressAlphaBlock(blk.c[3], Opt, pOut);
+          sCompressColorBlock(blk, false, Opt, pOut+8);
+          break;
+        case eDXTF_3DC:
+          sCompressAlphaBlock(blk.c[0], Opt, pOut);
+          sCompressAlphaBlock(blk.c[1], Opt, pOut+8);
+          break;
+      }
+      pOut += nBlockSize;
+    }
+  }
+}
+
+int DXTBlockSize(EDXTFormat eFormat)
+{
+  return (eFormat == eDXTF_DXT1 || eFormat == eDXTF_DXT1a) ? 8 : 16;
+}
+
+int DXTCompressedSize(int nWidth, int nHeight, EDXTFormat eFormat)
+{
+  return ((nWidth+3)>>2) * ((nHeight+3)>>2) * DXTBlockSize(eFormat);
+}
+
+bool DXTHasSSE()
+{
+#ifdef DXTC_SSE2
+  return true;
+#else
+  return false;
+#endif
+}
+
+void DXTCompress(const unsigned char *pSrc, int nWidth, int nHeight, int nPitch, int nBytesPerPixel, unsigned char *pDst, const SDXTCompressOptions& Opt)
+{
+  SDXTCompressOptions OptJob = Opt;
+  if (!DXTHasSSE())
+    OptJob.m_bSSE = false;
+
+  SDXTJob job;
+  job.m_pSrc = pSrc;
+  job.m_nWidth = nWidth;
+  job.m_nHeight = nHeight;
+  job.m_nPitch = nPitch;
+  job.m_nBpp = nBytesPerPixel;
+  job.m_pDst = pDst;
+  job.m_nBlocksX = (nWidth+3)>>2;
+  job.m_pOpt = &OptJob;
+  int nBlocksY = (nHeight+3)>>2;
+
+  if (Opt.m_pJobManager && job.m_nBlocksX*nBlocksY > DXTC_JOB_BLOCKS)
+  {
+    int nGranularity = DXTC_JOB_BLOCKS / job.m_nBlocksX;
+    if (nGranularity < 1)
+      nGranularity = 1;
+    Opt.m_pJobManager->ParallelFor(nBlocksY, nGranularity, sCompressRows, &job);
+  }
+  else
+    sCompressRows(&job, 0, nBlocksY);
+}
+
+//============================================================================
+// Decoding
+
+static void sDecodeColorBlock(const unsigned char *pIn, bool bDXT1, unsigned char pOut[16][4])
+{
+  int c0 = pIn[0] | (pIn[1]<<8);
+  int c1 = pIn[2] | (pIn[3]<<8);
+  bool b3Colors = bDXT1 && c0 <= c1;
+  int pal[4][3];
+  sColorPalette(c0, c1, b3Colors, pal);
+  unsigned int nBits = pIn[4] | (pIn[5]<<8) | (pIn[6]<<16) | ((unsigned int)pIn[7]<<24);
+  for (int i=0; i<16; i++)
+  {
+    int n = (nBits >> (i*2)) & 3;
+    pOut[i][0] = (unsigned char)pal[n][0];
+    pOut[i][1] = (unsigned char)pal[n][1];
+    pOut[i][2] = (unsigned char)pal[n][2];
+    pOut[i][3] = (b3Colors && n == 3) ? 0 : 255;
+  }
+}
+
+static void sDecodeAlphaBlock(const unsigned char *pIn, unsigned char pOut[16][4], int nChannel)
+{
+  int pal[8];
+  sAlphaPalette(pIn[0], pIn[1], pal);
+  for (int n=0; n<2; n++)
+  {
+    unsigned int nBits = pIn[2+n*3] | (pIn[3+n*3]<<8) | (pIn[4+n*3]<<16);
+    for (int i=0; i<8; i++)
+      pOut[n*8+i][nChannel] = (unsigned char)pal[(nBits >> (i*3)) & 7];
+  }
+}
+
+void DXTDecompress(const unsigned char *pSrc, int nWidth, int nHeight, EDXTFormat eFormat, unsigned char *pDst, bool bBGRA)
+{
+  int nBlockSize = DXTBlockSize(eFormat);
+  int nBlocksX = (nWidth+3)>>2;
+  int nBlocksY = (nHeight+3)>>2;
+  int nR = bBGRA ? 2 : 0;
+  int nB = 2 - nR;
+  unsigned char texels[16][4];
+  for (int by=0; by<nBlocksY; by++)
+  {
+    for (int bx=0; bx<nBlocksX; bx++)
+    {
+      const unsigned char *pIn = &pSrc[(by*nBlocksX + bx)*nBlockSize];
+      int i;
+      switch (eFormat)
+      {
+        case eDXTF_DXT1:
+        case eDXTF_DXT1a:
+          sDecodeColorBlock(pIn, true, texels);
+          break;
+        case eDXTF_DXT3:
+          sDecodeColorBlock(pIn+8, false, texels);
+          for (i=0; i<16; i++)
+            texels[i][3] = (unsigned char)(((pIn[i>>1] >> ((i&1)*4)) & 15) * 17);
+          break;
+        case eDXTF_DXT5:
+          sDecodeColorBlock(pIn+8, false, texels);
+          sDecodeAlphaBlock(pIn, texels, 3);
+          break;
+        case eDXTF_3DC:
+          sDecodeAlphaBlock(pIn, texels, 0);
+          sDecodeAlphaBlock(pIn+8, texels, 1);
+          for (i=0; i<16; i++)
+          {
+            texels[i][2] = 0;
+            texels[i][3] = 255;
+          }
+          break;
+      }
+      for (int y=0; y<4 && by*4+y<nHeight; y++)
+      {
+        for (int x=0; x<4 && bx*4+x<nWidth; x++)
+        {
+          unsigned char *p = &pDst[((by*4+y)*nWidth + bx*4+x)*4];
+          const unsigned char *t = texels[y*4+x];
+          p[nR] = t[0];
+          p[1] = t[1];
+          p[nB] = t[2];
+          p[3] = t[3];
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+/*=============================================================================
+  DXTCompressor.h : DXT1/DXT3/DXT5 and 3Dc block compressor.
+  Copyright (c) 2001-2004 Crytek Studios. All Rights Reserved.
+
+  Revision history:
+    * Replaces nvDXTlib for the texture manager and the image compiler
+
+=============================================================================*/
+
+#ifndef __DXTCOMPRESSOR_H__
+#define __DXTCOMPRESSOR_H__
+
+// Doesn't depend on the engine or on windows, so the resource compiler links the same
+// file. Blocks are compressed independently, rows of blocks go to the job manager.
+
+struct IJobManager;
+
+enum EDXTFormat
+{
+  eDXTF_DXT1,           // BC1, opaque
+  eDXTF_DXT1a,          // BC1 with 1 bit alpha
+  eDXTF_DXT3,           // BC2, explicit 4 bit alpha
+  eDXTF_DXT5,           // BC3, interpolated alpha
+  eDXTF_3DC             // BC5 / ATI2N, red and green as two interpolated alpha blocks
+};
+
+// Presets, eDXTQ_Normal gives what the nvDXT defaults of nvdxt_options.h did
+enum EDXTQuality
+{
+  eDXTQ_Fast,           // bounding box endpoints, no 3 color blocks (bQuickCompress)
+  eDXTQ_Normal,         // principal axis endpoints and one least squares pass
+  eDXTQ_High            // least squares until it converges and a search around the endpoints
+};
+
+struct SDXTCompressOptions
+{
+  EDXTFormat m_eFormat;
+  EDXTQuality m_eQuality;
+  bool m_bBGRA;                 // source texels are B,G,R(,A) instead of R,G,B(,A)
+  bool m_bForceFourColors;      // DXT1: no 3 color blocks (bForceDXT1FourColors)
+  int m_nAlphaThreshold;        // DXT1a: alpha below it is transparent (BinaryAlphaThreshold)
+  bool m_bSSE;                  // use the SSE kernels, the caller has checked the CPU
+  IJobManager *m_pJobManager;   // 0: compress on the calling thread
+
+  SDXTCompressOptions()
+  {
+    m_eFormat = eDXTF_DXT1;
+    m_eQuality = eDXTQ_Normal;
+    m_bBGRA = false;
+    m_bForceFourColors = false;
+    m_nAlphaThreshold = 128;
+    m_bSSE = false;
+    m_pJobManager = 0;
+  }
+};
+
+//! Bytes of one 4x4 block (8 or 16).
+int DXTBlockSize(EDXTFormat eFormat);
+//! Bytes of one compressed level, partial blocks included.
+int DXTCompressedSize(int nWidth, int nHeight, EDXTFormat eFormat);
+//! True if the SSE kernels are compiled in.
+bool DXTHasSSE();
+
+//! Compresses one level of 8 bit texels (nBytesPerPixel 3 or 4, 3 means opaque) to pDst,
+//! which needs DXTCompressedSize bytes.
+void DXTCompress(const unsigned char *pSrc, int nWidth, int nHeight, int nPitch, int nBytesPerPixel, unsigned char *pDst, const SDXTCompressOptions& Opt);
+//! Decodes one level to 32 bit texels (R,G,B,A or B,G,R,A).
+//! 3Dc gives the two channels in red and green, blue is 0.
+void DXTDecompress(const unsigned char *pSrc, int nWidth, int nHeight, EDXTFormat eFormat, unsigned char *pDst, bool bBGRA);
+
+#endif // __DXTCOMPRESSOR_H__
@@ -21,6 +21,8 @@
 #if defined(LINUX)
 #include "ILog.h"
 #endif
+#include <IJobManager.h>
+#include "DXTCompressor.h"
 
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
@@ -62,6 +64,9 @@ CTexMan::CTexMan()
   m_pProcessedTexture2 = NULL;
   m_nPhaseProcessingTextures = 0;
   m_nCustomMip = 0;
+  m_fPreprocessTime = 0;
+  m_fPreprocessMPixels = 0;
+  m_nPreprocessTextures = 0;
 }
 
 void CTexMan::Shutdown()
@@ -1596,6 +1601,10 @@ STexPic *CTexMan::LoadFromImage (const char *name, uint flags, uint flags2, byte
     im[1] = NULL;
   }
   
+  ti->m_fAmount1 = fAmount1;
+  ti->m_fAmount2 = fAmount2;
+
+  float fPreprocessStart = iTimer->GetAsyncCurTime();
   if (im[0] && (eTT == eTT_Bumpmap || eTT == eTT_DSDTBump))
   {
     flags &= ~FT_NOMIPS;
@@ -1604,6 +1613,12 @@ STexPic *CTexMan::LoadFromImage (const char *name, uint flags, uint flags2, byte
 
   if (!(flags & FT_DYNAMIC))
     ImagePreprocessing(im[0], flags, flags2, eTT, ti);
+  if (im[0])
+  {
+    m_fPreprocessTime += iTimer->GetAsyncCurTime() - fPreprocessStart;
+    m_fPreprocessMPixels += (float)im[0]->mfGet_width() * im[0]->mfGet_height() / 1000000.0f;
+    m_nPreprocessTextures++;
+  }
 
 #ifndef NULL_RENDERER
   if (im[0] && !ti->m_pSH && eTT == eTT_Bumpmap && im[0]->mfGetFormat()!=eIF_DDS_RGB8 && (strstr(ti->m_SourceName.c_str(), "_shadow") || CRenderer::CV_r_bumpselfshadow==2))
@@ -1623,6 +1638,652 @@ STexPic *CTexMan::LoadFromImage (const char *name, uint flags, uint flags2, byte
   return tx;
 }
 
+//===============================================================================
+// Preprocessing kernels
+//
+// Normal map generation, merging, resampling and mip building run on the loading
+// thread for every texture that isn't stored in its final form. r_TexPreprocessMT
+// selects the plain loops (0), the SSE2 kernels (1, blocks of 4 pixels, the scalar code
+// does the rest) or the SSE2 kernels with the rows split into jobs (2).
+// The results only depend on the mode through the float rounding of x87 builds.
+// Creating the device textures stays on the calling thread.
+
+// SSE2 kernels, on x86 it's also checked at runtime (CPUF_SSE2)
+#if defined(_CPU_AMD64) || (defined(_CPU_X86) && !defined(__GNUC__)) || defined(__SSE2__)
+#define TEXPREP_SSE2
+#include <emmintrin.h>
+#endif
+
+// least pixels handled by one job
+#define TEXPREP_JOB_PIXELS 16384
+
+static bool sTexPrepSSE()
+{
+#if defined(TEXPREP_SSE2) && defined(_CPU_X86)
+  return CRenderer::CV_r_texpreprocessmt >= 1 && CRenderer::CV_r_sse && (g_CpuFlags & CPUF_SSE2);
+#elif defined(TEXPREP_SSE2)
+  return CRenderer::CV_r_texpreprocessmt >= 1;
+#else
+  return false;
+#endif
+}
+
+// Runs pFunc for the rows [0,nRows), split into jobs if the image is big enough
+static void sTexPrepFor(int nRows, int nRowPixels, ParallelForFunc pFunc, void *pData)
+{
+  IJobManager *pJobManager = (CRenderer::CV_r_texpreprocessmt >= 2 && iSystem) ? iSystem->GetIJobManager() : NULL;
+  if (nRowPixels < 1)
+    nRowPixels = 1;
+  if (pJobManager && nRows > 1 && nRows*nRowPixels > TEXPREP_JOB_PIXELS)
+    pJobManager->ParallelFor(nRows, max(TEXPREP_JOB_PIXELS/nRowPixels, 1), pFunc, pData);
+  else
+    pFunc(pData, 0, nRows);
+}
+
+#ifdef TEXPREP_SSE2
+
+// 4 consecutive bytes to floats
+static _inline __m128 sLoad4Bytes(const byte *p)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_cvtsi32_si128(*(const int *)p);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero));
+}
+
+// Same steps as Vec3::NormalizeFast for 4 vectors
+static _inline void sNormalizeFast4(__m128& x, __m128& y, __m128& z)
+{
+  __m128 fLen = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+  __m128i n = _mm_sub_epi32(_mm_set1_epi32(0x5f3759df), _mm_srli_epi32(_mm_castps_si128(fLen), 1));
+  __m128 f = _mm_castsi128_ps(n);
+  f = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fLen, _mm_set1_ps(0.5f)), f), f)), f);
+  x = _mm_mul_ps(x, f);
+  y = _mm_mul_ps(y, f);
+  z = _mm_mul_ps(z, f);
+}
+
+// (byte)(f * fMul + fAdd) for 4 values, result in the low byte of each int
+static _inline __m128i sToByte4(__m128 f, float fMul, float fAdd)
+{
+  __m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(fMul)), _mm_set1_ps(fAdd)));
+  return _mm_and_si128(v, _mm_set1_epi32(0xff));
+}
+
+#endif
+
+//===============================================================================
+
+// Normals of all mip levels as separate x/y/z float planes, laid out like the destination image
+struct SNormalMapJob
+{
+  const byte *m_pGray;
+  float *m_pX;
+  float *m_pY;
+  float *m_pZ;
+  byte *m_pH;
+  byte *m_pDst;
+  int m_nWidth;        // of the level being built
+  int m_nHeight;
+  int m_nOffs;
+  int m_nPrevWidth;
+  int m_nPrevHeight;
+  int m_nPrevOffs;
+  float m_fScale;
+  bool m_bInv;
+  bool m_bSSE;
+  int m_nType;         // r_TexNormalMapType
+  byte m_eTT;
+};
+
+// Level 0, from the gray image (wraps around at the edges)
+static void sNormalMapRows(void *pData, int nBegin, int nEnd)
+{
+  SNormalMapJob *pJ = (SNormalMapJob *)pData;
+  int width = pJ->m_nWidth;
+  int height = pJ->m_nHeight;
+  int mx = width-1;
+  int my = height-1;
+  const byte *gray = pJ->m_pGray;
+  float fScale = pJ->m_fScale;
+  // negating before or after scaling gives the same floats
+  float fScaleInv = pJ->m_bInv ? -fScale : fScale;
+  int i, j;
+
+  for (j=nBegin; j<nEnd; j++)
+  {
+    const byte *pRow = &gray[j*width];
+    const byte *pUp = &gray[((j-1)&my)*width];
+    const byte *pDown = &gray[((j+1)&my)*width];
+    float *pX = &pJ->m_pX[j*width];
+    float *pY = &pJ->m_pY[j*width];
+    float *pZ = &pJ->m_pZ[j*width];
+    cryMemcpy(&pJ->m_pH[j*width], pRow, width);
+
+    i = 0;
+    if (!pJ->m_nType)
+    {
+      while (i < width)
+      {
+#ifdef TEXPREP_SSE2
+        // 4 pixels at a time where the left/right neighbours don't wrap
+        if (pJ->m_bSSE && i >= 1 && i+5 <= width)
+        {
+          __m128 v255 = _mm_set1_ps(255.0f);
+          __m128 vScale = _mm_set1_ps(fScaleInv);
+          for (; i+5<=width; i+=4)
+          {
+            __m128 x = _mm_div_ps(_mm_sub_ps(sLoad4Bytes(&pRow[i-1]), sLoad4Bytes(&pRow[i+1])), v255);
+            __m128 y = _mm_div_ps(_mm_sub_ps(sLoad4Bytes(&pUp[i]), sLoad4Bytes(&pDown[i])), v255);
+            x = _mm_mul_ps(x, vScale);
+            y = _mm_mul_ps(y, vScale);
+            __m128 z = _mm_set1_ps(1.0f);
+            sNormalizeFast4(x, y, z);
+            _mm_storeu_ps(&pX[i], x);
+            _mm_storeu_ps(&pY[i], y);
+            _mm_storeu_ps(&pZ[i], z);
+          }
+          if (i >= width)
+            break;
+        }
+#endif
+        Vec3d vN;
+        vN.x = ((float)pRow[(i-1)&mx] - (float)pRow[(i+1)&mx]) / 255.0f;
+        vN.y = ((float)pUp[i] - (float)pDown[i]) / 255.0f;
+        vN.x *= fScaleInv;
+        vN.y *= fScaleInv;
+        vN.z = 1.0f;
+        vN.NormalizeFast();
+        pX[i] = vN.x;
+        pY[i] = vN.y;
+        pZ[i] = vN.z;
+        i++;
+      }
+    }
+    else
+    {
+      // average of the normals of the two triangles of the quad
+      while (i < width)
+      {
+#ifdef TEXPREP_SSE2
+        if (pJ->m_bSSE && i+5 <= width)
+        {
+          __m128 v255 = _mm_set1_ps(255.0f);
+          __m128 vScale = _mm_set1_ps(fScale);
+          __m128 vScaleInv = _mm_set1_ps(fScaleInv);
+          for (; i+5<=width; i+=4)
+          {
+            __m128 c = sLoad4Bytes(&pRow[i]);
+            __m128 d = sLoad4Bytes(&pDown[i]);
+            __m128 dy = _mm_div_ps(_mm_sub_ps(c, d), v255);
+            __m128 x1 = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(c, sLoad4Bytes(&pRow[i+1])), v255), vScaleInv);
+            __m128 y1 = _mm_mul_ps(dy, vScaleInv);
+            __m128 z1 = _mm_set1_ps(1.0f);
+            sNormalizeFast4(x1, y1, z1);
+            __m128 x2 = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(d, sLoad4Bytes(&pDown[i+1])), v255), vScaleInv);
+            __m128 y2 = _mm_mul_ps(dy, vScale);
+            __m128 z2 = _mm_set1_ps(1.0f);
+            sNormalizeFast4(x2, y2, z2);
+            x1 = _mm_add_ps(x1, x2);
+            y1 = _mm_add_ps(y1, y2);
+            z1 = _mm_add_ps(z1, z2);
+            sNormalizeFast4(x1, y1, z1);
+            _mm_storeu_ps(&pX[i], x1);
+            _mm_storeu_ps(&pY[i], y1);
+            _mm_storeu_ps(&pZ[i], z1);
+          }
+          if (i >= width)
+            break;
+        }
+#endif
+        Vec3d vN1, vN2;
+        float dy = ((float)pRow[i] - (float)pDown[i]) / 255.0f;
+        vN1.x = ((float)pRow[i] - (float)pRow[(i+1)&mx]) / 255.0f;
+        vN1.x *= fScaleInv;
+        vN1.y = dy * fScaleInv;
+        vN1.z = 1.0f;
+        vN1.NormalizeFast();
+
+        // y of the second triangle is scaled but never inverted
+        vN2.x = ((float)pDown[i] - (float)pDown[(i+1)&mx]) / 255.0f;
+        vN2.x *= fScaleInv;
+        vN2.y = dy * fScale;
+        vN2.z = 1.0f;
+        vN2.NormalizeFast();
+
+        Vec3d vN = vN1 + vN2;
+        vN.NormalizeFast();
+        pX[i] = vN.x;
+        pY[i] = vN.y;
+        pZ[i] = vN.z;
+        i++;
+      }
+    }
+  }
+}
+
+// Mip level from the previous one
+static void sNormalMipRows(void *pData, int nBegin, int nEnd)
+{
+  SNormalMapJob *pJ = (SNormalMapJob *)pData;
+  int resw = pJ->m_nWidth;
+  int reswp = pJ->m_nPrevWidth;
+  int wmul = (reswp == 1) ? 1 : 2;
+  int hmul = (pJ->m_nPrevHeight == 1) ? 1 : 2;
+  int i, j;
+
+  for (j=nBegin; j<nEnd; j++)
+  {
+    int nDst = pJ->m_nOffs + j*resw;
+    int nSrc0 = pJ->m_nPrevOffs + hmul*j*reswp;
+    int nSrc1 = pJ->m_nPrevOffs + (hmul*j+1)*reswp;
+    const float *pX0 = &pJ->m_pX[nSrc0];
+    const float *pY0 = &pJ->m_pY[nSrc0];
+    const float *pZ0 = &pJ->m_pZ[nSrc0];
+    const float *pX1 = &pJ->m_pX[nSrc1];
+    const float *pY1 = &pJ->m_pY[nSrc1];
+    const float *pZ1 = &pJ->m_pZ[nSrc1];
+    const byte *pH0 = &pJ->m_pH[nSrc0];
+    const byte *pH1 = &pJ->m_pH[nSrc1];
+    float *pX = &pJ->m_pX[nDst];
+    float *pY = &pJ->m_pY[nDst];
+    float *pZ = &pJ->m_pZ[nDst];
+    byte *pH = &pJ->m_pH[nDst];
+
+    if (wmul == 1)
+    {
+      for (i=0; i<resw; i++)
+      {
+        Vec3d avg = Vec3d(pX0[i], pY0[i], pZ0[i]) + Vec3d(pX1[i], pY1[i], pZ1[i]);
+        avg.NormalizeFast();
+        pX[i] = avg.x;
+        pY[i] = avg.y;
+        pZ[i] = avg.z;
+        pH[i] = (pH0[i] + pH1[i]) / 2;
+      }
+      continue;
+    }
+    if (hmul == 1)
+    {
+      for (i=0; i<resw; i++)
+      {
+        Vec3d avg = Vec3d(pX0[2*i], pY0[2*i], pZ0[2*i]) + Vec3d(pX0[2*i+1], pY0[2*i+1], pZ0[2*i+1]);
+        avg.NormalizeFast();
+        pX[i] = avg.x;
+        pY[i] = avg.y;
+        pZ[i] = avg.z;
+        pH[i] = (pH0[2*i] + pH0[2*i+1]) / 2;
+      }
+      continue;
+    }
+    i = 0;
+#ifdef TEXPREP_SSE2
+    if (pJ->m_bSSE)
+    {
+      // adds in the same order as the scalar loop: top left, top right, bottom right, bottom left
+      for (; i+4<=resw; i+=4)
+      {
+        __m128 a0, a1, b0, b1, v[3];
+        const float *pSrc0[3] = {&pX0[2*i], &pY0[2*i], &pZ0[2*i]};
+        const float *pSrc1[3] = {&pX1[2*i], &pY1[2*i], &pZ1[2*i]};
+        for (int c=0; c<3; c++)
+        {
+          a0 = _mm_loadu_ps(pSrc0[c]);
+          a1 = _mm_loadu_ps(pSrc0[c]+4);
+          b0 = _mm_loadu_ps(pSrc1[c]);
+          b1 = _mm_loadu_ps(pSrc1[c]+4);
+          __m128 tl = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0));
+          __m128 tr = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1));
+          __m128 bl = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0));
+          __m128 br = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1));
+          v[c] = _mm_add_ps(_mm_add_ps(_mm_add_ps(tl, tr), br), bl);
+        }
+        sNormalizeFast4(v[0], v[1], v[2]);
+        _mm_storeu_ps(&pX[i], v[0]);
+        _mm_storeu_ps(&pY[i], v[1]);
+        _mm_storeu_ps(&pZ[i], v[2]);
+        for (int k=i; k<i+4; k++)
+          pH[k] = (pH0[2*k] + pH0[2*k+1] + pH1[2*k+1] + pH1[2*k]) / 4;
+      }
+    }
+#endif
+    for (; i<resw; i++)
+    {
+      Vec3d avg = Vec3d(pX0[2*i], pY0[2*i], pZ0[2*i]) +
+                  Vec3d(pX0[2*i+1], pY0[2*i+1], pZ0[2*i+1]) +
+                  Vec3d(pX1[2*i+1], pY1[2*i+1], pZ1[2*i+1]) +
+                  Vec3d(pX1[2*i], pY1[2*i], pZ1[2*i]);
+      avg.NormalizeFast();
+      pX[i] = avg.x;
+      pY[i] = avg.y;
+      pZ[i] = avg.z;
+      pH[i] = (pH0[2*i] + pH0[2*i+1] + pH1[2*i+1] + pH1[2*i]) / 4;
+    }
+  }
+}
+
+// Planes to the destination texels, the pixels of all mips in one range
+static void sNormalMapPack(void *pData, int nBegin, int nEnd)
+{
+  SNormalMapJob *pJ = (SNormalMapJob *)pData;
+  byte *dst = pJ->m_pDst;
+  int n = nBegin;
+  if (pJ->m_eTT == eTT_Bumpmap)
+  {
+#ifdef TEXPREP_SSE2
+    if (pJ->m_bSSE)
+    {
+      __m128i zero = _mm_setzero_si128();
+      for (; n+4<=nEnd; n+=4)
+      {
+        __m128i b = sToByte4(_mm_loadu_ps(&pJ->m_pZ[n]), 127.0f, 128.0f);
+        __m128i g = sToByte4(_mm_loadu_ps(&pJ->m_pY[n]), 127.0f, 128.0f);
+        __m128i r = sToByte4(_mm_loadu_ps(&pJ->m_pX[n]), 127.0f, 128.0f);
+        __m128i a = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)&pJ->m_pH[n]), zero), zero);
+        __m128i v = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(a, 24)));
+        _mm_storeu_si128((__m128i *)&dst[n*4], v);
+      }
+    }
+#endif
+    for (; n<nEnd; n++)
+    {
+      dst[n*4+2] = (byte)(pJ->m_pX[n] * 127.0f + 128.0f);
+      dst[n*4+1] = (byte)(pJ->m_pY[n] * 127.0f + 128.0f);
+      dst[n*4+0] = (byte)(pJ->m_pZ[n] * 127.0f + 128.0f);
+      dst[n*4+3] = pJ->m_pH[n];
+    }
+  }
+  else
+  if (pJ->m_eTT == eTT_DSDTBump)
+  {
+    for (; n<nEnd; n++)
+    {
+      float f = pJ->m_pX[n] * 127.5f;
+      dst[n*4+0] = (byte)(f);
+      f = pJ->m_pY[n] * 127.5f;
+      dst[n*4+1] = (byte)(f);
+      dst[n*4+2] = (byte)(63.0f);
+    }
+  }
+}
+
+//===============================================================================
+
+// Merges the normals of s into d (nCount texels, both runs are contiguous)
+static void sMergeNormals(byte *d, const byte *s, int nCount, int nIndexNM, bool bSSE)
+{
+  int n = 0;
+#ifdef TEXPREP_SSE2
+  if (bSSE)
+  {
+    __m128i mask = _mm_set1_epi32(0xff);
+    __m128 v255 = _mm_set1_ps(255.0f);
+    __m128 vHalf = _mm_set1_ps(0.5f);
+    __m128 vTwo = _mm_set1_ps(2.0f);
+    __m128 vOne = _mm_set1_ps(1.0f);
+    __m128 vMinusOne = _mm_set1_ps(-1.0f);
+    for (; n+4<=nCount; n+=4)
+    {
+      __m128i c[2];
+      __m128 x[2], y[2], z[2];
+      c[0] = _mm_loadu_si128((const __m128i *)&d[n*4]);
+      c[1] = _mm_loadu_si128((const __m128i *)&s[n*4]);
+      for (int k=0; k<2; k++)
+      {
+        x[k] = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c[k], 16), mask)), v255), vHalf), vTwo);
+        y[k] = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c[k], 8), mask)), v255), vHalf), vTwo);
+        z[k] = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(c[k], mask)), v255), vHalf), vTwo);
+      }
+      __m128 fLen = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x[nIndexNM], x[nIndexNM]), _mm_mul_ps(y[nIndexNM], y[nIndexNM])), _mm_mul_ps(z[nIndexNM], z[nIndexNM]));
+      fLen = _mm_min_ps(_mm_sqrt_ps(fLen), vOne);
+
+      __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_div_ps(x[0], z[0]), _mm_div_ps(x[1], z[1])), vTwo);
+      __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_div_ps(y[0], z[0]), _mm_div_ps(y[1], z[1])), vTwo);
+      __m128 vz = vTwo;
+      sNormalizeFast4(vx, vy, vz);
+      vx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(vx, fLen), vMinusOne), vOne);
+      vy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(vy, fLen), vMinusOne), vOne);
+      vz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(vz, fLen), vMinusOne), vOne);
+
+      __m128i a = _mm_srli_epi32(_mm_add_epi32(_mm_srli_epi32(c[0], 24), _mm_srli_epi32(c[1], 24)), 1);
+      __m128i v = _mm_or_si128(_mm_or_si128(sToByte4(vz, 127.0f, 128.0f), _mm_slli_epi32(sToByte4(vy, 127.0f, 128.0f), 8)),
+                               _mm_or_si128(_mm_slli_epi32(sToByte4(vx, 127.0f, 128.0f), 16), _mm_slli_epi32(a, 24)));
+      _mm_storeu_si128((__m128i *)&d[n*4], v);
+    }
+  }
+#endif
+  for (; n<nCount; n++)
+  {
+    Vec3d vN[2];
+    vN[0].x = (d[n*4+2]/255.0f-0.5f)*2.0f;
+    vN[0].y = (d[n*4+1]/255.0f-0.5f)*2.0f;
+    vN[0].z = (d[n*4+0]/255.0f-0.5f)*2.0f;
+
+    vN[1].x = (s[n*4+2]/255.0f-0.5f)*2.0f;
+    vN[1].y = (s[n*4+1]/255.0f-0.5f)*2.0f;
+    vN[1].z = (s[n*4+0]/255.0f-0.5f)*2.0f;
+
+    float fLen = min(vN[nIndexNM].Length(), 1.0f);
+
+    vN[0].x /= vN[0].z;
+    vN[0].y /= vN[0].z;
+    vN[0].z = 1.0f;
+
+    vN[1].x /= vN[1].z;
+    vN[1].y /= vN[1].z;
+    vN[1].z = 1.0f;
+
+    vN[0] = vN[0] + vN[1];
+    vN[0].x *= 2.0f;
+    vN[0].y *= 2.0f;
+    vN[0].NormalizeFast();
+    vN[0] *= fLen;
+    vN[0].CheckMax(Vec3(-1,-1,-1));
+    vN[0].CheckMin(Vec3(1,1,1));
+
+    d[n*4+2] = (byte)(vN[0].x * 127.0f + 128.0f);
+    d[n*4+1] = (byte)(vN[0].y * 127.0f + 128.0f);
+    d[n*4+0] = (byte)(vN[0].z * 127.0f + 128.0f);
+    d[n*4+3] = (d[n*4+3] + s[n*4+3]) >> 1;
+  }
+}
+
+struct SMergeNormalsJob
+{
+  byte *m_pDst;
+  const byte *m_pSrc;
+  int m_nIndexNM;
+  bool m_bSSE;
+  // tiled second map
+  int m_nWidth;
+  int m_nWidth1;
+  int m_nHeight1;
+};
+
+// Both maps have the same size, ranges of texels over all mips
+static void sMergeNormalsRange(void *pData, int nBegin, int nEnd)
+{
+  SMergeNormalsJob *pJ = (SMergeNormalsJob *)pData;
+  sMergeNormals(&pJ->m_pDst[nBegin*4], &pJ->m_pSrc[nBegin*4], nEnd-nBegin, pJ->m_nIndexNM, pJ->m_bSSE);
+}
+
+// Rows of one mip, the second map repeats
+static void sMergeNormalsTiledRows(void *pData, int nBegin, int nEnd)
+{
+  SMergeNormalsJob *pJ = (SMergeNormalsJob *)pData;
+  int wdt = pJ->m_nWidth;
+  int wdt1 = pJ->m_nWidth1;
+  int mwdt = wdt1-1;
+  int mhgt = pJ->m_nHeight1-1;
+  // runs of the second map are only contiguous if the wrap is a power of two
+  bool bRuns = !(wdt1 & mwdt);
+  for (int j=nBegin; j<nEnd; j++)
+  {
+    byte *d = &pJ->m_pDst[j*wdt*4];
+    const byte *s = &pJ->m_pSrc[(j&mhgt)*wdt1*4];
+    int i = 0;
+    while (i < wdt)
+    {
+      int k = i & mwdt;
+      int nRun = bRuns ? min(wdt-i, wdt1-k) : 1;
+      sMergeNormals(&d[i*4], &s[k*4], nRun, pJ->m_nIndexNM, pJ->m_bSSE);
+      i += nRun;
+    }
+  }
+}
+
+//===============================================================================
+
+struct SMipMap32Job
+{
+  byte *m_pIn;
+  byte *m_pOut;
+  int m_nWidth;        // of the destination
+  bool m_bSSE;
+};
+
+static void sMipMap32Rows(void *pData, int nBegin, int nEnd)
+{
+  SMipMap32Job *pJ = (SMipMap32Job *)pData;
+  int width = pJ->m_nWidth;
+  int wd = width<<3;
+  for (int i=nBegin; i<nEnd; i++)
+  {
+    byte *src2 = &pJ->m_pIn[i*(wd<<1)];
+    byte *dst1 = &pJ->m_pOut[i*(width<<2)];
+    int j = 0;
+#ifdef TEXPREP_SSE2
+    if (pJ->m_bSSE)
+    {
+      __m128i zero = _mm_setzero_si128();
+      for (; j+4<=width; j+=4)
+      {
+        __m128i a0 = _mm_loadu_si128((__m128i *)src2);
+        __m128i a1 = _mm_loadu_si128((__m128i *)(src2+16));
+        __m128i b0 = _mm_loadu_si128((__m128i *)(src2+wd));
+        __m128i b1 = _mm_loadu_si128((__m128i *)(src2+wd+16));
+        // vertical sums, 2 source texels with 16 bits per channel each
+        __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+        // horizontal pairs
+        __m128i d0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        __m128i d1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+        _mm_storeu_si128((__m128i *)dst1, _mm_packus_epi16(_mm_srli_epi16(d0, 2), _mm_srli_epi16(d1, 2)));
+        dst1 += 16;
+        src2 += 32;
+      }
+    }
+#endif
+    for (; j<width; j++)
+    {
+      dst1[0] = (src2[0]+src2[4]+src2[wd+0]+src2[wd+4])>>2;
+      dst1[1] = (src2[1]+src2[5]+src2[wd+1]+src2[wd+5])>>2;
+      dst1[2] = (src2[2]+src2[6]+src2[wd+2]+src2[wd+6])>>2;
+      dst1[3] = (src2[3]+src2[7]+src2[wd+3]+src2[wd+7])>>2;
+      dst1 += 4;
+      src2 += 8;
+    }
+  }
+}
+
+struct SMipMap8Job
+{
+  byte *m_pIn;
+  byte *m_pOut;
+  int m_nWidth;        // of the source
+  uint *m_pSrcTable;
+  byte *m_pDstTable;
+};
+
+static void sMipMap8Rows(void *pData, int nBegin, int nEnd)
+{
+  SMipMap8Job *pJ = (SMipMap8Job *)pData;
+  int width = pJ->m_nWidth;
+  uint *tabsrc = pJ->m_pSrcTable;
+  byte *tabdst = pJ->m_pDstTable;
+  for (int i=nBegin; i<nEnd; i++)
+  {
+    byte *in = &pJ->m_pIn[i*width*2];
+    byte *out = &pJ->m_pOut[i*((width+1)>>1)];
+    for (int j=0; j<width; j+=2,out+=1,in+=2)
+    {
+      byte *at1 = (byte *) (tabsrc + in[0]);
+      byte *at2 = (byte *) (tabsrc + in[1]);
+      byte *at3 = (byte *) (tabsrc + in[width+0]);
+      byte *at4 = (byte *) (tabsrc + in[width+1]);
+
+      uint r = (at1[0]+at2[0]+at3[0]+at4[0]); r>>=5;
+      uint g = (at1[1]+at2[1]+at3[1]+at4[1]); g>>=5;
+      uint b = (at1[2]+at2[2]+at3[2]+at4[2]); b>>=5;
+
+      out[0] = tabdst[(r<<0) + (g<<5) + (b<<10)];
+    }
+  }
+}
+
+// Point sampling, the same loop for 8 and 32 bit texels
+template <class T> struct SImgResampleJob
+{
+  T *m_pOut;
+  T *m_pIn;
+  int m_nOX, m_nOY;
+  int m_nIX, m_nIY;
+};
+
+template <class T> static void sImgResampleRows(void *pData, int nBegin, int nEnd)
+{
+  SImgResampleJob<T> *pJ = (SImgResampleJob<T> *)pData;
+  int ox = pJ->m_nOX;
+  uint fracstep = pJ->m_nIX*0x10000/ox;
+  for (int i=nBegin; i<nEnd; i++)
+  {
+    T *uout = &pJ->m_pOut[i*ox];
+    T *inrow = pJ->m_pIn + pJ->m_nIX*(i*pJ->m_nIY/pJ->m_nOY);
+    uint ifrac = fracstep >> 1;
+    int j = 0;
+    for (; j+4<=ox; j+=4)
+    {
+      uout[j] = inrow[ifrac>>16];
+      ifrac += fracstep;
+      uout[j+1] = inrow[ifrac>>16];
+      ifrac += fracstep;
+      uout[j+2] = inrow[ifrac>>16];
+      ifrac += fracstep;
+      uout[j+3] = inrow[ifrac>>16];
+      ifrac += fracstep;
+    }
+    for (; j<ox; j++)
+    {
+      uout[j] = inrow[ifrac>>16];
+      ifrac += fracstep;
+    }
+  }
+}
+
+// R<->B of 32 bit texels
+static void sSwapRB32(byte *p, int nCount)
+{
+  int i = 0;
+#ifdef TEXPREP_SSE2
+  if (sTexPrepSSE())
+  {
+    __m128i maskGA = _mm_set1_epi32(0xff00ff00);
+    __m128i mask = _mm_set1_epi32(0xff);
+    for (; i+4<=nCount; i+=4)
+    {
+      __m128i v = _mm_loadu_si128((__m128i *)&p[i*4]);
+      __m128i rb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), mask), _mm_slli_epi32(_mm_and_si128(v, mask), 16));
+      _mm_storeu_si128((__m128i *)&p[i*4], _mm_or_si128(_mm_and_si128(v, maskGA), rb));
+    }
+  }
+#endif
+  for (; i<nCount; i++)
+  {
+    Exchange(p[i*4+0], p[i*4+2]);
+  }
+}
+
 //===============================================================================
 
 void CTexMan::ImagePreprocessing(CImageFile* im, uint flags, uint flags2, byte eTT, STexPic *ti)
@@ -2058,7 +2719,7 @@ byte *CTexMan::ConvertRGB_Gray(byte *src, STexPic *ti, int flags, ETEX_Format eT
 byte *CTexMan::GenerateNormalMap(byte *src, int width, int height, uint flags, uint flags2, byte eTT, float fAmount, STexPic *ti, int& nMips, int& nSize, ETEX_Format eTF)
 {
   byte *dst;
-  int i, j, l;
+  int l;
 
   ti->m_Width = width;
   ti->m_Height = height;
@@ -2099,8 +2760,6 @@ byte *CTexMan::GenerateNormalMap(byte *src, int width, int height, uint flags, u
     }
     nMips = max(nlevelsw, nlevelsh);
   }
-  int mx = width-1;
-  int my = height-1;
   /*if (eTT == eTT_DSDTBump)
   {
     nMips = 1;
@@ -2152,86 +2811,9 @@ byte *CTexMan::GenerateNormalMap(byte *src, int width, int height, uint flags, u
     return dst;
   }*/
 
-  TArray<Vec3d> *Normals = new TArray<Vec3d> [nMips];
-  TArray<byte> *Heights = new TArray<byte> [nMips];
-  nSize = width * height * 4;
-  if (!CRenderer::CV_r_texnormalmaptype)
-  {
-    Normals[0].Grow(width*height);
-    Heights[0].Grow(width*height);
-    Vec3d *vDst = &Normals[0][0];
-    byte *bDst = &Heights[0][0];
-    for(j=0; j<height; j++)
-    {
-      for(i=0; i<width; i++)
-      {
-        Vec3d vN;
-        vN.x = ((float)gray[j*width+((i-1)&mx)] - (float)gray[j*width+((i+1)&mx)]) / 255.0f;
-        vN.y = ((float)gray[((j-1)&my)*width+i] - (float)gray[((j+1)&my)*width+i]) / 255.0f;
-        if (bInv)
-        {
-          vN[0] = -vN[0];
-          vN[1] = -vN[1];
-        }
-        vN.x *= fScale;
-        vN.y *= fScale;
-        vN.z = 1.0f;
-        vN.NormalizeFast();
-        *vDst = vN;
-        vDst++;
-        *bDst = gray[j*width+i];
-        bDst++;
-      }
-    }
-  }
-  else
-  {
-    Normals[0].Grow(width*height);
-    Vec3d *vDst = &Normals[0][0];
-    Heights[0].Grow(width*height);
-    byte *bDst = &Heights[0][0];
-    for(j=0; j<height; j++)
-    {
-      for(i=0; i<width; i++)
-      {
-        Vec3d vN1, vN2;
-        vN1.x = ((float)gray[j*width+i] - (float)gray[j*width+((i+1)&mx)]) / 255.0f;
-        vN1.y = ((float)gray[j*width+i] - (float)gray[((j+1)&my)*width+i]) / 255.0f;
-        if (bInv)
-        {
-          vN1.x = -vN1.x;
-          vN1.y = -vN1.y;
-        }
-        vN1.x *= fScale;
-        vN1.y *= fScale;
-        float f = vN1.y;
-        vN1.z = 1.0f;
-        vN1.NormalizeFast();
-
-        vN2.x = ((float)gray[((j+1)&my)*width+i] - (float)gray[((j+1)&my)*width+((i+1)&mx)]) / 255.0f;
-        vN2.y = f;
-        if (bInv)
-        {
-          vN2.x = -vN2.x;
-          vN2.y = -vN2.y;
-        }
-        vN2.x *= fScale;
-        vN2.z = 1.0f;
-        vN2.NormalizeFast();
-
-        *vDst = vN1 + vN2;
-        vDst->NormalizeFast();
-        vDst++;
-
-        *bDst = gray[j*width+i];
-        bDst++;
-      }
-    }
-  }
-
-  int reswp = width;
-  int reshp = height;
-  for (l=1; l<nMips; l++)
+  int nPixels = 0;
+  int nOffs[32];
+  for (l=0; l<nMips; l++)
   {
     int resw = width  >> l;
     int resh = height >> l;
@@ -2239,112 +2821,50 @@ byte *CTexMan::GenerateNormalMap(byte *src, int width, int height, uint flags, u
       resw = 1;
     if (!resh)
       resh = 1;
-    nSize += resw * resh * 4;
-    Normals[l].Grow(resw*resh);
-    Heights[l].Grow(resw*resh);
-    Vec3d *curr = &Normals[l][0];
-    Vec3d *prev = &Normals[l-1][0];
-    byte *bcurr = &Heights[l][0];
-    byte *bprev = &Heights[l-1][0];
-    int wmul = (reswp == 1) ? 1 : 2;
-    int hmul = (reshp == 1) ? 1 : 2;
-    for (j=0; j<resh; j++)
-    {
-      for (i=0; i<resw; i++)
-      {
-        Vec3d avg;
-        int bavg;
-        if (wmul == 1)
-        {
-          avg = prev[wmul*i+hmul*j*reswp] +
-                prev[wmul*i+(hmul*j+1)*reswp];
-          bavg = bprev[wmul*i+hmul*j*reswp] +
-                 bprev[wmul*i+(hmul*j+1)*reswp];
-          bavg /= 2;
-        }
-        else
-        if (hmul == 1)
-        {
-          avg = prev[wmul*i+hmul*j*reswp] +
-                prev[wmul*i+1+hmul*j*reswp];
-          bavg = bprev[wmul*i+hmul*j*reswp] +
-                 bprev[wmul*i+1+hmul*j*reswp];
-          bavg /= 2;
-        }
-        else
-        {
-          avg = prev[wmul*i+hmul*j*reswp] +
-                prev[wmul*i+1+hmul*j*reswp] +
-                prev[wmul*i+1+(hmul*j+1)*reswp] +
-                prev[wmul*i+(hmul*j+1)*reswp];
-          bavg = bprev[wmul*i+hmul*j*reswp] +
-                 bprev[wmul*i+1+hmul*j*reswp] +
-                 bprev[wmul*i+1+(hmul*j+1)*reswp] +
-                 bprev[wmul*i+(hmul*j+1)*reswp];
-          bavg /= 4;
-        }
-        avg.NormalizeFast();
-        *curr = avg;
-        curr++;
-        *bcurr = bavg;
-        bcurr++;
-      }
-    }
-    reswp = resw;
-    reshp = resh;
-  }
-  dst = new byte[nSize];
-  int n = 0;
-  if (eTT == eTT_Bumpmap)
+    nOffs[l] = nPixels;
+    nPixels += resw * resh;
+  }
+  nSize = nPixels * 4;
+
+  float *pNormals = new float[nPixels*3];
+  byte *pHeights = new byte[nPixels];
+
+  SNormalMapJob job;
+  job.m_pGray = gray;
+  job.m_pX = pNormals;
+  job.m_pY = &pNormals[nPixels];
+  job.m_pZ = &pNormals[nPixels*2];
+  job.m_pH = pHeights;
+  job.m_pDst = NULL;
+  job.m_nWidth = width;
+  job.m_nHeight = height;
+  job.m_nOffs = 0;
+  job.m_nPrevWidth = job.m_nPrevHeight = job.m_nPrevOffs = 0;
+  job.m_fScale = fScale;
+  job.m_bInv = bInv;
+  job.m_bSSE = sTexPrepSSE();
+  job.m_nType = CRenderer::CV_r_texnormalmaptype;
+  job.m_eTT = eTT;
+  sTexPrepFor(height, width, sNormalMapRows, &job);
+
+  // each mip needs the previous one, the rows of one level are independent
+  for (l=1; l<nMips; l++)
   {
-    for (l=0; l<nMips; l++)
-    {
-      int resw = width  >> l;
-      int resh = height >> l;
-      if (!resw)
-        resw = 1;
-      if (!resh)
-        resh = 1;
-      for (i=0; i<resw*resh; i++)
-      {
-        Vec3d vN = Normals[l][i];
-        byte bH = Heights[l][i];
-        dst[n*4+2] = (byte)(vN.x * 127.0f + 128.0f);
-        dst[n*4+1] = (byte)(vN.y * 127.0f + 128.0f);
-        dst[n*4+0] = (byte)(vN.z * 127.0f + 128.0f);
-        dst[n*4+3] = bH;
-        n++;
-      }
-    }
-  }
-  else
-  if (eTT == eTT_DSDTBump)
-  {
-    for (l=0; l<nMips; l++)
-    {
-      int resw = width  >> l;
-      int resh = height >> l;
-      if (!resw)
-        resw = 1;
-      if (!resh)
-        resh = 1;
-      for (i=0; i<resw*resh; i++)
-      {
-        Vec3d vN = Normals[l][i];
-        float f = vN.x * 127.5f;
-        dst[n*4+0] = (byte)(f);
-        f = vN.y * 127.5f;
-        dst[n*4+1] = (byte)(f);
-        dst[n*4+2] = (byte)(63.0f);
-        //dst[n*3+0] = byte(   (vN.x>=0.0f) ? (vN.x* 127.5f) : (256.0f + vN.x * 127.5f));
-        //dst[n*3+1] = byte(   (vN.y>=0.0f) ? (vN.y* 127.5f) : (256.0f + vN.y * 127.5f));
-        n++;
-      }
-    }
+    job.m_nPrevWidth = job.m_nWidth;
+    job.m_nPrevHeight = job.m_nHeight;
+    job.m_nPrevOffs = job.m_nOffs;
+    job.m_nWidth = max(width >> l, 1);
+    job.m_nHeight = max(height >> l, 1);
+    job.m_nOffs = nOffs[l];
+    sTexPrepFor(job.m_nHeight, job.m_nWidth, sNormalMipRows, &job);
   }
 
-  delete [] Heights;
-  delete [] Normals;
+  dst = new byte[nSize];
+  job.m_pDst = dst;
+  sTexPrepFor(nPixels, 1, sNormalMapPack, &job);
+
+  delete [] pHeights;
+  delete [] pNormals;
   delete [] gray;
 
   return dst;
@@ -2352,17 +2872,22 @@ byte *CTexMan::GenerateNormalMap(byte *src, int width, int height, uint flags, u
 
 void CTexMan::MergeNormalMaps(byte *src[2], CImageFile *im[2], int nMips[2])
 {
-  int i, j, l, n;
+  int l;
 
   int Width0 = im[0]->mfGet_width();
   int Height0 = im[0]->mfGet_height();
   int Width1 = im[1]->mfGet_width();
   int Height1 = im[1]->mfGet_height();
-  n = 0;
-  int nIndexNM = (im[0]->mfGet_Flags() & FIM_NORMALMAP) ? 0 : 1;
+
+  SMergeNormalsJob job;
+  job.m_pDst = src[0];
+  job.m_pSrc = src[1];
+  job.m_nIndexNM = (im[0]->mfGet_Flags() & FIM_NORMALMAP) ? 0 : 1;
+  job.m_bSSE = sTexPrepSSE();
 
   if (Width0 == Width1 && Height0 == Height1)
   {
+    int nPixels = 0;
     for (l=0; l<nMips[0]; l++)
     {
       int wdt = Width0 >> l;
@@ -2371,48 +2896,13 @@ void CTexMan::MergeNormalMaps(byte *src[2], CImageFile *im[2], int nMips[2])
         wdt = 1;
       if (!hgt)
         hgt = 1;
-      for (j=0; j<hgt; j++)
-      {
-        for (i=0; i<wdt; i++)
-        {
-          Vec3d vN[2];
-          vN[0].x = (src[0][n*4+2]/255.0f-0.5f)*2.0f;
-          vN[0].y = (src[0][n*4+1]/255.0f-0.5f)*2.0f;
-          vN[0].z = (src[0][n*4+0]/255.0f-0.5f)*2.0f;
-
-          vN[1].x = (src[1][n*4+2]/255.0f-0.5f)*2.0f;
-          vN[1].y = (src[1][n*4+1]/255.0f-0.5f)*2.0f;
-          vN[1].z = (src[1][n*4+0]/255.0f-0.5f)*2.0f;
-
-          float fLen = min(vN[nIndexNM].Length(), 1.0f);
-
-          vN[0].x /= vN[0].z;
-          vN[0].y /= vN[0].z;
-          vN[0].z = 1.0f;
-
-          vN[1].x /= vN[1].z;
-          vN[1].y /= vN[1].z;
-          vN[1].z = 1.0f;
-
-          vN[0] = vN[0] + vN[1];
-          vN[0].x *= 2.0f;
-          vN[0].y *= 2.0f;
-          vN[0].NormalizeFast();
-          vN[0] *= fLen;
-          vN[0].CheckMax(Vec3(-1,-1,-1));
-          vN[0].CheckMin(Vec3(1,1,1));
-
-          src[0][n*4+2] = (byte)(vN[0].x * 127.0f + 128.0f);
-          src[0][n*4+1] = (byte)(vN[0].y * 127.0f + 128.0f);
-          src[0][n*4+0] = (byte)(vN[0].z * 127.0f + 128.0f);
-          src[0][n*4+3] = (src[0][n*4+3] + src[1][n*4+3]) >> 1;
-          n++;
-        }
-      }
+      nPixels += wdt * hgt;
     }
+    sTexPrepFor(nPixels, 1, sMergeNormalsRange, &job);
   }
   else
   {
+    int n = 0;
     for (l=0; l<nMips[0]; l++)
     {
       int wdt = Width0 >> l;
@@ -2428,50 +2918,38 @@ void CTexMan::MergeNormalMaps(byte *src[2], CImageFile *im[2], int nMips[2])
         wdt1 = 1;
       if (!hgt1)
         hgt1 = 1;
-      int mwdt = wdt1-1;
-      int mhgt = hgt1-1;
-      for (j=0; j<hgt; j++)
-      {
-        for (i=0; i<wdt; i++)
-        {
-          Vec3d vN[2];
-          vN[0].x = (src[0][n*4+2]/255.0f-0.5f)*2.0f;
-          vN[0].y = (src[0][n*4+1]/255.0f-0.5f)*2.0f;
-          vN[0].z = (src[0][n*4+0]/255.0f-0.5f)*2.0f;
-
-          vN[1].x = (src[1][(i&mwdt)*4+(j&mhgt)*wdt1*4+2]/255.0f-0.5f)*2.0f;
-          vN[1].y = (src[1][(i&mwdt)*4+(j&mhgt)*wdt1*4+1]/255.0f-0.5f)*2.0f;
-          vN[1].z = (src[1][(i&mwdt)*4+(j&mhgt)*wdt1*4+0]/255.0f-0.5f)*2.0f;
-
-          float fLen = min(vN[nIndexNM].Length(), 1.0f);
-
-          vN[0].x /= vN[0].z;
-          vN[0].y /= vN[0].z;
-          vN[0].z = 1.0f;
-
-          vN[1].x /= vN[1].z;
-          vN[1].y /= vN[1].z;
-          vN[1].z = 1.0f;
-
-          vN[0] = vN[0] + vN[1];
-          vN[0].x *= 2.0f;
-          vN[0].y *= 2.0f;
-          vN[0].NormalizeFast();
-          vN[0] *= fLen;
-          vN[0].CheckMax(Vec3(-1,-1,-1));
-          vN[0].CheckMin(Vec3(1,1,1));
-
-          src[0][n*4+2] = (byte)(vN[0].x * 127.0f + 128.0f);
-          src[0][n*4+1] = (byte)(vN[0].y * 127.0f + 128.0f);
-          src[0][n*4+0] = (byte)(vN[0].z * 127.0f + 128.0f);
-          src[0][n*4+3] = (src[0][n*4+3] + src[1][(i&mwdt)*4+(j&mhgt)*wdt1*4+3]) >> 1;
-          n++;
-        }
-      }
+      job.m_pDst = &src[0][n*4];
+      job.m_nWidth = wdt;
+      job.m_nWidth1 = wdt1;
+      job.m_nHeight1 = hgt1;
+      sTexPrepFor(hgt, wdt, sMergeNormalsTiledRows, &job);
+      n += wdt * hgt;
     }
   }
 }
 
+// Builds the normal map of the second source of a bump texture while the first one is done on the calling thread
+struct SNormalMapSrcJob
+{
+  CTexMan *m_pTexMan;
+  CImageFile *m_pIm;
+  uint m_Flags;
+  uint m_Flags2;
+  byte m_eTT;
+  float m_fAmount;
+  STexPic *m_pTI;
+  int m_nMips;
+  int m_nSize;
+  ETEX_Format m_eTF;
+  byte *m_pDst;
+};
+
+void CTexMan::GenerateNormalMapJob(void *pData)
+{
+  SNormalMapSrcJob *pJ = (SNormalMapSrcJob *)pData;
+  pJ->m_pDst = pJ->m_pTexMan->GenerateNormalMap((byte *)pJ->m_pIm->mfGet_image(), pJ->m_pIm->mfGet_width(), pJ->m_pIm->mfGet_height(), pJ->m_Flags, pJ->m_Flags2, pJ->m_eTT, pJ->m_fAmount, pJ->m_pTI, pJ->m_nMips, pJ->m_nSize, pJ->m_eTF);
+}
+
 void CTexMan::GenerateNormalMap(CImageFile** im, uint flags, uint flags2, byte eTT, float fAmount1, float fAmount2, STexPic *ti)
 {
   byte *dst[2];
@@ -2481,6 +2959,27 @@ void CTexMan::GenerateNormalMap(CImageFile** im, uint flags, uint flags2, byte e
   nMips[0] = nMips[1] = 0;
   nSizeWithMips[0] = nSizeWithMips[1] = 0;
 
+  // both sources are independent, the second one goes to a job if it has to be generated as well
+  IJobManager *pJobManager = (CRenderer::CV_r_texpreprocessmt >= 2 && iSystem) ? iSystem->GetIJobManager() : NULL;
+  JobCounter jobSrc1;
+  SNormalMapSrcJob src1;
+  src1.m_pTI = NULL;
+  if (pJobManager && im[1] && !(im[0]->mfGet_Flags() & (FIM_NORMALMAP | FIM_DSDT)) && !(im[1]->mfGet_Flags() & (FIM_NORMALMAP | FIM_DSDT)))
+  {
+    src1.m_pTexMan = this;
+    src1.m_pIm = im[1];
+    src1.m_Flags = flags;
+    src1.m_Flags2 = flags2;
+    src1.m_eTT = eTT;
+    src1.m_fAmount = fAmount2;
+    src1.m_pTI = new STexPic;   // only used for the size of the gray image
+    src1.m_nMips = 0;
+    src1.m_nSize = 0;
+    src1.m_eTF = sImageFormat2TexFormat(im[1]->m_eFormat);
+    src1.m_pDst = NULL;
+    pJobManager->AddJob(GenerateNormalMapJob, &src1, &jobSrc1);
+  }
+
   if ((im[0]->mfGet_Flags() & FIM_NORMALMAP) || (im[0]->mfGet_Flags() & FIM_DSDT))
   {
     dst[0] = im[0]->mfGet_image();
@@ -2494,6 +2993,17 @@ void CTexMan::GenerateNormalMap(CImageFile** im, uint flags, uint flags2, byte e
     ti->m_ETF = eTF_8888;
   }
 
+  if (src1.m_pTI)
+  {
+    pJobManager->WaitForJobs(&jobSrc1);
+    dst[1] = src1.m_pDst;
+    nMips[1] = src1.m_nMips;
+    nSizeWithMips[1] = src1.m_nSize;
+    ti->m_Width = src1.m_pTI->m_Width;
+    ti->m_Height = src1.m_pTI->m_Height;
+    delete src1.m_pTI;
+  }
+  else
   if (im[1])
   {
     if ((im[1]->mfGet_Flags() & FIM_NORMALMAP) || (im[1]->mfGet_Flags() & FIM_DSDT))
@@ -2559,88 +3069,31 @@ void CTexMan::BuildImageGamma(int wdt, int hgt, byte *dst, bool bHasAlpha)
 
 void CTexMan::ImgResample(uint *uout, int ox, int oy, uint *uin, int ix, int iy)
 {
-  int   i, j;
-  uint  *inrow;
-  uint  ifrac, fracstep;
-
-  fracstep = ix*0x10000/ox;
-  if (!(ox & 3))
-  {
-    for (i=0 ; i<oy ; i++, uout += ox)
-    {
-      inrow = uin + ix*(i*iy/oy);
-      ifrac = fracstep >> 1;
-      for (j=0 ; j<ox ; j+=4)
-      {
-        uout[j] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+1] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+2] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+3] = inrow[ifrac>>16];
-        ifrac += fracstep;
-      }
-    }
-  }
-  else
-  {
-    for (i=0 ; i<oy ; i++, uout += ox)
-    {
-      inrow = uin + ix*(i*iy/oy);
-      ifrac = fracstep >> 1;
-      for (j=0 ; j<ox ; j++)
-      {
-        uout[j] = inrow[ifrac>>16];
-        ifrac += fracstep;
-      }
-    }
-  }
+  SImgResampleJob<uint> job;
+  job.m_pOut = uout;
+  job.m_pIn = uin;
+  job.m_nOX = ox;
+  job.m_nOY = oy;
+  job.m_nIX = ix;
+  job.m_nIY = iy;
+  sTexPrepFor(oy, ox, sImgResampleRows<uint>, &job);
 }
 
 void CTexMan::ImgResample8(byte *uout, int ox, int oy, byte *uin, int ix, int iy)
 {
-  int   i, j;
-  byte  *inrow;
-  uint  ifrac, fracstep;
-
-  fracstep = ix*0x10000/ox;
-  if (!(ox & 3))
-  {
-    for (i=0 ; i<oy ; i++, uout += ox)
-    {
-      inrow = uin + ix*(i*iy/oy);
-      ifrac = fracstep >> 1;
-      for (j=0 ; j<ox ; j+=4)
-      {
-        uout[j] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+1] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+2] = inrow[ifrac>>16];
-        ifrac += fracstep;
-        uout[j+3] = inrow[ifrac>>16];
-        ifrac += fracstep;
-      }
-    }
-  }
-  else
-  {
-    for (i=0 ; i<oy ; i++, uout += ox)
-    {
-      inrow = uin + ix*(i*iy/oy);
-      ifrac = fracstep >> 1;
-      for (j=0 ; j<ox ; j++)
-      {
-        uout[j] = inrow[ifrac>>16];
-        ifrac += fracstep;
-      }
-    }
-  }
+  SImgResampleJob<byte> job;
+  job.m_pOut = uout;
+  job.m_pIn = uin;
+  job.m_nOX = ox;
+  job.m_nOY = oy;
+  job.m_nIX = ix;
+  job.m_nIY = iy;
+  sTexPrepFor(oy, ox, sImgResampleRows<byte>, &job);
 }
 
 //============================================================================
 
+// nvDXTlib callbacks, the library is still used by CRenderer::DXTCompress
 byte *sData;
 static TArray<byte> sAData;
 void WriteDTXnFile (DWORD count, void *buffer, void * userData)
@@ -2679,265 +3132,364 @@ void ReadDTXnFile (DWORD count, void *buffer, void * userData)
 
 bool CTexMan::m_bRGBA = true;
 
+static EDXTFormat sDXTFormat(int nFlags)
+{
+  if (nFlags & FT_DXT1)
+    return eDXTF_DXT1;
+  if (nFlags & FT_DXT3)
+    return eDXTF_DXT3;
+  return eDXTF_DXT5;
+}
+
+// r_TexDXTQuality selects the preset, r_TexPreprocessMT the SIMD kernels and the jobs
+static void sDXTOptions(SDXTCompressOptions& Opt, EDXTFormat eFormat, bool bBGRA)
+{
+  Opt.m_eFormat = eFormat;
+  Opt.m_eQuality = (EDXTQuality)CLAMP(CRenderer::CV_r_texdxtquality, eDXTQ_Fast, eDXTQ_High);
+  Opt.m_bBGRA = bBGRA;
+  Opt.m_bSSE = sTexPrepSSE();
+  Opt.m_pJobManager = (CRenderer::CV_r_texpreprocessmt >= 2 && iSystem) ? iSystem->GetIJobManager() : NULL;
+}
+
 byte *CTexMan::ImgConvertDXT_RGBA(byte *dst, STexPic *ti, int DXTSize)
 {
-  int width;
-  int height;
-  int planes;
-  int lTotalWidth; 
-  int rowBytes;
-  DDS_HEADER *ddsh;
-
-  byte *dd = new byte [DXTSize + sizeof(DDS_HEADER) + sizeof(DWORD)];
-
-  DWORD dwMagic = MAKEFOURCC('D','D','S',' ');
-  *(DWORD *)dd = dwMagic;
-  ddsh = (DDS_HEADER *)&dd[sizeof(DWORD)];
-  memset(ddsh, 0, sizeof(DDS_HEADER));
-  cryMemcpy(&dd[sizeof(DWORD)+sizeof(DDS_HEADER)], dst, DXTSize);
-
-  ddsh->dwSize = sizeof(DDS_HEADER);
-  ddsh->dwWidth = ti->m_Width;
-  ddsh->dwHeight = ti->m_Height;
-  ddsh->dwHeaderFlags = DDSD_CAPS | DDSD_PIXELFORMAT | DDSD_WIDTH | DDSD_HEIGHT | DDSD_LINEARSIZE;
-  int blockSize = (ti->m_Flags & FT_DXT1) ? 8 : 16;
-  ddsh->dwPitchOrLinearSize = ti->m_Width*ti->m_Height*4/blockSize;
-  if (ti->m_Flags & FT_DXT1)
-    ddsh->ddspf.dwFourCC = FOURCC_DXT1;
-  else
-  if (ti->m_Flags & FT_DXT3)
-    ddsh->ddspf.dwFourCC = FOURCC_DXT3;
-  else
-  if (ti->m_Flags & FT_DXT5)
-    ddsh->ddspf.dwFourCC = FOURCC_DXT5;
-  ddsh->ddspf.dwSize = sizeof(ddsh->ddspf);
-  ddsh->ddspf.dwFlags = DDS_FOURCC;
-  ddsh->dwSurfaceFlags = DDS_SURFACE_FLAGS_TEXTURE;
+  byte *dd = new byte [ti->m_Width*ti->m_Height*4];
+  DXTDecompress(dst, ti->m_Width, ti->m_Height, sDXTFormat(ti->m_Flags), dd, !m_bRGBA);
+  return dd;
+}
 
-  sData = dd;
-      
-#if defined(WIN64) || defined(LINUX)
-	// NOTE: AMD64 port: implement
-	dd = new byte [ti->m_Width*ti->m_Height*4];
-#else
-  int src_format;
-  byte *_data = nvDXTdecompress(width, height, planes, lTotalWidth, rowBytes, src_format);
-  delete [] dd;
-  dd = new byte [ti->m_Width*ti->m_Height*4];
-  byte *dd1 = dd;
-  byte *data1 = _data;
-
-  if (planes == 3)
-  {
-    int n = width*height;
-    if (m_bRGBA)
-    for (int i=0; i<n; i++)
-    {
-      dd1[2] = data1[0];
-      dd1[1] = data1[1];
-      dd1[0] = data1[2];
-      dd1[3] = 255;
-      dd1   += 4;
-      data1 += 3;
-    }
-    else
-    for (int i=0; i<n; i++)
-    {
-      dd1[0] = data1[0];
-      dd1[1] = data1[1];
-      dd1[2] = data1[2];
-      dd1[3] = 255;
-      dd1   += 4;
-      data1 += 3;
-    }
-  }
-  else
+// 2x2 box filter for the generated DXT levels, sides of 1 texel stay 1
+static void sDXTMipMap(const byte *pSrc, int nWidth, int nHeight, byte *pDst)
+{
+  int nDstWidth = max(nWidth>>1, 1);
+  int nDstHeight = max(nHeight>>1, 1);
+  int nNextX = (nWidth > 1) ? 4 : 0;
+  int nNextY = (nHeight > 1) ? nWidth*4 : 0;
+  for (int y=0; y<nDstHeight; y++)
   {
-    int n = width*height;
-    if (m_bRGBA)
-    for (int i=0; i<n; i++)
-    {
-      dd1[2] = data1[0];
-      dd1[1] = data1[1];
-      dd1[0] = data1[2];
-      dd1[3] = data1[3];
-      dd1   += 4;
-      data1 += 4;
-    }
-    else
-    for (int i=0; i<n; i++)
+    const byte *src = &pSrc[(nNextY ? y*2 : 0)*nWidth*4];
+    for (int x=0; x<nDstWidth; x++)
     {
-      dd1[0] = data1[0];
-      dd1[1] = data1[1];
-      dd1[2] = data1[2];
-      dd1[3] = data1[3];
-      dd1   += 4;
-      data1 += 4;
+      for (int c=0; c<4; c++)
+        pDst[c] = (src[c] + src[c+nNextX] + src[c+nNextY] + src[c+nNextX+nNextY]) >> 2;
+      pDst += 4;
+      src += nNextX*2;
     }
   }
-
-  CRTDeleteArray(_data);
-#endif
-  return dd;
 }
   
 byte *CTexMan::ImgConvertRGBA_DXT(byte *dst, STexPic *ti, int& DXTSize, int& nMips, int bits, bool bUseExistingMips)
 {
-#if !defined(PS2) && !defined(WIN64) && !defined(LINUX)
-	// NOTE: AMD64 port: implement
-
   assert (bits == 24 || bits == 32);
 
-  CompressionOptions opt;
-  int i, j;
-  if (ti->m_Flags & FT_DXT1)
-    opt.TextureFormat = kDXT1;
-  else
-  if (ti->m_Flags & FT_DXT3)
-    opt.TextureFormat = kDXT3;
-  else
-  if (ti->m_Flags & FT_DXT5)
-    opt.TextureFormat = kDXT5;
+  int i;
+  SDXTCompressOptions Opt;
+  sDXTOptions(Opt, sDXTFormat(ti->m_Flags), !m_bRGBA);
 
   int width = ti->m_Width;
   int height = ti->m_Height;
-  byte *d;
+  int w, h;
+  if (!bUseExistingMips)
+  {
+    nMips = 0;
+    for (w=width, h=height; w || h; w>>=1, h>>=1)
+      nMips++;
+  }
+  DXTSize = 0;
+  for (i=0, w=width, h=height; i<nMips; i++, w>>=1, h>>=1)
+    DXTSize += DXTCompressedSize(max(w, 1), max(h, 1), Opt.m_eFormat);
+  byte *d = new byte[DXTSize];
 
-  if (bUseExistingMips)
+  // generated levels are filtered in 32 bit, ping-ponging between two buffers
+  byte *pLevel = dst;
+  int nBpp = bits/8;
+  byte *pBuf[2];
+  pBuf[0] = pBuf[1] = NULL;
+  if (!bUseExistingMips && nMips > 1)
   {
-    int w = width;
-    int h = height;
-    TArray<byte> Data;
-    for (i=0; i<nMips; i++)
+    pBuf[0] = new byte[width*height*4];
+    pBuf[1] = new byte[max(width>>1, 1)*max(height>>1, 1)*4];
+    if (nBpp == 3)
     {
-      if (!w)
-        w = 1;
-      if (!h)
-        h = 1;
-      sAData.Free();
-      if (m_bRGBA)
+      for (i=0; i<width*height; i++)
       {
-        if (bits == 24)
-        {
-          for (j=0; j<w*h; j++)
-          {
-            Exchange(dst[j*3+0], dst[j*3+2]);
-          }
-        }
-        else
-        {
-          for (j=0; j<w*h; j++)
-          {
-            Exchange(dst[j*4+0], dst[j*4+2]);
-          }
-        }
+        pBuf[0][i*4+0] = dst[i*3+0];
+        pBuf[0][i*4+1] = dst[i*3+1];
+        pBuf[0][i*4+2] = dst[i*3+2];
+        pBuf[0][i*4+3] = 255;
       }
-      opt.MipMapType = dNoMipMaps;
-      nvDXTcompress(dst, w, h, w, &opt, bits/8, NULL);
-      if (bits == 24)
-        dst += w*h*3;
-      else
-        dst += w*h*4;
-      int Offs = sizeof(DWORD)+sizeof(DDS_HEADER);
-      int n = Data.Num();
-      int Size = sAData.Num()-Offs;
-      int blockSize = (ti->m_Flags & FT_DXT1) ? 8 : 16;
-      int mipsize = ((w+3)/4)*((h+3)/4)*blockSize;
-      assert(mipsize == Size);
-      Data.Grow(Size);
-      cryMemcpy(&Data[n], &sAData[Offs], Size);
-      w >>= 1;
-      h >>= 1;
-    }
-    d = new byte[Data.Num()];
-    cryMemcpy(d, &Data[0], Data.Num());
-    DXTSize = Data.Num();
-  }
-  else
-  {
-    sAData.Free();
-    opt.MipMapType = dGenerateMipMaps;
-    nvDXTcompress(dst, width, height, width, &opt, bits/8, NULL);
-
-    int Offs = sizeof(DWORD)+sizeof(DDS_HEADER);
-    d = new byte[sAData.Num()-Offs];
-    cryMemcpy(d, &sAData[Offs], sAData.Num()-Offs);
-    DXTSize = sAData.Num()-Offs;
-    sAData.Free();
+      pLevel = pBuf[0];
+      nBpp = 4;
+    }
   }
 
-  if (!bUseExistingMips)
+  int nOffs = 0;
+  w = width;
+  h = height;
+  for (i=0; i<nMips; i++)
   {
-    nMips = 0;
-    while (width || height)
+    if (!w)
+      w = 1;
+    if (!h)
+      h = 1;
+    DXTCompress(pLevel, w, h, w*nBpp, nBpp, &d[nOffs], Opt);
+    nOffs += DXTCompressedSize(w, h, Opt.m_eFormat);
+    if (bUseExistingMips)
+      pLevel += w*h*nBpp;
+    else
+    if (i+1 < nMips)
     {
-      if (!width)
-        width = 1;
-      if (!height)
-        height = 1;
-      nMips++;
-
-      width >>= 1;
-      height >>= 1;
+      byte *pNext = (pLevel == pBuf[1]) ? pBuf[0] : pBuf[1];
+      if (w > 1 && h > 1)
+        MipMap32Bit(ti, pLevel, pNext, w>>1, h>>1);
+      else
+        sDXTMipMap(pLevel, w, h, pNext);
+      pLevel = pNext;
     }
+    w >>= 1;
+    h >>= 1;
   }
+  assert(nOffs == DXTSize);
+  SAFE_DELETE_ARRAY(pBuf[0]);
+  SAFE_DELETE_ARRAY(pBuf[1]);
 
   return d;
-
-#else
-  return NULL;
-#endif
 }
 
 
 void CTexMan::MipMap8Bit (STexPic *ti, byte *in, byte *out, int width, int height)
 {
-  int    i, j;
-  uint r,g,b;
-  byte  *at1, *at2, *at3, *at4;
+  SMipMap8Job job;
+  job.m_pIn = in;
+  job.m_pOut = out;
+  job.m_nWidth = width;
+  job.m_pSrcTable = ti->m_p8to24table;
+  job.m_pDstTable = ti->m_p15to8table;
+  sTexPrepFor(height>>1, (width+1)>>1, sMipMap8Rows, &job);
+}
 
-  height >>= 1;
-  uint *tabsrc = ti->m_p8to24table;
-  byte *tabdst = ti->m_p15to8table;
-  for (i=0; i<height; i++,in+=width)
-  {
-    for (j=0; j<width; j+=2,out+=1,in+=2)
-    {
-      at1 = (byte *) (tabsrc + in[0]);
-      at2 = (byte *) (tabsrc + in[1]);
-      at3 = (byte *) (tabsrc + in[width+0]);
-      at4 = (byte *) (tabsrc + in[width+1]);
+void CTexMan::MipMap32Bit (STexPic *ti, byte *in, byte *out, int width, int height)
+{
+  SMipMap32Job job;
+  job.m_pIn = in;
+  job.m_pOut = out;
+  job.m_nWidth = width;
+  job.m_bSSE = sTexPrepSSE();
+  sTexPrepFor(height, width, sMipMap32Rows, &job);
+}
 
-      r = (at1[0]+at2[0]+at3[0]+at4[0]); r>>=5;
-      g = (at1[1]+at2[1]+at3[1]+at4[1]); g>>=5;
-      b = (at1[2]+at2[2]+at3[2]+at4[2]); b>>=5;
+//===============================================================================
 
-      out[0] = tabdst[(r<<0) + (g<<5) + (b<<10)];
+// Runs the preprocessing of all loaded textures again with each r_TexPreprocessMT mode
+// and logs the times, the results are compared with the scalar path.
+// The images are loaded from disk outside of the timed part.
+void CTexMan::PreprocessBench()
+{
+  int nSaveMode = CRenderer::CV_r_texpreprocessmt;
+  float fTime[3];
+  fTime[0] = fTime[1] = fTime[2] = 0;
+  float fMPixels = 0;
+  int nTextures = 0;
+  int nDiffer = 0;
+
+  for (int i=0; i<m_Textures.Num(); i++)
+  {
+    STexPic *tp = m_Textures[i];
+    if (!tp || !tp->m_bBusy || !(tp->m_Flags2 & FT2_WASLOADED) || (tp->m_Flags & FT_DYNAMIC))
+      continue;
+    char name[2][256];
+    name[0][0] = name[1][0] = 0;
+    int nNames = tp->GetFileNames(name[0], name[1], 255);
+    if (!name[0][0])
+      continue;
+    byte eTT = tp->m_eTT;
+    bool bBump = (eTT == eTT_Bumpmap || eTT == eTT_DSDTBump);
+    byte *pRef = NULL;
+    int nRefSize = 0;
+    int nMode;
+    for (nMode=0; nMode<3; nMode++)
+    {
+      CImageFile *im[2];
+      im[0] = CImageFile::mfLoad_file(name[0]);
+      im[1] = (nNames == 2) ? CImageFile::mfLoad_file(name[1]) : NULL;
+      if (!im[0] || im[0]->mfGet_error() != eIFE_OK || (nNames == 2 && (!im[1] || im[1]->mfGet_error() != eIFE_OK)))
+      {
+        delete im[0];
+        delete im[1];
+        break;
+      }
+      CRenderer::CV_r_texpreprocessmt = nMode;
+      STexPic *ti = new STexPic;
+      ti->m_eTT = (ETexType)eTT;
+
+      float fStart = iTimer->GetAsyncCurTime();
+      if (bBump)
+        GenerateNormalMap(im, tp->m_Flags & ~FT_NOMIPS, tp->m_Flags2, eTT, tp->m_fAmount1, tp->m_fAmount2, ti);
+      ImagePreprocessing(im[0], tp->m_Flags, tp->m_Flags2, eTT, ti);
+      fTime[nMode] += iTimer->GetAsyncCurTime() - fStart;
+
+      byte *pData = im[0]->mfGet_image();
+      int nSize = im[0]->mfGet_ImageSize();
+      if (!nMode)
+      {
+        nRefSize = nSize;
+        pRef = new byte[nSize];
+        if (pData)
+          cryMemcpy(pRef, pData, nSize);
+        fMPixels += (float)im[0]->mfGet_width() * im[0]->mfGet_height() / 1000000.0f;
+        nTextures++;
+      }
+      else
+      if (nSize != nRefSize || (pData && memcmp(pRef, pData, nSize)))
+      {
+        nDiffer++;
+        if (CRenderer::CV_r_texpreprocessinfo > 2)
+          iLog->Log("  %s: r_TexPreprocessMT %d differs from the scalar path", tp->m_SourceName.c_str(), nMode);
+      }
+      delete im[0];
+      delete im[1];
+      delete ti;
     }
+    SAFE_DELETE_ARRAY(pRef);
   }
+  CRenderer::CV_r_texpreprocessmt = nSaveMode;
+
+  IJobManager *pJobManager = iSystem->GetIJobManager();
+  iLog->Log("r_TexPreprocessInfo: reprocessed %d textures (%.1f Mpix)", nTextures, fMPixels);
+  iLog->Log("  scalar %.1f ms, SIMD %.1f ms, SIMD+jobs %.1f ms (%d workers), %.1f ms saved",
+    fTime[0]*1000.0f, fTime[1]*1000.0f, fTime[2]*1000.0f, pJobManager ? pJobManager->GetWorkerCount() : 0, (fTime[0]-fTime[2])*1000.0f);
+  if (nDiffer)
+    iLog->Log("  %d results differ from the scalar path (float rounding)", nDiffer);
 }
 
-void CTexMan::MipMap32Bit (STexPic *ti, byte *in, byte *out, int width, int height)
+// Compresses the sources of up to nTextures loaded textures with each format and preset,
+// with each r_TexPreprocessMT mode, and logs the megapixels per second and the RMS error.
+// DXT sources are decoded first, loading and decoding are not timed.
+void CTexMan::DXTBench(int nTextures)
 {
-  int    i, j;
+  static const char *sFormats[] = { "DXT1", "DXT1a", "DXT3", "DXT5", "3Dc" };
+  static const char *sQualities[] = { "fast", "normal", "high" };
+  TArray<byte *> Images;
+  TArray<byte *> Outputs;
+  TArray<int> Sizes;
+  float fMPixels = 0;
+  int i, j;
 
-  byte *src1 = in;
-  byte *dst1 = out;
-  int wd = width<<3;
-  for (i=0; i<height; i++,in+=width)
+  for (i=0; i<m_Textures.Num() && Images.Num()<nTextures; i++)
   {
-    byte *src2 = src1;
-    for (j=0; j<width; j++)
+    STexPic *tp = m_Textures[i];
+    if (!tp || !tp->m_bBusy || !(tp->m_Flags2 & FT2_WASLOADED) || (tp->m_Flags & FT_DYNAMIC))
+      continue;
+    char name[2][256];
+    name[0][0] = name[1][0] = 0;
+    tp->GetFileNames(name[0], name[1], 255);
+    if (!name[0][0])
+      continue;
+    CImageFile *im = CImageFile::mfLoad_file(name[0]);
+    if (!im || im->mfGet_error() != eIFE_OK || !im->mfGet_image())
     {
-      dst1[0] = (src2[0]+src2[4]+src2[wd+0]+src2[wd+4])>>2;
-      dst1[1] = (src2[1]+src2[5]+src2[wd+1]+src2[wd+5])>>2;
-      dst1[2] = (src2[2]+src2[6]+src2[wd+2]+src2[wd+6])>>2;
-      dst1[3] = (src2[3]+src2[7]+src2[wd+3]+src2[wd+7])>>2;
-      dst1 += 4;
-      src2 += 8;
+      delete im;
+      continue;
+    }
+    int wdt = im->mfGet_width();
+    int hgt = im->mfGet_height();
+    EImFormat eF = im->mfGetFormat();
+    byte *pData = NULL;
+    if (eF == eIF_DXT1 || eF == eIF_DXT3 || eF == eIF_DXT5)
+    {
+      pData = new byte[wdt*hgt*4];
+      DXTDecompress(im->mfGet_image(), wdt, hgt, (eF == eIF_DXT1) ? eDXTF_DXT1 : (eF == eIF_DXT3 ? eDXTF_DXT3 : eDXTF_DXT5), pData, false);
     }
-    src1 += wd<<1;
+    else
+    if (im->mfGet_ImageSize() == wdt*hgt*4)
+    {
+      pData = new byte[wdt*hgt*4];
+      cryMemcpy(pData, im->mfGet_image(), wdt*hgt*4);
+    }
+    delete im;
+    if (!pData)
+      continue;
+    Images.AddElem(pData);
+    Outputs.AddElem(new byte[DXTCompressedSize(wdt, hgt, eDXTF_DXT5)]);
+    Sizes.AddElem(wdt);
+    Sizes.AddElem(hgt);
+    fMPixels += (float)wdt * hgt / 1000000.0f;
   }
+  if (!Images.Num())
+    return;
+
+  int nSaveMode = CRenderer::CV_r_texpreprocessmt;
+  IJobManager *pJobManager = iSystem->GetIJobManager();
+  iLog->Log("r_TexDXTBench: %d textures (%.1f Mpix), %d workers", Images.Num(), fMPixels, pJobManager ? pJobManager->GetWorkerCount() : 0);
+  for (int nFormat=eDXTF_DXT1; nFormat<=eDXTF_3DC; nFormat++)
+  {
+    for (int nQuality=eDXTQ_Fast; nQuality<=eDXTQ_High; nQuality++)
+    {
+      float fMPS[3];
+      for (int nMode=0; nMode<3; nMode++)
+      {
+        CRenderer::CV_r_texpreprocessmt = nMode;
+        SDXTCompressOptions Opt;
+        sDXTOptions(Opt, (EDXTFormat)nFormat, false);
+        Opt.m_eQuality = (EDXTQuality)nQuality;
+        float fStart = iTimer->GetAsyncCurTime();
+        for (j=0; j<Images.Num(); j++)
+          DXTCompress(Images[j], Sizes[j*2], Sizes[j*2+1], Sizes[j*2]*4, 4, Outputs[j], Opt);
+        float fTime = iTimer->GetAsyncCurTime() - fStart;
+        fMPS[nMode] = fTime > 0 ? fMPixels / fTime : 0;
+      }
+
+      // error of the last run, only the channels the format stores
+      int nChannels = (nFormat == eDXTF_DXT1) ? 3 : ((nFormat == eDXTF_3DC) ? 2 : 4);
+      double fErr = 0;
+      double fValues = 0;
+      for (j=0; j<Images.Num(); j++)
+      {
+        int nTexels = Sizes[j*2] * Sizes[j*2+1];
+        byte *pDecoded = new byte[nTexels*4];
+        DXTDecompress(Outputs[j], Sizes[j*2], Sizes[j*2+1], (EDXTFormat)nFormat, pDecoded, false);
+        for (i=0; i<nTexels*4; i++)
+        {
+          if ((i&3) >= nChannels)
+            continue;
+          int nDiff = (int)pDecoded[i] - (int)Images[j][i];
+          fErr += nDiff*nDiff;
+        }
+        fValues += (double)nTexels * nChannels;
+        delete [] pDecoded;
+      }
+      iLog->Log("  %s %s: scalar %.1f, SIMD %.1f, SIMD+jobs %.1f Mpix/s, RMS error %.2f",
+        sFormats[nFormat], sQualities[nQuality], fMPS[0], fMPS[1], fMPS[2], sqrt(fErr / fValues));
+    }
+  }
+  CRenderer::CV_r_texpreprocessmt = nSaveMode;
+
+  for (j=0; j<Images.Num(); j++)
+  {
+    delete [] Images[j];
+    delete [] Outputs[j];
+  }
+}
+
+void CTexMan::UpdatePreprocessInfo()
+{
+  if (CRenderer::CV_r_texdxtbench)
+  {
+    DXTBench(CRenderer::CV_r_texdxtbench);
+    CRenderer::CV_r_texdxtbench = 0;
+  }
+  if (!CRenderer::CV_r_texpreprocessinfo)
+    return;
+
+  iLog->Log("r_TexPreprocessInfo: %d textures (%.1f Mpix) preprocessed in %.1f ms while loading (r_TexPreprocessMT %d)",
+    m_nPreprocessTextures, m_fPreprocessMPixels, m_fPreprocessTime*1000.0f, CRenderer::CV_r_texpreprocessmt);
+  m_fPreprocessTime = 0;
+  m_fPreprocessMPixels = 0;
+  m_nPreprocessTextures = 0;
+
+  if (CRenderer::CV_r_texpreprocessinfo >= 2)
+    PreprocessBench();
+  CRenderer::CV_r_texpreprocessinfo = 0;
 }
 
 void CTexMan::ClearAll(int nFlags)
@@ -821,6 +821,9 @@ protected:
   void GenerateNormalMap(CImageFile** im, uint flags, uint flags2, byte eTT, float fAmount1, float fAmount2, STexPic *ti);
   byte *GenerateNormalMap(byte *src, int width, int height, uint flags, uint flags2, byte eTT, float fAmount, STexPic *ti, int& nMips, int& nSize, ETEX_Format eTF);
   void MergeNormalMaps(byte *src[2], CImageFile *im[2], int nMips[2]);
+  static void GenerateNormalMapJob(void *pData);
+  void PreprocessBench();
+  void DXTBench(int nTextures);
 
   STexPic *TextureInfoForName(const char *nameTex, int numT, byte eTT, uint flags, uint flags2, int bind);
   STexPic *LoadFromImage (const char *name, uint flags, uint flags2, byte eTT, int bind, STexPic *ti, float fAmount1=-1.0f, float fAmount2=-1.0f);
@@ -876,6 +879,7 @@ public:
   virtual void StartCubeSide(CCObject *obj)=0;
   virtual void Update()=0;
   virtual void SetGridTexture(STexPic *tp);
+  void UpdatePreprocessInfo();
 
   void UnloadOldTextures(STexPic *pExclude);
   bool CreateCacheFile();
@@ -945,6 +949,9 @@ public:
   CResFile *m_TexCache;
   int m_LoadBytes;
   int m_UpLoadBytes;
+  float m_fPreprocessTime;       // seconds spent in GenerateNormalMap/ImagePreprocessing while loading
+  float m_fPreprocessMPixels;
+  int m_nPreprocessTextures;
   int m_Streamed;
   float m_fStreamDistFactor;
 
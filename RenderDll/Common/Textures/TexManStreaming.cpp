@@ -1005,6 +1005,7 @@ void STexPic::LoadFromCache(int Flags, float fDist)
         StrParams.nLoadTime = 1;
         StrParams.nMaxLoadTime = 4;
         StrParams.nPriority = 0;
+        StrParams.nPriorityClass = SRPC_HIGH;
         StrParams.pBuffer = pTexCacheFileInfo->m_pTempBufferToStream;
         StrParams.nSize = SizeToLoad;
         if (m_CacheID >= 0)
@@ -15,6 +15,7 @@
 static char THIS_FILE[] = __FILE__;
 
 TArray<CVProgram *> CVProgram::m_VPrograms;
+ShaderNameIndex CVProgram::m_VProgramsIndex;
 
 //=======================================================================
 
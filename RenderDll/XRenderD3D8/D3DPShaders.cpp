@@ -22,6 +22,7 @@ static char THIS_FILE[] = __FILE__;
 #endif
 
 TArray<CPShader *> CPShader::m_PShaders;
+ShaderNameIndex CPShader::m_PShadersIndex;
 CPShader *CPShader::m_CurRC;
 
 //=======================================================================
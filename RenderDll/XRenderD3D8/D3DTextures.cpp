@@ -3603,6 +3603,7 @@ void CD3D8TexMan::Update()
   char buf[256]="";
 
   CheckTexLimits();
+  UpdatePreprocessInfo();
 
   if (CRenderer::CV_r_logusedtextures == 1 || CRenderer::CV_r_logusedtextures == 3 || CRenderer::CV_r_logusedtextures == 4)
   {
@@ -32,6 +32,7 @@ static char THIS_FILE[] = __FILE__;
 vec4_t CCGPShader_D3D::m_CurParams[32];
 
 TArray<CPShader *> CPShader::m_PShaders;
+ShaderNameIndex CPShader::m_PShadersIndex;
 CPShader *CPShader::m_CurRC;
 
 CPShader *CPShader::mfForName(const char *name, std::vector<SFXStruct>& Structs, std::vector<SPair>& Macros, char *entryFunc, EShaderVersion eSHV, uint64 nMaskGen)
@@ -44,16 +45,13 @@ CPShader *CPShader::mfForName(const char *name, std::vector<SFXStruct>& Structs,
   if (!(gRenDev->GetFeatures() & (RFT_HW_TS)))
     return NULL;
 
-  for (i=0; i<m_PShaders.Num(); i++)
+  CPShader *pFound = sFindInNameIndex(m_PShadersIndex, m_PShaders, name, nMaskGen);
+  if (pFound)
   {
-    if (!m_PShaders[i])
-      continue;
-    if (!stricmp(name, m_PShaders[i]->m_Name.c_str()) && m_PShaders[i]->m_nMaskGen == nMaskGen)
-    {
-      m_PShaders[i]->m_nRefCounter++;
-      return m_PShaders[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_PShaders.Num();
 
   CPShader *p = NULL;
   {
@@ -61,6 +59,7 @@ CPShader *CPShader::mfForName(const char *name, std::vector<SFXStruct>& Structs,
     pr->m_Name = name;
     pr->m_Id = i;
     m_PShaders.AddElem(pr);
+    sAddToNameIndex(m_PShadersIndex, name, i);
     pr->m_nRefCounter = 1;
     pr->m_nMaskGen = nMaskGen;
     p = pr;
@@ -385,16 +384,13 @@ CPShader *CPShader::mfForName(const char *name, uint64 nMaskGen)
   if (!(gRenDev->GetFeatures() & (RFT_HW_RC | RFT_HW_TS | RFT_HW_PS20)))
     return NULL;
 
-  for (i=0; i<m_PShaders.Num(); i++)
+  CPShader *pFound = sFindInNameIndex(m_PShadersIndex, m_PShaders, name, nMaskGen);
+  if (pFound)
   {
-    if (!m_PShaders[i])
-      continue;
-    if (!stricmp(name, m_PShaders[i]->m_Name.c_str()) && m_PShaders[i]->m_nMaskGen == nMaskGen)
-    {
-      m_PShaders[i]->m_nRefCounter++;
-      return m_PShaders[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_PShaders.Num();
   char scrname[128];
   char dir[128];
   sprintf(dir, "%sDeclarations/CGPShaders/", gRenDev->m_cEF.m_HWPath);
@@ -422,6 +418,7 @@ CPShader *CPShader::mfForName(const char *name, uint64 nMaskGen)
   pr->m_Name = name;
   pr->m_Id = i;
   m_PShaders.AddElem(pr);
+  sAddToNameIndex(m_PShadersIndex, name, i);
   pr->m_nRefCounter = 1;
   pr->m_nMaskGen = nMaskGen;
 
@@ -450,6 +447,7 @@ void CPShader::mfClearAll(void)
       delete vp;
   }
   m_PShaders.Free();
+  m_PShadersIndex.clear();
 }
 
 _inline bool sIncrTypes(int *Types, int nInd, bool bSpec)
@@ -692,6 +690,7 @@ CCGPShader_D3D::~CCGPShader_D3D()
 {
   mfFree();
   CPShader::m_PShaders[m_Id] = NULL;
+  sRemoveFromNameIndex(CPShader::m_PShadersIndex, m_Name.c_str(), m_Id);
 }
 
 void CCGPShader_D3D::Release()
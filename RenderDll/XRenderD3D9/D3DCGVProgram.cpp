@@ -22,6 +22,7 @@
 static char THIS_FILE[] = __FILE__;
 
 TArray<CVProgram *> CVProgram::m_VPrograms;
+ShaderNameIndex CVProgram::m_VProgramsIndex;
 vec4_t CCGVProgram_D3D::m_CurParams[256];
 int CCGVProgram_D3D::m_nResetDeviceFrame = -1;
 
@@ -38,16 +39,13 @@ CVProgram *CVProgram::mfForName(const char *name, std::vector<SFXStruct>& Struct
   if (!(gRenDev->GetFeatures() & (RFT_HW_VS)))
     return NULL;
 
-  for (i=0; i<m_VPrograms.Num(); i++)
+  CVProgram *pFound = sFindInNameIndex(m_VProgramsIndex, m_VPrograms, name, nMaskGen);
+  if (pFound)
   {
-    if (!m_VPrograms[i])
-      continue;
-    if (!stricmp(name, m_VPrograms[i]->m_Name.c_str()) && m_VPrograms[i]->m_nMaskGen == nMaskGen)
-    {
-      m_VPrograms[i]->m_nRefCounter++;
-      return m_VPrograms[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_VPrograms.Num();
 
   CVProgram *p = NULL;
   {
@@ -55,6 +53,7 @@ CVProgram *CVProgram::mfForName(const char *name, std::vector<SFXStruct>& Struct
     pr->m_Name = name;
     pr->m_Id = i;
     m_VPrograms.AddElem(pr);
+    sAddToNameIndex(m_VProgramsIndex, name, i);
     pr->m_nRefCounter = 1;
     pr->m_nMaskGen = nMaskGen;
     p = pr;
@@ -500,16 +499,13 @@ CVProgram *CVProgram::mfForName(const char *name, uint64 nMaskGen)
   if (!(gRenDev->GetFeatures() & (RFT_HW_VS)))
     return NULL;
 
-  for (i=0; i<m_VPrograms.Num(); i++)
+  CVProgram *pFound = sFindInNameIndex(m_VProgramsIndex, m_VPrograms, name, nMaskGen);
+  if (pFound)
   {
-    if (!m_VPrograms[i])
-      continue;
-    if (!stricmp(name, m_VPrograms[i]->m_Name.c_str()) && m_VPrograms[i]->m_nMaskGen == nMaskGen)
-    {
-      m_VPrograms[i]->m_nRefCounter++;
-      return m_VPrograms[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_VPrograms.Num();
 
   char scrname[128];
   char dir[128];
@@ -536,6 +532,7 @@ CVProgram *CVProgram::mfForName(const char *name, uint64 nMaskGen)
     pr->m_Name = name;
     pr->m_Id = i;
     m_VPrograms.AddElem(pr);
+    sAddToNameIndex(m_VProgramsIndex, name, i);
     pr->m_nRefCounter = 1;
     pr->m_nMaskGen = nMaskGen;
     p = pr;
@@ -623,6 +620,7 @@ CCGVProgram_D3D::~CCGVProgram_D3D()
 {
   mfFree();
   CVProgram::m_VPrograms[m_Id] = NULL;
+  sRemoveFromNameIndex(CVProgram::m_VProgramsIndex, m_Name.c_str(), m_Id);
 }
 
 void CCGVProgram_D3D::Release()
@@ -4396,6 +4396,7 @@ void CD3D9TexMan::Update()
   char buf[256]="";
 
   CheckTexLimits(NULL);
+  UpdatePreprocessInfo();
 
   bool bChangedNormalMapCompressed = false;
 #ifdef USE_3DC
@@ -355,7 +355,7 @@ public:
   virtual void EndRefractMap() {};
   virtual void StartNightMap(int Id) {}
   virtual void EndNightMap() {}
-  virtual void Update() {}
+  virtual void Update() { UpdatePreprocessInfo(); }
   virtual void GenerateFuncTextures() {}
 
   virtual void DrawFlashBangMap(int Id, int RendFlags, CREFlashBang *pRE) {}
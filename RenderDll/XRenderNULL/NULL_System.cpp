@@ -139,6 +139,7 @@ DLL_EXPORT IRenderer* PackageRenderConstructor(int argc, char* argv[], SCryRende
   iTimer    = sp->ipTimer;
   iSystem   = sp->ipSystem;
 //  cVars     = sp->ipVars;
+  g_CpuFlags = iSystem->GetCPUFlags();
   pTest_int = sp->ipTest_int;
 	pIPhysicalWorld = sp->pIPhysicalWorld;
 //  pCharMan = sp->ipCharMan;
@@ -16,6 +16,7 @@
 static char THIS_FILE[] = __FILE__;
 
 TArray<CPShader *> CPShader::m_PShaders;
+ShaderNameIndex CPShader::m_PShadersIndex;
 CPShader *CPShader::m_CurRC;
 
 #include "nvparse/nvparse.h"
@@ -52,16 +53,13 @@ CPShader *CPShader::mfForName(const char *name, uint64 nMask)
   if (!(gRenDev->GetFeatures() & (RFT_HW_RC | RFT_HW_TS | RFT_HW_PS20)))
     return NULL;
 
-  for (i=0; i<m_PShaders.Num(); i++)
+  CPShader *pFound = sFindInNameIndex(m_PShadersIndex, m_PShaders, name, nMask);
+  if (pFound)
   {
-    if (!m_PShaders[i])
-      continue;
-    if (!stricmp(name, m_PShaders[i]->m_Name.c_str()) && m_PShaders[i]->m_nMaskGen == nMask)
-    {
-      m_PShaders[i]->m_nRefCounter++;
-      return m_PShaders[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_PShaders.Num();
   char scrname[128];
   char dir[128];
   sprintf(dir, "%sDeclarations/CGPShaders/", gRenDev->m_cEF.m_HWPath);
@@ -88,6 +86,7 @@ CPShader *CPShader::mfForName(const char *name, uint64 nMask)
   pr->m_Name = name;
   pr->m_Id = i;
   m_PShaders.AddElem(pr);
+  sAddToNameIndex(m_PShadersIndex, name, i);
   pr->m_nRefCounter = 1;
   pr->m_nMaskGen = nMask;
   p = pr;
@@ -117,6 +116,7 @@ void CPShader::mfClearAll(void)
       delete vp;
   }
   m_PShaders.Free();
+  m_PShadersIndex.clear();
 }
 
 
@@ -175,6 +175,7 @@ CCGPShader_GL::~CCGPShader_GL()
 {
   mfFree();
   CPShader::m_PShaders[m_Id] = NULL;
+  sRemoveFromNameIndex(CPShader::m_PShadersIndex, m_Name.c_str(), m_Id);
 }
 
 void CCGPShader_GL::Release()
@@ -20,6 +20,7 @@ static char THIS_FILE[] = __FILE__;
 #endif
 
 TArray<CVProgram *> CVProgram::m_VPrograms;
+ShaderNameIndex CVProgram::m_VProgramsIndex;
 
 vec4_t CCGVProgram_GL::m_CurParams[96];
 vec4_t CCGVProgram_GL::m_CurParamsARB[96];
@@ -45,16 +46,13 @@ CVProgram *CVProgram::mfForName(const char *name, uint64 nMask)
   if (!(gRenDev->GetFeatures() & (RFT_HW_VS)))
     return NULL;
 
-  for (i=0; i<m_VPrograms.Num(); i++)
+  CVProgram *pFound = sFindInNameIndex(m_VProgramsIndex, m_VPrograms, name, nMask);
+  if (pFound)
   {
-    if (!m_VPrograms[i])
-      continue;
-    if (!stricmp(name, m_VPrograms[i]->m_Name.c_str()) && m_VPrograms[i]->m_nMaskGen == nMask)
-    {
-      m_VPrograms[i]->m_nRefCounter++;
-      return m_VPrograms[i];
-    }
+    pFound->m_nRefCounter++;
+    return pFound;
   }
+  i = m_VPrograms.Num();
 
   char scrname[128];
   char dir[128];
@@ -88,6 +86,7 @@ CVProgram *CVProgram::mfForName(const char *name, uint64 nMask)
     pr->m_Name = name;
     pr->m_Id = i;
     m_VPrograms.AddElem(pr);
+    sAddToNameIndex(m_VProgramsIndex, name, i);
     pr->m_nRefCounter = 1;
     pr->m_nMaskGen = nMask;
     p = pr;
@@ -180,6 +179,7 @@ CCGVProgram_GL::~CCGVProgram_GL()
 {
   mfFree();
   CVProgram::m_VPrograms[m_Id] = NULL;
+  sRemoveFromNameIndex(CVProgram::m_VProgramsIndex, m_Name.c_str(), m_Id);
 }
 
 void CCGVProgram_GL::Release()
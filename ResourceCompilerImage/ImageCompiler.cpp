@@ -82,7 +82,8 @@ static SPixelFormats g_pixelformats[]=
 //	{ 16,"4p",		D3DFMT_DXT2,				"DXT2",				"A8R8G8B8",		"DXT2 compression texture format",true },
 		{ 16,"4",			D3DFMT_DXT3,				"DXT3",				"A8R8G8B8",		"DXT3 compression texture format",true },
 //	{ 16,"3of8p",	D3DFMT_DXT4,				"DXT4",				"A8R8G8B8",		"DXT4 compression texture format",true },
-		{ 16,"3of8",	D3DFMT_DXT5,				"DXT5",				"A8R8G8B8",		"DXT5 compression texture format",true }
+		{ 16,"3of8",	D3DFMT_DXT5,				"DXT5",				"A8R8G8B8",		"DXT5 compression texture format",true },
+		{ 8, "0",			D3DFMT_ATI2,				"3DC",				"A8R8G8B8",		"3Dc (ATI2N) normal map compression, x from red and y from green",true }
 };
 
 
@@ -637,7 +638,7 @@ HRESULT CImageCompiler::ChangeFormat( LPDIRECT3DBASETEXTURE9 ptexCur, D3DFORMAT
 		{
 			if ((fmtTo == D3DFMT_DXT1 || fmtTo == D3DFMT_DXT2 ||
 				fmtTo == D3DFMT_DXT3 || fmtTo == D3DFMT_DXT4 ||
-				fmtTo == D3DFMT_DXT5) && (m_dwOrigWidth % 4 != 0 || m_dwOrigHeight % 4 != 0))
+				fmtTo == D3DFMT_DXT5 || fmtTo == D3DFMT_ATI2) && (m_dwOrigWidth % 4 != 0 || m_dwOrigHeight % 4 != 0))
 			{
 				CCLOG->LogError("ERROR_NEEDMULTOF4 = for DXT compression we need width and height to be multiple of 4");
 				return E_FAIL;
@@ -0,0 +1,175 @@
+// ImageCompressor.cpp: DXT/3Dc compression of the image compiler levels
+// doesn't include stdafx.h (windows, ATL, D3D), it builds for the linux asset build as well
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <string.h>										// memcpy
+#include <IJobManager.h>							// IJobManager
+#include "ImageCompressor.h"
+
+
+// Runs the ParallelFor ranges of the DXT compressor on one thread per CPU.
+// The resource compiler has no engine job manager, single jobs run right away.
+class CImageJobManager : public IJobManager
+{
+public:
+	CImageJobManager()
+	{
+#if defined(WIN32)
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		m_nThreads = si.dwNumberOfProcessors > 1 ? (int)si.dwNumberOfProcessors : 1;
+#else
+		long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+		m_nThreads = nCPUs > 1 ? (int)nCPUs : 1;
+#endif
+		if(m_nThreads > MAX_THREADS) m_nThreads = MAX_THREADS;
+	}
+
+	virtual void AddJob(JobFunc pFunc, void* pData) { pFunc(pData); }
+	virtual void AddJob(JobFunc pFunc, void* pData, JobCounter* pCounter, JobCounter* pDependsOn) { pFunc(pData); }
+	virtual void WaitForAllJobs() {}
+	virtual void WaitForJobs(JobCounter* pCounter) {}
+	virtual int GetWorkerCount() { return m_nThreads-1; }
+
+	virtual void ParallelFor(int nCount, int nGranularity, ParallelForFunc pFunc, void* pData)
+	{
+		SRanges r;
+		r.nNext = 0;
+		r.nCount = nCount;
+		r.nGranularity = nGranularity > 0 ? nGranularity : 1;
+		r.pFunc = pFunc;
+		r.pData = pData;
+
+		int nThreads = (nCount + r.nGranularity - 1) / r.nGranularity;
+		if(nThreads > m_nThreads) nThreads = m_nThreads;
+
+		// the calling thread takes ranges as well
+		int nStarted = 0;
+#if defined(WIN32)
+		HANDLE hThreads[MAX_THREADS];
+		for(int i = 1; i<nThreads; i++)
+		{
+			hThreads[nStarted] = CreateThread(NULL, 0, ThreadEntry, &r, 0, NULL);
+			if(hThreads[nStarted]) nStarted++;
+		}
+		Run(&r);
+		if(nStarted)
+		{
+			WaitForMultipleObjects(nStarted, hThreads, TRUE, INFINITE);
+			for(int i = 0; i<nStarted; i++) CloseHandle(hThreads[i]);
+		}
+#else
+		pthread_t hThreads[MAX_THREADS];
+		pthread_mutex_init(&r.mutex, NULL);
+		for(int i = 1; i<nThreads; i++)
+			if(pthread_create(&hThreads[nStarted], NULL, ThreadEntry, &r) == 0) nStarted++;
+		Run(&r);
+		for(int i = 0; i<nStarted; i++) pthread_join(hThreads[i], NULL);
+		pthread_mutex_destroy(&r.mutex);
+#endif
+	}
+
+private:
+	enum { MAX_THREADS = 32 };
+
+	struct SRanges
+	{
+#if defined(WIN32)
+		volatile LONG nNext;
+#else
+		pthread_mutex_t mutex;
+		int nNext;
+#endif
+		int nCount;
+		int nGranularity;
+		ParallelForFunc pFunc;
+		void *pData;
+	};
+
+	// returns the start of the next range
+	static int TakeRange(SRanges *r)
+	{
+#if defined(WIN32)
+		return InterlockedExchangeAdd(&r->nNext, r->nGranularity);
+#else
+		pthread_mutex_lock(&r->mutex);
+		int nBegin = r->nNext;
+		r->nNext += r->nGranularity;
+		pthread_mutex_unlock(&r->mutex);
+		return nBegin;
+#endif
+	}
+
+	static void Run(SRanges *r)
+	{
+		for(;;)
+		{
+			int nBegin = TakeRange(r);
+			if(nBegin >= r->nCount) break;
+			int nEnd = nBegin + r->nGranularity;
+			r->pFunc(r->pData, nBegin, nEnd < r->nCount ? nEnd : r->nCount);
+		}
+	}
+
+#if defined(WIN32)
+	static DWORD WINAPI ThreadEntry(void *pParam)
+	{
+		Run((SRanges *)pParam);
+		return 0;
+	}
+#else
+	static void *ThreadEntry(void *pParam)
+	{
+		Run((SRanges *)pParam);
+		return NULL;
+	}
+#endif
+
+	int m_nThreads;
+};
+
+static CImageJobManager g_ImageJobManager;
+
+
+// the SSE2 byte kernels (alpha and 3Dc blocks) are used as well
+static bool HasSSE2()
+{
+	if(!DXTHasSSE()) return false;
+#if defined(WIN32)
+	return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__SSE2__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void CompressImageLevel( const unsigned char *pSrc, int nWidth, int nHeight, int nSrcPitch, EDXTFormat eFormat, unsigned char *pDest, int nDestPitch )
+{
+	SDXTCompressOptions opt;
+	opt.m_eFormat = eFormat;
+	opt.m_bBGRA = true;																			// A8R8G8B8 in memory
+	opt.m_bSSE = HasSSE2();
+	opt.m_pJobManager = &g_ImageJobManager;
+
+	int nRowBytes = ((nWidth+3)/4) * DXTBlockSize(eFormat);
+	int nRows = (nHeight+3)/4;
+	if(nDestPitch == nRowBytes)
+	{
+		DXTCompress(pSrc, nWidth, nHeight, nSrcPitch, 4, pDest, opt);
+		return;
+	}
+
+	unsigned char *pBlocks = new unsigned char[nRowBytes*nRows];
+	DXTCompress(pSrc, nWidth, nHeight, nSrcPitch, 4, pBlocks, opt);
+	for(int i = 0; i<nRows; i++)
+		memcpy(pDest + i*nDestPitch, pBlocks + i*nRowBytes, nRowBytes);
+	delete [] pBlocks;
+}
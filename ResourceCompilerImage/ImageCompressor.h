@@ -0,0 +1,16 @@
+// ImageCompressor compresses the levels of the image compiler with the in-tree
+// DXT/3Dc block compressor. It doesn't use D3D, the surfaces are locked by
+// LoadSurfaceFromSurface (ImageObject.cpp)
+
+#ifndef __IMAGECOMPRESSOR_H__
+#define __IMAGECOMPRESSOR_H__
+
+#include "../RenderDll/Common/Textures/DXTCompressor.h"	// EDXTFormat
+
+//! compresses one level of A8R8G8B8 texels (B,G,R,A in memory), the rows of blocks are written nDestPitch bytes apart
+//! 3Dc: red (x) goes to the first block and green (y) to the second, the layout DXTDecompress reads back
+//! \param pSrc nSrcPitch bytes per row
+//! \param pDest DXTCompressedSize() bytes if nDestPitch is the size of one row of blocks
+void CompressImageLevel( const unsigned char *pSrc, int nWidth, int nHeight, int nSrcPitch, EDXTFormat eFormat, unsigned char *pDest, int nDestPitch );
+
+#endif // __IMAGECOMPRESSOR_H__
@@ -12,6 +12,45 @@
 #include <ddraw.h>
 #include "neuquant.h"
 #include "ImageObject.h"
+#include "ImageCompressor.h"					// CompressImageLevel
+
+HRESULT LoadSurfaceFromSurface(LPDIRECT3DSURFACE9 psurfDest, LPDIRECT3DSURFACE9 psurfSrc, int filter, LPDIRECT3DDEVICE9 pd3ddev)
+{
+	D3DSURFACE_DESC sd;
+	psurfDest->GetDesc(&sd);
+
+	EDXTFormat eFormat;
+	switch(sd.Format)
+	{
+		case D3DFMT_DXT1: eFormat = eDXTF_DXT1a; break;		// "0/1" alpha
+		case D3DFMT_DXT3: eFormat = eDXTF_DXT3; break;
+		case D3DFMT_DXT5: eFormat = eDXTF_DXT5; break;
+		case D3DFMT_ATI2: eFormat = eDXTF_3DC; break;
+		default:
+			return D3DXLoadSurfaceFromSurface(psurfDest, NULL, NULL, psurfSrc, NULL, NULL, filter, 0);
+	}
+
+	// filter/convert the source to A8R8G8B8 in the size of the destination
+	LPDIRECT3DSURFACE9 psurfTemp = NULL;
+	HRESULT hr = pd3ddev->CreateOffscreenPlainSurface(sd.Width, sd.Height, D3DFMT_A8R8G8B8, D3DPOOL_SCRATCH, &psurfTemp, NULL);
+	if(FAILED(hr)) return hr;
+	hr = D3DXLoadSurfaceFromSurface(psurfTemp, NULL, NULL, psurfSrc, NULL, NULL, filter, 0);
+
+	D3DLOCKED_RECT lrSrc, lrDest;
+	if(hr==S_OK) hr = psurfTemp->LockRect(&lrSrc, NULL, D3DLOCK_READONLY);
+	if(hr==S_OK)
+	{
+		hr = psurfDest->LockRect(&lrDest, NULL, 0);
+		if(hr==S_OK)
+		{
+			CompressImageLevel((unsigned char *)lrSrc.pBits, sd.Width, sd.Height, lrSrc.Pitch, eFormat, (unsigned char *)lrDest.pBits, lrDest.Pitch);
+			psurfDest->UnlockRect();
+		}
+		psurfTemp->UnlockRect();
+	}
+	ReleasePpo(&psurfTemp);
+	return hr;
+}
 
 HRESULT P8Image::Convert(LPDIRECT3DSURFACE9 psurfSrc, int mip, int filter, D3DCUBEMAP_FACES facetype, LPDIRECT3DDEVICE9 pd3ddev)
 {
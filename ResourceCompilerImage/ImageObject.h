@@ -21,6 +21,14 @@ struct ImageObject
 };
 
 
+//! 3Dc (ATI2N) normal map format, D3D9 has no enum for it
+#define D3DFMT_ATI2		((D3DFORMAT)MAKEFOURCC('A','T','I','2'))
+
+//! like D3DXLoadSurfaceFromSurface, DXT1/3/5 and 3Dc destinations are compressed with the in-tree
+//! block compressor (CompressImageLevel, multithreaded) instead of D3DX
+HRESULT LoadSurfaceFromSurface(LPDIRECT3DSURFACE9 psurfDest, LPDIRECT3DSURFACE9 psurfSrc, int filter, LPDIRECT3DDEVICE9 pd3ddev);
+
+
 // base DX Image, used for normal textures with mipmaps
 
 struct DXImage : ImageObject
@@ -41,7 +49,7 @@ struct DXImage : ImageObject
 
 		HRESULT hr = ((LPDIRECT3DTEXTURE9)m_pTex)->GetSurfaceLevel(mip, &psurfDest);
 
-		if(hr==S_OK) hr = D3DXLoadSurfaceFromSurface(psurfDest, NULL, NULL, psurfSrc, NULL, NULL, filter, 0);
+		if(hr==S_OK) hr = LoadSurfaceFromSurface(psurfDest, psurfSrc, filter, pd3ddev);
 
 		ReleasePpo(&psurfDest);
 		return hr;
@@ -61,7 +69,7 @@ struct DXImageCube : DXImage
 	{
 		LPDIRECT3DSURFACE9 pcubeDest = NULL;
 		HRESULT hr = ((LPDIRECT3DCUBETEXTURE9)m_pTex)->GetCubeMapSurface(facetype, mip, &pcubeDest);
-		if(hr==S_OK) hr = D3DXLoadSurfaceFromSurface(pcubeDest, NULL, NULL, psurfSrc, NULL, NULL, filter, 0);
+		if(hr==S_OK) hr = LoadSurfaceFromSurface(pcubeDest, psurfSrc, filter, pd3ddev);
 		ReleasePpo(&pcubeDest);
 		return hr;
 	};